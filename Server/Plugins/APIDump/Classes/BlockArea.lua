@@ -1991,6 +1991,71 @@ return
 					Notes = "Writes the area into World at the specified coords, returns true if successful. DataTypes is the sum of baXXX datatypes to write.",
 				},
 			},
+			WriteAsync =
+			{
+				{
+					Params =
+					{
+						{
+							Name = "World",
+							Type = "cWorld",
+						},
+						{
+							Name = "MinPoint",
+							Type = "Vector3i",
+						},
+						{
+							Name = "DataTypes",
+							Type = "number",
+						},
+						{
+							Name = "ChunksPerTick",
+							Type = "number",
+						},
+						{
+							Name = "OnCompleted",
+							Type = "function",
+							IsOptional = true,
+						},
+					},
+					Notes = "Writes the area into World at the specified coords across multiple ticks, at most ChunksPerTick chunks in each tick, so that writing large areas doesn't stall the server. DataTypes is the sum of baXXX datatypes to write. The area is copied, so it can be modified or discarded right after this call. Once all the chunks are written, the OnCompleted callback is called with a single boolean parameter, true if all the chunks were valid and have been written. The function signature is as follows: <pre class=\"prettyprint lang-lua\">function OnCompleted(a_IsSuccess)</pre>",
+				},
+				{
+					Params =
+					{
+						{
+							Name = "World",
+							Type = "cWorld",
+						},
+						{
+							Name = "MinX",
+							Type = "number",
+						},
+						{
+							Name = "MinY",
+							Type = "number",
+						},
+						{
+							Name = "MinZ",
+							Type = "number",
+						},
+						{
+							Name = "DataTypes",
+							Type = "number",
+						},
+						{
+							Name = "ChunksPerTick",
+							Type = "number",
+						},
+						{
+							Name = "OnCompleted",
+							Type = "function",
+							IsOptional = true,
+						},
+					},
+					Notes = "Writes the area into World at the specified coords across multiple ticks, see the Vector3i overload for details.",
+				},
+			},
 		},
 		Constants =
 		{
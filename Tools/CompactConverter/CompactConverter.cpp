@@ -0,0 +1,57 @@
+
+// CompactConverter.cpp
+
+// Implements the main app entrypoint that converts the worlds between the Anvil and the compact storage
+
+#include "Globals.h"
+#include "Logger.h"
+#include "LoggerListeners.h"
+#include "WorldStorage/CompactStorageConverter.h"
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	auto consoleLogListener = MakeConsoleListener(false);
+	auto consoleAttachment = cLogger::GetInstance().AttachListener(std::move(consoleLogListener));
+
+	bool ToCompact;
+	if ((argc >= 2) && (strcmp(argv[1], "to-compact") == 0))
+	{
+		ToCompact = true;
+	}
+	else if ((argc >= 2) && (strcmp(argv[1], "to-anvil") == 0))
+	{
+		ToCompact = false;
+	}
+	else
+	{
+		LOG("Usage: %s <to-compact | to-anvil> [<world folder> ...]", argv[0]);
+		LOG("Converts the region files of the worlds between the \"region\" and the \"compact\" folders.");
+		LOG("The converted chunks replace those already in the destination, the others are kept.");
+		LOG("If no world folder is given, the current folder is converted.");
+		return EXIT_FAILURE;
+	}
+
+	AStringVector WorldFolders;
+	for (int i = 2; i < argc; i++)
+	{
+		WorldFolders.emplace_back(argv[i]);
+	}
+	if (WorldFolders.empty())
+	{
+		WorldFolders.emplace_back(".");
+	}
+
+	// Compress the same as the server does by default:
+	cCompactStorageConverter Converter(6);
+	for (const auto & WorldFolder: WorldFolders)
+	{
+		LOG("Converting world \"%s\" to the %s storage...", WorldFolder, ToCompact ? "compact" : "Anvil");
+		const auto NumChunks = Converter.ConvertWorld(WorldFolder, ToCompact);
+		LOG("Converted %zu chunks of world \"%s\"", NumChunks, WorldFolder);
+	}
+	return 0;
+}
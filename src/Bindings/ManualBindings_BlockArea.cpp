@@ -817,6 +817,77 @@ static int tolua_cBlockArea_Write(lua_State * a_LuaState)
 
 
 
+/** Binding for the cBlockArea:WriteAsync() function.
+Writes the area into the world across multiple ticks, calling the optional callback once done. */
+static int tolua_cBlockArea_WriteAsync(lua_State * a_LuaState)
+{
+	// function cBlockArea:WriteAsync(World, MinCoords, DataTypes, ChunksPerTick, [OnCompleted])
+	// Also supports the 3-number version of the MinCoords
+	cLuaState L(a_LuaState);
+	if (
+		!L.CheckParamSelf("cBlockArea") ||
+		!L.CheckParamUserType(2, "cWorld")
+	)
+	{
+		return 0;
+	}
+
+	// Get the params:
+	cBlockArea * self = nullptr;
+	cWorld * world = nullptr;
+	if (!L.GetStackValues(1, self, world))
+	{
+		return L.ApiParamError("Cannot read self or world");
+	}
+	if (world == nullptr)
+	{
+		return L.ApiParamError("Invalid world instance. The world must be not nil");
+	}
+	Vector3i coords;
+	int dataTypes = 0;
+	int chunksPerTick = 0;
+	cLuaState::cOptionalCallbackPtr onCompleted;
+	auto dataTypesIdx = readVector3iOverloadParams(L, 3, coords, "coords");
+	if (!L.GetStackValues(dataTypesIdx, dataTypes, chunksPerTick, onCompleted))
+	{
+		return L.ApiParamError("Cannot read the DataTypes, ChunksPerTick or OnCompleted parameters");
+	}
+
+	// Check the params' validity:
+	if (!cBlockArea::IsValidDataTypeCombination(dataTypes))
+	{
+		return L.ApiParamError(fmt::format(FMT_STRING("Invalid datatype combination (0x{:02x})"), dataTypes));
+	}
+	if ((self->GetDataTypes() & dataTypes) != dataTypes)
+	{
+		return L.ApiParamError(fmt::format(
+			FMT_STRING("Requesting datatypes not present in the cBlockArea. Got only 0x{:02x}, requested 0x{:02x}"),
+			self->GetDataTypes(), dataTypes
+		));
+	}
+	if (chunksPerTick <= 0)
+	{
+		return L.ApiParamError(fmt::format(FMT_STRING("Invalid ChunksPerTick, must be greater than zero, got {}"), chunksPerTick));
+	}
+	if ((coords.y < 0) || (coords.y > cChunkDef::Height - self->GetSizeY()))
+	{
+		return L.ApiParamError(fmt::format(FMT_STRING("The area doesn't fit into the world height when written at {}"), coords));
+	}
+
+	// Queue the write, the callback needs to be copyable to be stored in the task:
+	std::shared_ptr<cLuaState::cOptionalCallback> onCompletedShared(std::move(onCompleted));
+	world->QueueWriteBlockArea(*self, coords, dataTypes, static_cast<size_t>(chunksPerTick), [onCompletedShared](bool a_IsSuccess)
+		{
+			onCompletedShared->Call(a_IsSuccess);
+		}
+	);
+	return 0;
+}
+
+
+
+
+
 /** Templated bindings for the GetBlock___() functions.
 DataType is either BLOCKTYPE or NIBBLETYPE.
 DataTypeFlag is the ba___ constant used for the datatype being queried.
@@ -1162,6 +1233,7 @@ void cManualBindings::BindBlockArea(lua_State * a_LuaState)
 			tolua_function(a_LuaState, "SetRelBlockSkyLight",     SetRelBlock<NIBBLETYPE, cBlockArea::baSkyLight, &cBlockArea::SetRelBlockSkyLight>);
 			tolua_function(a_LuaState, "SetRelBlockTypeMeta",     tolua_cBlockArea_SetRelBlockTypeMeta);
 			tolua_function(a_LuaState, "Write",                   tolua_cBlockArea_Write);
+			tolua_function(a_LuaState, "WriteAsync",              tolua_cBlockArea_WriteAsync);
 		tolua_endmodule(a_LuaState);
 	tolua_endmodule(a_LuaState);
 }
@@ -8,6 +8,8 @@
 #include "../Root.h"
 #include "../Server.h"
 #include "../CommandOutput.h"
+#include "../Metrics.h"
+#include "../Timings.h"
 
 #include "../IniFile.h"
 #include "../Entities/Player.h"
@@ -16,6 +18,62 @@
 
 
 
+namespace
+{
+	/** Observes the time spent in all the plugins' handlers of a single hook call into the hook's cMetrics histogram. */
+	class cHookMetricsScope
+	{
+	public:
+
+		explicit cHookMetricsScope(cPluginManager::PluginHook a_Hook):
+			m_Histogram(cMetrics::IsEnabled() ? &GetHistogram(a_Hook) : nullptr)
+		{
+			if (m_Histogram != nullptr)
+			{
+				m_Start = std::chrono::steady_clock::now();
+			}
+		}
+
+		~cHookMetricsScope()
+		{
+			if (m_Histogram != nullptr)
+			{
+				m_Histogram->Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count());
+			}
+		}
+
+	private:
+
+		cMetrics::cHistogram * m_Histogram;
+		std::chrono::steady_clock::time_point m_Start;
+
+
+		/** Returns the histogram for the hook. The lookup is cached, because hooks are called very often. */
+		static cMetrics::cHistogram & GetHistogram(cPluginManager::PluginHook a_Hook)
+		{
+			static std::array<std::atomic<cMetrics::cHistogram *>, cPluginManager::HOOK_NUM_HOOKS> Cache{};
+			auto & Cached = Cache[static_cast<size_t>(a_Hook)];
+			auto Histogram = Cached.load(std::memory_order_acquire);
+			if (Histogram == nullptr)
+			{
+				// Racing threads get the same histogram from the registry, so it doesn't matter which one stores it:
+				auto HookName = cPluginLua::GetHookFnName(a_Hook);
+				Histogram = &cMetrics::GetHistogram(
+					"cuberite_plugin_hook_duration_seconds", "Time spent in the plugins' handlers of a hook",
+					cMetrics::ShortDurationBounds(),
+					cMetrics::FormatLabels({{"hook", (HookName != nullptr) ? HookName : "<unknown hook>"}})
+				);
+				Cached.store(Histogram, std::memory_order_release);
+			}
+			return *Histogram;
+		}
+	};
+}  // namespace (anonymous)
+
+
+
+
+
 cPluginManager * cPluginManager::Get(void)
 {
 	return cRoot::Get()->GetPluginManager();
@@ -230,6 +288,7 @@ void cPluginManager::Tick(float a_Dt)
 
 	for (auto * Plugin : Plugins->second)
 	{
+		cTimingScope Timing(cTimings::eCategory::PluginHook, [Plugin] { return fmt::format(FMT_STRING("{}: OnTick"), Plugin->GetName()); });
 		Plugin->Tick(a_Dt);
 	}
 }
@@ -247,7 +306,24 @@ bool cPluginManager::GenericCallHook(PluginHook a_HookName, HookFunction a_HookF
 		return false;
 	}
 
-	return std::any_of(Plugins->second.begin(), Plugins->second.end(), a_HookFunction);
+	cHookMetricsScope Metrics(a_HookName);
+	if (!cTimings::IsEnabled())
+	{
+		return std::any_of(Plugins->second.begin(), Plugins->second.end(), a_HookFunction);
+	}
+
+	// Account the time spent in each plugin's handler:
+	return std::any_of(Plugins->second.begin(), Plugins->second.end(), [&](cPlugin * a_Plugin)
+		{
+			cTimingScope Timing(cTimings::eCategory::PluginHook, [a_Plugin, a_HookName]
+				{
+					auto HookName = cPluginLua::GetHookFnName(a_HookName);
+					return fmt::format(FMT_STRING("{}: {}"), a_Plugin->GetName(), (HookName != nullptr) ? HookName : "<unknown hook>");
+				}
+			);
+			return a_HookFunction(a_Plugin);
+		}
+	);
 }
 
 
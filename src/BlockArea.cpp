@@ -2696,6 +2696,41 @@ cBlockEntity * cBlockArea::GetBlockEntityRel(Vector3i a_RelPos)
 
 
 
+/** Copies a row of a_Count blocktypes from the chunk section, starting at a_SectionIdx, into the area.
+An unallocated section (nullptr) is read as all air. */
+static void CopyBlockTypesRow(BLOCKTYPE * a_AreaDst, const ChunkBlockData::BlockArray * a_Section, size_t a_SectionIdx, int a_Count)
+{
+	if (a_Section == nullptr)
+	{
+		std::fill_n(a_AreaDst, a_Count, ChunkBlockData::DefaultValue);
+		return;
+	}
+	std::copy_n(a_Section->data() + a_SectionIdx, a_Count, a_AreaDst);
+}
+
+
+
+
+
+/** Expands a row of a_Count nibbles from the chunk section, starting at a_SectionIdx, into the one-byte-per-block area array.
+An unallocated section (nullptr) is read as a_DefaultValue, which may be stored as a packed pair of nibbles. */
+static void CopyNibblesRow(NIBBLETYPE * a_AreaDst, const ChunkLightData::LightArray * a_Section, size_t a_SectionIdx, int a_Count, NIBBLETYPE a_DefaultValue)
+{
+	if (a_Section == nullptr)
+	{
+		std::fill_n(a_AreaDst, a_Count, static_cast<NIBBLETYPE>(a_DefaultValue & 0x0f));
+		return;
+	}
+	for (int x = 0; x < a_Count; x++)
+	{
+		a_AreaDst[x] = cChunkDef::ExpandNibble(a_Section->data(), a_SectionIdx + static_cast<size_t>(x));
+	}
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cBlockArea::cChunkReader:
 
@@ -2833,89 +2868,38 @@ void cBlockArea::cChunkReader::ChunkData(const ChunkBlockData & a_BlockData, con
 		SizeZ -= (m_CurrentChunkZ + 1) * cChunkDef::Width - (m_Origin.z + m_Area.m_Size.z);
 	}
 
-	// Copy the blocktypes:
-	if (m_Area.m_BlockTypes != nullptr)
+	// Copy the data one row along the X axis at a time, the rows are contiguous both in the area and in the chunk sections:
+	for (int y = 0; y < SizeY; y++)
 	{
-		for (int y = 0; y < SizeY; y++)
+		const int InChunkY = MinY + y;
+		const auto SectionY = static_cast<size_t>(InChunkY / cChunkDef::SectionHeight);
+		const int InSectionY = InChunkY % cChunkDef::SectionHeight;
+		const auto Blocks = a_BlockData.GetSection(SectionY);
+		const auto Metas = a_BlockData.GetMetaSection(SectionY);
+		const auto BlockLights = a_LightData.GetBlockLightSection(SectionY);
+		const auto SkyLights = a_LightData.GetSkyLightSection(SectionY);
+		for (int z = 0; z < SizeZ; z++)
 		{
-			int InChunkY = MinY + y;
-			int AreaY = y;
-			for (int z = 0; z < SizeZ; z++)
+			const auto AreaIdx = m_Area.MakeIndex(OffX, y, OffZ + z);
+			const auto SectionIdx = cChunkDef::MakeIndex(BaseX, InSectionY, BaseZ + z);
+			if (m_Area.m_BlockTypes != nullptr)
 			{
-				int InChunkZ = BaseZ + z;
-				int AreaZ = OffZ + z;
-				for (int x = 0; x < SizeX; x++)
-				{
-					int InChunkX = BaseX + x;
-					int AreaX = OffX + x;
-					m_Area.m_BlockTypes[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_BlockData.GetBlock({ InChunkX, InChunkY, InChunkZ });
-				}  // for x
-			}  // for z
-		}  // for y
-	}
-
-	// Copy the block metas:
-	if (m_Area.m_BlockMetas != nullptr)
-	{
-		for (int y = 0; y < SizeY; y++)
-		{
-			int InChunkY = MinY + y;
-			int AreaY = y;
-			for (int z = 0; z < SizeZ; z++)
+				CopyBlockTypesRow(m_Area.m_BlockTypes.get() + AreaIdx, Blocks, SectionIdx, SizeX);
+			}
+			if (m_Area.m_BlockMetas != nullptr)
 			{
-				int InChunkZ = BaseZ + z;
-				int AreaZ = OffZ + z;
-				for (int x = 0; x < SizeX; x++)
-				{
-					int InChunkX = BaseX + x;
-					int AreaX = OffX + x;
-					m_Area.m_BlockMetas[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_BlockData.GetMeta({ InChunkX, InChunkY, InChunkZ });
-				}  // for x
-			}  // for z
-		}  // for y
-	}
-
-	// Copy the blocklight:
-	if (m_Area.m_BlockLight != nullptr)
-	{
-		for (int y = 0; y < SizeY; y++)
-		{
-			int InChunkY = MinY + y;
-			int AreaY = y;
-			for (int z = 0; z < SizeZ; z++)
+				CopyNibblesRow(m_Area.m_BlockMetas.get() + AreaIdx, Metas, SectionIdx, SizeX, ChunkBlockData::DefaultMetaValue);
+			}
+			if (m_Area.m_BlockLight != nullptr)
 			{
-				int InChunkZ = BaseZ + z;
-				int AreaZ = OffZ + z;
-				for (int x = 0; x < SizeX; x++)
-				{
-					int InChunkX = BaseX + x;
-					int AreaX = OffX + x;
-					m_Area.m_BlockLight[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_LightData.GetBlockLight({ InChunkX, InChunkY, InChunkZ });
-				}  // for x
-			}  // for z
-		}  // for y
-	}
-
-	// Copy the skylight:
-	if (m_Area.m_BlockSkyLight != nullptr)
-	{
-		for (int y = 0; y < SizeY; y++)
-		{
-			int InChunkY = MinY + y;
-			int AreaY = y;
-			for (int z = 0; z < SizeZ; z++)
+				CopyNibblesRow(m_Area.m_BlockLight.get() + AreaIdx, BlockLights, SectionIdx, SizeX, ChunkLightData::DefaultBlockLightValue);
+			}
+			if (m_Area.m_BlockSkyLight != nullptr)
 			{
-				int InChunkZ = BaseZ + z;
-				int AreaZ = OffZ + z;
-				for (int x = 0; x < SizeX; x++)
-				{
-					int InChunkX = BaseX + x;
-					int AreaX = OffX + x;
-					m_Area.m_BlockSkyLight[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = a_LightData.GetSkyLight({ InChunkX, InChunkY, InChunkZ });
-				}  // for x
-			}  // for z
-		}  // for y
-	}
+				CopyNibblesRow(m_Area.m_BlockSkyLight.get() + AreaIdx, SkyLights, SectionIdx, SizeX, ChunkLightData::DefaultSkyLightValue);
+			}
+		}  // for z
+	}  // for y
 }
 
 
@@ -214,20 +214,15 @@ bool cHopperEntity::MovePickupsIn(cChunk & a_Chunk)
 		{
 		}
 
-		bool operator () (cEntity & a_Entity)
+		bool operator () (cPickup & a_Pickup)
 		{
-			if (!a_Entity.IsPickup())
-			{
-				return false;
-			}
-
-			Vector3f EntityPos = a_Entity.GetPosition();
+			Vector3f EntityPos = a_Pickup.GetPosition();
 			Vector3f BlockPos(m_Pos.x + 0.5f, static_cast<float>(m_Pos.y) + 1, m_Pos.z + 0.5f);  // One block above hopper, and search from center outwards
 			double Distance = (EntityPos - BlockPos).Length();
 
 			if (Distance < 0.5)
 			{
-				if (TrySuckPickupIn(static_cast<cPickup &>(a_Entity)))
+				if (TrySuckPickupIn(a_Pickup))
 				{
 					return false;
 				}
@@ -279,8 +274,11 @@ bool cHopperEntity::MovePickupsIn(cChunk & a_Chunk)
 		cItemGrid & m_Contents;
 	};
 
+	// The pickups within reach lie either in the block above the hopper, or in the hopper's top half.
+	// The chunk indexes its pickups by block, so that each hopper doesn't need to scan all the entities in the chunk:
 	cHopperPickupSearchCallback HopperPickupSearchCallback(Vector3i(GetPosX(), GetPosY(), GetPosZ()), m_Contents);
-	a_Chunk.ForEachEntity(HopperPickupSearchCallback);
+	a_Chunk.ForEachPickupInBlock(GetPos().addedY(1), HopperPickupSearchCallback);
+	a_Chunk.ForEachPickupInBlock(GetPos(), HopperPickupSearchCallback);
 
 	return HopperPickupSearchCallback.FoundPickupsAbove();
 }
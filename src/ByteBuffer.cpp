@@ -130,7 +130,8 @@ namespace XZYPosition
 // cByteBuffer:
 
 cByteBuffer::cByteBuffer(size_t a_BufferSize) :
-	m_Buffer(new std::byte[a_BufferSize + 1]),
+	m_OwnedBuffer(new std::byte[a_BufferSize + 1]),
+	m_Buffer(m_OwnedBuffer.get()),
 	m_BufferSize(a_BufferSize + 1)
 {
 	// Allocating one byte more than the buffer size requested, so that we can distinguish between
@@ -141,6 +142,20 @@ cByteBuffer::cByteBuffer(size_t a_BufferSize) :
 
 
 
+cByteBuffer::cByteBuffer(const ContiguousByteBufferView a_Data) :
+	m_Buffer(const_cast<std::byte *>(a_Data.data())),
+	m_BufferSize(a_Data.size() + 1),
+	m_WritePos(a_Data.size())
+{
+	// The size is one byte more than the data, same as in the allocating constructor, but the extra byte is never accessed:
+	// the buffer is completely full, so nothing can be written, and no read can wrap around past the data end.
+	// Hence the const_cast is safe, the data is never modified.
+}
+
+
+
+
+
 cByteBuffer::~cByteBuffer()
 {
 	CheckValid();
@@ -174,7 +189,7 @@ bool cByteBuffer::Write(const void * a_Bytes, size_t a_Count)
 		// Need to wrap around the ringbuffer end
 		if (TillEnd > 0)
 		{
-			memcpy(m_Buffer.get() + m_WritePos, Bytes, TillEnd);
+			memcpy(m_Buffer + m_WritePos, Bytes, TillEnd);
 			Bytes += TillEnd;
 			a_Count -= TillEnd;
 			#ifndef NDEBUG
@@ -187,7 +202,7 @@ bool cByteBuffer::Write(const void * a_Bytes, size_t a_Count)
 	// We're guaranteed that we'll fit in a single write op
 	if (a_Count > 0)
 	{
-		memcpy(m_Buffer.get() + m_WritePos, Bytes, a_Count);
+		memcpy(m_Buffer + m_WritePos, Bytes, a_Count);
 		m_WritePos += a_Count;
 		#ifndef NDEBUG
 			WrittenBytes += a_Count;
@@ -891,7 +906,7 @@ bool cByteBuffer::ReadBuf(void * a_Buffer, size_t a_Count)
 		// Reading across the ringbuffer end, read the first part and adjust parameters:
 		if (BytesToEndOfBuffer > 0)
 		{
-			memcpy(Dst, m_Buffer.get() + m_ReadPos, BytesToEndOfBuffer);
+			memcpy(Dst, m_Buffer + m_ReadPos, BytesToEndOfBuffer);
 			Dst += BytesToEndOfBuffer;
 			a_Count -= BytesToEndOfBuffer;
 		}
@@ -901,7 +916,7 @@ bool cByteBuffer::ReadBuf(void * a_Buffer, size_t a_Count)
 	// Read the rest of the bytes in a single read (guaranteed to fit):
 	if (a_Count > 0)
 	{
-		memcpy(Dst, m_Buffer.get() + m_ReadPos, a_Count);
+		memcpy(Dst, m_Buffer + m_ReadPos, a_Count);
 		m_ReadPos += a_Count;
 	}
 	return true;
@@ -922,7 +937,7 @@ bool cByteBuffer::WriteBuf(const void * a_Buffer, size_t a_Count)
 	if (BytesToEndOfBuffer <= a_Count)
 	{
 		// Reading across the ringbuffer end, read the first part and adjust parameters:
-		memcpy(m_Buffer.get() + m_WritePos, Src, BytesToEndOfBuffer);
+		memcpy(m_Buffer + m_WritePos, Src, BytesToEndOfBuffer);
 		Src += BytesToEndOfBuffer;
 		a_Count -= BytesToEndOfBuffer;
 		m_WritePos = 0;
@@ -931,7 +946,7 @@ bool cByteBuffer::WriteBuf(const void * a_Buffer, size_t a_Count)
 	// Read the rest of the bytes in a single read (guaranteed to fit):
 	if (a_Count > 0)
 	{
-		memcpy(m_Buffer.get() + m_WritePos, Src, a_Count);
+		memcpy(m_Buffer + m_WritePos, Src, a_Count);
 		m_WritePos += a_Count;
 	}
 	return true;
@@ -951,7 +966,7 @@ bool cByteBuffer::WriteBuf(size_t a_Count, unsigned char a_Value)
 	if (BytesToEndOfBuffer <= a_Count)
 	{
 		// Reading across the ringbuffer end, read the first part and adjust parameters:
-		memset(m_Buffer.get() + m_WritePos, a_Value, BytesToEndOfBuffer);
+		memset(m_Buffer + m_WritePos, a_Value, BytesToEndOfBuffer);
 		a_Count -= BytesToEndOfBuffer;
 		m_WritePos = 0;
 	}
@@ -959,7 +974,7 @@ bool cByteBuffer::WriteBuf(size_t a_Count, unsigned char a_Value)
 	// Read the rest of the bytes in a single read (guaranteed to fit):
 	if (a_Count > 0)
 	{
-		memset(m_Buffer.get() + m_WritePos, a_Value, a_Count);
+		memset(m_Buffer + m_WritePos, a_Value, a_Count);
 		m_WritePos += a_Count;
 	}
 	return true;
@@ -983,7 +998,7 @@ bool cByteBuffer::ReadSome(ContiguousByteBuffer & a_String, size_t a_Count)
 		// Reading across the ringbuffer end, read the first part and adjust parameters:
 		if (BytesToEndOfBuffer > 0)
 		{
-			a_String.assign(m_Buffer.get() + m_ReadPos, BytesToEndOfBuffer);
+			a_String.assign(m_Buffer + m_ReadPos, BytesToEndOfBuffer);
 			ASSERT(a_Count >= BytesToEndOfBuffer);
 			a_Count -= BytesToEndOfBuffer;
 		}
@@ -993,7 +1008,7 @@ bool cByteBuffer::ReadSome(ContiguousByteBuffer & a_String, size_t a_Count)
 	// Read the rest of the bytes in a single read (guaranteed to fit):
 	if (a_Count > 0)
 	{
-		a_String.append(m_Buffer.get() + m_ReadPos, a_Count);
+		a_String.append(m_Buffer + m_ReadPos, a_Count);
 		m_ReadPos += a_Count;
 	}
 	return true;
@@ -1088,11 +1103,11 @@ void cByteBuffer::ReadAgain(ContiguousByteBuffer & a_Out) const
 	{
 		// Across the ringbuffer end, read the first part and adjust next part's start:
 		ASSERT(m_BufferSize >= m_DataStart);
-		a_Out.append(m_Buffer.get() + m_DataStart, m_BufferSize - m_DataStart);
+		a_Out.append(m_Buffer + m_DataStart, m_BufferSize - m_DataStart);
 		DataStart = 0;
 	}
 	ASSERT(m_ReadPos >= DataStart);
-	a_Out.append(m_Buffer.get() + DataStart, m_ReadPos - DataStart);
+	a_Out.append(m_Buffer + DataStart, m_ReadPos - DataStart);
 }
 
 
@@ -33,6 +33,11 @@ class cByteBuffer
 public:
 
 	explicit cByteBuffer(size_t a_BufferSize);
+
+	/** Creates a read-only buffer over the specified data, without copying it.
+	The data must outlive the buffer. The buffer is full from the start, so all writes fail.
+	Used to parse the packets straight from the memory they were received or decompressed into. */
+	explicit cByteBuffer(ContiguousByteBufferView a_Data);
 	~cByteBuffer();
 
 	/** cByteBuffer should not be copied or moved. Use ReadToByteBuffer instead. */
@@ -157,7 +162,12 @@ public:
 
 protected:
 
-	std::unique_ptr<std::byte[]> m_Buffer;
+	/** The memory owned by the buffer; empty for the read-only buffers created over external data. */
+	std::unique_ptr<std::byte[]> m_OwnedBuffer;
+
+	/** The ringbuffer memory, either m_OwnedBuffer or the external data. */
+	std::byte * m_Buffer;
+
 	size_t m_BufferSize;  // Total size of the ringbuffer
 
 	size_t m_DataStart = 0;  // Where the data starts in the ringbuffer
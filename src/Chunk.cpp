@@ -12,7 +12,10 @@
 #include "ClientHandle.h"
 #include "Server.h"
 #include "Defines.h"
+#include "Entities/ExpOrb.h"
 #include "Entities/Pickup.h"
+#include "Entities/ProjectileEntity.h"
+#include "Timings.h"
 #include "Item.h"
 #include "Noise/Noise.h"
 #include "Root.h"
@@ -35,6 +38,221 @@
 
 
 
+namespace
+{
+	/** Returns true if the block change only swaps a fluid between its flowing and stationary form.
+	Such changes don't need to mark the chunk dirty. */
+	bool IsReplacingLiquids(const BLOCKTYPE a_OldBlockType, const BLOCKTYPE a_NewBlockType)
+	{
+		return (
+			((a_OldBlockType == E_BLOCK_STATIONARY_WATER) && (a_NewBlockType == E_BLOCK_WATER)) ||             // Replacing stationary water with water
+			((a_OldBlockType == E_BLOCK_WATER)            && (a_NewBlockType == E_BLOCK_STATIONARY_WATER)) ||  // Replacing water with stationary water
+			((a_OldBlockType == E_BLOCK_STATIONARY_LAVA)  && (a_NewBlockType == E_BLOCK_LAVA)) ||              // Replacing stationary lava with lava
+			((a_OldBlockType == E_BLOCK_LAVA)             && (a_NewBlockType == E_BLOCK_STATIONARY_LAVA))      // Replacing lava with stationary lava
+		);
+	}
+
+
+
+
+
+	/** Returns true if the block change needs to be queued for sending to the clients. */
+	bool ShouldSendBlockChange(
+		const BLOCKTYPE a_OldBlockType, const NIBBLETYPE a_OldBlockMeta,
+		const BLOCKTYPE a_NewBlockType, const NIBBLETYPE a_NewBlockMeta,
+		const bool a_ReplacingLiquids
+	)
+	{
+		return (
+			!(                                // ... the old and new blocktypes AREN'T leaves (because the client doesn't need meta updates)
+				((a_OldBlockType == E_BLOCK_LEAVES) && (a_NewBlockType == E_BLOCK_LEAVES)) ||
+				((a_OldBlockType == E_BLOCK_NEW_LEAVES) && (a_NewBlockType == E_BLOCK_NEW_LEAVES))
+			) &&                              // ... AND ...
+			(
+				(a_OldBlockMeta != a_NewBlockMeta) || (!a_ReplacingLiquids)
+			)
+		);
+	}
+
+
+
+
+
+	/** Returns true if replacing the old blocktype with the new one changes the chunk lighting. */
+	bool IsLightAffected(const BLOCKTYPE a_OldBlockType, const BLOCKTYPE a_NewBlockType)
+	{
+		return (
+			(cBlockInfo::GetLightValue        (a_OldBlockType) != cBlockInfo::GetLightValue        (a_NewBlockType)) ||
+			(cBlockInfo::GetSpreadLightFalloff(a_OldBlockType) != cBlockInfo::GetSpreadLightFalloff(a_NewBlockType)) ||
+			(cBlockInfo::IsTransparent        (a_OldBlockType) != cBlockInfo::IsTransparent        (a_NewBlockType))
+		);
+	}
+
+
+
+
+
+	/** Returns true if the one-byte-per-block area metas are the same as the nibbles stored in the section, starting at the specified section index. */
+	bool IsAreaNibbleRowEqual(const NIBBLETYPE * a_AreaMetas, const NIBBLETYPE * a_SectionNibbles, const size_t a_SectionIdx, const int a_Count)
+	{
+		for (int x = 0; x < a_Count; x++)
+		{
+			if (a_AreaMetas[x] != cChunkDef::ExpandNibble(a_SectionNibbles, a_SectionIdx + static_cast<size_t>(x)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+
+
+
+	/** Returns true if writing the specified part of the area into a chunk section wouldn't change any block in it.
+	a_AreaStart is the first block to compare in the area, a_SectionStart is the corresponding block in the section.
+	a_Blocks and a_Metas may be nullptr for sections that aren't allocated (all blocks are air with zero meta). */
+	bool IsAreaEqualToSection(
+		const cBlockArea & a_Area, const Vector3i a_AreaStart, const Vector3i a_SectionStart, const Vector3i a_Size,
+		const ChunkBlockData::BlockArray * a_Blocks, const ChunkBlockData::MetaArray * a_Metas
+	)
+	{
+		const BLOCKTYPE *  AreaBlockTypes = a_Area.GetBlockTypes();
+		const NIBBLETYPE * AreaBlockMetas = a_Area.GetBlockMetas();
+		const auto RowLength = static_cast<size_t>(a_Size.x);
+		for (int y = 0; y < a_Size.y; y++)
+		{
+			for (int z = 0; z < a_Size.z; z++)
+			{
+				const auto AreaIdx = a_Area.MakeIndex(a_AreaStart.x, a_AreaStart.y + y, a_AreaStart.z + z);
+				const auto SectionIdx = cChunkDef::MakeIndex(a_SectionStart.x, a_SectionStart.y + y, a_SectionStart.z + z);
+				const auto AreaTypesRow = AreaBlockTypes + AreaIdx;
+				const auto AreaMetasRow = AreaBlockMetas + AreaIdx;
+				if (a_Blocks == nullptr)
+				{
+					if (std::any_of(AreaTypesRow, AreaTypesRow + RowLength, [](const BLOCKTYPE a_Type) { return a_Type != ChunkBlockData::DefaultValue; }))
+					{
+						return false;
+					}
+				}
+				else if (memcmp(a_Blocks->data() + SectionIdx, AreaTypesRow, RowLength) != 0)
+				{
+					return false;
+				}
+				if (a_Metas == nullptr)
+				{
+					if (std::any_of(AreaMetasRow, AreaMetasRow + RowLength, [](const NIBBLETYPE a_Meta) { return a_Meta != ChunkBlockData::DefaultMetaValue; }))
+					{
+						return false;
+					}
+				}
+				else if (!IsAreaNibbleRowEqual(AreaMetasRow, a_Metas->data(), SectionIdx, a_Size.x))
+				{
+					return false;
+				}
+			}  // for z
+		}  // for y
+		return true;
+	}
+
+
+
+
+
+	/** Maximum distance between two pickups or two experience orbs that are merged together. */
+	const double ITEM_ENTITY_MERGE_DISTANCE = 1.2;
+
+
+
+
+
+	/** Returns the box within which a_Player collects pickups, same as cChunkMap::CollectPickupsByEntity() uses. */
+	cBoundingBox GetCollectionBox(const cEntity & a_Player)
+	{
+		auto Box = a_Player.GetBoundingBox();
+		Box.Expand(1, 0.5, 1);
+		return Box;
+	}
+
+
+
+
+
+	/** Merges the nearby entities among a_Entities, using a_Merge(Entity, Target), which returns true if Entity
+	was consumed by Target. The entities are processed in their ID order, so that the older ones absorb the newer ones.
+	Each entity is only compared with the already processed entities in the neighbouring cells of a spatial hash,
+	so the cost is linear in the number of entities instead of quadratic.
+	a_Cells is the spatial hash, passed in so that its storage is reused across the calls.
+	Returns the number of entities that were consumed. */
+	template <typename EntityType, typename MergeFn>
+	int MergeNearbyEntities(std::vector<EntityType *> & a_Entities, cChunk::cEntityCells & a_Cells, MergeFn a_Merge)
+	{
+		if (a_Entities.size() < 2)
+		{
+			return 0;
+		}
+
+		std::sort(a_Entities.begin(), a_Entities.end(), [](const EntityType * a_Lhs, const EntityType * a_Rhs)
+			{
+				return (a_Lhs->GetUniqueID() < a_Rhs->GetUniqueID());
+			}
+		);
+
+		// The cells are one block large, the merge distance spans at most three of them in each direction:
+		a_Cells.clear();
+		const Vector3d Reach(ITEM_ENTITY_MERGE_DISTANCE, ITEM_ENTITY_MERGE_DISTANCE, ITEM_ENTITY_MERGE_DISTANCE);
+		int NumMerged = 0;
+		for (auto * Entity : a_Entities)
+		{
+			const auto Position = Entity->GetPosition();
+			const auto Min = (Position - Reach).Floor();
+			const auto Max = (Position + Reach).Floor();
+			const bool IsConsumed = [&]
+			{
+				for (int y = Min.y; y <= Max.y; y++)
+				{
+					for (int z = Min.z; z <= Max.z; z++)
+					{
+						for (int x = Min.x; x <= Max.x; x++)
+						{
+							const auto Cell = a_Cells.find({x, y, z});
+							if (Cell == a_Cells.end())
+							{
+								continue;
+							}
+							for (auto * Target : Cell->second)
+							{
+								if (
+									((Target->GetPosition() - Position).SqrLength() < ITEM_ENTITY_MERGE_DISTANCE * ITEM_ENTITY_MERGE_DISTANCE) &&
+									a_Merge(*Entity, static_cast<EntityType &>(*Target))
+								)
+								{
+									return true;
+								}
+							}
+						}  // for x
+					}  // for z
+				}  // for y
+				return false;
+			}();
+
+			if (IsConsumed)
+			{
+				NumMerged += 1;
+			}
+			else
+			{
+				a_Cells[Position.Floor()].push_back(Entity);
+			}
+		}
+		return NumMerged;
+	}
+}  // namespace (anonymous)
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cChunk:
 
@@ -46,7 +264,9 @@ cChunk::cChunk(
 	m_IsLightValid(false),
 	m_IsDirty(false),
 	m_IsSaving(false),
+	m_DirtySince(0),
 	m_StayCount(0),
+	m_LastUsed(a_World->GetWorldAge()),
 	m_PosX(a_ChunkX),
 	m_PosZ(a_ChunkZ),
 	m_World(a_World),
@@ -77,6 +297,9 @@ cChunk::cChunk(
 	{
 		m_NeighborZP->m_NeighborZM = this;
 	}
+
+	m_BlockData.SetMemoryAccount(a_ChunkMap->GetMemoryAccount());
+	m_LightData.SetMemoryAccount(a_ChunkMap->GetMemoryAccount());
 }
 
 
@@ -279,6 +502,16 @@ void cChunk::MarkSaved(void)
 
 
 
+void cChunk::SetDirty(void)
+{
+	m_IsDirty = true;
+	m_DirtySince = m_World->GetWorldAge();
+}
+
+
+
+
+
 void cChunk::MarkLoaded(void)
 {
 	m_IsDirty = false;
@@ -335,6 +568,9 @@ void cChunk::SetAllData(SetChunkData && a_SetChunkData)
 
 	m_BlockData = std::move(a_SetChunkData.BlockData);
 	m_LightData = std::move(a_SetChunkData.LightData);
+	m_MapColours.reset();
+	m_BlockData.SetMemoryAccount(m_ChunkMap->GetMemoryAccount());
+	m_LightData.SetMemoryAccount(m_ChunkMap->GetMemoryAccount());
 	m_IsLightValid = a_SetChunkData.IsLightValid;
 
 	m_PendingSendBlocks.clear();
@@ -451,28 +687,111 @@ void cChunk::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlock
 	int BaseX = BlockStartX - a_MinBlockX;  // Offset within the area where the union starts
 	int BaseZ = BlockStartZ - a_MinBlockZ;
 
-	// Copy blocktype and blockmeta:
-	BLOCKTYPE *  AreaBlockTypes = a_Area.GetBlockTypes();
-	NIBBLETYPE * AreaBlockMetas = a_Area.GetBlockMetas();
-	for (int y = 0; y < SizeY; y++)
-	{
-		int ChunkY = a_MinBlockY + y;
-		int AreaY = y;
-		for (int z = 0; z < SizeZ; z++)
+	// Copy blocktype and blockmeta, one section at a time:
+	const BLOCKTYPE *  AreaBlockTypes = a_Area.GetBlockTypes();
+	const NIBBLETYPE * AreaBlockMetas = a_Area.GetBlockMetas();
+	std::array<int, cChunkDef::Width * cChunkDef::Width> HighestChanged;  // The highest changed Y in each column, -1 if the column hasn't changed
+	HighestChanged.fill(-1);
+	bool ShouldMarkDirty = false;
+	bool ShouldInvalidateLight = false;
+	for (size_t SectionY = static_cast<size_t>(a_MinBlockY / cChunkDef::SectionHeight); SectionY < cChunkDef::NumSections; SectionY++)
+	{
+		const int SectionBaseY = static_cast<int>(SectionY) * cChunkDef::SectionHeight;
+		const int SectionMinY = std::max(a_MinBlockY, SectionBaseY);
+		const int SectionMaxY = std::min(a_MinBlockY + SizeY, SectionBaseY + cChunkDef::SectionHeight);
+		if (SectionMinY >= SectionMaxY)
+		{
+			break;
+		}
+
+		// Skip the sections that the area wouldn't change, so that untouched sections don't get allocated:
+		if (IsAreaEqualToSection(
+			a_Area, { BaseX, SectionMinY - a_MinBlockY, BaseZ },
+			{ OffX, SectionMinY - SectionBaseY, OffZ }, { SizeX, SectionMaxY - SectionMinY, SizeZ },
+			m_BlockData.GetSection(SectionY), m_BlockData.GetMetaSection(SectionY)
+		))
 		{
-			int ChunkZ = OffZ + z;
-			int AreaZ = BaseZ + z;
-			for (int x = 0; x < SizeX; x++)
+			continue;
+		}
+
+		auto & Blocks = m_BlockData.GetOrCreateSection(SectionY);
+		auto & Metas = m_BlockData.GetOrCreateMetaSection(SectionY);
+		for (int ChunkY = SectionMinY; ChunkY < SectionMaxY; ChunkY++)
+		{
+			for (int z = 0; z < SizeZ; z++)
 			{
-				int ChunkX = OffX + x;
-				int AreaX = BaseX + x;
-				auto idx = a_Area.MakeIndex(AreaX, AreaY, AreaZ);
-				BLOCKTYPE BlockType = AreaBlockTypes[idx];
-				NIBBLETYPE BlockMeta = AreaBlockMetas[idx];
-				FastSetBlock(ChunkX, ChunkY, ChunkZ, BlockType, BlockMeta);
-			}  // for x
-		}  // for z
-	}  // for y
+				// Rows along the X axis are contiguous both in the area and in the section:
+				const auto AreaIdx = a_Area.MakeIndex(BaseX, ChunkY - a_MinBlockY, BaseZ + z);
+				const auto SectionIdx = cChunkDef::MakeIndex(OffX, ChunkY - SectionBaseY, OffZ + z);
+				if (
+					(memcmp(Blocks.data() + SectionIdx, AreaBlockTypes + AreaIdx, static_cast<size_t>(SizeX)) == 0) &&
+					IsAreaNibbleRowEqual(AreaBlockMetas + AreaIdx, Metas.data(), SectionIdx, SizeX)
+				)
+				{
+					continue;
+				}
+
+				for (int x = 0; x < SizeX; x++)
+				{
+					const auto Idx = SectionIdx + static_cast<size_t>(x);
+					const BLOCKTYPE BlockType = AreaBlockTypes[AreaIdx + static_cast<size_t>(x)];
+					const NIBBLETYPE BlockMeta = AreaBlockMetas[AreaIdx + static_cast<size_t>(x)];
+					const BLOCKTYPE OldBlockType = Blocks[Idx];
+					const NIBBLETYPE OldBlockMeta = cChunkDef::ExpandNibble(Metas.data(), Idx);
+					if ((OldBlockType == BlockType) && (OldBlockMeta == BlockMeta))
+					{
+						continue;
+					}
+
+					Blocks[Idx] = BlockType;
+					cChunkDef::PackNibble(Metas.data(), Idx, BlockMeta);
+
+					const bool ReplacingLiquids = IsReplacingLiquids(OldBlockType, BlockType);
+					ShouldMarkDirty = ShouldMarkDirty || !ReplacingLiquids;
+					ShouldInvalidateLight = ShouldInvalidateLight || IsLightAffected(OldBlockType, BlockType);
+					if (ShouldSendBlockChange(OldBlockType, OldBlockMeta, BlockType, BlockMeta, ReplacingLiquids))
+					{
+						m_PendingSendBlocks.emplace_back(m_PosX, m_PosZ, OffX + x, ChunkY, OffZ + z, BlockType, BlockMeta);
+					}
+
+					auto & Highest = HighestChanged[static_cast<size_t>(OffX + x + (OffZ + z) * cChunkDef::Width)];
+					Highest = std::max(Highest, ChunkY);
+				}  // for x
+			}  // for z
+		}  // for ChunkY
+	}  // for SectionY
+
+	if (ShouldMarkDirty)
+	{
+		MarkDirty();
+	}
+
+	// The lighting is invalidated only once for the whole write, the chunk gets relit as a single job when it is needed next:
+	if (ShouldInvalidateLight)
+	{
+		m_IsLightValid = false;
+	}
+
+	// Update the heightmap in the columns where the blocks at or above the current height have changed:
+	for (size_t Column = 0; Column < HighestChanged.size(); Column++)
+	{
+		const int RelX = static_cast<int>(Column) % cChunkDef::Width;
+		const int RelZ = static_cast<int>(Column) / cChunkDef::Width;
+		if (HighestChanged[Column] >= 0)
+		{
+			InvalidateMapColour(RelX, RelZ);
+		}
+		if (HighestChanged[Column] < m_HeightMap[Column])
+		{
+			continue;
+		}
+		int y = HighestChanged[Column];
+		while ((y > 0) && (GetBlock(RelX, y, RelZ) == E_BLOCK_AIR))
+		{
+			--y;
+		}
+		m_HeightMap[Column] = static_cast<HEIGHTTYPE>(y);
+	}
 
 	// Erase all affected block entities:
 	{
@@ -546,6 +865,10 @@ void cChunk::Stay(bool a_Stay)
 	{
 		ASSERT(m_StayCount != 0);
 		m_StayCount--;
+		if (m_StayCount == 0)
+		{
+			m_LastUsed = m_World->GetWorldAge();
+		}
 	}
 }
 
@@ -694,70 +1017,115 @@ void cChunk::SpawnMobs(cMobSpawner & a_MobSpawner)
 
 void cChunk::Tick(std::chrono::milliseconds a_Dt)
 {
-	TickBlocks();
+	cTimingScope ChunkTiming(cTimings::eCategory::Chunk, [this]
+		{
+			return fmt::format(FMT_STRING("{} [{}, {}]"), m_World->GetName(), m_PosX, m_PosZ);
+		}
+	);
 
-	// Tick all block entities in this chunk:
-	for (auto & KeyPair : m_BlockEntities)
 	{
-		m_IsDirty = KeyPair.second->Tick(a_Dt, *this) | m_IsDirty;
+		cTimingScope Timing(cTimings::eCategory::ChunkStep, [] { return AString("Random block ticks"); });
+		TickBlocks();
 	}
 
-	for (auto itr = m_Entities.begin(); itr != m_Entities.end();)
+	// Index the pickups for the hoppers and merge the nearby item entities:
 	{
-		// Do not tick mobs that are detached from the world. They're either scheduled for teleportation or for removal.
-		if (!(*itr)->IsTicking())
+		cTimingScope Timing(cTimings::eCategory::ChunkStep, [] { return AString("Item entity merging"); });
+		BuildPickupIndex();
+		if (const auto NumMerged = MergeItemEntities(); NumMerged > 0)
 		{
-			++itr;
-			continue;
+			m_World->AddMergedItemEntities(NumMerged);
 		}
+		CollectItemEntitiesByPlayers();
+	}
 
-		if (!((*itr)->IsMob()))  // Mobs are ticked inside cWorld::TickMobs() (as we don't have to tick them if they are far away from players)
+	// Tick all block entities in this chunk:
+	{
+		cTimingScope Timing(cTimings::eCategory::ChunkStep, [] { return AString("Block entities"); });
+		for (auto & KeyPair : m_BlockEntities)
 		{
-			// Tick all entities in this chunk (except mobs):
-			ASSERT((*itr)->GetParentChunk() == this);
-			(*itr)->Tick(a_Dt, *this);
-			ASSERT((*itr)->GetParentChunk() == this);
+			cBlockEntity & BlockEntity = *KeyPair.second;
+			cTimingScope BlockEntityTiming(cTimings::eCategory::BlockEntity, [&BlockEntity] { return ItemTypeToString(BlockEntity.GetBlockType()); });
+			if (BlockEntity.Tick(a_Dt, *this) && !m_IsDirty)
+			{
+				SetDirty();
+			}
 		}
+	}
 
-		// Do not move mobs that are detached from the world to neighbors. They're either scheduled for teleportation or for removal.
-		// Because the schedulded destruction is going to look for them in this chunk. See cEntity::destroy.
-		if (!(*itr)->IsTicking())
+	// Tick all entities in this chunk (except mobs), move the ones that left the chunk to their new chunks:
+	{
+		cTimingScope Timing(cTimings::eCategory::ChunkStep, [] { return AString("Entities"); });
+		for (auto itr = m_Entities.begin(); itr != m_Entities.end();)
 		{
-			++itr;
-			continue;
-		}
+			// Do not tick mobs that are detached from the world. They're either scheduled for teleportation or for removal.
+			if (!(*itr)->IsTicking())
+			{
+				++itr;
+				continue;
+			}
 
-		if (
-			((*itr)->GetChunkX() != m_PosX) ||
-			((*itr)->GetChunkZ() != m_PosZ)
-		)
-		{
-			// Mark as dirty if it was a server-generated entity:
-			if (!(*itr)->IsPlayer())
+			if (!((*itr)->IsMob()))  // Mobs are ticked inside cWorld::TickMobs() (as we don't have to tick them if they are far away from players)
 			{
-				MarkDirty();
+				// Tick all entities in this chunk (except mobs):
+				ASSERT((*itr)->GetParentChunk() == this);
+				cEntity & Entity = **itr;
+				cTimingScope EntityTiming(cTimings::eCategory::Entity, [&Entity] { return AString(Entity.GetClass()); });
+				Entity.Tick(a_Dt, *this);
+				ASSERT((*itr)->GetParentChunk() == this);
 			}
 
-			// This block is very similar to RemoveEntity, except it uses an iterator to avoid scanning the whole m_Entities
-			// The entity moved out of the chunk, move it to the neighbor
-			(*itr)->SetParentChunk(nullptr);
-			MoveEntityToNewChunk(std::move(*itr));
+			// Do not move mobs that are detached from the world to neighbors. They're either scheduled for teleportation or for removal.
+			// Because the schedulded destruction is going to look for them in this chunk. See cEntity::destroy.
+			if (!(*itr)->IsTicking())
+			{
+				++itr;
+				continue;
+			}
 
-			itr = m_Entities.erase(itr);
-		}
-		else
-		{
-			++itr;
-		}
-	}  // for itr - m_Entitites[]
+			if (
+				((*itr)->GetChunkX() != m_PosX) ||
+				((*itr)->GetChunkZ() != m_PosZ)
+			)
+			{
+				// Mark as dirty if it was a server-generated entity:
+				if (!(*itr)->IsPlayer())
+				{
+					MarkDirty();
+				}
+
+				// This block is very similar to RemoveEntity, except it uses an iterator to avoid scanning the whole m_Entities
+				// The entity moved out of the chunk, move it to the neighbor
+				(*itr)->SetParentChunk(nullptr);
+				MoveEntityToNewChunk(std::move(*itr));
+
+				itr = m_Entities.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}  // for itr - m_Entitites[]
+	}
 
 	ApplyWeatherToTop();
 
 	// Tick simulators:
-	m_World->GetSimulatorManager()->SimulateChunk(a_Dt, m_PosX, m_PosZ, this);
+	{
+		cTimingScope Timing(cTimings::eCategory::ChunkStep, [] { return AString("Simulators"); });
+		m_World->GetSimulatorManager()->SimulateChunk(a_Dt, m_PosX, m_PosZ, this);
+	}
 
 	// Check blocks after everything else to apply at least one round of queued ticks (i.e. cBlockHandler::Check) this tick:
-	CheckBlocks();
+	{
+		cTimingScope Timing(cTimings::eCategory::ChunkStep, [] { return AString("Block checks"); });
+		CheckBlocks();
+	}
+
+	// The indexed entities may move out of this chunk or get removed before the next tick:
+	m_PickupIndex.clear();
+	m_MergedOrbs.clear();
+	m_CollectibleProjectiles.clear();
 }
 
 
@@ -878,6 +1246,180 @@ void cChunk::TickBlocks(void)
 
 
 
+void cChunk::BuildPickupIndex(void)
+{
+	m_PickupIndex.clear();
+	m_MergedOrbs.clear();
+	m_CollectibleProjectiles.clear();
+	for (const auto & Entity : m_Entities)
+	{
+		if (!Entity->IsTicking())
+		{
+			continue;
+		}
+		if (Entity->IsPickup())
+		{
+			auto & Pickup = static_cast<cPickup &>(*Entity);
+			if (!Pickup.IsCollected())
+			{
+				m_PickupIndex[Pickup.GetPosition().Floor()].push_back(&Pickup);
+			}
+		}
+		else if (Entity->IsExpOrb())
+		{
+			m_MergedOrbs.push_back(static_cast<cExpOrb *>(Entity.get()));
+		}
+		else if (Entity->IsProjectile())
+		{
+			m_CollectibleProjectiles.push_back(static_cast<cProjectileEntity *>(Entity.get()));
+		}
+	}
+}
+
+
+
+
+
+void cChunk::CollectItemEntitiesByPlayers(void)
+{
+	if (m_PickupIndex.empty() && m_CollectibleProjectiles.empty())
+	{
+		return;
+	}
+
+	// The players that can reach into this chunk are in it, or in one of its neighbors:
+	const cBoundingBox ChunkBox(
+		m_PosX * cChunkDef::Width, (m_PosX + 1) * cChunkDef::Width,
+		0, cChunkDef::Height,
+		m_PosZ * cChunkDef::Width, (m_PosZ + 1) * cChunkDef::Width
+	);
+	m_NearbyPlayers.clear();
+	for (int z = -1; z <= 1; z++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			const auto Neighbor = GetRelNeighborChunk(x * cChunkDef::Width, z * cChunkDef::Width);
+			if (Neighbor == nullptr)
+			{
+				continue;
+			}
+			for (const auto & Entity : Neighbor->m_Entities)
+			{
+				if (!Entity->IsPlayer() || !Entity->IsTicking() || (static_cast<cPlayer &>(*Entity).GetHealth() <= 0))
+				{
+					continue;
+				}
+				if (GetCollectionBox(*Entity).DoesIntersect(ChunkBox))
+				{
+					m_NearbyPlayers.push_back(static_cast<cPlayer *>(Entity.get()));
+				}
+			}
+		}
+	}
+
+	// Hand each player the item entities within its reach, looking the pickups up in the index:
+	for (auto * Player : m_NearbyPlayers)
+	{
+		auto Box = GetCollectionBox(*Player);
+		// A pickup's bounding box reaches less than a block out of the block it's indexed by:
+		const auto Min = Vector3d(Box.GetMinX() - 1, Box.GetMinY() - 1, Box.GetMinZ() - 1).Floor();
+		const auto Max = Vector3d(Box.GetMaxX() + 1, Box.GetMaxY() + 1, Box.GetMaxZ() + 1).Floor();
+		for (int y = Min.y; y <= Max.y; y++)
+		{
+			for (int z = Min.z; z <= Max.z; z++)
+			{
+				for (int x = Min.x; x <= Max.x; x++)
+				{
+					const auto Cell = m_PickupIndex.find({x, y, z});
+					if (Cell == m_PickupIndex.end())
+					{
+						continue;
+					}
+					for (auto * Pickup : Cell->second)
+					{
+						if (Pickup->IsTicking() && Box.DoesIntersect(Pickup->GetBoundingBox()))
+						{
+							Pickup->CollectedBy(*Player);
+						}
+					}
+				}  // for x
+			}  // for z
+		}  // for y
+
+		for (auto * Projectile : m_CollectibleProjectiles)
+		{
+			if (Projectile->IsTicking() && Box.DoesIntersect(Projectile->GetBoundingBox()))
+			{
+				Projectile->CollectedBy(*Player);
+			}
+		}
+	}
+}
+
+
+
+
+
+int cChunk::MergeItemEntities(void)
+{
+	// Pickups lying on the ground combine their stacks, up to the max stack size:
+	m_MergedPickups.clear();
+	for (const auto & Cell : m_PickupIndex)
+	{
+		for (auto * Pickup : Cell.second)
+		{
+			if (Pickup->IsOnGround() && Pickup->CanCombine())
+			{
+				m_MergedPickups.push_back(Pickup);
+			}
+		}
+	}
+	int NumMerged = MergeNearbyEntities(m_MergedPickups, m_MergeCells, [this](cPickup & a_Pickup, cPickup & a_Target)
+		{
+			auto & Item = a_Pickup.GetItem();
+			auto & TargetItem = a_Target.GetItem();
+			if (!TargetItem.IsEqual(Item))
+			{
+				return false;
+			}
+			const auto NumMoved = static_cast<char>(std::min<int>(Item.m_ItemCount, TargetItem.GetMaxStackSize() - TargetItem.m_ItemCount));
+			if (NumMoved <= 0)
+			{
+				return false;
+			}
+
+			TargetItem.m_ItemCount += NumMoved;
+			Item.m_ItemCount -= NumMoved;
+			m_World->BroadcastEntityMetadata(a_Target);
+			if (Item.m_ItemCount > 0)
+			{
+				m_World->BroadcastEntityMetadata(a_Pickup);
+				return false;
+			}
+
+			m_World->BroadcastCollectEntity(a_Pickup, a_Target, static_cast<unsigned>(NumMoved));
+			a_Pickup.Destroy();
+			a_Target.SetAge(0);
+			return true;
+		}
+	);
+
+	// Experience orbs sum up their rewards:
+	NumMerged += MergeNearbyEntities(m_MergedOrbs, m_MergeCells, [](cExpOrb & a_Orb, cExpOrb & a_Target)
+		{
+			a_Target.SetReward(a_Target.GetReward() + a_Orb.GetReward());
+			a_Orb.Destroy();
+			return true;
+		}
+	);
+
+	return NumMerged;
+}
+
+
+
+
+
 void cChunk::ApplyWeatherToTop()
 {
 	if (
@@ -1194,6 +1736,34 @@ int cChunk::GetHeight(int a_X, int a_Z) const
 
 
 
+std::optional<Byte> cChunk::GetMapColour(int a_RelX, int a_RelZ) const
+{
+	ASSERT((a_RelX >= 0) && (a_RelX < cChunkDef::Width) && (a_RelZ >= 0) && (a_RelZ < cChunkDef::Width));
+	if (m_MapColours == nullptr)
+	{
+		return {};
+	}
+	return (*m_MapColours)[static_cast<size_t>(a_RelX + a_RelZ * cChunkDef::Width)];
+}
+
+
+
+
+
+void cChunk::SetMapColour(int a_RelX, int a_RelZ, Byte a_Colour)
+{
+	ASSERT((a_RelX >= 0) && (a_RelX < cChunkDef::Width) && (a_RelZ >= 0) && (a_RelZ < cChunkDef::Width));
+	if (m_MapColours == nullptr)
+	{
+		m_MapColours = std::make_unique<std::array<std::optional<Byte>, cChunkDef::Width * cChunkDef::Width>>();
+	}
+	(*m_MapColours)[static_cast<size_t>(a_RelX + a_RelZ * cChunkDef::Width)] = a_Colour;
+}
+
+
+
+
+
 bool cChunk::IsWeatherSunnyAt(int a_RelX, int a_RelZ) const
 {
 	return m_World->IsWeatherSunny() || IsBiomeNoDownfall(GetBiomeAt(a_RelX, a_RelZ));
@@ -1278,7 +1848,7 @@ void cChunk::SetBlock(Vector3i a_RelPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_Blo
 	m_BlocksToCheck.push(a_RelPos);
 
 	// Wake up the simulators for this block:
-	GetWorld()->GetSimulatorManager()->WakeUp(*this, a_RelPos);
+	WakeUpSimulators(a_RelPos);
 
 	// If there was a block entity, remove it:
 	if (const auto FindResult = m_BlockEntities.find(cChunkDef::MakeIndex(a_RelPos)); FindResult != m_BlockEntities.end())
@@ -1303,6 +1873,15 @@ void cChunk::SetBlock(Vector3i a_RelPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_Blo
 
 
 
+void cChunk::WakeUpSimulators(Vector3i a_RelPos)
+{
+	m_World->GetSimulatorManager()->WakeUp(*this, a_RelPos);
+}
+
+
+
+
+
 void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, BLOCKTYPE a_BlockMeta)
 {
 	ASSERT(cChunkDef::IsValidRelPos({ a_RelX, a_RelY, a_RelZ }));
@@ -1315,13 +1894,7 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 		return;
 	}
 
-	bool ReplacingLiquids = (
-		((OldBlockType == E_BLOCK_STATIONARY_WATER) && (a_BlockType == E_BLOCK_WATER)) ||             // Replacing stationary water with water
-		((OldBlockType == E_BLOCK_WATER)            && (a_BlockType == E_BLOCK_STATIONARY_WATER)) ||  // Replacing water with stationary water
-		((OldBlockType == E_BLOCK_STATIONARY_LAVA)  && (a_BlockType == E_BLOCK_LAVA)) ||              // Replacing stationary lava with lava
-		((OldBlockType == E_BLOCK_LAVA)             && (a_BlockType == E_BLOCK_STATIONARY_LAVA))      // Replacing lava with stationary lava
-	);
-
+	const bool ReplacingLiquids = IsReplacingLiquids(OldBlockType, a_BlockType);
 	if (!ReplacingLiquids)
 	{
 		MarkDirty();
@@ -1329,28 +1902,16 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 
 	m_BlockData.SetBlock({ a_RelX, a_RelY, a_RelZ }, a_BlockType);
 
-	// Queue block to be sent only if ...
-	if (
-		!(                                // ... the old and new blocktypes AREN'T leaves (because the client doesn't need meta updates)
-			((OldBlockType == E_BLOCK_LEAVES) && (a_BlockType == E_BLOCK_LEAVES)) ||
-			((OldBlockType == E_BLOCK_NEW_LEAVES) && (a_BlockType == E_BLOCK_NEW_LEAVES))
-		) &&                              // ... AND ...
-		(
-			(OldBlockMeta != a_BlockMeta) || (!ReplacingLiquids)
-		)
-	)
+	if (ShouldSendBlockChange(OldBlockType, OldBlockMeta, a_BlockType, a_BlockMeta, ReplacingLiquids))
 	{
 		m_PendingSendBlocks.emplace_back(m_PosX, m_PosZ, a_RelX, a_RelY, a_RelZ, a_BlockType, a_BlockMeta);
 	}
 
 	m_BlockData.SetMeta({ a_RelX, a_RelY, a_RelZ }, a_BlockMeta);
+	InvalidateMapColour(a_RelX, a_RelZ);
 
 	// ONLY recalculate lighting if it's necessary!
-	if (
-		(cBlockInfo::GetLightValue        (OldBlockType) != cBlockInfo::GetLightValue        (a_BlockType)) ||
-		(cBlockInfo::GetSpreadLightFalloff(OldBlockType) != cBlockInfo::GetSpreadLightFalloff(a_BlockType)) ||
-		(cBlockInfo::IsTransparent        (OldBlockType) != cBlockInfo::IsTransparent        (a_BlockType))
-	)
+	if (IsLightAffected(OldBlockType, a_BlockType))
 	{
 		m_IsLightValid = false;
 	}
@@ -1550,6 +2111,10 @@ void cChunk::RemoveClient(cClientHandle * a_Client)
 	ASSERT(std::distance(itr, m_LoadedByClient.end()) <= 1);
 	// Note: itr can equal m_LoadedByClient.end()
 	m_LoadedByClient.erase(itr, m_LoadedByClient.end());
+	if (m_LoadedByClient.empty())
+	{
+		m_LastUsed = m_World->GetWorldAge();
+	}
 
 	if (!a_Client->IsDestroyed())
 	{
@@ -1707,6 +2272,27 @@ bool cChunk::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback a_Ca
 
 
 
+bool cChunk::ForEachPickupInBlock(Vector3i a_BlockPos, cFunctionRef<bool(cPickup &)> a_Callback) const
+{
+	const auto Cell = m_PickupIndex.find(a_BlockPos);
+	if (Cell == m_PickupIndex.end())
+	{
+		return true;
+	}
+	for (auto * Pickup : Cell->second)
+	{
+		if (Pickup->IsTicking() && a_Callback(*Pickup))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
 bool cChunk::DoWithEntityByID(UInt32 a_EntityID, cEntityCallback a_Callback, bool & a_CallbackResult) const
 {
 	// The entity list is locked by the parent chunkmap's CS
@@ -24,6 +24,9 @@ class cBlockArea;
 class cFluidSimulatorData;
 class cMobCensus;
 class cMobSpawner;
+class cExpOrb;
+class cPickup;
+class cProjectileEntity;
 class cRedstoneSimulatorChunkData;
 
 struct SetChunkData;
@@ -36,6 +39,9 @@ class cChunk
 {
 public:
 
+	/** A spatial hash of entities, keyed by the absolute coords of the block they are in. */
+	using cEntityCells = std::unordered_map<Vector3i, std::vector<cEntity *>, VectorHasher<int>>;
+
 	/** Represents the presence state of the chunk */
 	enum ePresence
 	{
@@ -70,11 +76,21 @@ public:
 	/** Returns true iff the chunk has changed since it was last saved. */
 	bool IsDirty(void) const {return m_IsDirty; }
 
+	/** Returns true iff the chunk is being saved and hasn't changed since the saving started. */
+	bool IsSaving(void) const {return m_IsSaving; }
+
+	/** Returns the world age at which the chunk became dirty. Only meaningful while IsDirty(). */
+	cTickTimeLong GetDirtySince(void) const { return m_DirtySince; }
+
 	bool CanUnload(void) const;
 
 	/** Returns true if the chunk could have been unloaded if it weren't dirty */
 	bool CanUnloadAfterSaving(void) const;
 
+	/** Returns the world age at which the chunk was last used by a client or a chunk stay.
+	The chunks unused for the longest are the first to be unloaded when the world is short of memory. */
+	cTickTimeLong GetLastUsed(void) const { return m_LastUsed; }
+
 	/** Called when the chunkmap unloads unused chunks.
 	Notifies contained entities that they are being unloaded and should for example, broadcast a destroy packet.
 	Not called during server shutdown; such cleanup during shutdown is unnecessary. */
@@ -137,6 +153,10 @@ public:
 	void SetBlock(Vector3i a_RelBlockPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
 	// SetBlock() does a lot of work (heightmap, tickblocks, blockentities) so a BlockIdx version doesn't make sense
 
+	/** Wakes up the simulators for the block at the relative position and for its neighbors, same as when the block is set. */
+	void WakeUpSimulators(Vector3i a_RelPos);
+
+
 	void FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, BLOCKTYPE a_BlockMeta);  // Doesn't force block updates on neighbors, use for simple changes such as grass growing etc.
 	void FastSetBlock(Vector3i a_RelPos, BLOCKTYPE a_BlockType, BLOCKTYPE a_BlockMeta)
 	{
@@ -200,6 +220,12 @@ public:
 
 	int GetHeight( int a_X, int a_Z) const;
 
+	/** Returns the colour of the column on maps, as stored by SetMapColour(), if none of the column's blocks have changed since. */
+	std::optional<Byte> GetMapColour(int a_RelX, int a_RelZ) const;
+
+	/** Stores the colour of the column on maps, computed by cMap from the column's blocks. */
+	void SetMapColour(int a_RelX, int a_RelZ, Byte a_Colour);
+
 	/** Returns true if it is sunny at the specified location. This takes into account biomes. */
 	bool IsWeatherSunnyAt(int a_RelX, int a_RelZ) const;
 
@@ -239,6 +265,11 @@ public:
 	Returns true if all entities processed, false if the callback aborted by returning true. */
 	bool ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback a_Callback) const;  // Lua-accessible
 
+	/** Calls the callback for each pickup in this chunk whose position lies within the specified block (absolute coords).
+	Uses the pickup index that is only built for the duration of Tick(), so that block entities (hoppers) don't need to scan all the entities.
+	Returns true if all pickups processed, false if the callback aborted by returning true. */
+	bool ForEachPickupInBlock(Vector3i a_BlockPos, cFunctionRef<bool(cPickup &)> a_Callback) const;
+
 	/** Calls the callback if the entity with the specified ID is found, with the entity object as the callback param. Returns true if entity found. */
 	bool DoWithEntityByID(UInt32 a_EntityID, cEntityCallback a_Callback, bool & a_CallbackResult) const;  // Lua-accessible
 
@@ -264,7 +295,10 @@ public:
 
 	inline void MarkDirty(void)
 	{
-		m_IsDirty = true;
+		if (!m_IsDirty)
+		{
+			SetDirty();
+		}
 		m_IsSaving = false;
 	}
 
@@ -291,6 +325,7 @@ public:
 	inline void SetMeta(Vector3i a_RelPos, NIBBLETYPE a_Meta)
 	{
 		m_BlockData.SetMeta(a_RelPos, a_Meta);
+		InvalidateMapColour(a_RelPos.x, a_RelPos.z);
 		MarkDirty();
 		m_PendingSendBlocks.emplace_back(m_PosX, m_PosZ, a_RelPos.x, a_RelPos.y, a_RelPos.z, GetBlock(a_RelPos), a_Meta);
 	}
@@ -483,6 +518,9 @@ private:
 	bool m_IsDirty;        // True if the chunk has changed since it was last saved
 	bool m_IsSaving;       // True if the chunk is being saved
 
+	/** The world age at which the chunk last became dirty, the saving is scheduled by it. */
+	cTickTimeLong m_DirtySince;
+
 	/** Blocks that have changed and need to be sent to all clients.
 	The protocol has a provision for coalescing block changes, and this is the buffer.
 	It will collect the block changes that occur in a tick, before being flushed in BroadcastPendingSendBlocks. */
@@ -502,9 +540,26 @@ private:
 	std::vector<OwnedEntity> m_Entities;
 	cBlockEntities m_BlockEntities;
 
+	/** The ticking pickups in m_Entities, indexed by the absolute coords of the block they are in.
+	Built at the start of Tick() and cleared at its end, used for merging the pickups, for the players collecting them
+	and by ForEachPickupInBlock(). */
+	std::unordered_map<Vector3i, std::vector<cPickup *>, VectorHasher<int>> m_PickupIndex;
+
+	/** The ticking experience orbs and projectiles in m_Entities, built and cleared along with m_PickupIndex. */
+	std::vector<cExpOrb *> m_MergedOrbs;
+	std::vector<cProjectileEntity *> m_CollectibleProjectiles;
+
+	/** Scratch storage of the item entity merging and collecting, kept so that each tick reuses its allocations. */
+	std::vector<cPickup *> m_MergedPickups;
+	cEntityCells m_MergeCells;
+	std::vector<cPlayer *> m_NearbyPlayers;
+
 	/** Number of times the chunk has been requested to stay (by various cChunkStay objects); if zero, the chunk can be unloaded */
 	unsigned m_StayCount;
 
+	/** The world age at which the last client or chunk stay left the chunk, or at which it was created. */
+	cTickTimeLong m_LastUsed;
+
 	int m_PosX, m_PosZ;
 	cWorld *    m_World;
 	cChunkMap * m_ChunkMap;
@@ -515,6 +570,9 @@ private:
 	cChunkDef::HeightMap m_HeightMap;
 	cChunkDef::BiomeMap  m_BiomeMap;
 
+	/** The colour of each column on maps, see GetMapColour(). Allocated when the chunk is first drawn on a map. */
+	std::unique_ptr<std::array<std::optional<Byte>, cChunkDef::Width * cChunkDef::Width>> m_MapColours;
+
 	/** Relative coords of the block to tick first in the next Tick() call.
 	Plugins can use this to force a tick in a specific block, using cWorld:SetNextBlockToTick() API. */
 	Vector3i m_BlockToTick;
@@ -536,6 +594,15 @@ private:
 	This is the support for plugin-accessible chunk tick forcing. */
 	unsigned m_AlwaysTicked;
 
+	/** Drops the stored map colour of the column, its blocks have changed. */
+	void InvalidateMapColour(int a_RelX, int a_RelZ)
+	{
+		if (m_MapColours != nullptr)
+		{
+			(*m_MapColours)[static_cast<size_t>(a_RelX + a_RelZ * cChunkDef::Width)].reset();
+		}
+	}
+
 	// Pick up a random block of this chunk
 	void GetRandomBlockCoords(int & a_X, int & a_Y, int & a_Z);
 	void GetThreeRandomNumbers(int & a_X, int & a_Y, int & a_Z, int a_MaxX, int a_MaxY, int a_MaxZ);
@@ -552,6 +619,18 @@ private:
 	/** Ticks several random blocks in the chunk. */
 	void TickBlocks(void);
 
+	/** Fills m_PickupIndex, m_MergedOrbs and m_CollectibleProjectiles with the ticking item entities in this chunk. */
+	void BuildPickupIndex(void);
+
+	/** Hands the pickups and projectiles of this chunk to the players within their reach, in one pass for all the players
+	around the chunk; each player looks up only the index cells within its reach instead of scanning the entities. */
+	void CollectItemEntitiesByPlayers(void);
+
+	/** Merges the compatible pickups and experience orbs that lie close to each other.
+	Uses a spatial hash, so that the cost grows linearly with the number of item entities.
+	Returns the number of entities that were merged into others (and destroyed). */
+	int MergeItemEntities(void);
+
 	/** Adds snow to the top of snowy biomes and hydrates farmland / fills cauldrons in rainy biomes */
 	void ApplyWeatherToTop(void);
 
@@ -569,4 +648,7 @@ private:
 
 	/** Check m_Entities for cPlayer objects. */
 	bool HasPlayerEntities() const;
+
+	/** Marks the clean chunk dirty, remembering when it became dirty. */
+	void SetDirty(void);
 };
@@ -54,15 +54,8 @@ namespace
 template<class ElementType, size_t ElementCount, ElementType DefaultValue>
 void ChunkDataStore<ElementType, ElementCount, DefaultValue>::Assign(const ChunkDataStore<ElementType, ElementCount, DefaultValue> & a_Other)
 {
-	for (size_t Y = 0; Y != cChunkDef::NumSections; Y++)
-	{
-		Store[Y].reset();
-
-		if (const auto & Other = a_Other.Store[Y]; Other != nullptr)
-		{
-			Store[Y] = std::make_unique<Type>(*Other);
-		}
-	}
+	// Share the sections, they get cloned by whichever store writes into them first:
+	std::copy(std::begin(a_Other.Store), std::end(a_Other.Store), std::begin(Store));
 }
 
 
@@ -95,7 +88,7 @@ ElementType ChunkDataStore<ElementType, ElementCount, DefaultValue>::Get(const V
 
 
 template<class ElementType, size_t ElementCount, ElementType DefaultValue>
-typename ChunkDataStore<ElementType, ElementCount, DefaultValue>::Type * ChunkDataStore<ElementType, ElementCount, DefaultValue>::GetSection(const size_t a_Y) const
+const typename ChunkDataStore<ElementType, ElementCount, DefaultValue>::Type * ChunkDataStore<ElementType, ElementCount, DefaultValue>::GetSection(const size_t a_Y) const
 {
 	return Store[a_Y].get();
 }
@@ -104,6 +97,23 @@ typename ChunkDataStore<ElementType, ElementCount, DefaultValue>::Type * ChunkDa
 
 
 
+template<class ElementType, size_t ElementCount, ElementType DefaultValue>
+typename ChunkDataStore<ElementType, ElementCount, DefaultValue>::Type & ChunkDataStore<ElementType, ElementCount, DefaultValue>::GetOrCreateSection(const size_t a_Y)
+{
+	auto & Section = Store[a_Y];
+	if (Section == nullptr)
+	{
+		Section = AllocateSection();
+		std::fill(Section->begin(), Section->end(), DefaultValue);
+		return *Section;
+	}
+	return GetExclusiveSection(a_Y);
+}
+
+
+
+
+
 template<class ElementType, size_t ElementCount, ElementType DefaultValue>
 void ChunkDataStore<ElementType, ElementCount, DefaultValue>::Set(const Vector3i a_Position, const ElementType a_Value)
 {
@@ -117,17 +127,23 @@ void ChunkDataStore<ElementType, ElementCount, DefaultValue>::Set(const Vector3i
 			return;
 		}
 
-		Section = cpp20::make_unique_for_overwrite<Type>();
+		Section = AllocateSection();
 		std::fill(Section->begin(), Section->end(), DefaultValue);
 	}
+	else if (Get(a_Position) == a_Value)
+	{
+		// Don't clone a shared section just to write the same value:
+		return;
+	}
 
+	auto & Exclusive = GetExclusiveSection(Indices.Section);
 	if (IsCompressed(ElementCount))
 	{
-		cChunkDef::PackNibble(Section->data(), Indices.Index, a_Value);
+		cChunkDef::PackNibble(Exclusive.data(), Indices.Index, a_Value);
 	}
 	else
 	{
-		(*Section)[Indices.Index] = a_Value;
+		Exclusive[Indices.Index] = a_Value;
 	}
 }
 
@@ -141,13 +157,14 @@ void ChunkDataStore<ElementType, ElementCount, DefaultValue>::SetSection(const E
 	auto & Section = Store[a_Y];
 	const auto SourceEnd = std::end(a_Source);
 
-	if (Section != nullptr)
+	if ((Section != nullptr) && (Section.use_count() == 1))
 	{
 		std::copy(a_Source, SourceEnd, Section->begin());
 	}
-	else if (std::any_of(a_Source, SourceEnd, [](const auto Value) { return Value != DefaultValue; }))
+	else if ((Section != nullptr) || std::any_of(a_Source, SourceEnd, [](const auto Value) { return Value != DefaultValue; }))
 	{
-		Section = cpp20::make_unique_for_overwrite<Type>();
+		// The whole section gets overwritten, a shared one is replaced rather than cloned:
+		Section = AllocateSection();
 		std::copy(a_Source, SourceEnd, Section->begin());
 	}
 }
@@ -156,6 +173,38 @@ void ChunkDataStore<ElementType, ElementCount, DefaultValue>::SetSection(const E
 
 
 
+template<class ElementType, size_t ElementCount, ElementType DefaultValue>
+std::shared_ptr<typename ChunkDataStore<ElementType, ElementCount, DefaultValue>::Type> ChunkDataStore<ElementType, ElementCount, DefaultValue>::AllocateSection(void) const
+{
+	return std::allocate_shared<Type>(cSectionAllocator<Type>(m_Account));
+}
+
+
+
+
+
+template<class ElementType, size_t ElementCount, ElementType DefaultValue>
+typename ChunkDataStore<ElementType, ElementCount, DefaultValue>::Type & ChunkDataStore<ElementType, ElementCount, DefaultValue>::GetExclusiveSection(const size_t a_Y)
+{
+	auto & Section = Store[a_Y];
+	ASSERT(Section != nullptr);
+	if (Section.use_count() > 1)
+	{
+		// Shared with a snapshot, which keeps the old data:
+		Section = std::allocate_shared<Type>(cSectionAllocator<Type>(m_Account), *Section);
+	}
+	else
+	{
+		// The last other owner may have just released the section on another thread, its reads must happen before our writes:
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+	return *Section;
+}
+
+
+
+
+
 template<class ElementType, size_t ElementCount, ElementType DefaultValue>
 void ChunkDataStore<ElementType, ElementCount, DefaultValue>::SetAll(const ElementType (& a_Source)[cChunkDef::NumSections * ElementCount])
 {
@@ -199,6 +248,17 @@ void ChunkBlockData::SetSection(const SectionType & a_BlockSource, const Section
 
 
 
+
+void ChunkBlockData::SetMemoryAccount(const std::shared_ptr<cMemoryAccount> & a_Account)
+{
+	m_Blocks.SetMemoryAccount(a_Account);
+	m_Metas.SetMemoryAccount(a_Account);
+}
+
+
+
+
+
 void ChunkLightData::Assign(const ChunkLightData & a_Other)
 {
 	m_BlockLights.Assign(a_Other.m_BlockLights);
@@ -229,6 +289,17 @@ void ChunkLightData::SetSection(const SectionType & a_BlockLightSource, const Se
 
 
 
+
+void ChunkLightData::SetMemoryAccount(const std::shared_ptr<cMemoryAccount> & a_Account)
+{
+	m_BlockLights.SetMemoryAccount(a_Account);
+	m_SkyLights.SetMemoryAccount(a_Account);
+}
+
+
+
+
+
 template struct ChunkDataStore<BLOCKTYPE, ChunkBlockData::SectionBlockCount, ChunkBlockData::DefaultValue>;
 template struct ChunkDataStore<NIBBLETYPE, ChunkBlockData::SectionMetaCount, ChunkLightData::DefaultBlockLightValue>;
 template struct ChunkDataStore<NIBBLETYPE, ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue>;
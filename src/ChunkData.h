@@ -3,6 +3,14 @@
 
 // Declares the cChunkData class that represents the block's type, meta, blocklight and skylight storage for a chunk
 
+/*
+The sections are reference-counted and shared between copies: Assign() only copies the pointers, so that a snapshot
+of a chunk, taken while holding the chunkmap lock, costs a handful of pointer copies rather than a full copy.
+A shared section is never modified; the store writing to it first clones it (copy-on-write). All the modifications
+of a chunk's data and all the snapshots of it are made under the chunkmap lock, so a section seen as unshared can
+not become shared while being written.
+*/
+
 
 
 
@@ -11,6 +19,7 @@
 
 #include "FunctionRef.h"
 #include "ChunkDef.h"
+#include "SectionAllocator.h"
 
 
 
@@ -21,7 +30,8 @@ struct ChunkDataStore
 {
 	using Type = std::array<ElementType, ElementCount>;
 
-	/** Copy assign from another ChunkDataStore. */
+	/** Copy assign from another ChunkDataStore.
+	The sections are shared with a_Other until either store writes into them. */
 	void Assign(const ChunkDataStore<ElementType, ElementCount, DefaultValue> & a_Other);
 
 	/** Gets one value at the given position.
@@ -30,7 +40,11 @@ struct ChunkDataStore
 
 	/** Returns a raw pointer to the internal representation of the specified section.
 	Will be nullptr if the section is not allocated. */
-	Type * GetSection(size_t a_Y) const;
+	const Type * GetSection(size_t a_Y) const;
+
+	/** Returns the internal representation of the specified section, for bulk modification.
+	Allocates the section, filled with DefaultValue, if it wasn't allocated before; clones it if it is shared. */
+	Type & GetOrCreateSection(size_t a_Y);
 
 	/** Sets one value at the given position.
 	Allocates a section if needed for the operation. */
@@ -44,8 +58,24 @@ struct ChunkDataStore
 	Allocates sections that are needed for the operation. */
 	void SetAll(const ElementType (& a_Source)[cChunkDef::NumSections * ElementCount]);
 
-	/** Contains all the sections this ChunkDataStore manages. */
-	std::unique_ptr<Type> Store[cChunkDef::NumSections];
+	/** Sets the account charged for the sections allocated from now on. The sections already allocated stay charged to the
+	account they were allocated with. nullptr for no account. */
+	void SetMemoryAccount(std::shared_ptr<cMemoryAccount> a_Account) { m_Account = std::move(a_Account); }
+
+	/** Contains all the sections this ChunkDataStore manages, possibly shared with other stores. */
+	std::shared_ptr<Type> Store[cChunkDef::NumSections];
+
+private:
+
+	/** The account charged for the sections allocated by this store. */
+	std::shared_ptr<cMemoryAccount> m_Account;
+
+
+	/** Returns a new section, allocated from the section pool and charged to m_Account. */
+	std::shared_ptr<Type> AllocateSection(void) const;
+
+	/** Returns the specified allocated section for writing, cloning it first if it is shared with another store. */
+	Type & GetExclusiveSection(size_t a_Y);
 };
 
 
@@ -80,14 +110,20 @@ public:
 	BLOCKTYPE GetBlock(Vector3i a_Position) const { return m_Blocks.Get(a_Position); }
 	NIBBLETYPE GetMeta(Vector3i a_Position) const { return m_Metas.Get(a_Position); }
 
-	BlockArray * GetSection(size_t a_Y) const { return m_Blocks.GetSection(a_Y); }
-	MetaArray * GetMetaSection(size_t a_Y) const { return m_Metas.GetSection(a_Y); }
+	const BlockArray * GetSection(size_t a_Y) const { return m_Blocks.GetSection(a_Y); }
+	const MetaArray * GetMetaSection(size_t a_Y) const { return m_Metas.GetSection(a_Y); }
+
+	BlockArray & GetOrCreateSection(size_t a_Y) { return m_Blocks.GetOrCreateSection(a_Y); }
+	MetaArray & GetOrCreateMetaSection(size_t a_Y) { return m_Metas.GetOrCreateSection(a_Y); }
 
 	void SetBlock(Vector3i a_Position, BLOCKTYPE a_Block) { m_Blocks.Set(a_Position, a_Block); }
 	void SetMeta(Vector3i a_Position, NIBBLETYPE a_Meta) { m_Metas.Set(a_Position, a_Meta); }
 
 	void SetAll(const cChunkDef::BlockTypes & a_BlockSource, const cChunkDef::BlockNibbles & a_MetaSource);
 	void SetSection(const SectionType & a_BlockSource, const SectionMetaType & a_MetaSource, size_t a_Y);
+
+	/** Sets the account charged for the sections allocated from now on. */
+	void SetMemoryAccount(const std::shared_ptr<cMemoryAccount> & a_Account);
 };
 
 
@@ -119,11 +155,14 @@ public:
 	NIBBLETYPE GetBlockLight(Vector3i a_Position) const { return m_BlockLights.Get(a_Position); }
 	NIBBLETYPE GetSkyLight(Vector3i a_Position) const { return m_SkyLights.Get(a_Position); }
 
-	LightArray * GetBlockLightSection(size_t a_Y) const { return m_BlockLights.GetSection(a_Y); }
-	LightArray * GetSkyLightSection(size_t a_Y) const { return m_SkyLights.GetSection(a_Y); }
+	const LightArray * GetBlockLightSection(size_t a_Y) const { return m_BlockLights.GetSection(a_Y); }
+	const LightArray * GetSkyLightSection(size_t a_Y) const { return m_SkyLights.GetSection(a_Y); }
 
 	void SetAll(const cChunkDef::BlockNibbles & a_BlockLightSource, const cChunkDef::BlockNibbles & a_SkyLightSource);
 	void SetSection(const SectionType & a_BlockLightSource, const SectionType & a_SkyLightSource, size_t a_Y);
+
+	/** Sets the account charged for the sections allocated from now on. */
+	void SetMemoryAccount(const std::shared_ptr<cMemoryAccount> & a_Account);
 };
 
 
@@ -2,6 +2,7 @@
 #include "ChunkGeneratorThread.h"
 #include "Generating/ChunkGenerator.h"
 #include "Generating/ChunkDesc.h"
+#include "Profiler.h"
 
 
 
@@ -157,6 +158,7 @@ void cChunkGeneratorThread::Execute(void)
 	int NumChunksGenerated = 0;  // Number of chunks generated since the queue was last empty
 	clock_t GenerationStart = clock();  // Clock tick when the queue started to fill
 	clock_t LastReportTick = clock();  // Clock tick of the last report made (so that performance isn't reported too often)
+	cProfiler::SetCurrentThreadName("Chunk Generator");
 
 	while (!m_ShouldTerminate)
 	{
@@ -227,7 +229,10 @@ void cChunkGeneratorThread::Execute(void)
 		}
 
 		// Generate the chunk:
-		DoGenerate(item.m_Coords);
+		{
+			cProfileScope Profile("cChunkGeneratorThread::DoGenerate");
+			DoGenerate(item.m_Coords);
+		}
 		if (item.m_Callback != nullptr)
 		{
 			item.m_Callback->Call(item.m_Coords, true);
@@ -19,6 +19,8 @@
 #include "Blocks/ChunkInterface.h"
 #include "Entities/Pickup.h"
 #include "DeadlockDetect.h"
+#include "Profiler.h"
+#include "WorldStorage/ChunkSaveScheduler.h"
 
 
 
@@ -28,7 +30,8 @@
 // cChunkMap:
 
 cChunkMap::cChunkMap(cWorld * a_World) :
-	m_World(a_World)
+	m_World(a_World),
+	m_MemoryAccount(std::make_shared<cMemoryAccount>())
 {
 }
 
@@ -160,7 +163,7 @@ void cChunkMap::WakeUpSimulators(Vector3i a_Block)
 		return;
 	}
 
-	m_World->GetSimulatorManager()->WakeUp(*Chunk, cChunkDef::AbsoluteToRelative(a_Block, Position));
+	Chunk->WakeUpSimulators(cChunkDef::AbsoluteToRelative(a_Block, Position));
 }
 
 
@@ -1250,6 +1253,22 @@ bool cChunkMap::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBl
 
 
 
+bool cChunkMap::WriteBlockAreaChunk(cBlockArea & a_Area, const Vector3i a_MinBlock, const int a_DataTypes, const cChunkCoords a_ChunkCoords)
+{
+	cCSLock Lock(m_CSChunks);
+	const auto Chunk = FindChunk(a_ChunkCoords.m_ChunkX, a_ChunkCoords.m_ChunkZ);
+	if ((Chunk == nullptr) || !Chunk->IsValid())
+	{
+		return false;
+	}
+	Chunk->WriteBlockArea(a_Area, a_MinBlock.x, a_MinBlock.y, a_MinBlock.z, a_DataTypes);
+	return true;
+}
+
+
+
+
+
 void cChunkMap::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const
 {
 	a_NumChunksValid = 0;
@@ -1341,6 +1360,8 @@ void cChunkMap::SpawnMobs(cMobSpawner & a_MobSpawner)
 
 void cChunkMap::Tick(std::chrono::milliseconds a_Dt)
 {
+	cProfileScope Profile("cChunkMap::Tick");
+
 	cCSLock Lock(m_CSChunks);
 
 	// Do the magic of updating the world:
@@ -1385,23 +1406,56 @@ void cChunkMap::UnloadUnusedChunks(void)
 	cCSLock Lock(m_CSChunks);
 	for (auto itr = m_Chunks.begin(); itr != m_Chunks.end();)
 	{
-		if (
-			itr->second.CanUnload() &&  // Can unload
-			!cPluginManager::Get()->CallHookChunkUnloading(*GetWorld(), itr->first.m_ChunkX, itr->first.m_ChunkZ)  // Plugins agree
-		)
+		// Advance before the chunk is possibly erased:
+		const auto Chunk = itr++;
+		if (Chunk->second.CanUnload())
+		{
+			TryUnloadChunk(Chunk);
+		}
+	}
+}
+
+
+
+
+
+void cChunkMap::UnloadColdChunks(const size_t a_MemoryBudget)
+{
+	cCSLock Lock(m_CSChunks);
+	if (m_MemoryAccount->GetBytes() <= a_MemoryBudget)
+	{
+		return;
+	}
+
+	// Collect the unused chunks, the coldest first:
+	std::vector<std::pair<cTickTimeLong, cChunkCoords>> Unused;
+	for (const auto & [Coords, Chunk]: m_Chunks)
+	{
+		if (Chunk.CanUnload() || (Chunk.IsValid() && Chunk.CanUnloadAfterSaving()))
 		{
-			// First notify plugins:
-			cPluginManager::Get()->CallHookChunkUnloaded(*m_World, itr->first.m_ChunkX, itr->first.m_ChunkZ);
+			Unused.emplace_back(Chunk.GetLastUsed(), Coords);
+		}
+	}
+	std::sort(Unused.begin(), Unused.end());
 
-			// Notify entities within the chunk, while everything's still valid:
-			itr->second.OnUnload();
+	// Queue more saving only once the previous batch is saved, the storage would save the same chunks again otherwise:
+	auto & Storage = GetWorld()->GetStorage();
+	const bool ShouldSave = (Storage.GetSaveQueueLength() == 0);
+	for (const auto & [LastUsed, Coords]: Unused)
+	{
+		if (m_MemoryAccount->GetBytes() <= a_MemoryBudget)
+		{
+			return;
+		}
 
-			// Kill the chunk:
-			itr = m_Chunks.erase(itr);
+		const auto Chunk = m_Chunks.find(Coords);
+		if (Chunk->second.CanUnload())
+		{
+			TryUnloadChunk(Chunk);
 		}
-		else
+		else if (ShouldSave)
 		{
-			++itr;
+			Storage.QueueSaveChunk(Coords.m_ChunkX, Coords.m_ChunkZ);
 		}
 	}
 }
@@ -1426,6 +1480,34 @@ void cChunkMap::SaveAllChunks(void) const
 
 
 
+void cChunkMap::SaveDirtyChunks(cChunkSaveScheduler & a_Scheduler, const cTickTimeLong a_Period) const
+{
+	cCSLock Lock(m_CSChunks);
+	std::vector<cChunkSaveScheduler::sDirtyChunk> Dirty;
+	for (const auto & [Coords, Chunk]: m_Chunks)
+	{
+		if (Chunk.IsValid() && Chunk.IsDirty() && !Chunk.IsSaving())
+		{
+			Dirty.push_back({ Coords, Chunk.GetDirtySince(), Chunk.CanUnloadAfterSaving() });
+		}
+	}
+	const auto NumToSave = a_Scheduler.Schedule(Dirty, GetWorld()->GetWorldAge(), a_Period);
+
+	auto & Storage = GetWorld()->GetStorage();
+	if (Storage.GetSaveQueueLength() != 0)
+	{
+		return;
+	}
+	for (size_t i = 0; i < NumToSave; i++)
+	{
+		Storage.QueueSaveChunk(Dirty[i].m_Coords.m_ChunkX, Dirty[i].m_Coords.m_ChunkZ);
+	}
+}
+
+
+
+
+
 size_t cChunkMap::GetNumChunks(void) const
 {
 	cCSLock Lock(m_CSChunks);
@@ -1554,3 +1636,27 @@ void cChunkMap::DelChunkStay(cChunkStay & a_ChunkStay)
 	}  // for itr - Chunks[]
 	a_ChunkStay.OnDisabled();
 }
+
+
+
+
+
+bool cChunkMap::TryUnloadChunk(const std::map<cChunkCoords, cChunk>::iterator a_Chunk)
+{
+	const auto & Coords = a_Chunk->first;
+	if (cPluginManager::Get()->CallHookChunkUnloading(*GetWorld(), Coords.m_ChunkX, Coords.m_ChunkZ))
+	{
+		// A plugin refused
+		return false;
+	}
+
+	// First notify plugins:
+	cPluginManager::Get()->CallHookChunkUnloaded(*m_World, Coords.m_ChunkX, Coords.m_ChunkZ);
+
+	// Notify entities within the chunk, while everything's still valid:
+	a_Chunk->second.OnUnload();
+
+	// Kill the chunk:
+	m_Chunks.erase(a_Chunk);
+	return true;
+}
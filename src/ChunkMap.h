@@ -18,6 +18,7 @@ class cWorld;
 class cItem;
 class cItems;
 class cChunkStay;
+class cChunkSaveScheduler;
 class cChunk;
 class cPlayer;
 class cBlockArea;
@@ -238,6 +239,10 @@ public:
 	/** Writes the block area into the specified coords. Returns true if all chunks have been processed. Prefer cBlockArea::Write() instead. */
 	bool WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes);
 
+	/** Writes the part of the block area placed at the specified coords that falls into the specified chunk.
+	Returns true if the chunk was valid and has been written. Used for writing large areas across multiple ticks. */
+	bool WriteBlockAreaChunk(cBlockArea & a_Area, Vector3i a_MinBlock, int a_DataTypes, cChunkCoords a_ChunkCoords);
+
 	/** Returns the number of valid chunks and the number of dirty chunks */
 	void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const;
 
@@ -263,8 +268,21 @@ public:
 	void TickBlock(const Vector3i a_BlockPos);
 
 	void UnloadUnusedChunks(void);
+
+	/** Unloads the unused chunks, the ones unused for the longest first, until the chunk data takes at most a_MemoryBudget bytes.
+	The unused chunks that need saving first are queued for saving, so that a later call can unload them. */
+	void UnloadColdChunks(size_t a_MemoryBudget);
+
 	void SaveAllChunks(void) const;
 
+	/** Queues the dirty chunks that a_Scheduler picks to be saved within the next a_Period.
+	Nothing is queued while the storage is still saving the previous batch, the storage would save the same chunks again otherwise;
+	the scheduler's lag statistics are updated nevertheless. */
+	void SaveDirtyChunks(cChunkSaveScheduler & a_Scheduler, cTickTimeLong a_Period) const;
+
+	/** Returns the account charged for this world's chunk data. */
+	const std::shared_ptr<cMemoryAccount> & GetMemoryAccount(void) const { return m_MemoryAccount; }
+
 	cWorld * GetWorld(void) const { return m_World; }
 
 	size_t GetNumChunks(void) const;
@@ -310,6 +328,9 @@ private:
 
 	cWorld * m_World;
 
+	/** The account charged for the data of the chunks, and for the data prepared for them. */
+	std::shared_ptr<cMemoryAccount> m_MemoryAccount;
+
 	/** The cChunkStay descendants that are currently enabled in this chunkmap */
 	cChunkStays m_ChunkStays;
 
@@ -334,4 +355,6 @@ private:
 	To be used only by cChunkStay; others should use cChunkStay::Disable() instead */
 	void DelChunkStay(cChunkStay & a_ChunkStay);
 
+	/** Unloads the specified chunk, unless a plugin refuses. Returns true if unloaded. Assumes m_CSChunks is locked. */
+	bool TryUnloadChunk(std::map<cChunkCoords, cChunk>::iterator a_Chunk);
 };
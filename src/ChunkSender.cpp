@@ -13,6 +13,7 @@
 #include "BlockEntities/BlockEntity.h"
 #include "ClientHandle.h"
 #include "Chunk.h"
+#include "Profiler.h"
 
 
 
@@ -158,8 +159,20 @@ void cChunkSender::QueueSendChunkTo(int a_ChunkX, int a_ChunkZ, Priority a_Prior
 
 
 
+size_t cChunkSender::GetQueueLength(void)
+{
+	cCSLock Lock(m_CS);
+	return m_SendChunks.size();
+}
+
+
+
+
+
 void cChunkSender::Execute(void)
 {
+	cProfiler::SetCurrentThreadName("Chunk Sender");
+
 	while (!m_ShouldTerminate)
 	{
 		m_evtQueue.Wait();
@@ -193,6 +206,8 @@ void cChunkSender::Execute(void)
 
 void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkZ, const WeakClients & a_Clients)
 {
+	cProfileScope Profile("cChunkSender::SendChunk");
+
 	// Contains strong pointers to clienthandles.
 	std::vector<std::shared_ptr<cClientHandle>> Clients;
 
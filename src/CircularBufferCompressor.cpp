@@ -39,29 +39,3 @@ void CircularBufferCompressor::ReadFrom(cByteBuffer & Buffer, size_t Size)
 	Buffer.ReadSome(m_ContiguousIntermediate, Size);
 }
 
-
-
-
-
-ContiguousByteBufferView CircularBufferExtractor::GetView() const
-{
-	return m_ContiguousIntermediate;
-}
-
-
-
-
-
-Compression::Result CircularBufferExtractor::Extract(size_t UncompressedSize)
-{
-	return m_Extractor.ExtractZLib(m_ContiguousIntermediate, UncompressedSize);
-}
-
-
-
-
-
-void CircularBufferExtractor::ReadFrom(cByteBuffer & Buffer, size_t Size)
-{
-	Buffer.ReadSome(m_ContiguousIntermediate, Size);
-}
@@ -20,6 +20,7 @@ public:
 	ContiguousByteBufferView GetView() const;
 
 	Compression::Result Compress();
+	Compression::Compressor & GetCompressor() { return m_Compressor; }
 	void ReadFrom(cByteBuffer & Buffer);
 	void ReadFrom(cByteBuffer & Buffer, size_t Size);
 
@@ -29,21 +30,3 @@ private:
 	std::basic_string<std::byte> m_ContiguousIntermediate;
 };
 
-
-
-
-
-class CircularBufferExtractor
-{
-public:
-
-	ContiguousByteBufferView GetView() const;
-
-	Compression::Result Extract(size_t UncompressedSize);
-	void ReadFrom(cByteBuffer & Buffer, size_t Size);
-
-private:
-
-	Compression::Extractor m_Extractor;
-	std::basic_string<std::byte> m_ContiguousIntermediate;
-};
@@ -33,6 +33,7 @@
 
 #include "Protocol/Authenticator.h"
 #include "Protocol/Protocol.h"
+#include "Protocol/Protocol_1_8.h"
 #include "CompositeChat.h"
 #include "Items/ItemSword.h"
 
@@ -52,6 +53,12 @@
 /** Maximum number of chunks to stream per tick. */
 #define MAX_CHUNKS_STREAMED_PER_TICK 4
 
+/** Maximum number of bytes of framed packets that may wait for the tick thread, the client is kicked if exceeded. */
+#define MAX_INCOMING_PACKETS_SIZE (256 KiB)
+
+/** Number of bytes waiting to be sent to the client above which no more chunks are streamed to it. */
+#define MAX_OUTGOING_DATA_BACKLOG (2 MiB)
+
 
 
 
@@ -65,13 +72,32 @@ Vector3i cClientHandle::s_IllegalPosition = {0, cChunkDef::Height + 1, 0};
 
 
 
+
+
+/** Returns true if the IP address, as reported by cTCPLink, is a loopback one. */
+static bool IsLoopbackAddress(const AString & a_IP)
+{
+	return (a_IP == "::1") || (a_IP.rfind("127.", 0) == 0) || (a_IP.rfind("::ffff:127.", 0) == 0);
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cClientHandle:
 
 cClientHandle::cClientHandle(const AString & a_IPString, int a_ViewDistance) :
 	m_CurrentViewDistance(a_ViewDistance),
 	m_RequestedViewDistance(a_ViewDistance),
+	m_ViewDistanceLimit(MAX_VIEW_DISTANCE),
+	m_EgressBytes(0),
+	m_TimeSinceViewDistanceEvaluation(0),
 	m_IPString(a_IPString),
+	m_IsFramingOffloaded(false),
+	m_IsIncomingBufferFull(false),
+	m_OutgoingDataSize(0),
+	m_IsFlushQueued(false),
 	m_Player(nullptr),
 	m_CachedSentChunk(std::numeric_limits<decltype(m_CachedSentChunk.m_ChunkX)>::max(), std::numeric_limits<decltype(m_CachedSentChunk.m_ChunkZ)>::max()),
 	m_ProxyConnection(false),
@@ -131,9 +157,9 @@ void cClientHandle::Destroy(void)
 	LOGD("%s: destroying client %p, \"%s\" @ %s", __FUNCTION__, static_cast<void *>(this), m_Username.c_str(), m_IPString.c_str());
 
 	{
-		cCSLock Lock(m_CSOutgoingData);
-		m_Protocol.HandleOutgoingData(m_OutgoingData);  // Finalise any encryption.
-		m_Link->Send(m_OutgoingData.data(), m_OutgoingData.size());  // Flush remaining data.
+		cCSLock Lock(m_CSFlush);
+		const auto OutgoingData = PrepareOutgoingData();  // Compress and finalise any encryption.
+		m_Link->Send(OutgoingData.data(), OutgoingData.size());  // Flush remaining data.
 		m_Link->Shutdown();  // Cleanly close the connection.
 		m_Link.reset();  // Release the strong reference cTCPLink holds to ourself.
 	}
@@ -247,25 +273,69 @@ void cClientHandle::ProcessProtocolIn(void)
 {
 	// Process received network data:
 	decltype(m_IncomingData) IncomingData;
+	AString IncomingDataError;
+	bool IsIncomingBufferFull;
 	{
 		cCSLock Lock(m_CSIncomingData);
 
 		// Bail out when nothing was received:
-		if (m_IncomingData.empty())
+		if (m_IncomingData.empty() && m_IncomingPacketSizes.empty() && m_IncomingDataError.empty() && !m_IsIncomingBufferFull)
 		{
 			return;
 		}
 
+		// Hand the emptied buffers from the previous call over to the network thread in exchange for the new packets:
+		m_ProcessingPackets.clear();
+		m_ProcessingPacketSizes.clear();
+		std::swap(m_ProcessingPackets, m_IncomingPackets);
+		std::swap(m_ProcessingPacketSizes, m_IncomingPacketSizes);
+
 		std::swap(IncomingData, m_IncomingData);
+		std::swap(IncomingDataError, m_IncomingDataError);
+		IsIncomingBufferFull = std::exchange(m_IsIncomingBufferFull, false);
 	}
 
 	try
 	{
-		m_Protocol.HandleIncomingData(*this, IncomingData);
+		// While logging in, the raw data is framed here, because any packet may change the encryption or compression.
+		// Those packets also pick the protocol and start its encryptor, both used by the flush worker, keep it out meanwhile:
+		if (!IncomingData.empty())
+		{
+			cCSLock Lock(m_CSFlush);
+			m_Protocol.HandleIncomingData(*this, IncomingData);
+		}
+
+		// Afterwards, the network thread has already framed the packets:
+		size_t PacketStart = 0;
+		for (const auto PacketSize : m_ProcessingPacketSizes)
+		{
+			m_Protocol.HandleIncomingPacket({ m_ProcessingPackets.data() + PacketStart, PacketSize });
+			PacketStart += PacketSize;
+		}
 	}
 	catch (const std::exception & Oops)
 	{
 		Kick(Oops.what());
+		return;
+	}
+
+	if (IsIncomingBufferFull)
+	{
+		PacketBufferFull();
+		return;
+	}
+	if (!IncomingDataError.empty())
+	{
+		Kick(IncomingDataError);
+		return;
+	}
+
+	// Once the protocol has settled on its encryption and compression, hand the framing over to the network thread.
+	// Any raw data received meanwhile needs to be framed here first, so the handover waits for a tick when there's none:
+	if (!IncomingData.empty() && m_Protocol.IsFramingFinal())
+	{
+		cCSLock Lock(m_CSIncomingData);
+		m_IsFramingOffloaded = m_IncomingData.empty();
 	}
 }
 
@@ -274,28 +344,150 @@ void cClientHandle::ProcessProtocolIn(void)
 
 
 void cClientHandle::ProcessProtocolOut()
+{
+	// Bail out if the client is already waiting for its flush worker:
+	if (m_IsFlushQueued.exchange(true))
+	{
+		return;
+	}
+
+	// The compression, encryption and sending is done by the flush worker owning this client, away from the tick thread:
+	cRoot::Get()->GetServer()->GetFlushWorkerPool().QueueFlush(shared_from_this());
+}
+
+
+
+
+
+void cClientHandle::FlushOutgoingData(void)
+{
+	// Any data queued from now on needs another flush:
+	m_IsFlushQueued = false;
+
+	cCSLock Lock(m_CSFlush);
+
+	// Due to cTCPLink's design of holding a strong pointer to ourself, we need to explicitly reset m_Link.
+	// This means we need to check it's not nullptr before trying to send; m_CSFlush prevents it being reset meanwhile:
+	if (m_Link == nullptr)
+	{
+		return;
+	}
+
+	const auto OutgoingData = PrepareOutgoingData();
+
+	// Bail out when there's nothing to send to avoid TCPLink::Send overhead:
+	if (OutgoingData.empty())
+	{
+		return;
+	}
+
+	m_EgressBytes += OutgoingData.size();
+	m_Link->Send(OutgoingData.data(), OutgoingData.size());
+}
+
+
+
+
+
+size_t cClientHandle::GetOutgoingDataBacklog(void) const
+{
+	size_t Backlog = m_OutgoingDataSize;
+
+	// Also count the data that the link couldn't send yet, a slow client is just as backlogged as a busy flush worker:
+	if (auto Link = m_Link; Link != nullptr)
+	{
+		Backlog += Link->GetOutgoingDataSize();
+	}
+	return Backlog;
+}
+
+
+
+
+
+bool cClientHandle::IsOutgoingDataBacklogged(void) const
+{
+	return (GetOutgoingDataBacklog() > MAX_OUTGOING_DATA_BACKLOG);
+}
+
+
+
+
+
+bool cClientHandle::StartTrackingEntity(const UInt32 a_EntityID)
+{
+	cCSLock Lock(m_CSTrackedEntities);
+	return m_TrackedEntities.insert(a_EntityID).second;
+}
+
+
+
+
+
+void cClientHandle::StopTrackingEntity(const UInt32 a_EntityID)
+{
+	cCSLock Lock(m_CSTrackedEntities);
+	m_TrackedEntities.erase(a_EntityID);
+}
+
+
+
+
+
+ContiguousByteBuffer cClientHandle::PrepareOutgoingData(void)
 {
 	decltype(m_OutgoingData) OutgoingData;
 	{
 		cCSLock Lock(m_CSOutgoingData);
+		std::swap(OutgoingData, m_OutgoingData);
+	}
+
+	// The compressors are large, keep one per thread and level rather than one per client:
+	thread_local std::array<std::unique_ptr<Compression::Compressor>, 13> Compressors;
+	const auto Level = static_cast<size_t>(m_CompressionController.GetLevel());
+	ASSERT(Level < Compressors.size());
+	if (Compressors[Level] == nullptr)
+	{
+		Compressors[Level] = std::make_unique<Compression::Compressor>(static_cast<int>(Level));
+	}
+	auto & Compressor = *Compressors[Level];
+	const auto Threshold = m_CompressionController.GetThreshold();
 
-		// Bail out when there's nothing to send to avoid TCPLink::Send overhead:
-		if (m_OutgoingData.empty())
+	ContiguousByteBuffer Data;
+	size_t InputSize = 0, OutputSize = 0;
+	cCompressionController::clock::duration CompressionTime(0);
+	for (const auto & Run : OutgoingData)
+	{
+		m_OutgoingDataSize -= Run.m_Data.size();
+		if (!Run.m_ShouldCompress)
 		{
-			return;
+			Data += Run.m_Data;
+			continue;
 		}
 
-		std::swap(OutgoingData, m_OutgoingData);
+		const auto Start = cCompressionController::clock::now();
+		const auto SizeBefore = Data.size();
+		const ContiguousByteBufferView Packets(Run.m_Data);
+		size_t Offset = 0;
+		for (const auto PacketSize : Run.m_PacketSizes)
+		{
+			cProtocol_1_8_0::AppendCompressedPacket(Packets.substr(Offset, PacketSize), Compressor, Threshold, Data);
+			Offset += PacketSize;
+		}
+		CompressionTime += cCompressionController::clock::now() - Start;
+		InputSize += Run.m_Data.size();
+		OutputSize += Data.size() - SizeBefore;
 	}
 
-	// Due to cTCPLink's design of holding a strong pointer to ourself, we need to explicitly reset m_Link.
-	// This means we need to check it's not nullptr before trying to send, but also capture the link,
-	// to prevent it being reset between the null check and the Send:
-	if (auto Link = m_Link; Link != nullptr)
+	if (InputSize > 0)
 	{
-		m_Protocol.HandleOutgoingData(OutgoingData);
-		Link->Send(OutgoingData.data(), OutgoingData.size());
+		// The link may be gone meanwhile, then nothing is waiting in it:
+		const auto Link = m_Link;
+		m_CompressionController.OnFlush(InputSize, OutputSize, CompressionTime, (Link == nullptr) ? 0 : Link->GetOutgoingDataSize());
 	}
+
+	m_Protocol.HandleOutgoingData(Data);  // Finalise any encryption.
+	return Data;
 }
 
 
@@ -396,6 +588,15 @@ void cClientHandle::Authenticate(AString && a_Name, const cUUID & a_UUID, Json::
 		m_Properties = std::move(a_Properties);
 	}
 
+	// Choose the compression settings before the login success enables the compression.
+	// The proxies are trusted to be close, the link to them is as cheap as the loopback:
+	const auto Link = m_Link;
+	const bool IsLocalLink = m_ProxyConnection || ((Link != nullptr) && IsLoopbackAddress(Link->GetRemoteIP()));
+	{
+		cCSLock Lock(m_CSFlush);
+		m_CompressionController.Init(cRoot::Get()->GetServer()->GetCompressionSettings(), IsLocalLink);
+	}
+
 	// Send login success (if the protocol supports it):
 	m_Protocol->SendLoginSuccess();
 
@@ -2034,8 +2235,38 @@ void cClientHandle::SendData(const ContiguousByteBufferView a_Data)
 		return;
 	}
 
+	m_OutgoingDataSize += a_Data.size();
+
+	cCSLock Lock(m_CSOutgoingData);
+	if (m_OutgoingData.empty() || m_OutgoingData.back().m_ShouldCompress)
+	{
+		m_OutgoingData.push_back({false, {}, {}});
+	}
+	m_OutgoingData.back().m_Data += a_Data;
+}
+
+
+
+
+
+void cClientHandle::SendUncompressedPacket(const ContiguousByteBufferView a_Packet)
+{
+	if (m_HasSentDC)
+	{
+		// This could crash the client, because they've already unloaded the world etc., and suddenly a wild packet appears (#31)
+		return;
+	}
+
+	m_OutgoingDataSize += a_Packet.size();
+
 	cCSLock Lock(m_CSOutgoingData);
-	m_OutgoingData += a_Data;
+	if (m_OutgoingData.empty() || !m_OutgoingData.back().m_ShouldCompress)
+	{
+		m_OutgoingData.push_back({true, {}, {}});
+	}
+	auto & Run = m_OutgoingData.back();
+	Run.m_Data += a_Packet;
+	Run.m_PacketSizes.push_back(a_Packet.size());
 }
 
 
@@ -2180,8 +2411,27 @@ void cClientHandle::Tick(std::chrono::milliseconds a_Dt)
 		}
 	}
 
-	// Send a couple of chunks to the player:
-	StreamNextChunks();
+	// Adapt the view distance to this client's egress and to the world's load (every 2 seconds):
+	if ((m_TimeSinceViewDistanceEvaluation += a_Dt) > 2s)
+	{
+		size_t ChunkBacklog;
+		{
+			cCSLock Lock(m_CSChunkLists);
+			ChunkBacklog = m_ChunksToSend.size();
+		}
+		const auto EgressBytesPerSecond = m_EgressBytes.exchange(0) * 1000 / static_cast<size_t>(m_TimeSinceViewDistanceEvaluation.count());
+		m_ViewDistanceLimit = m_Player->GetWorld()->GetViewDistanceController().GetClientLimit(
+			std::min(m_ViewDistanceLimit, m_CurrentViewDistance), EgressBytesPerSecond, ChunkBacklog
+		);
+		m_TimeSinceViewDistanceEvaluation = 0s;
+	}
+	UpdateViewDistance();
+
+	// Send a couple of chunks to the player, unless they can't keep up with the data already being sent:
+	if (!IsOutgoingDataBacklogged())
+	{
+		StreamNextChunks();
+	}
 
 	// Unload all chunks that are out of the view distance (every 5 seconds):
 	if ((m_TimeSinceLastUnloadCheck += a_Dt) > 5s)
@@ -2553,6 +2803,7 @@ void cClientHandle::SendCollectEntity(const cEntity & a_Collected, const cEntity
 
 void cClientHandle::SendDestroyEntity(const cEntity & a_Entity)
 {
+	StopTrackingEntity(a_Entity.GetUniqueID());
 	m_Protocol->SendDestroyEntity(a_Entity);
 }
 
@@ -2650,6 +2901,15 @@ void cClientHandle::SendEntityPosition(const cEntity & a_Entity)
 
 
 
+void cClientHandle::SendEntityTeleport(const cEntity & a_Entity)
+{
+	m_Protocol->SendEntityTeleport(a_Entity);
+}
+
+
+
+
+
 void cClientHandle::SendEntityProperties(const cEntity & a_Entity)
 {
 	m_Protocol->SendEntityProperties(a_Entity);
@@ -2751,9 +3011,9 @@ void cClientHandle::SendInventorySlot(char a_WindowID, short a_SlotNum, const cI
 
 
 
-void cClientHandle::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cClientHandle::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight)
 {
-	m_Protocol->SendMapData(a_Map, a_DataStartX, a_DataStartY);
+	m_Protocol->SendMapData(a_Map, a_DataStartX, a_DataStartY, a_DataWidth, a_DataHeight);
 }
 
 
@@ -3303,16 +3563,43 @@ void cClientHandle::SetViewDistance(int a_ViewDistance)
 	m_RequestedViewDistance = a_ViewDistance;
 	LOGD("%s is requesting ViewDistance of %d!", GetUsername().c_str(), m_RequestedViewDistance);
 
-	cWorld * world = m_Player->GetWorld();
-	if (world != nullptr)
+	UpdateViewDistance();
+
+	// Restart chunk streaming even if the distance didn't change, this is also used after the player changes worlds:
+	m_LastStreamedChunkX = std::numeric_limits<decltype(m_LastStreamedChunkX)>::max();
+	m_LastStreamedChunkZ = std::numeric_limits<decltype(m_LastStreamedChunkZ)>::max();
+}
+
+
+
+
+
+void cClientHandle::UpdateViewDistance(void)
+{
+	cWorld * World = m_Player->GetWorld();
+	if (World == nullptr)
 	{
-		// Set the current view distance based on the requested VD and world max VD:
-		m_CurrentViewDistance = Clamp(a_ViewDistance, cClientHandle::MIN_VIEW_DISTANCE, world->GetMaxViewDistance());
+		return;
+	}
+
+	// Set the current view distance based on the requested VD, world max VD and the adaptive limits:
+	const auto MaxViewDistance = std::min(World->GetViewDistanceController().GetWorldViewDistance(World->GetMaxViewDistance()), m_ViewDistanceLimit);
+	const auto ViewDistance = Clamp(m_RequestedViewDistance, cClientHandle::MIN_VIEW_DISTANCE, std::max(MaxViewDistance, cClientHandle::MIN_VIEW_DISTANCE));
+	if (ViewDistance == m_CurrentViewDistance)
+	{
+		return;
+	}
+	m_CurrentViewDistance = ViewDistance;
 
-		// Restart chunk streaming to respond to new view distance:
-		m_LastStreamedChunkX = std::numeric_limits<decltype(m_LastStreamedChunkX)>::max();
-		m_LastStreamedChunkZ = std::numeric_limits<decltype(m_LastStreamedChunkZ)>::max();
+	// Let the client know, so that it renders and keeps exactly the chunks it's being sent (1.14+):
+	if (IsPlaying())
+	{
+		m_Protocol->SendUpdateViewDistance(m_CurrentViewDistance);
 	}
+
+	// Restart chunk streaming to respond to new view distance:
+	m_LastStreamedChunkX = std::numeric_limits<decltype(m_LastStreamedChunkX)>::max();
+	m_LastStreamedChunkZ = std::numeric_limits<decltype(m_LastStreamedChunkZ)>::max();
 }
 
 
@@ -3447,9 +3734,38 @@ void cClientHandle::OnReceivedData(const char * a_Data, size_t a_Length)
 	// Reset the timeout:
 	m_TicksSinceLastPacket = 0;
 
-	// Queue the incoming data to be processed in the tick thread:
 	cCSLock Lock(m_CSIncomingData);
-	m_IncomingData.append(reinterpret_cast<const std::byte *>(a_Data), a_Length);
+	if (!m_IsFramingOffloaded)
+	{
+		// Queue the incoming data to be processed in the tick thread:
+		m_IncomingData.append(reinterpret_cast<const std::byte *>(a_Data), a_Length);
+		return;
+	}
+
+	// Don't bother with any more data once the client is about to be kicked:
+	if (!m_IncomingDataError.empty() || m_IsIncomingBufferFull)
+	{
+		return;
+	}
+
+	// Decrypt, decompress and split the data into packets right here, so that the tick thread only needs to handle them.
+	// Any error is turned into a kick on the tick thread:
+	ContiguousByteBuffer Data(reinterpret_cast<const std::byte *>(a_Data), a_Length);
+	try
+	{
+		m_IsIncomingBufferFull = !m_Protocol.FrameIncomingData(Data, m_IncomingPackets, m_IncomingPacketSizes, m_IncomingDataError);
+	}
+	catch (const std::exception & Oops)
+	{
+		m_IncomingDataError = Oops.what();
+		return;
+	}
+
+	if (m_IncomingPackets.size() > MAX_INCOMING_PACKETS_SIZE)
+	{
+		// The tick thread cannot keep up with the client:
+		m_IsIncomingBufferFull = true;
+	}
 }
 
 
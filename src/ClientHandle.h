@@ -16,6 +16,7 @@
 #include "json/json.h"
 #include "ChunkSender.h"
 #include "EffectID.h"
+#include "Protocol/CompressionController.h"
 #include "Protocol/ForgeHandshake.h"
 #include "Protocol/ProtocolRecognizer.h"
 #include "UUID.h"
@@ -109,9 +110,33 @@ public:  // tolua_export
 	Called by both cWorld::Tick() and ServerTick(). */
 	void ProcessProtocolIn(void);
 
-	/** Flushes all buffered outgoing data to the network. */
+	/** Schedules all buffered outgoing data to be flushed to the network by the server's flush workers. */
 	void ProcessProtocolOut();
 
+	/** Compresses and encrypts all buffered outgoing data and sends it to the network.
+	Called by the flush worker owning this client (or right away by ProcessProtocolOut() if there are no workers). */
+	void FlushOutgoingData(void);
+
+	/** Returns the number of bytes of outgoing data waiting to be sent, both buffered and queued in the link. */
+	size_t GetOutgoingDataBacklog(void) const;
+
+	/** Returns true if the outgoing data waiting to be sent has grown so large that no more chunks should be streamed to the client.
+	The chunks are streamed again once the backlog drains. */
+	bool IsOutgoingDataBacklogged(void) const;
+
+	/** Returns the size from which the packets sent to the client are compressed. Fixed once the client logs in. */
+	UInt32 GetCompressionThreshold(void) const { return m_CompressionController.GetThreshold(); }
+
+	/** Returns the level at which the packets sent to the client are currently compressed. */
+	int GetCompressionLevel(void) const { return m_CompressionController.GetLevel(); }
+
+	/** Adds the entity into the set of entities whose movement the client is kept up to date with (see cEntityTracker).
+	Returns true if the entity wasn't tracked before, meaning that the client needs its absolute position first. */
+	bool StartTrackingEntity(UInt32 a_EntityID);
+
+	/** Removes the entity from the set of tracked entities, so that it gets an absolute position update once tracked again. */
+	void StopTrackingEntity(UInt32 a_EntityID);
+
 	/** Formats the type of message with the proper color and prefix for sending to the client. */
 	static AString FormatMessageType(bool ShouldAppendChatPrefixes, eMessageType a_ChatPrefix, const AString & a_AdditionalData);
 
@@ -134,6 +159,10 @@ public:  // tolua_export
 	/** Remove all loaded chunks that are no longer in range */
 	void UnloadOutOfRangeChunks(void);
 
+	/** Recalculates the current view distance from the requested one, the world's adaptive limit and this client's
+	adaptive limit; restarts chunk streaming if it changed. */
+	void UpdateViewDistance(void);
+
 	inline bool IsLoggedIn(void) const { return (m_State >= csAuthenticating); }
 
 	/** Called while the client is being ticked from the world via its cPlayer object */
@@ -182,6 +211,7 @@ public:  // tolua_export
 	void SendEntityLook                 (const cEntity & a_Entity);
 	void SendEntityMetadata             (const cEntity & a_Entity);
 	void SendEntityPosition             (const cEntity & a_Entity);
+	void SendEntityTeleport             (const cEntity & a_Entity);
 	void SendEntityProperties           (const cEntity & a_Entity);
 	void SendEntityVelocity             (const cEntity & a_Entity);
 	void SendExperience                 (void);
@@ -193,7 +223,7 @@ public:  // tolua_export
 	void SendHideTitle                  (void);   // tolua_export
 	void SendInventorySlot              (char a_WindowID, short a_SlotNum, const cItem & a_Item);
 	void SendLeashEntity                (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo);  // tolua_export
-	void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY);
+	void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight);
 	void SendPaintingSpawn              (const cPainting & a_Painting);
 	void SendParticleEffect             (const AString & a_ParticleName, Vector3f a_Source, Vector3f a_Offset, float a_ParticleData, int a_ParticleAmount);
 	void SendParticleEffect             (const AString & a_ParticleName, const Vector3f a_Src, const Vector3f a_Offset, float a_ParticleData, int a_ParticleAmount, std::array<int, 2> a_Data);
@@ -409,8 +439,12 @@ public:  // tolua_export
 	Return true to allow the user in; false to kick them. */
 	bool HandleLogin();
 
+	/** Queues data that is ready to be sent (already framed and compressed, if applicable). */
 	void SendData(ContiguousByteBufferView a_Data);
 
+	/** Queues a single packet without the packet length, to be compressed by the flush worker before sending. */
+	void SendUncompressedPacket(ContiguousByteBufferView a_Packet);
+
 	/** Called when the player moves into a different world.
 	Sends an UnloadChunk packet for each loaded chunk and resets the streamed chunks. */
 	void RemoveFromWorld(void);
@@ -442,6 +476,15 @@ private:
 	/** The requested view distance from the player. It isn't clamped with 1 and the max view distance of the world. */
 	int m_RequestedViewDistance;
 
+	/** The view distance limit for this client set by the world's cViewDistanceController, based on the client's egress. */
+	int m_ViewDistanceLimit;
+
+	/** Number of bytes sent to the client since the last view distance limit evaluation. */
+	std::atomic<size_t> m_EgressBytes;
+
+	/** The time since the client's view distance limit was last evaluated. */
+	std::chrono::milliseconds m_TimeSinceViewDistanceEvaluation;
+
 	AString m_IPString;
 
 	AString m_Username;
@@ -453,21 +496,82 @@ private:
 	std::unordered_set<cChunkCoords, cChunkCoordsHash> m_ChunksToSend;  // Chunks that need to be sent to the player (queued because they weren't generated yet or there's not enough time to send them)
 	cChunkCoordsList                                   m_SentChunks;    // Chunks that are currently sent to the client
 
+	/** The IDs of the entities whose movement the client is kept up to date with, see cEntityTracker.
+	Protected by m_CSTrackedEntities, because the entities may be in a different world's thread while the player is moving between worlds. */
+	std::unordered_set<UInt32> m_TrackedEntities;
+	cCriticalSection m_CSTrackedEntities;
+
 	cMultiVersionProtocol m_Protocol;
 
 	/** Protects m_IncomingData against multithreaded access. */
 	cCriticalSection m_CSIncomingData;
 
 	/** Queue for the incoming data received on the link until it is processed in ProcessProtocolIn().
+	Only used while logging in, see m_IsFramingOffloaded.
 	Protected by m_CSIncomingData. */
 	ContiguousByteBuffer m_IncomingData;
 
+	/** Set by the tick thread once the protocol has settled on its encryption and compression.
+	From then on, the received data is decrypted, decompressed and split into packets right away on the network thread,
+	and queued in m_IncomingPackets instead of m_IncomingData.
+	Protected by m_CSIncomingData. */
+	bool m_IsFramingOffloaded;
+
+	/** Queue for the payloads of the packets framed on the network thread until they are handled in ProcessProtocolIn().
+	The payloads are stored back-to-back, their sizes are in m_IncomingPacketSizes.
+	Protected by m_CSIncomingData. */
+	ContiguousByteBuffer m_IncomingPackets;
+
+	/** The sizes of the individual packets in m_IncomingPackets. Protected by m_CSIncomingData. */
+	std::vector<size_t> m_IncomingPacketSizes;
+
+	/** The packets being handled by ProcessProtocolIn(), swapped with m_IncomingPackets and m_IncomingPacketSizes.
+	They are emptied but stay allocated, so that the two pairs of buffers take turns and the steady flow of packets doesn't allocate.
+	Only accessed in the tick thread (and within m_CSIncomingData when swapping). */
+	ContiguousByteBuffer m_ProcessingPackets;
+	std::vector<size_t> m_ProcessingPacketSizes;
+
+	/** Set when the network thread failed to frame the received data, so that the tick thread kicks the client.
+	Empty if no error occurred. Protected by m_CSIncomingData. */
+	AString m_IncomingDataError;
+
+	/** Set when the network thread couldn't buffer the received data, so that the tick thread kicks the client.
+	Protected by m_CSIncomingData. */
+	bool m_IsIncomingBufferFull;
+
+	/** A run of consecutive outgoing data of the same kind. */
+	struct sOutgoingData
+	{
+		/** If true, m_Data consists of packets that need compressing before being sent, their sizes are in m_PacketSizes.
+		If false, m_Data is sent as-is, apart from the encryption. */
+		bool m_ShouldCompress;
+
+		ContiguousByteBuffer m_Data;
+
+		std::vector<size_t> m_PacketSizes;
+	};
+
 	/** Protects m_OutgoingData against multithreaded access. */
 	cCriticalSection m_CSOutgoingData;
 
-	/** Buffer for storing outgoing data from any thread; will get sent in ProcessProtocolOut() at the end of each tick.
+	/** Buffer for storing outgoing data from any thread; will get sent in FlushOutgoingData() after ProcessProtocolOut() at the end of each tick.
 	Protected by m_CSOutgoingData. */
-	ContiguousByteBuffer m_OutgoingData;
+	std::vector<sOutgoingData> m_OutgoingData;
+
+	/** Serializes the flushes, so that the data is compressed, encrypted and sent in order.
+	Held for the whole duration of a flush, also protects m_Link from being reset while sending.
+	The tick thread holds it while handling the login packets, since they choose m_Protocol and start its encryption. */
+	cCriticalSection m_CSFlush;
+
+	/** Number of bytes queued in m_OutgoingData and not yet sent, used for the backpressure. */
+	std::atomic<size_t> m_OutgoingDataSize;
+
+	/** Set while the client is waiting in a flush worker's queue, so that it isn't queued multiple times. */
+	std::atomic<bool> m_IsFlushQueued;
+
+	/** Chooses the compression threshold at login, and adapts the compression level to the CPU and egress load.
+	Initialized in Authenticate() and used by the flushes, both under m_CSFlush. */
+	cCompressionController m_CompressionController;
 
 	/** A pointer to a World-owned player object, created in FinishAuthenticate when authentication succeeds.
 	The player should only be accessed from the tick thread of the World that owns him.
@@ -569,7 +673,7 @@ private:
 	UInt32 m_ProtocolVersion;
 
 	/** The link that is used for network communication.
-	m_CSOutgoingData is used to synchronize access for sending data. */
+	m_CSFlush is used to synchronize access for sending data. */
 	cTCPLinkPtr m_Link;
 
 	/** The fraction between 0 and 1 (or above), of how far through mining the currently mined block is.
@@ -579,6 +683,10 @@ private:
 	/** Finish logging the user in after authenticating. */
 	void FinishAuthenticate();
 
+	/** Takes all the queued outgoing data, compresses the packets that need it and encrypts the result.
+	Returns the data ready to be sent to the link. The caller must hold m_CSFlush. */
+	ContiguousByteBuffer PrepareOutgoingData(void);
+
 	/** Returns true if the rate block interactions is within a reasonable limit (bot protection) */
 	bool CheckBlockInteractionsRate(void);
 
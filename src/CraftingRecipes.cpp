@@ -266,6 +266,7 @@ void cCraftingRecipe::Dump(void)
 cCraftingRecipes::cCraftingRecipes(void)
 {
 	LoadRecipes();
+	IndexRecipes();
 	PopulateRecipeNameMap();
 }
 
@@ -348,7 +349,7 @@ cCraftingRecipes::cRecipe * cCraftingRecipes::GetRecipeById(UInt32 a_RecipeId)
 
 
 
-void cCraftingRecipes::GetRecipe(cPlayer & a_Player, cCraftingGrid & a_CraftingGrid, cCraftingRecipe & a_Recipe)
+void cCraftingRecipes::GetRecipe(cPlayer & a_Player, cCraftingGrid & a_CraftingGrid, cCraftingRecipe & a_Recipe, cRecipeCache * a_Cache)
 {
 	// Allow plugins to intercept recipes using a pre-craft hook:
 	if (cRoot::Get()->GetPluginManager()->CallHookPreCrafting(a_Player, a_CraftingGrid, a_Recipe))
@@ -357,7 +358,7 @@ void cCraftingRecipes::GetRecipe(cPlayer & a_Player, cCraftingGrid & a_CraftingG
 	}
 
 	// Built-in recipes:
-	std::unique_ptr<cRecipe> Recipe(FindRecipe(a_CraftingGrid.GetItems(), a_CraftingGrid.GetWidth(), a_CraftingGrid.GetHeight()));
+	std::unique_ptr<cRecipe> Recipe(FindRecipe(a_CraftingGrid.GetItems(), a_CraftingGrid.GetWidth(), a_CraftingGrid.GetHeight(), a_Cache));
 	a_Recipe.Clear();
 	if (Recipe.get() == nullptr)
 	{
@@ -442,6 +443,122 @@ void cCraftingRecipes::ClearRecipes(void)
 		delete *itr;
 	}
 	m_Recipes.clear();
+	m_RecipesByShape.clear();
+	m_RecipesByIngredients.clear();
+	m_UnindexedRecipes.clear();
+}
+
+
+
+
+
+void cCraftingRecipes::IndexRecipes(void)
+{
+	m_RecipesByShape.clear();
+	m_RecipesByIngredients.clear();
+	m_UnindexedRecipes.clear();
+
+	for (size_t i = 0; i < m_Recipes.size(); i++)
+	{
+		const cRecipe * Recipe = m_Recipes[i];
+		std::vector<short> Shape(static_cast<size_t>(Recipe->m_Width * Recipe->m_Height), -1);
+		std::vector<short> Ingredients;
+		bool HasAnywhere = false;
+		bool IsIndexable = true;
+		for (const auto & Slot : Recipe->m_Ingredients)
+		{
+			if (Slot.m_Item.m_ItemType <= 0)
+			{
+				// Would match a slot that the grid's key describes as empty
+				IsIndexable = false;
+			}
+			Ingredients.push_back(Slot.m_Item.m_ItemType);
+			if ((Slot.x < 0) || (Slot.y < 0))
+			{
+				HasAnywhere = true;
+				continue;
+			}
+			auto & Type = Shape[static_cast<size_t>(Slot.x + Slot.y * Recipe->m_Width)];
+			if (Type != -1)
+			{
+				// Two ingredients for a single slot
+				IsIndexable = false;
+			}
+			Type = Slot.m_Item.m_ItemType;
+		}
+
+		if (!IsIndexable)
+		{
+			m_UnindexedRecipes.push_back(i);
+		}
+		else if (HasAnywhere)
+		{
+			std::sort(Ingredients.begin(), Ingredients.end());
+			m_RecipesByIngredients[Ingredients].push_back(i);
+		}
+		else
+		{
+			Shape.insert(Shape.begin(), { static_cast<short>(Recipe->m_Width), static_cast<short>(Recipe->m_Height) });
+			m_RecipesByShape[Shape].push_back(i);
+		}
+	}
+}
+
+
+
+
+
+std::vector<size_t> cCraftingRecipes::GetCandidateRecipes(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride) const
+{
+	if ((a_GridWidth <= 0) || (a_GridHeight <= 0))
+	{
+		// An empty grid, no recipe fits in
+		return {};
+	}
+
+	// Describe the grid the same way as the recipes in the indices:
+	std::vector<short> Shape{ static_cast<short>(a_GridWidth), static_cast<short>(a_GridHeight) };
+	std::vector<short> Ingredients;
+	for (int y = 0; y < a_GridHeight; y++)
+	{
+		for (int x = 0; x < a_GridWidth; x++)
+		{
+			const cItem & Item = a_CraftingGrid[x + y * a_GridStride];
+			if (!Item.IsEmpty())
+			{
+				Shape.push_back(Item.m_ItemType);
+				Ingredients.push_back(Item.m_ItemType);
+				continue;
+			}
+			if (Item.m_ItemType > 0)
+			{
+				// An empty stack that still has a type, an "anywhere" ingredient would match it. Try all the recipes:
+				std::vector<size_t> Res;
+				Res.reserve(m_Recipes.size());
+				for (size_t i = 0; i < m_Recipes.size(); i++)
+				{
+					Res.push_back(i);
+				}
+				return Res;
+			}
+			Shape.push_back(-1);
+		}
+	}
+	std::sort(Ingredients.begin(), Ingredients.end());
+
+	std::vector<size_t> Res(m_UnindexedRecipes);
+	for (const auto & Index : { std::make_pair(&m_RecipesByShape, &Shape), std::make_pair(&m_RecipesByIngredients, &Ingredients) })
+	{
+		const auto itr = Index.first->find(*Index.second);
+		if (itr != Index.first->end())
+		{
+			Res.insert(Res.end(), itr->second.begin(), itr->second.end());
+		}
+	}
+
+	// Keep the order of m_Recipes, the first recipe that matches wins:
+	std::sort(Res.begin(), Res.end());
+	return Res;
 }
 
 
@@ -671,7 +788,7 @@ void cCraftingRecipes::NormalizeIngredients(cCraftingRecipes::cRecipe * a_Recipe
 
 
 
-cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipe(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight)
+cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipe(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, cRecipeCache * a_Cache)
 {
 	ASSERT(a_GridWidth <= MAX_GRID_WIDTH);
 	ASSERT(a_GridHeight <= MAX_GRID_HEIGHT);
@@ -694,7 +811,38 @@ cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipe(const cItem * a_Craftin
 
 	// Search in the possibly minimized grid, but keep the stride:
 	const cItem * Grid = a_CraftingGrid + GridLeft + (a_GridWidth * GridTop);
-	cRecipe * Recipe = FindRecipeCropped(Grid, GridWidth, GridHeight, a_GridWidth);
+	cRecipe * Recipe = nullptr;
+	if (a_Cache == nullptr)
+	{
+		Recipe = FindRecipeCropped(Grid, GridWidth, GridHeight, a_GridWidth);
+	}
+	else
+	{
+		// The ingredients all count one item, the match only depends on the type and damage and on which slots have any items:
+		std::vector<std::tuple<short, short, bool>> Items;
+		Items.reserve(static_cast<size_t>(a_GridWidth * a_GridHeight));
+		for (int i = 0; i < a_GridWidth * a_GridHeight; i++)
+		{
+			const cItem & Item = a_CraftingGrid[i];
+			Items.emplace_back(Item.m_ItemType, Item.m_ItemDamage, (Item.m_ItemCount > 0));
+		}
+
+		if ((a_Cache->m_GridWidth == a_GridWidth) && (a_Cache->m_Grid == Items))
+		{
+			// Same items as the last time, only the recipe found then may match. Match it again for the result's details:
+			if (a_Cache->m_RecipeIdx >= 0)
+			{
+				Recipe = MatchRecipe(Grid, GridWidth, GridHeight, a_GridWidth, m_Recipes[static_cast<size_t>(a_Cache->m_RecipeIdx)], a_Cache->m_OffsetX, a_Cache->m_OffsetY);
+				ASSERT(Recipe != nullptr);
+			}
+		}
+		else
+		{
+			a_Cache->m_Grid = std::move(Items);
+			a_Cache->m_GridWidth = a_GridWidth;
+			Recipe = FindRecipeCropped(Grid, GridWidth, GridHeight, a_GridWidth, a_Cache);
+		}
+	}
 	if (Recipe == nullptr)
 	{
 		return nullptr;
@@ -714,29 +862,42 @@ cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipe(const cItem * a_Craftin
 
 
 
-cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipeCropped(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride)
+cCraftingRecipes::cRecipe * cCraftingRecipes::FindRecipeCropped(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride, cRecipeCache * a_Cache)
 {
-	for (cRecipes::const_iterator itr = m_Recipes.begin(); itr != m_Recipes.end(); ++itr)
+	// Only try the recipes made of the same items as the grid, see IndexRecipes():
+	for (const auto RecipeIdx : GetCandidateRecipes(a_CraftingGrid, a_GridWidth, a_GridHeight, a_GridStride))
 	{
+		const cRecipe * Candidate = m_Recipes[RecipeIdx];
+
 		// Both the crafting grid and the recipes are normalized. The only variable possible is the "anywhere" items.
 		// This still means that the "anywhere" item may be the one that is offsetting the grid contents to the right or downwards, so we need to check all possible positions.
 		// E. g. recipe "A, * | B, 1:1 | ..." still needs to check grid for B at 2:2 (in case A was in grid's 1:1)
 		// Calculate the maximum offsets for this recipe relative to the grid size, and iterate through all combinations of offsets.
 		// Also, this calculation automatically filters out recipes that are too large for the current grid - the loop won't be entered at all.
 
-		int MaxOfsX = a_GridWidth  - (*itr)->m_Width;
-		int MaxOfsY = a_GridHeight - (*itr)->m_Height;
+		int MaxOfsX = a_GridWidth  - Candidate->m_Width;
+		int MaxOfsY = a_GridHeight - Candidate->m_Height;
 		for (int x = 0; x <= MaxOfsX; x++) for (int y = 0; y <= MaxOfsY; y++)
 		{
-			cRecipe * Recipe = MatchRecipe(a_CraftingGrid, a_GridWidth, a_GridHeight, a_GridStride, *itr, x, y);
+			cRecipe * Recipe = MatchRecipe(a_CraftingGrid, a_GridWidth, a_GridHeight, a_GridStride, Candidate, x, y);
 			if (Recipe != nullptr)
 			{
+				if (a_Cache != nullptr)
+				{
+					a_Cache->m_RecipeIdx = static_cast<int>(RecipeIdx);
+					a_Cache->m_OffsetX = x;
+					a_Cache->m_OffsetY = y;
+				}
 				return Recipe;
 			}
 		}  // for y, for x
-	}  // for itr - m_Recipes[]
+	}  // for RecipeIdx
 
 	// No matching recipe found
+	if (a_Cache != nullptr)
+	{
+		a_Cache->m_RecipeIdx = -1;
+	}
 	return nullptr;
 }
 
@@ -120,11 +120,33 @@ public:
 	static const int MAX_GRID_WIDTH  = 3;
 	static const int MAX_GRID_HEIGHT = 3;
 
+	/** The last recipe found for a crafting grid, kept by the grid's owner so that crafting repeatedly from the same
+	ingredients, such as shift-clicking the result, needn't search the recipes again. */
+	class cRecipeCache
+	{
+	private:
+
+		friend class cCraftingRecipes;
+
+		/** The type, damage and whether there are any items, of each slot of the grid the recipe was searched for. */
+		std::vector<std::tuple<short, short, bool>> m_Grid;
+
+		int m_GridWidth = 0;
+
+		/** The index of the recipe found in m_Recipes, or -1 if none matched. */
+		int m_RecipeIdx = -1;
+
+		/** The offsets the recipe matched at, within the cropped grid. */
+		int m_OffsetX = 0;
+		int m_OffsetY = 0;
+	} ;
+
 	cCraftingRecipes(void);
 	~cCraftingRecipes();
 
-	/** Returns the recipe for current crafting grid. Doesn't modify the grid. Clears a_Recipe if no recipe found. */
-	void GetRecipe(cPlayer & a_Player, cCraftingGrid & a_CraftingGrid, cCraftingRecipe & a_Recipe);
+	/** Returns the recipe for current crafting grid. Doesn't modify the grid. Clears a_Recipe if no recipe found.
+	If a_Cache is given, the recipe found for the same items the last time is reused. */
+	void GetRecipe(cPlayer & a_Player, cCraftingGrid & a_CraftingGrid, cCraftingRecipe & a_Recipe, cRecipeCache * a_Cache = nullptr);
 
 	/** Find recipes and returns the RecipeIds which contain the new item and all ingredients are in the known items */
 	std::vector<UInt32> FindNewRecipesForItem(const cItem & a_Item, const std::set<cItem, cItem::sItemCompare> & a_KnownItems);
@@ -159,11 +181,32 @@ protected:
 
 	typedef std::vector<cRecipe *> cRecipes;
 
+	/** Indices into m_Recipes, ascending, keyed by item types. */
+	typedef std::map<std::vector<short>, std::vector<size_t>> cRecipeIndex;
+
 	cRecipes m_Recipes;
 
+	/** The recipes without "anywhere" ingredients, keyed by their normalized shape: the width, the height and the
+	item type of each slot, row by row, -1 for the empty ones. A grid cropped the same way matches only these. */
+	cRecipeIndex m_RecipesByShape;
+
+	/** The recipes with "anywhere" ingredients, keyed by the sorted item types of all their ingredients. They are matched
+	against the grids whose items have the same types, in any shape. */
+	cRecipeIndex m_RecipesByIngredients;
+
+	/** The recipes the indices can't describe (two ingredients in one slot, or an empty ingredient), tried for every grid. */
+	std::vector<size_t> m_UnindexedRecipes;
+
 	void LoadRecipes(void);
 	void ClearRecipes(void);
 
+	/** Fills the indices from m_Recipes. */
+	void IndexRecipes(void);
+
+	/** Returns the indices of the recipes that may match the cropped grid, in the order of m_Recipes.
+	Returns all recipes for grids the indices can't describe. */
+	std::vector<size_t> GetCandidateRecipes(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride) const;
+
 	/** Parses the recipe line and adds it into m_Recipes. a_LineNum is used for diagnostic warnings only */
 	void AddRecipeLine(int a_LineNum, const AString & a_RecipeLine);
 
@@ -176,11 +219,12 @@ protected:
 	/** Moves the recipe to top-left corner, sets its MinWidth / MinHeight */
 	void NormalizeIngredients(cRecipe * a_Recipe);
 
-	/** Finds a recipe matching the crafting grid. Returns a newly allocated recipe (with all its coords set) or nullptr if not found. Caller must delete return value! */
-	cRecipe * FindRecipe(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight);
+	/** Finds a recipe matching the crafting grid. Returns a newly allocated recipe (with all its coords set) or nullptr if not found. Caller must delete return value!
+	If a_Cache is given and was filled for the same items, its recipe is used without searching; otherwise it is filled with the recipe found. */
+	cRecipe * FindRecipe(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, cRecipeCache * a_Cache = nullptr);
 
-	/** Same as FindRecipe, but the grid is guaranteed to be of minimal dimensions needed */
-	cRecipe * FindRecipeCropped(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride);
+	/** Same as FindRecipe, but the grid is guaranteed to be of minimal dimensions needed. If a_Cache is given, the recipe found is stored in it. */
+	cRecipe * FindRecipeCropped(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride, cRecipeCache * a_Cache = nullptr);
 
 	/** Checks if the grid matches the specified recipe, offset by the specified offsets. Returns a matched cRecipe * if so, or nullptr if not matching. Caller must delete the return value! */
 	cRecipe * MatchRecipe(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight, int a_GridStride, const cRecipe * a_Recipe, int a_OffsetX, int a_OffsetY);
@@ -2,6 +2,7 @@
 #include "Globals.h"  // NOTE: MSVC stupidness requires this to be the same across all modules
 
 #include "Entity.h"
+#include "EntityTracker.h"
 #include "Player.h"
 #include "../BlockInfo.h"
 #include "../World.h"
@@ -1965,50 +1966,65 @@ void cEntity::TeleportToCoords(double a_PosX, double a_PosY, double a_PosZ)
 
 void cEntity::BroadcastMovementUpdate(const cClientHandle * a_Exclude)
 {
-	// Process packet sending every two ticks:
-	if ((GetWorld()->GetWorldTickAge() % 2_tick) != 0_tick)
+	// Process packet sending only in the ticks given by the entity class' update interval:
+	const auto Params = cEntityTracker::GetParams(*this);
+	if (!cEntityTracker::ShouldUpdate(*this, Params))
 	{
 		return;
 	}
 
-	if (m_Speed.HasNonZeroLength())
-	{
-		// Movin'
-		m_World->BroadcastEntityVelocity(*this, a_Exclude);
-		m_bHasSentNoSpeed = false;
-	}
-	else if (!m_bHasSentNoSpeed)
-	{
-		// Speed is zero, send this to clients once only as well as an absolute position
-		m_World->BroadcastEntityVelocity(*this, a_Exclude);
-		m_World->BroadcastEntityPosition(*this, a_Exclude);
-		m_LastSentPosition = GetPosition();
-		m_bDirtyOrientation = false;
-		m_bHasSentNoSpeed = true;
-	}
+	// When the speed drops to zero, it is sent once only, together with an absolute position:
+	const bool IsMoving = m_Speed.HasNonZeroLength();
+	const bool SendVelocity = IsMoving || !m_bHasSentNoSpeed;
+	const bool SendPosition = (!IsMoving && !m_bHasSentNoSpeed) || (m_Position - m_LastSentPosition).HasNonZeroLength();
+	const bool IsResync = SendPosition && cEntityTracker::ShouldResync(*this, Params);
 
-	if ((m_Position - m_LastSentPosition).HasNonZeroLength())  // Have we moved?
-	{
-		m_World->BroadcastEntityPosition(*this, a_Exclude);
+	// The look is sent along with the relative move, individually only if there's no move:
+	const bool SendHead = m_bDirtyHead;
+	const bool SendLook = m_bDirtyOrientation && !SendPosition;
 
-		// Clients seem to store two positions, one for the velocity packet and one for the teleport / relmove packet
-		// The latter is only changed with a relmove / teleport, and m_LastSentPosition stores this position
-		m_LastSentPosition = GetPosition();
-		m_bDirtyOrientation = false;
-	}
-
-	if (m_bDirtyHead)
+	cEntityTracker::ForEachViewer(*this, Params, a_Exclude, [&](cClientHandle & a_Client, const bool a_IsNewViewer)
 	{
-		m_World->BroadcastEntityHeadLook(*this, a_Exclude);
-		m_bDirtyHead = false;
-	}
+		if (a_IsNewViewer)
+		{
+			// The client has missed some of the relative moves (or all of them), give it the full state:
+			a_Client.SendEntityTeleport(*this);
+			a_Client.SendEntityVelocity(*this);
+			a_Client.SendEntityHeadLook(*this);
+			return;
+		}
 
-	if (m_bDirtyOrientation)
+		if (SendVelocity)
+		{
+			a_Client.SendEntityVelocity(*this);
+		}
+		if (IsResync)
+		{
+			a_Client.SendEntityTeleport(*this);
+		}
+		else if (SendPosition)
+		{
+			a_Client.SendEntityPosition(*this);
+		}
+		if (SendHead)
+		{
+			a_Client.SendEntityHeadLook(*this);
+		}
+		if (SendLook)
+		{
+			a_Client.SendEntityLook(*this);
+		}
+	});
+
+	// Clients seem to store two positions, one for the velocity packet and one for the teleport / relmove packet
+	// The latter is only changed with a relmove / teleport, and m_LastSentPosition stores this position
+	if (SendPosition)
 	{
-		// Send individual update in case above (sending with rel-move packet) wasn't done
-		GetWorld()->BroadcastEntityLook(*this, a_Exclude);
-		m_bDirtyOrientation = false;
+		m_LastSentPosition = GetPosition();
 	}
+	m_bHasSentNoSpeed = !IsMoving;
+	m_bDirtyHead = false;
+	m_bDirtyOrientation = false;
 }
 
 
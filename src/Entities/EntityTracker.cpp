@@ -0,0 +1,165 @@
+
+// EntityTracker.cpp
+
+// Implements the cEntityTracker class deciding which clients receive an entity's movement updates, and how often
+
+#include "Globals.h"
+#include "EntityTracker.h"
+#include "Player.h"
+#include "ProjectileEntity.h"
+#include "../Chunk.h"
+#include "../ClientHandle.h"
+#include "../World.h"
+#include "../Mobs/Monster.h"
+
+
+
+
+
+cEntityTracker::sParams cEntityTracker::GetParams(const cEntity & a_Entity)
+{
+	const auto EntityType = a_Entity.GetEntityType();
+	const auto MobType = (EntityType == cEntity::etMonster) ? static_cast<const cMonster &>(a_Entity).GetMobType() : mtInvalidType;
+	const bool IsArrow = (
+		(EntityType == cEntity::etProjectile) &&
+		(static_cast<const cProjectileEntity &>(a_Entity).GetProjectileKind() == cProjectileEntity::pkArrow)
+	);
+	return GetParams(EntityType, MobType, IsArrow);
+}
+
+
+
+
+
+cEntityTracker::sParams cEntityTracker::GetParams(const cEntity::eEntityType a_EntityType, const eMonsterType a_MobType, const bool a_IsArrow)
+{
+	// The values are those of the vanilla server:
+	switch (a_EntityType)
+	{
+		case cEntity::etPlayer:       return { 512, 2 };
+		case cEntity::etPickup:       return { 64, 20 };
+		case cEntity::etExpOrb:       return { 160, 20 };
+		case cEntity::etFallingBlock: return { 160, 20 };
+		case cEntity::etTNT:          return { 160, 10 };
+		case cEntity::etMinecart:     return { 80, 3 };
+		case cEntity::etBoat:         return { 80, 3 };
+		case cEntity::etFloater:      return { 64, 5 };
+		case cEntity::etEntity:       return { 80, 3 };
+
+		// These never move on their own:
+		case cEntity::etEnderCrystal:
+		case cEntity::etItemFrame:
+		case cEntity::etPainting:
+		case cEntity::etLeashKnot:
+		{
+			return { 160, 0 };
+		}
+
+		case cEntity::etProjectile:
+		{
+			// Arrows fly along a predictable path, the client simulates it well:
+			return { 64, a_IsArrow ? 20 : 10 };
+		}
+
+		case cEntity::etMonster:
+		{
+			switch (a_MobType)
+			{
+				case mtEnderDragon: return { 160, 3 };
+				case mtSquid:       return { 64, 3 };
+				default:            return { 80, 3 };
+			}
+		}
+	}
+	UNREACHABLE("Unsupported entity type");
+}
+
+
+
+
+
+bool cEntityTracker::IsInRange(const Vector3d a_ViewerPos, const Vector3d a_EntityPos, const sParams & a_Params)
+{
+	const auto Distance = a_ViewerPos - a_EntityPos;
+	return (
+		(std::abs(Distance.x) <= a_Params.m_Range) &&
+		(std::abs(Distance.y) <= a_Params.m_Range) &&
+		(std::abs(Distance.z) <= a_Params.m_Range)
+	);
+}
+
+
+
+
+
+bool cEntityTracker::ShouldUpdate(const cEntity & a_Entity, const sParams & a_Params)
+{
+	return ShouldUpdate(a_Entity.GetWorld()->GetWorldTickAge(), a_Entity.GetUniqueID(), a_Params);
+}
+
+
+
+
+
+bool cEntityTracker::ShouldUpdate(const cTickTimeLong a_WorldAge, const UInt32 a_EntityID, const sParams & a_Params)
+{
+	if (a_Params.m_UpdateInterval <= 0)
+	{
+		return false;
+	}
+	const auto Phase = a_WorldAge.count() + a_EntityID;
+	return ((Phase % a_Params.m_UpdateInterval) == 0);
+}
+
+
+
+
+
+bool cEntityTracker::ShouldResync(const cEntity & a_Entity, const sParams & a_Params)
+{
+	return ShouldResync(a_Entity.GetWorld()->GetWorldTickAge(), a_Entity.GetUniqueID(), a_Params);
+}
+
+
+
+
+
+bool cEntityTracker::ShouldResync(const cTickTimeLong a_WorldAge, const UInt32 a_EntityID, const sParams & a_Params)
+{
+	// Exactly one update tick falls into each window of m_UpdateInterval ticks at the start of a resync period:
+	const auto Phase = a_WorldAge.count() + a_EntityID;
+	return ((Phase % RESYNC_INTERVAL) < a_Params.m_UpdateInterval);
+}
+
+
+
+
+
+void cEntityTracker::ForEachViewer(cEntity & a_Entity, const sParams & a_Params, const cClientHandle * a_Exclude, cFunctionRef<void(cClientHandle &, bool)> a_Callback)
+{
+	cWorld::cLock Lock(*a_Entity.GetWorld());  // Lock world before accessing the chunk
+	auto Chunk = a_Entity.GetParentChunk();
+	if (Chunk == nullptr)
+	{
+		// Not ticked yet, the clients will get the entity spawned at its current position:
+		return;
+	}
+
+	const auto Position = a_Entity.GetPosition();
+	const auto EntityID = a_Entity.GetUniqueID();
+	for (auto * Client : Chunk->GetAllClients())
+	{
+		const auto Player = Client->GetPlayer();
+		if ((Client == a_Exclude) || (Player == nullptr))
+		{
+			continue;
+		}
+
+		if (!IsInRange(Player->GetPosition(), Position, a_Params))
+		{
+			Client->StopTrackingEntity(EntityID);
+			continue;
+		}
+		a_Callback(*Client, Client->StartTrackingEntity(EntityID));
+	}
+}
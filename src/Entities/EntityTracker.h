@@ -0,0 +1,82 @@
+
+// EntityTracker.h
+
+// Declares the cEntityTracker class deciding which clients receive an entity's movement updates, and how often
+
+/*
+All the clients that have an entity's chunk loaded have the entity spawned, same as before. The tracker only limits
+the movement updates (velocity, relative move, look), following the vanilla entity tracker:
+	- each entity class has an update interval; hanging entities and the like never move on their own and get none,
+	pickups and orbs are updated once a second, mobs every 3 ticks and players every 2 ticks;
+	- each entity class has a tracking range; clients further away on any axis don't receive its movement updates;
+	- each client keeps the set of the entities it is kept up to date with. The relative moves only make sense to
+	clients that received all the previous ones, so a client that gets (back) into range is first sent the absolute
+	position (and removed from the set once it gets out of range or the entity is destroyed for it);
+	- every RESYNC_INTERVAL ticks, the absolute position is sent instead of the relative move, to counter any drift
+	in the client's accumulated position.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Entity.h"
+#include "../FunctionRef.h"
+#include "../Mobs/MonsterTypes.h"
+
+
+
+
+
+class cClientHandle;
+
+
+
+
+
+class cEntityTracker
+{
+public:
+
+	/** How the movement of a class of entities is broadcast. */
+	struct sParams
+	{
+		/** The distance along any axis, in blocks, beyond which the clients don't receive the entity's movement updates. */
+		int m_Range;
+
+		/** Number of ticks between two movement updates; 0 for entities that don't move on their own. */
+		int m_UpdateInterval;
+	};
+
+	/** Number of ticks between two absolute position updates of a moving entity. */
+	static const int RESYNC_INTERVAL = 400;
+
+	/** Returns the tracking parameters of the entity's class. */
+	static sParams GetParams(const cEntity & a_Entity);
+
+	/** Returns the tracking parameters of an entity of the specified class.
+	a_MobType is only used for monsters, a_IsArrow only for projectiles. */
+	static sParams GetParams(cEntity::eEntityType a_EntityType, eMonsterType a_MobType, bool a_IsArrow);
+
+	/** Returns true if a client whose player is at a_ViewerPos receives the movement updates of an entity at a_EntityPos.
+	Same as the vanilla tracker, the range is checked on each axis, including the vertical one. */
+	static bool IsInRange(Vector3d a_ViewerPos, Vector3d a_EntityPos, const sParams & a_Params);
+
+	/** Returns true if the entity's movement is to be broadcast in the current tick.
+	The updates of the entities with the same interval are spread over the ticks by their IDs. */
+	static bool ShouldUpdate(const cEntity & a_Entity, const sParams & a_Params);
+	static bool ShouldUpdate(cTickTimeLong a_WorldAge, UInt32 a_EntityID, const sParams & a_Params);
+
+	/** Returns true if the current movement update should carry the absolute position, to counter the drift.
+	Only valid in the ticks when ShouldUpdate() returns true. */
+	static bool ShouldResync(const cEntity & a_Entity, const sParams & a_Params);
+	static bool ShouldResync(cTickTimeLong a_WorldAge, UInt32 a_EntityID, const sParams & a_Params);
+
+	/** Calls a_Callback for each client that has the entity's chunk loaded and is within the tracking range, except a_Exclude.
+	The second parameter of the callback is true if the client has just started tracking the entity, and therefore needs
+	its absolute position. Clients that got out of range stop tracking the entity.
+	Must be called from the entity's world tick thread. */
+	static void ForEachViewer(cEntity & a_Entity, const sParams & a_Params, const cClientHandle * a_Exclude, cFunctionRef<void(cClientHandle &, bool)> a_Callback);
+};
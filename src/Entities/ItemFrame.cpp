@@ -113,7 +113,7 @@ void cItemFrame::SpawnOn(cClientHandle & a_ClientHandle)
 		cMap * Map = GetWorld()->GetMapManager().GetMapData(static_cast<unsigned>(m_Item.m_ItemDamage));
 		if (Map != nullptr)
 		{
-			a_ClientHandle.SendMapData(*Map, 0, 0);
+			a_ClientHandle.SendMapData(*Map, 0, 0, static_cast<int>(Map->GetWidth()), static_cast<int>(Map->GetHeight()));
 		}
 	}
 }
@@ -104,21 +104,14 @@ void cPawn::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
 	}
 	HandleFalling();
 
-	// Handle item pickup
-	if (m_Health > 0)
+	// Handle item pickup; players collect theirs in one batch per chunk, in cChunk::CollectItemEntitiesByPlayers():
+	if ((m_Health > 0) && IsMob())
 	{
-		if (IsPlayer())
+		cMonster & Mob = static_cast<cMonster &>(*this);
+		if (Mob.CanPickUpLoot())
 		{
 			m_World->CollectPickupsByEntity(*this);
 		}
-		else if (IsMob())
-		{
-			cMonster & Mob = static_cast<cMonster &>(*this);
-			if (Mob.CanPickUpLoot())
-			{
-				m_World->CollectPickupsByEntity(*this);
-			}
-		}
 	}
 }
 
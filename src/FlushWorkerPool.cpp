@@ -0,0 +1,158 @@
+// FlushWorkerPool.cpp
+
+// Implements the cFlushWorkerPool class representing the threads that compress, encrypt and send the clients' outgoing data
+
+#include "Globals.h"
+#include "FlushWorkerPool.h"
+#include "ClientHandle.h"
+#include "Profiler.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cFlushWorkerPool:
+
+cFlushWorkerPool::cFlushWorkerPool(void)
+{
+}
+
+
+
+
+
+cFlushWorkerPool::~cFlushWorkerPool()
+{
+	Stop();
+}
+
+
+
+
+
+void cFlushWorkerPool::Start(unsigned a_NumWorkers)
+{
+	cCSLock Lock(m_CS);
+	ASSERT(m_Workers.empty());  // Already started?
+
+	for (unsigned i = 0; i < a_NumWorkers; i++)
+	{
+		m_Workers.push_back(std::make_unique<cWorker>(i + 1));
+		m_Workers.back()->Start();
+	}
+}
+
+
+
+
+
+void cFlushWorkerPool::Stop(void)
+{
+	cCSLock Lock(m_CS);
+	for (auto & Worker : m_Workers)
+	{
+		Worker->Stop();
+	}
+	m_Workers.clear();
+}
+
+
+
+
+
+void cFlushWorkerPool::QueueFlush(std::shared_ptr<cClientHandle> a_Client)
+{
+	{
+		cCSLock Lock(m_CS);
+		if (!m_Workers.empty())
+		{
+			// Always use the same worker for the same client, so that its data is sent in order:
+			auto Index = static_cast<size_t>(a_Client->GetUniqueID()) % m_Workers.size();
+			m_Workers[Index]->QueueFlush(std::move(a_Client));
+			return;
+		}
+	}
+
+	// No workers, flush right here:
+	a_Client->FlushOutgoingData();
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cFlushWorkerPool::cWorker:
+
+cFlushWorkerPool::cWorker::cWorker(unsigned a_Index):
+	Super(fmt::format(FMT_STRING("Flush Worker {}"), a_Index)),
+	m_Name(fmt::format(FMT_STRING("Flush Worker {}"), a_Index))
+{
+}
+
+
+
+
+
+cFlushWorkerPool::cWorker::~cWorker()
+{
+	Stop();
+}
+
+
+
+
+
+void cFlushWorkerPool::cWorker::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_Event.Set();
+	Super::Stop();
+}
+
+
+
+
+
+void cFlushWorkerPool::cWorker::QueueFlush(std::shared_ptr<cClientHandle> a_Client)
+{
+	{
+		cCSLock Lock(m_CS);
+		m_Clients.push_back(std::move(a_Client));
+	}
+	m_Event.Set();
+}
+
+
+
+
+
+void cFlushWorkerPool::cWorker::Execute(void)
+{
+	cProfiler::SetCurrentThreadName(m_Name);
+
+	std::vector<std::shared_ptr<cClientHandle>> Clients;
+	for (;;)
+	{
+		m_Event.Wait();
+
+		{
+			cCSLock Lock(m_CS);
+			std::swap(Clients, m_Clients);
+		}
+
+		for (const auto & Client : Clients)
+		{
+			cProfileScope Profile("cClientHandle::FlushOutgoingData");
+			Client->FlushOutgoingData();
+		}
+		Clients.clear();
+
+		// Terminate only after flushing what was queued, so that no data is lost:
+		if (m_ShouldTerminate)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+// FlushWorkerPool.h
+
+// Declares the cFlushWorkerPool class representing the threads that compress, encrypt and send the clients' outgoing data
+
+/*
+The threads that produce packets (mostly the world tick threads) only append uncompressed packets to the client's
+outgoing queue (cClientHandle::SendUncompressedPacket()) and then ask the pool to flush the client (QueueFlush()).
+Each client is always flushed by the same worker, chosen by its unique ID, so the data of a single connection is
+compressed, encrypted and sent in order, while the connections are spread across the workers.
+With no workers (or once stopped), the pool flushes the client right away on the calling thread.
+*/
+
+
+
+
+
+#pragma once
+
+#include "OSSupport/IsThread.h"
+
+
+
+
+
+class cClientHandle;
+
+
+
+
+
+class cFlushWorkerPool
+{
+public:
+
+	cFlushWorkerPool(void);
+	~cFlushWorkerPool();
+
+	/** Starts the specified number of worker threads. */
+	void Start(unsigned a_NumWorkers);
+
+	/** Stops all the worker threads. Any further flushes are done on the calling thread. */
+	void Stop(void);
+
+	/** Schedules the client's outgoing data to be flushed by the worker owning the client. */
+	void QueueFlush(std::shared_ptr<cClientHandle> a_Client);
+
+private:
+
+	/** A single worker thread, flushing the clients queued to it one after another. */
+	class cWorker:
+		public cIsThread
+	{
+		using Super = cIsThread;
+
+	public:
+
+		cWorker(unsigned a_Index);
+		virtual ~cWorker() override;
+
+		/** Signals the thread to terminate and waits for it to finish. */
+		void Stop(void);
+
+		/** Adds the client into the queue of clients to flush. */
+		void QueueFlush(std::shared_ptr<cClientHandle> a_Client);
+
+	protected:
+
+		// cIsThread override:
+		virtual void Execute(void) override;
+
+	private:
+
+		/** The name of the thread used in the profiler. */
+		AString m_Name;
+
+		/** Protects m_Clients. */
+		cCriticalSection m_CS;
+
+		/** The clients waiting to be flushed, in the order of the requests. */
+		std::vector<std::shared_ptr<cClientHandle>> m_Clients;
+
+		/** Set when a client is queued, or when the thread is to terminate. */
+		cEvent m_Event;
+	};
+
+	/** Protects m_Workers against being stopped while in use. */
+	cCriticalSection m_CS;
+
+	std::vector<std::unique_ptr<cWorker>> m_Workers;
+};
@@ -0,0 +1,462 @@
+
+// HTTPClientConnection.cpp
+
+// Implements the cHTTPClientConnection class representing a persistent (keep-alive) HTTP(S) client connection to a single server
+
+#include "Globals.h"
+#include "HTTPClientConnection.h"
+#include "HTTPMessageParser.h"
+#include "UrlParser.h"
+
+
+
+
+
+/** A single TCP connection to the server.
+Receives the network callbacks in the network thread and hands the response over to the thread waiting for it.
+Shared by the cHTTPClientConnection and the cTCPLink, so that the callbacks can outlive a closed connection. */
+class cHTTPClientConnection::cLink:
+	public cNetwork::cConnectCallbacks,
+	public cTCPLink::cCallbacks,
+	protected cHTTPMessageParser::cCallbacks
+{
+public:
+
+	cLink(bool a_IsTls):
+		m_IsTls(a_IsTls),
+		m_Parser(*this),
+		m_IsReady(false),
+		m_IsClosed(false),
+		m_HasResponseData(false),
+		m_IsResponseFinished(false),
+		m_ShouldClose(false),
+		m_StatusCode(0)
+	{
+	}
+
+
+	/** Waits until the link is ready for sending requests, or closed, or the deadline passes.
+	Returns true if the link is ready. */
+	bool WaitReady(std::chrono::steady_clock::time_point a_Deadline)
+	{
+		WaitFor(a_Deadline, [this]() { return m_IsReady || m_IsClosed; });
+		cCSLock Lock(m_CS);
+		return m_IsReady && !m_IsClosed;
+	}
+
+
+	/** Sends the request over the link, after resetting the response state.
+	Returns false if the link is already known to be closed. */
+	bool SendRequest(const AString & a_Request)
+	{
+		cTCPLinkPtr Link;
+		{
+			cCSLock Lock(m_CS);
+			if (m_IsClosed || (m_TCPLink == nullptr))
+			{
+				return false;
+			}
+			m_Parser.Reset();
+			m_HasResponseData = false;
+			m_IsResponseFinished = false;
+			m_ShouldClose = false;
+			m_StatusCode = 0;
+			m_Body.clear();
+			Link = m_TCPLink;
+		}
+
+		// Send outside the lock, the TLS layer may call back into us from within:
+		return Link->Send(a_Request);
+	}
+
+
+	/** Waits for the response to the last request sent, at most until the deadline. */
+	sResponse WaitResponse(std::chrono::steady_clock::time_point a_Deadline, bool & a_IsStale)
+	{
+		a_IsStale = false;
+		WaitFor(a_Deadline, [this]() { return m_IsResponseFinished || m_IsClosed; });
+
+		cCSLock Lock(m_CS);
+		sResponse Response;
+		if (m_IsResponseFinished)
+		{
+			Response.m_IsSuccessful = true;
+			Response.m_StatusCode = m_StatusCode;
+			Response.m_Body = std::move(m_Body);
+			return Response;
+		}
+		if (m_IsClosed)
+		{
+			// If the server closed the connection before sending anything, it was most likely closing the idle connection:
+			a_IsStale = !m_HasResponseData;
+			Response.m_Body = m_Error.empty() ? "Connection closed by the server" : m_Error;
+			return Response;
+		}
+		Response.m_Body = "Timeout";
+		return Response;
+	}
+
+
+	/** Returns true if the server asked to close the connection after the last response. */
+	bool ShouldClose(void)
+	{
+		cCSLock Lock(m_CS);
+		return m_ShouldClose || m_IsClosed;
+	}
+
+
+	/** Drops the underlying TCP connection, if still open. */
+	void Close(void)
+	{
+		cTCPLinkPtr Link;
+		{
+			cCSLock Lock(m_CS);
+			m_IsClosed = true;
+			std::swap(Link, m_TCPLink);
+		}
+		if (Link != nullptr)
+		{
+			Link->Close();
+		}
+	}
+
+protected:
+
+	/** If true, the TLS handshake is done right after connecting. */
+	bool m_IsTls;
+
+	/** Protects all the members below against concurrent access by the network thread and the requesting thread. */
+	cCriticalSection m_CS;
+
+	/** Signalled whenever the state changes (ready, closed, response finished). */
+	cEvent m_StateChanged;
+
+	/** The TCP connection, nullptr before connecting and after closing. */
+	cTCPLinkPtr m_TCPLink;
+
+	/** Parser of the responses. */
+	cHTTPMessageParser m_Parser;
+
+	/** Set once the connection (and the TLS handshake, if used) is done. */
+	bool m_IsReady;
+
+	/** Set once the connection is closed, by either side, or fails. */
+	bool m_IsClosed;
+
+	/** Set once any data of the response to the current request is received. */
+	bool m_HasResponseData;
+
+	/** Set once the response to the current request is complete. */
+	bool m_IsResponseFinished;
+
+	/** Set if the server sent the "Connection: close" header in the current response. */
+	bool m_ShouldClose;
+
+	/** The status code of the current response. */
+	int m_StatusCode;
+
+	/** The body of the current response received so far. */
+	AString m_Body;
+
+	/** Description of the error that closed the connection. */
+	AString m_Error;
+
+
+	/** Waits until a_Predicate returns true, evaluated with m_CS held, or until the deadline passes. */
+	template <typename Predicate>
+	void WaitFor(std::chrono::steady_clock::time_point a_Deadline, Predicate a_Predicate)
+	{
+		for (;;)
+		{
+			{
+				cCSLock Lock(m_CS);
+				if (a_Predicate())
+				{
+					return;
+				}
+			}
+			const auto Remaining = std::chrono::duration_cast<std::chrono::milliseconds>(a_Deadline - std::chrono::steady_clock::now());
+			if (Remaining.count() <= 0)
+			{
+				return;
+			}
+			m_StateChanged.Wait(static_cast<unsigned>(Remaining.count()) + 1);
+		}
+	}
+
+
+	/** Marks the connection as closed, with the specified error, and wakes up the waiting thread. */
+	void SetClosed(const AString & a_Error)
+	{
+		{
+			cCSLock Lock(m_CS);
+			m_IsClosed = true;
+			m_TCPLink.reset();
+			if (m_Error.empty())
+			{
+				m_Error = a_Error;
+			}
+		}
+		m_StateChanged.Set();
+	}
+
+
+	/** Marks the connection as ready for sending requests and wakes up the waiting thread. */
+	void SetReady(void)
+	{
+		{
+			cCSLock Lock(m_CS);
+			m_IsReady = true;
+		}
+		m_StateChanged.Set();
+	}
+
+
+	// cNetwork::cConnectCallbacks overrides:
+	virtual void OnConnected(cTCPLink & a_Link) override
+	{
+		{
+			cCSLock Lock(m_CS);
+			if (m_IsClosed)
+			{
+				// The requesting thread has given up waiting in the meantime:
+				a_Link.Close();
+				return;
+			}
+		}
+		if (!m_IsTls)
+		{
+			SetReady();
+			return;
+		}
+		auto Error = a_Link.StartTLSClient(nullptr, nullptr, nullptr);
+		if (!Error.empty())
+		{
+			SetClosed(fmt::format(FMT_STRING("Cannot start TLS: {}"), Error));
+			a_Link.Close();
+		}
+	}
+
+
+	// cNetwork::cConnectCallbacks and cTCPLink::cCallbacks override:
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		SetClosed(fmt::format(FMT_STRING("Network error {} ({})"), a_ErrorCode, a_ErrorMsg));
+	}
+
+
+	// cTCPLink::cCallbacks overrides:
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		cCSLock Lock(m_CS);
+		if (!m_IsClosed)
+		{
+			m_TCPLink = std::move(a_Link);
+		}
+	}
+
+
+	virtual void OnTlsHandshakeCompleted(void) override
+	{
+		SetReady();
+	}
+
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Length) override
+	{
+		bool IsFinished;
+		{
+			cCSLock Lock(m_CS);
+			m_HasResponseData = true;
+			if (m_Parser.Parse(a_Data, a_Length) == AString::npos)
+			{
+				m_IsClosed = true;
+			}
+			IsFinished = m_IsResponseFinished || m_IsClosed;
+		}
+		if (IsFinished)
+		{
+			m_StateChanged.Set();
+		}
+	}
+
+
+	virtual void OnRemoteClosed(void) override
+	{
+		SetClosed("Connection closed by the server");
+	}
+
+
+	// cHTTPMessageParser::cCallbacks overrides, called with m_CS held from OnReceivedData():
+	virtual void OnError(const AString & a_ErrorDescription) override
+	{
+		m_IsClosed = true;
+		m_Error = fmt::format(FMT_STRING("Failed to parse the HTTP response: {}"), a_ErrorDescription);
+	}
+
+
+	virtual void OnFirstLine(const AString & a_FirstLine) override
+	{
+		// "HTTP/1.1 200 OK"
+		auto Split = StringSplit(a_FirstLine, " ");
+		if ((Split.size() < 2) || !StringToInteger(Split[1], m_StatusCode))
+		{
+			OnError(fmt::format(FMT_STRING("Invalid status line \"{}\""), a_FirstLine));
+		}
+	}
+
+
+	virtual void OnHeaderLine(const AString & a_Key, const AString & a_Value) override
+	{
+		if ((NoCaseCompare(a_Key, "Connection") == 0) && (NoCaseCompare(a_Value, "close") == 0))
+		{
+			m_ShouldClose = true;
+		}
+	}
+
+
+	virtual void OnHeadersFinished(void) override
+	{
+	}
+
+
+	virtual void OnBodyData(const void * a_Data, size_t a_Size) override
+	{
+		m_Body.append(static_cast<const char *>(a_Data), a_Size);
+	}
+
+
+	virtual void OnBodyFinished(void) override
+	{
+		m_IsResponseFinished = true;
+	}
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cHTTPClientConnection:
+
+cHTTPClientConnection::cHTTPClientConnection(const AString & a_ServerUrl):
+	m_Port(0),
+	m_IsTls(false),
+	m_IsValid(false),
+	m_NumConnectionsOpened(0)
+{
+	AString Username, Password, Path, Query, Fragment;
+	if (!cUrlParser::Parse(a_ServerUrl, m_Scheme, Username, Password, m_Host, m_Port, Path, Query, Fragment).first)
+	{
+		return;
+	}
+	m_Scheme = StrToLower(m_Scheme);
+	m_IsTls = (m_Scheme == "https");
+	m_IsValid = (m_IsTls || (m_Scheme == "http"));
+}
+
+
+
+
+
+cHTTPClientConnection::~cHTTPClientConnection()
+{
+	if (m_Link != nullptr)
+	{
+		m_Link->Close();
+	}
+}
+
+
+
+
+
+cHTTPClientConnection::sResponse cHTTPClientConnection::Get(const AString & a_PathAndQuery, std::chrono::milliseconds a_Timeout)
+{
+	if (!m_IsValid)
+	{
+		return { false, 0, "Invalid server URL" };
+	}
+	const auto Deadline = std::chrono::steady_clock::now() + a_Timeout;
+
+	// Try the connection kept from the previous request first:
+	if (m_Link != nullptr)
+	{
+		bool IsStale;
+		auto Response = DoRequest(*m_Link, a_PathAndQuery, Deadline, IsStale);
+		if (!IsStale)
+		{
+			if (!Response.m_IsSuccessful || m_Link->ShouldClose())
+			{
+				m_Link->Close();
+				m_Link.reset();
+			}
+			return Response;
+		}
+
+		// The server has closed the idle connection in the meantime, resend over a new one:
+		m_Link->Close();
+		m_Link.reset();
+	}
+
+	m_Link = Connect(Deadline);
+	if (m_Link == nullptr)
+	{
+		return { false, 0, fmt::format(FMT_STRING("Cannot connect to {}:{}"), m_Host, m_Port) };
+	}
+	bool IsStale;
+	auto Response = DoRequest(*m_Link, a_PathAndQuery, Deadline, IsStale);
+	if (!Response.m_IsSuccessful || m_Link->ShouldClose())
+	{
+		m_Link->Close();
+		m_Link.reset();
+	}
+	return Response;
+}
+
+
+
+
+
+cHTTPClientConnection::sResponse cHTTPClientConnection::DoRequest(
+	cLink & a_Link,
+	const AString & a_PathAndQuery,
+	std::chrono::steady_clock::time_point a_Deadline,
+	bool & a_IsStale
+)
+{
+	auto Request = fmt::format(
+		FMT_STRING("GET {} HTTP/1.1\r\nHost: {}\r\nConnection: keep-alive\r\n\r\n"),
+		a_PathAndQuery.empty() ? "/" : a_PathAndQuery, m_Host
+	);
+	if (!a_Link.SendRequest(Request))
+	{
+		a_IsStale = true;
+		return { false, 0, "Connection closed by the server" };
+	}
+	return a_Link.WaitResponse(a_Deadline, a_IsStale);
+}
+
+
+
+
+
+std::shared_ptr<cHTTPClientConnection::cLink> cHTTPClientConnection::Connect(std::chrono::steady_clock::time_point a_Deadline)
+{
+	auto Link = std::make_shared<cLink>(m_IsTls);
+	if (!cNetwork::Connect(m_Host, m_Port, Link, Link))
+	{
+		return nullptr;
+	}
+	m_NumConnectionsOpened += 1;
+	if (!Link->WaitReady(a_Deadline))
+	{
+		Link->Close();
+		return nullptr;
+	}
+	return Link;
+}
+
+
+
+
@@ -0,0 +1,90 @@
+
+// HTTPClientConnection.h
+
+// Declares the cHTTPClientConnection class representing a persistent (keep-alive) HTTP(S) client connection to a single server
+
+/*
+cUrlClient opens a new TCP connection (and for https, does a full TLS handshake) for each request, and closes it
+after the response. That is fine for the occasional request, but wasteful for a stream of requests to the same
+server, such as the session server checks of players logging in.
+This class keeps the connection open between requests and sends the next request over it. When the server closes
+the connection (or it breaks in any other way), the next request transparently opens a new one.
+The requests are blocking, with a timeout; one object serves one request at a time, users wanting more concurrent
+requests use more objects.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../OSSupport/Network.h"
+
+
+
+
+
+class cHTTPClientConnection
+{
+public:
+
+	/** The result of a single request. */
+	struct sResponse
+	{
+		/** True if a complete response was received, regardless of its status code. */
+		bool m_IsSuccessful = false;
+
+		/** The HTTP status code of the response, 0 if none was received. */
+		int m_StatusCode = 0;
+
+		/** The response body, or the error description if m_IsSuccessful is false. */
+		AString m_Body;
+	};
+
+	/** Creates a connection object for the server specified by the URL's scheme, host and port.
+	The rest of the URL is ignored. No connection is made until the first request. */
+	explicit cHTTPClientConnection(const AString & a_ServerUrl);
+
+	~cHTTPClientConnection();
+
+	/** Returns true if the server URL has been parsed successfully and uses a supported scheme (http or https). */
+	bool IsValid(void) const { return m_IsValid; }
+
+	/** Sends a GET request for the specified path (including the query) and waits for the response, at most a_Timeout.
+	Reuses the connection kept from the previous request, if there's any. */
+	sResponse Get(const AString & a_PathAndQuery, std::chrono::milliseconds a_Timeout);
+
+	/** Returns the number of TCP connections that have been opened so far, for statistics and testing. */
+	size_t GetNumConnectionsOpened(void) const { return m_NumConnectionsOpened; }
+
+private:
+
+	class cLink;
+
+	/** The parts of the server URL. */
+	AString m_Scheme, m_Host;
+	UInt16 m_Port;
+	bool m_IsTls;
+	bool m_IsValid;
+
+	/** The connection kept open from the previous request, nullptr if there's none. */
+	std::shared_ptr<cLink> m_Link;
+
+	/** The number of TCP connections that have been opened so far. */
+	size_t m_NumConnectionsOpened;
+
+
+	/** Sends the request over the specified link and waits for the response.
+	Sets a_IsStale to true if the link turned out to be closed by the server before any response data was received,
+	in which case the request may safely be resent over a new connection. */
+	sResponse DoRequest(cLink & a_Link, const AString & a_PathAndQuery, std::chrono::steady_clock::time_point a_Deadline, bool & a_IsStale);
+
+	/** Opens a new connection to the server and waits for it to be ready for requests (including the TLS handshake).
+	Returns nullptr on failure or timeout. */
+	std::shared_ptr<cLink> Connect(std::chrono::steady_clock::time_point a_Deadline);
+};
+
+
+
+
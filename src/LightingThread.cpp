@@ -8,6 +8,7 @@
 #include "ChunkMap.h"
 #include "World.h"
 #include "BlockInfo.h"
+#include "Profiler.h"
 
 
 
@@ -19,33 +20,9 @@ class cReader :
 {
 	virtual void ChunkData(const ChunkBlockData & a_BlockData, const ChunkLightData &) override
 	{
-		BLOCKTYPE * OutputRows = m_BlockTypes;
-		int OutputIdx = m_ReadingChunkX + m_ReadingChunkZ * cChunkDef::Width * 3;
-		for (size_t i = 0; i != cChunkDef::NumSections; ++i)
-		{
-			const auto Section = a_BlockData.GetSection(i);
-			if (Section == nullptr)
-			{
-				// Skip to the next section
-				OutputIdx += 9 * cChunkDef::SectionHeight * cChunkDef::Width;
-				continue;
-			}
-
-			for (size_t OffsetY = 0; OffsetY != cChunkDef::SectionHeight; ++OffsetY)
-			{
-				for (size_t Z = 0; Z != cChunkDef::Width; ++Z)
-				{
-					auto InPtr = Section->data() + Z * cChunkDef::Width + OffsetY * cChunkDef::Width * cChunkDef::Width;
-					std::copy_n(InPtr, cChunkDef::Width, OutputRows + OutputIdx * cChunkDef::Width);
-
-					OutputIdx += 3;
-				}
-				// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
-				// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
-				OutputIdx += cChunkDef::Width * 6;
-			}
-		}
-	}  // BlockTypes()
+		// Only share the sections while the chunkmap is locked, they are copied by CopyBlockTypes() once unlocked:
+		m_BlockData.Assign(a_BlockData);
+	}
 
 
 	virtual void HeightMap(const cChunkDef::HeightMap & a_Heightmap) override
@@ -90,6 +67,43 @@ public:
 	{
 		std::fill_n(m_BlockTypes, cChunkDef::NumBlocks * 9, E_BLOCK_AIR);
 	}
+
+
+	/** Copies the block types of the last read chunk into its place in the 3x3 chunk blob. */
+	void CopyBlockTypes(void)
+	{
+		BLOCKTYPE * OutputRows = m_BlockTypes;
+		int OutputIdx = m_ReadingChunkX + m_ReadingChunkZ * cChunkDef::Width * 3;
+		for (size_t i = 0; i != cChunkDef::NumSections; ++i)
+		{
+			const auto Section = m_BlockData.GetSection(i);
+			if (Section == nullptr)
+			{
+				// Skip to the next section
+				OutputIdx += 9 * cChunkDef::SectionHeight * cChunkDef::Width;
+				continue;
+			}
+
+			for (size_t OffsetY = 0; OffsetY != cChunkDef::SectionHeight; ++OffsetY)
+			{
+				for (size_t Z = 0; Z != cChunkDef::Width; ++Z)
+				{
+					auto InPtr = Section->data() + Z * cChunkDef::Width + OffsetY * cChunkDef::Width * cChunkDef::Width;
+					std::copy_n(InPtr, cChunkDef::Width, OutputRows + OutputIdx * cChunkDef::Width);
+
+					OutputIdx += 3;
+				}
+				// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
+				// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
+				OutputIdx += cChunkDef::Width * 6;
+			}
+		}
+	}  // CopyBlockTypes()
+
+private:
+
+	/** The block data of the last read chunk, sharing its sections with the chunk. */
+	ChunkBlockData m_BlockData;
 } ;
 
 
@@ -189,6 +203,8 @@ size_t cLightingThread::GetQueueLength(void)
 
 void cLightingThread::Execute(void)
 {
+	cProfiler::SetCurrentThreadName("Lighting");
+
 	for (;;)
 	{
 		{
@@ -233,6 +249,8 @@ void cLightingThread::Execute(void)
 
 void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
 {
+	cProfileScope Profile("cLightingThread::LightChunk");
+
 	// If the chunk is already lit, skip it (report as success):
 	if (m_World.IsChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ))
 	{
@@ -338,6 +356,7 @@ void cLightingThread::ReadChunks(int a_ChunkX, int a_ChunkZ)
 		{
 			Reader.m_ReadingChunkX = x;
 			VERIFY(m_World.GetChunkData({a_ChunkX + x - 1, a_ChunkZ + z - 1}, Reader));
+			Reader.CopyBlockTypes();
 		}  // for z
 	}  // for x
 
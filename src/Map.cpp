@@ -24,6 +24,10 @@ cMap::cMap(unsigned int a_ID, cWorld * a_World):
 	m_CenterX(0),
 	m_CenterZ(0),
 	m_Dirty(false),  // This constructor is for an empty map object which will be filled by the caller with the correct values - it does not need saving.
+	m_UnsentStartX(0),
+	m_UnsentStartZ(0),
+	m_UnsentEndX(0),
+	m_UnsentEndZ(0),
 	m_World(a_World),
 	m_Name(fmt::format(FMT_STRING("map_{}"), m_ID))
 {
@@ -42,6 +46,10 @@ cMap::cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, un
 	m_CenterX(a_CenterX),
 	m_CenterZ(a_CenterZ),
 	m_Dirty(true),  // This constructor is for creating a brand new map in game, it will always need saving.
+	m_UnsentStartX(0),
+	m_UnsentStartZ(0),
+	m_UnsentEndX(0),
+	m_UnsentEndZ(0),
 	m_World(a_World),
 	m_Name(fmt::format(FMT_STRING("map_{}"), m_ID))
 {
@@ -54,10 +62,27 @@ cMap::cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, un
 
 void cMap::Tick()
 {
+	std::vector<int> ClientsInThisTick;
 	for (const auto & Client : m_ClientsInCurrentTick)
 	{
-		Client->SendMapData(*this, 0, 0);
+		const auto ClientID = Client->GetUniqueID();
+		if (std::find(m_ClientsInLastTick.begin(), m_ClientsInLastTick.end(), ClientID) != m_ClientsInLastTick.end())
+		{
+			// The client has the rest of the map already. If nothing has changed, only the decorators are sent:
+			Client->SendMapData(
+				*this,
+				static_cast<int>(m_UnsentStartX), static_cast<int>(m_UnsentStartZ),
+				static_cast<int>(m_UnsentEndX - m_UnsentStartX), static_cast<int>(m_UnsentEndZ - m_UnsentStartZ)
+			);
+		}
+		else
+		{
+			Client->SendMapData(*this, 0, 0, static_cast<int>(m_Width), static_cast<int>(m_Height));
+		}
+		ClientsInThisTick.push_back(ClientID);
 	}
+	m_ClientsInLastTick = std::move(ClientsInThisTick);
+	m_UnsentStartX = m_UnsentStartZ = m_UnsentEndX = m_UnsentEndZ = 0;
 	m_ClientsInCurrentTick.clear();
 	m_Decorators.clear();
 }
@@ -68,6 +93,12 @@ void cMap::Tick()
 
 void cMap::UpdateRadius(int a_PixelX, int a_PixelZ, unsigned int a_Radius)
 {
+	if (GetDimension() == dimNether)
+	{
+		// TODO 2014-02-22 xdot: Nether maps
+		return;
+	}
+
 	int PixelRadius = static_cast<int>(a_Radius / GetPixelWidth());
 
 	unsigned int StartX = static_cast<unsigned int>(Clamp(a_PixelX - PixelRadius, 0, static_cast<int>(m_Width)));
@@ -76,18 +107,50 @@ void cMap::UpdateRadius(int a_PixelX, int a_PixelZ, unsigned int a_Radius)
 	unsigned int EndX   = static_cast<unsigned int>(Clamp(a_PixelX + PixelRadius, 0, static_cast<int>(m_Width)));
 	unsigned int EndZ   = static_cast<unsigned int>(Clamp(a_PixelZ + PixelRadius, 0, static_cast<int>(m_Height)));
 
-	for (unsigned int X = StartX; X < EndX; ++X)
+	ASSERT(m_World != nullptr);
+
+	// Neighbouring pixels are drawn from the same chunk until their blocks cross its border, take each chunk only once:
+	unsigned int SpanStartX = StartX;
+	while (SpanStartX < EndX)
 	{
-		for (unsigned int Z = StartZ; Z < EndZ; ++Z)
+		const int ChunkX = FAST_FLOOR_DIV(PixelToBlockX(SpanStartX), cChunkDef::Width);
+		unsigned int SpanEndX = SpanStartX + 1;
+		while ((SpanEndX < EndX) && (FAST_FLOOR_DIV(PixelToBlockX(SpanEndX), cChunkDef::Width) == ChunkX))
 		{
-			int dX = static_cast<int>(X) - a_PixelX;
-			int dZ = static_cast<int>(Z) - a_PixelZ;
+			SpanEndX++;
+		}
 
-			if ((dX * dX) + (dZ * dZ) < (PixelRadius * PixelRadius))
+		unsigned int SpanStartZ = StartZ;
+		while (SpanStartZ < EndZ)
+		{
+			const int ChunkZ = FAST_FLOOR_DIV(PixelToBlockZ(SpanStartZ), cChunkDef::Width);
+			unsigned int SpanEndZ = SpanStartZ + 1;
+			while ((SpanEndZ < EndZ) && (FAST_FLOOR_DIV(PixelToBlockZ(SpanEndZ), cChunkDef::Width) == ChunkZ))
 			{
-				UpdatePixel(X, Z);
+				SpanEndZ++;
 			}
+
+			m_World->DoWithChunk(ChunkX, ChunkZ, [&](cChunk & a_Chunk)
+				{
+					for (unsigned int X = SpanStartX; X < SpanEndX; ++X)
+					{
+						for (unsigned int Z = SpanStartZ; Z < SpanEndZ; ++Z)
+						{
+							int dX = static_cast<int>(X) - a_PixelX;
+							int dZ = static_cast<int>(Z) - a_PixelZ;
+
+							if ((dX * dX) + (dZ * dZ) < (PixelRadius * PixelRadius))
+							{
+								UpdatePixel(a_Chunk, X, Z);
+							}
+						}
+					}
+					return true;
+				}
+			);
+			SpanStartZ = SpanEndZ;
 		}
+		SpanStartX = SpanEndX;
 	}
 }
 
@@ -109,64 +172,74 @@ void cMap::UpdateRadius(cPlayer & a_Player, unsigned int a_Radius)
 
 
 
-bool cMap::UpdatePixel(unsigned int a_X, unsigned int a_Z)
+void cMap::UpdatePixel(cChunk & a_Chunk, unsigned int a_X, unsigned int a_Z)
 {
-	int BlockX = m_CenterX + static_cast<int>((a_X - m_Width  / 2) * GetPixelWidth());
-	int BlockZ = m_CenterZ + static_cast<int>((a_Z - m_Height / 2) * GetPixelWidth());
+	int RelX = PixelToBlockX(a_X) - a_Chunk.GetPosX() * cChunkDef::Width;
+	int RelZ = PixelToBlockZ(a_Z) - a_Chunk.GetPosZ() * cChunkDef::Width;
 
-	int ChunkX, ChunkZ;
-	cChunkDef::BlockToChunk(BlockX, BlockZ, ChunkX, ChunkZ);
+	// The chunk keeps the colour until the column's blocks change:
+	auto Colour = a_Chunk.GetMapColour(RelX, RelZ);
+	if (!Colour.has_value())
+	{
+		Colour = GetColumnColour(a_Chunk, RelX, RelZ);
+		a_Chunk.SetMapColour(RelX, RelZ, *Colour);
+	}
 
-	int RelX = BlockX - (ChunkX * cChunkDef::Width);
-	int RelZ = BlockZ - (ChunkZ * cChunkDef::Width);
+	SetPixel(a_X, a_Z, *Colour);
+}
 
-	ASSERT(m_World != nullptr);
 
-	ColorID PixelData;
-	m_World->DoWithChunk(ChunkX, ChunkZ, [&](cChunk & a_Chunk)
-		{
-			if (GetDimension() == dimNether)
-			{
-				// TODO 2014-02-22 xdot: Nether maps
 
-				return false;
-			}
 
-			static const std::array<unsigned char, 4> BrightnessID = { { 3, 0, 1, 2 } };  // Darkest to lightest
-			BLOCKTYPE TargetBlock;
-			NIBBLETYPE TargetMeta;
 
-			auto Height = a_Chunk.GetHeight(RelX, RelZ);
-			auto ChunkHeight = cChunkDef::Height;
-			a_Chunk.GetBlockTypeMeta(RelX, Height, RelZ, TargetBlock, TargetMeta);
-			auto ColourID = cBlockHandler::For(TargetBlock).GetMapBaseColourID(TargetMeta);
+cMap::ColorID cMap::GetColumnColour(const cChunk & a_Chunk, int a_RelX, int a_RelZ)
+{
+	static const std::array<unsigned char, 4> BrightnessID = { { 3, 0, 1, 2 } };  // Darkest to lightest
+	BLOCKTYPE TargetBlock;
+	NIBBLETYPE TargetMeta;
 
-			if (IsBlockWater(TargetBlock))
-			{
-				ChunkHeight /= 4;
-				while (((--Height) != -1) && IsBlockWater(a_Chunk.GetBlock(RelX, Height, RelZ)))
-				{
-					continue;
-				}
-			}
-			else if (ColourID == 0)
-			{
-				while (((--Height) != -1) && ((ColourID = cBlockHandler::For(a_Chunk.GetBlock(RelX, Height, RelZ)).GetMapBaseColourID(a_Chunk.GetMeta(RelX, Height, RelZ))) == 0))
-				{
-					continue;
-				}
-			}
+	auto Height = a_Chunk.GetHeight(a_RelX, a_RelZ);
+	auto ChunkHeight = cChunkDef::Height;
+	a_Chunk.GetBlockTypeMeta(a_RelX, Height, a_RelZ, TargetBlock, TargetMeta);
+	auto ColourID = cBlockHandler::For(TargetBlock).GetMapBaseColourID(TargetMeta);
 
-			// Multiply base color ID by 4 and add brightness ID
-			const int BrightnessIDSize = static_cast<int>(BrightnessID.size());
-			PixelData = ColourID * 4 + BrightnessID[static_cast<size_t>(Clamp<int>((BrightnessIDSize * Height) / ChunkHeight, 0, BrightnessIDSize - 1))];
-			return false;
+	if (IsBlockWater(TargetBlock))
+	{
+		ChunkHeight /= 4;
+		while (((--Height) != -1) && IsBlockWater(a_Chunk.GetBlock(a_RelX, Height, a_RelZ)))
+		{
+			continue;
+		}
+	}
+	else if (ColourID == 0)
+	{
+		while (((--Height) != -1) && ((ColourID = cBlockHandler::For(a_Chunk.GetBlock(a_RelX, Height, a_RelZ)).GetMapBaseColourID(a_Chunk.GetMeta(a_RelX, Height, a_RelZ))) == 0))
+		{
+			continue;
 		}
-	);
+	}
+
+	// Multiply base color ID by 4 and add brightness ID
+	const int BrightnessIDSize = static_cast<int>(BrightnessID.size());
+	return static_cast<ColorID>(ColourID * 4 + BrightnessID[static_cast<size_t>(Clamp<int>((BrightnessIDSize * Height) / ChunkHeight, 0, BrightnessIDSize - 1))]);
+}
+
+
+
 
-	SetPixel(a_X, a_Z, PixelData);
 
-	return true;
+int cMap::PixelToBlockX(unsigned int a_X) const
+{
+	return m_CenterX + (static_cast<int>(a_X) - static_cast<int>(m_Width / 2)) * static_cast<int>(GetPixelWidth());
+}
+
+
+
+
+
+int cMap::PixelToBlockZ(unsigned int a_Z) const
+{
+	return m_CenterZ + (static_cast<int>(a_Z) - static_cast<int>(m_Height / 2)) * static_cast<int>(GetPixelWidth());
 }
 
 
@@ -205,6 +278,10 @@ void cMap::Resize(unsigned int a_Width, unsigned int a_Height)
 	m_Height = a_Height;
 
 	m_Data.assign(m_Width * m_Height, 0);
+	m_UnsentStartX = 0;
+	m_UnsentStartZ = 0;
+	m_UnsentEndX = m_Width;
+	m_UnsentEndZ = m_Height;
 }
 
 
@@ -231,6 +308,7 @@ bool cMap::SetPixel(unsigned int a_X, unsigned int a_Z, cMap::ColorID a_Data)
 		{
 			m_Data[index] = a_Data;
 			m_Dirty = true;
+			MarkPixelUnsent(a_X, a_Z);
 		}
 
 		return true;
@@ -270,6 +348,27 @@ unsigned int cMap::GetNumPixels(void) const
 
 
 
+void cMap::MarkPixelUnsent(unsigned int a_X, unsigned int a_Z)
+{
+	if (m_UnsentStartX >= m_UnsentEndX)
+	{
+		m_UnsentStartX = a_X;
+		m_UnsentStartZ = a_Z;
+		m_UnsentEndX = a_X + 1;
+		m_UnsentEndZ = a_Z + 1;
+		return;
+	}
+
+	m_UnsentStartX = std::min(m_UnsentStartX, a_X);
+	m_UnsentStartZ = std::min(m_UnsentStartZ, a_Z);
+	m_UnsentEndX = std::max(m_UnsentEndX, a_X + 1);
+	m_UnsentEndZ = std::max(m_UnsentEndZ, a_Z + 1);
+}
+
+
+
+
+
 const cMapDecorator cMap::CreateDecorator(const cEntity * a_TrackedEntity)
 {
 	int InsideWidth = (GetWidth() / 2) - 1;
@@ -15,6 +15,7 @@
 
 
 
+class cChunk;
 class cClientHandle;
 class cWorld;
 class cPlayer;
@@ -116,11 +117,13 @@ public:
 	/** Construct an empty map at the specified coordinates. */
 	cMap(unsigned int a_ID, int a_CenterX, int a_CenterZ, cWorld * a_World, unsigned int a_Scale = 3);
 
-	/** Sends a map update to all registered clients
+	/** Sends a map update to all registered clients: the pixels changed since the last tick to those that were sent
+	the map in the last tick as well, the whole map to the others.
 	Clears the list holding registered clients and decorators */
 	void Tick();
 
-	/** Update a circular region with the specified radius and center (in pixels). */
+	/** Update a circular region with the specified radius and center (in pixels).
+	The pixels are updated a chunk at a time, from the colours the chunks keep for their columns. */
 	void UpdateRadius(int a_PixelX, int a_PixelZ, unsigned int a_Radius);
 
 	/** Update a circular region around the specified player. */
@@ -171,8 +174,18 @@ public:
 
 private:
 
-	/** Update the specified pixel. */
-	bool UpdatePixel(unsigned int a_X, unsigned int a_Z);
+	/** Update the specified pixel, whose block lies in a_Chunk. */
+	void UpdatePixel(cChunk & a_Chunk, unsigned int a_X, unsigned int a_Z);
+
+	/** Returns the colour of the column on the map, scanning it down from its highest block. */
+	static ColorID GetColumnColour(const cChunk & a_Chunk, int a_RelX, int a_RelZ);
+
+	/** Returns the world coord of the block the pixel is drawn from. */
+	int PixelToBlockX(unsigned int a_X) const;
+	int PixelToBlockZ(unsigned int a_Z) const;
+
+	/** Adds the pixel to the ones to send to the clients in the next tick. */
+	void MarkPixelUnsent(unsigned int a_X, unsigned int a_Z);
 
 	unsigned int m_ID;
 
@@ -187,13 +200,22 @@ private:
 
 	bool m_Dirty;
 
-	/** Column-major array of colours */
+	/** Row-major array of colours */
 	cColorList m_Data;
 
+	/** The rectangle of pixels changed since the last tick, end exclusive. Empty if the start is not below the end. */
+	unsigned int m_UnsentStartX;
+	unsigned int m_UnsentStartZ;
+	unsigned int m_UnsentEndX;
+	unsigned int m_UnsentEndZ;
+
 	cWorld * m_World;
 
 	cMapClientList m_ClientsInCurrentTick;
 
+	/** The unique IDs of the clients sent the map in the last tick. They have all the pixels but the unsent ones. */
+	std::vector<int> m_ClientsInLastTick;
+
 	cMapDecoratorList m_Decorators;
 
 	AString m_Name;
@@ -6,6 +6,7 @@
 #include "MapManager.h"
 
 #include "World.h"
+#include "Profiler.h"
 #include "WorldStorage/MapSerializer.h"
 
 
@@ -52,6 +53,8 @@ bool cMapManager::DoWithMap(UInt32 a_ID, cMapCallback a_Callback)
 
 void cMapManager::TickMaps()
 {
+	cProfileScope Profile("cMapManager::TickMaps");
+
 	cCSLock Lock(m_CS);
 	for (auto & Map : m_MapData)
 	{
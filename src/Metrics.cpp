@@ -0,0 +1,450 @@
+
+// Metrics.cpp
+
+// Implements the cMetrics class, a registry of counters, gauges and histograms exported in the OpenMetrics text format
+
+#include "Globals.h"
+#include "Metrics.h"
+
+
+
+
+
+namespace
+{
+	enum class eType
+	{
+		Counter,
+		Gauge,
+		Histogram,
+	};
+
+
+
+
+
+	/** All the metrics of a single name, differing only in their labels. */
+	struct sFamily
+	{
+		eType m_Type;
+		AString m_Help;
+
+		/** Only one of the maps is used, based on m_Type. Keyed by the labels.
+		The metrics are held by pointers so that the references given out stay valid when the maps grow. */
+		std::map<AString, std::unique_ptr<cMetrics::cCounter>> m_Counters;
+		std::map<AString, std::unique_ptr<cMetrics::cGauge>> m_Gauges;
+		std::map<AString, std::unique_ptr<cMetrics::cHistogram>> m_Histograms;
+	};
+
+
+
+
+
+	/** A gauge family produced on each scrape. */
+	struct sCollector
+	{
+		AString m_Help;
+		cMetrics::cCollector m_Collector;
+
+		/** Held while m_Collector runs, so that removing the collector can wait for a scrape in progress. */
+		cCriticalSection m_CSCall;
+
+		/** Set, under m_CSCall, once the collector is removed or replaced; it must not be called anymore. */
+		bool m_IsRemoved = false;
+
+		sCollector(AString a_Help, cMetrics::cCollector a_Collector):
+			m_Help(std::move(a_Help)),
+			m_Collector(std::move(a_Collector))
+		{
+		}
+	};
+
+
+
+
+
+	struct sRegistry
+	{
+		/** Protects the maps, but not the metrics' values. */
+		cCriticalSection m_CS;
+
+		/** Sorted by name so that the output is stable. */
+		std::map<AString, sFamily> m_Families;
+		std::map<AString, std::shared_ptr<sCollector>> m_Collectors;
+	};
+
+
+
+
+
+	sRegistry & GetRegistry()
+	{
+		static sRegistry Registry;
+		return Registry;
+	}
+
+
+
+
+
+	/** Returns the family of the specified name, creating it if needed. */
+	sFamily & GetFamily(sRegistry & a_Registry, const AString & a_Name, const AString & a_Help, eType a_Type)
+	{
+		auto & Family = a_Registry.m_Families.try_emplace(a_Name, sFamily{ a_Type, a_Help, {}, {}, {} }).first->second;
+		ASSERT(Family.m_Type == a_Type);  // Was the same name registered as different types of metrics?
+		return Family;
+	}
+
+
+
+
+
+	/** Formats the number as expected by the exposition format. */
+	AString FormatValue(double a_Value)
+	{
+		if (std::isnan(a_Value))
+		{
+			return "NaN";
+		}
+		if (std::isinf(a_Value))
+		{
+			return (a_Value > 0) ? "+Inf" : "-Inf";
+		}
+		return fmt::format(FMT_STRING("{}"), a_Value);
+	}
+
+
+
+
+
+	/** Appends a single sample line; a_ExtraLabel is added after a_Labels, used for the histogram buckets' "le". */
+	void AppendSample(AString & a_Out, const AString & a_Name, const AString & a_Labels, const AString & a_ExtraLabel, const AString & a_Value)
+	{
+		a_Out.append(a_Name);
+		if (!a_Labels.empty() || !a_ExtraLabel.empty())
+		{
+			a_Out.push_back('{');
+			a_Out.append(a_Labels);
+			if (!a_Labels.empty() && !a_ExtraLabel.empty())
+			{
+				a_Out.push_back(',');
+			}
+			a_Out.append(a_ExtraLabel);
+			a_Out.push_back('}');
+		}
+		a_Out.push_back(' ');
+		a_Out.append(a_Value);
+		a_Out.push_back('\n');
+	}
+
+
+
+
+
+	void AppendHeader(AString & a_Out, const AString & a_Name, const char * a_Type, const AString & a_Help)
+	{
+		a_Out.append(fmt::format(FMT_STRING("# TYPE {} {}\n"), a_Name, a_Type));
+		if (!a_Help.empty())
+		{
+			a_Out.append(fmt::format(FMT_STRING("# HELP {} {}\n"), a_Name, a_Help));
+		}
+	}
+}  // namespace (anonymous)
+
+
+
+
+
+std::atomic<bool> cMetrics::s_IsEnabled { false };
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetrics::cHistogram:
+
+cMetrics::cHistogram::cHistogram(std::vector<double> a_Bounds):
+	m_Bounds(std::move(a_Bounds)),
+	m_Buckets(new std::atomic<UInt64>[m_Bounds.size() + 1])
+{
+	ASSERT(std::is_sorted(m_Bounds.begin(), m_Bounds.end()));
+	for (size_t i = 0; i <= m_Bounds.size(); i++)
+	{
+		m_Buckets[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+
+
+
+
+void cMetrics::cHistogram::Observe(double a_Value)
+{
+	// The bucket's bound is inclusive ("less or equal"):
+	auto Bucket = static_cast<size_t>(std::lower_bound(m_Bounds.begin(), m_Bounds.end(), a_Value) - m_Bounds.begin());
+	m_Buckets[Bucket].fetch_add(1, std::memory_order_relaxed);
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+
+	// There's no atomic addition for doubles before C++20:
+	auto Sum = m_Sum.load(std::memory_order_relaxed);
+	while (!m_Sum.compare_exchange_weak(Sum, Sum + a_Value, std::memory_order_relaxed))
+	{
+	}
+}
+
+
+
+
+
+std::vector<UInt64> cMetrics::cHistogram::GetBucketCounts(void) const
+{
+	std::vector<UInt64> Res;
+	Res.reserve(m_Bounds.size() + 1);
+	for (size_t i = 0; i <= m_Bounds.size(); i++)
+	{
+		Res.push_back(m_Buckets[i].load(std::memory_order_relaxed));
+	}
+	return Res;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cMetrics:
+
+cMetrics::cCounter & cMetrics::GetCounter(const AString & a_Name, const AString & a_Help, const AString & a_Labels)
+{
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	auto & Counter = GetFamily(Registry, a_Name, a_Help, eType::Counter).m_Counters[a_Labels];
+	if (Counter == nullptr)
+	{
+		Counter = std::make_unique<cCounter>();
+	}
+	return *Counter;
+}
+
+
+
+
+
+cMetrics::cGauge & cMetrics::GetGauge(const AString & a_Name, const AString & a_Help, const AString & a_Labels)
+{
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	auto & Gauge = GetFamily(Registry, a_Name, a_Help, eType::Gauge).m_Gauges[a_Labels];
+	if (Gauge == nullptr)
+	{
+		Gauge = std::make_unique<cGauge>();
+	}
+	return *Gauge;
+}
+
+
+
+
+
+cMetrics::cHistogram & cMetrics::GetHistogram(const AString & a_Name, const AString & a_Help, const std::vector<double> & a_Bounds, const AString & a_Labels)
+{
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	auto & Histogram = GetFamily(Registry, a_Name, a_Help, eType::Histogram).m_Histograms[a_Labels];
+	if (Histogram == nullptr)
+	{
+		Histogram = std::make_unique<cHistogram>(a_Bounds);
+	}
+	return *Histogram;
+}
+
+
+
+
+
+void cMetrics::SetCollector(const AString & a_Name, const AString & a_Help, cCollector a_Collector)
+{
+	auto & Registry = GetRegistry();
+	std::shared_ptr<sCollector> Replaced;
+	{
+		cCSLock Lock(Registry.m_CS);
+		auto & Collector = Registry.m_Collectors[a_Name];
+		Replaced = std::move(Collector);
+		Collector = std::make_shared<sCollector>(a_Help, std::move(a_Collector));
+	}
+
+	// The replaced collector may be running in a scrape, wait for it:
+	if (Replaced != nullptr)
+	{
+		cCSLock Lock(Replaced->m_CSCall);
+		Replaced->m_IsRemoved = true;
+	}
+}
+
+
+
+
+
+void cMetrics::RemoveCollector(const AString & a_Name)
+{
+	auto & Registry = GetRegistry();
+	std::shared_ptr<sCollector> Removed;
+	{
+		cCSLock Lock(Registry.m_CS);
+		auto itr = Registry.m_Collectors.find(a_Name);
+		if (itr == Registry.m_Collectors.end())
+		{
+			return;
+		}
+		Removed = std::move(itr->second);
+		Registry.m_Collectors.erase(itr);
+	}
+
+	// A scrape may have taken the collector before it was removed, wait for it to finish the call.
+	// The registry is unlocked meanwhile, the collector may be registering metrics:
+	cCSLock Lock(Removed->m_CSCall);
+	Removed->m_IsRemoved = true;
+}
+
+
+
+
+
+AString cMetrics::Serialize(void)
+{
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	AString Res;
+	std::set<AString> Names;
+	for (const auto & [Name, Family]: Registry.m_Families)
+	{
+		Names.insert(Name);
+		switch (Family.m_Type)
+		{
+			case eType::Counter:
+			{
+				AppendHeader(Res, Name, "counter", Family.m_Help);
+				for (const auto & [Labels, Counter]: Family.m_Counters)
+				{
+					AppendSample(Res, Name + "_total", Labels, AString(), fmt::format(FMT_STRING("{}"), Counter->Get()));
+				}
+				break;
+			}
+			case eType::Gauge:
+			{
+				AppendHeader(Res, Name, "gauge", Family.m_Help);
+				for (const auto & [Labels, Gauge]: Family.m_Gauges)
+				{
+					AppendSample(Res, Name, Labels, AString(), FormatValue(Gauge->Get()));
+				}
+				break;
+			}
+			case eType::Histogram:
+			{
+				AppendHeader(Res, Name, "histogram", Family.m_Help);
+				for (const auto & [Labels, Histogram]: Family.m_Histograms)
+				{
+					// The buckets are cumulative in the output. The count is taken from the buckets, rather than
+					// read separately, so that it matches the +Inf bucket even while observations are being added:
+					const auto & Bounds = Histogram->GetBounds();
+					const auto Counts = Histogram->GetBucketCounts();
+					UInt64 Cumulative = 0;
+					for (size_t i = 0; i < Counts.size(); i++)
+					{
+						Cumulative += Counts[i];
+						auto Bound = (i < Bounds.size()) ? FormatValue(Bounds[i]) : AString("+Inf");
+						AppendSample(Res, Name + "_bucket", Labels, fmt::format(FMT_STRING("le=\"{}\""), Bound), fmt::format(FMT_STRING("{}"), Cumulative));
+					}
+					AppendSample(Res, Name + "_count", Labels, AString(), fmt::format(FMT_STRING("{}"), Cumulative));
+					AppendSample(Res, Name + "_sum", Labels, AString(), FormatValue(Histogram->GetSum()));
+				}
+				break;
+			}
+		}
+	}
+
+	// The collectors may need to lock other objects (worlds), whose owners may in turn register metrics.
+	// Call them unlocked, to avoid a deadlock:
+	auto Collectors = Registry.m_Collectors;
+	Lock.Unlock();
+
+	std::vector<sSample> Samples;
+	for (const auto & [Name, Collector]: Collectors)
+	{
+		if (Names.find(Name) != Names.end())
+		{
+			// A name may only be used once in the output
+			continue;
+		}
+		Samples.clear();
+		{
+			// Removing the collector waits for this call; once removed, the objects it uses may be gone:
+			cCSLock CallLock(Collector->m_CSCall);
+			if (Collector->m_IsRemoved)
+			{
+				continue;
+			}
+			Collector->m_Collector(Samples);
+		}
+		AppendHeader(Res, Name, "gauge", Collector->m_Help);
+		for (const auto & Sample: Samples)
+		{
+			AppendSample(Res, Name, Sample.m_Labels, AString(), FormatValue(Sample.m_Value));
+		}
+	}
+
+	Res.append("# EOF\n");
+	return Res;
+}
+
+
+
+
+
+AString cMetrics::FormatLabels(std::initializer_list<std::pair<const char *, AString>> a_Labels)
+{
+	AString Res;
+	for (const auto & [Name, Value]: a_Labels)
+	{
+		if (!Res.empty())
+		{
+			Res.push_back(',');
+		}
+		Res.append(Name);
+		Res.append("=\"");
+		for (auto ch: Value)
+		{
+			switch (ch)
+			{
+				case '\\': Res.append("\\\\"); break;
+				case '"':  Res.append("\\\""); break;
+				case '\n': Res.append("\\n");  break;
+				default:   Res.push_back(ch);  break;
+			}
+		}
+		Res.push_back('"');
+	}
+	return Res;
+}
+
+
+
+
+
+const std::vector<double> & cMetrics::TickDurationBounds(void)
+{
+	// Centered around the 50 ms of a tick:
+	static const std::vector<double> Bounds{ 0.005, 0.01, 0.02, 0.03, 0.04, 0.05, 0.075, 0.1, 0.25, 0.5, 1, 5 };
+	return Bounds;
+}
+
+
+
+
+
+const std::vector<double> & cMetrics::ShortDurationBounds(void)
+{
+	static const std::vector<double> Bounds{ 0.00001, 0.00005, 0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1 };
+	return Bounds;
+}
@@ -0,0 +1,155 @@
+
+// Metrics.h
+
+// Declares the cMetrics class, a registry of counters, gauges and histograms exported in the OpenMetrics text format
+
+/*
+The core subsystems register their metrics once and keep the returned references; updating a metric is then a
+relaxed atomic operation, no lock is taken. The registry's lock is only used for registering a metric and for
+serializing them all (the scrape). The references stay valid for the lifetime of the process.
+Metrics with label sets that come and go (per-player, per-entity-class) are better produced by a collector, a
+callback invoked on each scrape, so that the departed label sets don't linger in the output.
+The metrics are served by the webadmin (see the MetricsPath value in webadmin.ini); when not enabled, the
+subsystems are expected to skip their measurements, cMetrics::IsEnabled() is a single relaxed load.
+
+Usage:
+	static auto & Requests = cMetrics::GetCounter("cuberite_requests", "Number of requests served");
+	Requests.Inc();
+*/
+
+
+
+
+
+#pragma once
+
+#include <functional>
+
+
+
+
+
+class cMetrics
+{
+public:
+
+	/** Monotonically increasing value, such as the number of events that have happened. */
+	class cCounter
+	{
+	public:
+
+		void Inc(UInt64 a_Amount = 1) { m_Value.fetch_add(a_Amount, std::memory_order_relaxed); }
+
+		UInt64 Get(void) const { return m_Value.load(std::memory_order_relaxed); }
+
+	private:
+
+		std::atomic<UInt64> m_Value{ 0 };
+	};
+
+
+	/** A value that can go up and down, such as a queue length. */
+	class cGauge
+	{
+	public:
+
+		void Set(double a_Value) { m_Value.store(a_Value, std::memory_order_relaxed); }
+
+		double Get(void) const { return m_Value.load(std::memory_order_relaxed); }
+
+	private:
+
+		std::atomic<double> m_Value{ 0 };
+	};
+
+
+	/** Distribution of observed values, such as durations, in buckets with fixed upper bounds. */
+	class cHistogram
+	{
+	public:
+
+		/** Creates a histogram with the specified bucket upper bounds, which must be sorted ascending.
+		The implicit +Inf bucket is added automatically. */
+		explicit cHistogram(std::vector<double> a_Bounds);
+
+		/** Adds a single observation. */
+		void Observe(double a_Value);
+
+		/** Returns the bucket upper bounds, without the implicit +Inf. */
+		const std::vector<double> & GetBounds(void) const { return m_Bounds; }
+
+		/** Returns the number of observations in each bucket, not cumulative; the last one is the +Inf bucket. */
+		std::vector<UInt64> GetBucketCounts(void) const;
+
+		/** Returns the number of all observations. */
+		UInt64 GetCount(void) const { return m_Count.load(std::memory_order_relaxed); }
+
+		/** Returns the sum of all observed values. */
+		double GetSum(void) const { return m_Sum.load(std::memory_order_relaxed); }
+
+	private:
+
+		std::vector<double> m_Bounds;
+
+		/** Number of observations per bucket, one more than there are bounds. */
+		std::unique_ptr<std::atomic<UInt64>[]> m_Buckets;
+
+		std::atomic<UInt64> m_Count{ 0 };
+		std::atomic<double> m_Sum{ 0 };
+	};
+
+
+	/** A single value produced by a collector. */
+	struct sSample
+	{
+		/** The labels, as formatted by FormatLabels(). */
+		AString m_Labels;
+
+		double m_Value;
+	};
+
+	/** A callback producing the current values of a gauge family on each scrape. */
+	using cCollector = std::function<void(std::vector<sSample> & a_Samples)>;
+
+
+	/** Returns true if the metrics are being served, and so should be measured. */
+	static bool IsEnabled(void) { return s_IsEnabled.load(std::memory_order_relaxed); }
+
+	/** Enables or disables the measurements. The already registered metrics are kept. */
+	static void SetEnabled(bool a_IsEnabled) { s_IsEnabled.store(a_IsEnabled, std::memory_order_relaxed); }
+
+	/** Returns the counter of the specified name and labels, registering it on first use.
+	The name is without the "_total" suffix, it is added on output. a_Labels is formatted by FormatLabels(). */
+	static cCounter & GetCounter(const AString & a_Name, const AString & a_Help, const AString & a_Labels = AString());
+
+	/** Returns the gauge of the specified name and labels, registering it on first use. */
+	static cGauge & GetGauge(const AString & a_Name, const AString & a_Help, const AString & a_Labels = AString());
+
+	/** Returns the histogram of the specified name and labels, registering it with the bounds on first use.
+	All the histograms of the same name should use the same bounds. */
+	static cHistogram & GetHistogram(const AString & a_Name, const AString & a_Help, const std::vector<double> & a_Bounds, const AString & a_Labels = AString());
+
+	/** Sets the collector producing the gauge family of the specified name; replaces any previous one of the same name. */
+	static void SetCollector(const AString & a_Name, const AString & a_Help, cCollector a_Collector);
+
+	/** Removes the collector of the specified name. To be called before anything the collector uses goes away.
+	If a scrape is calling the collector meanwhile, waits for the call to finish; so the caller mustn't hold any lock that the collector takes. */
+	static void RemoveCollector(const AString & a_Name);
+
+	/** Returns all the metrics in the OpenMetrics text format, including the final "# EOF" line. */
+	static AString Serialize(void);
+
+	/** Returns the label set in the exposition format, such as: world="world",class="cPig".
+	The values are escaped as needed. */
+	static AString FormatLabels(std::initializer_list<std::pair<const char *, AString>> a_Labels);
+
+	/** Bucket bounds suitable for durations of a tick, in seconds. */
+	static const std::vector<double> & TickDurationBounds(void);
+
+	/** Bucket bounds suitable for short durations, such as a single plugin callback, in seconds. */
+	static const std::vector<double> & ShortDurationBounds(void);
+
+private:
+
+	static std::atomic<bool> s_IsEnabled;
+};
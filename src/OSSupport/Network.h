@@ -85,6 +85,10 @@ public:
 		return Send(a_Data.data(), a_Data.size());
 	}
 
+	/** Returns the number of bytes that have been queued by Send() but not yet handed over to the OS.
+	A growing value means that the remote peer cannot keep up with the data being sent. */
+	virtual size_t GetOutgoingDataSize(void) const = 0;
+
 	/** Returns the IP address of the local endpoint of the connection. */
 	virtual AString GetLocalIP(void) const = 0;
 
@@ -165,6 +169,10 @@ public:
 
 	/** Returns true if the server has been started correctly and is currently listening for incoming connections. */
 	virtual bool IsListening(void) const = 0;
+
+	/** Returns the local port on which the server is listening, useful when it was asked to listen on port 0 (any free port).
+	Returns 0 if not listening. */
+	virtual UInt16 GetPort(void) const = 0;
 };
 
 
@@ -2,7 +2,7 @@
 // NetworkSingleton.cpp
 
 // Implements the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
 
 #include "Globals.h"
 #include "NetworkSingleton.h"
@@ -15,6 +15,13 @@
 
 
 
+/** The loop whose thread is the current thread, nullptr in all the other threads. */
+static thread_local const cNetworkSingleton::sEventLoop * g_CurrentEventLoop = nullptr;
+
+
+
+
+
 cNetworkSingleton::cNetworkSingleton() :
 	m_HasTerminated(true)
 {
@@ -44,7 +51,7 @@ cNetworkSingleton & cNetworkSingleton::Get(void)
 
 
 
-void cNetworkSingleton::Initialise(void)
+void cNetworkSingleton::Initialise(size_t a_NumEventLoops)
 {
 	// Start the lookup thread
 	m_LookupThread.Start();
@@ -74,21 +81,38 @@ void cNetworkSingleton::Initialise(void)
 		#error No threading implemented for EVTHREAD
 	#endif
 
-	// Create the main event_base:
-	event_config * config = event_config_new();
-	event_config_set_flag(config, EVENT_BASE_FLAG_STARTUP_IOCP);
-	m_EventBase = event_base_new_with_config(config);
-	if (m_EventBase == nullptr)
+	// By default, run one loop per hardware thread:
+	if (a_NumEventLoops == 0)
+	{
+		a_NumEventLoops = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	// Create the event_bases:
+	cCSLock Lock(m_CSEventLoops);
+	ASSERT(m_EventLoops.empty());
+	for (size_t i = 0; i < a_NumEventLoops; i++)
 	{
-		LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
-		abort();
+		auto EventLoop = std::make_shared<sEventLoop>();
+		event_config * config = event_config_new();
+		event_config_set_flag(config, EVENT_BASE_FLAG_STARTUP_IOCP);
+		EventLoop->m_EventBase = event_base_new_with_config(config);
+		if (EventLoop->m_EventBase == nullptr)
+		{
+			LOGERROR("Failed to initialize LibEvent. The server will now terminate.");
+			abort();
+		}
+		event_config_free(config);
+		EventLoop->m_TasksEvent = event_new(EventLoop->m_EventBase, -1, 0, RunTasks, EventLoop.get());
+		m_EventLoops.push_back(std::move(EventLoop));
 	}
-	event_config_free(config);
 
-	// Create the event loop thread:
+	// Create the event loop threads:
 	m_HasTerminated = false;
-	m_EventLoopThread = std::thread(RunEventLoop, this);
-	m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+	for (auto & EventLoop : m_EventLoops)
+	{
+		EventLoop->m_Thread = std::thread(RunEventLoop, EventLoop.get());
+		EventLoop->m_StartupEvent.Wait();  // Wait for the LibEvent loop to actually start running (otherwise calling Terminate too soon would hang, see #3228)
+	}
 }
 
 
@@ -102,33 +126,58 @@ void cNetworkSingleton::Terminate(void)
 	// Wait for the lookup thread to stop
 	m_LookupThread.Stop();
 
-	// Wait for the LibEvent event loop to terminate:
-	event_base_loopbreak(m_EventBase);
-	m_EventLoopThread.join();
+	// Wait for the LibEvent event loops to terminate:
+	for (auto & EventLoop : m_EventLoops)
+	{
+		event_base_loopbreak(EventLoop->m_EventBase);
+	}
+	for (auto & EventLoop : m_EventLoops)
+	{
+		EventLoop->m_Thread.join();
+	}
+
+	// From now on, RunOnEventLoop() runs the tasks directly. Run the ones that the loops didn't get to:
+	for (auto & EventLoop : m_EventLoops)
+	{
+		{
+			cCSLock Lock(EventLoop->m_CS);
+			EventLoop->m_HasStopped = true;
+		}
+		RunTasks(-1, 0, EventLoop.get());
+	}
 
 	// Close all open connections:
+	for (auto & EventLoop : m_EventLoops)
 	{
-		cCSLock Lock(m_CS);
+		cCSLock Lock(EventLoop->m_CS);
 		// Must take copies because Close will modify lists
-		auto Conns = m_Connections;
+		auto Conns = EventLoop->m_Connections;
 		for (auto & Conn : Conns)
 		{
 			Conn->Close();
 		}
 
+		// Closed handles should have removed themself
+		ASSERT(EventLoop->m_Connections.empty());
+	}
+	{
+		cCSLock Lock(m_CS);
 		auto Servers = m_Servers;
 		for (auto & Server : Servers)
 		{
 			Server->Close();
 		}
-
-		// Closed handles should have removed themself
-		ASSERT(m_Connections.empty());
 		ASSERT(m_Servers.empty());
 	}
 
-	// Free the underlying LibEvent objects:
-	event_base_free(m_EventBase);
+	// Free the underlying LibEvent objects. Links that outlive this still hold their loop, but it is no longer in m_EventLoops:
+	cCSLock Lock(m_CSEventLoops);
+	for (auto & EventLoop : m_EventLoops)
+	{
+		event_free(EventLoop->m_TasksEvent);
+		event_base_free(EventLoop->m_EventBase);
+	}
+	m_EventLoops.clear();
 
 	libevent_global_shutdown();
 
@@ -161,12 +210,13 @@ void cNetworkSingleton::LogCallback(int a_Severity, const char * a_Msg)
 
 
 
-void cNetworkSingleton::RunEventLoop(cNetworkSingleton * a_Self)
+void cNetworkSingleton::RunEventLoop(sEventLoop * a_EventLoop)
 {
-	auto timer = evtimer_new(a_Self->m_EventBase, SignalizeStartup, a_Self);
+	g_CurrentEventLoop = a_EventLoop;
+	auto timer = evtimer_new(a_EventLoop->m_EventBase, SignalizeStartup, a_EventLoop);
 	timeval timeout{};  // Zero timeout - execute immediately
 	evtimer_add(timer, &timeout);
-	event_base_loop(a_Self->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
+	event_base_loop(a_EventLoop->m_EventBase, EVLOOP_NO_EXIT_ON_EMPTY);
 	event_free(timer);
 }
 
@@ -174,37 +224,137 @@ void cNetworkSingleton::RunEventLoop(cNetworkSingleton * a_Self)
 
 
 
-void cNetworkSingleton::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self)
+void cNetworkSingleton::SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop)
 {
-	auto self = static_cast<cNetworkSingleton *>(a_Self);
-	ASSERT(self != nullptr);
-	self->m_StartupEvent.Set();
+	auto EventLoop = static_cast<sEventLoop *>(a_EventLoop);
+	ASSERT(EventLoop != nullptr);
+	EventLoop->m_StartupEvent.Set();
 }
 
 
 
 
 
-void cNetworkSingleton::AddLink(const cTCPLinkPtr & a_Link)
+void cNetworkSingleton::RunTasks(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop)
+{
+	auto EventLoop = static_cast<sEventLoop *>(a_EventLoop);
+	ASSERT(EventLoop != nullptr);
+
+	// Run the tasks unlocked, they may queue more tasks; those are run in the next activation:
+	std::vector<std::function<void()>> Tasks;
+	{
+		cCSLock Lock(EventLoop->m_CS);
+		std::swap(Tasks, EventLoop->m_Tasks);
+	}
+	for (auto & Task : Tasks)
+	{
+		Task();
+	}
+}
+
+
+
+
+
+size_t cNetworkSingleton::GetNumEventLoops(void) const
+{
+	cCSLock Lock(m_CSEventLoops);
+	return m_EventLoops.size();
+}
+
+
+
+
+
+cNetworkSingleton::cEventLoopPtr cNetworkSingleton::AcquireEventLoop(void)
 {
 	ASSERT(!m_HasTerminated);
-	cCSLock Lock(m_CS);
-	m_Connections.push_back(a_Link);
+	cCSLock Lock(m_CSEventLoops);
+	ASSERT(!m_EventLoops.empty());
+
+	// Pick the loop with the fewest links; the races with other threads picking at the same time only skew the balance slightly:
+	auto Best = m_EventLoops[0];
+	for (const auto & EventLoop : m_EventLoops)
+	{
+		if (EventLoop->m_NumLinks < Best->m_NumLinks)
+		{
+			Best = EventLoop;
+		}
+	}
+	Best->m_NumLinks += 1;
+	return Best;
 }
 
 
 
 
 
-void cNetworkSingleton::RemoveLink(const cTCPLink * a_Link)
+void cNetworkSingleton::ReleaseEventLoop(const cEventLoopPtr & a_EventLoop)
+{
+	// The link holds its own loop, even after Terminate(), so there's no need to look it up in m_EventLoops:
+	ASSERT(a_EventLoop->m_NumLinks > 0);
+	a_EventLoop->m_NumLinks -= 1;
+}
+
+
+
+
+
+void cNetworkSingleton::RunOnEventLoop(const cEventLoopPtr & a_EventLoop, std::function<void()> a_Task)
+{
+	{
+		cCSLock Lock(a_EventLoop->m_CS);
+		if (!a_EventLoop->m_HasStopped)
+		{
+			a_EventLoop->m_Tasks.push_back(std::move(a_Task));
+			if (a_EventLoop->m_Tasks.size() == 1)
+			{
+				// The first task since the last run, wake up the loop:
+				event_active(a_EventLoop->m_TasksEvent, 0, 0);
+			}
+			return;
+		}
+	}
+
+	// The loop's thread is not running anymore, so it cannot race with this thread:
+	a_Task();
+}
+
+
+
+
+
+bool cNetworkSingleton::IsInEventLoop(const cEventLoopPtr & a_EventLoop)
+{
+	return (g_CurrentEventLoop == a_EventLoop.get());
+}
+
+
+
+
+
+void cNetworkSingleton::AddLink(const cTCPLinkPtr & a_Link, const cEventLoopPtr & a_EventLoop)
 {
 	ASSERT(!m_HasTerminated);
-	cCSLock Lock(m_CS);
-	for (auto itr = m_Connections.begin(), end = m_Connections.end(); itr != end; ++itr)
+	auto & EventLoop = *a_EventLoop;
+	cCSLock Lock(EventLoop.m_CS);
+	EventLoop.m_Connections.push_back(a_Link);
+}
+
+
+
+
+
+void cNetworkSingleton::RemoveLink(const cTCPLink * a_Link, const cEventLoopPtr & a_EventLoop)
+{
+	ASSERT(!m_HasTerminated);
+	auto & EventLoop = *a_EventLoop;
+	cCSLock Lock(EventLoop.m_CS);
+	for (auto itr = EventLoop.m_Connections.begin(), end = EventLoop.m_Connections.end(); itr != end; ++itr)
 	{
 		if (itr->get() == a_Link)
 		{
-			m_Connections.erase(itr);
+			EventLoop.m_Connections.erase(itr);
 			return;
 		}
 	}  // for itr - m_Connections[]
@@ -2,7 +2,11 @@
 // NetworkSingleton.h
 
 // Declares the cNetworkSingleton class representing the storage for global data pertaining to network API
-// such as a list of all connections, all listening sockets and the LibEvent dispatch thread.
+// such as a list of all connections, all listening sockets and the LibEvent dispatch threads.
+
+// There are several LibEvent loops, each running in its own thread, so that the socket I/O of many connections
+// can use multiple cores. The listening sockets, UDP endpoints and lookups use the first (main) loop,
+// each TCP link is assigned to the least loaded loop when it is created and stays there for its whole lifetime.
 
 // This is an internal header, no-one outside OSSupport should need to include it; use Network.h instead;
 // the only exception being the main app entrypoint that needs to call Terminate before quitting.
@@ -38,6 +42,42 @@ typedef std::vector<cServerHandlePtr> cServerHandlePtrs;
 class cNetworkSingleton
 {
 public:
+
+	/** A single LibEvent loop, with its thread and the links assigned to it.
+	The links keep a shared pointer to their loop, so that a link outliving Terminate() never touches the loops of a later Initialise(). */
+	struct sEventLoop
+	{
+		/** The LibEvent container for driving the event loop. */
+		event_base * m_EventBase = nullptr;
+
+		/** The thread in which the LibEvent loop runs. */
+		std::thread m_Thread;
+
+		/** Event that is signalled once the startup is finished and the LibEvent loop is running. */
+		cEvent m_StartupEvent;
+
+		/** Mutex protecting m_Connections, m_Tasks and m_HasStopped against multithreaded access. */
+		cCriticalSection m_CS;
+
+		/** Container for the client connections of this loop, including ones with pending-connect. */
+		cTCPLinkPtrs m_Connections;
+
+		/** Number of links (both client and server-accepted) currently assigned to this loop, used for balancing. */
+		std::atomic<size_t> m_NumLinks { 0 };
+
+		/** The tasks queued by RunOnEventLoop(), to be run by the loop's thread in the order they were queued. */
+		std::vector<std::function<void()>> m_Tasks;
+
+		/** The LibEvent event that runs m_Tasks, activated by RunOnEventLoop(). */
+		event * m_TasksEvent = nullptr;
+
+		/** Set once the loop's thread has stopped; the tasks are then run by the queueing thread itself. */
+		bool m_HasStopped = false;
+	};
+
+	using cEventLoopPtr = std::shared_ptr<sEventLoop>;
+
+
 	cNetworkSingleton();
 	~cNetworkSingleton() noexcept(false);
 
@@ -45,8 +85,9 @@ public:
 	static cNetworkSingleton & Get(void);
 
 	/** Initialises all network-related threads.
+	a_NumEventLoops is the number of LibEvent loops to run, 0 for one per hardware thread.
 	To be called on first run or after app restart. */
-	void Initialise(void);
+	void Initialise(size_t a_NumEventLoops = 0);
 
 	/** Terminates all network-related threads.
 	To be used only on app shutdown or restart.
@@ -54,18 +95,36 @@ public:
 	void Terminate(void);
 
 	/** Returns the main LibEvent handle for event registering. */
-	event_base * GetEventBase(void) { return m_EventBase; }
+	event_base * GetEventBase(void) { return m_EventLoops[0]->m_EventBase; }
+
+	/** Returns the number of LibEvent loops. */
+	size_t GetNumEventLoops(void) const;
+
+	/** Picks the loop with the fewest links for a new link and accounts the link to it.
+	The link must call ReleaseEventLoop() when it is destroyed. */
+	cEventLoopPtr AcquireEventLoop(void);
+
+	/** Removes a link from the accounting of the loop it was assigned by AcquireEventLoop(). */
+	void ReleaseEventLoop(const cEventLoopPtr & a_EventLoop);
+
+	/** Runs the task in the thread of the specified loop, as soon as possible, after the tasks queued before it.
+	Used to marshal work onto the thread that handles a specific link's callbacks.
+	If the loop has already stopped (Terminate()), the task is run right away in the calling thread. */
+	void RunOnEventLoop(const cEventLoopPtr & a_EventLoop, std::function<void()> a_Task);
+
+	/** Returns true if called from the thread of the specified loop. */
+	static bool IsInEventLoop(const cEventLoopPtr & a_EventLoop);
 
 	/** Returns the thread used to perform hostname and IP lookups */
 	cNetworkLookup & GetLookupThread() { return m_LookupThread; }
 
-	/** Adds the specified link to m_Connections.
+	/** Adds the specified link to the m_Connections of the specified loop.
 	Used by the underlying link implementation when a new link is created. */
-	void AddLink(const cTCPLinkPtr & a_Link);
+	void AddLink(const cTCPLinkPtr & a_Link, const cEventLoopPtr & a_EventLoop);
 
-	/** Removes the specified link from m_Connections.
+	/** Removes the specified link from the m_Connections of the specified loop.
 	Used by the underlying link implementation when the link is closed / errored. */
-	void RemoveLink(const cTCPLink * a_Link);
+	void RemoveLink(const cTCPLink * a_Link, const cEventLoopPtr & a_EventLoop);
 
 	/** Adds the specified link to m_Servers.
 	Used by the underlying server handle implementation when a new listening server is created.
@@ -78,27 +137,22 @@ public:
 
 protected:
 
-	/** The main LibEvent container for driving the event loop. */
-	event_base * m_EventBase;
+	/** All the LibEvent loops. The first one is the main loop.
+	Filled by Initialise() and emptied by Terminate(), under m_CSEventLoops; other threads only read it. */
+	std::vector<cEventLoopPtr> m_EventLoops;
 
-	/** Container for all client connections, including ones with pending-connect. */
-	cTCPLinkPtrs m_Connections;
+	/** Mutex protecting m_EventLoops against being changed while read. */
+	mutable cCriticalSection m_CSEventLoops;
 
 	/** Container for all servers that are currently active. */
 	cServerHandlePtrs m_Servers;
 
-	/** Mutex protecting all containers against multithreaded access. */
+	/** Mutex protecting m_Servers against multithreaded access. */
 	cCriticalSection m_CS;
 
 	/** Set to true if Terminate has been called. */
 	std::atomic<bool> m_HasTerminated;
 
-	/** The thread in which the main LibEvent loop runs. */
-	std::thread m_EventLoopThread;
-
-	/** Event that is signalled once the startup is finished and the LibEvent loop is running. */
-	cEvent m_StartupEvent;
-
 	/** The thread on which hostname and ip address lookup is performed. */
 	cNetworkLookup m_LookupThread;
 
@@ -107,10 +161,13 @@ protected:
 	static void LogCallback(int a_Severity, const char * a_Msg);
 
 	/** Implements the thread that runs LibEvent's event dispatcher loop. */
-	static void RunEventLoop(cNetworkSingleton * a_Self);
+	static void RunEventLoop(sEventLoop * a_EventLoop);
 
 	/** Callback called by LibEvent when the event loop is started. */
-	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_Self);
+	static void SignalizeStartup(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop);
+
+	/** Callback called by LibEvent to run the tasks queued by RunOnEventLoop(). */
+	static void RunTasks(evutil_socket_t a_Socket, short a_Events, void * a_EventLoop);
 };
 
 
@@ -39,6 +39,7 @@ cServerHandleImpl::cServerHandleImpl(cNetwork::cListenCallbacksPtr a_ListenCallb
 	m_ConnListener(nullptr),
 	m_SecondaryConnListener(nullptr),
 	m_IsListening(false),
+	m_Port(0),
 	m_ErrorCode(0)
 {
 }
@@ -75,6 +76,7 @@ void cServerHandleImpl::Close(void)
 		evconnlistener_disable(m_SecondaryConnListener);
 	}
 	m_IsListening = false;
+	m_Port = 0;
 
 	// Shutdown all connections:
 	cTCPLinkImplPtrs Conns;
@@ -225,6 +227,31 @@ bool cServerHandleImpl::Listen(UInt16 a_Port)
 	m_ConnListener = evconnlistener_new(cNetworkSingleton::Get().GetEventBase(), Callback, this, LEV_OPT_CLOSE_ON_FREE | LEV_OPT_REUSEABLE, 0, MainSock);
 	m_IsListening = true;
 
+	// Read the actual port number on which the socket is listening, a_Port may have been 0:
+	{
+		sockaddr_storage name;
+		socklen_t namelen = static_cast<socklen_t>(sizeof(name));
+		getsockname(MainSock, reinterpret_cast<sockaddr *>(&name), &namelen);
+		switch (name.ss_family)
+		{
+			case AF_INET:
+			{
+				m_Port = ntohs(reinterpret_cast<sockaddr_in *>(&name)->sin_port);
+				break;
+			}
+			case AF_INET6:
+			{
+				m_Port = ntohs(reinterpret_cast<sockaddr_in6 *>(&name)->sin6_port);
+				break;
+			}
+		}
+	}
+	if (NeedsTwoSockets)
+	{
+		// The secondary socket must be on the same port as the main one:
+		a_Port = m_Port;
+	}
+
 	if (!NeedsTwoSockets)
 	{
 		return true;
@@ -331,7 +358,7 @@ void cServerHandleImpl::Callback(evconnlistener * a_Listener, evutil_socket_t a_
 	const int one = 1;
 	setsockopt(a_Socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
 
-	// Create a new cTCPLink for the incoming connection:
+	// Create a new cTCPLink for the incoming connection, it picks the least loaded event loop:
 	cTCPLinkImplPtr Link = std::make_shared<cTCPLinkImpl>(a_Socket, LinkCallbacks, Self->m_SelfPtr, a_Addr, static_cast<socklen_t>(a_Len));
 	{
 		cCSLock Lock(Self->m_CS);
@@ -53,6 +53,7 @@ public:
 	// cServerHandle overrides:
 	virtual void Close(void) override;
 	virtual bool IsListening(void) const override { return m_IsListening; }
+	virtual UInt16 GetPort(void) const override { return m_Port; }
 
 protected:
 	/** The callbacks used to notify about incoming connections. */
@@ -67,6 +68,9 @@ protected:
 	/** Set to true when the server is initialized successfully and is listening for incoming connections. */
 	bool m_IsListening;
 
+	/** The port on which the main socket is listening, as read back from the socket. 0 when not listening. */
+	UInt16 m_Port;
+
 	/** Container for all currently active connections on this server. */
 	cTCPLinkImplPtrs m_Connections;
 
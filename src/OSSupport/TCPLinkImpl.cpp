@@ -19,7 +19,9 @@
 
 cTCPLinkImpl::cTCPLinkImpl(const std::string & a_Host, cTCPLink::cCallbacksPtr a_LinkCallbacks):
 	Super(std::move(a_LinkCallbacks)),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventLoop(cNetworkSingleton::Get().AcquireEventLoop()),
+	m_NumQueuedBytes(0),
+	m_BufferEvent(bufferevent_socket_new(m_EventLoop->m_EventBase, -1, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_LocalPort(0),
 	m_RemoteHost(a_Host),
 	m_RemotePort(0),
@@ -39,7 +41,9 @@ cTCPLinkImpl::cTCPLinkImpl(
 	socklen_t a_AddrLen
 ):
 	Super(std::move(a_LinkCallbacks)),
-	m_BufferEvent(bufferevent_socket_new(cNetworkSingleton::Get().GetEventBase(), a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
+	m_EventLoop(cNetworkSingleton::Get().AcquireEventLoop()),
+	m_NumQueuedBytes(0),
+	m_BufferEvent(bufferevent_socket_new(m_EventLoop->m_EventBase, a_Socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE | BEV_OPT_DEFER_CALLBACKS | BEV_OPT_UNLOCK_CALLBACKS)),
 	m_Server(std::move(a_Server)),
 	m_LocalPort(0),
 	m_RemotePort(0),
@@ -60,6 +64,7 @@ cTCPLinkImpl::~cTCPLinkImpl()
 	m_TlsContext.reset();
 
 	bufferevent_free(m_BufferEvent);
+	cNetworkSingleton::Get().ReleaseEventLoop(m_EventLoop);
 }
 
 
@@ -74,7 +79,7 @@ cTCPLinkImplPtr cTCPLinkImpl::Connect(const AString & a_Host, UInt16 a_Port, cTC
 	// Create a new link:
 	cTCPLinkImplPtr res{new cTCPLinkImpl(a_Host, std::move(a_LinkCallbacks))};  // Cannot use std::make_shared here, constructor is not accessible
 	res->m_ConnectCallbacks = std::move(a_ConnectCallbacks);
-	cNetworkSingleton::Get().AddLink(res);
+	cNetworkSingleton::Get().AddLink(res, res->m_EventLoop);
 	res->m_Callbacks->OnLinkCreated(res);
 	res->Enable(res);
 
@@ -131,7 +136,7 @@ cTCPLinkImplPtr cTCPLinkImpl::Connect(const AString & a_Host, UInt16 a_Port, cTC
 		virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
 		{
 			m_Link->GetCallbacks()->OnError(a_ErrorCode, a_ErrorMsg);
-			cNetworkSingleton::Get().RemoveLink(m_Link.get());
+			cNetworkSingleton::Get().RemoveLink(m_Link.get(), m_Link->m_EventLoop);
 		}
 
 		// Don't need to do anything for these
@@ -168,6 +173,28 @@ void cTCPLinkImpl::Enable(cTCPLinkImplPtr a_Self)
 
 
 bool cTCPLinkImpl::Send(const void * a_Data, size_t a_Length)
+{
+	if (cNetworkSingleton::IsInEventLoop(m_EventLoop))
+	{
+		return SendNow(a_Data, a_Length);
+	}
+
+	// Hand the data over to the link's loop. The tasks are run in order, so the data from consecutive calls stays in order:
+	m_NumQueuedBytes += a_Length;
+	cNetworkSingleton::Get().RunOnEventLoop(m_EventLoop, [Self = shared_from_this(), Data = AString(static_cast<const char *>(a_Data), a_Length)]()
+		{
+			Self->m_NumQueuedBytes -= Data.size();
+			Self->SendNow(Data.data(), Data.size());
+		}
+	);
+	return true;
+}
+
+
+
+
+
+bool cTCPLinkImpl::SendNow(const void * a_Data, size_t a_Length)
 {
 	if (m_ShouldShutdown)
 	{
@@ -176,9 +203,9 @@ bool cTCPLinkImpl::Send(const void * a_Data, size_t a_Length)
 	}
 
 	// If running in TLS mode, push the data into the TLS context instead:
-	if (m_TlsContext != nullptr)
+	if (auto TlsContext = m_TlsContext; TlsContext != nullptr)
 	{
-		m_TlsContext->Send(a_Data, a_Length);
+		TlsContext->Send(a_Data, a_Length);
 		return true;
 	}
 
@@ -190,7 +217,37 @@ bool cTCPLinkImpl::Send(const void * a_Data, size_t a_Length)
 
 
 
+size_t cTCPLinkImpl::GetOutgoingDataSize(void) const
+{
+	// The bufferevent is thread-safe, so is its output evbuffer:
+	return m_NumQueuedBytes + evbuffer_get_length(bufferevent_get_output(m_BufferEvent));
+}
+
+
+
+
+
 void cTCPLinkImpl::Shutdown(void)
+{
+	if (cNetworkSingleton::IsInEventLoop(m_EventLoop))
+	{
+		ShutdownNow();
+		return;
+	}
+
+	// Queued after any data sent before, so that the data still gets out:
+	cNetworkSingleton::Get().RunOnEventLoop(m_EventLoop, [Self = shared_from_this()]()
+		{
+			Self->ShutdownNow();
+		}
+	);
+}
+
+
+
+
+
+void cTCPLinkImpl::ShutdownNow(void)
 {
 	// If running in TLS mode, notify the TLS layer:
 	if (m_TlsContext != nullptr)
@@ -216,6 +273,25 @@ void cTCPLinkImpl::Shutdown(void)
 
 
 void cTCPLinkImpl::Close(void)
+{
+	if (cNetworkSingleton::IsInEventLoop(m_EventLoop))
+	{
+		CloseNow();
+		return;
+	}
+
+	cNetworkSingleton::Get().RunOnEventLoop(m_EventLoop, [Self = shared_from_this()]()
+		{
+			Self->CloseNow();
+		}
+	);
+}
+
+
+
+
+
+void cTCPLinkImpl::CloseNow(void)
 {
 	// If running in TLS mode, notify the TLS layer:
 	if (m_TlsContext != nullptr)
@@ -229,7 +305,7 @@ void cTCPLinkImpl::Close(void)
 	bufferevent_disable(m_BufferEvent, EV_READ | EV_WRITE);
 	if (m_Server == nullptr)
 	{
-		cNetworkSingleton::Get().RemoveLink(this);
+		cNetworkSingleton::Get().RemoveLink(this, m_EventLoop);
 	}
 	else
 	{
@@ -411,7 +487,7 @@ void cTCPLinkImpl::EventCallback(bufferevent * a_BufferEvent, short a_What, void
 			Self->m_Callbacks->OnError(err, evutil_socket_error_to_string(err));
 			if (Self->m_Server == nullptr)
 			{
-				cNetworkSingleton::Get().RemoveLink(Self.get());
+				cNetworkSingleton::Get().RemoveLink(Self.get(), Self->m_EventLoop);
 			}
 			else
 			{
@@ -453,7 +529,7 @@ void cTCPLinkImpl::EventCallback(bufferevent * a_BufferEvent, short a_What, void
 		}
 		else
 		{
-			cNetworkSingleton::Get().RemoveLink(Self.get());
+			cNetworkSingleton::Get().RemoveLink(Self.get(), Self->m_EventLoop);
 		}
 		Self->m_Self.reset();
 		return;
@@ -594,6 +670,7 @@ void cTCPLinkImpl::cLinkTlsContext::StoreReceivedData(const char * a_Data, size_
 {
 	// Hold self alive for the duration of this function
 	cLinkTlsContextPtr Self(m_Self);
+	cCSLock Lock(m_CS);
 
 	m_EncryptedData.append(a_Data, a_NumBytes);
 
@@ -663,6 +740,7 @@ void cTCPLinkImpl::cLinkTlsContext::Send(const void * a_Data, size_t a_Length)
 {
 	// Hold self alive for the duration of this function
 	cLinkTlsContextPtr Self(m_Self);
+	cCSLock Lock(m_CS);
 
 	// If the handshake hasn't completed yet, queue the data:
 	if (!HasHandshaken())
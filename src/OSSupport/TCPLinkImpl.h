@@ -12,6 +12,7 @@
 #pragma once
 
 #include "Network.h"
+#include "NetworkSingleton.h"
 #include <event2/event.h>
 #include <event2/bufferevent.h>
 #include "../mbedTLS++/SslContext.h"
@@ -32,7 +33,8 @@ typedef std::vector<cTCPLinkImplPtr> cTCPLinkImplPtrs;
 
 
 class cTCPLinkImpl:
-	public cTCPLink
+	public cTCPLink,
+	public std::enable_shared_from_this<cTCPLinkImpl>
 {
 	using Super = cTCPLink;
 
@@ -65,8 +67,14 @@ public:
 	The a_Self parameter is used so that the socket can keep itself alive as long as the callbacks are coming. */
 	void Enable(cTCPLinkImplPtr a_Self);
 
-	// cTCPLink overrides:
+	/** Returns the LibEvent loop handling this link's callbacks.
+	Use cNetworkSingleton::RunOnEventLoop() to run code on that loop's thread. */
+	const cNetworkSingleton::cEventLoopPtr & GetEventLoop(void) const { return m_EventLoop; }
+
+	// cTCPLink overrides, these may be called from any thread. The ones changing the link's state
+	// are run on the link's loop, so that they don't race with the callbacks:
 	virtual bool Send(const void * a_Data, size_t a_Length) override;
+	virtual size_t GetOutgoingDataSize(void) const override;
 	virtual AString GetLocalIP(void) const override { return m_LocalIP; }
 	virtual UInt16 GetLocalPort(void) const override { return m_LocalPort; }
 	virtual AString GetRemoteIP(void) const override { return m_RemoteIP; }
@@ -106,6 +114,10 @@ protected:
 		/** Shared ownership of self, so that this object can keep itself alive for as long as it needs. */
 		cLinkTlsContextWPtr m_Self;
 
+		/** Serializes the access to the SSL context between the link's event loop, which pushes the received data,
+		and the threads that send data over the link. */
+		cCriticalSection m_CS;
+
 	public:
 		cLinkTlsContext(cTCPLinkImpl & a_Link);
 
@@ -145,6 +157,12 @@ protected:
 	May be NULL if not used. Only used for outgoing connections (cNetwork::Connect()). */
 	cNetwork::cConnectCallbacksPtr m_ConnectCallbacks;
 
+	/** The LibEvent loop that handles this connection's events. */
+	cNetworkSingleton::cEventLoopPtr m_EventLoop;
+
+	/** Number of bytes given to Send() by other threads, still waiting for the loop to push them into the bufferevent. */
+	std::atomic<size_t> m_NumQueuedBytes;
+
 	/** The LibEvent handle representing this connection. */
 	bufferevent * m_BufferEvent;
 
@@ -213,6 +231,11 @@ protected:
 	/** Sends the data directly to the socket (without the optional TLS). */
 	bool SendRaw(const void * a_Data, size_t a_Length);
 
+	/** Implements Send(), Shutdown() and Close(), once running on the link's loop. */
+	bool SendNow(const void * a_Data, size_t a_Length);
+	void ShutdownNow(void);
+	void CloseNow(void);
+
 	/** Called by the TLS when it has decoded a piece of incoming cleartext data from the socket. */
 	void ReceivedCleartextData(const char * a_Data, size_t a_Length);
 };
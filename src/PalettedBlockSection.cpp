@@ -0,0 +1,360 @@
+
+// PalettedBlockSection.cpp
+
+// Implements the PalettedBlockSection class that stores the block types and metas of a single chunk section compactly
+
+#include "Globals.h"
+#include "PalettedBlockSection.h"
+
+
+
+
+
+namespace
+{
+	/** Unpacks the states of the whole section into the block types and metas, a word at a time and two blocks per step,
+	so that each meta byte is written whole. The width is fixed at compile time, so that the shifts and masks are constants.
+	a_Palette is nullptr for the direct states. */
+	template <unsigned Bits>
+	void UnpackStates(const std::vector<UInt64> & a_Data, const PalettedBlockSection::State * a_Palette, BLOCKTYPE * a_Blocks, NIBBLETYPE * a_Metas)
+	{
+		static_assert((64 / Bits) % 2 == 0, "Each word must hold an even number of blocks");
+		constexpr UInt64 Mask = (UInt64(1) << Bits) - 1;
+		size_t Index = 0;
+		for (const auto Word: a_Data)
+		{
+			for (unsigned Shift = 0; Shift < 64; Shift += 2 * Bits, Index += 2)
+			{
+				auto State1 = static_cast<PalettedBlockSection::State>((Word >> Shift) & Mask);
+				auto State2 = static_cast<PalettedBlockSection::State>((Word >> (Shift + Bits)) & Mask);
+				if (a_Palette != nullptr)
+				{
+					State1 = a_Palette[State1];
+					State2 = a_Palette[State2];
+				}
+				a_Blocks[Index] = static_cast<BLOCKTYPE>(State1 >> 4);
+				a_Blocks[Index + 1] = static_cast<BLOCKTYPE>(State2 >> 4);
+				a_Metas[Index / 2] = static_cast<NIBBLETYPE>((State1 & 0x0f) | ((State2 & 0x0f) << 4));
+			}
+		}
+	}
+
+
+
+
+
+	/** Returns true if all the values packed in a_Data are below a_NumValues. The width is fixed at compile time, see UnpackStates(). */
+	template <unsigned Bits>
+	bool AreValuesBelow(const std::vector<UInt64> & a_Data, const size_t a_NumValues)
+	{
+		constexpr UInt64 Mask = (UInt64(1) << Bits) - 1;
+		const auto NumValues = static_cast<UInt64>(a_NumValues);
+		bool IsAnyTooLarge = false;
+		for (const auto Word: a_Data)
+		{
+			for (unsigned Shift = 0; Shift < 64; Shift += Bits)
+			{
+				IsAnyTooLarge |= (((Word >> Shift) & Mask) >= NumValues);
+			}
+		}
+		return !IsAnyTooLarge;
+	}
+}
+
+
+
+
+
+PalettedBlockSection::PalettedBlockSection(const State a_Fill):
+	m_Palette{ a_Fill },
+	m_BitsPerEntry(0),
+	m_WordShift(0),
+	m_IndexMask(0),
+	m_ValueMask(0)
+{
+	static_assert(MakeState(0xff, 0x0f) < NUM_STATES, "The states must fit the lookup tables");
+	ASSERT(a_Fill < NUM_STATES);
+}
+
+
+
+
+
+void PalettedBlockSection::Set(const size_t a_Index, const State a_State)
+{
+	ASSERT(a_Index < EntryCount);
+	ASSERT(a_State < NUM_STATES);
+
+	if (IsDirect())
+	{
+		SetValue(a_Index, a_State);
+		return;
+	}
+
+	const auto Itr = std::find(m_Palette.begin(), m_Palette.end(), a_State);
+	const auto PaletteIndex = static_cast<State>(Itr - m_Palette.begin());
+	if (Itr != m_Palette.end())
+	{
+		if (m_BitsPerEntry != 0)
+		{
+			SetValue(a_Index, PaletteIndex);
+		}
+		return;
+	}
+
+	if (m_Palette.size() < (size_t(1) << m_BitsPerEntry))
+	{
+		// There's a free index at the current width:
+		m_Palette.push_back(a_State);
+		SetValue(a_Index, PaletteIndex);
+		return;
+	}
+
+	// The new state doesn't fit, re-encode the section; this also drops the states no longer used:
+	std::array<State, EntryCount> States;
+	GetAll(States);
+	States[a_Index] = a_State;
+	Encode(States);
+}
+
+
+
+
+
+void PalettedBlockSection::SetAll(const BLOCKTYPE * const a_Blocks, const NIBBLETYPE * const a_Metas)
+{
+	std::array<State, EntryCount> States;
+	for (size_t i = 0; i < EntryCount; i++)
+	{
+		const auto BlockType = (a_Blocks == nullptr) ? ChunkBlockData::DefaultValue : a_Blocks[i];
+		const auto Meta = (a_Metas == nullptr) ? ChunkBlockData::DefaultMetaValue : cChunkDef::ExpandNibble(a_Metas, i);
+		States[i] = MakeState(BlockType, Meta);
+	}
+	Encode(States);
+}
+
+
+
+
+
+void PalettedBlockSection::CopyTo(BLOCKTYPE * const a_Blocks, NIBBLETYPE * const a_Metas) const
+{
+	if (m_BitsPerEntry == 0)
+	{
+		const auto Meta = static_cast<NIBBLETYPE>(m_Palette[0] & 0x0f);
+		std::fill_n(a_Blocks, EntryCount, static_cast<BLOCKTYPE>(m_Palette[0] >> 4));
+		std::fill_n(a_Metas, EntryCount / 2, static_cast<NIBBLETYPE>(Meta | (Meta << 4)));
+		return;
+	}
+
+	const auto Palette = IsDirect() ? nullptr : m_Palette.data();
+	switch (m_BitsPerEntry)
+	{
+		case 1:  UnpackStates<1>(m_Data, Palette, a_Blocks, a_Metas); return;
+		case 2:  UnpackStates<2>(m_Data, Palette, a_Blocks, a_Metas); return;
+		case 4:  UnpackStates<4>(m_Data, Palette, a_Blocks, a_Metas); return;
+		case 8:  UnpackStates<8>(m_Data, Palette, a_Blocks, a_Metas); return;
+		case 16: UnpackStates<16>(m_Data, Palette, a_Blocks, a_Metas); return;
+	}
+	UNREACHABLE("Unsupported width");
+}
+
+
+
+
+
+bool PalettedBlockSection::Load(const unsigned a_BitsPerEntry, std::vector<State> a_Palette, std::vector<UInt64> a_Data)
+{
+	// The direct states come without a palette, a palette must be indexed by the smallest width that fits it:
+	const bool IsDirectData = (a_BitsPerEntry == DIRECT_BITS) && a_Palette.empty();
+	if (
+		!IsDirectData &&
+		(a_Palette.empty() || (a_Palette.size() > (size_t(1) << MAX_PALETTE_BITS)) || (a_BitsPerEntry != BitsForPaletteSize(a_Palette.size())))
+	)
+	{
+		return false;
+	}
+	if (
+		(a_Data.size() != EntryCount * a_BitsPerEntry / 64) ||
+		std::any_of(a_Palette.begin(), a_Palette.end(), [](const State a_State) { return a_State >= NUM_STATES; })
+	)
+	{
+		return false;
+	}
+
+	// Each value must be an index into the palette, or a state; unless all the values of the width are:
+	const size_t NumValues = IsDirectData ? NUM_STATES : a_Palette.size();
+	const UInt64 ValueMask = (a_BitsPerEntry == 0) ? 0 : ((UInt64(1) << a_BitsPerEntry) - 1);
+	if (NumValues <= ValueMask)
+	{
+		bool AreValid = false;
+		switch (a_BitsPerEntry)
+		{
+			case 1:  AreValid = AreValuesBelow<1>(a_Data, NumValues); break;
+			case 2:  AreValid = AreValuesBelow<2>(a_Data, NumValues); break;
+			case 4:  AreValid = AreValuesBelow<4>(a_Data, NumValues); break;
+			case 8:  AreValid = AreValuesBelow<8>(a_Data, NumValues); break;
+			case 16: AreValid = AreValuesBelow<16>(a_Data, NumValues); break;
+		}
+		if (!AreValid)
+		{
+			return false;
+		}
+	}
+
+	SetBitsPerEntry(a_BitsPerEntry);
+	m_Palette = std::move(a_Palette);
+	m_Data = std::move(a_Data);
+	return true;
+}
+
+
+
+
+
+void PalettedBlockSection::Compact(void)
+{
+	if (m_BitsPerEntry == 0)
+	{
+		return;
+	}
+
+	std::array<State, EntryCount> States;
+	GetAll(States);
+	Encode(States);
+}
+
+
+
+
+
+size_t PalettedBlockSection::GetMemoryUsage(void) const
+{
+	return sizeof(*this) + m_Palette.capacity() * sizeof(State) + m_Data.capacity() * sizeof(UInt64);
+}
+
+
+
+
+
+void PalettedBlockSection::SetValue(const size_t a_Index, const State a_Value)
+{
+	ASSERT(m_BitsPerEntry != 0);
+	ASSERT(a_Value <= m_ValueMask);
+
+	const auto Shift = (a_Index & m_IndexMask) * m_BitsPerEntry;
+	auto & Word = m_Data[a_Index >> m_WordShift];
+	Word = (Word & ~(m_ValueMask << Shift)) | (static_cast<UInt64>(a_Value) << Shift);
+}
+
+
+
+
+
+void PalettedBlockSection::GetAll(std::array<State, EntryCount> & a_States) const
+{
+	if (m_BitsPerEntry == 0)
+	{
+		a_States.fill(m_Palette[0]);
+		return;
+	}
+
+	for (size_t i = 0; i < EntryCount; i++)
+	{
+		a_States[i] = Get(i);
+	}
+}
+
+
+
+
+
+void PalettedBlockSection::Encode(const std::array<State, EntryCount> & a_States)
+{
+	// Collect the palette, in the order of the first use; remember each state's index:
+	std::array<State, NUM_STATES> Indices;
+	std::array<bool, NUM_STATES> IsUsed{};
+	m_Palette.clear();
+	for (const auto BlockState: a_States)
+	{
+		if (!IsUsed[BlockState])
+		{
+			IsUsed[BlockState] = true;
+			Indices[BlockState] = static_cast<State>(m_Palette.size());
+			m_Palette.push_back(BlockState);
+		}
+	}
+
+	SetBitsPerEntry(BitsForPaletteSize(m_Palette.size()));
+	if (m_BitsPerEntry == 0)
+	{
+		m_Palette = std::vector<State>{ m_Palette[0] };
+		return;
+	}
+
+	// Pack a whole word at a time:
+	const bool IsDirectData = IsDirect();
+	if (IsDirectData)
+	{
+		m_Palette = std::vector<State>();
+	}
+	m_Data.resize(EntryCount * m_BitsPerEntry / 64);
+	size_t Index = 0;
+	for (auto & Word: m_Data)
+	{
+		Word = 0;
+		for (unsigned Shift = 0; Shift < 64; Shift += m_BitsPerEntry, Index++)
+		{
+			const auto Value = IsDirectData ? a_States[Index] : Indices[a_States[Index]];
+			Word |= static_cast<UInt64>(Value) << Shift;
+		}
+	}
+	m_Data.shrink_to_fit();
+}
+
+
+
+
+
+void PalettedBlockSection::SetBitsPerEntry(const unsigned a_BitsPerEntry)
+{
+	m_BitsPerEntry = a_BitsPerEntry;
+	if (a_BitsPerEntry == 0)
+	{
+		// Release the memory, rather than only clearing:
+		m_Data = std::vector<UInt64>();
+		return;
+	}
+
+	ASSERT((a_BitsPerEntry <= 64) && ((a_BitsPerEntry & (a_BitsPerEntry - 1)) == 0));  // Power of two
+
+	// log2(64 / Bits), the widths are powers of two:
+	unsigned EntriesPerWordLog2 = 6;
+	for (auto Bits = a_BitsPerEntry; Bits > 1; Bits >>= 1)
+	{
+		EntriesPerWordLog2 -= 1;
+	}
+	m_WordShift = EntriesPerWordLog2;
+	m_IndexMask = (size_t(1) << EntriesPerWordLog2) - 1;
+	m_ValueMask = (UInt64(1) << a_BitsPerEntry) - 1;
+}
+
+
+
+
+
+unsigned PalettedBlockSection::BitsForPaletteSize(const size_t a_PaletteSize)
+{
+	ASSERT(a_PaletteSize > 0);
+	if (a_PaletteSize > (size_t(1) << MAX_PALETTE_BITS))
+	{
+		return DIRECT_BITS;
+	}
+
+	unsigned Bits = 0;
+	while ((size_t(1) << Bits) < a_PaletteSize)
+	{
+		Bits = (Bits == 0) ? 1 : Bits * 2;
+	}
+	return Bits;
+}
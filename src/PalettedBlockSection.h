@@ -0,0 +1,142 @@
+
+// PalettedBlockSection.h
+
+// Declares the PalettedBlockSection class that stores the block types and metas of a single chunk section compactly
+
+/*
+Most sections hold only a handful of different blocks, yet the flat layout of ChunkBlockData costs 6 KiB for each
+section no matter how uniform it is. This class stores the section as indices into a local palette of the
+(blocktype, meta) states present in it:
+	- a uniform section is just its single state, no index data at all;
+	- otherwise each block takes 1, 2, 4 or 8 bits, the smallest width that fits the palette size;
+	- a section with more than 256 different states stores the states themselves, 16 bits per block.
+The widths are powers of two so that an index never straddles two words and the lookup is a shift and a mask.
+The width grows automatically when Set() adds a state that doesn't fit; the states that are no longer used stay in
+the palette until Compact() is called or the section is re-encoded for a new state.
+The indices are laid out like the indirect palettes of the protocol: 64-bit words, the first block in the lowest bits.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkData.h"
+
+
+
+
+
+class PalettedBlockSection
+{
+public:
+
+	/** A single block: the blocktype in the upper 8 bits, the meta in the lower 4 bits. */
+	using State = UInt16;
+
+	static constexpr size_t EntryCount = ChunkBlockData::SectionBlockCount;
+
+	/** Creates a uniform section filled with the specified state. */
+	explicit PalettedBlockSection(State a_Fill = 0);
+
+	static constexpr State MakeState(BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta)
+	{
+		return static_cast<State>((a_BlockType << 4) | (a_Meta & 0x0f));
+	}
+
+	/** Returns the state of the block at the specified index, as given by cChunkDef::MakeIndex() within the section. */
+	State Get(size_t a_Index) const
+	{
+		ASSERT(a_Index < EntryCount);
+		if (m_BitsPerEntry == 0)
+		{
+			return m_Palette[0];
+		}
+		const auto Value = GetValue(a_Index);
+		return IsDirect() ? Value : m_Palette[Value];
+	}
+
+	BLOCKTYPE GetBlock(size_t a_Index) const { return static_cast<BLOCKTYPE>(Get(a_Index) >> 4); }
+	NIBBLETYPE GetMeta(size_t a_Index) const { return static_cast<NIBBLETYPE>(Get(a_Index) & 0x0f); }
+
+	/** Sets the state of the block at the specified index, widening the indices if the state is new and doesn't fit. */
+	void Set(size_t a_Index, State a_State);
+
+	void SetBlock(size_t a_Index, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta) { Set(a_Index, MakeState(a_BlockType, a_Meta)); }
+
+	/** Replaces the whole section with the data from the flat arrays, laid out as the sections of ChunkBlockData.
+	Either array may be nullptr, for a section not allocated there. The result is compact. */
+	void SetAll(const BLOCKTYPE * a_Blocks, const NIBBLETYPE * a_Metas);
+
+	/** Writes the whole section into the flat arrays, laid out as the sections of ChunkBlockData. */
+	void CopyTo(BLOCKTYPE * a_Blocks, NIBBLETYPE * a_Metas) const;
+
+	/** Replaces the whole section with the width, palette and data of a compact section, as returned by
+	GetBitsPerEntry(), GetPalette() and GetData(), such as when read back from a file.
+	Returns false, leaving the section unchanged, if they don't make up a valid section of the smallest width. */
+	bool Load(unsigned a_BitsPerEntry, std::vector<State> a_Palette, std::vector<UInt64> a_Data);
+
+	/** Drops the palette entries that are no longer used and narrows the indices accordingly. */
+	void Compact(void);
+
+	/** Returns the number of bits per block: 0 for a uniform section, 1 - 8 for a paletted one, 16 for the direct states. */
+	unsigned GetBitsPerEntry(void) const { return m_BitsPerEntry; }
+
+	/** Returns true if the indices are the states themselves, rather than indices into the palette. */
+	bool IsDirect(void) const { return m_BitsPerEntry > MAX_PALETTE_BITS; }
+
+	/** Returns the states the indices refer to. Empty in the direct mode; may contain unused states until Compact(). */
+	const std::vector<State> & GetPalette(void) const { return m_Palette; }
+
+	/** Returns the packed indices; empty for a uniform section. */
+	const std::vector<UInt64> & GetData(void) const { return m_Data; }
+
+	/** Returns the number of bytes the section takes, including the heap allocations. */
+	size_t GetMemoryUsage(void) const;
+
+private:
+
+	/** The widest indices into a palette; wider sections store the states directly. */
+	static constexpr unsigned MAX_PALETTE_BITS = 8;
+
+	/** The width of the direct states. */
+	static constexpr unsigned DIRECT_BITS = 16;
+
+	/** The number of different states there can be, 256 blocktypes times 16 metas. */
+	static constexpr size_t NUM_STATES = 4096;
+
+	std::vector<State> m_Palette;
+
+	std::vector<UInt64> m_Data;
+
+	unsigned m_BitsPerEntry;
+
+	/** Precomputed from m_BitsPerEntry for the lookup: log2 of the entries per word, the mask of an entry's position
+	within the word, and the mask of a single entry's bits. */
+	unsigned m_WordShift;
+	size_t m_IndexMask;
+	UInt64 m_ValueMask;
+
+
+	/** Returns the raw value, index or state, stored at the specified index. Must not be called for a uniform section. */
+	State GetValue(size_t a_Index) const
+	{
+		return static_cast<State>((m_Data[a_Index >> m_WordShift] >> ((a_Index & m_IndexMask) * m_BitsPerEntry)) & m_ValueMask);
+	}
+
+	/** Stores the raw value at the specified index. Must not be called for a uniform section. */
+	void SetValue(size_t a_Index, State a_Value);
+
+	/** Writes the states of all the blocks into a_States. */
+	void GetAll(std::array<State, EntryCount> & a_States) const;
+
+	/** Re-encodes the whole section from the specified states, with the smallest width that fits them. */
+	void Encode(const std::array<State, EntryCount> & a_States);
+
+	/** Updates the precomputed lookup values for the specified width; releases m_Data for width 0, otherwise the caller fills it. */
+	void SetBitsPerEntry(unsigned a_BitsPerEntry);
+
+	/** Returns the smallest width that fits the specified number of states. */
+	static unsigned BitsForPaletteSize(size_t a_PaletteSize);
+};
@@ -0,0 +1,486 @@
+// Profiler.cpp
+
+// Implements the cProfiler class that collects timed scopes from the server threads
+
+#include "Globals.h"
+#include "Profiler.h"
+#include "JsonUtils.h"
+#include "OSSupport/IsThread.h"
+#include "json/json.h"
+
+
+
+
+
+namespace
+{
+	/** Number of events kept per thread. At the usual ~15 scopes per world tick, this covers almost a minute of ticking. */
+	constexpr size_t RING_BUFFER_SIZE = 16384;
+
+	/** Minimum time between two slow tick captures, so that a lagging server doesn't flood the disk with traces. */
+	constexpr auto SLOW_TICK_SAVE_INTERVAL = std::chrono::seconds(10);
+
+	/** How much history is stored in a slow tick capture. */
+	constexpr auto SLOW_TICK_TRACE_PERIOD = std::chrono::seconds(2);
+
+
+
+
+
+	/** A single recorded scope.
+	The members are atomic only so that a reader racing with the owner thread doesn't invoke UB;
+	torn slots are detected through sThreadBuffer::m_NumWritten and discarded. */
+	struct sEventSlot
+	{
+		std::atomic<const char *> m_Name { nullptr };
+		std::atomic<Int64> m_Start { 0 };     // Nanoseconds since the clock epoch
+		std::atomic<Int64> m_Duration { 0 };  // Nanoseconds
+	};
+
+
+
+
+
+	/** A copy of a single recorded scope, as read out of a ring buffer. */
+	struct sEvent
+	{
+		const char * m_Name;
+		Int64 m_Start;
+		Int64 m_Duration;
+	};
+
+
+
+
+
+	/** The ring buffer owned by a single thread. */
+	struct sThreadBuffer
+	{
+		/** ID of the thread used in the exported trace. */
+		int m_ThreadID;
+
+		/** Total number of events ever written. Only the owner thread writes this. */
+		std::atomic<UInt64> m_NumWritten { 0 };
+
+		std::array<sEventSlot, RING_BUFFER_SIZE> m_Slots;
+
+		sThreadBuffer(int a_ThreadID):
+			m_ThreadID(a_ThreadID)
+		{
+		}
+
+		/** Appends the event. Must only be called from the owner thread. */
+		void Add(const char * a_Name, Int64 a_Start, Int64 a_Duration)
+		{
+			auto Index = m_NumWritten.load(std::memory_order_relaxed);
+			auto & Slot = m_Slots[Index % RING_BUFFER_SIZE];
+			Slot.m_Name.store(a_Name, std::memory_order_relaxed);
+			Slot.m_Start.store(a_Start, std::memory_order_relaxed);
+			Slot.m_Duration.store(a_Duration, std::memory_order_relaxed);
+			m_NumWritten.store(Index + 1, std::memory_order_release);
+		}
+
+		/** Appends all the events that ended at or after a_MinEnd into a_Events.
+		Safe to call from any thread. */
+		void CopyEvents(Int64 a_MinEnd, std::vector<sEvent> & a_Events) const
+		{
+			auto End = m_NumWritten.load(std::memory_order_acquire);
+			auto Begin = (End > RING_BUFFER_SIZE) ? (End - RING_BUFFER_SIZE) : 0;
+			std::vector<sEvent> Copied;
+			Copied.reserve(static_cast<size_t>(End - Begin));
+			for (auto i = Begin; i < End; i++)
+			{
+				const auto & Slot = m_Slots[i % RING_BUFFER_SIZE];
+				Copied.push_back({
+					Slot.m_Name.load(std::memory_order_relaxed),
+					Slot.m_Start.load(std::memory_order_relaxed),
+					Slot.m_Duration.load(std::memory_order_relaxed)
+				});
+			}
+
+			// Discard the slots that the owner may have overwritten while we were copying. The owner may also be
+			// in the middle of writing the event number EndAfter, which shares its slot with EndAfter - RING_BUFFER_SIZE:
+			std::atomic_thread_fence(std::memory_order_acquire);
+			auto EndAfter = m_NumWritten.load(std::memory_order_relaxed);
+			auto FirstValid = (EndAfter >= RING_BUFFER_SIZE) ? (EndAfter - RING_BUFFER_SIZE + 1) : 0;
+			for (auto i = std::max(Begin, FirstValid); i < End; i++)
+			{
+				const auto & Event = Copied[static_cast<size_t>(i - Begin)];
+				if ((Event.m_Name != nullptr) && (Event.m_Start + Event.m_Duration >= a_MinEnd))
+				{
+					a_Events.push_back(Event);
+				}
+			}
+		}
+	};
+
+
+
+
+
+	/** All the thread buffers ever created, with their thread names.
+	Buffers are kept after their thread exits so that its events can still be exported. */
+	struct sRegistry
+	{
+		cCriticalSection m_CS;
+		std::vector<std::pair<std::shared_ptr<sThreadBuffer>, AString>> m_Buffers;
+	};
+
+
+
+
+
+	sRegistry & GetRegistry()
+	{
+		static sRegistry Registry;
+		return Registry;
+	}
+
+
+
+
+
+	std::atomic<Int64> g_SlowTickThreshold { 0 };  // Milliseconds, 0 = disabled
+	std::atomic<Int64> g_LastSlowTickSave { 0 };  // Nanoseconds since the clock epoch, 0 = never saved
+
+
+
+
+
+	Int64 ToNanoseconds(cProfiler::clock::time_point a_Time)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(a_Time.time_since_epoch()).count();
+	}
+
+
+
+
+
+	/** Returns the calling thread's buffer, creating and registering it on first use. */
+	sThreadBuffer & GetThreadBuffer()
+	{
+		thread_local std::shared_ptr<sThreadBuffer> Buffer;
+		if (Buffer == nullptr)
+		{
+			auto & Registry = GetRegistry();
+			cCSLock Lock(Registry.m_CS);
+			Buffer = std::make_shared<sThreadBuffer>(static_cast<int>(Registry.m_Buffers.size()) + 1);
+			Registry.m_Buffers.emplace_back(Buffer, fmt::format(FMT_STRING("Thread {}"), Buffer->m_ThreadID));
+		}
+		return *Buffer;
+	}
+
+
+
+
+
+	/** The events of a single thread, copied out of its ring buffer. */
+	struct sThreadEvents
+	{
+		int m_ThreadID;
+		AString m_ThreadName;
+		std::vector<sEvent> m_Events;
+	};
+
+	using cSnapshot = std::vector<sThreadEvents>;
+
+
+
+
+
+	/** Copies the events of all the threads that ended at or after a_MinEnd. */
+	cSnapshot TakeSnapshot(Int64 a_MinEnd)
+	{
+		// Snapshot the list of buffers, so that the threads may register new ones while we're copying:
+		std::vector<std::pair<std::shared_ptr<sThreadBuffer>, AString>> Buffers;
+		{
+			auto & Registry = GetRegistry();
+			cCSLock Lock(Registry.m_CS);
+			Buffers = Registry.m_Buffers;
+		}
+
+		cSnapshot Snapshot;
+		Snapshot.reserve(Buffers.size());
+		for (const auto & Buffer : Buffers)
+		{
+			Snapshot.push_back({ Buffer.first->m_ThreadID, Buffer.second, {} });
+			Buffer.first->CopyEvents(a_MinEnd, Snapshot.back().m_Events);
+		}
+		return Snapshot;
+	}
+
+
+
+
+
+	/** Returns the Chrome trace JSON of the snapshot. */
+	AString ToChromeTrace(const cSnapshot & a_Snapshot)
+	{
+		Json::Value TraceEvents(Json::arrayValue);
+		for (const auto & Thread : a_Snapshot)
+		{
+			Json::Value Meta;
+			Meta["name"] = "thread_name";
+			Meta["ph"] = "M";
+			Meta["pid"] = 1;
+			Meta["tid"] = Thread.m_ThreadID;
+			Meta["args"]["name"] = Thread.m_ThreadName;
+			TraceEvents.append(Meta);
+
+			for (const auto & Event : Thread.m_Events)
+			{
+				Json::Value Out;
+				Out["name"] = Event.m_Name;
+				Out["ph"] = "X";
+				Out["pid"] = 1;
+				Out["tid"] = Thread.m_ThreadID;
+				Out["ts"] = static_cast<double>(Event.m_Start) / 1000;  // Microseconds
+				Out["dur"] = static_cast<double>(Event.m_Duration) / 1000;
+				TraceEvents.append(Out);
+			}
+		}
+
+		Json::Value Root;
+		Root["traceEvents"] = TraceEvents;
+		Root["displayTimeUnit"] = "ms";
+		return JsonUtils::WriteFastString(Root);
+	}
+
+
+
+
+
+	/** Writes the string into the file, replacing its contents. Returns true on success. */
+	bool WriteTraceFile(const AString & a_FileName, const AString & a_Trace)
+	{
+		cFile File;
+		if (!File.Open(a_FileName, cFile::fmWrite))
+		{
+			return false;
+		}
+		return (File.Write(a_Trace) == static_cast<int>(a_Trace.size()));
+	}
+
+
+
+
+
+	/** Serializes and writes the slow tick captures on its own thread, so that the lagging tick thread only copies the events. */
+	class cTraceWriter:
+		public cIsThread
+	{
+		using Super = cIsThread;
+
+	public:
+
+		cTraceWriter():
+			Super("Profiler Trace Writer"),
+			m_IsStarted(false)
+		{
+		}
+
+		virtual ~cTraceWriter() override
+		{
+			Finish();
+		}
+
+		/** Queues the snapshot to be written into the file; starts the thread on first use.
+		a_Message is logged once the file is written. */
+		void Queue(AString && a_FileName, cSnapshot && a_Snapshot, AString && a_Message)
+		{
+			{
+				cCSLock Lock(m_CS);
+				m_Queue.push_back({ std::move(a_FileName), std::move(a_Snapshot), std::move(a_Message) });
+				if (!m_IsStarted)
+				{
+					m_IsStarted = true;
+					Start();
+				}
+			}
+			m_QueueNonEmpty.Set();
+		}
+
+		/** Writes the traces still queued and stops the thread. */
+		void Finish(void)
+		{
+			m_ShouldTerminate = true;
+			m_QueueNonEmpty.Set();
+			Stop();
+
+			// Allow restarting, when the server restarts within the same process:
+			cCSLock Lock(m_CS);
+			m_IsStarted = false;
+		}
+
+	protected:
+
+		struct sItem
+		{
+			AString m_FileName;
+			cSnapshot m_Snapshot;
+			AString m_Message;
+		};
+
+		cCriticalSection m_CS;
+		std::vector<sItem> m_Queue;
+		bool m_IsStarted;
+		cEvent m_QueueNonEmpty;
+
+
+		void WriteQueued(void)
+		{
+			std::vector<sItem> Queue;
+			{
+				cCSLock Lock(m_CS);
+				std::swap(Queue, m_Queue);
+			}
+			for (const auto & Item : Queue)
+			{
+				if (WriteTraceFile(Item.m_FileName, ToChromeTrace(Item.m_Snapshot)))
+				{
+					LOGWARNING("%s", Item.m_Message);
+				}
+			}
+		}
+
+		virtual void Execute(void) override
+		{
+			while (!m_ShouldTerminate)
+			{
+				m_QueueNonEmpty.Wait();
+				WriteQueued();
+			}
+			WriteQueued();
+		}
+	};
+
+
+
+
+
+	cTraceWriter & GetTraceWriter()
+	{
+		static cTraceWriter Writer;
+		return Writer;
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cProfiler:
+
+std::atomic<bool> cProfiler::s_IsEnabled { false };
+
+
+
+
+
+void cProfiler::SetEnabled(bool a_IsEnabled)
+{
+	s_IsEnabled.store(a_IsEnabled, std::memory_order_relaxed);
+}
+
+
+
+
+
+void cProfiler::SetSlowTickThreshold(std::chrono::milliseconds a_Threshold)
+{
+	g_SlowTickThreshold.store(a_Threshold.count(), std::memory_order_relaxed);
+}
+
+
+
+
+
+void cProfiler::SetCurrentThreadName(const AString & a_Name)
+{
+	auto & Buffer = GetThreadBuffer();
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	Registry.m_Buffers[static_cast<size_t>(Buffer.m_ThreadID - 1)].second = a_Name;
+}
+
+
+
+
+
+void cProfiler::AddEvent(const char * a_Name, clock::time_point a_Start, clock::time_point a_End)
+{
+	GetThreadBuffer().Add(a_Name, ToNanoseconds(a_Start), std::chrono::duration_cast<std::chrono::nanoseconds>(a_End - a_Start).count());
+}
+
+
+
+
+
+AString cProfiler::GetChromeTrace(std::chrono::milliseconds a_Period)
+{
+	auto MinEnd = ToNanoseconds(clock::now()) - std::chrono::duration_cast<std::chrono::nanoseconds>(a_Period).count();
+	return ToChromeTrace(TakeSnapshot(MinEnd));
+}
+
+
+
+
+
+bool cProfiler::SaveChromeTrace(const AString & a_FileName, std::chrono::milliseconds a_Period)
+{
+	return WriteTraceFile(a_FileName, GetChromeTrace(a_Period));
+}
+
+
+
+
+
+void cProfiler::ReportTickDuration(const AString & a_Source, std::chrono::milliseconds a_TickDuration)
+{
+	auto Threshold = g_SlowTickThreshold.load(std::memory_order_relaxed);
+	if (!IsEnabled() || (Threshold <= 0) || (a_TickDuration.count() < Threshold))
+	{
+		return;
+	}
+
+	// Rate-limit the captures; when several threads lag at once, only one of them saves:
+	auto Now = ToNanoseconds(clock::now());
+	auto LastSave = g_LastSlowTickSave.load(std::memory_order_relaxed);
+	if (
+		((LastSave != 0) && (Now - LastSave < std::chrono::duration_cast<std::chrono::nanoseconds>(SLOW_TICK_SAVE_INTERVAL).count())) ||
+		!g_LastSlowTickSave.compare_exchange_strong(LastSave, Now)
+	)
+	{
+		return;
+	}
+
+	// Keep the file name portable, world names may contain all kinds of characters:
+	AString Source;
+	for (auto ch : a_Source)
+	{
+		Source.push_back(std::isalnum(static_cast<unsigned char>(ch)) ? ch : '_');
+	}
+
+	// Assume creation succeeds, as the API does not provide a way to tell if the folder exists.
+	cFile::CreateFolder("profiles");
+	auto FileName = fmt::format(
+		FMT_STRING("profiles/slowtick_{}_{}.json"),
+		Source,
+		std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+	);
+
+	// Only copy the events here, the lagging tick thread shouldn't serialize nor write them:
+	auto MinEnd = Now - std::chrono::duration_cast<std::chrono::nanoseconds>(SLOW_TICK_TRACE_PERIOD).count();
+	auto Message = fmt::format(FMT_STRING("{}: tick took {} ms, saved the profile to {}"), a_Source, a_TickDuration.count(), FileName);
+	GetTraceWriter().Queue(std::move(FileName), TakeSnapshot(MinEnd), std::move(Message));
+}
+
+
+
+
+
+void cProfiler::Shutdown(void)
+{
+	GetTraceWriter().Finish();
+}
@@ -0,0 +1,109 @@
+// Profiler.h
+
+// Declares the cProfiler class that collects timed scopes from the server threads, and the cProfileScope RAII helper
+
+/*
+Each thread that records an event gets its own fixed-size ring buffer. Only the owning thread ever writes into it,
+so recording an event takes no locks; readers (the dump code) copy the buffer and discard the slots that the owner
+overwrote while they were being copied.
+The events are exported in the Chrome trace format (chrome://tracing, Perfetto, speedscope), where nested scopes
+on the same thread are displayed as a hierarchy.
+
+Usage:
+	void cWorld::TickMobs(...)
+	{
+		cProfileScope Profile("cWorld::TickMobs");
+		...
+	}
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cProfiler
+{
+public:
+
+	using clock = std::chrono::steady_clock;
+
+	/** Returns true if the scopes are being recorded. */
+	static bool IsEnabled(void) { return s_IsEnabled.load(std::memory_order_relaxed); }
+
+	/** Enables or disables recording the scopes. */
+	static void SetEnabled(bool a_IsEnabled);
+
+	/** Sets the tick duration above which ReportTickDuration() saves a trace into the "profiles" folder.
+	Zero disables the slow tick capture. */
+	static void SetSlowTickThreshold(std::chrono::milliseconds a_Threshold);
+
+	/** Sets the name under which the calling thread's events are exported. */
+	static void SetCurrentThreadName(const AString & a_Name);
+
+	/** Records a finished scope into the calling thread's ring buffer.
+	a_Name must point to a string that outlives the profiler (a string literal). */
+	static void AddEvent(const char * a_Name, clock::time_point a_Start, clock::time_point a_End);
+
+	/** Returns a Chrome trace JSON of all recorded events that ended within the last a_Period. */
+	static AString GetChromeTrace(std::chrono::milliseconds a_Period);
+
+	/** Writes the events from the last a_Period into the specified file, as a Chrome trace.
+	Returns true on success. */
+	static bool SaveChromeTrace(const AString & a_FileName, std::chrono::milliseconds a_Period);
+
+	/** Called by tick threads after each tick. If the tick took longer than the slow tick threshold,
+	queues the recent events to be saved into the "profiles" folder on a background thread (at most once per several seconds).
+	a_Source is used in the file name to identify the ticking thread. */
+	static void ReportTickDuration(const AString & a_Source, std::chrono::milliseconds a_TickDuration);
+
+	/** Writes the slow tick captures still queued and stops their writer thread. */
+	static void Shutdown(void);
+
+private:
+
+	static std::atomic<bool> s_IsEnabled;
+};
+
+
+
+
+
+/** Records the time between its construction and destruction into cProfiler, when the profiler is enabled. */
+class cProfileScope
+{
+public:
+
+	/** a_Name must point to a string that outlives the profiler (a string literal). */
+	cProfileScope(const char * a_Name):
+		m_Name(a_Name),
+		m_IsEnabled(cProfiler::IsEnabled())
+	{
+		if (m_IsEnabled)
+		{
+			m_Start = cProfiler::clock::now();
+		}
+	}
+
+	~cProfileScope()
+	{
+		if (m_IsEnabled)
+		{
+			cProfiler::AddEvent(m_Name, m_Start, cProfiler::clock::now());
+		}
+	}
+
+	cProfileScope(const cProfileScope &) = delete;
+	cProfileScope & operator = (const cProfileScope &) = delete;
+
+private:
+
+	const char * m_Name;
+	bool m_IsEnabled;
+	cProfiler::clock::time_point m_Start;
+};
@@ -4,10 +4,11 @@
 #include "Protocol/Authenticator.h"
 
 #include "ClientHandle.h"
-#include "HTTP/UrlClient.h"
+#include "HTTP/HTTPClientConnection.h"
 #include "HTTP/UrlParser.h"
 #include "IniFile.h"
 #include "JsonUtils.h"
+#include "Metrics.h"
 #include "json/json.h"
 #include "Protocol/MojangAPI.h"
 #include "Root.h"
@@ -20,16 +21,24 @@
 
 constexpr char DEFAULT_AUTH_SERVER[]  = "sessionserver.mojang.com";
 constexpr char DEFAULT_AUTH_ADDRESS[] = "/session/minecraft/hasJoined?username=%USERNAME%&serverId=%SERVERID%";
+constexpr int  DEFAULT_NUM_WORKERS = 4;
+constexpr int  DEFAULT_REQUEST_TIMEOUT_MSEC = 5000;
+constexpr int  DEFAULT_MAX_RETRIES = 3;
+constexpr int  DEFAULT_RETRY_BACKOFF_MSEC = 250;
 
 
 
 
 
 cAuthenticator::cAuthenticator(void) :
-	Super("Authenticator"),
+	m_ShouldTerminate(false),
 	m_Server(DEFAULT_AUTH_SERVER),
 	m_Address(DEFAULT_AUTH_ADDRESS),
-	m_ShouldAuthenticate(true)
+	m_ShouldAuthenticate(true),
+	m_NumWorkers(DEFAULT_NUM_WORKERS),
+	m_RequestTimeout(DEFAULT_REQUEST_TIMEOUT_MSEC),
+	m_MaxRetries(DEFAULT_MAX_RETRIES),
+	m_RetryBackoff(DEFAULT_RETRY_BACKOFF_MSEC)
 {
 }
 
@@ -51,6 +60,10 @@ void cAuthenticator::ReadSettings(cSettingsRepositoryInterface & a_Settings)
 	m_Server             = a_Settings.GetValueSet ("Authentication", "Server", DEFAULT_AUTH_SERVER);
 	m_Address            = a_Settings.GetValueSet ("Authentication", "Address", DEFAULT_AUTH_ADDRESS);
 	m_ShouldAuthenticate = a_Settings.GetValueSetB("Authentication", "Authenticate", true);
+	m_NumWorkers         = std::clamp(a_Settings.GetValueSetI("Authentication", "MaxConcurrentRequests", DEFAULT_NUM_WORKERS), 1, 64);
+	m_RequestTimeout     = std::chrono::milliseconds(std::max(a_Settings.GetValueSetI("Authentication", "RequestTimeoutMSec", DEFAULT_REQUEST_TIMEOUT_MSEC), 100));
+	m_MaxRetries         = std::max(a_Settings.GetValueSetI("Authentication", "MaxRetries", DEFAULT_MAX_RETRIES), 0);
+	m_RetryBackoff       = std::chrono::milliseconds(std::max(a_Settings.GetValueSetI("Authentication", "RetryBackoffMSec", DEFAULT_RETRY_BACKOFF_MSEC), 0));
 
 	// prepend https:// if missing
 	constexpr std::string_view HttpPrefix = "http://";
@@ -103,7 +116,24 @@ void cAuthenticator::Authenticate(int a_ClientID, const std::string_view a_Usern
 	}
 
 	cCSLock Lock(m_CS);
-	m_Queue.emplace_back(a_ClientID, a_Username, a_ServerHash);
+
+	// If the same user with the same server ID is already being authenticated, only add the client to the request:
+	auto Key = GetPendingKey(AString(a_Username), AString(a_ServerHash));
+	auto itr = m_Pending.find(Key);
+	if (itr != m_Pending.end())
+	{
+		itr->second->m_ClientIDs.push_back(a_ClientID);
+		if (cMetrics::IsEnabled())
+		{
+			static auto & Deduplicated = cMetrics::GetCounter("cuberite_auth_deduplicated_requests", "Number of logins that joined an identical authentication request already pending");
+			Deduplicated.Inc();
+		}
+		return;
+	}
+
+	auto User = std::make_shared<cUser>(a_ClientID, a_Username, a_ServerHash);
+	m_Pending.emplace(std::move(Key), User);
+	m_Queue.push_back(std::move(User));
 	m_QueueNonempty.Set();
 }
 
@@ -114,7 +144,28 @@ void cAuthenticator::Authenticate(int a_ClientID, const std::string_view a_Usern
 void cAuthenticator::Start(cSettingsRepositoryInterface & a_Settings)
 {
 	ReadSettings(a_Settings);
-	Super::Start();
+	m_ShouldTerminate = false;
+
+	// The queue lengths are only read on each scrape:
+	cMetrics::SetCollector("cuberite_auth_queued_requests", "Number of authentication requests waiting for a free worker", [this](std::vector<cMetrics::sSample> & a_Samples)
+	{
+		cCSLock Lock(m_CS);
+		a_Samples.push_back({ AString(), static_cast<double>(m_Queue.size()) });
+	});
+	cMetrics::SetCollector("cuberite_auth_in_flight_requests", "Number of authentication requests being processed by the workers", [this](std::vector<cMetrics::sSample> & a_Samples)
+	{
+		cCSLock Lock(m_CS);
+		a_Samples.push_back({ AString(), static_cast<double>(m_Pending.size() - m_Queue.size()) });
+	});
+
+	for (int i = 0; i < m_NumWorkers; i++)
+	{
+		m_Workers.push_back(std::make_unique<cWorker>(*this));
+	}
+	for (auto & Worker : m_Workers)
+	{
+		Worker->Start();
+	}
 }
 
 
@@ -124,56 +175,124 @@ void cAuthenticator::Start(cSettingsRepositoryInterface & a_Settings)
 void cAuthenticator::Stop(void)
 {
 	m_ShouldTerminate = true;
-	m_QueueNonempty.Set();
-	Super::Stop();
+	m_QueueNonempty.SetAll();
+	for (auto & Worker : m_Workers)
+	{
+		Worker->Stop();
+	}
+	m_Workers.clear();
+
+	cMetrics::RemoveCollector("cuberite_auth_queued_requests");
+	cMetrics::RemoveCollector("cuberite_auth_in_flight_requests");
 }
 
 
 
 
 
-void cAuthenticator::Execute(void)
+AString cAuthenticator::GetPendingKey(const AString & a_Name, const AString & a_ServerID)
 {
-	for (;;)
+	return a_Name + '\n' + a_ServerID;
+}
+
+
+
+
+
+cAuthenticator::cUserPtr cAuthenticator::WaitForRequest(void)
+{
+	cCSLock Lock(m_CS);
+	while (!m_ShouldTerminate && m_Queue.empty())
 	{
-		cCSLock Lock(m_CS);
-		while (!m_ShouldTerminate && (m_Queue.size() == 0))
-		{
-			cCSUnlock Unlock(Lock);
-			m_QueueNonempty.Wait();
-		}
-		if (m_ShouldTerminate)
+		cCSUnlock Unlock(Lock);
+		m_QueueNonempty.Wait();
+	}
+	if (m_ShouldTerminate)
+	{
+		// Wake up the next worker, so that they all terminate:
+		m_QueueNonempty.SetAll();
+		return nullptr;
+	}
+
+	auto User = std::move(m_Queue.front());
+	m_Queue.pop_front();
+	if (!m_Queue.empty())
+	{
+		// Let another worker pick the next request:
+		m_QueueNonempty.Set();
+	}
+	return User;
+}
+
+
+
+
+
+void cAuthenticator::ProcessRequest(cUser & a_User, cHTTPClientConnection & a_Connection)
+{
+	AString Username = a_User.m_Name;
+	cUUID UUID;
+	Json::Value Properties;
+	auto Result = AuthWithYggdrasil(a_Connection, Username, a_User.m_ServerID, UUID, Properties);
+	auto Backoff = m_RetryBackoff;
+	for (int Retry = 0; (Result == eAuthResult::Unavailable) && (Retry < m_MaxRetries) && !m_ShouldTerminate; Retry++)
+	{
+		LOGD("Session server unavailable for user %s, retrying in %d msec", a_User.m_Name.c_str(), static_cast<int>(Backoff.count()));
+		std::this_thread::sleep_for(Backoff);
+		Backoff *= 2;
+		if (cMetrics::IsEnabled())
 		{
-			return;
+			static auto & Retried = cMetrics::GetCounter("cuberite_auth_retried_requests", "Number of requests to the session server resent after a network failure");
+			Retried.Inc();
 		}
-		ASSERT(!m_Queue.empty());
-
-		cAuthenticator::cUser User = std::move(m_Queue.front());
-		int & ClientID = User.m_ClientID;
-		AString & Username = User.m_Name;
-		AString & ServerID = User.m_ServerID;
-		m_Queue.pop_front();
-		Lock.Unlock();
-
-		cUUID UUID;
-		Json::Value Properties;
-		if (AuthWithYggdrasil(Username, ServerID, UUID, Properties))
+		Username = a_User.m_Name;
+		Result = AuthWithYggdrasil(a_Connection, Username, a_User.m_ServerID, UUID, Properties);
+	}
+
+	// Remove the request from the pending ones, from now on no more clients can join it:
+	std::vector<int> ClientIDs;
+	{
+		cCSLock Lock(m_CS);
+		m_Pending.erase(GetPendingKey(a_User.m_Name, a_User.m_ServerID));
+		ClientIDs = a_User.m_ClientIDs;
+	}
+
+	if (cMetrics::IsEnabled())
+	{
+		// From queueing to the result, the login waits for all of it:
+		static auto & Latency = cMetrics::GetHistogram(
+			"cuberite_auth_latency_seconds", "Time from queueing an authentication request to its result",
+			{ 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30 }
+		);
+		Latency.Observe(std::chrono::duration<double>(std::chrono::steady_clock::now() - a_User.m_QueuedAt).count());
+		if (Result != eAuthResult::Success)
 		{
-			LOGINFO("User %s authenticated with UUID %s", Username.c_str(), UUID.ToShortString().c_str());
-			cRoot::Get()->GetServer()->AuthenticateUser(ClientID, std::move(Username), UUID, std::move(Properties));
+			static auto & Failed = cMetrics::GetCounter("cuberite_auth_failed_requests", "Number of authentication requests rejected by the session server or left unanswered");
+			Failed.Inc();
 		}
-		else
+	}
+
+	if (Result != eAuthResult::Success)
+	{
+		for (auto ClientID : ClientIDs)
 		{
 			cRoot::Get()->KickUser(ClientID, "Failed to authenticate account!");
 		}
-	}  // for (-ever)
+		return;
+	}
+
+	LOGINFO("User %s authenticated with UUID %s", Username.c_str(), UUID.ToShortString().c_str());
+	for (auto ClientID : ClientIDs)
+	{
+		cRoot::Get()->GetServer()->AuthenticateUser(ClientID, AString(Username), UUID, Json::Value(Properties));
+	}
 }
 
 
 
 
 
-bool cAuthenticator::AuthWithYggdrasil(AString & a_UserName, const AString & a_ServerId, cUUID & a_UUID, Json::Value & a_Properties) const
+cAuthenticator::eAuthResult cAuthenticator::AuthWithYggdrasil(cHTTPClientConnection & a_Connection, AString & a_UserName, const AString & a_ServerId, cUUID & a_UUID, Json::Value & a_Properties) const
 {
 	LOGD("Trying to authenticate user %s", a_UserName.c_str());
 
@@ -182,36 +301,82 @@ bool cAuthenticator::AuthWithYggdrasil(AString & a_UserName, const AString & a_S
 	ReplaceURL(ActualAddress, "%USERNAME%", a_UserName);
 	ReplaceURL(ActualAddress, "%SERVERID%", a_ServerId);
 
-	// Create and send the HTTP request
-	auto [IsSuccessful, Response] = cUrlClient::BlockingGet(m_Server + ActualAddress);
-	if (!IsSuccessful)
+	// Send the HTTP request over the worker's connection:
+	auto Response = a_Connection.Get(ActualAddress, m_RequestTimeout);
+	if (!Response.m_IsSuccessful)
 	{
-		return false;
+		LOGD("%s: Session server request failed: %s", __FUNCTION__, Response.m_Body.c_str());
+		return eAuthResult::Unavailable;
+	}
+	if ((Response.m_StatusCode >= 500) || (Response.m_StatusCode == 429))
+	{
+		// Server overloaded or rate-limiting us, worth retrying later:
+		return eAuthResult::Unavailable;
 	}
 
 	// Parse the Json response:
-	if (Response.empty())
+	if (Response.m_Body.empty())
 	{
-		return false;
+		return eAuthResult::Rejected;
 	}
 	Json::Value root;
-	if (!JsonUtils::ParseString(Response, root))
+	if (!JsonUtils::ParseString(Response.m_Body, root))
 	{
 		LOGWARNING("%s: Cannot parse received data (authentication) to JSON!", __FUNCTION__);
-		return false;
+		return eAuthResult::Rejected;
 	}
 	a_UserName = root.get("name", "Unknown").asString();
 	a_Properties = root["properties"];
 	if (!a_UUID.FromString(root.get("id", "").asString()))
 	{
 		LOGWARNING("%s: Received invalid UUID format", __FUNCTION__);
-		return false;
+		return eAuthResult::Rejected;
 	}
 
 	// Store the player's profile in the MojangAPI caches:
 	cRoot::Get()->GetMojangAPI().AddPlayerProfile(a_UserName, a_UUID, a_Properties);
 
-	return true;
+	return eAuthResult::Success;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cAuthenticator::cWorker:
+
+cAuthenticator::cWorker::cWorker(cAuthenticator & a_Parent):
+	Super("Authenticator"),
+	m_Parent(a_Parent),
+	m_Connection(std::make_unique<cHTTPClientConnection>(a_Parent.m_Server))
+{
+}
+
+
+
+
+
+cAuthenticator::cWorker::~cWorker()
+{
+	Stop();
+}
+
+
+
+
+
+void cAuthenticator::cWorker::Execute(void)
+{
+	for (;;)
+	{
+		auto User = m_Parent.WaitForRequest();
+		if (User == nullptr)
+		{
+			return;
+		}
+		m_Parent.ProcessRequest(*User, *m_Connection);
+	}
 }
 
 
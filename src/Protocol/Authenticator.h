@@ -1,10 +1,12 @@
 
 // cAuthenticator.h
 
-// Interfaces to the cAuthenticator class representing the thread that authenticates users against the official Mojang servers
+// Interfaces to the cAuthenticator class representing the threads that authenticate users against the official Mojang servers
 // Authentication prevents "hackers" from joining with an arbitrary username (possibly impersonating the server admins)
 // For more info, see http://wiki.vg/Session
-// In Cuberite, authentication is implemented as a single thread that receives queued auth requests and dispatches them one by one.
+// In Cuberite, authentication is implemented as a small pool of worker threads that take the queued auth requests
+// and dispatch them concurrently. Each worker keeps its own keep-alive connection to the session server,
+// so that a login storm (such as after a server restart) doesn't pay for a TLS handshake per player.
 
 
 
@@ -15,6 +17,7 @@
 #include "../OSSupport/IsThread.h"
 
 // fwd:
+class cHTTPClientConnection;
 class cUUID;
 class cSettingsRepositoryInterface;
 
@@ -27,15 +30,12 @@ namespace Json
 
 
 
-class cAuthenticator:
-	public cIsThread
+class cAuthenticator
 {
-	using Super = cIsThread;
-
 public:
 
 	cAuthenticator();
-	virtual ~cAuthenticator() override;
+	~cAuthenticator();
 
 	/** (Re-)read server and address from INI: */
 	void ReadSettings(cSettingsRepositoryInterface & a_Settings);
@@ -43,34 +43,83 @@ public:
 	/** Queues a request for authenticating a user. If the auth fails, the user will be kicked */
 	void Authenticate(int a_ClientID, std::string_view a_Username, std::string_view a_ServerHash);
 
-	/** Starts the authenticator thread. The thread may be started and stopped repeatedly */
+	/** Starts the authenticator threads. The threads may be started and stopped repeatedly */
 	void Start(cSettingsRepositoryInterface & a_Settings);
 
-	/** Stops the authenticator thread. The thread may be started and stopped repeatedly */
+	/** Stops the authenticator threads. The threads may be started and stopped repeatedly */
 	void Stop(void);
 
 private:
 
+	/** The outcome of a single request to the session server. */
+	enum class eAuthResult
+	{
+		Success,      ///< The user is authenticated
+		Rejected,     ///< The server has refused the user, or sent a nonsense reply
+		Unavailable,  ///< The server couldn't be reached or didn't reply in time, the request may be retried
+	};
+
+	/** A single request being authenticated.
+	Identical requests (same name and server ID) share a single instance, all their clients receive the result. */
 	class cUser
 	{
 	public:
-		int     m_ClientID;
+		std::vector<int> m_ClientIDs;
 		AString m_Name;
 		AString m_ServerID;
 
+		/** When the first of the requests was queued, for the latency metric. */
+		std::chrono::steady_clock::time_point m_QueuedAt;
+
 		cUser(int a_ClientID, const std::string_view a_Name, const std::string_view a_ServerID) :
-			m_ClientID(a_ClientID),
+			m_ClientIDs{ a_ClientID },
 			m_Name(a_Name),
-			m_ServerID(a_ServerID)
+			m_ServerID(a_ServerID),
+			m_QueuedAt(std::chrono::steady_clock::now())
 		{
 		}
 	};
 
-	using cUserList = std::deque<cUser>;
+	using cUserPtr = std::shared_ptr<cUser>;
+
+	/** A single worker thread, processing the queued requests one by one over its own connection. */
+	class cWorker:
+		public cIsThread
+	{
+		using Super = cIsThread;
+
+	public:
+
+		cWorker(cAuthenticator & a_Parent);
+		virtual ~cWorker() override;
+
+	private:
 
-	cCriticalSection m_CS;
-	cUserList        m_Queue;
-	cEvent           m_QueueNonempty;
+		cAuthenticator & m_Parent;
+
+		/** The keep-alive connection to the session server, reused for all the requests processed by this worker. */
+		std::unique_ptr<cHTTPClientConnection> m_Connection;
+
+		// cIsThread override:
+		virtual void Execute(void) override;
+	};
+
+	mutable cCriticalSection m_CS;
+
+	/** The requests waiting for a free worker, in the order of arrival. */
+	std::deque<cUserPtr> m_Queue;
+
+	/** All the requests either queued or being processed, keyed by name + server ID, for deduplication. */
+	std::unordered_map<AString, cUserPtr> m_Pending;
+
+	/** Signalled when a request is queued, or when the workers are to terminate. */
+	cEvent m_QueueNonempty;
+
+	/** Set when the workers are to terminate. */
+	std::atomic<bool> m_ShouldTerminate;
+
+	/** The worker threads. */
+	std::vector<std::unique_ptr<cWorker>> m_Workers;
 
 	/** The server that is to be contacted for auth / UUID conversions */
 	AString m_Server;
@@ -84,12 +133,32 @@ private:
 	AString m_PropertiesAddress;
 	bool    m_ShouldAuthenticate;
 
-	/** cIsThread override: */
-	virtual void Execute(void) override;
+	/** The number of worker threads, i.e. the maximum number of concurrent requests to the session server. */
+	int m_NumWorkers;
+
+	/** How long to wait for the session server's reply, including connecting, for a single attempt. */
+	std::chrono::milliseconds m_RequestTimeout;
+
+	/** How many times an unanswered request is resent, with the delay doubling each time. */
+	int m_MaxRetries;
+
+	/** The delay before the first resend. */
+	std::chrono::milliseconds m_RetryBackoff;
+
+
+	/** Returns the key under which the request is stored in m_Pending. */
+	static AString GetPendingKey(const AString & a_Name, const AString & a_ServerID);
+
+	/** Waits for a queued request and removes it from the queue.
+	Returns nullptr if the workers are to terminate. */
+	cUserPtr WaitForRequest(void);
+
+	/** Authenticates the user, retrying with backoff while the server is unavailable, and delivers the result to all its clients. */
+	void ProcessRequest(cUser & a_User, cHTTPClientConnection & a_Connection);
 
-	/** Returns true if the user authenticated okay, false on error
-	Returns the case-corrected username, UUID, and properties (eg. skin). */
-	bool AuthWithYggdrasil(AString & a_UserName, const AString & a_ServerId, cUUID & a_UUID, Json::Value & a_Properties) const;
+	/** Asks the session server about the user.
+	On success, returns the case-corrected username, UUID, and properties (eg. skin). */
+	eAuthResult AuthWithYggdrasil(cHTTPClientConnection & a_Connection, AString & a_UserName, const AString & a_ServerId, cUUID & a_UUID, Json::Value & a_Properties) const;
 };
 
 
@@ -0,0 +1,180 @@
+
+// CompressionController.cpp
+
+// Implements the cCompressionController class that chooses the packet compression threshold and level of a single connection
+
+#include "Globals.h"
+#include "CompressionController.h"
+#include "../Metrics.h"
+#include "../SettingsRepositoryInterface.h"
+
+
+
+
+
+/** How often the level is re-evaluated. */
+static const auto EVALUATION_INTERVAL = std::chrono::seconds(1);
+
+/** The level bounds supported by libdeflate. Levels above 9 are too slow for the packets. */
+static const int MIN_LEVEL = 1;
+static const int MAX_LEVEL = 9;
+
+
+
+
+
+std::atomic<cCompressionController::clock::rep> cCompressionController::s_TotalCompressionTime { 0 };
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cCompressionController::sSettings:
+
+void cCompressionController::sSettings::Load(cSettingsRepositoryInterface & a_Settings)
+{
+	m_Threshold      = static_cast<UInt32>(std::max(a_Settings.GetValueSetI("Compression", "Threshold", static_cast<int>(m_Threshold)), 0));
+	m_Level          = Clamp(a_Settings.GetValueSetI("Compression", "Level", m_Level), MIN_LEVEL, MAX_LEVEL);
+	m_LocalThreshold = static_cast<UInt32>(std::max(a_Settings.GetValueSetI("Compression", "LocalThreshold", static_cast<int>(m_LocalThreshold)), 0));
+	m_LocalLevel     = Clamp(a_Settings.GetValueSetI("Compression", "LocalLevel", m_LocalLevel), MIN_LEVEL, MAX_LEVEL);
+	m_MinLevel       = Clamp(a_Settings.GetValueSetI("Compression", "MinLevel", m_MinLevel), MIN_LEVEL, MAX_LEVEL);
+	m_MaxLevel       = Clamp(a_Settings.GetValueSetI("Compression", "MaxLevel", m_MaxLevel), m_MinLevel, MAX_LEVEL);
+	m_MaxServerLoad  = a_Settings.GetValueSetI("Compression", "MaxServerLoadPercent", static_cast<int>(m_MaxServerLoad * 100)) / 100.0;
+	m_MaxConnectionLoad = a_Settings.GetValueSetI("Compression", "MaxConnectionLoadPercent", static_cast<int>(m_MaxConnectionLoad * 100)) / 100.0;
+	m_SaturatedBacklog = static_cast<size_t>(std::max(a_Settings.GetValueSetI("Compression", "SaturatedBacklogKiB", static_cast<int>(m_SaturatedBacklog / 1024)), 1)) * 1024;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cCompressionController:
+
+cCompressionController::cCompressionController(void):
+	m_Threshold(m_Settings.m_Threshold),
+	m_BaseLevel(m_Settings.m_Level),
+	m_Level(m_Settings.m_Level),
+	m_WindowStart(clock::now()),
+	m_WindowStartTotalTime(0),
+	m_WindowCompressionTime(clock::duration::zero()),
+	m_WindowOutput(0),
+	m_LastBacklog(0)
+{
+}
+
+
+
+
+
+void cCompressionController::Init(const sSettings & a_Settings, bool a_IsLocalLink)
+{
+	m_Settings = a_Settings;
+	m_Threshold = a_IsLocalLink ? a_Settings.m_LocalThreshold : a_Settings.m_Threshold;
+	m_BaseLevel = Clamp(a_IsLocalLink ? a_Settings.m_LocalLevel : a_Settings.m_Level, a_Settings.m_MinLevel, a_Settings.m_MaxLevel);
+	m_Level = m_BaseLevel;
+	m_WindowStart = clock::now();
+	m_WindowStartTotalTime = s_TotalCompressionTime.load(std::memory_order_relaxed);
+}
+
+
+
+
+
+void cCompressionController::OnFlush(size_t a_InputSize, size_t a_OutputSize, clock::duration a_Duration, size_t a_LinkBacklog)
+{
+	s_TotalCompressionTime.fetch_add(a_Duration.count(), std::memory_order_relaxed);
+	m_WindowCompressionTime += a_Duration;
+	m_WindowOutput += a_OutputSize;
+
+	if (cMetrics::IsEnabled())
+	{
+		static auto & Input = cMetrics::GetCounter("cuberite_compression_input_bytes", "Number of packet bytes given to the compression");
+		static auto & Output = cMetrics::GetCounter("cuberite_compression_output_bytes", "Number of bytes produced by the compression, including the uncompressed small packets");
+		static auto & Time = cMetrics::GetCounter("cuberite_compression_microseconds", "Time spent compressing the packets");
+		Input.Inc(a_InputSize);
+		Output.Inc(a_OutputSize);
+		Time.Inc(static_cast<UInt64>(std::chrono::duration_cast<std::chrono::microseconds>(a_Duration).count()));
+	}
+
+	const auto Now = clock::now();
+	const auto Window = Now - m_WindowStart;
+	if (Window < EVALUATION_INTERVAL)
+	{
+		return;
+	}
+	Evaluate(Window, a_LinkBacklog);
+
+	m_WindowStart = Now;
+	m_WindowStartTotalTime = s_TotalCompressionTime.load(std::memory_order_relaxed);
+	m_WindowCompressionTime = clock::duration::zero();
+	m_WindowOutput = 0;
+	m_LastBacklog = a_LinkBacklog;
+}
+
+
+
+
+
+void cCompressionController::Evaluate(clock::duration a_Window, size_t a_LinkBacklog)
+{
+	const auto WindowSeconds = std::chrono::duration<double>(a_Window).count();
+	const auto ToSeconds = [](clock::rep a_Ticks)
+	{
+		return std::chrono::duration<double>(clock::duration(a_Ticks)).count();
+	};
+
+	// The share of the flush workers' time spent compressing, by all the connections:
+	const auto NumThreads = std::max(m_Settings.m_NumFlushWorkers, 1U);
+	const auto TotalTime = s_TotalCompressionTime.load(std::memory_order_relaxed) - m_WindowStartTotalTime;
+	const auto ServerLoad = ToSeconds(TotalTime) / (WindowSeconds * NumThreads);
+
+	// The share of a single thread's time spent compressing this connection's data:
+	const auto ConnectionLoad = ToSeconds(m_WindowCompressionTime.count()) / WindowSeconds;
+
+	// The link is saturated when it sends less than what is produced, so that a large backlog keeps growing:
+	const auto BacklogGrowth = static_cast<double>(a_LinkBacklog) - static_cast<double>(m_LastBacklog);
+	const auto LinkThroughput = (static_cast<double>(m_WindowOutput) - BacklogGrowth) / WindowSeconds;
+	const auto ProducedThroughput = static_cast<double>(m_WindowOutput) / WindowSeconds;
+	const bool IsSaturated = (a_LinkBacklog >= m_Settings.m_SaturatedBacklog) && (LinkThroughput < ProducedThroughput);
+
+	const auto Level = GetLevel();
+	if (ServerLoad > m_Settings.m_MaxServerLoad)
+	{
+		// Everyone's latency suffers when the server is CPU-bound, this takes precedence:
+		if (Level > m_Settings.m_MinLevel)
+		{
+			SetLevel(Level - 1, "cpu");
+		}
+	}
+	else if (IsSaturated)
+	{
+		if ((Level < m_Settings.m_MaxLevel) && (ConnectionLoad < m_Settings.m_MaxConnectionLoad))
+		{
+			SetLevel(Level + 1, "egress");
+		}
+	}
+	else if ((Level < m_BaseLevel) && (ServerLoad < m_Settings.m_MaxServerLoad / 2))
+	{
+		// The CPU is available again; only return once well below the limit, so that the level doesn't oscillate:
+		SetLevel(Level + 1, "relax");
+	}
+	else if ((Level > m_BaseLevel) && (a_LinkBacklog < m_Settings.m_SaturatedBacklog / 2))
+	{
+		SetLevel(Level - 1, "relax");
+	}
+}
+
+
+
+
+
+void cCompressionController::SetLevel(int a_Level, const char * a_Reason)
+{
+	m_Level.store(a_Level, std::memory_order_relaxed);
+	if (cMetrics::IsEnabled())
+	{
+		cMetrics::GetCounter("cuberite_compression_level_changes", "Number of compression level changes, by reason", cMetrics::FormatLabels({{"reason", a_Reason}})).Inc();
+	}
+}
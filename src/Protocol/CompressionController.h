@@ -0,0 +1,124 @@
+
+// CompressionController.h
+
+// Declares the cCompressionController class that chooses the packet compression threshold and level of a single connection
+
+/*
+A single fixed threshold and level is the wrong trade-off for most connections: a client on the same machine or a
+proxy on the LAN gains nothing from the bytes saved, while a client behind a slow link would rather have smaller
+packets than a fast server.
+The threshold is chosen once, when the compression is enabled at login, because the client needs to be told about it:
+loopback and proxy connections get the "local" threshold and level, the rest get the defaults.
+The level is then adapted by the flush worker after each flush, one step at a time and at most once per second:
+	- when the flush workers spend too much of their time compressing, the server is CPU-bound; the level is lowered;
+	- when the data that the link couldn't send yet keeps growing, egress is saturated; the level is raised, as long as
+	this connection's compression doesn't take too much time itself;
+	- otherwise the level returns towards the connection's base level.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cSettingsRepositoryInterface;
+
+
+
+
+
+class cCompressionController
+{
+public:
+
+	using clock = std::chrono::steady_clock;
+
+	/** The server-wide settings, from the [Compression] section of settings.ini. */
+	struct sSettings
+	{
+		/** The threshold and level for the remote connections. */
+		UInt32 m_Threshold = 256;
+		int m_Level = 6;
+
+		/** The threshold and level for the loopback and proxy connections. */
+		UInt32 m_LocalThreshold = 1024;
+		int m_LocalLevel = 1;
+
+		/** The bounds of the adapted level. */
+		int m_MinLevel = 1;
+		int m_MaxLevel = 9;
+
+		/** The share of the flush workers' time spent compressing, above which the server is considered CPU-bound. */
+		double m_MaxServerLoad = 0.5;
+
+		/** The share of a single thread's time spent compressing a connection's data, above which its level isn't raised. */
+		double m_MaxConnectionLoad = 0.05;
+
+		/** The amount of data the link couldn't send yet, above which the connection's egress is considered saturated. */
+		size_t m_SaturatedBacklog = 64 KiB;
+
+		/** The number of threads doing the compression; the flushing is done on the tick threads when 0. */
+		unsigned m_NumFlushWorkers = 0;
+
+		/** Reads the settings, writing the defaults if not present. */
+		void Load(cSettingsRepositoryInterface & a_Settings);
+	};
+
+
+	cCompressionController(void);
+
+	/** Chooses the threshold and level for the connection. Called once, right before the compression is enabled. */
+	void Init(const sSettings & a_Settings, bool a_IsLocalLink);
+
+	/** Returns the size from which the packets are compressed. */
+	UInt32 GetThreshold(void) const { return m_Threshold; }
+
+	/** Returns the current compression level. */
+	int GetLevel(void) const { return m_Level.load(std::memory_order_relaxed); }
+
+	/** Records a single flush: a_InputSize bytes compressed into a_OutputSize bytes in a_Duration.
+	a_LinkBacklog is the amount of data the link hasn't sent yet. Re-evaluates the level when due.
+	Called by the flush worker owning the connection, never concurrently. */
+	void OnFlush(size_t a_InputSize, size_t a_OutputSize, clock::duration a_Duration, size_t a_LinkBacklog);
+
+private:
+
+	/** The total time spent compressing by all the connections, for the server-wide load. */
+	static std::atomic<clock::rep> s_TotalCompressionTime;
+
+	/** The settings given to Init(). */
+	sSettings m_Settings;
+
+	UInt32 m_Threshold;
+
+	/** The level the connection returns to when neither CPU-bound nor saturated. */
+	int m_BaseLevel;
+
+	/** Read by the metrics from other threads, hence atomic. */
+	std::atomic<int> m_Level;
+
+	/** The start of the current evaluation window. */
+	clock::time_point m_WindowStart;
+
+	/** s_TotalCompressionTime at the start of the current window. */
+	clock::rep m_WindowStartTotalTime;
+
+	/** The time spent compressing this connection's data, and the data produced, in the current window. */
+	clock::duration m_WindowCompressionTime;
+	size_t m_WindowOutput;
+
+	/** The link's backlog at the end of the previous window. */
+	size_t m_LastBacklog;
+
+
+	/** Decides the new level at the end of an evaluation window lasting a_Window. */
+	void Evaluate(clock::duration a_Window, size_t a_LinkBacklog);
+
+	/** Changes the level, counting the change in the metrics under the specified reason. */
+	void SetLevel(int a_Level, const char * a_Reason);
+};
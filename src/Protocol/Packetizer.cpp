@@ -128,6 +128,7 @@ AString cPacketizer::PacketTypeToStr(cProtocol::ePacketType a_PacketType)
 		case cProtocol::pktUpdateHealth:           return "pktUpdateHealth";
 		case cProtocol::pktUpdateScore:            return "pktUpdateScore";
 		case cProtocol::pktUpdateSign:             return "pktUpdateSign";
+		case cProtocol::pktUpdateViewDistance:     return "pktUpdateViewDistance";
 		case cProtocol::pktUseBed:                 return "pktUseBed";
 		case cProtocol::pktWeather:                return "pktWeather";
 		case cProtocol::pktWindowItems:            return "pktWindowItems";
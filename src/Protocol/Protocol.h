@@ -126,6 +126,7 @@ public:
 		pktUpdateHealth,
 		pktUpdateScore,
 		pktUpdateSign,
+		pktUpdateViewDistance,
 		pktUseBed,
 		pktWeather,
 		pktWindowItems,
@@ -365,6 +366,22 @@ public:
 	The protocol uses the provided buffers for storage and processing, and must have exclusive access to them. */
 	virtual void DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data) = 0;
 
+	/** Returns true once the encryption and compression of the incoming data can no longer change.
+	From then on, cClientHandle splits the received data into packets on the network thread using FrameReceivedData(),
+	and only the handling of the resulting packets is left for the tick thread. */
+	virtual bool IsFramingFinal(void) const = 0;
+
+	/** Called by cClientHandle on the network thread to decrypt the received data and split it into packets, once IsFramingFinal() is true.
+	The decompressed payload of each complete packet is appended to a_Packets and its size to a_PacketSizes,
+	to be handled by HandleFramedPacket(). The payloads are stored back-to-back, so that the buffers can be reused without allocating.
+	The protocol uses the provided buffers for storage and processing, and must have exclusive access to them.
+	Since the client cannot be kicked from the network thread, a malformed packet sets a_Error to the reason to kick it with.
+	Returns false if there's too much unparsed data in a_Buffer. */
+	virtual bool FrameReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data, ContiguousByteBuffer & a_Packets, std::vector<size_t> & a_PacketSizes, AString & a_Error) = 0;
+
+	/** Called by cClientHandle on the tick thread to handle a single packet produced by FrameReceivedData(). */
+	virtual void HandleFramedPacket(ContiguousByteBufferView a_Packet) = 0;
+
 	/** Called by cClientHandle to finalise a buffer of prepared data before they are sent to the client.
 	Descendants may for example, encrypt the data if needed.
 	The protocol modifies the provided buffer in-place. */
@@ -399,6 +416,7 @@ public:
 	virtual void SendEntityLook                 (const cEntity & a_Entity) = 0;
 	virtual void SendEntityMetadata             (const cEntity & a_Entity) = 0;
 	virtual void SendEntityPosition             (const cEntity & a_Entity) = 0;
+	virtual void SendEntityTeleport             (const cEntity & a_Entity) = 0;
 	virtual void SendEntityProperties           (const cEntity & a_Entity) = 0;
 	virtual void SendEntityVelocity             (const cEntity & a_Entity) = 0;
 	virtual void SendExplosion                  (Vector3f a_Position, float a_Power) = 0;
@@ -411,7 +429,7 @@ public:
 	virtual void SendLeashEntity                (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo) = 0;
 	virtual void SendLogin                      (const cPlayer & a_Player, const cWorld & a_World) = 0;
 	virtual void SendLoginSuccess               (void) = 0;
-	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY) = 0;
+	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight) = 0;
 	virtual void SendPaintingSpawn              (const cPainting & a_Painting) = 0;
 	virtual void SendPlayerAbilities            (void) = 0;
 	virtual void SendParticleEffect             (const AString & a_SoundName, Vector3f a_Src, Vector3f a_Offset, float a_ParticleData, int a_ParticleAmount) = 0;
@@ -454,6 +472,7 @@ public:
 	virtual void SendUnloadChunk                (int a_ChunkX, int a_ChunkZ) = 0;
 	virtual void SendUpdateBlockEntity          (cBlockEntity & a_BlockEntity) = 0;
 	virtual void SendUpdateSign                 (Vector3i a_BlockPos, const AString & a_Line1, const AString & a_Line2, const AString & a_Line3, const AString & a_Line4) = 0;
+	virtual void SendUpdateViewDistance         (int a_ViewDistance) = 0;
 	virtual void SendUnlockRecipe               (UInt32 a_RecipeID) = 0;
 	virtual void SendInitRecipes                (UInt32 a_RecipeID) = 0;
 	virtual void SendWeather                    (eWeather a_Weather) = 0;
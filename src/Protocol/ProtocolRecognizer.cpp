@@ -206,6 +206,28 @@ void cMultiVersionProtocol::HandleIncomingData(cClientHandle & a_Client, Contigu
 
 
 
+bool cMultiVersionProtocol::FrameIncomingData(ContiguousByteBuffer & a_Data, ContiguousByteBuffer & a_Packets, std::vector<size_t> & a_PacketSizes, AString & a_Error)
+{
+	ASSERT(IsFramingFinal());
+
+	return m_Protocol->FrameReceivedData(m_Buffer, a_Data, a_Packets, a_PacketSizes, a_Error);
+}
+
+
+
+
+
+void cMultiVersionProtocol::HandleIncomingPacket(const ContiguousByteBufferView a_Packet)
+{
+	ASSERT(m_Protocol != nullptr);
+
+	m_Protocol->HandleFramedPacket(a_Packet);
+}
+
+
+
+
+
 void cMultiVersionProtocol::HandleOutgoingData(ContiguousByteBuffer & a_Data)
 {
 	// Normally only the protocol sends data, so outgoing data are only present when m_Protocol != nullptr.
@@ -42,6 +42,22 @@ public:
 	The protocol modifies the provided buffer in-place. */
 	void HandleIncomingData(cClientHandle & a_Client, ContiguousByteBuffer & a_Data);
 
+	/** Returns true once a protocol was recognized and it has settled on the encryption and compression of the incoming data.
+	After that, the incoming data may be split into packets on the network thread using FrameIncomingData. */
+	bool IsFramingFinal() const
+	{
+		return !m_WaitingForData && (m_Protocol != nullptr) && m_Protocol->IsFramingFinal();
+	}
+
+	/** Decrypts the incoming data and splits them into packets, appending their payloads to a_Packets and their sizes to a_PacketSizes.
+	May only be used once IsFramingFinal() returns true; the protocol modifies the provided buffer in-place.
+	Sets a_Error to the reason to kick the client with on malformed data.
+	Returns false if there's too much unparsed data buffered. */
+	bool FrameIncomingData(ContiguousByteBuffer & a_Data, ContiguousByteBuffer & a_Packets, std::vector<size_t> & a_PacketSizes, AString & a_Error);
+
+	/** Handles a single packet produced by FrameIncomingData. */
+	void HandleIncomingPacket(ContiguousByteBufferView a_Packet);
+
 	/** Allows the protocol (if any) to do a final pass on outgiong data, possibly modifying the provided buffer in-place. */
 	void HandleOutgoingData(ContiguousByteBuffer & a_Data);
 
@@ -179,7 +179,7 @@ void cProtocol_1_14::SendLogin(const cPlayer & a_Player, const cWorld & a_World)
 
 
 
-void cProtocol_1_14::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cProtocol_1_14::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight)
 {
 }
 
@@ -316,6 +316,18 @@ void cProtocol_1_14::SendUpdateSign(Vector3i a_BlockPos, const AString & a_Line1
 
 
 
+void cProtocol_1_14::SendUpdateViewDistance(int a_ViewDistance)
+{
+	ASSERT(m_State == 3);  // In game mode?
+
+	cPacketizer Pkt(*this, pktUpdateViewDistance);
+	Pkt.WriteVarInt32(ToUnsigned(a_ViewDistance));
+}
+
+
+
+
+
 void cProtocol_1_14::SendWindowOpen(const cWindow & a_Window)
 {
 	ASSERT(m_State == 3);  // In game mode?
@@ -492,6 +504,7 @@ UInt32 cProtocol_1_14::GetPacketID(ePacketType a_PacketType) const
 		case cProtocol::pktUnlockRecipe:         return 0x36;
 		case cProtocol::pktUpdateHealth:         return 0x48;
 		case cProtocol::pktUpdateScore:          return 0x4C;
+		case cProtocol::pktUpdateViewDistance:   return 0x41;
 		case cProtocol::pktUpdateSign:           return 0x2F;
 		case cProtocol::pktWeather:              return 0x1E;
 		case cProtocol::pktWindowItems:          return 0x14;
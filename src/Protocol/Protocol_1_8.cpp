@@ -56,7 +56,7 @@ Implements the 1.8 protocol classes:
 
 
 const int MAX_ENC_LEN = 512;  // Maximum size of the encrypted message; should be 128, but who knows...
-static const UInt32 CompressionThreshold = 256;  // After how large a packet should we compress it.
+static const UInt32 MAX_UNCOMPRESSED_PACKET_SIZE = 2 MiB;  // The largest decompressed packet a client may send, same as vanilla
 
 
 
@@ -149,7 +149,59 @@ void cProtocol_1_8_0::DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer
 		m_Decryptor.ProcessData(a_Data.data(), a_Data.size());
 	}
 
-	AddReceivedData(a_Buffer, a_Data);
+	// Handle the packets as soon as they're framed, any of them may change the state, and with it the compression:
+	AString Error;
+	if (!AddReceivedData(a_Buffer, a_Data, [this](const ContiguousByteBufferView a_Packet) { HandleFramedPacket(a_Packet); }, Error))
+	{
+		m_Client->PacketBufferFull();
+		return;
+	}
+	if (!Error.empty())
+	{
+		m_Client->Kick(Error);
+		return;
+	}
+}
+
+
+
+
+
+bool cProtocol_1_8_0::IsFramingFinal(void) const
+{
+	// Both the encryption and the compression are set up before switching to the Game state, and never change afterwards:
+	return (m_State == State::Game);
+}
+
+
+
+
+
+bool cProtocol_1_8_0::FrameReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data, ContiguousByteBuffer & a_Packets, std::vector<size_t> & a_PacketSizes, AString & a_Error)
+{
+	ASSERT(IsFramingFinal());
+
+	if (m_IsEncrypted)
+	{
+		m_Decryptor.ProcessData(a_Data.data(), a_Data.size());
+	}
+
+	return AddReceivedData(a_Buffer, a_Data, [&a_Packets, &a_PacketSizes](const ContiguousByteBufferView a_Packet)
+	{
+		a_Packets.append(a_Packet);
+		a_PacketSizes.push_back(a_Packet.size());
+	}, a_Error);
+}
+
+
+
+
+
+void cProtocol_1_8_0::HandleFramedPacket(const ContiguousByteBufferView a_Packet)
+{
+	// Parse the packet right where it is, without copying:
+	cByteBuffer bb(a_Packet);
+	HandlePacket(bb);
 }
 
 
@@ -365,6 +417,25 @@ void cProtocol_1_8_0::SendChunkData(const ContiguousByteBufferView a_ChunkData)
 	ASSERT(m_State == 3);  // In game mode?
 
 	cCSLock Lock(m_CSPacket);
+
+	// The data was compressed with the shared threshold, but the client rejects compressed packets below its own threshold:
+	const auto Threshold = m_Client->GetCompressionThreshold();
+	if (Threshold > SHARED_COMPRESSION_THRESHOLD)
+	{
+		cByteBuffer Header(a_ChunkData);
+		UInt32 PacketSize, DataSize;
+		if (Header.ReadVarInt(PacketSize) && Header.ReadVarInt(DataSize) && (DataSize > 0) && (DataSize < Threshold))
+		{
+			// Rare, the chunk packets are almost always larger than any sensible threshold; reframe uncompressed:
+			Compression::Extractor Extractor;
+			const auto Packet = Extractor.ExtractZLib(a_ChunkData.substr(a_ChunkData.size() - Header.GetReadableSpace()), DataSize);
+			ContiguousByteBuffer Reframed;
+			AppendCompressedPacket(Packet.GetView(), m_Compressor.GetCompressor(), Threshold, Reframed);
+			m_Client->SendData(Reframed);
+			return;
+		}
+	}
+
 	m_Client->SendData(a_ChunkData);
 }
 
@@ -616,7 +687,17 @@ void cProtocol_1_8_0::SendEntityPosition(const cEntity & a_Entity)
 		return;
 	}
 
-	// Too big or small a movement, do a teleport.
+	// Too big or small a movement, do a teleport:
+	SendEntityTeleport(a_Entity);
+}
+
+
+
+
+
+void cProtocol_1_8_0::SendEntityTeleport(const cEntity & a_Entity)
+{
+	ASSERT(m_State == 3);  // In game mode?
 
 	cPacketizer Pkt(*this, pktTeleportEntity);
 	Pkt.WriteVarInt32(a_Entity.GetUniqueID());
@@ -861,7 +942,7 @@ void cProtocol_1_8_0::SendLoginSuccess(void)
 	// Enable compression:
 	{
 		cPacketizer Pkt(*this, pktStartCompression);
-		Pkt.WriteVarInt32(CompressionThreshold);
+		Pkt.WriteVarInt32(m_Client->GetCompressionThreshold());
 	}
 
 	m_State = State::Game;
@@ -895,7 +976,7 @@ void cProtocol_1_8_0::SendPaintingSpawn(const cPainting & a_Painting)
 
 
 
-void cProtocol_1_8_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cProtocol_1_8_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight)
 {
 	ASSERT(m_State == 3);  // In game mode?
 
@@ -911,14 +992,23 @@ void cProtocol_1_8_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_Da
 		Pkt.WriteBEUInt8(static_cast<UInt8>(Decorator.GetPixelZ()));
 	}
 
-	Pkt.WriteBEUInt8(128);
-	Pkt.WriteBEUInt8(128);
+	// No columns means no pixel data, only the decorators are updated:
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataWidth));
+	if (a_DataWidth == 0)
+	{
+		return;
+	}
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataHeight));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartX));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartY));
-	Pkt.WriteVarInt32(static_cast<UInt32>(a_Map.GetData().size()));
-	for (auto itr = a_Map.GetData().cbegin(); itr != a_Map.GetData().cend(); ++itr)
+	Pkt.WriteVarInt32(static_cast<UInt32>(a_DataWidth * a_DataHeight));
+	const auto & Data = a_Map.GetData();
+	for (int Y = a_DataStartY; Y < a_DataStartY + a_DataHeight; Y++)
 	{
-		Pkt.WriteBEUInt8(*itr);
+		for (int X = a_DataStartX; X < a_DataStartX + a_DataWidth; X++)
+		{
+			Pkt.WriteBEUInt8(Data[static_cast<size_t>(X) + static_cast<size_t>(Y) * a_Map.GetWidth()]);
+		}
 	}
 }
 
@@ -1667,6 +1757,16 @@ void cProtocol_1_8_0::SendUpdateSign(Vector3i a_BlockPos, const AString & a_Line
 
 
 
+void cProtocol_1_8_0::SendUpdateViewDistance(int a_ViewDistance)
+{
+	// Client doesn't support this feature, it learns the view distance from the chunks it gets
+	return;
+}
+
+
+
+
+
 void cProtocol_1_8_0::SendUnlockRecipe(UInt32 a_RecipeID)
 {
 	// Client doesn't support this feature
@@ -1793,9 +1893,17 @@ void cProtocol_1_8_0::SendWindowProperty(const cWindow & a_Window, size_t a_Prop
 
 void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, ContiguousByteBuffer & a_CompressedData)
 {
-	const auto Uncompressed = a_Packet.GetView();
+	a_CompressedData.clear();
+	AppendCompressedPacket(a_Packet.GetView(), a_Packet.GetCompressor(), SHARED_COMPRESSION_THRESHOLD, a_CompressedData);
+}
+
 
-	if (Uncompressed.size() < CompressionThreshold)
+
+
+
+void cProtocol_1_8_0::AppendCompressedPacket(const ContiguousByteBufferView a_Packet, Compression::Compressor & a_Compressor, const UInt32 a_Threshold, ContiguousByteBuffer & a_CompressedData)
+{
+	if (a_Packet.size() < a_Threshold)
 	{
 		/* Size doesn't reach threshold, not worth compressing.
 
@@ -1808,7 +1916,7 @@ void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, Contig
 		----------------------------------------------
 		*/
 		const UInt32 DataSize = 0;
-		const auto PacketSize = static_cast<UInt32>(cByteBuffer::GetVarIntSize(DataSize) + Uncompressed.size());
+		const auto PacketSize = static_cast<UInt32>(cByteBuffer::GetVarIntSize(DataSize) + a_Packet.size());
 
 		cByteBuffer LengthHeaderBuffer(
 			cByteBuffer::GetVarIntSize(PacketSize) +
@@ -1821,9 +1929,9 @@ void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, Contig
 		ContiguousByteBuffer LengthData;
 		LengthHeaderBuffer.ReadAll(LengthData);
 
-		a_CompressedData.reserve(LengthData.size() + Uncompressed.size());
-		a_CompressedData = LengthData;
-		a_CompressedData += Uncompressed;
+		a_CompressedData.reserve(a_CompressedData.size() + LengthData.size() + a_Packet.size());
+		a_CompressedData += LengthData;
+		a_CompressedData += a_Packet;
 
 		return;
 	}
@@ -1839,10 +1947,10 @@ void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, Contig
 	----------------------------------------------
 	*/
 
-	const auto CompressedData = a_Packet.Compress();
+	const auto CompressedData = a_Compressor.CompressZLib(a_Packet);
 	const auto Compressed = CompressedData.GetView();
 
-	const UInt32 DataSize = static_cast<UInt32>(Uncompressed.size());
+	const UInt32 DataSize = static_cast<UInt32>(a_Packet.size());
 	const auto PacketSize = static_cast<UInt32>(cByteBuffer::GetVarIntSize(DataSize) + Compressed.size());
 
 	cByteBuffer LengthHeaderBuffer(
@@ -1856,8 +1964,8 @@ void cProtocol_1_8_0::CompressPacket(CircularBufferCompressor & a_Packet, Contig
 	ContiguousByteBuffer LengthData;
 	LengthHeaderBuffer.ReadAll(LengthData);
 
-	a_CompressedData.reserve(LengthData.size() + Compressed.size());
-	a_CompressedData = LengthData;
+	a_CompressedData.reserve(a_CompressedData.size() + LengthData.size() + Compressed.size());
+	a_CompressedData += LengthData;
 	a_CompressedData += Compressed;
 }
 
@@ -3057,13 +3165,8 @@ void cProtocol_1_8_0::SendPacket(cPacketizer & a_Pkt)
 
 	if (m_State == 3)
 	{
-		ContiguousByteBuffer CompressedPacket;
-
-		// Compress the packet payload:
-		cProtocol_1_8_0::CompressPacket(m_Compressor, CompressedPacket);
-
-		// Send the packet's payload compressed:
-		m_Client->SendData(CompressedPacket);
+		// Send the packet's payload, it gets compressed by the flush worker:
+		m_Client->SendUncompressedPacket(PacketData);
 	}
 	else
 	{
@@ -3081,6 +3184,7 @@ void cProtocol_1_8_0::SendPacket(cPacketizer & a_Pkt)
 	// Log the comm into logfile:
 	if (g_ShouldLogCommOut && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		AString Hex;
 		ASSERT(PacketData.size() > 0);
 		CreateHexDump(Hex, PacketData.data(), PacketData.size(), 16);
@@ -3795,11 +3899,12 @@ void cProtocol_1_8_0::WriteMobMetadata(cPacketizer & a_Pkt, const cMonster & a_M
 
 
 
-void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousByteBufferView a_Data)
+bool cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousByteBufferView a_Data, cFunctionRef<void(ContiguousByteBufferView)> a_Callback, AString & a_Error)
 {
 	// Write the incoming data into the comm log file:
 	if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		if (a_Buffer.GetReadableSpace() > 0)
 		{
 			ContiguousByteBuffer AllData;
@@ -3824,77 +3929,79 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 		m_CommLogFile.Flush();
 	}
 
-	if (!a_Buffer.Write(a_Data.data(), a_Data.size()))
+	// Parse the packets straight from the received data. Only if a partial packet was left over from the previous data,
+	// join the two in the reusable m_ReceivedData first:
+	ContiguousByteBufferView Data = a_Data;
+	if (a_Buffer.GetReadableSpace() > 0)
 	{
-		// Too much data in the incoming queue, report to caller:
-		m_Client->PacketBufferFull();
-		return;
+		m_ReceivedData.clear();
+		a_Buffer.ReadAll(m_ReceivedData);
+		a_Buffer.CommitRead();
+		m_ReceivedData.append(a_Data);
+		Data = m_ReceivedData;
 	}
 
 	// Handle all complete packets:
+	cByteBuffer Frames(Data);
 	for (;;)
 	{
 		UInt32 PacketLen;
-		if (!a_Buffer.ReadVarInt(PacketLen))
+		if (!Frames.ReadVarInt(PacketLen))
 		{
 			// Not enough data
-			a_Buffer.ResetRead();
+			Frames.ResetRead();
 			break;
 		}
-		if (!a_Buffer.CanReadBytes(PacketLen))
+		if (!Frames.CanReadBytes(PacketLen))
 		{
 			// The full packet hasn't been received yet
-			a_Buffer.ResetRead();
+			Frames.ResetRead();
 			break;
 		}
+		auto Packet = Data.substr(Data.size() - Frames.GetReadableSpace(), PacketLen);
+		Frames.SkipRead(PacketLen);
+		Frames.CommitRead();
 
 		// Check packet for compression:
 		if (m_State == 3)
 		{
-			UInt32 NumBytesRead = static_cast<UInt32>(a_Buffer.GetReadableSpace());
-
+			cByteBuffer Header(Packet);
 			UInt32 UncompressedSize;
-			if (!a_Buffer.ReadVarInt(UncompressedSize))
+			if (!Header.ReadVarInt(UncompressedSize))
 			{
-				m_Client->Kick("Compression packet incomplete");
-				return;
+				a_Error = "Compression packet incomplete";
+				return true;
 			}
-
-			NumBytesRead -= static_cast<UInt32>(a_Buffer.GetReadableSpace());  // How many bytes has the UncompressedSize taken up?
-			ASSERT(PacketLen > NumBytesRead);
-			PacketLen -= NumBytesRead;
+			Packet.remove_prefix(Packet.size() - Header.GetReadableSpace());
 
 			if (UncompressedSize > 0)
 			{
-				// Decompress the data:
-				m_Extractor.ReadFrom(a_Buffer, PacketLen);
-				a_Buffer.CommitRead();
-
-				const auto UncompressedData = m_Extractor.Extract(UncompressedSize);
-				const auto Uncompressed = UncompressedData.GetView();
-				cByteBuffer bb(Uncompressed.size());
-
-				// Compression was used, move the uncompressed data:
-				VERIFY(bb.Write(Uncompressed.data(), Uncompressed.size()));
+				if (UncompressedSize > MAX_UNCOMPRESSED_PACKET_SIZE)
+				{
+					a_Error = "Compressed packet too large";
+					return true;
+				}
 
-				HandlePacket(bb);
-				continue;
+				// Decompress the data into the reusable m_ExtractedData:
+				Packet = m_Extractor.ExtractZLib(Packet, UncompressedSize, m_ExtractedData);
 			}
 		}
 
-		// Move the packet payload to a separate cByteBuffer, bb:
-		cByteBuffer bb(PacketLen);
-
-		// No compression was used, move directly:
-		VERIFY(a_Buffer.ReadToByteBuffer(bb, static_cast<size_t>(PacketLen)));
-		a_Buffer.CommitRead();
-
-		HandlePacket(bb);
+		a_Callback(Packet);
 	}  // for (ever)
 
+	// Keep the partial packet for the next data:
+	const auto Leftover = Data.substr(Data.size() - Frames.GetReadableSpace());
+	if (!a_Buffer.Write(Leftover.data(), Leftover.size()))
+	{
+		// Too much data in the incoming queue, report to caller:
+		return false;
+	}
+
 	// Log any leftover bytes into the logfile:
 	if (g_ShouldLogCommIn && (a_Buffer.GetReadableSpace() > 0) && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		ContiguousByteBuffer AllData;
 		size_t OldReadableSpace = a_Buffer.GetReadableSpace();
 		a_Buffer.ReadAll(AllData);
@@ -3909,6 +4016,7 @@ void cProtocol_1_8_0::AddReceivedData(cByteBuffer & a_Buffer, const ContiguousBy
 		));
 		m_CommLogFile.Flush();
 	}
+	return true;
 }
 
 
@@ -4151,6 +4259,7 @@ void cProtocol_1_8_0::HandlePacket(cByteBuffer & a_Buffer)
 	// Log the packet info into the comm log file:
 	if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 	{
+		cCSLock Lock(m_CSCommLog);
 		ContiguousByteBuffer PacketData;
 		a_Buffer.ReadAll(PacketData);
 		a_Buffer.ResetRead();
@@ -4184,6 +4293,7 @@ void cProtocol_1_8_0::HandlePacket(cByteBuffer & a_Buffer)
 		// Put a message in the comm log:
 		if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 		{
+			cCSLock Lock(m_CSCommLog);
 			m_CommLogFile.Write("^^^^^^ Unhandled packet ^^^^^^\n\n\n");
 		}
 
@@ -4201,6 +4311,7 @@ void cProtocol_1_8_0::HandlePacket(cByteBuffer & a_Buffer)
 		// Put a message in the comm log:
 		if (g_ShouldLogCommIn && m_CommLogFile.IsOpen())
 		{
+			cCSLock Lock(m_CSCommLog);
 			m_CommLogFile.Write(fmt::format(
 				FMT_STRING("^^^^^^ Wrong number of bytes read for this packet (exp 1 left, got {} left) ^^^^^^\n\n\n"),
 				a_Buffer.GetReadableSpace()
@@ -15,6 +15,7 @@ Declares the 1.8 protocol classes:
 
 #include "Protocol.h"
 #include "../ByteBuffer.h"
+#include "../FunctionRef.h"
 #include "../Registries/CustomStatistics.h"
 
 #include "../mbedTLS++/AesCfb128Decryptor.h"
@@ -37,6 +38,9 @@ public:
 	cProtocol_1_8_0(cClientHandle * a_Client, const AString & a_ServerAddress, State a_State);
 
 	virtual void DataReceived(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data) override;
+	virtual bool IsFramingFinal(void) const override;
+	virtual bool FrameReceivedData(cByteBuffer & a_Buffer, ContiguousByteBuffer & a_Data, ContiguousByteBuffer & a_Packets, std::vector<size_t> & a_PacketSizes, AString & a_Error) override;
+	virtual void HandleFramedPacket(ContiguousByteBufferView a_Packet) override;
 	virtual void DataPrepared(ContiguousByteBuffer & a_Data) override;
 
 	// Sending stuff to clients (alphabetically sorted):
@@ -68,6 +72,7 @@ public:
 	virtual void SendEntityLook                 (const cEntity & a_Entity) override;
 	virtual void SendEntityMetadata             (const cEntity & a_Entity) override;
 	virtual void SendEntityPosition             (const cEntity & a_Entity) override;
+	virtual void SendEntityTeleport             (const cEntity & a_Entity) override;
 	virtual void SendEntityProperties           (const cEntity & a_Entity) override;
 	virtual void SendEntityVelocity             (const cEntity & a_Entity) override;
 	virtual void SendExperience                 (void) override;
@@ -82,7 +87,7 @@ public:
 	virtual void SendLeashEntity                (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo) override;
 	virtual void SendLogin                      (const cPlayer & a_Player, const cWorld & a_World) override;
 	virtual void SendLoginSuccess               (void) override;
-	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY) override;
+	virtual void SendMapData                    (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight) override;
 	virtual void SendPaintingSpawn              (const cPainting & a_Painting) override;
 	virtual void SendPlayerAbilities            (void) override;
 	virtual void SendParticleEffect             (const AString & a_ParticleName, Vector3f a_Src, Vector3f a_Offset, float a_ParticleData, int a_ParticleAmount) override;
@@ -123,6 +128,7 @@ public:
 	virtual void SendUnloadChunk                (int a_ChunkX, int a_ChunkZ) override;
 	virtual void SendUpdateBlockEntity          (cBlockEntity & a_BlockEntity) override;
 	virtual void SendUpdateSign                 (Vector3i a_BlockPos, const AString & a_Line1, const AString & a_Line2, const AString & a_Line3, const AString & a_Line4) override;
+	virtual void SendUpdateViewDistance         (int a_ViewDistance) override;
 	virtual void SendUnlockRecipe               (UInt32 a_RecipeID) override;
 	virtual void SendInitRecipes                (UInt32 a_RecipeID) override;
 	virtual void SendWeather                    (eWeather a_Weather) override;
@@ -133,10 +139,18 @@ public:
 
 	virtual AString GetAuthServerID(void) override { return m_AuthServerID; }
 
-	/** Compress the packet. a_Packet must be without packet length.
+	/** The compression threshold of the packets shared by all the clients, such as the cached chunk data.
+	Clients with a higher threshold get these packets reframed uncompressed when needed, see SendChunkData(). */
+	static const UInt32 SHARED_COMPRESSION_THRESHOLD = 256;
+
+	/** Compress the packet, using SHARED_COMPRESSION_THRESHOLD. a_Packet must be without packet length.
 	a_Compressed will be set to the compressed packet includes packet length and data length. */
 	static void CompressPacket(CircularBufferCompressor & a_Packet, ContiguousByteBuffer & a_Compressed);
 
+	/** Compresses the packet using a_Compressor, if it is at least a_Threshold bytes large. a_Packet must be without packet length.
+	The compressed packet, including the packet length and data length, is appended to a_Compressed. */
+	static void AppendCompressedPacket(ContiguousByteBufferView a_Packet, Compression::Compressor & a_Compressor, UInt32 a_Threshold, ContiguousByteBuffer & a_Compressed);
+
 protected:
 
 	/** State of the protocol. */
@@ -248,19 +262,34 @@ private:
 
 	AString m_AuthServerID;
 
-	bool m_IsEncrypted;
+	/** Set on the tick thread when the encryption starts, read by the flush worker that encrypts the outgoing data.
+	The tick thread starts the encryption under the client's flush lock, so the flush worker never sees m_Encryptor half-initialized. */
+	std::atomic<bool> m_IsEncrypted;
 
 	cAesCfb128Decryptor m_Decryptor;
 	cAesCfb128Encryptor m_Encryptor;
 
 	CircularBufferCompressor m_Compressor;
-	CircularBufferExtractor m_Extractor;
+	Compression::Extractor m_Extractor;
+
+	/** The reusable storage for the decompressed incoming packets. Only ever grows, so that it stops allocating. */
+	ContiguousByteBuffer m_ExtractedData;
+
+	/** The reusable storage where a partial packet left over in the buffer is joined with the newly received data. */
+	ContiguousByteBuffer m_ReceivedData;
 
 	/** The logfile where the comm is logged, when g_ShouldLogComm is true */
 	cFile m_CommLogFile;
 
-	/** Adds the received (unencrypted) data to m_ReceivedData, parses complete packets */
-	void AddReceivedData(cByteBuffer & a_Buffer, ContiguousByteBufferView a_Data);
+	/** Protects m_CommLogFile, the outgoing packets are logged from the tick threads while the incoming ones from the network thread. */
+	cCriticalSection m_CSCommLog;
+
+	/** Splits the received (unencrypted) data into packets, calls a_Callback with the decompressed payload of each complete packet.
+	The payloads are views into a_Data or the reusable buffers, valid only during the callback.
+	A trailing partial packet is kept in a_Buffer until the rest of it is received.
+	On a malformed packet header, stops and sets a_Error to the reason to kick the client with.
+	Returns false if the partial packet doesn't fit into a_Buffer. */
+	bool AddReceivedData(cByteBuffer & a_Buffer, ContiguousByteBufferView a_Data, cFunctionRef<void(ContiguousByteBufferView)> a_Callback, AString & a_Error);
 
 	/** Converts a statistic to a protocol-specific string.
 	Protocols <= 1.12 use strings, hence this is a static as the string-mapping was append-only for the versions that used it.
@@ -344,7 +344,17 @@ void cProtocol_1_9_0::SendEntityPosition(const cEntity & a_Entity)
 		return;
 	}
 
-	// Too big or small a movement, do a teleport.
+	// Too big or small a movement, do a teleport:
+	SendEntityTeleport(a_Entity);
+}
+
+
+
+
+
+void cProtocol_1_9_0::SendEntityTeleport(const cEntity & a_Entity)
+{
+	ASSERT(m_State == 3);  // In game mode?
 
 	cPacketizer Pkt(*this, pktTeleportEntity);
 	Pkt.WriteVarInt32(a_Entity.GetUniqueID());
@@ -438,7 +448,7 @@ void cProtocol_1_9_0::SendPaintingSpawn(const cPainting & a_Painting)
 
 
 
-void cProtocol_1_9_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY)
+void cProtocol_1_9_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight)
 {
 	ASSERT(m_State == 3);  // In game mode?
 
@@ -455,14 +465,23 @@ void cProtocol_1_9_0::SendMapData(const cMap & a_Map, int a_DataStartX, int a_Da
 		Pkt.WriteBEUInt8(static_cast<UInt8>(Decorator.GetPixelZ()));
 	}
 
-	Pkt.WriteBEUInt8(128);
-	Pkt.WriteBEUInt8(128);
+	// No columns means no pixel data, only the decorators are updated:
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataWidth));
+	if (a_DataWidth == 0)
+	{
+		return;
+	}
+	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataHeight));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartX));
 	Pkt.WriteBEUInt8(static_cast<UInt8>(a_DataStartY));
-	Pkt.WriteVarInt32(static_cast<UInt32>(a_Map.GetData().size()));
-	for (auto itr = a_Map.GetData().cbegin(); itr != a_Map.GetData().cend(); ++itr)
+	Pkt.WriteVarInt32(static_cast<UInt32>(a_DataWidth * a_DataHeight));
+	const auto & Data = a_Map.GetData();
+	for (int Y = a_DataStartY; Y < a_DataStartY + a_DataHeight; Y++)
 	{
-		Pkt.WriteBEUInt8(*itr);
+		for (int X = a_DataStartX; X < a_DataStartX + a_DataWidth; X++)
+		{
+			Pkt.WriteBEUInt8(Data[static_cast<size_t>(X) + static_cast<size_t>(Y) * a_Map.GetWidth()]);
+		}
 	}
 }
 
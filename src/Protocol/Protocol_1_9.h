@@ -46,10 +46,11 @@ public:
 	virtual void SendEntityEquipment      (const cEntity & a_Entity, short a_SlotNum, const cItem & a_Item) override;
 	virtual void SendEntityMetadata       (const cEntity & a_Entity) override;
 	virtual void SendEntityPosition       (const cEntity & a_Entity) override;
+	virtual void SendEntityTeleport       (const cEntity & a_Entity) override;
 	virtual void SendExperienceOrb        (const cExpOrb & a_ExpOrb) override;
 	virtual void SendKeepAlive            (UInt32 a_PingID) override;
 	virtual void SendLeashEntity          (const cEntity & a_Entity, const cEntity & a_EntityLeashedTo) override;
-	virtual void SendMapData              (const cMap & a_Map, int a_DataStartX, int a_DataStartY) override;
+	virtual void SendMapData              (const cMap & a_Map, int a_DataStartX, int a_DataStartY, int a_DataWidth, int a_DataHeight) override;
 	virtual void SendPaintingSpawn        (const cPainting & a_Painting) override;
 	virtual void SendPlayerMoveLook       (Vector3d a_Pos, float a_Yaw, float a_Pitch, bool a_IsRelative) override;
 	virtual void SendPlayerMoveLook       (void) override;
@@ -6,7 +6,226 @@
 #include "Globals.h"
 #include "RankManager.h"
 #include "Protocol/MojangAPI.h"
-#include "ClientHandle.h"
+
+
+
+
+
+/** How often the batch transaction is committed, i.e. the longest time a change waits before getting to the disk. */
+static const unsigned BATCH_COMMIT_INTERVAL_MSEC = 1000;
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cRankManager::cGraphChange:
+
+/** Wraps a single change of the ranks, groups, permissions or restrictions.
+Opens the batch transaction for the change and invalidates the cached graph once the change is done.
+The invalidation must come only after the change, otherwise a cache update done by a query within the change
+would be taken for an up-to-date one. */
+class cRankManager::cGraphChange
+{
+public:
+
+	cGraphChange(cRankManager & a_RankManager, bool a_AffectsAllPlayers = false):
+		m_RankManager(a_RankManager),
+		m_AffectsAllPlayers(a_AffectsAllPlayers)
+	{
+		m_RankManager.BeginBatch();
+	}
+
+	~cGraphChange()
+	{
+		++m_RankManager.m_GraphGeneration;
+		if (m_AffectsAllPlayers)
+		{
+			++m_RankManager.m_PlayersGeneration;
+		}
+	}
+
+private:
+
+	cRankManager & m_RankManager;
+
+	/** Set if the change may modify any number of players, so that the cached players get invalidated, too. */
+	bool m_AffectsAllPlayers;
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cRankManager::cPlayerChange:
+
+/** Wraps a single change of a single player's record.
+Opens the batch transaction for the change and updates the player's cached record once the change is done. */
+class cRankManager::cPlayerChange
+{
+public:
+
+	cPlayerChange(cRankManager & a_RankManager, const AString & a_StrUUID):
+		m_RankManager(a_RankManager),
+		m_StrUUID(a_StrUUID)
+	{
+		m_RankManager.BeginBatch();
+	}
+
+	~cPlayerChange()
+	{
+		m_RankManager.UpdateCachedPlayer(m_StrUUID);
+	}
+
+private:
+
+	cRankManager & m_RankManager;
+
+	/** The short UUID of the player being changed. */
+	AString m_StrUUID;
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cRankManager::sCache:
+
+int cRankManager::sCache::FindRankID(const AString & a_RankName) const
+{
+	auto itr = m_RankIDs.find(a_RankName);
+	return (itr == m_RankIDs.end()) ? -1 : itr->second;
+}
+
+
+
+
+
+int cRankManager::sCache::FindGroupID(const AString & a_GroupName) const
+{
+	auto itr = m_GroupIDs.find(a_GroupName);
+	return (itr == m_GroupIDs.end()) ? -1 : itr->second;
+}
+
+
+
+
+
+const cRankManager::sPlayer * cRankManager::sCache::FindPlayer(const cUUID & a_PlayerUUID) const
+{
+	auto itr = m_Players.find(a_PlayerUUID.ToShortString());
+	return (itr == m_Players.end()) ? nullptr : &itr->second;
+}
+
+
+
+
+
+int cRankManager::sCache::FindPlayerRankID(const cUUID & a_PlayerUUID, const AString & a_DefaultRank) const
+{
+	const auto Player = FindPlayer(a_PlayerUUID);
+	if ((Player != nullptr) && (m_Ranks.find(Player->m_RankID) != m_Ranks.end()))
+	{
+		return Player->m_RankID;
+	}
+	return FindRankID(a_DefaultRank);
+}
+
+
+
+
+
+AStringVector cRankManager::sCache::GetRankGroupNames(int a_RankID) const
+{
+	AStringVector res;
+	auto Bindings = m_RankGroups.find(a_RankID);
+	if (Bindings == m_RankGroups.end())
+	{
+		return res;
+	}
+	for (const auto GroupID: Bindings->second)
+	{
+		// Skip any bindings to groups that don't exist:
+		auto Group = m_Groups.find(GroupID);
+		if (Group != m_Groups.end())
+		{
+			res.push_back(Group->second);
+		}
+	}
+	return res;
+}
+
+
+
+
+
+AStringVector cRankManager::sCache::GetRankItems(const std::unordered_map<int, AStringVector> & a_Items, int a_RankID) const
+{
+	AStringVector res;
+	auto Bindings = m_RankGroups.find(a_RankID);
+	if (Bindings == m_RankGroups.end())
+	{
+		return res;
+	}
+	for (const auto GroupID: Bindings->second)
+	{
+		auto Items = a_Items.find(GroupID);
+		if (Items != a_Items.end())
+		{
+			res.insert(res.end(), Items->second.begin(), Items->second.end());
+		}
+	}
+	return res;
+}
+
+
+
+
+
+AStringVector cRankManager::sCache::GetGroupItems(const std::unordered_map<int, AStringVector> & a_Items, int a_GroupID)
+{
+	auto Items = a_Items.find(a_GroupID);
+	return (Items == a_Items.end()) ? AStringVector() : Items->second;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cRankManager::cBatchCommitter:
+
+cRankManager::cBatchCommitter::cBatchCommitter(cRankManager & a_Parent):
+	Super("RankManager"),
+	m_Parent(a_Parent)
+{
+}
+
+
+
+
+
+cRankManager::cBatchCommitter::~cBatchCommitter()
+{
+	m_ShouldTerminate = true;
+	m_Wake.Set();
+	Stop();
+}
+
+
+
+
+
+void cRankManager::cBatchCommitter::Execute(void)
+{
+	while (!m_ShouldTerminate)
+	{
+		m_Wake.Wait(BATCH_COMMIT_INTERVAL_MSEC);
+		m_Parent.CommitBatch();
+	}
+}
 
 
 
@@ -17,7 +236,9 @@
 
 cRankManager::cRankManager(void) :
 	m_DB("Ranks.sqlite", SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE),
-	m_IsInitialized(false)
+	m_IsInitialized(false),
+	m_GraphGeneration(1),
+	m_PlayersGeneration(1)
 {
 }
 
@@ -27,6 +248,32 @@ cRankManager::cRankManager(void) :
 
 cRankManager::~cRankManager()
 {
+	// Stop the background commits first, then commit whatever is left:
+	m_BatchCommitter.reset();
+	CommitBatch();
+}
+
+
+
+
+
+template <typename Func>
+auto cRankManager::ReadCache(Func a_Func)
+{
+	ASSERT(m_IsInitialized);
+
+	{
+		std::shared_lock<std::shared_mutex> Lock(m_CacheLock);
+		if ((m_Cache.m_GraphGeneration == m_GraphGeneration) && (m_Cache.m_PlayersGeneration == m_PlayersGeneration))
+		{
+			return a_Func(m_Cache);
+		}
+	}
+
+	// The cache is stale, update it first:
+	UpdateCache();
+	std::shared_lock<std::shared_mutex> Lock(m_CacheLock);
+	return a_Func(m_Cache);
 }
 
 
@@ -48,6 +295,10 @@ void cRankManager::Initialize(cMojangAPI & a_MojangAPI)
 
 	m_IsInitialized = true;
 
+	// Commit the changes periodically in the background:
+	m_BatchCommitter = std::make_unique<cBatchCommitter>(*this);
+	m_BatchCommitter->Start();
+
 	a_MojangAPI.SetRankManager(this);
 
 	// If tables are empty, create default ranks
@@ -89,26 +340,16 @@ void cRankManager::Initialize(cMojangAPI & a_MojangAPI)
 
 AString cRankManager::GetPlayerRankName(const cUUID & a_PlayerUUID)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
+	return ReadCache([&a_PlayerUUID](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT Rank.Name FROM Rank LEFT JOIN PlayerRank ON Rank.RankID = PlayerRank.RankID WHERE PlayerRank.PlayerUUID = ?");
-		stmt.bind(1, a_PlayerUUID.ToShortString());
-		// executeStep returns false on no data
-		if (!stmt.executeStep())
+		const auto Player = a_Cache.FindPlayer(a_PlayerUUID);
+		if (Player == nullptr)
 		{
-			// No data returned from the DB
 			return AString();
 		}
-		return stmt.getColumn(0).getText();
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Cannot get player rank name: %s", __FUNCTION__, ex.what());
-	}
-	return AString();
+		const auto Rank = a_Cache.m_Ranks.find(Player->m_RankID);
+		return (Rank == a_Cache.m_Ranks.end()) ? AString() : Rank->second.m_Name;
+	});
 }
 
 
@@ -117,25 +358,11 @@ AString cRankManager::GetPlayerRankName(const cUUID & a_PlayerUUID)
 
 AString cRankManager::GetPlayerName(const cUUID & a_PlayerUUID)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
+	return ReadCache([&a_PlayerUUID](const sCache & a_Cache)
 	{
-		// Prepare the DB statement:
-		SQLite::Statement stmt(m_DB, "SELECT PlayerName FROM PlayerRank WHERE PlayerUUID = ?");
-		stmt.bind(1, a_PlayerUUID.ToShortString());
-
-		if (stmt.executeStep())
-		{
-			return stmt.getColumn(0).getText();
-		}
-	}
-	catch (SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Cannot get player name: %s", __FUNCTION__, ex.what());
-	}
-	return AString();
+		const auto Player = a_Cache.FindPlayer(a_PlayerUUID);
+		return (Player == nullptr) ? AString() : Player->m_Name;
+	});
 }
 
 
@@ -144,32 +371,11 @@ AString cRankManager::GetPlayerName(const cUUID & a_PlayerUUID)
 
 AStringVector cRankManager::GetPlayerGroups(const cUUID & a_PlayerUUID)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
+	return ReadCache([&a_PlayerUUID](const sCache & a_Cache)
 	{
-		// Prepare the DB statement:
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermGroup.Name FROM PermGroup "
-				"LEFT JOIN RankPermGroup ON PermGroup.PermGroupID = RankPermGroup.PermGroupID "
-				"LEFT JOIN PlayerRank ON PlayerRank.RankID = RankPermGroup.RankID "
-			"WHERE PlayerRank.PlayerUUID = ?"
-		);
-		stmt.bind(1, a_PlayerUUID.ToShortString());
-
-		// Execute and get results:
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Cannot get player groups: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		const auto Player = a_Cache.FindPlayer(a_PlayerUUID);
+		return (Player == nullptr) ? AStringVector() : a_Cache.GetRankGroupNames(Player->m_RankID);
+	});
 }
 
 
@@ -178,12 +384,10 @@ AStringVector cRankManager::GetPlayerGroups(const cUUID & a_PlayerUUID)
 
 AStringVector cRankManager::GetPlayerPermissions(const cUUID & a_PlayerUUID)
 {
-	AString Rank = GetPlayerRankName(a_PlayerUUID);
-	if (Rank.empty())
+	return ReadCache([this, &a_PlayerUUID](const sCache & a_Cache)
 	{
-		Rank = m_DefaultRank;
-	}
-	return GetRankPermissions(Rank);
+		return a_Cache.GetRankItems(a_Cache.m_GroupPermissions, a_Cache.FindPlayerRankID(a_PlayerUUID, m_DefaultRank));
+	});
 }
 
 
@@ -192,12 +396,10 @@ AStringVector cRankManager::GetPlayerPermissions(const cUUID & a_PlayerUUID)
 
 AStringVector cRankManager::GetPlayerRestrictions(const cUUID & a_PlayerUUID)
 {
-	AString Rank = GetPlayerRankName(a_PlayerUUID);
-	if (Rank.empty())
+	return ReadCache([this, &a_PlayerUUID](const sCache & a_Cache)
 	{
-		Rank = m_DefaultRank;
-	}
-	return GetRankRestrictions(Rank);
+		return a_Cache.GetRankItems(a_Cache.m_GroupRestrictions, a_Cache.FindPlayerRankID(a_PlayerUUID, m_DefaultRank));
+	});
 }
 
 
@@ -206,29 +408,11 @@ AStringVector cRankManager::GetPlayerRestrictions(const cUUID & a_PlayerUUID)
 
 AStringVector cRankManager::GetRankGroups(const AString & a_RankName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
+	return ReadCache([&a_RankName](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermGroup.Name FROM PermGroup "
-				"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermGroup.PermGroupID "
-				"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
-			"WHERE Rank.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get rank groups from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		const auto RankID = a_Cache.FindRankID(a_RankName);
+		return (RankID == -1) ? AStringVector() : a_Cache.GetRankGroupNames(RankID);
+	});
 }
 
 
@@ -237,28 +421,11 @@ AStringVector cRankManager::GetRankGroups(const AString & a_RankName)
 
 AStringVector cRankManager::GetGroupPermissions(const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
+	return ReadCache([&a_GroupName](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermissionItem.Permission FROM PermissionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = PermissionItem.PermGroupID "
-			"WHERE PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_GroupName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get group permissions from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		const auto GroupID = a_Cache.FindGroupID(a_GroupName);
+		return (GroupID == -1) ? AStringVector() : sCache::GetGroupItems(a_Cache.m_GroupPermissions, GroupID);
+	});
 }
 
 
@@ -267,28 +434,11 @@ AStringVector cRankManager::GetGroupPermissions(const AString & a_GroupName)
 
 AStringVector cRankManager::GetGroupRestrictions(const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT RestrictionItem.Permission FROM RestrictionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RestrictionItem.PermGroupID "
-			"WHERE PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_GroupName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	return ReadCache([&a_GroupName](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to get group restrictions from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		const auto GroupID = a_Cache.FindGroupID(a_GroupName);
+		return (GroupID == -1) ? AStringVector() : sCache::GetGroupItems(a_Cache.m_GroupRestrictions, GroupID);
+	});
 }
 
 
@@ -297,29 +447,11 @@ AStringVector cRankManager::GetGroupRestrictions(const AString & a_GroupName)
 
 AStringVector cRankManager::GetRankPermissions(const AString & a_RankName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT PermissionItem.Permission FROM PermissionItem "
-				"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermissionItem.PermGroupID "
-				"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
-			"WHERE Rank.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	return ReadCache([&a_RankName](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to get rank permissions from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		const auto RankID = a_Cache.FindRankID(a_RankName);
+		return (RankID == -1) ? AStringVector() : a_Cache.GetRankItems(a_Cache.m_GroupPermissions, RankID);
+	});
 }
 
 
@@ -328,29 +460,11 @@ AStringVector cRankManager::GetRankPermissions(const AString & a_RankName)
 
 AStringVector cRankManager::GetRankRestrictions(const AString & a_RankName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT RestrictionItem.Permission FROM RestrictionItem "
-				"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = RestrictionItem.PermGroupID "
-				"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
-			"WHERE Rank.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	return ReadCache([&a_RankName](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to get rank restrictions from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		const auto RankID = a_Cache.FindRankID(a_RankName);
+		return (RankID == -1) ? AStringVector() : a_Cache.GetRankItems(a_Cache.m_GroupRestrictions, RankID);
+	});
 }
 
 
@@ -359,29 +473,35 @@ AStringVector cRankManager::GetRankRestrictions(const AString & a_RankName)
 
 std::vector<cUUID> cRankManager::GetAllPlayerUUIDs(void)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	cUUID tempUUID;
-	std::vector<cUUID> res;
-	try
+	return ReadCache([](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT PlayerUUID FROM PlayerRank ORDER BY PlayerName COLLATE NOCASE");
-		while (stmt.executeStep())
+		// Sort the players by their name, ignoring the case (same as the DB's NOCASE collation):
+		std::vector<std::pair<AString, cUUID>> Players;
+		Players.reserve(a_Cache.m_Players.size());
+		cUUID tempUUID;
+		for (const auto & Player: a_Cache.m_Players)
 		{
-			if (!tempUUID.FromString(stmt.getColumn(0).getText()))
+			if (!tempUUID.FromString(Player.first))
 			{
 				// Invalid UUID, ignore
 				continue;
 			}
-			res.push_back(tempUUID);
+			Players.emplace_back(StrToLower(Player.second.m_Name), tempUUID);
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get players from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		std::stable_sort(Players.begin(), Players.end(), [](const auto & a_First, const auto & a_Second)
+			{
+				return (a_First.first < a_Second.first);
+			}
+		);
+
+		std::vector<cUUID> res;
+		res.reserve(Players.size());
+		for (const auto & Player: Players)
+		{
+			res.push_back(Player.second);
+		}
+		return res;
+	});
 }
 
 
@@ -390,23 +510,16 @@ std::vector<cUUID> cRankManager::GetAllPlayerUUIDs(void)
 
 AStringVector cRankManager::GetAllRanks(void)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
+	return ReadCache([](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT Name FROM Rank");
-		while (stmt.executeStep())
+		AStringVector res;
+		res.reserve(a_Cache.m_Ranks.size());
+		for (const auto & Rank: a_Cache.m_Ranks)
 		{
-			res.push_back(stmt.getColumn(0).getText());
+			res.push_back(Rank.second.m_Name);
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get ranks from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		return res;
+	});
 }
 
 
@@ -415,48 +528,28 @@ AStringVector cRankManager::GetAllRanks(void)
 
 AStringVector cRankManager::GetAllGroups(void)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
+	return ReadCache([](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT Name FROM PermGroup");
-		while (stmt.executeStep())
+		AStringVector res;
+		res.reserve(a_Cache.m_Groups.size());
+		for (const auto & Group: a_Cache.m_Groups)
 		{
-			res.push_back(stmt.getColumn(0).getText());
+			res.push_back(Group.second);
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get groups from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		return res;
+	});
 }
 
-
-
-
-
-AStringVector cRankManager::GetAllPermissions(void)
-{
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT DISTINCT(Permission) FROM PermissionItem");
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+
+
+
+
+AStringVector cRankManager::GetAllPermissions(void)
+{
+	return ReadCache([](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to get permissions from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		return a_Cache.m_AllPermissions;
+	});
 }
 
 
@@ -465,23 +558,10 @@ AStringVector cRankManager::GetAllPermissions(void)
 
 AStringVector cRankManager::GetAllRestrictions(void)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AStringVector res;
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT DISTINCT(Permission) FROM RestrictionItem");
-		while (stmt.executeStep())
-		{
-			res.push_back(stmt.getColumn(0).getText());
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	return ReadCache([](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to get restrictions from DB: %s", __FUNCTION__, ex.what());
-	}
-	return res;
+		return a_Cache.m_AllRestrictions;
+	});
 }
 
 
@@ -535,6 +615,7 @@ void cRankManager::AddRank(
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -578,6 +659,7 @@ void cRankManager::AddGroup(const AString & a_GroupName)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -618,6 +700,7 @@ void cRankManager::AddGroups(const AStringVector & a_GroupNames)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -661,6 +744,7 @@ bool cRankManager::AddGroupToRank(const AString & a_GroupName, const AString & a
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -739,6 +823,7 @@ bool cRankManager::AddPermissionToGroup(const AString & a_Permission, const AStr
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -806,6 +891,7 @@ bool cRankManager::AddRestrictionToGroup(const AString & a_Restriction, const AS
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -873,6 +959,7 @@ bool cRankManager::AddPermissionsToGroup(const AStringVector & a_Permissions, co
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -943,6 +1030,7 @@ bool cRankManager::AddRestrictionsToGroup(const AStringVector & a_Restrictions,
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1013,6 +1101,7 @@ void cRankManager::RemoveRank(const AString & a_RankName, const AString & a_Repl
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this, true);
 
 	// Check if the default rank is being removed with a proper replacement:
 	if ((a_RankName == m_DefaultRank) && !RankExists(a_ReplacementRankName))
@@ -1082,6 +1171,7 @@ void cRankManager::RemoveRank(const AString & a_RankName, const AString & a_Repl
 		// Update the default rank, if it was the one being removed:
 		if (a_RankName == m_DefaultRank)
 		{
+			std::unique_lock<std::shared_mutex> CacheLock(m_CacheLock);  // The queries read m_DefaultRank under the cache lock
 			m_DefaultRank = a_RankName;
 		}
 	}
@@ -1099,6 +1189,7 @@ void cRankManager::RemoveGroup(const AString & a_GroupName)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1150,6 +1241,7 @@ void cRankManager::RemoveGroupFromRank(const AString & a_GroupName, const AStrin
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1202,6 +1294,7 @@ void cRankManager::RemovePermissionFromGroup(const AString & a_Permission, const
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1242,6 +1335,7 @@ void cRankManager::RemoveRestrictionFromGroup(const AString & a_Restriction, con
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1282,6 +1376,7 @@ bool cRankManager::RenameRank(const AString & a_OldName, const AString & a_NewNa
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1311,6 +1406,7 @@ bool cRankManager::RenameRank(const AString & a_OldName, const AString & a_NewNa
 		// Update the default rank, if it was the one being renamed:
 		if (a_OldName == m_DefaultRank)
 		{
+			std::unique_lock<std::shared_mutex> CacheLock(m_CacheLock);  // The queries read m_DefaultRank under the cache lock
 			m_DefaultRank = a_NewName;
 		}
 
@@ -1332,6 +1428,7 @@ bool cRankManager::RenameGroup(const AString & a_OldName, const AString & a_NewN
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1375,6 +1472,7 @@ void cRankManager::SetPlayerRank(const cUUID & a_PlayerUUID, const AString & a_P
 	cCSLock Lock(m_CS);
 
 	AString StrUUID = a_PlayerUUID.ToShortString();
+	cPlayerChange Change(*this, StrUUID);
 
 	try
 	{
@@ -1437,6 +1535,7 @@ void cRankManager::RemovePlayerRank(const cUUID & a_PlayerUUID)
 	cCSLock Lock(m_CS);
 
 	AString StrUUID = a_PlayerUUID.ToShortString();
+	cPlayerChange Change(*this, StrUUID);
 
 	try
 	{
@@ -1465,6 +1564,7 @@ void cRankManager::SetRankVisuals(
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	cGraphChange Change(*this);
 
 	try
 	{
@@ -1495,28 +1595,19 @@ bool cRankManager::GetRankVisuals(
 	AString & a_MsgNameColorCode
 )
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
+	return ReadCache([&](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB, "SELECT MsgPrefix, MsgSuffix, MsgNameColorCode FROM Rank WHERE Name = ?");
-		stmt.bind(1, a_RankName);
-		if (!stmt.executeStep())
+		const auto Rank = a_Cache.m_Ranks.find(a_Cache.FindRankID(a_RankName));
+		if (Rank == a_Cache.m_Ranks.end())
 		{
 			// Rank not found
 			return false;
 		}
-		a_MsgPrefix = stmt.getColumn(0).getText();
-		a_MsgSuffix = stmt.getColumn(1).getText();
-		a_MsgNameColorCode = stmt.getColumn(2).getText();
+		a_MsgPrefix = Rank->second.m_MsgPrefix;
+		a_MsgSuffix = Rank->second.m_MsgSuffix;
+		a_MsgNameColorCode = Rank->second.m_MsgNameColorCode;
 		return true;
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to get ranks from DB: %s", __FUNCTION__, ex.what());
-	}
-	return false;
+	});
 }
 
 
@@ -1525,24 +1616,10 @@ bool cRankManager::GetRankVisuals(
 
 bool cRankManager::RankExists(const AString & a_RankName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT * FROM Rank WHERE Name = ?");
-		stmt.bind(1, a_RankName);
-		if (stmt.executeStep())
-		{
-			// The rank was found
-			return true;
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	return ReadCache([&a_RankName](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to query DB for rank %s: %s", __FUNCTION__, a_RankName.c_str(), ex.what());
-	}
-	return false;
+		return (a_Cache.FindRankID(a_RankName) != -1);
+	});
 }
 
 
@@ -1551,24 +1628,10 @@ bool cRankManager::RankExists(const AString & a_RankName)
 
 bool cRankManager::GroupExists(const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT * FROM PermGroup WHERE Name = ?");
-		stmt.bind(1, a_GroupName);
-		if (stmt.executeStep())
-		{
-			// The group was found
-			return true;
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	return ReadCache([&a_GroupName](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to query DB for group %s: %s", __FUNCTION__, a_GroupName.c_str(), ex.what());
-	}
-	return false;
+		return (a_Cache.FindGroupID(a_GroupName) != -1);
+	});
 }
 
 
@@ -1577,26 +1640,10 @@ bool cRankManager::GroupExists(const AString & a_GroupName)
 
 bool cRankManager::IsPlayerRankSet(const cUUID & a_PlayerUUID)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	AString StrUUID = a_PlayerUUID.ToShortString();
-
-	try
-	{
-		SQLite::Statement stmt(m_DB, "SELECT * FROM PlayerRank WHERE PlayerUUID = ?");
-		stmt.bind(1, StrUUID);
-		if (stmt.executeStep())
-		{
-			// The player UUID was found, they have a rank
-			return true;
-		}
-	}
-	catch (const SQLite::Exception & ex)
+	return ReadCache([&a_PlayerUUID](const sCache & a_Cache)
 	{
-		LOGWARNING("%s: Failed to query DB for player UUID %s: %s", __FUNCTION__, StrUUID.c_str(), ex.what());
-	}
-	return false;
+		return (a_Cache.FindPlayer(a_PlayerUUID) != nullptr);
+	});
 }
 
 
@@ -1605,30 +1652,16 @@ bool cRankManager::IsPlayerRankSet(const cUUID & a_PlayerUUID)
 
 bool cRankManager::IsGroupInRank(const AString & a_GroupName, const AString & a_RankName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
+	return ReadCache([&](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT * FROM Rank "
-				"LEFT JOIN RankPermGroup ON Rank.RankID = RankPermGroup.RankID "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RankPermGroup.PermGroupID "
-			"WHERE Rank.Name = ? AND PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_RankName);
-		stmt.bind(2, a_GroupName);
-		if (stmt.executeStep())
+		const auto GroupID = a_Cache.FindGroupID(a_GroupName);
+		const auto Bindings = a_Cache.m_RankGroups.find(a_Cache.FindRankID(a_RankName));
+		if ((GroupID == -1) || (Bindings == a_Cache.m_RankGroups.end()))
 		{
-			// The group is in the rank
-			return true;
+			return false;
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to query DB: %s", __FUNCTION__, ex.what());
-	}
-	return false;
+		return (std::find(Bindings->second.begin(), Bindings->second.end(), GroupID) != Bindings->second.end());
+	});
 }
 
 
@@ -1637,29 +1670,15 @@ bool cRankManager::IsGroupInRank(const AString & a_GroupName, const AString & a_
 
 bool cRankManager::IsPermissionInGroup(const AString & a_Permission, const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
+	return ReadCache([&](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT * FROM PermissionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = PermissionItem.PermGroupID "
-			"WHERE PermissionItem.Permission = ? AND PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_Permission);
-		stmt.bind(2, a_GroupName);
-		if (stmt.executeStep())
+		const auto Permissions = a_Cache.m_GroupPermissions.find(a_Cache.FindGroupID(a_GroupName));
+		if (Permissions == a_Cache.m_GroupPermissions.end())
 		{
-			// The permission is in the group
-			return true;
+			return false;
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to query DB: %s", __FUNCTION__, ex.what());
-	}
-	return false;
+		return (std::find(Permissions->second.begin(), Permissions->second.end(), a_Permission) != Permissions->second.end());
+	});
 }
 
 
@@ -1668,29 +1687,15 @@ bool cRankManager::IsPermissionInGroup(const AString & a_Permission, const AStri
 
 bool cRankManager::IsRestrictionInGroup(const AString & a_Restriction, const AString & a_GroupName)
 {
-	ASSERT(m_IsInitialized);
-	cCSLock Lock(m_CS);
-
-	try
+	return ReadCache([&](const sCache & a_Cache)
 	{
-		SQLite::Statement stmt(m_DB,
-			"SELECT * FROM RestrictionItem "
-				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RestrictionItem.PermGroupID "
-			"WHERE RestrictionItem.Permission = ? AND PermGroup.Name = ?"
-		);
-		stmt.bind(1, a_Restriction);
-		stmt.bind(2, a_GroupName);
-		if (stmt.executeStep())
+		const auto Restrictions = a_Cache.m_GroupRestrictions.find(a_Cache.FindGroupID(a_GroupName));
+		if (Restrictions == a_Cache.m_GroupRestrictions.end())
 		{
-			// The restriction is in the group
-			return true;
+			return false;
 		}
-	}
-	catch (const SQLite::Exception & ex)
-	{
-		LOGWARNING("%s: Failed to query DB: %s", __FUNCTION__, ex.what());
-	}
-	return false;
+		return (std::find(Restrictions->second.begin(), Restrictions->second.end(), a_Restriction) != Restrictions->second.end());
+	});
 }
 
 
@@ -1702,11 +1707,14 @@ void cRankManager::NotifyNameUUID(const AString & a_PlayerName, const cUUID & a_
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
 
+	AString StrUUID = a_UUID.ToShortString();
+	cPlayerChange Change(*this, StrUUID);
+
 	try
 	{
 		SQLite::Statement stmt(m_DB, "UPDATE PlayerRank SET PlayerName = ? WHERE PlayerUUID = ?");
 		stmt.bind(1, a_PlayerName);
-		stmt.bind(2, a_UUID.ToShortString());
+		stmt.bind(2, StrUUID);
 		stmt.exec();
 	}
 	catch (const SQLite::Exception & ex)
@@ -1723,6 +1731,7 @@ bool cRankManager::SetDefaultRank(const AString & a_RankName)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	BeginBatch();
 
 	try
 	{
@@ -1756,7 +1765,10 @@ bool cRankManager::SetDefaultRank(const AString & a_RankName)
 		}
 
 		// Set the internal cache:
-		m_DefaultRank = a_RankName;
+		{
+			std::unique_lock<std::shared_mutex> CacheLock(m_CacheLock);  // The queries read m_DefaultRank under the cache lock
+			m_DefaultRank = a_RankName;
+		}
 		return true;
 	}
 	catch (const SQLite::Exception & ex)
@@ -1774,6 +1786,7 @@ void cRankManager::ClearPlayerRanks(void)
 {
 	ASSERT(m_IsInitialized);
 	cCSLock Lock(m_CS);
+	BeginBatch();
 
 	try
 	{
@@ -1784,6 +1797,9 @@ void cRankManager::ClearPlayerRanks(void)
 	{
 		LOGWARNING("%s: Failed to remove / clear all players: %s", __FUNCTION__, ex.what());
 	}
+
+	// Have the cached players re-read:
+	++m_PlayersGeneration;
 }
 
 
@@ -1796,6 +1812,7 @@ bool cRankManager::UpdatePlayerName(const cUUID & a_PlayerUUID, const AString &
 	cCSLock Lock(m_CS);
 
 	AString StrUUID = a_PlayerUUID.ToShortString();
+	cPlayerChange Change(*this, StrUUID);
 
 	try
 	{
@@ -1819,6 +1836,214 @@ bool cRankManager::UpdatePlayerName(const cUUID & a_PlayerUUID, const AString &
 
 
 
+void cRankManager::CommitBatch(void)
+{
+	cCSLock Lock(m_CS);
+	if (m_Batch == nullptr)
+	{
+		return;
+	}
+
+	try
+	{
+		m_Batch->commit();
+	}
+	catch (const SQLite::Exception & ex)
+	{
+		LOGWARNING("%s: Failed to commit the changes to the DB: %s", __FUNCTION__, ex.what());
+
+		// The changes are rolled back, have the cache re-read:
+		++m_GraphGeneration;
+		++m_PlayersGeneration;
+	}
+	m_Batch.reset();
+}
+
+
+
+
+
+void cRankManager::UpdateCache(void)
+{
+	cCSLock Lock(m_CS);
+	std::unique_lock<std::shared_mutex> CacheLock(m_CacheLock);
+
+	// The generations cannot change while m_CS is held, all the changes are done under it:
+	const UInt64 GraphGeneration = m_GraphGeneration;
+	if ((m_Cache.m_GraphGeneration != GraphGeneration) && LoadGraph())
+	{
+		m_Cache.m_GraphGeneration = GraphGeneration;
+	}
+	const UInt64 PlayersGeneration = m_PlayersGeneration;
+	if ((m_Cache.m_PlayersGeneration != PlayersGeneration) && LoadPlayers())
+	{
+		m_Cache.m_PlayersGeneration = PlayersGeneration;
+	}
+}
+
+
+
+
+
+bool cRankManager::LoadGraph(void)
+{
+	m_Cache.m_Ranks.clear();
+	m_Cache.m_RankIDs.clear();
+	m_Cache.m_Groups.clear();
+	m_Cache.m_GroupIDs.clear();
+	m_Cache.m_RankGroups.clear();
+	m_Cache.m_GroupPermissions.clear();
+	m_Cache.m_GroupRestrictions.clear();
+	m_Cache.m_AllPermissions.clear();
+	m_Cache.m_AllRestrictions.clear();
+
+	try
+	{
+		{
+			SQLite::Statement stmt(m_DB, "SELECT RankID, Name, MsgPrefix, MsgSuffix, MsgNameColorCode FROM Rank");
+			while (stmt.executeStep())
+			{
+				const int RankID = stmt.getColumn(0).getInt();
+				sRank & Rank = m_Cache.m_Ranks[RankID];
+				Rank.m_Name = stmt.getColumn(1).getText();
+				Rank.m_MsgPrefix = stmt.getColumn(2).getText();
+				Rank.m_MsgSuffix = stmt.getColumn(3).getText();
+				Rank.m_MsgNameColorCode = stmt.getColumn(4).getText();
+				m_Cache.m_RankIDs.emplace(Rank.m_Name, RankID);  // In case of duplicate names, the first one wins, same as in the DB queries
+			}
+		}
+		{
+			SQLite::Statement stmt(m_DB, "SELECT PermGroupID, Name FROM PermGroup");
+			while (stmt.executeStep())
+			{
+				const int GroupID = stmt.getColumn(0).getInt();
+				const AString Name = stmt.getColumn(1).getText();
+				m_Cache.m_Groups[GroupID] = Name;
+				m_Cache.m_GroupIDs.emplace(Name, GroupID);
+			}
+		}
+		{
+			SQLite::Statement stmt(m_DB, "SELECT RankID, PermGroupID FROM RankPermGroup");
+			while (stmt.executeStep())
+			{
+				m_Cache.m_RankGroups[stmt.getColumn(0).getInt()].push_back(stmt.getColumn(1).getInt());
+			}
+		}
+		{
+			SQLite::Statement stmt(m_DB, "SELECT PermGroupID, Permission FROM PermissionItem");
+			while (stmt.executeStep())
+			{
+				m_Cache.m_GroupPermissions[stmt.getColumn(0).getInt()].push_back(stmt.getColumn(1).getText());
+			}
+		}
+		{
+			SQLite::Statement stmt(m_DB, "SELECT PermGroupID, Permission FROM RestrictionItem");
+			while (stmt.executeStep())
+			{
+				m_Cache.m_GroupRestrictions[stmt.getColumn(0).getInt()].push_back(stmt.getColumn(1).getText());
+			}
+		}
+		{
+			SQLite::Statement stmt(m_DB, "SELECT DISTINCT(Permission) FROM PermissionItem");
+			while (stmt.executeStep())
+			{
+				m_Cache.m_AllPermissions.push_back(stmt.getColumn(0).getText());
+			}
+		}
+		{
+			SQLite::Statement stmt(m_DB, "SELECT DISTINCT(Permission) FROM RestrictionItem");
+			while (stmt.executeStep())
+			{
+				m_Cache.m_AllRestrictions.push_back(stmt.getColumn(0).getText());
+			}
+		}
+		return true;
+	}
+	catch (const SQLite::Exception & ex)
+	{
+		LOGWARNING("%s: Failed to load ranks and groups from DB: %s", __FUNCTION__, ex.what());
+	}
+	return false;
+}
+
+
+
+
+
+bool cRankManager::LoadPlayers(void)
+{
+	m_Cache.m_Players.clear();
+
+	try
+	{
+		SQLite::Statement stmt(m_DB, "SELECT PlayerUUID, PlayerName, RankID FROM PlayerRank");
+		while (stmt.executeStep())
+		{
+			m_Cache.m_Players.emplace(
+				stmt.getColumn(0).getText(),
+				sPlayer{ stmt.getColumn(1).getText(), stmt.getColumn(2).getInt() }
+			);
+		}
+		return true;
+	}
+	catch (const SQLite::Exception & ex)
+	{
+		LOGWARNING("%s: Failed to load players from DB: %s", __FUNCTION__, ex.what());
+	}
+	return false;
+}
+
+
+
+
+
+void cRankManager::UpdateCachedPlayer(const AString & a_StrUUID)
+{
+	if (m_Cache.m_PlayersGeneration != m_PlayersGeneration)
+	{
+		// All the players are going to be re-read anyway
+		return;
+	}
+
+	try
+	{
+		SQLite::Statement stmt(m_DB, "SELECT PlayerName, RankID FROM PlayerRank WHERE PlayerUUID = ?");
+		stmt.bind(1, a_StrUUID);
+		if (stmt.executeStep())
+		{
+			sPlayer Player{ stmt.getColumn(0).getText(), stmt.getColumn(1).getInt() };
+			std::unique_lock<std::shared_mutex> CacheLock(m_CacheLock);
+			m_Cache.m_Players[a_StrUUID] = std::move(Player);
+		}
+		else
+		{
+			std::unique_lock<std::shared_mutex> CacheLock(m_CacheLock);
+			m_Cache.m_Players.erase(a_StrUUID);
+		}
+	}
+	catch (const SQLite::Exception & ex)
+	{
+		LOGWARNING("%s: Failed to query DB for player UUID %s: %s", __FUNCTION__, a_StrUUID.c_str(), ex.what());
+		++m_PlayersGeneration;
+	}
+}
+
+
+
+
+
+void cRankManager::BeginBatch(void)
+{
+	if (m_Batch == nullptr)
+	{
+		m_Batch = std::make_unique<SQLite::Transaction>(m_DB);
+	}
+}
+
+
+
+
+
 bool cRankManager::AreDBTablesEmpty(void)
 {
 	return (
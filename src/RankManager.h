@@ -3,11 +3,24 @@
 
 // Declares the cRankManager class that represents the rank manager responsible for assigning permissions and message visuals to players
 
+/*
+All the queries are served from an in-memory copy of the DB, so that the frequent lookups done for each player
+(permissions, message visuals) don't need to go to SQLite and don't block each other:
+	- the ranks, groups and their permissions / restrictions ("the graph") are cached as a whole. Each change to them
+	increments m_GraphGeneration; the next query that finds the cache older than that re-reads the graph from the DB;
+	- the players are cached in a separate map, because they change often (each login updates the player's name).
+	A change to a single player updates just that player's cached record, only the changes affecting many players
+	(removing a rank, clearing all players) increment m_PlayersGeneration and have the map re-read.
+The changes are executed on the DB right away, but into a long-running "batch" transaction that the cBatchCommitter
+thread commits periodically, so that a burst of changes costs a single disk sync.
+*/
+
 
 
 
 #pragma once
 
+#include "OSSupport/IsThread.h"
 #include "SQLiteCpp/Database.h"
 #include "SQLiteCpp/Transaction.h"
 
@@ -25,25 +38,19 @@ class cRankManager
 {
 public:
 	/** Acquire this lock to perform mass changes.
-	Improves performance by wrapping everything into a transaction.
-	Makes sure that no other thread is accessing the DB. */
+	Makes sure that no other thread is accessing the DB, and that all the changes made while the lock is held
+	are committed together, in the same batch transaction. */
 	class cMassChangeLock
 	{
 	public:
 		cMassChangeLock(cRankManager & a_RankManager) :
-			m_Lock(a_RankManager.m_CS),
-			m_Transaction(a_RankManager.m_DB)
-		{
-		}
-
-		~cMassChangeLock()
+			m_Lock(a_RankManager.m_CS)
 		{
-			m_Transaction.commit();
+			a_RankManager.BeginBatch();
 		}
 
 	protected:
 		cCSLock m_Lock;
-		SQLite::Transaction m_Transaction;
 	};
 
 
@@ -259,20 +266,175 @@ public:
 	/** Updates the playername that is saved with this uuid. Returns false if a error occurred */
 	bool UpdatePlayerName(const cUUID & a_PlayerUUID, const AString & a_NewPlayerName);
 
+	/** Commits the changes made so far to the disk, if there are any.
+	Normally the changes are committed periodically by a background thread; this is for the cases when they are needed
+	on the disk right away. */
+	void CommitBatch(void);
+
 protected:
 
+	class cGraphChange;
+	class cPlayerChange;
+
+
+	/** A single rank, as cached from the Rank table. */
+	struct sRank
+	{
+		AString m_Name;
+		AString m_MsgPrefix;
+		AString m_MsgSuffix;
+		AString m_MsgNameColorCode;
+	};
+
+
+	/** A single player, as cached from the PlayerRank table. */
+	struct sPlayer
+	{
+		AString m_Name;
+		int m_RankID;
+	};
+
+
+	/** The in-memory copy of the DB contents. */
+	struct sCache
+	{
+		/** All the ranks, mapped by RankID. Ordered, so that GetAllRanks() returns the ranks in the DB order. */
+		std::map<int, sRank> m_Ranks;
+
+		/** Maps rank names to their RankID. */
+		std::map<AString, int> m_RankIDs;
+
+		/** All the groups' names, mapped by PermGroupID. */
+		std::map<int, AString> m_Groups;
+
+		/** Maps group names to their PermGroupID. */
+		std::map<AString, int> m_GroupIDs;
+
+		/** The PermGroupIDs bound to each RankID. */
+		std::unordered_map<int, std::vector<int>> m_RankGroups;
+
+		/** The permissions and restrictions of each PermGroupID. */
+		std::unordered_map<int, AStringVector> m_GroupPermissions;
+		std::unordered_map<int, AStringVector> m_GroupRestrictions;
+
+		/** All the distinct permissions and restrictions, in the DB order. */
+		AStringVector m_AllPermissions;
+		AStringVector m_AllRestrictions;
+
+		/** All the players, mapped by their short UUID string. */
+		std::unordered_map<AString, sPlayer> m_Players;
+
+		/** The values of m_GraphGeneration and m_PlayersGeneration that the cached data corresponds to. */
+		UInt64 m_GraphGeneration = 0;
+		UInt64 m_PlayersGeneration = 0;
+
+
+		/** Returns the RankID of the specified rank, or -1 if there's no such rank. */
+		int FindRankID(const AString & a_RankName) const;
+
+		/** Returns the PermGroupID of the specified group, or -1 if there's no such group. */
+		int FindGroupID(const AString & a_GroupName) const;
+
+		/** Returns the specified player, or nullptr if they are not in the DB. */
+		const sPlayer * FindPlayer(const cUUID & a_PlayerUUID) const;
+
+		/** Returns the RankID of the rank assigned to the specified player.
+		If the player has no rank assigned (or the rank doesn't exist), returns the RankID of a_DefaultRank, or -1 if that doesn't exist either. */
+		int FindPlayerRankID(const cUUID & a_PlayerUUID, const AString & a_DefaultRank) const;
+
+		/** Returns the names of the existing groups bound to the specified rank. */
+		AStringVector GetRankGroupNames(int a_RankID) const;
+
+		/** Returns the items of all the groups bound to the specified rank, from a_Items (m_GroupPermissions or m_GroupRestrictions). */
+		AStringVector GetRankItems(const std::unordered_map<int, AStringVector> & a_Items, int a_RankID) const;
+
+		/** Returns the items of the specified group from a_Items (m_GroupPermissions or m_GroupRestrictions). */
+		static AStringVector GetGroupItems(const std::unordered_map<int, AStringVector> & a_Items, int a_GroupID);
+	};
+
+
+	/** The thread that commits the batch transaction periodically. */
+	class cBatchCommitter:
+		public cIsThread
+	{
+		using Super = cIsThread;
+
+	public:
+
+		cBatchCommitter(cRankManager & a_Parent);
+		virtual ~cBatchCommitter() override;
+
+	private:
+
+		cRankManager & m_Parent;
+
+		/** Set to wake the thread up when it is to terminate. */
+		cEvent m_Wake;
+
+		// cIsThread override:
+		virtual void Execute(void) override;
+	};
+
+
 	/** The database storage for all the data. Protected by m_CS. */
 	SQLite::Database m_DB;
 
-	/** The name of the default rank. Kept as a cache so that queries for it don't need to go through the DB. */
+	/** The name of the default rank. Kept as a cache so that queries for it don't need to go through the DB.
+	Written while holding both m_CS and m_CacheLock, so that the queries can read it under m_CacheLock alone. */
 	AString m_DefaultRank;
 
-	/** The mutex protecting m_DB and m_DefaultRank against multi-threaded access. */
+	/** The mutex protecting m_DB and m_DefaultRank against multi-threaded access.
+	Also serializes the cache updates, so that the cache is always read from a consistent DB. */
 	cCriticalSection m_CS;
 
 	/** Set to true once the manager is initialized. */
 	bool m_IsInitialized;
 
+	/** The transaction into which all the changes are made, until it is committed by CommitBatch().
+	nullptr when there are no uncommitted changes. Protected by m_CS. */
+	std::unique_ptr<SQLite::Transaction> m_Batch;
+
+	/** The thread committing m_Batch periodically. */
+	std::unique_ptr<cBatchCommitter> m_BatchCommitter;
+
+	/** The in-memory copy of the DB. Protected by m_CacheLock, only modified while holding m_CS, too. */
+	sCache m_Cache;
+
+	/** Protects m_Cache. The queries share it for reading, the cache updates take it exclusively. */
+	std::shared_mutex m_CacheLock;
+
+	/** Incremented on each change to the ranks, groups, permissions or restrictions.
+	The cached graph is re-read from the DB when it doesn't match m_Cache.m_GraphGeneration. */
+	std::atomic<UInt64> m_GraphGeneration;
+
+	/** Incremented on each change that affects more than a single player.
+	The cached players are re-read from the DB when it doesn't match m_Cache.m_PlayersGeneration. */
+	std::atomic<UInt64> m_PlayersGeneration;
+
+
+	/** Calls a_Func with the up-to-date cache, locked for reading, and returns its result. */
+	template <typename Func>
+	auto ReadCache(Func a_Func);
+
+	/** Re-reads the stale parts of the cache from the DB. */
+	void UpdateCache(void);
+
+	/** Reads the ranks, groups, permissions and restrictions from the DB into m_Cache.
+	Must be called with both m_CS and m_CacheLock held. Returns true on success. */
+	bool LoadGraph(void);
+
+	/** Reads the players from the DB into m_Cache.
+	Must be called with both m_CS and m_CacheLock held. Returns true on success. */
+	bool LoadPlayers(void);
+
+	/** Updates the cached record of the specified player from the DB, after a change of that single player.
+	Must be called with m_CS held. */
+	void UpdateCachedPlayer(const AString & a_StrUUID);
+
+	/** Opens the batch transaction, unless already open. All the changes to the DB are done within it.
+	Must be called with m_CS held. */
+	void BeginBatch(void);
+
 	/** Returns true if all the DB tables are empty, indicating a fresh new install. */
 	bool AreDBTablesEmpty(void);
 
@@ -44,12 +44,14 @@
 #include "Protocol/ProtocolRecognizer.h"  // for protocol version constants
 #include "CommandOutput.h"
 #include "DeadlockDetect.h"
+#include "Profiler.h"
 #include "LoggerListeners.h"
 #include "BuildInfo.h"
 #include "IniFile.h"
 #include "OverridesSettingsRepository.h"
 #include "Logger.h"
 #include "ClientHandle.h"
+#include "Metrics.h"
 
 
 
@@ -190,8 +192,17 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	LOGD("Starting Authenticator...");
 	m_Authenticator.Start(*settingsRepo);
 
+	// The number of network event loops is applied by main() when (re)starting the network, only make sure it's listed:
+	settingsRepo->GetValueSetI("Network", "EventLoops", 0);
+
+	// Recording a scope only costs two clock reads and a write into a per-thread ring buffer. It is on by default
+	// so that the slow tick captures are there when a lag spike needs investigating:
+	cProfiler::SetEnabled(settingsRepo->GetValueSetB("Profiler", "Enabled", true));
+	cProfiler::SetSlowTickThreshold(std::chrono::milliseconds(settingsRepo->GetValueSetI("Profiler", "SlowTickThresholdMs", 250)));
+
 	LOGD("Starting worlds...");
 	StartWorlds(dd);
+	AddMetricsCollectors();
 
 	if (settingsRepo->GetValueSetB("DeadlockDetect", "Enabled", true))
 	{
@@ -221,6 +232,7 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 		LOG("Shutting down server...");
 		m_Server->Shutdown();
 	}  // if (m_Server->Start()
+	RemoveMetricsCollectors();
 
 	delete m_MojangAPI; m_MojangAPI = nullptr;
 
@@ -233,6 +245,8 @@ bool cRoot::Run(cSettingsRepositoryInterface & a_OverridesRepo)
 	LOGD("Stopping authenticator...");
 	m_Authenticator.Stop();
 
+	cProfiler::Shutdown();
+
 	LOGD("Freeing MonsterConfig...");
 	delete m_MonsterConfig; m_MonsterConfig = nullptr;
 	delete m_WebAdmin; m_WebAdmin = nullptr;
@@ -453,6 +467,91 @@ void cRoot::StopWorlds(cDeadlockDetect & a_DeadlockDetect)
 
 
 
+void cRoot::AddMetricsCollectors(void)
+{
+	cMetrics::SetCollector("cuberite_world_entities", "Number of entities in the world, by class", [this](std::vector<cMetrics::sSample> & a_Samples)
+		{
+			ForEachWorld([&a_Samples](cWorld & a_World)
+				{
+					std::map<AString, int> Counts;
+					a_World.ForEachEntity([&Counts](cEntity & a_Entity)
+						{
+							Counts[a_Entity.GetClass()] += 1;
+							return false;
+						}
+					);
+					for (const auto & [Class, Count]: Counts)
+					{
+						a_Samples.push_back({ cMetrics::FormatLabels({{"world", a_World.GetName()}, {"class", Class}}), static_cast<double>(Count) });
+					}
+					return false;
+				}
+			);
+		}
+	);
+
+	cMetrics::SetCollector("cuberite_client_ping_seconds", "The client's latency, as measured by the keep-alive packets", [this](std::vector<cMetrics::sSample> & a_Samples)
+		{
+			ForEachPlayer([&a_Samples](cPlayer & a_Player)
+				{
+					auto Client = a_Player.GetClientHandle();
+					if (Client != nullptr)
+					{
+						a_Samples.push_back({ cMetrics::FormatLabels({{"player", a_Player.GetName()}}), Client->GetPing() / 1000.0 });
+					}
+					return false;
+				}
+			);
+		}
+	);
+
+	cMetrics::SetCollector("cuberite_client_compression_level", "The level at which the packets sent to the client are compressed", [this](std::vector<cMetrics::sSample> & a_Samples)
+		{
+			ForEachPlayer([&a_Samples](cPlayer & a_Player)
+				{
+					auto Client = a_Player.GetClientHandle();
+					if (Client != nullptr)
+					{
+						a_Samples.push_back({ cMetrics::FormatLabels({{"player", a_Player.GetName()}}), static_cast<double>(Client->GetCompressionLevel()) });
+					}
+					return false;
+				}
+			);
+		}
+	);
+
+	cMetrics::SetCollector("cuberite_client_send_backlog_bytes", "Number of bytes waiting to be sent to the client", [this](std::vector<cMetrics::sSample> & a_Samples)
+		{
+			ForEachPlayer([&a_Samples](cPlayer & a_Player)
+				{
+					auto Client = a_Player.GetClientHandle();
+					if (Client != nullptr)
+					{
+						a_Samples.push_back({ cMetrics::FormatLabels({{"player", a_Player.GetName()}}), static_cast<double>(Client->GetOutgoingDataBacklog()) });
+					}
+					return false;
+				}
+			);
+		}
+	);
+}
+
+
+
+
+
+void cRoot::RemoveMetricsCollectors(void)
+{
+	cMetrics::RemoveCollector("cuberite_world_entities");
+	cMetrics::RemoveCollector("cuberite_client_ping_seconds");
+	cMetrics::RemoveCollector("cuberite_client_compression_level");
+	cMetrics::RemoveCollector("cuberite_client_send_backlog_bytes");
+}
+
+
+
+
+
 cWorld * cRoot::GetDefaultWorld()
 {
 	ASSERT(m_pDefaultWorld != nullptr);
@@ -945,6 +1044,7 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		a_Output.OutLn(fmt::format(FMT_STRING("  Num chunks in generator queue: {}"), NumInGenerator));
 		a_Output.OutLn(fmt::format(FMT_STRING("  Num chunks in storage load queue: {}"), NumInLoadQueue));
 		a_Output.OutLn(fmt::format(FMT_STRING("  Num chunks in storage save queue: {}"), NumInSaveQueue));
+		a_Output.OutLn(fmt::format(FMT_STRING("  Num item entities merged: {}"), World.GetNumMergedItemEntities()));
 		int Mem = NumValid * static_cast<int>(sizeof(cChunk));
 		a_Output.OutLn(fmt::format(FMT_STRING("  Memory used by chunks: {} KiB ({} MiB)"), (Mem + 1023) / 1024, (Mem + 1024 * 1024 - 1) / (1024 * 1024)));
 		SumNumValid += NumValid;
@@ -246,6 +246,13 @@ private:
 	/** Stops each world's threads, so that it's safe to unload them */
 	void StopWorlds(cDeadlockDetect & a_DeadlockDetect);
 
+	/** Registers the cMetrics collectors of the per-world entity counts and per-client ping, send backlog and compression level.
+	They are computed on each scrape, so that the departed players and entity classes don't linger in the output. */
+	void AddMetricsCollectors(void);
+
+	/** Removes the collectors registered by AddMetricsCollectors(); must be called before the worlds are stopped. */
+	void RemoveMetricsCollectors(void);
+
 	static cRoot * s_Root;
 
 	/** Indicates the next action of cRoot, whether to run, stop or restart. */
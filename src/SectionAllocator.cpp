@@ -0,0 +1,360 @@
+
+// SectionAllocator.cpp
+
+// Implements the cSlabPool class that allocates the chunk sections from slabs
+
+#include "Globals.h"
+#include "SectionAllocator.h"
+
+#ifndef _WIN32
+	#include <sys/mman.h>
+#endif
+
+
+
+
+
+namespace
+{
+	/** The size of a single slab. Large enough for the section sizes to waste little of it. */
+	const size_t SLAB_SIZE = 1024 * 1024;
+
+	/** The number of pools that have a per-thread cache. There's one pool per section size, only a few are expected. */
+	const size_t MAX_CACHED_POOLS = 8;
+
+	/** The number of free blocks a thread keeps for each pool, at most. */
+	const size_t CACHE_SIZE = 32;
+
+
+
+
+
+	/** The free blocks kept by a single thread. Given back to the pools when the thread exits. */
+	struct sThreadCache
+	{
+		cSlabPool * m_Pools[MAX_CACHED_POOLS] = {};
+		std::vector<void *> m_Blocks[MAX_CACHED_POOLS];
+
+		~sThreadCache();
+	};
+
+	thread_local sThreadCache t_Cache;
+
+	/** Set once the thread's cache is gone; the blocks freed afterwards (by the thread's static objects) go straight to the pools. */
+	thread_local bool t_IsCacheDestroyed = false;
+
+
+
+
+
+	sThreadCache::~sThreadCache()
+	{
+		for (size_t i = 0; i < MAX_CACHED_POOLS; i++)
+		{
+			if (m_Pools[i] != nullptr)
+			{
+				m_Pools[i]->ReturnBlocks(m_Blocks[i]);
+			}
+		}
+		t_IsCacheDestroyed = true;
+	}
+
+
+
+
+
+	struct sRegistry
+	{
+		cCriticalSection m_CS;
+		std::vector<cSlabPool *> m_Pools;
+	};
+
+
+
+
+
+	sRegistry & GetRegistry()
+	{
+		// Never destroyed, the threads' caches may give their blocks back after the static objects are gone:
+		static auto * Registry = new sRegistry;
+		return *Registry;
+	}
+
+
+
+
+
+	/** Returns a new slab, mapped directly so that it can be given back to the system when freed.
+	The C runtime would keep such a large block in its heap. */
+	std::byte * MapSlab()
+	{
+		#ifdef _WIN32
+			auto Res = VirtualAlloc(nullptr, SLAB_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			if (Res == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+		#else
+			auto Res = mmap(nullptr, SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (Res == MAP_FAILED)
+			{
+				throw std::bad_alloc();
+			}
+		#endif
+		return static_cast<std::byte *>(Res);
+	}
+
+
+
+
+
+	void UnmapSlab(std::byte * a_Slab)
+	{
+		#ifdef _WIN32
+			VERIFY(VirtualFree(a_Slab, 0, MEM_RELEASE));
+		#else
+			VERIFY(munmap(a_Slab, SLAB_SIZE) == 0);
+		#endif
+	}
+}  // namespace (anonymous)
+
+
+
+
+
+cSlabPool & cSlabPool::Get(const size_t a_BlockSize)
+{
+	// Keep the blocks aligned:
+	const auto Alignment = alignof(std::max_align_t);
+	const auto BlockSize = (a_BlockSize + Alignment - 1) / Alignment * Alignment;
+	ASSERT(BlockSize <= SLAB_SIZE / 16);
+
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	for (auto Pool: Registry.m_Pools)
+	{
+		if (Pool->m_BlockSize == BlockSize)
+		{
+			return *Pool;
+		}
+	}
+	ASSERT(Registry.m_Pools.size() < MAX_CACHED_POOLS);  // The pools past the limit work, but always take the lock
+	Registry.m_Pools.push_back(new cSlabPool(Registry.m_Pools.size(), BlockSize));
+	return *Registry.m_Pools.back();
+}
+
+
+
+
+
+size_t cSlabPool::TrimAll(void)
+{
+	std::vector<cSlabPool *> Pools;
+	{
+		auto & Registry = GetRegistry();
+		cCSLock Lock(Registry.m_CS);
+		Pools = Registry.m_Pools;
+	}
+
+	size_t Res = 0;
+	for (auto Pool: Pools)
+	{
+		Res += Pool->Trim();
+	}
+	return Res;
+}
+
+
+
+
+
+size_t cSlabPool::GetTotalReservedBytes(void)
+{
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	size_t Res = 0;
+	for (auto Pool: Registry.m_Pools)
+	{
+		cCSLock PoolLock(Pool->m_CS);
+		Res += Pool->m_Slabs.size() * SLAB_SIZE;
+	}
+	return Res;
+}
+
+
+
+
+
+size_t cSlabPool::GetTotalUsedBytes(void)
+{
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	size_t Res = 0;
+	for (auto Pool: Registry.m_Pools)
+	{
+		Res += Pool->m_NumUsedBlocks.load(std::memory_order_relaxed) * Pool->m_BlockSize;
+	}
+	return Res;
+}
+
+
+
+
+
+cSlabPool::cSlabPool(const size_t a_Index, const size_t a_BlockSize):
+	m_Index(a_Index),
+	m_BlockSize(a_BlockSize),
+	m_NumUsedBlocks(0)
+{
+}
+
+
+
+
+
+void * cSlabPool::Allocate(void)
+{
+	m_NumUsedBlocks.fetch_add(1, std::memory_order_relaxed);
+
+	if ((m_Index >= MAX_CACHED_POOLS) || t_IsCacheDestroyed)
+	{
+		std::vector<void *> Block;
+		Refill(Block);
+		auto Res = Block.back();
+		Block.pop_back();
+		ReturnBlocks(Block);
+		return Res;
+	}
+
+	auto & Cache = t_Cache.m_Blocks[m_Index];
+	if (Cache.empty())
+	{
+		t_Cache.m_Pools[m_Index] = this;
+		Refill(Cache);
+	}
+	auto Res = Cache.back();
+	Cache.pop_back();
+	return Res;
+}
+
+
+
+
+
+void cSlabPool::Deallocate(void * a_Block)
+{
+	m_NumUsedBlocks.fetch_sub(1, std::memory_order_relaxed);
+
+	if ((m_Index >= MAX_CACHED_POOLS) || t_IsCacheDestroyed)
+	{
+		cCSLock Lock(m_CS);
+		m_FreeBlocks.push_back(a_Block);
+		return;
+	}
+
+	auto & Cache = t_Cache.m_Blocks[m_Index];
+	t_Cache.m_Pools[m_Index] = this;
+	Cache.push_back(a_Block);
+	if (Cache.size() >= CACHE_SIZE)
+	{
+		// Keep half of the blocks for the next allocations, share the rest:
+		cCSLock Lock(m_CS);
+		m_FreeBlocks.insert(m_FreeBlocks.end(), Cache.begin() + CACHE_SIZE / 2, Cache.end());
+		Cache.resize(CACHE_SIZE / 2);
+	}
+}
+
+
+
+
+
+size_t cSlabPool::Trim(void)
+{
+	cCSLock Lock(m_CS);
+	if (m_Slabs.empty())
+	{
+		return 0;
+	}
+
+	// Count the free blocks in each slab:
+	const auto SlabOf = [this](void * a_Block)
+	{
+		const auto Itr = std::upper_bound(m_Slabs.begin(), m_Slabs.end(), static_cast<std::byte *>(a_Block), std::less<>());
+		ASSERT(Itr != m_Slabs.begin());
+		return static_cast<size_t>(Itr - m_Slabs.begin()) - 1;
+	};
+	std::vector<size_t> NumFree(m_Slabs.size(), 0);
+	for (auto Block: m_FreeBlocks)
+	{
+		NumFree[SlabOf(Block)] += 1;
+	}
+
+	// Drop the blocks of the slabs that are entirely free, then the slabs themselves:
+	const auto BlocksPerSlab = GetBlocksPerSlab();
+	m_FreeBlocks.erase(
+		std::remove_if(m_FreeBlocks.begin(), m_FreeBlocks.end(), [&](void * a_Block) { return (NumFree[SlabOf(a_Block)] == BlocksPerSlab); }),
+		m_FreeBlocks.end()
+	);
+	std::vector<std::byte *> Kept;
+	size_t Res = 0;
+	for (size_t i = 0; i < m_Slabs.size(); i++)
+	{
+		if (NumFree[i] == BlocksPerSlab)
+		{
+			UnmapSlab(m_Slabs[i]);
+			Res += SLAB_SIZE;
+		}
+		else
+		{
+			Kept.push_back(m_Slabs[i]);
+		}
+	}
+	m_Slabs = std::move(Kept);
+
+	// Hand out the lowest addresses first, so that the last slabs are the first to become free:
+	std::sort(m_FreeBlocks.begin(), m_FreeBlocks.end(), std::greater<>());
+	return Res;
+}
+
+
+
+
+
+void cSlabPool::ReturnBlocks(std::vector<void *> & a_Blocks)
+{
+	cCSLock Lock(m_CS);
+	m_FreeBlocks.insert(m_FreeBlocks.end(), a_Blocks.begin(), a_Blocks.end());
+	a_Blocks.clear();
+}
+
+
+
+
+
+void cSlabPool::Refill(std::vector<void *> & a_Cache)
+{
+	cCSLock Lock(m_CS);
+	if (m_FreeBlocks.empty())
+	{
+		// Add a new slab, its blocks in descending order so that the lowest is used first:
+		const auto Slab = MapSlab();
+		m_Slabs.insert(std::upper_bound(m_Slabs.begin(), m_Slabs.end(), Slab, std::less<>()), Slab);
+		for (size_t i = GetBlocksPerSlab(); i > 0; i--)
+		{
+			m_FreeBlocks.push_back(Slab + (i - 1) * m_BlockSize);
+		}
+	}
+
+	const auto Count = std::min(CACHE_SIZE / 2, m_FreeBlocks.size());
+	a_Cache.insert(a_Cache.end(), m_FreeBlocks.end() - static_cast<std::ptrdiff_t>(Count), m_FreeBlocks.end());
+	m_FreeBlocks.resize(m_FreeBlocks.size() - Count);
+}
+
+
+
+
+
+size_t cSlabPool::GetBlocksPerSlab(void) const
+{
+	return SLAB_SIZE / m_BlockSize;
+}
@@ -0,0 +1,180 @@
+
+// SectionAllocator.h
+
+// Declares the cSlabPool class and the cSectionAllocator template that allocate the chunk sections from slabs,
+// and the cMemoryAccount class that counts the memory allocated on behalf of a single world
+
+/*
+The chunks come and go as the players move about, each bringing up to 64 section allocations of 2 or 4 KiB. Mixed
+with the rest of the server's allocations, this fragments the heap and the memory freed by the unloaded chunks is
+rarely returned to the system. The sections are therefore allocated from slabs, large blocks mapped directly from
+the system, each holding many sections of a single size.
+Each thread keeps a few free sections of each size, so that allocating and freeing a section usually doesn't take
+any lock. The rest of the free sections are shared by all the threads; the lowest addresses are handed out first, so
+that the slabs at the end empty out and can be given back to the system by Trim().
+
+Each allocation is charged to the cMemoryAccount given to the allocator, and refunded when freed, no matter which
+thread frees it or which copy of the data is the last to hold it.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+/** Counts the bytes allocated on behalf of a single owner, such as a world's chunks. */
+class cMemoryAccount
+{
+public:
+
+	void Add(size_t a_Bytes) { m_Bytes.fetch_add(a_Bytes, std::memory_order_relaxed); }
+
+	void Remove(size_t a_Bytes) { m_Bytes.fetch_sub(a_Bytes, std::memory_order_relaxed); }
+
+	size_t GetBytes(void) const { return m_Bytes.load(std::memory_order_relaxed); }
+
+private:
+
+	std::atomic<size_t> m_Bytes{ 0 };
+};
+
+
+
+
+
+/** A pool of fixed-size blocks, carved out of slabs. There's a single pool per block size, shared by all the threads. */
+class cSlabPool
+{
+public:
+
+	/** Returns the pool for the blocks of the specified size, creating it on first use. The pools are never destroyed. */
+	static cSlabPool & Get(size_t a_BlockSize);
+
+	/** Gives the slabs no longer used by any block back to the system, in all the pools.
+	Returns the number of bytes released. */
+	static size_t TrimAll(void);
+
+	/** Returns the number of bytes in the slabs of all the pools. */
+	static size_t GetTotalReservedBytes(void);
+
+	/** Returns the number of bytes in the blocks handed out by all the pools. */
+	static size_t GetTotalUsedBytes(void);
+
+	void * Allocate(void);
+
+	void Deallocate(void * a_Block);
+
+	/** Gives the slabs no longer used by any block back to the system. Returns the number of bytes released.
+	The free blocks held by the threads' caches keep their slabs. */
+	size_t Trim(void);
+
+	size_t GetBlockSize(void) const { return m_BlockSize; }
+
+	/** Moves the specified free blocks into the shared free list, used by the threads' caches. */
+	void ReturnBlocks(std::vector<void *> & a_Blocks);
+
+private:
+
+	/** The pool's index into the threads' caches. */
+	size_t m_Index;
+
+	size_t m_BlockSize;
+
+	/** Protects m_Slabs and m_FreeBlocks. */
+	cCriticalSection m_CS;
+
+	/** All the slabs, sorted by address. */
+	std::vector<std::byte *> m_Slabs;
+
+	/** The free blocks not cached by any thread; sorted by descending address after a trim, so that the lowest are used first. */
+	std::vector<void *> m_FreeBlocks;
+
+	std::atomic<size_t> m_NumUsedBlocks;
+
+
+	cSlabPool(size_t a_Index, size_t a_BlockSize);
+
+	/** Moves a batch of free blocks into a_Cache, allocating a new slab if there are none. */
+	void Refill(std::vector<void *> & a_Cache);
+
+	/** Returns the number of blocks in a single slab. */
+	size_t GetBlocksPerSlab(void) const;
+};
+
+
+
+
+
+/** A standard allocator for the chunk sections, to be used with std::allocate_shared.
+The single objects come from the slab pool of their size, the memory is charged to the account, if any. */
+template <class T>
+class cSectionAllocator
+{
+public:
+
+	using value_type = T;
+
+	explicit cSectionAllocator(std::shared_ptr<cMemoryAccount> a_Account) noexcept:
+		m_Account(std::move(a_Account))
+	{
+	}
+
+	template <class U>
+	cSectionAllocator(const cSectionAllocator<U> & a_Other) noexcept:
+		m_Account(a_Other.GetAccount())
+	{
+	}
+
+	T * allocate(size_t a_Count)
+	{
+		static_assert(alignof(T) <= alignof(std::max_align_t), "The slabs only provide the fundamental alignment");
+		const auto Bytes = a_Count * sizeof(T);
+		auto Res = (a_Count == 1) ? GetPool().Allocate() : ::operator new(Bytes);
+		if (m_Account != nullptr)
+		{
+			m_Account->Add(Bytes);
+		}
+		return static_cast<T *>(Res);
+	}
+
+	void deallocate(T * a_Ptr, size_t a_Count) noexcept
+	{
+		if (m_Account != nullptr)
+		{
+			m_Account->Remove(a_Count * sizeof(T));
+		}
+		if (a_Count == 1)
+		{
+			GetPool().Deallocate(a_Ptr);
+		}
+		else
+		{
+			::operator delete(a_Ptr);
+		}
+	}
+
+	const std::shared_ptr<cMemoryAccount> & GetAccount(void) const noexcept { return m_Account; }
+
+	template <class U>
+	bool operator == (const cSectionAllocator<U> & a_Other) const noexcept { return (m_Account == a_Other.GetAccount()); }
+
+	template <class U>
+	bool operator != (const cSectionAllocator<U> & a_Other) const noexcept { return (m_Account != a_Other.GetAccount()); }
+
+private:
+
+	/** Shared, so that a section freed after its world is gone doesn't refund a destroyed account. */
+	std::shared_ptr<cMemoryAccount> m_Account;
+
+
+	static cSlabPool & GetPool(void)
+	{
+		static cSlabPool & Pool = cSlabPool::Get(sizeof(T));
+		return Pool;
+	}
+};
@@ -18,6 +18,8 @@
 #include "Protocol/ProtocolRecognizer.h"
 #include "CommandOutput.h"
 #include "FastRandom.h"
+#include "Profiler.h"
+#include "Timings.h"
 
 #include "IniFile.h"
 
@@ -79,6 +81,7 @@ void cServer::cTickThread::Execute(void)
 {
 	auto LastTime = std::chrono::steady_clock::now();
 	static const auto msPerTick = std::chrono::milliseconds(50);
+	cProfiler::SetCurrentThreadName("Server Ticker");
 
 	while (!m_ShouldTerminate)
 	{
@@ -86,6 +89,7 @@ void cServer::cTickThread::Execute(void)
 		auto msec = std::chrono::duration_cast<std::chrono::milliseconds>(NowTime - LastTime).count();
 		m_Server.Tick(static_cast<float>(msec));
 		auto TickTime = std::chrono::steady_clock::now() - NowTime;
+		cProfiler::ReportTickDuration("Server", std::chrono::duration_cast<std::chrono::milliseconds>(TickTime));
 
 		if (TickTime < msPerTick)
 		{
@@ -112,6 +116,7 @@ cServer::cServer(void) :
 	m_MaxPlayers(0),
 	m_bIsHardcore(false),
 	m_TickThread(*this),
+	m_NumFlushWorkers(0),
 	m_ShouldAuthenticate(false),
 	m_UpTime(0)
 {
@@ -211,6 +216,13 @@ bool cServer::InitServer(cSettingsRepositoryInterface & a_Settings, bool a_Shoul
 	m_ShouldAllowMultiWorldTabCompletion = a_Settings.GetValueSetB("Server", "AllowMultiWorldTabCompletion", true);
 	m_ShouldLimitPlayerBlockChanges = a_Settings.GetValueSetB("AntiCheat", "LimitPlayerBlockChanges", true);
 
+	// Compressing and encrypting the outgoing data is cheap compared to the ticking, a quarter of the cores is plenty:
+	const auto DefaultNumFlushWorkers = static_cast<int>(std::max(std::thread::hardware_concurrency() / 4, 1U));
+	m_NumFlushWorkers = static_cast<unsigned>(std::max(a_Settings.GetValueSetI("Server", "NumFlushWorkers", DefaultNumFlushWorkers), 0));
+
+	m_CompressionSettings.Load(a_Settings);
+	m_CompressionSettings.m_NumFlushWorkers = m_NumFlushWorkers;
+
 	const auto ClientViewDistance = a_Settings.GetValueSetI("Server", "DefaultViewDistance", cClientHandle::DEFAULT_VIEW_DISTANCE);
 	if (ClientViewDistance < cClientHandle::MIN_VIEW_DISTANCE)
 	{
@@ -332,6 +344,8 @@ cTCPLink::cCallbacksPtr cServer::OnConnectionAccepted(const AString & a_RemoteIP
 
 void cServer::Tick(float a_Dt)
 {
+	cProfileScope Profile("cServer::Tick");
+
 	// Update server uptime
 	m_UpTime++;
 
@@ -420,6 +434,7 @@ bool cServer::Start(void)
 		LOGERROR("Couldn't open any ports. Aborting the server");
 		return false;
 	}
+	m_FlushWorkerPool.Start(m_NumFlushWorkers);
 	m_TickThread.Start();
 	return true;
 }
@@ -577,6 +592,18 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 		a_Output.Finished();
 		return;
 	}
+	else if (split[0].compare("profile") == 0)
+	{
+		ExecuteProfileCommand(split, a_Output);
+		a_Output.Finished();
+		return;
+	}
+	else if (split[0].compare("timings") == 0)
+	{
+		ExecuteTimingsCommand(split, a_Output);
+		a_Output.Finished();
+		return;
+	}
 	else if (cPluginManager::Get()->ExecuteConsoleCommand(split, a_Output, a_Cmd))
 	{
 		a_Output.Finished();
@@ -635,6 +662,105 @@ void cServer::PrintHelp(const AStringVector & a_Split, cCommandOutputCallback &
 
 
 
+void cServer::ExecuteProfileCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
+{
+	if ((a_Split.size() >= 2) && (a_Split[1] == "on"))
+	{
+		cProfiler::SetEnabled(true);
+		a_Output.OutLn("Profiler enabled");
+		return;
+	}
+	if ((a_Split.size() >= 2) && (a_Split[1] == "off"))
+	{
+		cProfiler::SetEnabled(false);
+		a_Output.OutLn("Profiler disabled");
+		return;
+	}
+	if ((a_Split.size() < 2) || (a_Split[1] != "dump"))
+	{
+		a_Output.OutLn(fmt::format(FMT_STRING("Profiler is {}"), cProfiler::IsEnabled() ? "enabled" : "disabled"));
+		a_Output.OutLn("Usage: profile on|off|dump [seconds] [file]");
+		return;
+	}
+
+	int Seconds = 10;
+	if ((a_Split.size() >= 3) && (!StringToInteger(a_Split[2], Seconds) || (Seconds <= 0)))
+	{
+		a_Output.OutLn("Usage: profile dump [seconds] [file]");
+		return;
+	}
+	AString FileName;
+	if (a_Split.size() >= 4)
+	{
+		FileName = a_Split[3];
+	}
+	else
+	{
+		// Assume creation succeeds, as the API does not provide a way to tell if the folder exists.
+		cFile::CreateFolder("profiles");
+		FileName = fmt::format(
+			FMT_STRING("profiles/profile_{}.json"),
+			std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()
+		);
+	}
+
+	if (cProfiler::SaveChromeTrace(FileName, std::chrono::seconds(Seconds)))
+	{
+		a_Output.OutLn(fmt::format(FMT_STRING("Saved the last {} seconds of the profile to {}; open it in chrome://tracing or speedscope"), Seconds, FileName));
+	}
+	else
+	{
+		a_Output.OutLn(fmt::format(FMT_STRING("Cannot write the profile to {}"), FileName));
+	}
+}
+
+
+
+
+
+void cServer::ExecuteTimingsCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output)
+{
+	if ((a_Split.size() >= 2) && (a_Split[1] == "on"))
+	{
+		cTimings::SetEnabled(true);
+		a_Output.OutLn("Timings enabled, use \"timings report\" to list the most expensive items");
+		return;
+	}
+	if ((a_Split.size() >= 2) && (a_Split[1] == "off"))
+	{
+		cTimings::SetEnabled(false);
+		a_Output.OutLn("Timings disabled");
+		return;
+	}
+	if ((a_Split.size() >= 2) && (a_Split[1] == "reset"))
+	{
+		cTimings::Reset();
+		a_Output.OutLn("Timings reset");
+		return;
+	}
+	if ((a_Split.size() < 2) || (a_Split[1] != "report"))
+	{
+		a_Output.OutLn(fmt::format(FMT_STRING("Timings are {}"), cTimings::IsEnabled() ? "enabled" : "disabled"));
+		a_Output.OutLn("Usage: timings on|off|reset|report [NumEntries]");
+		return;
+	}
+
+	size_t NumEntries = 10;
+	if ((a_Split.size() >= 3) && (!StringToInteger(a_Split[2], NumEntries) || (NumEntries == 0)))
+	{
+		a_Output.OutLn("Usage: timings report [NumEntries]");
+		return;
+	}
+	for (const auto & Line : cTimings::GetReport(NumEntries))
+	{
+		a_Output.OutLn(Line);
+	}
+}
+
+
+
+
+
 void cServer::BindBuiltInConsoleCommands(void)
 {
 	// Create an empty handler - the actual handling for the commands is performed before they are handed off to cPluginManager
@@ -664,6 +790,8 @@ void cServer::BindBuiltInConsoleCommands(void)
 	PlgMgr->BindConsoleCommand("load",            nullptr, handler, "Adds and enables the specified plugin");
 	PlgMgr->BindConsoleCommand("unload",          nullptr, handler, "Disables the specified plugin");
 	PlgMgr->BindConsoleCommand("destroyentities", nullptr, handler, "Destroys all entities in all worlds");
+	PlgMgr->BindConsoleCommand("timings",         nullptr, handler, "Lists the most expensive chunks, entities, block entities and plugin hooks, \"timings on\" starts measuring");
+	PlgMgr->BindConsoleCommand("profile",         nullptr, handler, "Controls the tick profiler, \"profile dump [seconds] [file]\" saves a Chrome trace");
 }
 
 
@@ -686,12 +814,17 @@ void cServer::Shutdown(void)
 	cRoot::Get()->SaveAllChunksNow();
 
 	// Remove all clients:
-	cCSLock Lock(m_CSClients);
-	for (auto itr = m_Clients.begin(); itr != m_Clients.end(); ++itr)
 	{
-		(*itr)->Destroy();
+		cCSLock Lock(m_CSClients);
+		for (auto itr = m_Clients.begin(); itr != m_Clients.end(); ++itr)
+		{
+			(*itr)->Destroy();
+		}
+		m_Clients.clear();
 	}
-	m_Clients.clear();
+
+	// Any further flushes are done on the calling thread:
+	m_FlushWorkerPool.Stop();
 }
 
 
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "FlushWorkerPool.h"
+#include "Protocol/CompressionController.h"
 #include "RCONServer.h"
 #include "OSSupport/IsThread.h"
 #include "OSSupport/Network.h"
@@ -116,6 +118,12 @@ public:
 	/** Lists all available console commands and their helpstrings */
 	void PrintHelp(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
 
+	/** Handles the "profile" console command: toggles the tick profiler or saves its recent events as a Chrome trace */
+	void ExecuteProfileCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+
+	/** Handles the "timings" console command: toggles the lag attribution or lists the most expensive items */
+	void ExecuteTimingsCommand(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+
 	/** Binds the built-in console commands with the plugin manager */
 	static void BindBuiltInConsoleCommands(void);
 
@@ -165,6 +173,12 @@ public:
 	/** Get the Forge mods (map of ModName -> ModVersionString) registered for a given protocol. */
 	const AStringMap & GetRegisteredForgeMods(const UInt32 a_Protocol);
 
+	/** Returns the pool of threads that compress, encrypt and send the clients' outgoing data. */
+	cFlushWorkerPool & GetFlushWorkerPool(void) { return m_FlushWorkerPool; }
+
+	/** Returns the settings for the clients' cCompressionController. */
+	const cCompressionController::sSettings & GetCompressionSettings(void) const { return m_CompressionSettings; }
+
 private:
 
 	friend class cRoot;  // so cRoot can create and destroy cServer
@@ -238,6 +252,15 @@ private:
 
 	cTickThread m_TickThread;
 
+	/** The threads that compress, encrypt and send the clients' outgoing data. */
+	cFlushWorkerPool m_FlushWorkerPool;
+
+	/** Number of threads to start in m_FlushWorkerPool; settable in Settings.ini. */
+	unsigned m_NumFlushWorkers;
+
+	/** The settings for the clients' compression, from the [Compression] section of Settings.ini. */
+	cCompressionController::sSettings m_CompressionSettings;
+
 	/** The server ID used for client authentication */
 	AString m_ServerID;
 
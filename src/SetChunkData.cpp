@@ -28,3 +28,13 @@ void SetChunkData::UpdateHeightMap()
 		}  // for z
 	}  // for x
 }
+
+
+
+
+
+void SetChunkData::SetMemoryAccount(const std::shared_ptr<cMemoryAccount> & a_Account)
+{
+	BlockData.SetMemoryAccount(a_Account);
+	LightData.SetMemoryAccount(a_Account);
+}
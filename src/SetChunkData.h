@@ -33,4 +33,8 @@ struct SetChunkData
 
 	/** Recalculates the HeightMap based on BlockData contents. */
 	void UpdateHeightMap();
+
+	/** Sets the account charged for the block and light data allocated from now on.
+	Should be the destination world's, so that the data is accounted for once the chunk takes it over. */
+	void SetMemoryAccount(const std::shared_ptr<cMemoryAccount> & a_Account);
 };
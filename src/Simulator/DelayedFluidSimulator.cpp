@@ -14,32 +14,6 @@
 
 
 
-////////////////////////////////////////////////////////////////////////////////
-// cDelayedFluidSimulatorChunkData::cSlot
-
-bool cDelayedFluidSimulatorChunkData::cSlot::Add(int a_RelX, int a_RelY, int a_RelZ)
-{
-	ASSERT(a_RelZ >= 0);
-	ASSERT(a_RelZ < static_cast<int>(ARRAYCOUNT(m_Blocks)));
-
-	auto & Blocks = m_Blocks[a_RelZ];
-	const auto Index = cChunkDef::MakeIndex(a_RelX, a_RelY, a_RelZ);
-	for (const auto & Block : Blocks)
-	{
-		if (Block.Data == Index)
-		{
-			// Already present
-			return false;
-		}
-	}  // for itr - Blocks[]
-	Blocks.emplace_back(a_RelX, a_RelY, a_RelZ, Index);
-	return true;
-}
-
-
-
-
-
 ////////////////////////////////////////////////////////////////////////////////
 // cDelayedFluidSimulatorChunkData:
 
@@ -98,20 +72,18 @@ void cDelayedFluidSimulator::SimulateChunk(std::chrono::milliseconds a_Dt, int a
 	cDelayedFluidSimulatorChunkData * ChunkData = static_cast<cDelayedFluidSimulatorChunkData *>(ChunkDataRaw);
 	cDelayedFluidSimulatorChunkData::cSlot & Slot = ChunkData->m_Slots[m_SimSlotNum];
 
+	// Take all the blocks out of the scheduled slot first, the simulation may queue new ones into it:
+	std::vector<cCoordWithData<size_t>> Blocks[cChunkDef::Width];
+	Slot.TakeAll(Blocks);
+
 	// Simulate all the blocks in the scheduled slot:
-	for (size_t i = 0; i < ARRAYCOUNT(Slot.m_Blocks); i++)
+	for (const auto & BlocksZ: Blocks)
 	{
-		auto & Blocks = Slot.m_Blocks[i];
-		if (Blocks.empty())
-		{
-			continue;
-		}
-		for (const auto & Block : Blocks)
+		for (const auto & Block : BlocksZ)
 		{
 			SimulateBlock(a_Chunk, Block.x, Block.y, Block.z);
 		}
-		m_TotalBlocks -= static_cast<int>(Blocks.size());
-		Blocks.clear();
+		m_TotalBlocks -= static_cast<int>(BlocksZ.size());
 	}
 }
 
@@ -126,6 +98,12 @@ void cDelayedFluidSimulator::AddBlock(cChunk & a_Chunk, Vector3i a_Position, BLO
 		return;
 	}
 
+	if (IsSettled(a_Chunk, a_Position, a_Block))
+	{
+		// Nothing would change, let the block sleep until one of its neighbors changes:
+		return;
+	}
+
 	auto ChunkDataRaw = (m_FluidBlock == E_BLOCK_WATER) ? a_Chunk.GetWaterSimulatorData() : a_Chunk.GetLavaSimulatorData();
 	cDelayedFluidSimulatorChunkData * ChunkData = static_cast<cDelayedFluidSimulatorChunkData *>(ChunkDataRaw);
 	cDelayedFluidSimulatorChunkData::cSlot & Slot = ChunkData->m_Slots[m_AddSlotNum];
@@ -138,3 +116,15 @@ void cDelayedFluidSimulator::AddBlock(cChunk & a_Chunk, Vector3i a_Position, BLO
 
 	++m_TotalBlocks;
 }
+
+
+
+
+
+bool cDelayedFluidSimulator::IsSettled(cChunk & a_Chunk, Vector3i a_RelPos, BLOCKTYPE a_Block)
+{
+	UNUSED(a_Chunk);
+	UNUSED(a_RelPos);
+	UNUSED(a_Block);
+	return false;
+}
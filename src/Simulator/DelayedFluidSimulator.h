@@ -11,6 +11,8 @@
 
 #include "FluidSimulator.h"
 
+#include <bitset>
+
 
 
 
@@ -23,15 +25,65 @@ public:
 	{
 	public:
 		/** Returns true if the specified block is stored */
-		bool HasBlock(int a_RelX, int a_RelY, int a_RelZ);
+		bool HasBlock(int a_RelX, int a_RelY, int a_RelZ) const
+		{
+			const auto & IsQueued = m_IsQueued[static_cast<size_t>(a_RelY / cChunkDef::SectionHeight)];
+			return (IsQueued != nullptr) && IsQueued->test(BitIndex(a_RelX, a_RelY, a_RelZ));
+		}
 
 		/** Adds the specified block unless already present; returns true if added, false if the block was already present */
-		bool Add(int a_RelX, int a_RelY, int a_RelZ);
+		bool Add(int a_RelX, int a_RelY, int a_RelZ)
+		{
+			ASSERT(cChunkDef::IsValidRelPos({ a_RelX, a_RelY, a_RelZ }));
+
+			auto & IsQueued = m_IsQueued[static_cast<size_t>(a_RelY / cChunkDef::SectionHeight)];
+			if (IsQueued == nullptr)
+			{
+				IsQueued = std::make_unique<cSectionBits>();
+			}
+			const auto Bit = BitIndex(a_RelX, a_RelY, a_RelZ);
+			if (IsQueued->test(Bit))
+			{
+				// Already present
+				return false;
+			}
+			IsQueued->set(Bit);
+			m_Blocks[a_RelZ].emplace_back(a_RelX, a_RelY, a_RelZ, cChunkDef::MakeIndex(a_RelX, a_RelY, a_RelZ));
+			return true;
+		}
+
+		/** Moves all the stored blocks into a_Blocks and empties the slot, so that blocks can be added while simulating the taken ones. */
+		void TakeAll(std::vector<cCoordWithData<size_t>> (& a_Blocks)[cChunkDef::Width])
+		{
+			for (size_t i = 0; i < ARRAYCOUNT(m_Blocks); i++)
+			{
+				a_Blocks[i].clear();
+				std::swap(a_Blocks[i], m_Blocks[i]);
+			}
+			for (auto & IsQueued: m_IsQueued)
+			{
+				IsQueued.reset();
+			}
+		}
 
 		/** Array of block containers, each item stores blocks for one Z coord
-		size_t param is the block index (for faster duplicate comparison in Add())
+		size_t param is the block index within the chunk
 		*/
 		std::vector<cCoordWithData<size_t>> m_Blocks[16];
+
+	private:
+
+		using cSectionBits = std::bitset<cChunkDef::SectionHeight * cChunkDef::Width * cChunkDef::Width>;
+
+		/** One bit per block, set for the blocks in m_Blocks, so that Add() needn't search for duplicates.
+		Allocated only for the sections that have any blocks queued. */
+		std::unique_ptr<cSectionBits> m_IsQueued[cChunkDef::NumSections];
+
+
+		static size_t BitIndex(int a_RelX, int a_RelY, int a_RelZ)
+		{
+			return static_cast<size_t>(a_RelX + a_RelZ * cChunkDef::Width + (a_RelY % cChunkDef::SectionHeight) * cChunkDef::Width * cChunkDef::Width);
+		}
 	} ;
 
 	cDelayedFluidSimulatorChunkData(int a_TickDelay);
@@ -73,6 +125,12 @@ protected:
 
 	/** Called from SimulateChunk() to simulate each block in one slot of blocks. Descendants override this method to provide custom simulation. */
 	virtual void SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ) = 0;
+
+	/** Returns true if simulating the specified fluid block wouldn't change anything, given the blocks around it,
+	so that AddBlock() needn't queue it. Such blocks form settled regions, the inside of lakes and oceans, that stay
+	asleep until a block next to them changes; the change wakes them up and this is asked again.
+	Descendants override this to describe the blocks their SimulateBlock() leaves alone; the default settles nothing. */
+	virtual bool IsSettled(cChunk & a_Chunk, Vector3i a_RelPos, BLOCKTYPE a_Block);
 } ;
 
 
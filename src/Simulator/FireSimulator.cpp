@@ -66,7 +66,7 @@ static constexpr Vector3i gNeighborCoords[] =
 // cFireSimulator:
 
 cFireSimulator::cFireSimulator(cWorld & a_World, cIniFile & a_IniFile) :
-	cSimulator(a_World)
+	m_World(a_World)
 {
 	// Read params from the ini file:
 	m_BurnStepTimeFuel    = static_cast<unsigned>(a_IniFile.GetValueSetI("FireSimulator", "BurnStepTimeFuel",     500));
@@ -8,6 +8,13 @@
 
 
 
+// fwd:
+class cWorld;
+
+
+
+
+
 /** The fire simulator takes care of the fire blocks.
 It periodically increases their meta ("steps") until they "burn out"; it also supports the forever burning netherrack.
 Each individual fire block gets stored in per-chunk data; that list is then used for fast retrieval.
@@ -31,6 +38,8 @@ private:
 
 	static bool IsAllowedBlock(BLOCKTYPE a_BlockType);
 
+	cWorld & m_World;
+
 	/** Time (in msec) that a fire block takes to burn with a fuel block into the next step */
 	unsigned m_BurnStepTimeFuel;
 
@@ -135,6 +135,63 @@ void cFloodyFluidSimulator::SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_Re
 
 
 
+bool cFloodyFluidSimulator::IsSettled(cChunk & a_Chunk, Vector3i a_RelPos, BLOCKTYPE a_Block)
+{
+	// Only stationary sources settle; the rest may still decrease, or be turned into a stationary block:
+	if ((a_Block != m_StationaryFluidBlock) || (a_Chunk.GetMeta(a_RelPos) != 0))
+	{
+		return false;
+	}
+
+	// A source with a zero falloff may be re-created by CheckNeighborsForSource():
+	if ((m_Falloff == 0) && (m_NumNeighborsForSource > 0))
+	{
+		return false;
+	}
+
+	// The source spreads down and sideways; it has nowhere to go if these are all sources of the same fluid or blocks
+	// the fluid can't enter. The other fluid is never settled against, they harden.
+	static const Vector3i SpreadCoords[] =
+	{
+		Vector3i( 1,  0,  0),
+		Vector3i(-1,  0,  0),
+		Vector3i( 0,  0,  1),
+		Vector3i( 0,  0, -1),
+		Vector3i( 0, -1,  0),
+	} ;
+	for (const auto & Offset: SpreadCoords)
+	{
+		const auto NeighborPos = a_RelPos + Offset;
+		if (NeighborPos.y < 0)
+		{
+			continue;
+		}
+		BLOCKTYPE BlockType;
+		NIBBLETYPE BlockMeta;
+		if (!a_Chunk.UnboundedRelGetBlock(NeighborPos, BlockType, BlockMeta))
+		{
+			// Neighbor not available, simulate the block once it is
+			return false;
+		}
+		if (IsAllowedBlock(BlockType))
+		{
+			if (BlockMeta != 0)
+			{
+				return false;
+			}
+		}
+		else if (IsPassableForFluid(BlockType) || IsBlockLiquid(BlockType))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
 void cFloodyFluidSimulator::SpreadXZ(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_NewMeta)
 {
 	SpreadToNeighbor(a_Chunk, a_RelX - 1, a_RelY, a_RelZ,     a_NewMeta);
@@ -32,6 +32,7 @@ protected:
 
 	// cDelayedFluidSimulator overrides:
 	virtual void SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ) override;
+	virtual bool IsSettled(cChunk & a_Chunk, Vector3i a_RelPos, BLOCKTYPE a_Block) override;
 
 	/** Checks tributaries, if not fed, decreases the block's level and returns true. */
 	bool CheckTributaries(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_MyMeta);
@@ -8,7 +8,7 @@
 
 
 cFluidSimulator::cFluidSimulator(cWorld & a_World, BLOCKTYPE a_Fluid, BLOCKTYPE a_StationaryFluid) :
-	Super(a_World),
+	m_World(a_World),
 	m_FluidBlock(a_Fluid),
 	m_StationaryFluidBlock(a_StationaryFluid)
 {
@@ -65,6 +65,8 @@ protected:
 
 	bool IsAllowedBlock(BLOCKTYPE a_BlockType);
 
+	cWorld & m_World;
+
 	BLOCKTYPE m_FluidBlock;            // The fluid block type that needs simulating
 	BLOCKTYPE m_StationaryFluidBlock;  // The fluid block type that indicates no simulation is needed
 };
@@ -5,7 +5,24 @@
 #include "BlockType.h"
 #include "RedstoneHandler.h"
 #include "RedstoneSimulatorChunkData.h"
+#include "RedstoneWireNetwork.h"
 #include "ForEachSourceCallback.h"
+#include "RedstoneDataHelper.h"
+
+
+
+
+
+cIncrementalRedstoneSimulatorChunkData::~cIncrementalRedstoneSimulatorChunkData() = default;
+
+
+
+
+
+cIncrementalRedstoneSimulator::cIncrementalRedstoneSimulator(const bool a_CompileCircuits) :
+	m_CompileCircuits(a_CompileCircuits)
+{
+}
 
 
 
@@ -112,35 +129,165 @@ void cIncrementalRedstoneSimulator::ProcessWorkItem(cChunk & Chunk, cChunk & Tic
 
 
 
-void cIncrementalRedstoneSimulator::SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk)
+bool cIncrementalRedstoneSimulator::IsCompiledWire(cChunk & Chunk, const Vector3i Position)
 {
-	auto & ChunkData = *static_cast<cIncrementalRedstoneSimulatorChunkData *>(a_Chunk->GetRedstoneSimulatorData());
-	for (auto & DelayInfo : ChunkData.m_MechanismDelays)
+	auto & ChunkData = DataForChunk(Chunk);
+	if (ChunkData.CompiledWires.find(Position) != ChunkData.CompiledWires.end())
+	{
+		return true;
+	}
+
+	if (ChunkData.CompileCooldown > 0)
+	{
+		return false;
+	}
+
+	auto Network = cRedstoneWireNetwork::Compile(Chunk, Position);
+	if (Network == nullptr)
+	{
+		return false;
+	}
+
+	const auto & Wires = Network->GetWires();
+	for (size_t i = 0; i < Wires.size(); i++)
+	{
+		ChunkData.CompiledWires.emplace(Wires[i], std::make_pair(Network.get(), i));
+	}
+	ChunkData.WireNetworks.push_back(std::move(Network));
+	return true;
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::EvaluateNetworks(std::vector<std::pair<cChunk *, Vector3i>> & Wires, cChunk & TickingSource)
+{
+	std::vector<std::pair<cChunk *, cRedstoneWireNetwork *>> Networks;
+	for (const auto & [Chunk, Position] : Wires)
+	{
+		// Look the wire up again, the blocks processed since it was woken may have dissolved its network:
+		const auto & CompiledWires = DataForChunk(*Chunk).CompiledWires;
+		const auto Compiled = CompiledWires.find(Position);
+		if (Compiled == CompiledWires.end())
+		{
+			DataForChunk(TickingSource).WakeUp(cIncrementalRedstoneSimulatorChunkData::RebaseRelativePosition(*Chunk, TickingSource, Position));
+			continue;
+		}
+
+		const auto Network = Compiled->second.first;
+		if (std::find(Networks.begin(), Networks.end(), std::make_pair(Chunk, Network)) == Networks.end())
+		{
+			Networks.emplace_back(Chunk, Network);
+		}
+		Network->WakeUp(Compiled->second.second);
+	}
+	Wires.clear();
+
+	for (const auto & [Chunk, Network] : Networks)
 	{
-		if ((--DelayInfo.second.first) == 0)
+		Network->Evaluate(*Chunk, TickingSource);
+	}
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::DissolveNetworksAround(cChunk & Chunk, const Vector3i Position)
+{
+	for (int X = -1; X <= 1; X++)
+	{
+		for (int Y = -1; Y <= 1; Y++)
 		{
-			ChunkData.WakeUp(DelayInfo.first);
+			for (int Z = -1; Z <= 1; Z++)
+			{
+				auto Relative = Position + Vector3i(X, Y, Z);
+				if (!cChunkDef::IsValidHeight(Relative))
+				{
+					continue;
+				}
+
+				const auto NeighbourChunk = Chunk.GetRelNeighborChunkAdjustCoords(Relative);
+				if ((NeighbourChunk == nullptr) || !NeighbourChunk->IsValid())
+				{
+					continue;
+				}
+
+				auto & ChunkData = DataForChunk(*NeighbourChunk);
+				const auto Compiled = ChunkData.CompiledWires.find(Relative);
+				if (Compiled == ChunkData.CompiledWires.end())
+				{
+					continue;
+				}
+
+				// Hand the network's wires back to their handler, each one is evaluated again:
+				const auto Network = Compiled->second.first;
+				for (const auto & Wire : Network->GetWires())
+				{
+					ChunkData.CompiledWires.erase(Wire);
+					ChunkData.WakeUp(Wire);
+				}
+				ChunkData.WireNetworks.erase(std::find_if(ChunkData.WireNetworks.begin(), ChunkData.WireNetworks.end(), [Network](const auto & a_Network)
+				{
+					return a_Network.get() == Network;
+				}));
+				ChunkData.CompileCooldown = COMPILE_COOLDOWN_TICKS;
+			}
 		}
 	}
+}
+
+
+
+
+
+void cIncrementalRedstoneSimulator::SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk)
+{
+	auto & ChunkData = *static_cast<cIncrementalRedstoneSimulatorChunkData *>(a_Chunk->GetRedstoneSimulatorData());
+	if (ChunkData.CompileCooldown > 0)
+	{
+		ChunkData.CompileCooldown--;
+	}
+
+	ChunkData.TickMechanismDelays();
 
 	// Build our work queue
 	auto & WorkQueue = ChunkData.GetActiveBlocks();
 
+	// The woken wires of compiled networks, evaluated together once the rest of the queue is processed:
+	std::vector<std::pair<cChunk *, Vector3i>> NetworkWires;
+
 	// Process the work queue
-	while (!WorkQueue.empty())
+	do
 	{
-		// Grab the first element and remove it from the list
-		Vector3i CurrentLocation = WorkQueue.top();
-		WorkQueue.pop();
-
-		const auto NeighbourChunk = a_Chunk->GetRelNeighborChunkAdjustCoords(CurrentLocation);
-		if ((NeighbourChunk == nullptr) || !NeighbourChunk->IsValid())
+		while (!WorkQueue.IsEmpty())
 		{
-			continue;
+			// Grab the first element and remove it from the list
+			Vector3i CurrentLocation = WorkQueue.Pop();
+
+			const auto NeighbourChunk = a_Chunk->GetRelNeighborChunkAdjustCoords(CurrentLocation);
+			if ((NeighbourChunk == nullptr) || !NeighbourChunk->IsValid())
+			{
+				continue;
+			}
+
+			if (
+				m_CompileCircuits &&
+				(NeighbourChunk->GetBlock(CurrentLocation) == E_BLOCK_REDSTONE_WIRE) &&
+				IsCompiledWire(*NeighbourChunk, CurrentLocation)
+			)
+			{
+				NetworkWires.emplace_back(NeighbourChunk, CurrentLocation);
+				continue;
+			}
+
+			ProcessWorkItem(*NeighbourChunk, *a_Chunk, CurrentLocation);
 		}
 
-		ProcessWorkItem(*NeighbourChunk, *a_Chunk, CurrentLocation);
-	}
+		// The networks' changes may have woken more blocks:
+		EvaluateNetworks(NetworkWires, *a_Chunk);
+	} while (!WorkQueue.IsEmpty());
 
 	for (const auto & Position : ChunkData.AlwaysTickedPositions)
 	{
@@ -194,6 +341,10 @@ void cIncrementalRedstoneSimulator::WakeUp(cChunk & a_Chunk, Vector3i a_Position
 {
 	// Having WakeUp called on us directly means someone called SetBlock (or WakeUp)
 	// Since the simulator never does this, something external changed. Clear cached data:
+	if (m_CompileCircuits)
+	{
+		DissolveNetworksAround(a_Chunk, a_Position);
+	}
 	static_cast<cIncrementalRedstoneSimulatorChunkData *>(a_Chunk.GetRedstoneSimulatorData())->ErasePowerData(a_Position);
 
 	// Queue the block, in case the set block was redstone:
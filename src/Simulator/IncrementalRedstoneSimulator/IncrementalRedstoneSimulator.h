@@ -14,10 +14,16 @@ class cIncrementalRedstoneSimulator final :
 
 public:
 
-	using Super::Super;
+	/** If a_CompileCircuits is true, stable wire networks are compiled and evaluated as a whole, see cRedstoneWireNetwork. */
+	cIncrementalRedstoneSimulator(bool a_CompileCircuits);
 
 private:
 
+	/** The number of ticks a chunk's wires are simulated block by block after a block change dissolved one of its networks. */
+	static constexpr int COMPILE_COOLDOWN_TICKS = 20;
+
+	bool m_CompileCircuits;
+
 	/** Returns if a redstone device is always ticked due to influence by its environment */
 	static bool IsAlwaysTicked(BLOCKTYPE a_Block);
 
@@ -26,6 +32,15 @@ private:
 
 	void ProcessWorkItem(cChunk & Chunk, cChunk & TickingSource, const Vector3i Position);
 
+	/** Returns true if the wire at the position belongs to a compiled network, compiling one if allowed. */
+	static bool IsCompiledWire(cChunk & Chunk, Vector3i Position);
+
+	/** Wakes the networks of the specified wires and evaluates them. The wires no longer compiled are queued again. */
+	static void EvaluateNetworks(std::vector<std::pair<cChunk *, Vector3i>> & Wires, cChunk & TickingSource);
+
+	/** Dissolves the networks with a wire next to the position, so that their wires are simulated block by block again. */
+	static void DissolveNetworksAround(cChunk & Chunk, Vector3i Position);
+
 	virtual void SimulateChunk(std::chrono::milliseconds Dt, int ChunkX, int ChunkZ, cChunk * Chunk) override;
 	virtual void AddBlock(cChunk & a_Chunk, Vector3i a_Position, BLOCKTYPE a_Block) override;
 	virtual cRedstoneSimulatorChunkData * CreateChunkData() override;
@@ -59,7 +59,7 @@ namespace ObserverHandler
 		auto & Data = DataForChunk(a_Chunk);
 		auto DelayInfo = Data.GetMechanismDelayInfo(a_Position);
 
-		if (DelayInfo == nullptr)
+		if (!DelayInfo.has_value())
 		{
 			if (!ShouldPowerOn(a_Chunk, a_Position, a_Meta, Data))
 			{
@@ -68,7 +68,7 @@ namespace ObserverHandler
 
 			// From rest, we've determined there was a block update
 			// Schedule power-on 1 tick in the future
-			Data.m_MechanismDelays[a_Position] = std::make_pair(1, true);
+			Data.SetMechanismDelay(a_Position, 1, true);
 
 			return;
 		}
@@ -85,13 +85,13 @@ namespace ObserverHandler
 		if (ShouldPowerOn)
 		{
 			// Remain on for 1 tick before resetting
-			*DelayInfo = std::make_pair(1, false);
+			Data.SetMechanismDelay(a_Position, 1, false);
 			a_Chunk.SetMeta(a_Position, a_Meta | 0x8);
 		}
 		else
 		{
 			// We've reset. Erase delay data in preparation for detecting further updates
-			Data.m_MechanismDelays.erase(a_Position);
+			Data.EraseMechanismDelay(a_Position);
 			a_Chunk.SetMeta(a_Position, a_Meta & ~0x8);
 		}
 
@@ -127,7 +127,7 @@ namespace PressurePlateHandler
 		const auto DelayInfo = ChunkData.GetMechanismDelayInfo(a_Position);
 
 		// Resting state?
-		if (DelayInfo == nullptr)
+		if (!DelayInfo.has_value())
 		{
 			if (PowerLevel == 0)
 			{
@@ -137,7 +137,7 @@ namespace PressurePlateHandler
 
 			// From rest, a player stepped on us
 			// Schedule a minimum 0.5 second delay before even thinking about releasing
-			ChunkData.m_MechanismDelays[a_Position] = std::make_pair(5, true);
+			ChunkData.SetMechanismDelay(a_Position, 5, true);
 
 			a_Chunk.GetWorld()->BroadcastSoundEffect(GetClickOnSound(a_BlockType), Absolute, 0.5f, 0.6f);
 
@@ -170,7 +170,7 @@ namespace PressurePlateHandler
 			if (!HasExitedMinimumOnDelayPhase)
 			{
 				// Reset delay
-				*DelayInfo = std::make_pair(0, true);
+				ChunkData.SetMechanismDelay(a_Position, 0, true);
 			}
 
 			// Did the power level change and is still above zero?
@@ -191,7 +191,7 @@ namespace PressurePlateHandler
 			if (PowerLevel == 0)
 			{
 				// Yes. Go into subsequent release delay, for a further 0.5 seconds
-				*DelayInfo = std::make_pair(5, false);
+				ChunkData.SetMechanismDelay(a_Position, 5, false);
 				return;
 			}
 
@@ -208,7 +208,7 @@ namespace PressurePlateHandler
 		}
 
 		// Just got out of the subsequent release phase, reset everything and raise the plate
-		ChunkData.m_MechanismDelays.erase(a_Position);
+		ChunkData.EraseMechanismDelay(a_Position);
 
 		a_Chunk.GetWorld()->BroadcastSoundEffect(GetClickOffSound(a_BlockType), Absolute, 0.5f, 0.5f);
 		ChunkData.SetCachedPowerData(a_Position, PowerLevel);
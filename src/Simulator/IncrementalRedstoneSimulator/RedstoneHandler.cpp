@@ -116,8 +116,18 @@ namespace RedstoneHandler
 		INVOKE_FOR_HANDLERS(ForValidSourcePositions(Chunk, Position, BlockType, Meta, Callback));
 	}
 
-	void SetWireState(const cChunk & Chunk, const Vector3i Position)
+	void SetWireState(cChunk & Chunk, const Vector3i Position)
 	{
 		RedstoneWireHandler::SetWireState(Chunk, Position);
 	}
+
+	WirePowerTransfer GetWirePowerTransfer(const cChunk & Chunk, const Vector3i Position, const Vector3i QueryPosition, const BLOCKTYPE QueryBlockType, const bool IsLinked)
+	{
+		return RedstoneWireHandler::GetPowerTransfer(Chunk, Position, QueryPosition, QueryBlockType, IsLinked);
+	}
+
+	void ForWireSourcePositions(const cChunk & Chunk, const Vector3i Position, cFunctionRef<void(Vector3i)> Callback)
+	{
+		RedstoneWireHandler::ForValidSourcePositions(Chunk, Position, E_BLOCK_REDSTONE_WIRE, Chunk.GetMeta(Position), Callback);
+	}
 }
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "RedstoneSimulatorChunkData.h"
+#include "../../FunctionRef.h"
 
 
 
@@ -16,6 +17,14 @@ class ForEachSourceCallback;
 
 namespace RedstoneHandler
 {
+	/** How the power of a redstone wire reaches a position, whatever the wire's power level. */
+	enum class WirePowerTransfer
+	{
+		None,
+		Full,
+		Decreased,  // By one, as between two wires
+	};
+
 	/** Asks a redstone component at the source position how much power it will deliver to the querying position.
 	If IsLinked is true, QueryPosition should point to the intermediate conduit block.
 	The Position and QueryPosition are both relative to Chunk. */
@@ -30,5 +39,11 @@ namespace RedstoneHandler
 	void ForValidSourcePositions(const cChunk & Chunk, Vector3i Position, BLOCKTYPE BlockType, NIBBLETYPE Meta, ForEachSourceCallback & Callback);
 
 	/** Temporary: compute and set the block state of a redstone wire. */
-	void SetWireState(const cChunk & Chunk, Vector3i Position);
+	void SetWireState(cChunk & Chunk, Vector3i Position);
+
+	/** Returns how the power of the wire at Position reaches QueryPosition, as delivered by GetPowerDeliveredToPosition(). */
+	WirePowerTransfer GetWirePowerTransfer(const cChunk & Chunk, Vector3i Position, Vector3i QueryPosition, BLOCKTYPE QueryBlockType, bool IsLinked);
+
+	/** Invokes Callback for each position the wire at Position accepts power from. */
+	void ForWireSourcePositions(const cChunk & Chunk, Vector3i Position, cFunctionRef<void(Vector3i)> Callback);
 }
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <bitset>
+
+#include "ChunkDef.h"
+
+
+
+
+
+/** A value for each block of a chunk, stored in arrays allocated only for the sections that have any value set.
+The positions are relative to the chunk, and within it. */
+template <typename T>
+class cRedstoneSectionStore
+{
+	static_assert(std::is_trivially_copyable_v<T>, "The values are kept in raw storage, filled and copied as bytes");
+
+public:
+
+	/** Returns the value at the position, nullptr if none is set. */
+	T * Find(const Vector3i a_Position)
+	{
+		const auto & Section = m_Sections[SectionOf(a_Position)];
+		const auto Index = IndexOf(a_Position);
+		return ((Section != nullptr) && Section->m_IsSet[Index]) ? &Section->m_Values[Index] : nullptr;
+	}
+
+	const T * Find(const Vector3i a_Position) const
+	{
+		const auto & Section = m_Sections[SectionOf(a_Position)];
+		const auto Index = IndexOf(a_Position);
+		return ((Section != nullptr) && Section->m_IsSet[Index]) ? &Section->m_Values[Index] : nullptr;
+	}
+
+	/** Sets the value at the position, allocating its section if needed. Returns the stored value. */
+	T & Set(const Vector3i a_Position, const T a_Value)
+	{
+		auto & Section = m_Sections[SectionOf(a_Position)];
+		if (Section == nullptr)
+		{
+			Section = std::make_unique<sSection>(a_Value);
+		}
+
+		const auto Index = IndexOf(a_Position);
+		if (!Section->m_IsSet[Index])
+		{
+			Section->m_IsSet[Index] = true;
+			Section->m_NumSet++;
+		}
+		Section->m_Values[Index] = a_Value;
+		return Section->m_Values[Index];
+	}
+
+	/** Removes the value at the position, if any. The section is freed along with its last value. */
+	void Erase(const Vector3i a_Position)
+	{
+		auto & Section = m_Sections[SectionOf(a_Position)];
+		const auto Index = IndexOf(a_Position);
+		if ((Section == nullptr) || !Section->m_IsSet[Index])
+		{
+			return;
+		}
+
+		Section->m_IsSet[Index] = false;
+		if (--Section->m_NumSet == 0)
+		{
+			Section.reset();
+		}
+	}
+
+private:
+
+	static constexpr size_t SectionBlockCount = cChunkDef::SectionHeight * cChunkDef::Width * cChunkDef::Width;
+
+	struct sSection
+	{
+		/** Filled with the first value set, so that types without a default value, such as BlockState, can be stored. */
+		explicit sSection(const T a_Fill) :
+			m_NumSet(0)
+		{
+			std::uninitialized_fill_n(m_Values, SectionBlockCount, a_Fill);
+		}
+
+		union
+		{
+			T m_Values[SectionBlockCount];
+		};
+		std::bitset<SectionBlockCount> m_IsSet;
+		size_t m_NumSet;
+	};
+
+	std::unique_ptr<sSection> m_Sections[cChunkDef::NumSections];
+
+
+	static size_t SectionOf(const Vector3i a_Position)
+	{
+		ASSERT(cChunkDef::IsValidRelPos(a_Position));
+		return static_cast<size_t>(a_Position.y) / cChunkDef::SectionHeight;
+	}
+
+	static size_t IndexOf(const Vector3i a_Position)
+	{
+		return static_cast<size_t>(a_Position.x + a_Position.z * cChunkDef::Width) + (static_cast<size_t>(a_Position.y) % cChunkDef::SectionHeight) * cChunkDef::Width * cChunkDef::Width;
+	}
+};
+
+
+
+
+
+/** The positions to simulate, taken last in first out, as from the stack the chunk data used to keep.
+A position within the chunk is queued only once until it is taken; waking it up again meanwhile leaves it where it is.
+Positions in the neighbouring chunks, queued only by the blocks on the chunk's border, aren't checked for duplicates. */
+class cRedstoneActiveQueue
+{
+public:
+
+	bool IsEmpty(void) const { return m_Positions.empty(); }
+
+	size_t GetSize(void) const { return m_Positions.size(); }
+
+	/** Queues the position, unless it is within the chunk and already queued. */
+	void Push(const Vector3i a_Position)
+	{
+		if (cChunkDef::IsValidRelPos(a_Position))
+		{
+			auto & IsQueued = m_IsQueued[static_cast<size_t>(a_Position.y) / cChunkDef::SectionHeight];
+			if (IsQueued == nullptr)
+			{
+				IsQueued = std::make_unique<cSectionBits>();
+			}
+			auto && IsPositionQueued = (*IsQueued)[BitIndex(a_Position)];
+			if (IsPositionQueued)
+			{
+				return;
+			}
+			IsPositionQueued = true;
+		}
+
+		m_Positions.push_back(a_Position);
+	}
+
+	/** Removes the most recently queued position and returns it. The queue mustn't be empty. */
+	Vector3i Pop(void)
+	{
+		ASSERT(!IsEmpty());
+
+		const auto Position = m_Positions.back();
+		m_Positions.pop_back();
+
+		if (cChunkDef::IsValidRelPos(Position))
+		{
+			(*m_IsQueued[static_cast<size_t>(Position.y) / cChunkDef::SectionHeight])[BitIndex(Position)] = false;
+		}
+		return Position;
+	}
+
+private:
+
+	using cSectionBits = std::bitset<cChunkDef::SectionHeight * cChunkDef::Width * cChunkDef::Width>;
+
+	std::vector<Vector3i> m_Positions;
+
+	/** One bit per block, set for the positions within the chunk that are queued. Allocated for the sections woken up. */
+	std::unique_ptr<cSectionBits> m_IsQueued[cChunkDef::NumSections];
+
+
+	static size_t BitIndex(const Vector3i a_Position)
+	{
+		return static_cast<size_t>(a_Position.x + a_Position.z * cChunkDef::Width) + (static_cast<size_t>(a_Position.y) % cChunkDef::SectionHeight) * cChunkDef::Width * cChunkDef::Width;
+	}
+};
@@ -1,11 +1,12 @@
 
 #pragma once
 
-#include <stack>
+#include <optional>
 
 #include "Chunk.h"
 #include "BlockState.h"
 #include "Simulator/RedstoneSimulator.h"
+#include "RedstoneSectionStorage.h"
 
 
 
@@ -13,6 +14,8 @@
 
 using PowerLevel = unsigned char;
 
+class cRedstoneWireNetwork;
+
 
 
 
@@ -21,9 +24,11 @@ class cIncrementalRedstoneSimulatorChunkData final : public cRedstoneSimulatorCh
 {
 public:
 
+	virtual ~cIncrementalRedstoneSimulatorChunkData() override;
+
 	void WakeUp(const Vector3i & a_Position)
 	{
-		m_ActiveBlocks.push(a_Position);
+		m_ActiveBlocks.Push(a_Position);
 	}
 
 	auto & GetActiveBlocks()
@@ -33,42 +38,87 @@ public:
 
 	PowerLevel GetCachedPowerData(const Vector3i Position) const
 	{
-		auto Result = m_CachedPowerLevels.find(Position);
-		return (Result == m_CachedPowerLevels.end()) ? 0 : Result->second;
+		auto Result = m_CachedPowerLevels.Find(Position);
+		return (Result == nullptr) ? 0 : *Result;
 	}
 
 	void SetCachedPowerData(const Vector3i Position, const PowerLevel PowerLevel)
 	{
-		m_CachedPowerLevels[Position] = PowerLevel;
+		m_CachedPowerLevels.Set(Position, PowerLevel);
+	}
+
+	/** Returns the mechanism's remaining delay ticks (zero once elapsed) and whether to power on, if it has a delay. */
+	std::optional<std::pair<int, bool>> GetMechanismDelayInfo(const Vector3i Position) const
+	{
+		const auto Delay = m_MechanismDelays.Find(Position);
+		if (Delay == nullptr)
+		{
+			return {};
+		}
+
+		const auto Remaining = Delay->IsElapsed ? 0 : static_cast<unsigned char>(Delay->DueTick - static_cast<unsigned char>(m_Tick));
+		return std::make_pair(static_cast<int>(Remaining), Delay->ShouldPowerOn);
+	}
+
+	/** Sets the mechanism's delay, the mechanism is woken up once it elapses. A zero delay is already elapsed. */
+	void SetMechanismDelay(const Vector3i Position, const int DelayTicks, const bool ShouldPowerOn)
+	{
+		ASSERT((DelayTicks >= 0) && (DelayTicks < 128));
+
+		const auto DueTick = m_Tick + static_cast<UInt64>(DelayTicks);
+		m_MechanismDelays.Set(Position, { static_cast<unsigned char>(DueTick), (DelayTicks == 0), ShouldPowerOn });
+		if (DelayTicks != 0)
+		{
+			m_DelayTimers.emplace(DueTick, Position);
+		}
 	}
 
-	std::pair<int, bool> * GetMechanismDelayInfo(const Vector3i Position)
+	void EraseMechanismDelay(const Vector3i Position)
 	{
-		auto Result = m_MechanismDelays.find(Position);
-		return (Result == m_MechanismDelays.end()) ? nullptr : &Result->second;
+		m_MechanismDelays.Erase(Position);
+	}
+
+	/** Advances the chunk's tick count and wakes up the mechanisms whose delay elapses now.
+	Only the delays due are visited, not all of them. */
+	void TickMechanismDelays()
+	{
+		m_Tick++;
+		while (!m_DelayTimers.empty() && (m_DelayTimers.top().first <= m_Tick))
+		{
+			const auto [DueTick, Position] = m_DelayTimers.top();
+			m_DelayTimers.pop();
+
+			// The delay may have been erased or replaced since the timer was set:
+			const auto Delay = m_MechanismDelays.Find(Position);
+			if ((Delay != nullptr) && !Delay->IsElapsed && (Delay->DueTick == static_cast<unsigned char>(DueTick)))
+			{
+				Delay->IsElapsed = true;
+				WakeUp(Position);
+			}
+		}
 	}
 
 	/** Erase all cached redstone data for position. */
 	void ErasePowerData(const Vector3i Position)
 	{
-		m_CachedPowerLevels.erase(Position);
-		m_MechanismDelays.erase(Position);
+		m_CachedPowerLevels.Erase(Position);
+		m_MechanismDelays.Erase(Position);
 		AlwaysTickedPositions.erase(Position);
-		WireStates.erase(Position);
+		WireStates.Erase(Position);
 		ObserverCache.erase(Position);
 	}
 
 	PowerLevel ExchangeUpdateOncePowerData(const Vector3i & a_Position, PowerLevel Power)
 	{
-		auto Result = m_CachedPowerLevels.find(a_Position);
+		auto Result = m_CachedPowerLevels.Find(a_Position);
 
-		if (Result == m_CachedPowerLevels.end())
+		if (Result == nullptr)
 		{
-			m_CachedPowerLevels[a_Position] = Power;
+			m_CachedPowerLevels.Set(a_Position, Power);
 			return 0;
 		}
 
-		return std::exchange(Result->second, Power);
+		return std::exchange(*Result, Power);
 	}
 
 	/** Adjust From-relative coordinates into To-relative coordinates. */
@@ -83,23 +133,56 @@ public:
 	}
 
 	/** Temporary, should be chunk data: wire block store, to avoid recomputing states every time. */
-	std::unordered_map<Vector3i, BlockState, VectorHasher<int>> WireStates;
+	cRedstoneSectionStore<BlockState> WireStates;
 
 	std::unordered_set<Vector3i, VectorHasher<int>> AlwaysTickedPositions;
 
 	/** Structure storing an observer's last seen block. */
 	std::unordered_map<Vector3i, std::pair<BLOCKTYPE, NIBBLETYPE>, VectorHasher<int>> ObserverCache;
 
-	/** Structure storing position of mechanism + it's delay ticks (countdown) & if to power on. */
-	std::unordered_map<Vector3i, std::pair<int, bool>, VectorHasher<int>> m_MechanismDelays;
+	/** The wire networks compiled from this chunk's wires. */
+	std::vector<std::unique_ptr<cRedstoneWireNetwork>> WireNetworks;
+
+	/** The network and the index within it of each compiled wire. */
+	std::unordered_map<Vector3i, std::pair<cRedstoneWireNetwork *, size_t>, VectorHasher<int>> CompiledWires;
+
+	/** The number of ticks before this chunk's wires may be compiled again, after a block change dissolved a network. */
+	int CompileCooldown = 0;
 
 private:
 
-	std::stack<Vector3i, std::vector<Vector3i>> m_ActiveBlocks;
+	struct sMechanismDelay
+	{
+		/** The chunk tick the delay elapses at, the lowest byte of it. No delay is longer than a few ticks. */
+		unsigned char DueTick;
+
+		bool IsElapsed;
+		bool ShouldPowerOn;
+	};
+
+	/** Orders the delay timers soonest first. */
+	struct sLaterTimer
+	{
+		bool operator () (const std::pair<UInt64, Vector3i> & a_Lhs, const std::pair<UInt64, Vector3i> & a_Rhs) const
+		{
+			return a_Lhs.first > a_Rhs.first;
+		}
+	};
+
+	cRedstoneActiveQueue m_ActiveBlocks;
 
 	// TODO: map<Vector3i, int> -> Position of torch + it's heat level
 
-	std::unordered_map<Vector3i, PowerLevel, VectorHasher<int>> m_CachedPowerLevels;
+	cRedstoneSectionStore<PowerLevel> m_CachedPowerLevels;
+
+	/** The delay of each waiting mechanism: repeaters, torches, comparators, observers and pressure plates. */
+	cRedstoneSectionStore<sMechanismDelay> m_MechanismDelays;
+
+	/** The tick each pending delay elapses at, with the mechanism's position. May hold stale timers, skipped when due. */
+	std::priority_queue<std::pair<UInt64, Vector3i>, std::vector<std::pair<UInt64, Vector3i>>, sLaterTimer> m_DelayTimers;
+
+	/** The number of times the chunk has been simulated, the clock of the delays. */
+	UInt64 m_Tick = 0;
 
 	friend class cRedstoneHandlerFactory;
 };
@@ -52,12 +52,12 @@ namespace RedstoneTorchHandler
 		auto & Data = DataForChunk(a_Chunk);
 		auto DelayInfo = Data.GetMechanismDelayInfo(a_Position);
 
-		if (DelayInfo == nullptr)
+		if (!DelayInfo.has_value())
 		{
 			const bool ShouldBeOn = (Power == 0);
 			if (ShouldBeOn != IsOn(a_BlockType))
 			{
-				Data.m_MechanismDelays[a_Position] = std::make_pair(1, ShouldBeOn);
+				Data.SetMechanismDelay(a_Position, 1, ShouldBeOn);
 			}
 
 			return;
@@ -73,7 +73,7 @@ namespace RedstoneTorchHandler
 		}
 
 		a_Chunk.FastSetBlock(a_Position, ShouldPowerOn ? E_BLOCK_REDSTONE_TORCH_ON : E_BLOCK_REDSTONE_TORCH_OFF, a_Meta);
-		Data.m_MechanismDelays.erase(a_Position);
+		Data.EraseMechanismDelay(a_Position);
 
 		for (const auto & Adjacent : RelativeAdjacents)
 		{
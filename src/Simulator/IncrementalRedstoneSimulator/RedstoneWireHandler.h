@@ -116,7 +116,7 @@ namespace RedstoneWireHandler
 
 	/** Temporary. Discovers a wire's connection state, including terracing, storing the block inside redstone chunk data.
 	TODO: once the server supports block states this should go in the block handler, with data saved in the world. */
-	static void SetWireState(const cChunk & a_Chunk, const Vector3i a_Position)
+	static void SetWireState(cChunk & a_Chunk, const Vector3i a_Position)
 	{
 		auto Block = Block::RedstoneWire::RedstoneWire();
 		const bool IsYPTerracingBlocked = RedstoneWireHandler::IsYPTerracingBlocked(a_Chunk, a_Position);
@@ -146,7 +146,7 @@ namespace RedstoneWireHandler
 				// This function is called during chunk load (through AddBlock). Attempt to tell it its new state:
 				if ((NeighbourChunk != &a_Chunk) && (LateralBlock == E_BLOCK_REDSTONE_WIRE))
 				{
-					auto & NeighbourBlock = DataForChunk(*NeighbourChunk).WireStates.find(Adjacent)->second;
+					auto & NeighbourBlock = *DataForChunk(*NeighbourChunk).WireStates.Find(Adjacent);
 					SetDirectionState(-Offset, NeighbourBlock, TemporaryDirection::Side);
 				}
 
@@ -163,7 +163,7 @@ namespace RedstoneWireHandler
 
 				if (NeighbourChunk != &a_Chunk)
 				{
-					auto & NeighbourBlock = DataForChunk(*NeighbourChunk).WireStates.find(Adjacent + OffsetYP)->second;
+					auto & NeighbourBlock = *DataForChunk(*NeighbourChunk).WireStates.Find(Adjacent + OffsetYP);
 					SetDirectionState(-Offset, NeighbourBlock, TemporaryDirection::Side);
 				}
 
@@ -181,35 +181,36 @@ namespace RedstoneWireHandler
 
 				if (NeighbourChunk != &a_Chunk)
 				{
-					auto & NeighbourBlock = DataForChunk(*NeighbourChunk).WireStates.find(Adjacent + OffsetYM)->second;
+					auto & NeighbourBlock = *DataForChunk(*NeighbourChunk).WireStates.Find(Adjacent + OffsetYM);
 					SetDirectionState(-Offset, NeighbourBlock, TemporaryDirection::Up);
 				}
 			}
 		}
 
 		auto & States = DataForChunk(a_Chunk).WireStates;
-		const auto FindResult = States.find(a_Position);
-		if (FindResult != States.end())
+		const auto FindResult = States.Find(a_Position);
+		if (FindResult != nullptr)
 		{
-			if (Block != FindResult->second)
+			if (Block != *FindResult)
 			{
-				FindResult->second = Block;
+				*FindResult = Block;
 
 				// TODO: when state is stored as the block, the block handler updating via SetBlock will do this automatically
 				// When a wire changes connection state, it needs to update its neighbours:
-				a_Chunk.GetWorld()->WakeUpSimulators(cChunkDef::RelativeToAbsolute(a_Position, a_Chunk.GetPos()));
+				a_Chunk.WakeUpSimulators(a_Position);
 			}
 
 			return;
 		}
 
-		DataForChunk(a_Chunk).WireStates.emplace(a_Position, Block);
+		States.Set(a_Position, Block);
 	}
 
-	static PowerLevel GetPowerDeliveredToPosition(const cChunk & a_Chunk, Vector3i a_Position, BLOCKTYPE a_BlockType, Vector3i a_QueryPosition, BLOCKTYPE a_QueryBlockType, bool IsLinked)
+	/** Returns how the power of the wire at a_Position reaches the query position; it doesn't depend on the wire's power level. */
+	static RedstoneHandler::WirePowerTransfer GetPowerTransfer(const cChunk & a_Chunk, Vector3i a_Position, Vector3i a_QueryPosition, BLOCKTYPE a_QueryBlockType, bool IsLinked)
 	{
-		// Starts off as the wire's meta value, modified appropriately and returned
-		auto Power = a_Chunk.GetMeta(a_Position);
+		using RedstoneHandler::WirePowerTransfer;
+
 		const auto QueryOffset = a_QueryPosition - a_Position;
 
 		if (
@@ -217,19 +218,20 @@ namespace RedstoneWireHandler
 			(IsLinked && (a_QueryBlockType == E_BLOCK_REDSTONE_WIRE))  // Nor do they link power other wires
 		)
 		{
-			return 0;
+			return WirePowerTransfer::None;
 		}
 
 		if (QueryOffset == OffsetYM)
 		{
 			// Wires always deliver power to the block underneath
-			return Power;
+			return WirePowerTransfer::Full;
 		}
 
 		const auto & Data = DataForChunk(a_Chunk);
-		const auto Block = Data.WireStates.find(a_Position)->second;
+		const auto Block = *Data.WireStates.Find(a_Position);
+		auto Transfer = WirePowerTransfer::Full;
 
-		DoWithDirectionState(QueryOffset, Block, [a_QueryBlockType, &Power](const auto Left, const auto Front, const auto Right)
+		DoWithDirectionState(QueryOffset, Block, [a_QueryBlockType, &Transfer](const auto Left, const auto Front, const auto Right)
 		{
 			using LeftState = std::remove_reference_t<decltype(Left)>;
 			using FrontState = std::remove_reference_t<decltype(Front)>;
@@ -238,11 +240,11 @@ namespace RedstoneWireHandler
 			// Wires always deliver power to any directly connecting mechanisms:
 			if (Front != FrontState::None)
 			{
-				if ((a_QueryBlockType == E_BLOCK_REDSTONE_WIRE) && (Power != 0))
+				if (a_QueryBlockType == E_BLOCK_REDSTONE_WIRE)
 				{
 					// For mechanisms, wire of power one will still power them
 					// But for wire-to-wire connections, power level decreases by 1:
-					Power--;
+					Transfer = WirePowerTransfer::Decreased;
 				}
 
 				return;
@@ -264,10 +266,24 @@ namespace RedstoneWireHandler
 			}
 
 			// Case 3
-			Power = 0;
+			Transfer = WirePowerTransfer::None;
 		});
 
-		return Power;
+		return Transfer;
+	}
+
+	static PowerLevel GetPowerDeliveredToPosition(const cChunk & a_Chunk, Vector3i a_Position, BLOCKTYPE a_BlockType, Vector3i a_QueryPosition, BLOCKTYPE a_QueryBlockType, bool IsLinked)
+	{
+		// Starts off as the wire's meta value, modified appropriately and returned
+		const auto Power = a_Chunk.GetMeta(a_Position);
+
+		switch (GetPowerTransfer(a_Chunk, a_Position, a_QueryPosition, a_QueryBlockType, IsLinked))
+		{
+			case RedstoneHandler::WirePowerTransfer::None:      return 0;
+			case RedstoneHandler::WirePowerTransfer::Full:      return Power;
+			case RedstoneHandler::WirePowerTransfer::Decreased: return (Power == 0) ? 0 : static_cast<PowerLevel>(Power - 1);
+		}
+		UNREACHABLE("Unsupported wire power transfer");
 	}
 
 	static void Update(cChunk & a_Chunk, cChunk & CurrentlyTicking, Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const PowerLevel Power)
@@ -286,7 +302,9 @@ namespace RedstoneWireHandler
 		UpdateAdjustedRelatives(a_Chunk, CurrentlyTicking, a_Position, RelativeLaterals);
 	}
 
-	static void ForValidSourcePositions(const cChunk & a_Chunk, Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, ForEachSourceCallback & Callback)
+	/** Invokes Callback for each position the wire accepts power from. A template so that the circuit compiler can collect the positions. */
+	template <class CallbackType>
+	static void ForValidSourcePositions(const cChunk & a_Chunk, Vector3i a_Position, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, CallbackType & Callback)
 	{
 		UNUSED(a_BlockType);
 		UNUSED(a_Meta);
@@ -295,7 +313,7 @@ namespace RedstoneWireHandler
 		Callback(a_Position + OffsetYM);
 
 		const auto & Data = DataForChunk(a_Chunk);
-		const auto Block = Data.WireStates.find(a_Position)->second;
+		const auto Block = *Data.WireStates.Find(a_Position);
 
 		// Figure out, based on our pre-computed block, where we connect to:
 		for (const auto & Offset : RelativeLaterals)
@@ -0,0 +1,211 @@
+#include "Globals.h"
+
+#include "RedstoneWireNetwork.h"
+#include "BlockType.h"
+#include "RedstoneHandler.h"
+#include "RedstoneDataHelper.h"
+#include "ForEachSourceCallback.h"
+
+
+
+
+
+std::unique_ptr<cRedstoneWireNetwork> cRedstoneWireNetwork::Compile(const cChunk & a_Chunk, const Vector3i a_Position)
+{
+	const auto & Data = DataForChunk(a_Chunk);
+
+	// A wire may join if it's in this chunk, has its state computed and isn't in another network yet:
+	const auto CanJoin = [&a_Chunk, &Data](const Vector3i a_Wire)
+	{
+		return (
+			cChunkDef::IsValidRelPos(a_Wire) &&
+			(a_Chunk.GetBlock(a_Wire) == E_BLOCK_REDSTONE_WIRE) &&
+			(Data.WireStates.Find(a_Wire) != nullptr) &&
+			(Data.CompiledWires.find(a_Wire) == Data.CompiledWires.end())
+		);
+	};
+	if (!CanJoin(a_Position))
+	{
+		return nullptr;
+	}
+
+	auto Network = std::make_unique<cRedstoneWireNetwork>();
+	std::unordered_map<Vector3i, size_t, VectorHasher<int>> Indices;
+	const auto IndexOf = [&Network, &Indices](const Vector3i a_Wire)
+	{
+		const auto [Itr, IsNew] = Indices.emplace(a_Wire, Network->m_Wires.size());
+		if (IsNew)
+		{
+			Network->m_Wires.push_back(a_Wire);
+			Network->m_FanOut.emplace_back();
+			Network->m_OutsideSources.emplace_back();
+		}
+		return Itr->second;
+	};
+	IndexOf(a_Position);
+
+	// Go breadth-first through the wires feeding each other, m_Wires grows as they are found:
+	for (size_t i = 0; i < Network->m_Wires.size(); i++)
+	{
+		const auto Wire = Network->m_Wires[i];
+		RedstoneHandler::ForWireSourcePositions(a_Chunk, Wire, [&](const Vector3i a_Source)
+		{
+			if (!cChunkDef::IsValidHeight(a_Source))
+			{
+				// ForEachSourceCallback skips these as well
+				return;
+			}
+
+			if (!CanJoin(a_Source))
+			{
+				Network->m_OutsideSources[i].push_back(a_Source);
+				return;
+			}
+
+			const auto Transfer = RedstoneHandler::GetWirePowerTransfer(a_Chunk, a_Source, Wire, E_BLOCK_REDSTONE_WIRE, false);
+			const auto Source = IndexOf(a_Source);
+			if (Transfer != RedstoneHandler::WirePowerTransfer::None)
+			{
+				Network->m_FanOut[Source].push_back({ i, (Transfer == RedstoneHandler::WirePowerTransfer::Decreased) });
+			}
+		});
+	}
+
+	// The first evaluation asks all the outside sources:
+	const auto NumWires = Network->m_Wires.size();
+	Network->m_OutsidePower.resize(NumWires, 0);
+	Network->m_IsWoken.resize(NumWires, false);
+	for (size_t i = 0; i < NumWires; i++)
+	{
+		Network->WakeUp(i);
+	}
+	return Network;
+}
+
+
+
+
+
+void cRedstoneWireNetwork::WakeUp(const size_t a_Index)
+{
+	ASSERT(a_Index < m_Wires.size());
+
+	if (!m_IsWoken[a_Index])
+	{
+		m_IsWoken[a_Index] = true;
+		m_WokenWires.push_back(a_Index);
+	}
+}
+
+
+
+
+
+void cRedstoneWireNetwork::Evaluate(cChunk & a_Chunk, cChunk & a_TickingChunk)
+{
+	// Ask the outside sources of the woken wires for their power:
+	for (const auto Index: m_WokenWires)
+	{
+		ForEachSourceCallback Callback(a_Chunk, m_Wires[Index], E_BLOCK_REDSTONE_WIRE);
+		for (const auto & Source: m_OutsideSources[Index])
+		{
+			Callback(Source);
+		}
+		ASSERT(Callback.Power <= 15);
+		m_OutsidePower[Index] = Callback.Power;
+		m_IsWoken[Index] = false;
+	}
+	m_WokenWires.clear();
+
+	// Propagate the power through the network, strongest first, so that each wire is only settled once:
+	std::vector<PowerLevel> Power(m_OutsidePower);
+	std::array<std::vector<size_t>, 16> Pending;
+	for (size_t i = 0; i < Power.size(); i++)
+	{
+		if (Power[i] > 0)
+		{
+			Pending[Power[i]].push_back(i);
+		}
+	}
+	for (size_t Level = Pending.size() - 1; Level > 0; Level--)
+	{
+		auto & Wires = Pending[Level];
+		while (!Wires.empty())
+		{
+			const auto Index = Wires.back();
+			Wires.pop_back();
+			if (Power[Index] != Level)
+			{
+				// Reached by a stronger power since queued
+				continue;
+			}
+
+			for (const auto & Edge: m_FanOut[Index])
+			{
+				const auto Delivered = static_cast<PowerLevel>(Edge.m_IsDecreasing ? (Level - 1) : Level);
+				if (Delivered > Power[Edge.m_Target])
+				{
+					Power[Edge.m_Target] = Delivered;
+					Pending[Delivered].push_back(Edge.m_Target);
+				}
+			}
+		}
+	}
+
+	// Set the changed wires and tell their surroundings:
+	for (size_t i = 0; i < m_Wires.size(); i++)
+	{
+		if (a_Chunk.GetMeta(m_Wires[i]) != Power[i])
+		{
+			a_Chunk.SetMeta(m_Wires[i], Power[i]);
+			WakeUpAround(a_Chunk, a_TickingChunk, m_Wires[i]);
+		}
+	}
+}
+
+
+
+
+
+bool cRedstoneWireNetwork::IsOwnWire(const cChunk & a_Chunk, const Vector3i a_Position) const
+{
+	if (!cChunkDef::IsValidRelPos(a_Position))
+	{
+		return false;
+	}
+
+	const auto & CompiledWires = DataForChunk(a_Chunk).CompiledWires;
+	const auto Itr = CompiledWires.find(a_Position);
+	return (Itr != CompiledWires.end()) && (Itr->second.first == this);
+}
+
+
+
+
+
+void cRedstoneWireNetwork::WakeUpAround(const cChunk & a_Chunk, cChunk & a_TickingChunk, const Vector3i a_Position) const
+{
+	auto & TickingData = DataForChunk(a_TickingChunk);
+	const auto WakeUpIfOutside = [this, &a_Chunk, &a_TickingChunk, &TickingData](const Vector3i a_ToWake)
+	{
+		if (cChunkDef::IsValidHeight(a_ToWake) && !IsOwnWire(a_Chunk, a_ToWake))
+		{
+			TickingData.WakeUp(cIncrementalRedstoneSimulatorChunkData::RebaseRelativePosition(a_Chunk, a_TickingChunk, a_ToWake));
+		}
+	};
+
+	// The same positions as RedstoneWireHandler::Update() wakes, all but above, each with its linked positions:
+	const Vector3i Offsets[] = { OffsetYM, RelativeLaterals[0], RelativeLaterals[1], RelativeLaterals[2], RelativeLaterals[3] };
+	for (const auto & Offset: Offsets)
+	{
+		if (!cChunkDef::IsValidHeight(a_Position + Offset))
+		{
+			continue;
+		}
+		WakeUpIfOutside(a_Position + Offset);
+		for (const auto & LinkedOffset: cSimulator::GetLinkedOffsets(Offset))
+		{
+			WakeUpIfOutside(a_Position + LinkedOffset);
+		}
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "RedstoneSimulatorChunkData.h"
+
+
+
+
+
+/*
+Evaluating a wire block by block means asking each of its source positions for their power, through the handlers and
+the hashed redstone data, and waking all the neighbours again whenever its power changes; a single lever flick on a
+long line of wire re-evaluates every wire several times before the powers settle.
+A compiled network lists, for each wire, the other wires it feeds and whether the power decreases on the way, and
+the remaining source positions, those outside of the network. When some of its wires are woken, only their outside
+sources are asked for power; the powers of all the wires are then propagated over the graph, strongest first, and
+only the positions around the wires that changed, outside the network, are woken.
+The structure depends only on the blocks within one block of each wire, which the simulator itself never changes
+other than the wires' power. When any of these blocks is changed by other means, the network is dissolved and its
+wires are simulated block by block again, until they are compiled anew.
+*/
+
+
+
+
+
+class cRedstoneWireNetwork
+{
+public:
+
+	/** Compiles the wires connected to the wire at a_Position, limited to a_Chunk, leaving out the wires already
+	compiled into another network. Returns nullptr if the wire at a_Position cannot be compiled. */
+	static std::unique_ptr<cRedstoneWireNetwork> Compile(const cChunk & a_Chunk, Vector3i a_Position);
+
+	/** Marks the wire at the specified index as woken, its outside sources are asked for power in the next Evaluate(). */
+	void WakeUp(size_t a_Index);
+
+	/** Returns true if any of the wires have been woken since the last Evaluate(). */
+	bool IsWoken(void) const { return !m_WokenWires.empty(); }
+
+	/** Updates the power levels of all the wires in a_Chunk, given the power of the outside sources of the woken ones.
+	The positions around the changed wires, except for the network's own wires, are queued to a_TickingChunk. */
+	void Evaluate(cChunk & a_Chunk, cChunk & a_TickingChunk);
+
+	/** Returns the positions of the network's wires, relative to their chunk; the index of a wire is its position in the list. */
+	const std::vector<Vector3i> & GetWires(void) const { return m_Wires; }
+
+private:
+
+	struct sEdge
+	{
+		/** The index of the wire being fed. */
+		size_t m_Target;
+
+		/** True if the power decreases by one on the way. */
+		bool m_IsDecreasing;
+	};
+
+	std::vector<Vector3i> m_Wires;
+
+	/** For each wire, the wires it feeds. */
+	std::vector<std::vector<sEdge>> m_FanOut;
+
+	/** For each wire, its source positions outside of the network. */
+	std::vector<std::vector<Vector3i>> m_OutsideSources;
+
+	/** For each wire, the power it got from its outside sources when last woken. */
+	std::vector<PowerLevel> m_OutsidePower;
+
+	/** The wires woken since the last Evaluate(); m_IsWoken tells whether each one is in the list. */
+	std::vector<size_t> m_WokenWires;
+	std::vector<bool> m_IsWoken;
+
+
+	/** Returns true if the position is one of the network's wires. */
+	bool IsOwnWire(const cChunk & a_Chunk, Vector3i a_Position) const;
+
+	/** Queues the positions a wire's power change affects, as the wire handler does, but the network's own wires. */
+	void WakeUpAround(const cChunk & a_Chunk, cChunk & a_TickingChunk, Vector3i a_Position) const;
+};
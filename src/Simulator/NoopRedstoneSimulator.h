@@ -10,15 +10,8 @@
 class cRedstoneNoopSimulator final :
 	public cRedstoneSimulator
 {
-	using Super = cRedstoneSimulator;
-
 public:
 
-	cRedstoneNoopSimulator(cWorld & a_World):
-		Super(a_World)
-	{
-	}
-
 	virtual void SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk) override
 	{
 		UNUSED(a_Dt);
@@ -23,11 +23,7 @@ public:
 class cRedstoneSimulator:
 	public cSimulator
 {
-	using Super = cSimulator;
-
 public:
 
-	using Super::Super;
-
 	virtual cRedstoneSimulatorChunkData * CreateChunkData() = 0;
 };
@@ -15,7 +15,7 @@
 
 
 cSandSimulator::cSandSimulator(cWorld & a_World, cIniFile & a_IniFile) :
-	cSimulator(a_World),
+	m_World(a_World),
 	m_TotalBlocks(0)
 {
 	m_IsInstantFall = a_IniFile.GetValueSetB("Physics", "SandInstantFall", false);
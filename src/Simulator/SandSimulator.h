@@ -10,6 +10,7 @@
 
 // fwd:
 class cChunk;
+class cWorld;
 
 
 
@@ -57,6 +58,8 @@ private:
 
 	virtual void SimulateChunk(std::chrono::milliseconds a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk) override;
 
+	cWorld & m_World;
+
 	bool m_IsInstantFall;  // If set to true, blocks don't fall using cFallingBlock entity, but instantly instead
 
 	int  m_TotalBlocks;    // Total number of blocks currently in the queue for simulating
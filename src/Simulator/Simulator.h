@@ -3,7 +3,6 @@
 
 #include "ChunkDef.h"
 
-class cWorld;
 class cChunk;
 class cCuboid;
 
@@ -22,11 +21,6 @@ class cSimulator
 {
 public:
 
-	cSimulator(cWorld & a_World)
-		: m_World(a_World)
-	{
-	}
-
 	virtual ~cSimulator() {}
 
 	/** Contains offsets for direct adjacents of any position. */
@@ -67,6 +61,4 @@ protected:
 	Simulators may use this information to update additional blocks that were affected by the change, or queue
 	farther, extra-adjacents blocks to be updated. The simulator manager calls this overload after the 3-argument WakeUp. */
 	virtual void WakeUp(cChunk & a_Chunk, Vector3i a_Position, Vector3i a_Offset, BLOCKTYPE a_Block);
-
-	cWorld & m_World;
 } ;
@@ -4,14 +4,13 @@
 #include "SimulatorManager.h"
 #include "../Chunk.h"
 #include "../Cuboid.h"
-#include "../World.h"
+#include "../Profiler.h"
 
 
 
 
 
-cSimulatorManager::cSimulatorManager(cWorld & a_World) :
-	m_World(a_World),
+cSimulatorManager::cSimulatorManager(void) :
 	m_Ticks(0)
 {
 }
@@ -30,6 +29,8 @@ cSimulatorManager::~cSimulatorManager()
 
 void cSimulatorManager::Simulate(float a_Dt)
 {
+	cProfileScope Profile("cSimulatorManager::Simulate");
+
 	m_Ticks++;
 
 	for (cSimulators::iterator itr = m_Simulators.begin(); itr != m_Simulators.end(); ++itr)
@@ -102,48 +103,29 @@ void cSimulatorManager::WakeUp(cChunk & a_Chunk, Vector3i a_Position)
 
 
 
-void cSimulatorManager::WakeUp(const cCuboid & a_Area)
+void cSimulatorManager::WakeUp(cChunk & a_Chunk, const cCuboid & a_Area)
 {
-	cCuboid area(a_Area);
-	area.Sort();
-	area.Expand(1, 1, 1, 1, 1, 1);  // Expand the area to contain the neighbors, too.
-	area.ClampY(0, cChunkDef::Height - 1);
-
-	cChunkCoords ChunkStart = cChunkDef::BlockToChunk(area.p1);
-	cChunkCoords ChunkEnd = cChunkDef::BlockToChunk(area.p2);
+	int startX = std::max(a_Area.p1.x, a_Chunk.GetPosX() * cChunkDef::Width);
+	int startZ = std::max(a_Area.p1.z, a_Chunk.GetPosZ() * cChunkDef::Width);
+	int endX = std::min(a_Area.p2.x, a_Chunk.GetPosX() * cChunkDef::Width + cChunkDef::Width - 1);
+	int endZ = std::min(a_Area.p2.z, a_Chunk.GetPosZ() * cChunkDef::Width + cChunkDef::Width - 1);
 
-	// Add all blocks, in a per-chunk manner:
-	for (int cz = ChunkStart.m_ChunkZ; cz <= ChunkEnd.m_ChunkZ; ++cz)
+	for (const auto & Item : m_Simulators)
 	{
-		for (int cx = ChunkStart.m_ChunkX; cx <= ChunkEnd.m_ChunkX; ++cx)
+		const auto Simulator = Item.first;
+
+		for (int y = a_Area.p1.y; y <= a_Area.p2.y; ++y)
 		{
-			m_World.DoWithChunk(cx, cz, [this, &area](cChunk & a_CBChunk)
+			for (int z = startZ; z <= endZ; ++z)
 			{
-				int startX = std::max(area.p1.x, a_CBChunk.GetPosX() * cChunkDef::Width);
-				int startZ = std::max(area.p1.z, a_CBChunk.GetPosZ() * cChunkDef::Width);
-				int endX = std::min(area.p2.x, a_CBChunk.GetPosX() * cChunkDef::Width + cChunkDef::Width - 1);
-				int endZ = std::min(area.p2.z, a_CBChunk.GetPosZ() * cChunkDef::Width + cChunkDef::Width - 1);
-
-				for (const auto & Item : m_Simulators)
+				for (int x = startX; x <= endX; ++x)
 				{
-					const auto Simulator = Item.first;
-
-					for (int y = area.p1.y; y <= area.p2.y; ++y)
-					{
-						for (int z = startZ; z <= endZ; ++z)
-						{
-							for (int x = startX; x <= endX; ++x)
-							{
-								const auto Position = cChunkDef::AbsoluteToRelative({ x, y, z });
-								Simulator->WakeUp(a_CBChunk, Position, a_CBChunk.GetBlock(Position));
-							}  // for x
-						}  // for z
-					}  // for y
-				}
-				return true;
-			});
-		}  // for cx
-	}  // for cz
+					const auto Position = cChunkDef::AbsoluteToRelative({ x, y, z });
+					Simulator->WakeUp(a_Chunk, Position, a_Chunk.GetBlock(Position));
+				}  // for x
+			}  // for z
+		}  // for y
+	}
 }
 
 
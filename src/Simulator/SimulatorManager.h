@@ -18,9 +18,6 @@
 // fwd: Chunk.h
 class cChunk;
 
-// fwd: World.h
-class cWorld;
-
 
 
 
@@ -29,7 +26,7 @@ class cSimulatorManager
 {
 public:
 
-	cSimulatorManager(cWorld & a_World);
+	cSimulatorManager(void);
 	~cSimulatorManager();
 
 	/** Called in each tick, a_Dt is the time passed since the last tick, in msec. */
@@ -42,11 +39,10 @@ public:
 	The simulator implementation may also decide to wake blocks farther away. */
 	void WakeUp(cChunk & a_Chunk, Vector3i a_Position);
 
-	/** Does the same processing as WakeUp, but for all blocks within the specified area.
-	Has better performance than calling WakeUp for each block individually, due to neighbor-checking.
-	All chunks intersected by the area should be valid (outputs a warning if not).
-	Note that, unlike WakeUp(), this call adds blocks not only face-neighboring, but also edge-neighboring and corner-neighboring the specified area. */
-	void WakeUp(const cCuboid & a_Area);
+	/** Wakes all simulators up for the blocks of the chunk within the specified area, the area in absolute coords.
+	Has better performance than calling WakeUp for each block individually, due to no neighbor-checking.
+	The caller includes the neighbors in the area, see cWorld::WakeUpSimulatorsInArea(). */
+	void WakeUp(cChunk & a_Chunk, const cCuboid & a_Area);
 
 	void RegisterSimulator(cSimulator * a_Simulator, int a_Rate);  // Takes ownership of the simulator object!
 
@@ -54,7 +50,6 @@ protected:
 
 	typedef std::vector <std::pair<cSimulator *, int> > cSimulators;
 
-	cWorld & m_World;
 	cSimulators m_Simulators;
 	long long   m_Ticks;
 };
@@ -134,6 +134,15 @@ Compression::Result Compression::Compressor::CompressZLib(const void * const Inp
 
 
 
+Compression::Result Compression::Compressor::CompressDeflate(const ContiguousByteBufferView Input)
+{
+	return Compress<&libdeflate_deflate_compress>(Input.data(), Input.size());
+}
+
+
+
+
+
 Compression::Extractor::Extractor()
 {
 	m_Handle = libdeflate_alloc_decompressor();
@@ -184,6 +193,42 @@ Compression::Result Compression::Extractor::ExtractZLib(ContiguousByteBufferView
 
 
 
+ContiguousByteBufferView Compression::Extractor::ExtractZLib(const ContiguousByteBufferView Input, const size_t UncompressedSize, ContiguousByteBuffer & Output)
+{
+	if (Output.size() < UncompressedSize)
+	{
+		Output.resize(UncompressedSize);
+	}
+
+	if (libdeflate_zlib_decompress(m_Handle, Input.data(), Input.size(), Output.data(), UncompressedSize, nullptr) != libdeflate_result::LIBDEFLATE_SUCCESS)
+	{
+		throw std::runtime_error("Data extraction failed.");
+	}
+	return { Output.data(), UncompressedSize };
+}
+
+
+
+
+
+ContiguousByteBufferView Compression::Extractor::ExtractDeflate(const ContiguousByteBufferView Input, const size_t UncompressedSize, ContiguousByteBuffer & Output)
+{
+	if (Output.size() < UncompressedSize)
+	{
+		Output.resize(UncompressedSize);
+	}
+
+	if (libdeflate_deflate_decompress(m_Handle, Input.data(), Input.size(), Output.data(), UncompressedSize, nullptr) != libdeflate_result::LIBDEFLATE_SUCCESS)
+	{
+		throw std::runtime_error("Data extraction failed.");
+	}
+	return { Output.data(), UncompressedSize };
+}
+
+
+
+
+
 template <auto Algorithm>
 Compression::Result Compression::Extractor::Extract(const ContiguousByteBufferView Input)
 {
@@ -52,6 +52,9 @@ namespace Compression
 		Result CompressZLib(ContiguousByteBufferView Input);
 		Result CompressZLib(const void * Input, size_t Size);
 
+		/** Compresses into raw deflate data, without any header or checksum. */
+		Result CompressDeflate(ContiguousByteBufferView Input);
+
 	private:
 
 		template <auto Algorithm>
@@ -73,6 +76,13 @@ namespace Compression
 		Result ExtractZLib(ContiguousByteBufferView Input);
 		Result ExtractZLib(ContiguousByteBufferView Input, size_t UncompressedSize);
 
+		/** Extracts the zlib data of a known size into Output, returning the view of the extracted data within it.
+		Output is only ever grown, so that a buffer kept across the calls stops allocating once it fits the largest data. */
+		ContiguousByteBufferView ExtractZLib(ContiguousByteBufferView Input, size_t UncompressedSize, ContiguousByteBuffer & Output);
+
+		/** Extracts the raw deflate data of a known size into Output, same as the zlib variant above. */
+		ContiguousByteBufferView ExtractDeflate(ContiguousByteBufferView Input, size_t UncompressedSize, ContiguousByteBuffer & Output);
+
 	private:
 
 		template <auto Algorithm> Result Extract(ContiguousByteBufferView Input);
@@ -0,0 +1,235 @@
+// Timings.cpp
+
+// Implements the cTimings class that accumulates the time spent per chunk, entity class, block entity type and plugin hook
+
+#include "Globals.h"
+#include "Timings.h"
+
+
+
+
+
+namespace
+{
+	/** The accumulated measurements of a single item. */
+	struct sEntry
+	{
+		cTimings::clock::duration m_Total = cTimings::clock::duration::zero();
+		cTimings::clock::duration m_Max = cTimings::clock::duration::zero();
+		UInt64 m_Count = 0;
+
+		void Add(cTimings::clock::duration a_Duration)
+		{
+			m_Total += a_Duration;
+			m_Max = std::max(m_Max, a_Duration);
+			m_Count += 1;
+		}
+
+		void Merge(const sEntry & a_Other)
+		{
+			m_Total += a_Other.m_Total;
+			m_Max = std::max(m_Max, a_Other.m_Max);
+			m_Count += a_Other.m_Count;
+		}
+	};
+
+	using cEntries = std::unordered_map<AString, sEntry>;
+
+
+
+
+
+	/** The accumulator of a single thread.
+	The CS is only contended while a report is being made, so the owner thread practically never waits on it. */
+	struct sThreadTimings
+	{
+		cCriticalSection m_CS;
+		std::array<cEntries, cTimings::NumCategories> m_Entries;
+	};
+
+
+
+
+
+	/** All the thread accumulators ever created, and the time of the last reset. */
+	struct sRegistry
+	{
+		cCriticalSection m_CS;
+		std::vector<std::shared_ptr<sThreadTimings>> m_Threads;
+		cTimings::clock::time_point m_LastReset = cTimings::clock::now();
+	};
+
+
+
+
+
+	sRegistry & GetRegistry()
+	{
+		static sRegistry Registry;
+		return Registry;
+	}
+
+
+
+
+
+	/** Returns the calling thread's accumulator, creating and registering it on first use. */
+	sThreadTimings & GetThreadTimings()
+	{
+		thread_local std::shared_ptr<sThreadTimings> Timings;
+		if (Timings == nullptr)
+		{
+			Timings = std::make_shared<sThreadTimings>();
+			auto & Registry = GetRegistry();
+			cCSLock Lock(Registry.m_CS);
+			Registry.m_Threads.push_back(Timings);
+		}
+		return *Timings;
+	}
+
+
+
+
+
+	double ToMilliseconds(cTimings::clock::duration a_Duration)
+	{
+		return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(a_Duration).count();
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cTimings:
+
+std::atomic<bool> cTimings::s_IsEnabled { false };
+
+
+
+
+
+void cTimings::SetEnabled(bool a_IsEnabled)
+{
+	if (a_IsEnabled)
+	{
+		Reset();
+	}
+	s_IsEnabled.store(a_IsEnabled, std::memory_order_relaxed);
+}
+
+
+
+
+
+void cTimings::Reset(void)
+{
+	auto & Registry = GetRegistry();
+	cCSLock Lock(Registry.m_CS);
+	for (const auto & Thread : Registry.m_Threads)
+	{
+		cCSLock ThreadLock(Thread->m_CS);
+		for (auto & Entries : Thread->m_Entries)
+		{
+			Entries.clear();
+		}
+	}
+	Registry.m_LastReset = clock::now();
+}
+
+
+
+
+
+void cTimings::Add(eCategory a_Category, const AString & a_Name, clock::duration a_Duration)
+{
+	auto & Thread = GetThreadTimings();
+	cCSLock Lock(Thread.m_CS);
+	Thread.m_Entries[static_cast<size_t>(a_Category)][a_Name].Add(a_Duration);
+}
+
+
+
+
+
+AStringVector cTimings::GetReport(size_t a_NumEntries)
+{
+	// Merge the per-thread accumulators:
+	std::array<cEntries, NumCategories> Merged;
+	clock::duration Period;
+	{
+		auto & Registry = GetRegistry();
+		cCSLock Lock(Registry.m_CS);
+		for (const auto & Thread : Registry.m_Threads)
+		{
+			cCSLock ThreadLock(Thread->m_CS);
+			for (size_t i = 0; i < NumCategories; i++)
+			{
+				for (const auto & Entry : Thread->m_Entries[i])
+				{
+					Merged[i][Entry.first].Merge(Entry.second);
+				}
+			}
+		}
+		Period = clock::now() - Registry.m_LastReset;
+	}
+	auto Seconds = std::max(ToMilliseconds(Period) / 1000, 0.001);
+
+	AStringVector Report;
+	Report.push_back(fmt::format(FMT_STRING("Timings over the last {:.1f} seconds (ms/s is the average cost per second of wall time):"), Seconds));
+	for (size_t i = 0; i < NumCategories; i++)
+	{
+		if (Merged[i].empty())
+		{
+			continue;
+		}
+
+		// Sort the items by their total time, most expensive first:
+		std::vector<std::pair<const AString *, const sEntry *>> Sorted;
+		Sorted.reserve(Merged[i].size());
+		for (const auto & Entry : Merged[i])
+		{
+			Sorted.emplace_back(&Entry.first, &Entry.second);
+		}
+		auto NumShown = std::min(a_NumEntries, Sorted.size());
+		std::partial_sort(Sorted.begin(), Sorted.begin() + static_cast<std::ptrdiff_t>(NumShown), Sorted.end(),
+			[](const auto & a_Lhs, const auto & a_Rhs)
+			{
+				return (a_Lhs.second->m_Total > a_Rhs.second->m_Total);
+			}
+		);
+
+		Report.push_back(fmt::format(FMT_STRING("{} ({} items):"), CategoryToString(static_cast<eCategory>(i)), Sorted.size()));
+		for (size_t j = 0; j < NumShown; j++)
+		{
+			const auto & Entry = *Sorted[j].second;
+			Report.push_back(fmt::format(
+				FMT_STRING("  {:>8.3f} ms/s  {:>10} calls  {:>9.1f} us avg  {:>9.1f} us max  {}"),
+				ToMilliseconds(Entry.m_Total) / Seconds,
+				Entry.m_Count,
+				ToMilliseconds(Entry.m_Total) * 1000 / static_cast<double>(Entry.m_Count),
+				ToMilliseconds(Entry.m_Max) * 1000,
+				*Sorted[j].first
+			));
+		}
+	}
+	return Report;
+}
+
+
+
+
+
+const char * cTimings::CategoryToString(eCategory a_Category)
+{
+	switch (a_Category)
+	{
+		case eCategory::Chunk:       return "Chunks";
+		case eCategory::ChunkStep:   return "Chunk tick steps";
+		case eCategory::BlockEntity: return "Block entities";
+		case eCategory::Entity:      return "Entities";
+		case eCategory::PluginHook:  return "Plugin hooks";
+	}
+	UNREACHABLE("Unsupported timings category");
+}
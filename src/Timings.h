@@ -0,0 +1,107 @@
+// Timings.h
+
+// Declares the cTimings class that accumulates the time spent per chunk, entity class, block entity type and plugin hook
+
+/*
+Unlike cProfiler, which records a timeline of the tick phases, cTimings aggregates the time spent by individual game
+objects, so that the most expensive ones can be listed (the "timings" console command). It answers the question
+"what is eating my tick" on a large world, where a lag machine hides among thousands of chunks.
+The accounting is disabled by default, because it constructs a name for every measured object; the name is only
+constructed while the timings are enabled, so a disabled cTimingScope costs a single relaxed load.
+
+Usage:
+	cTimingScope Timing(cTimings::eCategory::Entity, [&] { return AString(Entity.GetClass()); });
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cTimings
+{
+public:
+
+	using clock = std::chrono::steady_clock;
+
+	enum class eCategory
+	{
+		Chunk,
+		ChunkStep,
+		BlockEntity,
+		Entity,
+		PluginHook,
+	};
+
+	/** Number of the eCategory values. */
+	static constexpr size_t NumCategories = static_cast<size_t>(eCategory::PluginHook) + 1;
+
+	/** Returns true if the timings are being accumulated. */
+	static bool IsEnabled(void) { return s_IsEnabled.load(std::memory_order_relaxed); }
+
+	/** Enables or disables the accumulation. Enabling also resets the accumulated values. */
+	static void SetEnabled(bool a_IsEnabled);
+
+	/** Discards all the accumulated values. */
+	static void Reset(void);
+
+	/** Adds a single measurement to the calling thread's accumulator. */
+	static void Add(eCategory a_Category, const AString & a_Name, clock::duration a_Duration);
+
+	/** Returns the report of the a_NumEntries most expensive items in each category, one line per item. */
+	static AStringVector GetReport(size_t a_NumEntries);
+
+	/** Returns the human-readable name of the category. */
+	static const char * CategoryToString(eCategory a_Category);
+
+private:
+
+	static std::atomic<bool> s_IsEnabled;
+};
+
+
+
+
+
+/** Measures the time between its construction and destruction and adds it into cTimings, when the timings are enabled.
+a_NameFn is a callable returning the name of the measured item as an AString; it is only invoked when enabled. */
+template <typename NameFn>
+class cTimingScope
+{
+public:
+
+	cTimingScope(cTimings::eCategory a_Category, NameFn a_NameFn):
+		m_Category(a_Category),
+		m_NameFn(std::move(a_NameFn)),
+		m_IsEnabled(cTimings::IsEnabled())
+	{
+		if (m_IsEnabled)
+		{
+			m_Start = cTimings::clock::now();
+		}
+	}
+
+	~cTimingScope()
+	{
+		if (m_IsEnabled)
+		{
+			auto Duration = cTimings::clock::now() - m_Start;
+			cTimings::Add(m_Category, m_NameFn(), Duration);
+		}
+	}
+
+	cTimingScope(const cTimingScope &) = delete;
+	cTimingScope & operator = (const cTimingScope &) = delete;
+
+private:
+
+	cTimings::eCategory m_Category;
+	NameFn m_NameFn;
+	bool m_IsEnabled;
+	cTimings::clock::time_point m_Start;
+};
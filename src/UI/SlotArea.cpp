@@ -568,6 +568,8 @@ void cSlotAreaCrafting::OnPlayerRemoved(cPlayer & a_Player)
 	// Toss all items on the crafting grid:
 	TossItems(a_Player, 1, m_NumSlots);
 
+	m_RecipeCaches.erase(a_Player.GetUniqueID());
+
 	// Remove the current recipe from the player -> recipe map:
 	for (cRecipeMap::iterator itr = m_Recipes.begin(), end = m_Recipes.end(); itr != end; ++itr)
 	{
@@ -729,7 +731,7 @@ void cSlotAreaCrafting::UpdateRecipe(cPlayer & a_Player)
 {
 	cCraftingGrid   Grid(GetPlayerSlots(a_Player) + 1, m_GridSize, m_GridSize);
 	cCraftingRecipe & Recipe = GetRecipeForPlayer(a_Player);
-	cRoot::Get()->GetCraftingRecipes()->GetRecipe(a_Player, Grid, Recipe);
+	cRoot::Get()->GetCraftingRecipes()->GetRecipe(a_Player, Grid, Recipe, &m_RecipeCaches[a_Player.GetUniqueID()]);
 	SetSlot(0, a_Player, Recipe.GetResult());
 }
 
@@ -750,7 +752,7 @@ cCraftingRecipe & cSlotAreaCrafting::GetRecipeForPlayer(cPlayer & a_Player)
 	// Not found. Add a new one:
 	cCraftingGrid   Grid(GetPlayerSlots(a_Player) + 1, m_GridSize, m_GridSize);
 	cCraftingRecipe Recipe(Grid);
-	cRoot::Get()->GetCraftingRecipes()->GetRecipe(a_Player, Grid, Recipe);
+	cRoot::Get()->GetCraftingRecipes()->GetRecipe(a_Player, Grid, Recipe, &m_RecipeCaches[a_Player.GetUniqueID()]);
 	m_Recipes.emplace_back(a_Player.GetUniqueID(), Recipe);
 	return m_Recipes.back().second;
 }
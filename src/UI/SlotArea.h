@@ -9,6 +9,7 @@
 #pragma once
 
 #include "../Inventory.h"
+#include "../CraftingRecipes.h"
 
 
 
@@ -23,7 +24,6 @@ class cChestEntity;
 class cEnderChestEntity;
 class cFurnaceEntity;
 class cMinecartWithChest;
-class cCraftingRecipe;
 class cWorld;
 
 
@@ -287,6 +287,9 @@ protected:
 	int        m_GridSize;
 	cRecipeMap m_Recipes;
 
+	/** Maps player's EntityID -> the recipe last found for their grid, so that an unchanged grid isn't searched again. */
+	std::map<UInt32, cCraftingRecipes::cRecipeCache> m_RecipeCaches;
+
 	/** Handles a click in the result slot.
 	Crafts using the current recipe, if possible. */
 	void ClickedResult(cPlayer & a_Player);
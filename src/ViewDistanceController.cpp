@@ -0,0 +1,148 @@
+// ViewDistanceController.cpp
+
+// Implements the cViewDistanceController class that adapts the view distance of a world's players to the server load
+
+#include "Globals.h"
+#include "ViewDistanceController.h"
+#include "ClientHandle.h"
+#include "IniFile.h"
+
+
+
+
+
+/** Number of ticks between two evaluations of the world-wide budget. */
+static const int EVALUATION_PERIOD_TICKS = 20;
+
+/** Number of consecutive relaxed evaluations needed before the budget is raised by one chunk.
+Shrinking happens on every overloaded evaluation, so that the server reacts quickly to a load spike. */
+static const int RELAXED_EVALUATIONS_TO_GROW = 10;
+
+/** Weight of the latest tick duration in the moving average. */
+static const double TICK_DURATION_SMOOTHING = 0.1;
+
+
+
+
+
+cViewDistanceController::cViewDistanceController(void):
+	m_IsEnabled(false),
+	m_MinViewDistance(cClientHandle::DEFAULT_VIEW_DISTANCE),
+	m_TargetTickDuration(40),
+	m_MaxLoadedChunks(0),
+	m_MaxChunkSenderQueueLength(0),
+	m_MaxClientEgressBytesPerSecond(0),
+	m_ViewDistance(cClientHandle::MAX_VIEW_DISTANCE),
+	m_AverageTickDuration(0),
+	m_TicksSinceEvaluation(0),
+	m_NumRelaxedEvaluations(0)
+{
+}
+
+
+
+
+
+void cViewDistanceController::LoadSettings(cIniFile & a_IniFile)
+{
+	m_IsEnabled = a_IniFile.GetValueSetB("AdaptiveViewDistance", "Enabled", false);
+	m_MinViewDistance = Clamp(
+		a_IniFile.GetValueSetI("AdaptiveViewDistance", "MinViewDistance", cClientHandle::DEFAULT_VIEW_DISTANCE),
+		cClientHandle::MIN_VIEW_DISTANCE, cClientHandle::MAX_VIEW_DISTANCE
+	);
+	m_TargetTickDuration = std::chrono::milliseconds(std::max(a_IniFile.GetValueSetI("AdaptiveViewDistance", "TargetTickMs", 40), 1));
+	m_MaxLoadedChunks = static_cast<size_t>(std::max(a_IniFile.GetValueSetI("AdaptiveViewDistance", "MaxLoadedChunks", 0), 0));
+	m_MaxChunkSenderQueueLength = static_cast<size_t>(std::max(a_IniFile.GetValueSetI("AdaptiveViewDistance", "MaxChunkSenderQueue", 1000), 0));
+	m_MaxClientEgressBytesPerSecond = static_cast<size_t>(std::max(a_IniFile.GetValueSetI("AdaptiveViewDistance", "MaxClientEgressKiBps", 0), 0)) * 1024;
+}
+
+
+
+
+
+void cViewDistanceController::Tick(int a_MaxViewDistance, std::chrono::milliseconds a_LastTickDuration, size_t a_NumChunks, size_t a_ChunkSenderQueueLength)
+{
+	if (!m_IsEnabled)
+	{
+		return;
+	}
+
+	m_AverageTickDuration += (static_cast<double>(a_LastTickDuration.count()) - m_AverageTickDuration) * TICK_DURATION_SMOOTHING;
+	if (++m_TicksSinceEvaluation < EVALUATION_PERIOD_TICKS)
+	{
+		return;
+	}
+	m_TicksSinceEvaluation = 0;
+
+	const auto Target = static_cast<double>(m_TargetTickDuration.count());
+	const bool IsOverloaded = (
+		(m_AverageTickDuration > Target) ||
+		((m_MaxLoadedChunks > 0) && (a_NumChunks > m_MaxLoadedChunks)) ||
+		((m_MaxChunkSenderQueueLength > 0) && (a_ChunkSenderQueueLength > m_MaxChunkSenderQueueLength))
+	);
+
+	// Only consider growing well below the limits, so that the distance doesn't oscillate around them:
+	const bool IsRelaxed = (
+		(m_AverageTickDuration < Target * 0.6) &&
+		((m_MaxLoadedChunks == 0) || (a_NumChunks < m_MaxLoadedChunks * 9 / 10)) &&
+		((m_MaxChunkSenderQueueLength == 0) || (a_ChunkSenderQueueLength < m_MaxChunkSenderQueueLength / 4))
+	);
+
+	if (IsOverloaded)
+	{
+		m_ViewDistance -= 1;
+		m_NumRelaxedEvaluations = 0;
+	}
+	else if (IsRelaxed)
+	{
+		if (++m_NumRelaxedEvaluations >= RELAXED_EVALUATIONS_TO_GROW)
+		{
+			m_ViewDistance += 1;
+			m_NumRelaxedEvaluations = 0;
+		}
+	}
+	else
+	{
+		m_NumRelaxedEvaluations = 0;
+	}
+
+	m_ViewDistance = Clamp(m_ViewDistance, std::min(m_MinViewDistance, a_MaxViewDistance), a_MaxViewDistance);
+}
+
+
+
+
+
+int cViewDistanceController::GetWorldViewDistance(int a_MaxViewDistance) const
+{
+	if (!m_IsEnabled)
+	{
+		return a_MaxViewDistance;
+	}
+	return std::min(m_ViewDistance, a_MaxViewDistance);
+}
+
+
+
+
+
+int cViewDistanceController::GetClientLimit(int a_CurrentLimit, size_t a_EgressBytesPerSecond, size_t a_ChunkBacklog) const
+{
+	if (!m_IsEnabled || (m_MaxClientEgressBytesPerSecond == 0))
+	{
+		return cClientHandle::MAX_VIEW_DISTANCE;
+	}
+
+	// The client cannot keep up with the chunks it's being sent, shrink:
+	if ((a_EgressBytesPerSecond > m_MaxClientEgressBytesPerSecond) && (a_ChunkBacklog > 0))
+	{
+		return std::max(a_CurrentLimit - 1, m_MinViewDistance);
+	}
+
+	// The client has received everything it asked for and its link is far from the budget, let it grow back:
+	if ((a_ChunkBacklog == 0) && (a_EgressBytesPerSecond < m_MaxClientEgressBytesPerSecond / 2))
+	{
+		return std::min(a_CurrentLimit + 1, cClientHandle::MAX_VIEW_DISTANCE);
+	}
+	return a_CurrentLimit;
+}
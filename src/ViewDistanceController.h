@@ -0,0 +1,86 @@
+// ViewDistanceController.h
+
+// Declares the cViewDistanceController class that adapts the view distance of a world's players to the server load
+
+/*
+The world's MaxViewDistance and the client's requested view distance are static caps. When the server is overloaded
+(such as when many players log in at once), every player would still stream and keep loaded the full radius.
+The controller watches the world's tick duration, loaded chunk count and chunk sender backlog, and lowers or raises
+a world-wide view distance budget within the configured bounds. Additionally, each client's limit is lowered when its
+egress exceeds the configured budget while it still has chunks waiting to be sent.
+The changes are smoothed: a single step at a time, shrinking quickly when overloaded and growing only after
+the load has stayed low for a while, so that the distance doesn't oscillate.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cIniFile;
+
+
+
+
+
+class cViewDistanceController
+{
+public:
+
+	cViewDistanceController(void);
+
+	/** Reads the settings from the [AdaptiveViewDistance] section of the world's ini file, writing the defaults if not present. */
+	void LoadSettings(cIniFile & a_IniFile);
+
+	/** Updates the world-wide budget; called by the world once per tick.
+	a_MaxViewDistance is the world's configured maximum, a_LastTickDuration is the duration of the previous world tick,
+	a_NumChunks is the number of loaded chunks and a_ChunkSenderQueueLength is the number of chunks waiting in the chunk sender. */
+	void Tick(int a_MaxViewDistance, std::chrono::milliseconds a_LastTickDuration, size_t a_NumChunks, size_t a_ChunkSenderQueueLength);
+
+	/** Returns the view distance that the world currently allows, given its configured maximum. */
+	int GetWorldViewDistance(int a_MaxViewDistance) const;
+
+	/** Returns the updated view distance limit of a single client.
+	a_CurrentLimit is the client's current limit, a_EgressBytesPerSecond is its measured outgoing data rate
+	and a_ChunkBacklog is the number of chunks that are waiting to be sent to it. */
+	int GetClientLimit(int a_CurrentLimit, size_t a_EgressBytesPerSecond, size_t a_ChunkBacklog) const;
+
+	/** Returns true if the adaptive view distance is enabled. */
+	bool IsEnabled(void) const { return m_IsEnabled; }
+
+private:
+
+	bool m_IsEnabled;
+
+	/** The view distance never gets lowered below this value. */
+	int m_MinViewDistance;
+
+	/** The tick duration above which the world is considered overloaded. */
+	std::chrono::milliseconds m_TargetTickDuration;
+
+	/** The number of loaded chunks above which the world is considered overloaded; 0 to disable. */
+	size_t m_MaxLoadedChunks;
+
+	/** The chunk sender backlog above which the world is considered overloaded; 0 to disable. */
+	size_t m_MaxChunkSenderQueueLength;
+
+	/** The egress rate above which a client that is still waiting for chunks gets its view distance lowered; 0 to disable. */
+	size_t m_MaxClientEgressBytesPerSecond;
+
+	/** The current world-wide budget, in chunks. Starts at the maximum and is lowered under load. */
+	int m_ViewDistance;
+
+	/** Exponential moving average of the tick duration, in milliseconds. */
+	double m_AverageTickDuration;
+
+	/** Number of ticks since the budget was last evaluated. */
+	int m_TicksSinceEvaluation;
+
+	/** Number of consecutive evaluations during which the world was relaxed enough to grow the budget. */
+	int m_NumRelaxedEvaluations;
+};
@@ -7,6 +7,7 @@
 #include "Entities/Player.h"
 #include "Server.h"
 #include "Root.h"
+#include "Metrics.h"
 
 #include "HTTP/HTTPServerConnection.h"
 #include "HTTP/HTTPFormParser.h"
@@ -61,7 +62,8 @@ public:
 cWebAdmin::cWebAdmin(void) :
 	m_TemplateScript("<webadmin_template>"),
 	m_IsInitialized(false),
-	m_IsRunning(false)
+	m_IsRunning(false),
+	m_MetricsRequireLogin(true)
 {
 }
 
@@ -94,6 +96,11 @@ bool cWebAdmin::Init(void)
 	// Note that historically the ports were stored in the "Port" and "PortsIPv6" values
 	m_Ports = ReadUpgradeIniPorts(m_IniFile, "WebAdmin", "Ports", "Port", "PortsIPv6", DEFAULT_WEBADMIN_PORTS);
 
+	// The metrics are only measured when there's someone to read them:
+	m_MetricsPath = m_IniFile.GetValueSet("WebAdmin", "MetricsPath", "");
+	m_MetricsRequireLogin = m_IniFile.GetValueSetB("WebAdmin", "MetricsRequireLogin", true);
+	cMetrics::SetEnabled(!m_MetricsPath.empty());
+
 	if (!m_HTTPServer.Initialize())
 	{
 		return false;
@@ -272,23 +279,33 @@ bool cWebAdmin::HasUsers()
 
 
 
-void cWebAdmin::HandleWebadminRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
+bool cWebAdmin::CheckAuth(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
 {
 	if (!a_Request.HasAuth())
 	{
 		a_Connection.SendNeedAuth("Cuberite WebAdmin");
-		return;
+		return false;
 	}
 
-	// Check auth:
+	cCSLock Lock(m_CS);
+	AString UserPassword = m_IniFile.GetValue("User:" + a_Request.GetAuthUsername(), "Password", "");
+	if ((UserPassword == "") || (a_Request.GetAuthPassword() != UserPassword))
 	{
-		cCSLock Lock(m_CS);
-		AString UserPassword = m_IniFile.GetValue("User:" + a_Request.GetAuthUsername(), "Password", "");
-		if ((UserPassword == "") || (a_Request.GetAuthPassword() != UserPassword))
-		{
-			a_Connection.SendNeedAuth("Cuberite WebAdmin - bad username or password");
-			return;
-		}
+		a_Connection.SendNeedAuth("Cuberite WebAdmin - bad username or password");
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+void cWebAdmin::HandleWebadminRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
+{
+	if (!CheckAuth(a_Connection, a_Request))
+	{
+		return;
 	}
 
 	// Check if the contents should be wrapped in the template:
@@ -384,6 +401,24 @@ void cWebAdmin::HandleRootRequest(cHTTPServerConnection & a_Connection, cHTTPInc
 
 
 
+void cWebAdmin::HandleMetricsRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
+{
+	if (m_MetricsRequireLogin && !CheckAuth(a_Connection, a_Request))
+	{
+		return;
+	}
+
+	cHTTPOutgoingResponse Resp;
+	Resp.SetContentType("application/openmetrics-text; version=1.0.0; charset=utf-8");
+	a_Connection.Send(Resp);
+	a_Connection.Send(cMetrics::Serialize());
+	a_Connection.FinishResponse();
+}
+
+
+
+
+
 void cWebAdmin::HandleFileRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request)
 {
 	AString FileURL = a_Request.GetURL();
@@ -682,6 +717,10 @@ void cWebAdmin::OnRequestFinished(cHTTPServerConnection & a_Connection, cHTTPInc
 		// The root needs no body handler and is fully handled in the OnRequestFinished() call
 		HandleRootRequest(a_Connection, a_Request);
 	}
+	else if (!m_MetricsPath.empty() && (a_Request.GetURLPath() == m_MetricsPath))
+	{
+		HandleMetricsRequest(a_Connection, a_Request);
+	}
 	else
 	{
 		HandleFileRequest(a_Connection, a_Request);
@@ -251,6 +251,13 @@ protected:
 	/** The ports on which the webadmin is running. */
 	AStringVector m_Ports;
 
+	/** The URL path on which the metrics are served (the MetricsPath value in webadmin.ini), empty if not served.
+	Only written in Init(), before the server starts. */
+	AString m_MetricsPath;
+
+	/** If true, the metrics require the same login as the webadmin pages (the MetricsRequireLogin value in webadmin.ini). */
+	bool m_MetricsRequireLogin;
+
 	/** The HTTP server which provides the underlying HTTP parsing, serialization and events */
 	cHTTPServer m_HTTPServer;
 
@@ -263,9 +270,16 @@ protected:
 	/** Checks inside the webadmin.ini file if there are users configured. */
 	bool HasUsers();
 
+	/** Checks the request's credentials against the users in webadmin.ini.
+	Returns true if they match; otherwise sends the auth request as the response and returns false. */
+	bool CheckAuth(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
+
 	/** Handles requests coming to the "/webadmin" or "/~webadmin" URLs */
 	void HandleWebadminRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
 
+	/** Handles requests for the metrics (m_MetricsPath), serves them in the OpenMetrics text format. */
+	void HandleMetricsRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
+
 	/** Handles requests for the root page */
 	void HandleRootRequest(cHTTPServerConnection & a_Connection, cHTTPIncomingRequest & a_Request);
 
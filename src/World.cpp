@@ -2,6 +2,7 @@
 #include "Globals.h"  // NOTE: MSVC stupidness requires this to be the same across all modules
 
 #include "World.h"
+#include "BlockArea.h"
 #include "BlockInfo.h"
 #include "ClientHandle.h"
 #include "Physics/Explodinator.h"
@@ -57,7 +58,10 @@
 
 #include "SpawnPrepare.h"
 #include "FastRandom.h"
+#include "Metrics.h"
 #include "OpaqueWorld.h"
+#include "Profiler.h"
+#include "Timings.h"
 
 
 
@@ -107,6 +111,8 @@ cWorld::cTickThread::cTickThread(cWorld & a_World):
 
 void cWorld::cTickThread::Execute()
 {
+	cProfiler::SetCurrentThreadName(fmt::format(FMT_STRING("World Ticker ({})"), m_World.GetName()));
+
 	auto LastTime = std::chrono::steady_clock::now();
 	auto TickTime = std::chrono::duration_cast<std::chrono::milliseconds>(1_tick);
 
@@ -115,7 +121,10 @@ void cWorld::cTickThread::Execute()
 		auto NowTime = std::chrono::steady_clock::now();
 		auto WaitTime = std::chrono::duration_cast<std::chrono::milliseconds>(NowTime - LastTime);
 		m_World.Tick(WaitTime, TickTime);
-		TickTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - NowTime);
+		const auto TickDuration = std::chrono::steady_clock::now() - NowTime;
+		TickTime = std::chrono::duration_cast<std::chrono::milliseconds>(TickDuration);
+		cProfiler::ReportTickDuration(m_World.GetName(), TickTime);
+		m_World.UpdateMetrics(TickDuration);
 
 		if (TickTime < 1_tick)
 		{
@@ -131,6 +140,64 @@ void cWorld::cTickThread::Execute()
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cWorld::sMetrics:
+
+struct cWorld::sMetrics
+{
+	explicit sMetrics(const AString & a_WorldName):
+		m_TickDuration(cMetrics::GetHistogram("cuberite_world_tick_duration_seconds", "Duration of the world's ticks", cMetrics::TickDurationBounds(), Labels(a_WorldName))),
+		m_TPS(cMetrics::GetGauge("cuberite_world_tps", "Ticks per second over the last second", Labels(a_WorldName))),
+		m_ChunksLoaded(cMetrics::GetGauge("cuberite_world_chunks_loaded", "Number of chunks loaded in memory", Labels(a_WorldName))),
+		m_ChunksValid(cMetrics::GetGauge("cuberite_world_chunks_valid", "Number of loaded chunks that have their data", Labels(a_WorldName))),
+		m_ChunksDirty(cMetrics::GetGauge("cuberite_world_chunks_dirty", "Number of loaded chunks that need saving", Labels(a_WorldName))),
+		m_ChunksSaveOverdue(cMetrics::GetGauge("cuberite_world_chunks_save_overdue", "Number of dirty chunks not saved within the save interval", Labels(a_WorldName))),
+		m_OldestDirtyChunkAge(cMetrics::GetGauge("cuberite_world_oldest_dirty_chunk_age_seconds", "Time since the longest unsaved chunk changed", Labels(a_WorldName))),
+		m_GeneratorQueue(cMetrics::GetGauge("cuberite_world_generator_queue_length", "Number of chunks waiting to be generated", Labels(a_WorldName))),
+		m_LightingQueue(cMetrics::GetGauge("cuberite_world_lighting_queue_length", "Number of chunks waiting to be lit", Labels(a_WorldName))),
+		m_StorageLoadQueue(cMetrics::GetGauge("cuberite_world_storage_load_queue_length", "Number of chunks waiting to be loaded from disk", Labels(a_WorldName))),
+		m_StorageSaveQueue(cMetrics::GetGauge("cuberite_world_storage_save_queue_length", "Number of chunks waiting to be saved to disk", Labels(a_WorldName))),
+		m_ChunkSenderQueue(cMetrics::GetGauge("cuberite_world_chunk_sender_queue_length", "Number of chunks waiting to be sent to clients", Labels(a_WorldName))),
+		m_ChunkMemory(cMetrics::GetGauge("cuberite_world_chunk_memory_bytes", "Memory taken by the block and light data of the chunks", Labels(a_WorldName))),
+		m_SectionPoolReserved(cMetrics::GetGauge("cuberite_section_pool_reserved_bytes", "Memory reserved by the chunk section pools, for all the worlds")),
+		m_SectionPoolUsed(cMetrics::GetGauge("cuberite_section_pool_used_bytes", "Memory of the chunk section pools in use, for all the worlds")),
+		m_LastUpdate(std::chrono::steady_clock::now()),
+		m_NumTicksSinceUpdate(0)
+	{
+	}
+
+	static AString Labels(const AString & a_WorldName)
+	{
+		return cMetrics::FormatLabels({{"world", a_WorldName}});
+	}
+
+	cMetrics::cHistogram & m_TickDuration;
+	cMetrics::cGauge & m_TPS;
+	cMetrics::cGauge & m_ChunksLoaded;
+	cMetrics::cGauge & m_ChunksValid;
+	cMetrics::cGauge & m_ChunksDirty;
+	cMetrics::cGauge & m_ChunksSaveOverdue;
+	cMetrics::cGauge & m_OldestDirtyChunkAge;
+	cMetrics::cGauge & m_GeneratorQueue;
+	cMetrics::cGauge & m_LightingQueue;
+	cMetrics::cGauge & m_StorageLoadQueue;
+	cMetrics::cGauge & m_StorageSaveQueue;
+	cMetrics::cGauge & m_ChunkSenderQueue;
+	cMetrics::cGauge & m_ChunkMemory;
+	cMetrics::cGauge & m_SectionPoolReserved;
+	cMetrics::cGauge & m_SectionPoolUsed;
+
+	/** The time when the gauges were last updated. */
+	std::chrono::steady_clock::time_point m_LastUpdate;
+
+	/** Number of ticks since m_LastUpdate, for the TPS. */
+	int m_NumTicksSinceUpdate;
+};
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cWorld:
 
@@ -162,7 +229,9 @@ cWorld::cWorld(
 	m_WorldDate(0),
 	m_WorldTickAge(0),
 	m_LastChunkCheck(0),
-	m_LastSave(0),
+	m_LastDirtyChunksSave(0),
+	m_LastSaveLagWarning(0),
+	m_LastMemoryCheck(0),
 	m_SkyDarkness(0),
 	m_GameMode(gmSurvival),
 	m_bEnabledPVP(false),
@@ -249,12 +318,18 @@ cWorld::cWorld(
 		UnusedDirtyChunksCap *= -1;
 		IniFile.SetValueI("General", "UnusedChunkCap", UnusedDirtyChunksCap);
 	}
-	m_UnusedDirtyChunksCap = static_cast<size_t>(UnusedDirtyChunksCap);
+	m_ChunkSaveScheduler.Configure(
+		std::chrono::seconds(std::max(IniFile.GetValueSetI("General", "ChunkSaveIntervalSeconds", 300), 1)),
+		IniFile.GetValueSetF("General", "ChunkSaveRate", 20),
+		static_cast<size_t>(UnusedDirtyChunksCap)
+	);
+	m_ChunkMemoryBudget = static_cast<size_t>(std::max(IniFile.GetValueSetI("General", "ChunkMemoryBudgetMiB", 0), 0)) * 1024 * 1024;
 
 	m_BroadcastDeathMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastDeathMessages", true);
 	m_BroadcastAchievementMessages = IniFile.GetValueSetB("Broadcasting", "BroadcastAchievementMessages", true);
 
 	SetMaxViewDistance(IniFile.GetValueSetI("SpawnPosition", "MaxViewDistance", cClientHandle::DEFAULT_VIEW_DISTANCE));
+	m_ViewDistanceController.LoadSettings(IniFile);
 
 	// Try to find the "SpawnPosition" key and coord values in the world configuration, set the flag if found
 	int KeyNum = IniFile.FindKey("SpawnPosition");
@@ -413,7 +488,7 @@ cWorld::cWorld(
 	m_BlockTickQueueCopy.reserve(1000);
 
 	// Simulators:
-	m_SimulatorManager  = std::make_unique<cSimulatorManager>(*this);
+	m_SimulatorManager  = std::make_unique<cSimulatorManager>();
 	m_WaterSimulator    = InitializeFluidSimulator(IniFile, "Water", E_BLOCK_WATER, E_BLOCK_STATIONARY_WATER);
 	m_LavaSimulator     = InitializeFluidSimulator(IniFile, "Lava",  E_BLOCK_LAVA,  E_BLOCK_STATIONARY_LAVA);
 	m_SandSimulator     = std::make_unique<cSandSimulator>(*this, IniFile);
@@ -1046,6 +1121,8 @@ void cWorld::Stop(cDeadlockDetect & a_DeadlockDetect)
 
 void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_LastTickDurationMSec)
 {
+	cProfileScope Profile("cWorld::Tick");
+
 	// Notify the plugins:
 	cPluginManager::Get()->CallHookWorldTick(*this, a_Dt, a_LastTickDurationMSec);
 
@@ -1072,6 +1149,9 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 		BroadcastPlayerListUpdatePing();
 	}
 
+	// Adapt the view distance budget to the load before the clients stream their chunks:
+	m_ViewDistanceController.Tick(m_MaxViewDistance, a_LastTickDurationMSec, m_ChunkMap.GetNumChunks(), m_ChunkSender.GetQueueLength());
+
 	// Process all clients' buffered actions:
 	for (const auto Player : m_Players)
 	{
@@ -1100,18 +1180,23 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 	{
 		// Unload every 10 seconds
 		UnloadUnusedChunks();
-
-		if (m_WorldAge - m_LastSave > std::chrono::minutes(5))
-		{
-			// Save every 5 minutes
-			SaveAllChunks();
-		}
-		else if (GetNumUnusedDirtyChunks() > m_UnusedDirtyChunksCap)
+	}
+	else if ((m_ChunkMemoryBudget != 0) && (m_WorldAge - m_LastMemoryCheck > std::chrono::seconds(1)))
+	{
+		// Over the memory budget, evict the coldest chunks without waiting for the regular unloading:
+		m_LastMemoryCheck = m_WorldAge;
+		if (m_ChunkMap.GetMemoryAccount()->GetBytes() > m_ChunkMemoryBudget)
 		{
-			// Save if we have too many dirty unused chunks
-			SaveAllChunks();
+			m_ChunkMap.UnloadColdChunks(m_ChunkMemoryBudget);
+			cSlabPool::TrimAll();
 		}
 	}
+
+	if (m_WorldAge - m_LastDirtyChunksSave >= std::chrono::seconds(1))
+	{
+		// Save the dirty chunks a few at a time, rather than all of them at once:
+		SaveDirtyChunks();
+	}
 }
 
 
@@ -1120,6 +1205,8 @@ void cWorld::Tick(std::chrono::milliseconds a_Dt, std::chrono::milliseconds a_La
 
 void cWorld::TickClients(const std::chrono::milliseconds a_Dt)
 {
+	cProfileScope Profile("cWorld::TickClients");
+
 	for (const auto Player : m_Players)
 	{
 		Player->GetClientHandle()->Tick(a_Dt);
@@ -1132,6 +1219,8 @@ void cWorld::TickClients(const std::chrono::milliseconds a_Dt)
 
 void cWorld::TickWeather(float a_Dt)
 {
+	cProfileScope Profile("cWorld::TickWeather");
+
 	UNUSED(a_Dt);
 	// There are no weather changes anywhere but in the Overworld:
 	if (GetDimension() != dimOverworld)
@@ -1166,6 +1255,8 @@ void cWorld::TickWeather(float a_Dt)
 
 void cWorld::TickMobs(std::chrono::milliseconds a_Dt)
 {
+	cProfileScope Profile("cWorld::TickMobs");
+
 	// _X 2013_10_22: This is a quick fix for #283 - the world needs to be locked while ticking mobs
 	cWorld::cLock Lock(*this);
 
@@ -1223,6 +1314,7 @@ void cWorld::TickMobs(std::chrono::milliseconds a_Dt)
 			// Tick close mobs
 			if (Monster.GetParentChunk()->HasAnyClients())
 			{
+				cTimingScope Timing(cTimings::eCategory::Entity, [&Monster] { return AString(Monster.GetClass()); });
 				Monster.Tick(a_Dt, *(a_Entity.GetParentChunk()));
 			}
 			// Destroy far hostile mobs except if last target was a player
@@ -1252,6 +1344,8 @@ void cWorld::TickMobs(std::chrono::milliseconds a_Dt)
 
 void cWorld::TickQueuedChunkDataSets()
 {
+	cProfileScope Profile("cWorld::TickQueuedChunkDataSets");
+
 	decltype(m_SetChunkDataQueue) SetChunkDataQueue;
 	{
 		cCSLock Lock(m_CSSetChunkDataQueue);
@@ -1294,6 +1388,8 @@ void cWorld::TickQueuedChunkDataSets()
 
 void cWorld::TickQueuedEntityAdditions(void)
 {
+	cProfileScope Profile("cWorld::TickQueuedEntityAdditions");
+
 	decltype(m_EntitiesToAdd) EntitiesToAdd;
 	{
 		cCSLock Lock(m_CSEntitiesToAdd);
@@ -1333,6 +1429,8 @@ void cWorld::TickQueuedEntityAdditions(void)
 
 void cWorld::TickQueuedTasks(void)
 {
+	cProfileScope Profile("cWorld::TickQueuedTasks");
+
 	// Move the tasks to be executed to a seperate vector to avoid deadlocks on accessing m_Tasks
 	decltype(m_Tasks) Tasks;
 	{
@@ -1368,6 +1466,52 @@ void cWorld::TickQueuedTasks(void)
 
 
 
+void cWorld::UpdateMetrics(std::chrono::steady_clock::duration a_TickDuration)
+{
+	if (!cMetrics::IsEnabled())
+	{
+		return;
+	}
+	if (m_Metrics == nullptr)
+	{
+		m_Metrics = std::make_unique<sMetrics>(m_WorldName);
+	}
+
+	m_Metrics->m_TickDuration.Observe(std::chrono::duration<double>(a_TickDuration).count());
+	m_Metrics->m_NumTicksSinceUpdate += 1;
+
+	// The gauges are only updated once per second, they need locking the chunkmap and the queues:
+	const auto Now = std::chrono::steady_clock::now();
+	const auto SinceUpdate = std::chrono::duration<double>(Now - m_Metrics->m_LastUpdate).count();
+	if (SinceUpdate < 1)
+	{
+		return;
+	}
+	m_Metrics->m_TPS.Set(m_Metrics->m_NumTicksSinceUpdate / SinceUpdate);
+	m_Metrics->m_LastUpdate = Now;
+	m_Metrics->m_NumTicksSinceUpdate = 0;
+
+	int NumValid, NumDirty, NumInLightingQueue;
+	GetChunkStats(NumValid, NumDirty, NumInLightingQueue);
+	m_Metrics->m_ChunksLoaded.Set(static_cast<double>(GetNumChunks()));
+	m_Metrics->m_ChunksValid.Set(NumValid);
+	m_Metrics->m_ChunksDirty.Set(NumDirty);
+	m_Metrics->m_ChunksSaveOverdue.Set(static_cast<double>(m_ChunkSaveScheduler.GetNumOverdue()));
+	m_Metrics->m_OldestDirtyChunkAge.Set(std::chrono::duration<double>(m_ChunkSaveScheduler.GetOldestDirtyAge()).count());
+	m_Metrics->m_GeneratorQueue.Set(static_cast<double>(GetGeneratorQueueLength()));
+	m_Metrics->m_LightingQueue.Set(static_cast<double>(GetLightingQueueLength()));
+	m_Metrics->m_StorageLoadQueue.Set(static_cast<double>(GetStorageLoadQueueLength()));
+	m_Metrics->m_StorageSaveQueue.Set(static_cast<double>(GetStorageSaveQueueLength()));
+	m_Metrics->m_ChunkSenderQueue.Set(static_cast<double>(m_ChunkSender.GetQueueLength()));
+	m_Metrics->m_ChunkMemory.Set(static_cast<double>(m_ChunkMap.GetMemoryAccount()->GetBytes()));
+	m_Metrics->m_SectionPoolReserved.Set(static_cast<double>(cSlabPool::GetTotalReservedBytes()));
+	m_Metrics->m_SectionPoolUsed.Set(static_cast<double>(cSlabPool::GetTotalUsedBytes()));
+}
+
+
+
+
+
 void cWorld::UpdateSkyDarkness(void)
 {
 	const auto TIME_SUNSET = 12000_tick;
@@ -1410,7 +1554,26 @@ void cWorld::WakeUpSimulators(Vector3i a_Block)
 
 void cWorld::WakeUpSimulatorsInArea(const cCuboid & a_Area)
 {
-	m_SimulatorManager->WakeUp(a_Area);
+	cCuboid Area(a_Area);
+	Area.Sort();
+	Area.Expand(1, 1, 1, 1, 1, 1);  // Expand the area to contain the neighbors, too.
+	Area.ClampY(0, cChunkDef::Height - 1);
+
+	const auto ChunkStart = cChunkDef::BlockToChunk(Area.p1);
+	const auto ChunkEnd = cChunkDef::BlockToChunk(Area.p2);
+
+	// Add all blocks, in a per-chunk manner:
+	for (int ChunkZ = ChunkStart.m_ChunkZ; ChunkZ <= ChunkEnd.m_ChunkZ; ++ChunkZ)
+	{
+		for (int ChunkX = ChunkStart.m_ChunkX; ChunkX <= ChunkEnd.m_ChunkX; ++ChunkX)
+		{
+			DoWithChunk(ChunkX, ChunkZ, [this, &Area](cChunk & a_Chunk)
+			{
+				m_SimulatorManager->WakeUp(a_Chunk, Area);
+				return true;
+			});
+		}
+	}
 }
 
 
@@ -1844,6 +2007,87 @@ bool cWorld::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlock
 
 
 
+struct cWorld::sBlockAreaWrite
+{
+	cBlockArea m_Area;
+	Vector3i m_MinCoords;
+	int m_DataTypes;
+	size_t m_ChunksPerTick;
+
+	/** The chunks that are yet to be written. */
+	std::vector<cChunkCoords> m_Chunks;
+
+	/** False if any of the chunks written so far wasn't valid. */
+	bool m_IsSuccess;
+
+	std::function<void(bool)> m_OnCompleted;
+};
+
+
+
+
+
+void cWorld::QueueWriteBlockArea(const cBlockArea & a_Area, const Vector3i a_MinCoords, const int a_DataTypes, const size_t a_ChunksPerTick, std::function<void(bool)> a_OnCompleted)
+{
+	auto Write = std::make_shared<sBlockAreaWrite>();
+	Write->m_Area.CopyFrom(a_Area);
+	Write->m_MinCoords = a_MinCoords;
+	Write->m_DataTypes = a_DataTypes;
+	Write->m_ChunksPerTick = std::max<size_t>(a_ChunksPerTick, 1);
+	Write->m_IsSuccess = true;
+	Write->m_OnCompleted = std::move(a_OnCompleted);
+
+	// Collect the affected chunks, in reverse order so that they get written in the usual XZ order when popped from the back:
+	const auto MinChunk = cChunkDef::BlockToChunk(a_MinCoords);
+	const auto MaxChunk = cChunkDef::BlockToChunk(a_MinCoords + a_Area.GetSize() - Vector3i(1, 1, 1));
+	for (int z = MaxChunk.m_ChunkZ; z >= MinChunk.m_ChunkZ; z--)
+	{
+		for (int x = MaxChunk.m_ChunkX; x >= MinChunk.m_ChunkX; x--)
+		{
+			Write->m_Chunks.emplace_back(x, z);
+		}
+	}
+
+	QueueTask([Write](cWorld & a_World)
+	{
+		a_World.WriteBlockAreaBatch(Write);
+	});
+}
+
+
+
+
+
+void cWorld::WriteBlockAreaBatch(const std::shared_ptr<sBlockAreaWrite> & a_Write)
+{
+	for (size_t i = 0; (i < a_Write->m_ChunksPerTick) && !a_Write->m_Chunks.empty(); i++)
+	{
+		if (!m_ChunkMap.WriteBlockAreaChunk(a_Write->m_Area, a_Write->m_MinCoords, a_Write->m_DataTypes, a_Write->m_Chunks.back()))
+		{
+			a_Write->m_IsSuccess = false;
+		}
+		a_Write->m_Chunks.pop_back();
+	}
+
+	if (!a_Write->m_Chunks.empty())
+	{
+		ScheduleTask(cTickTime(1), [a_Write](cWorld & a_World)
+		{
+			a_World.WriteBlockAreaBatch(a_Write);
+		});
+		return;
+	}
+
+	if (a_Write->m_OnCompleted != nullptr)
+	{
+		a_Write->m_OnCompleted(a_Write->m_IsSuccess);
+	}
+}
+
+
+
+
+
 void cWorld::SpawnItemPickups(const cItems & a_Pickups, Vector3i a_BlockPos, double a_FlyAwaySpeed, bool a_IsPlayerCreated)
 {
 	auto & random = GetRandomProvider();
@@ -2273,10 +2517,39 @@ bool cWorld::HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) const
 
 
 
+void cWorld::SaveDirtyChunks(void)
+{
+	m_LastDirtyChunksSave = m_WorldAge;
+	if (!IsSavingEnabled())
+	{
+		return;
+	}
+
+	m_ChunkMap.SaveDirtyChunks(m_ChunkSaveScheduler, std::chrono::duration_cast<cTickTimeLong>(std::chrono::seconds(1)));
+
+	const auto NumOverdue = m_ChunkSaveScheduler.GetNumOverdue();
+	if ((NumOverdue != 0) && (m_WorldAge - m_LastSaveLagWarning >= std::chrono::minutes(1)))
+	{
+		m_LastSaveLagWarning = m_WorldAge;
+		LOGWARNING("World \"%s\": Saving is falling behind, %zu chunks have been unsaved for over %lld seconds, the oldest for %lld seconds. The storage cannot keep up with the changes.",
+			m_WorldName, NumOverdue,
+			static_cast<long long>(std::chrono::duration_cast<std::chrono::seconds>(m_ChunkSaveScheduler.GetInterval()).count()),
+			static_cast<long long>(std::chrono::duration_cast<std::chrono::seconds>(m_ChunkSaveScheduler.GetOldestDirtyAge()).count())
+		);
+	}
+}
+
+
+
+
+
 void cWorld::UnloadUnusedChunks(void)
 {
 	m_LastChunkCheck = m_WorldAge;
 	m_ChunkMap.UnloadUnusedChunks();
+
+	// Give the memory of the unloaded chunks back to the system:
+	cSlabPool::TrimAll();
 }
 
 
@@ -2759,7 +3032,6 @@ void cWorld::SaveAllChunks(void)
 {
 	if (IsSavingEnabled())
 	{
-		m_LastSave = m_WorldAge;
 		m_ChunkMap.SaveAllChunks();
 	}
 }
@@ -2883,6 +3155,8 @@ void cWorld::GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLigh
 
 void cWorld::TickQueuedBlocks(void)
 {
+	cProfileScope Profile("cWorld::TickQueuedBlocks");
+
 	if (m_BlockTickQueue.empty())
 	{
 		return;
@@ -3100,19 +3374,20 @@ cRedstoneSimulator * cWorld::InitializeRedstoneSimulator(cIniFile & a_IniFile)
 	}
 
 	cRedstoneSimulator * res = nullptr;
+	const bool CompileCircuits = a_IniFile.GetValueSetB("Physics", "RedstoneCompileCircuits", false);
 
 	if (NoCaseCompare(SimulatorName, "Incremental") == 0)
 	{
-		res = new cIncrementalRedstoneSimulator(*this);
+		res = new cIncrementalRedstoneSimulator(CompileCircuits);
 	}
 	else if (NoCaseCompare(SimulatorName, "noop") == 0)
 	{
-		res = new cRedstoneNoopSimulator(*this);
+		res = new cRedstoneNoopSimulator();
 	}
 	else
 	{
 		LOGWARNING("[Physics] Unknown RedstoneSimulator \"%s\" in %s, using the default of \"Incremental\".", SimulatorName.c_str(), GetIniFileName().c_str());
-		res = new cIncrementalRedstoneSimulator(*this);
+		res = new cIncrementalRedstoneSimulator(CompileCircuits);
 	}
 
 	m_SimulatorManager->RegisterSimulator(res, 2 /* Two game ticks is a redstone tick */);
@@ -3210,6 +3485,7 @@ void cWorld::cChunkGeneratorCallbacks::OnChunkGenerated(cChunkDesc & a_ChunkDesc
 	a_ChunkDesc.CompressBlockMetas(BlockMetas);
 
 	struct SetChunkData Data({ a_ChunkDesc.GetChunkX(), a_ChunkDesc.GetChunkZ() });
+	Data.SetMemoryAccount(m_World->GetChunkMap()->GetMemoryAccount());
 	{
 		Data.BlockData.SetAll(a_ChunkDesc.GetBlockTypes(), BlockMetas);
 
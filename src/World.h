@@ -6,10 +6,12 @@
 #include "Simulator/SimulatorManager.h"
 #include "ChunkMap.h"
 #include "WorldStorage/WorldStorage.h"
+#include "WorldStorage/ChunkSaveScheduler.h"
 #include "ChunkGeneratorThread.h"
 #include "ChunkSender.h"
 #include "Defines.h"
 #include "LightingThread.h"
+#include "ViewDistanceController.h"
 #include "IniFile.h"
 #include "Item.h"
 #include "Mobs/Monster.h"
@@ -404,6 +406,13 @@ public:
 	Doesn't wake up simulators, use WakeUpSimulatorsInArea() for that. */
 	virtual bool WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes) override;
 
+	/** Writes the block area into the specified coords gradually, at most a_ChunksPerTick chunks in each tick.
+	Meant for large areas that would stall the tick thread if written all at once.
+	The area is copied, the caller may modify or destroy a_Area as soon as this function returns.
+	a_OnCompleted is called from the tick thread once all the chunks are written, with true if all of them were valid.
+	Exported in ManualBindings_BlockArea.cpp as cBlockArea:WriteAsync(). */
+	void QueueWriteBlockArea(const cBlockArea & a_Area, Vector3i a_MinCoords, int a_DataTypes, size_t a_ChunksPerTick, std::function<void(bool)> a_OnCompleted);
+
 	// tolua_begin
 
 	/** Spawns item pickups for each item in the list.
@@ -592,7 +601,7 @@ public:
 	/** Wakes up the simulators for the specified block */
 	virtual void WakeUpSimulators(Vector3i a_Block) override;
 
-	/** Wakes up the simulators for the specified area of blocks */
+	/** Wakes up the simulators for the specified area of blocks and the blocks neighboring it, including the edge and corner neighbors */
 	void WakeUpSimulatorsInArea(const cCuboid & a_Area);
 
 	// tolua_end
@@ -765,6 +774,15 @@ public:
 	/** Returns the number of chunks loaded and dirty, and in the lighting queue */
 	void GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue);
 
+	/** Returns the controller that lowers the players' view distance when the world is overloaded. */
+	const cViewDistanceController & GetViewDistanceController(void) const { return m_ViewDistanceController; }
+
+	/** Returns the number of pickups and experience orbs that have been merged into others since the world started. */
+	UInt64 GetNumMergedItemEntities(void) const { return m_NumMergedItemEntities.load(std::memory_order_relaxed); }
+
+	/** Adds to the count of merged pickups and experience orbs; called by the chunks when they merge item entities. */
+	void AddMergedItemEntities(int a_NumMerged) { m_NumMergedItemEntities.fetch_add(static_cast<UInt64>(a_NumMerged), std::memory_order_relaxed); }
+
 	// Various queues length queries (cannot be const, they lock their CS):
 	inline size_t GetGeneratorQueueLength  (void) { return m_Generator.GetQueueLength();   }    // tolua_export
 	inline size_t GetLightingQueueLength   (void) { return m_Lighting.GetQueueLength();    }    // tolua_export
@@ -899,6 +917,9 @@ public:
 	bool IsSlimeChunk(int a_ChunkX, int a_ChunkZ) const;  // tolua_export
 private:
 
+	/** The state of a block area being written across multiple ticks, see QueueWriteBlockArea(). */
+	struct sBlockAreaWrite;
+
 	class cTickThread:
 		public cIsThread
 	{
@@ -939,10 +960,13 @@ private:
 	} ;
 
 
-	/** The maximum number of allowed unused dirty chunks for this world.
-	Loaded from config, enforced every 10 seconds by freeing some unused dirty chunks
-	if this was exceeded. */
-	size_t m_UnusedDirtyChunksCap;
+	/** Picks the dirty chunks to save each second, so that each is saved within the configured interval after it changed,
+	the unused ones first, and at most the configured number of unused dirty chunks is kept. Configured from the world.ini. */
+	cChunkSaveScheduler m_ChunkSaveScheduler;
+
+	/** The number of bytes the chunk data of this world may take before the coldest unused chunks are unloaded
+	without waiting for the regular unloading; 0 for no limit. Loaded from config. */
+	size_t m_ChunkMemoryBudget;
 
 	AString m_WorldName;
 
@@ -963,6 +987,9 @@ private:
 	/** Whether or not writing chunks to disk is currently enabled */
 	std::atomic<bool> m_IsSavingEnabled;
 
+	/** Number of pickups and experience orbs merged into others, reported by the "chunkstats" console command. */
+	std::atomic<UInt64> m_NumMergedItemEntities { 0 };
+
 	/** The dimension of the world, used by the client to provide correct lighting scheme */
 	eDimension m_Dimension;
 
@@ -998,7 +1025,9 @@ private:
 	cTickTimeLong m_WorldTickAge;
 
 	std::chrono::milliseconds m_LastChunkCheck;  // The last WorldAge in which unloading and possibly saving was triggered.
-	std::chrono::milliseconds m_LastSave;  // The last WorldAge in which save-all was triggerred.
+	std::chrono::milliseconds m_LastDirtyChunksSave;  // The last WorldAge in which the dirty chunks were scheduled for saving.
+	std::chrono::milliseconds m_LastSaveLagWarning;  // The last WorldAge in which the chunks overdue for saving were logged.
+	std::chrono::milliseconds m_LastMemoryCheck;  // The last WorldAge in which the chunk data was checked against m_ChunkMemoryBudget.
 	std::map<cMonster::eFamily, cTickTimeLong> m_LastSpawnMonster;  // The last WorldAge (in ticks) in which a monster was spawned (for each megatype of monster)  // MG TODO : find a way to optimize without creating unmaintenability (if mob IDs are becoming unrowed)
 
 	NIBBLETYPE m_SkyDarkness;
@@ -1071,6 +1100,13 @@ private:
 	/** The maximum view distance that a player can have in this world. */
 	int m_MaxViewDistance;
 
+	/** Adapts the players' view distance to the world's tick duration, loaded chunks and chunk sender backlog. */
+	cViewDistanceController m_ViewDistanceController;
+
+	/** The world's metrics exported via cMetrics, created on first use while the metrics are enabled. See UpdateMetrics(). */
+	struct sMetrics;
+	std::unique_ptr<sMetrics> m_Metrics;
+
 	/** Name of the nether world - where Nether portals should teleport.
 	Only used when this world is an Overworld. */
 	AString m_LinkedNetherWorldName;
@@ -1131,9 +1167,21 @@ private:
 	/** Executes all tasks queued onto the tick thread */
 	void TickQueuedTasks(void);
 
+	/** Records the tick duration into the world's metrics, and once per second updates the TPS, chunk and queue gauges.
+	Called by the tick thread after each tick; does nothing unless the metrics are enabled. */
+	void UpdateMetrics(std::chrono::steady_clock::duration a_TickDuration);
+
+	/** Writes the next batch of chunks of an area queued by QueueWriteBlockArea().
+	Reschedules itself for the next tick until all the chunks are written, then calls the completion callback. */
+	void WriteBlockAreaBatch(const std::shared_ptr<sBlockAreaWrite> & a_Write);
+
 	/** Unloads all chunks immediately. */
 	void UnloadUnusedChunks(void);
 
+	/** Queues the next second's share of the dirty chunks for saving, as picked by m_ChunkSaveScheduler.
+	Warns, at most once a minute, when the chunks aren't saved within the interval. */
+	void SaveDirtyChunks(void);
+
 	void UpdateSkyDarkness(void);
 
 	/** Generates a random spawnpoint on solid land by walking chunks and finding their biomes */
@@ -0,0 +1,110 @@
+
+// ChunkSaveScheduler.cpp
+
+// Implements the cChunkSaveScheduler class that picks the dirty chunks to save, spreading the saving over time
+
+#include "Globals.h"
+#include "ChunkSaveScheduler.h"
+
+
+
+
+
+cChunkSaveScheduler::cChunkSaveScheduler(void):
+	m_Interval(std::chrono::minutes(5)),
+	m_ChunksPerSecond(20),
+	m_SaveCredit(0),
+	m_UnusedChunksCap(1000),
+	m_NumOverdue(0),
+	m_OldestDirtyAge(0)
+{
+}
+
+
+
+
+
+void cChunkSaveScheduler::Configure(const cTickTimeLong a_Interval, const double a_ChunksPerSecond, const size_t a_UnusedChunksCap)
+{
+	m_Interval = std::max(a_Interval, cTickTimeLong(1));
+	m_ChunksPerSecond = std::max(a_ChunksPerSecond, 0.0);
+	m_UnusedChunksCap = a_UnusedChunksCap;
+}
+
+
+
+
+
+size_t cChunkSaveScheduler::Schedule(std::vector<sDirtyChunk> & a_Chunks, const cTickTimeLong a_Now, const cTickTimeLong a_Period)
+{
+	m_NumOverdue = 0;
+	m_OldestDirtyAge = cTickTimeLong(0);
+	if (a_Chunks.empty())
+	{
+		m_SaveCredit = 0;
+		return 0;
+	}
+
+	// All the chunks have the same interval, the oldest dirty ones are the ones with the closest deadline:
+	std::sort(a_Chunks.begin(), a_Chunks.end(), [](const sDirtyChunk & a_Lhs, const sDirtyChunk & a_Rhs)
+		{
+			return (a_Lhs.m_DirtySince < a_Rhs.m_DirtySince);
+		}
+	);
+	m_OldestDirtyAge = a_Now - a_Chunks.front().m_DirtySince;
+
+	// The chunks with the deadline within this period are all saved now. For the others, the k-th closest deadline
+	// is kept if k chunks are saved until then; save at the highest rate any of the deadlines needs, up to the configured rate:
+	double ChunksPerSecond = 0;
+	size_t NumDue = 0;
+	size_t NumUnused = 0;
+	for (size_t i = 0; i < a_Chunks.size(); i++)
+	{
+		const auto Deadline = a_Chunks[i].m_DirtySince + m_Interval;
+		if (Deadline < a_Now)
+		{
+			m_NumOverdue++;
+		}
+		if (Deadline <= a_Now + a_Period)
+		{
+			NumDue = i + 1;
+		}
+		else
+		{
+			ChunksPerSecond = std::max(ChunksPerSecond, static_cast<double>(i + 1) / std::chrono::duration<double>(Deadline - a_Now).count());
+		}
+		if (a_Chunks[i].m_IsUnused)
+		{
+			NumUnused++;
+		}
+	}
+	ChunksPerSecond = std::min(ChunksPerSecond, m_ChunksPerSecond);
+	m_SaveCredit += ChunksPerSecond * std::chrono::duration<double>(a_Period).count();
+	auto NumToSave = std::max(NumDue, static_cast<size_t>(m_SaveCredit));
+
+	// After the due chunks, the unused ones, so that they can be unloaded. Then the rest, still oldest first:
+	std::stable_partition(a_Chunks.begin() + static_cast<std::ptrdiff_t>(NumDue), a_Chunks.end(), [](const sDirtyChunk & a_Chunk)
+		{
+			return a_Chunk.m_IsUnused;
+		}
+	);
+
+	// Too many unused chunks waiting to be unloaded, save enough of them to get below the cap, whatever the rate:
+	if (NumUnused > m_UnusedChunksCap)
+	{
+		const auto NumDueUnused = static_cast<size_t>(std::count_if(a_Chunks.begin(), a_Chunks.begin() + static_cast<std::ptrdiff_t>(NumDue), [](const sDirtyChunk & a_Chunk)
+			{
+				return a_Chunk.m_IsUnused;
+			}
+		));
+		const auto NumExcess = NumUnused - m_UnusedChunksCap;
+		if (NumExcess > NumDueUnused)
+		{
+			NumToSave = std::max(NumToSave, NumDue + NumExcess - NumDueUnused);
+		}
+	}
+
+	NumToSave = std::min(NumToSave, a_Chunks.size());
+	m_SaveCredit = std::max(m_SaveCredit - static_cast<double>(NumToSave), 0.0);
+	return NumToSave;
+}
@@ -0,0 +1,76 @@
+
+// ChunkSaveScheduler.h
+
+// Declares the cChunkSaveScheduler class that picks the dirty chunks to save, spreading the saving over time
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+
+
+
+
+
+/** Decides which dirty chunks to save next, so that the chunks are saved continuously instead of all at once.
+Each chunk is to be saved at most an interval after it became dirty; the chunks are spread out over the interval,
+at the lowest rate that keeps the deadlines, but at most at the configured rate. So a chunk that is changed all the time
+is still only saved about once per interval. The chunks due are saved regardless of the rate, as are the unused chunks
+over the cap. The chunks about to be unloaded are saved before the others whose deadline isn't close, so that they can
+be unloaded sooner. */
+class cChunkSaveScheduler
+{
+public:
+
+	/** A dirty chunk, as the chunkmap reports it. */
+	struct sDirtyChunk
+	{
+		cChunkCoords m_Coords;
+
+		/** The world age at which the chunk became dirty. */
+		cTickTimeLong m_DirtySince;
+
+		/** True if the chunk could be unloaded once saved. */
+		bool m_IsUnused;
+	};
+
+
+	cChunkSaveScheduler(void);
+
+	/** Sets the longest time a chunk may stay dirty, the most chunks to save per second ahead of their deadline,
+	and the number of unused dirty chunks over which the unused chunks are saved regardless of the rate. */
+	void Configure(cTickTimeLong a_Interval, double a_ChunksPerSecond, size_t a_UnusedChunksCap);
+
+	/** Orders the chunks by their saving priority, and returns how many of them, from the front, are to be saved
+	within the a_Period starting at the world age a_Now. Updates the lag statistics. */
+	size_t Schedule(std::vector<sDirtyChunk> & a_Chunks, cTickTimeLong a_Now, cTickTimeLong a_Period);
+
+	/** Returns the number of chunks past their deadline, as of the last Schedule(). */
+	size_t GetNumOverdue(void) const { return m_NumOverdue; }
+
+	/** Returns how long the oldest dirty chunk has been dirty, as of the last Schedule(). */
+	cTickTimeLong GetOldestDirtyAge(void) const { return m_OldestDirtyAge; }
+
+	cTickTimeLong GetInterval(void) const { return m_Interval; }
+
+protected:
+
+	/** The longest time a chunk may stay dirty. */
+	cTickTimeLong m_Interval;
+
+	/** The most chunks to save per second ahead of their deadline. */
+	double m_ChunksPerSecond;
+
+	/** The part of a chunk left over from the previous Schedule() calls, so that rates below a chunk per period still save chunks.
+	Always below one after Schedule(). */
+	double m_SaveCredit;
+
+	/** The number of unused dirty chunks kept in memory without regard to the rate. */
+	size_t m_UnusedChunksCap;
+
+	size_t m_NumOverdue;
+	cTickTimeLong m_OldestDirtyAge;
+};
@@ -0,0 +1,365 @@
+
+// CompactChunkSerializer.cpp
+
+// Implements the cCompactChunkSerializer class that converts the chunks between the Anvil NBT and the compact storage form
+
+#include "Globals.h"
+#include "CompactChunkSerializer.h"
+#include "FastNBT.h"
+#include "../ChunkData.h"
+#include "../PalettedBlockSection.h"
+
+
+
+
+
+namespace
+{
+	constexpr size_t SectionBlockCount = ChunkBlockData::SectionBlockCount;
+	constexpr size_t SectionNibbleCount = ChunkBlockData::SectionMetaCount;
+
+	static_assert(ChunkLightData::SectionLightCount == SectionNibbleCount);
+
+
+
+
+
+	/** Appends the nibble array: a single byte if all its bytes are the same, the whole array otherwise.
+	A nullptr array is all a_Default. */
+	void AppendNibbles(ContiguousByteBuffer & a_Out, const NIBBLETYPE * a_Nibbles, const NIBBLETYPE a_Default)
+	{
+		if (a_Nibbles == nullptr)
+		{
+			a_Out.push_back(std::byte(0));
+			a_Out.push_back(std::byte(a_Default));
+			return;
+		}
+
+		const auto First = a_Nibbles[0];
+		if (std::all_of(a_Nibbles + 1, a_Nibbles + SectionNibbleCount, [First](const NIBBLETYPE a_Value) { return a_Value == First; }))
+		{
+			a_Out.push_back(std::byte(0));
+			a_Out.push_back(std::byte(First));
+			return;
+		}
+		a_Out.push_back(std::byte(1));
+		a_Out.append(reinterpret_cast<const std::byte *>(a_Nibbles), SectionNibbleCount);
+	}
+
+
+
+
+
+	/** Reads the nibble array written by AppendNibbles(), advancing a_Pos. Returns false if the data is too short or invalid. */
+	bool ReadNibbles(const std::byte * & a_Pos, const std::byte * a_End, NIBBLETYPE * a_Nibbles)
+	{
+		if (a_End - a_Pos < 2)
+		{
+			return false;
+		}
+		switch (static_cast<Byte>(*a_Pos))
+		{
+			case 0:
+			{
+				std::fill_n(a_Nibbles, SectionNibbleCount, static_cast<NIBBLETYPE>(a_Pos[1]));
+				a_Pos += 2;
+				return true;
+			}
+			case 1:
+			{
+				if (static_cast<size_t>(a_End - a_Pos) < 1 + SectionNibbleCount)
+				{
+					return false;
+				}
+				std::memcpy(a_Nibbles, a_Pos + 1, SectionNibbleCount);
+				a_Pos += 1 + SectionNibbleCount;
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+
+
+
+	/** Returns the byte array child of the specified name and length, or nullptr if there's no such child. */
+	const std::byte * GetByteArray(const cParsedNBT & a_NBT, const int a_Tag, const char * a_Name, const size_t a_Length)
+	{
+		const int Child = a_NBT.FindChildByName(a_Tag, a_Name);
+		if ((Child < 0) || (a_NBT.GetType(Child) != TAG_ByteArray) || (a_NBT.GetDataLength(Child) != a_Length))
+		{
+			return nullptr;
+		}
+		return a_NBT.GetData(Child);
+	}
+
+
+
+
+
+	/** Encodes the Anvil "Sections" list into a_Sections.
+	Returns false if any of the sections has anything else than the Y, Blocks, Data, BlockLight and SkyLight tags
+	of the expected types and sizes, or if the sections aren't sorted by their Y, so that they wouldn't convert back the same. */
+	bool EncodeAnvilSections(const cParsedNBT & a_NBT, const int a_SectionsTag, std::array<ContiguousByteBuffer, cChunkDef::NumSections> & a_Sections)
+	{
+		if (a_NBT.GetType(a_SectionsTag) != TAG_List)
+		{
+			return false;
+		}
+
+		int LastY = -1;
+		for (int Section = a_NBT.GetFirstChild(a_SectionsTag); Section >= 0; Section = a_NBT.GetNextSibling(Section))
+		{
+			if (a_NBT.GetType(Section) != TAG_Compound)
+			{
+				return false;
+			}
+
+			int NumChildren = 0;
+			for (int Child = a_NBT.GetFirstChild(Section); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+			{
+				NumChildren++;
+			}
+			const int YTag = a_NBT.FindChildByName(Section, "Y");
+			if ((NumChildren != 5) || (YTag < 0) || (a_NBT.GetType(YTag) != TAG_Byte))
+			{
+				return false;
+			}
+			const int Y = a_NBT.GetByte(YTag);
+			if ((Y <= LastY) || (Y >= static_cast<int>(cChunkDef::NumSections)))
+			{
+				return false;
+			}
+			LastY = Y;
+
+			const auto Blocks     = GetByteArray(a_NBT, Section, "Blocks",     SectionBlockCount);
+			const auto Metas      = GetByteArray(a_NBT, Section, "Data",       SectionNibbleCount);
+			const auto BlockLight = GetByteArray(a_NBT, Section, "BlockLight", SectionNibbleCount);
+			const auto SkyLight   = GetByteArray(a_NBT, Section, "SkyLight",   SectionNibbleCount);
+			if ((Blocks == nullptr) || (Metas == nullptr) || (BlockLight == nullptr) || (SkyLight == nullptr))
+			{
+				return false;
+			}
+			auto & Encoded = a_Sections[static_cast<size_t>(Y)];
+			Encoded.clear();
+			cCompactChunkSerializer::EncodeSection(
+				Encoded,
+				reinterpret_cast<const BLOCKTYPE *>(Blocks), reinterpret_cast<const NIBBLETYPE *>(Metas),
+				reinterpret_cast<const NIBBLETYPE *>(BlockLight), reinterpret_cast<const NIBBLETYPE *>(SkyLight)
+			);
+		}
+		return true;
+	}
+}  // namespace (anonymous)
+
+
+
+
+
+void cCompactChunkSerializer::EncodeSection(
+	ContiguousByteBuffer & a_Out,
+	const BLOCKTYPE * a_Blocks, const NIBBLETYPE * a_Metas,
+	const NIBBLETYPE * a_BlockLight, const NIBBLETYPE * a_SkyLight
+)
+{
+	PalettedBlockSection Section;
+	Section.SetAll(a_Blocks, a_Metas);
+	const auto & Palette = Section.GetPalette();
+	const auto & Data = Section.GetData();
+
+	a_Out.reserve(a_Out.size() + 2 + Palette.size() * 2 + 1 + Data.size() * 8 + 2 * (1 + SectionNibbleCount));
+	const auto Size = HostToNetwork(static_cast<UInt16>(Palette.size()));
+	a_Out.append(Size.begin(), Size.end());
+	for (const auto Entry: Palette)
+	{
+		const auto State = HostToNetwork(Entry);
+		a_Out.append(State.begin(), State.end());
+	}
+	a_Out.push_back(std::byte(Section.GetBitsPerEntry()));
+	for (const auto Word: Data)
+	{
+		const auto Bytes = HostToNetwork(Word);
+		a_Out.append(Bytes.begin(), Bytes.end());
+	}
+
+	AppendNibbles(a_Out, a_BlockLight, ChunkLightData::DefaultBlockLightValue);
+	AppendNibbles(a_Out, a_SkyLight, ChunkLightData::DefaultSkyLightValue);
+}
+
+
+
+
+
+bool cCompactChunkSerializer::DecodeSection(
+	const ContiguousByteBufferView a_Data,
+	BLOCKTYPE * a_Blocks, NIBBLETYPE * a_Metas,
+	NIBBLETYPE * a_BlockLight, NIBBLETYPE * a_SkyLight
+)
+{
+	auto Pos = a_Data.data();
+	const auto End = Pos + a_Data.size();
+
+	// The palette:
+	if (End - Pos < 2)
+	{
+		return false;
+	}
+	const size_t PaletteSize = NetworkBufToHost<UInt16>(Pos);
+	Pos += 2;
+	if (static_cast<size_t>(End - Pos) < PaletteSize * 2 + 1)
+	{
+		return false;
+	}
+	std::vector<PalettedBlockSection::State> Palette(PaletteSize);
+	for (auto & Entry: Palette)
+	{
+		Entry = NetworkBufToHost<UInt16>(Pos);
+		Pos += 2;
+	}
+
+	// The blocks, PalettedBlockSection checks that they fit the palette:
+	const unsigned Bits = static_cast<Byte>(*Pos++);
+	const size_t NumWords = SectionBlockCount * Bits / 64;
+	if (static_cast<size_t>(End - Pos) < NumWords * 8)
+	{
+		return false;
+	}
+	std::vector<UInt64> Data(NumWords);
+	for (auto & Word: Data)
+	{
+		Word = NetworkBufToHost<UInt64>(Pos);
+		Pos += 8;
+	}
+	PalettedBlockSection Section;
+	if (!Section.Load(Bits, std::move(Palette), std::move(Data)))
+	{
+		return false;
+	}
+	Section.CopyTo(a_Blocks, a_Metas);
+
+	return ReadNibbles(Pos, End, a_BlockLight) && ReadNibbles(Pos, End, a_SkyLight) && (Pos == End);
+}
+
+
+
+
+
+bool cCompactChunkSerializer::AnvilToCompact(const ContiguousByteBufferView a_AnvilNBT, sCompactChunk & a_Chunk)
+{
+	const cParsedNBT NBT(a_AnvilNBT);
+	if (!NBT.IsValid())
+	{
+		return false;
+	}
+	const int Level = NBT.FindChildByName(NBT.GetRoot(), "Level");
+	if ((Level < 0) || (NBT.GetType(Level) != TAG_Compound))
+	{
+		return false;
+	}
+	const int Sections = NBT.FindChildByName(Level, "Sections");
+	if (Sections < 0)
+	{
+		return false;
+	}
+
+	// Keep the sections as NBT, unless all of them fit the binary form:
+	for (auto & Section: a_Chunk.m_Sections)
+	{
+		Section.clear();
+	}
+	const bool AreSectionsBinary = EncodeAnvilSections(NBT, Sections, a_Chunk.m_Sections);
+	if (!AreSectionsBinary)
+	{
+		for (auto & Section: a_Chunk.m_Sections)
+		{
+			Section.clear();
+		}
+	}
+
+	cFastNBTWriter Writer(NBT.GetName(NBT.GetRoot()));
+	for (int Child = NBT.GetFirstChild(NBT.GetRoot()); Child >= 0; Child = NBT.GetNextSibling(Child))
+	{
+		if (Child != Level)
+		{
+			Writer.CopyTag(NBT, Child);
+			continue;
+		}
+		Writer.BeginCompound(NBT.GetName(Level));
+		for (int LevelChild = NBT.GetFirstChild(Level); LevelChild >= 0; LevelChild = NBT.GetNextSibling(LevelChild))
+		{
+			if (!AreSectionsBinary || (LevelChild != Sections))
+			{
+				Writer.CopyTag(NBT, LevelChild);
+			}
+		}
+		Writer.EndCompound();
+	}
+	Writer.Finish();
+	a_Chunk.m_Extras = Writer.GetResult();
+	return true;
+}
+
+
+
+
+
+bool cCompactChunkSerializer::CompactToAnvil(const sCompactChunk & a_Chunk, ContiguousByteBuffer & a_AnvilNBT)
+{
+	const cParsedNBT NBT(a_Chunk.m_Extras);
+	if (!NBT.IsValid())
+	{
+		return false;
+	}
+	const int Level = NBT.FindChildByName(NBT.GetRoot(), "Level");
+	if ((Level < 0) || (NBT.GetType(Level) != TAG_Compound))
+	{
+		return false;
+	}
+
+	cFastNBTWriter Writer(NBT.GetName(NBT.GetRoot()));
+	for (int Child = NBT.GetFirstChild(NBT.GetRoot()); Child >= 0; Child = NBT.GetNextSibling(Child))
+	{
+		if (Child != Level)
+		{
+			Writer.CopyTag(NBT, Child);
+			continue;
+		}
+		Writer.BeginCompound(NBT.GetName(Level));
+		for (int LevelChild = NBT.GetFirstChild(Level); LevelChild >= 0; LevelChild = NBT.GetNextSibling(LevelChild))
+		{
+			Writer.CopyTag(NBT, LevelChild);
+		}
+
+		// The sections kept as NBT were copied above, otherwise decode them back:
+		if (NBT.FindChildByName(Level, "Sections") < 0)
+		{
+			BLOCKTYPE Blocks[SectionBlockCount];
+			NIBBLETYPE Metas[SectionNibbleCount], BlockLight[SectionNibbleCount], SkyLight[SectionNibbleCount];
+			Writer.BeginList("Sections", TAG_Compound);
+			for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+			{
+				if (a_Chunk.m_Sections[Y].empty())
+				{
+					continue;
+				}
+				if (!DecodeSection(a_Chunk.m_Sections[Y], Blocks, Metas, BlockLight, SkyLight))
+				{
+					return false;
+				}
+				Writer.BeginCompound("");
+				Writer.AddByteArray("Blocks", reinterpret_cast<const char *>(Blocks), SectionBlockCount);
+				Writer.AddByteArray("Data", reinterpret_cast<const char *>(Metas), SectionNibbleCount);
+				Writer.AddByteArray("BlockLight", reinterpret_cast<const char *>(BlockLight), SectionNibbleCount);
+				Writer.AddByteArray("SkyLight", reinterpret_cast<const char *>(SkyLight), SectionNibbleCount);
+				Writer.AddByte("Y", static_cast<unsigned char>(Y));
+				Writer.EndCompound();
+			}
+			Writer.EndList();
+		}
+		Writer.EndCompound();
+	}
+	Writer.Finish();
+	a_AnvilNBT = Writer.GetResult();
+	return true;
+}
@@ -0,0 +1,74 @@
+
+// CompactChunkSerializer.h
+
+// Declares the cCompactChunkSerializer class that converts the chunks between the Anvil NBT and the compact storage form
+
+
+
+
+
+#pragma once
+
+#include "../ChunkDef.h"
+
+
+
+
+
+/** A chunk as the compact storage keeps it. */
+struct sCompactChunk
+{
+	/** The palette-encoded block and light data of each section, indexed by the section's Y.
+	Empty for the sections that the chunk doesn't store. */
+	std::array<ContiguousByteBuffer, cChunkDef::NumSections> m_Sections;
+
+	/** The rest of the chunk, as uncompressed NBT: the Anvil chunk without the "Sections" tag.
+	The chunks whose sections don't fit the binary form keep their "Sections" tag here instead. */
+	ContiguousByteBuffer m_Extras;
+};
+
+
+
+
+
+/** Encodes the chunk sections into their compact binary form and back, and converts the whole chunks from and to the
+Anvil NBT, losslessly.
+
+A section is encoded as the width, palette and data of its PalettedBlockSection:
+	UInt16 PaletteSize
+	UInt16 Palette[PaletteSize]  -- (BlockType << 4) | Meta, in the order of the first appearance in the section
+	UInt8 BitsPerBlock           -- 0 for a single-entry palette, 1, 2, 4 or 8 to index the palette,
+	                                16 for the states themselves, with no palette, if there are more than 256 of them
+	UInt64 Data[4096 * BitsPerBlock / 64]  -- the packed values in the ChunkDef block order, the first in the lowest bits
+	the BlockLight, then the SkyLight:
+		UInt8 0, UInt8 Value     -- all the bytes of the nibble array are Value
+		UInt8 1, 2048 bytes      -- the nibble array as-is
+All the multi-byte values are big-endian. The same section always encodes to the same bytes. */
+class cCompactChunkSerializer
+{
+public:
+
+	/** Appends the encoded section to a_Out. A nullptr array stands for the array filled with the chunk data's default value. */
+	static void EncodeSection(
+		ContiguousByteBuffer & a_Out,
+		const BLOCKTYPE * a_Blocks, const NIBBLETYPE * a_Metas,
+		const NIBBLETYPE * a_BlockLight, const NIBBLETYPE * a_SkyLight
+	);
+
+	/** Decodes the section into the arrays, which must hold a whole section each.
+	Returns false if the data is not a valid encoded section. */
+	static bool DecodeSection(
+		ContiguousByteBufferView a_Data,
+		BLOCKTYPE * a_Blocks, NIBBLETYPE * a_Metas,
+		NIBBLETYPE * a_BlockLight, NIBBLETYPE * a_SkyLight
+	);
+
+	/** Converts the uncompressed Anvil chunk NBT into the compact form.
+	Returns false if the NBT isn't a chunk: it doesn't parse, or misses the Level or its Sections. */
+	static bool AnvilToCompact(ContiguousByteBufferView a_AnvilNBT, sCompactChunk & a_Chunk);
+
+	/** Converts the chunk back into the uncompressed Anvil chunk NBT.
+	The tags are the same as those converted by AnvilToCompact(), except that the "Sections" come last within the Level.
+	Returns false if the chunk data is corrupt. */
+	static bool CompactToAnvil(const sCompactChunk & a_Chunk, ContiguousByteBuffer & a_AnvilNBT);
+};
@@ -0,0 +1,708 @@
+
+// CompactRegionFile.cpp
+
+// Implements the cCompactRegionFile class representing a single region file of the compact world storage
+
+#include "Globals.h"
+#include "CompactRegionFile.h"
+#include "../Endianness.h"
+
+
+
+
+
+namespace
+{
+	const std::byte Magic[] = { std::byte('C'), std::byte('M'), std::byte('P'), std::byte('R') };
+	/** The version of the file format; the sections of version 2 are laid out as PalettedBlockSection. */
+	constexpr UInt32 Version = 2;
+
+	enum : Byte
+	{
+		COMPRESSION_NONE = 0,
+		COMPRESSION_DEFLATE = 1,
+	};
+
+	/** The size of the compression and the two sizes in front of the stored data. */
+	constexpr size_t DataHeaderSize = 1 + 4 + 4;
+
+	/** The largest data extracted from a record, a sanity check against corrupt sizes. */
+	constexpr UInt32 MaxDataSize = 64 MiB;
+
+	/** The file is rewritten only when larger than this, so that the small regions aren't rewritten over and over. */
+	constexpr UInt32 MinCompactionSize = 4 MiB;
+
+
+
+
+
+	/** Appends the value in the network byte order. */
+	template <typename T>
+	void Append(ContiguousByteBuffer & a_Out, const T a_Value)
+	{
+		const auto Bytes = HostToNetwork(a_Value);
+		a_Out.append(Bytes.begin(), Bytes.end());
+	}
+}  // namespace (anonymous)
+
+
+
+
+
+cCompactRegionFile::cCompactRegionFile(
+	const AString & a_FileName, const int a_RegionX, const int a_RegionZ,
+	Compression::Compressor & a_Compressor, Compression::Extractor & a_Extractor
+):
+	m_RegionX(a_RegionX),
+	m_RegionZ(a_RegionZ),
+	m_FileName(a_FileName),
+	m_Compressor(a_Compressor),
+	m_Extractor(a_Extractor),
+	m_FileSize(0),
+	m_LiveSize(HEADER_SIZE)
+{
+}
+
+
+
+
+
+bool cCompactRegionFile::GetChunk(const cChunkCoords & a_Chunk, sCompactChunk & a_Data)
+{
+	if (!OpenFile(true))
+	{
+		return false;
+	}
+
+	const auto & Chunk = m_Chunks[GetIndex(a_Chunk)];
+	if (Chunk.m_Offset == 0)
+	{
+		return false;
+	}
+
+	if (!ReadRecord(Chunk.m_Offset, Chunk.m_Size))
+	{
+		throw std::runtime_error("Cannot read the chunk record");
+	}
+
+	// The section offsets were validated when loading the index, only the Ys are left to check:
+	const auto NumSections = Chunk.m_SectionOffsets.size();
+	std::array<size_t, cChunkDef::NumSections> Ys;
+	for (size_t i = 0; i < NumSections; i++)
+	{
+		Ys[i] = static_cast<size_t>(m_Record[1 + i * 5]);
+		if ((Ys[i] >= cChunkDef::NumSections) || ((i > 0) && (Ys[i] <= Ys[i - 1])))
+		{
+			throw std::runtime_error(fmt::format(FMT_STRING("Invalid section Y: {}"), Ys[i]));
+		}
+	}
+	ExtractData(ContiguousByteBufferView(m_Record).substr(1 + NumSections * 5), a_Data.m_Extras);
+
+	for (auto & Section: a_Data.m_Sections)
+	{
+		Section.clear();
+	}
+	for (size_t i = 0; i < NumSections; i++)
+	{
+		ReadSection(Chunk.m_SectionOffsets[i], a_Data.m_Sections[Ys[i]]);
+	}
+	return true;
+}
+
+
+
+
+
+bool cCompactRegionFile::SetChunk(const cChunkCoords & a_Chunk, const sCompactChunk & a_Data)
+{
+	if (!OpenFile(false))
+	{
+		LOGWARNING("Cannot save chunk [%d, %d], opening file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, m_FileName);
+		return false;
+	}
+
+	// Reference the sections already stored, append the others, all of them in a single write:
+	struct sNewSection
+	{
+		UInt64 m_Hash;
+		UInt32 m_Offset;
+		UInt32 m_RecordSize;
+		size_t m_Y;
+	};
+	std::vector<sNewSection> NewSections;
+	std::vector<std::pair<size_t, UInt32>> SectionRefs;
+	ContiguousByteBuffer Records;
+	for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+	{
+		const auto & Encoded = a_Data.m_Sections[Y];
+		if (Encoded.empty())
+		{
+			continue;
+		}
+		const auto SectionHash = Hash(Encoded);
+		auto Offset = FindSection(SectionHash, Encoded);
+		if (Offset == 0)
+		{
+			for (const auto & NewSection: NewSections)
+			{
+				if ((NewSection.m_Hash == SectionHash) && (a_Data.m_Sections[NewSection.m_Y] == Encoded))
+				{
+					Offset = NewSection.m_Offset;
+					break;
+				}
+			}
+		}
+		if (Offset == 0)
+		{
+			const auto RecordStart = Records.size();
+			Offset = static_cast<UInt32>(m_FileSize + RecordStart);
+			Append(Records, SectionHash);
+			AppendData(Records, Encoded);
+			NewSections.push_back({ SectionHash, Offset, static_cast<UInt32>(Records.size() - RecordStart), Y });
+		}
+		SectionRefs.emplace_back(Y, Offset);
+	}
+
+	const auto ChunkRecordStart = Records.size();
+	const auto ChunkOffset = static_cast<UInt32>(m_FileSize + ChunkRecordStart);
+	Records.push_back(std::byte(SectionRefs.size()));
+	for (const auto & [Y, Offset]: SectionRefs)
+	{
+		Records.push_back(std::byte(Y));
+		Append(Records, Offset);
+	}
+	AppendData(Records, a_Data.m_Extras);
+	const auto ChunkSize = static_cast<UInt32>(Records.size() - ChunkRecordStart);
+
+	if (static_cast<UInt64>(m_FileSize) + Records.size() > static_cast<UInt64>(std::numeric_limits<int>::max()))
+	{
+		LOGWARNING("Cannot save chunk [%d, %d], file \"%s\" is too large", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, m_FileName);
+		return false;
+	}
+	if (
+		(m_File.Seek(static_cast<int>(m_FileSize)) < 0) ||
+		(m_File.Write(Records.data(), Records.size()) != static_cast<int>(Records.size()))
+	)
+	{
+		LOGWARNING("Cannot save chunk [%d, %d], writing data to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, m_FileName);
+		return false;
+	}
+	m_FileSize += static_cast<UInt32>(Records.size());
+
+	// Only once the index points to the new record does the chunk change:
+	const auto Index = GetIndex(a_Chunk);
+	if (!WriteIndexEntry(Index, ChunkOffset, ChunkSize))
+	{
+		LOGWARNING("Cannot save chunk [%d, %d], writing index to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, m_FileName);
+		return false;
+	}
+
+	for (const auto & NewSection: NewSections)
+	{
+		m_Sections.emplace(NewSection.m_Offset, sSection{ NewSection.m_Hash, NewSection.m_RecordSize, 0 });
+		m_SectionsByHash.emplace(NewSection.m_Hash, NewSection.m_Offset);
+		m_LiveSize += NewSection.m_RecordSize;
+	}
+	auto & Chunk = m_Chunks[Index];
+	auto OldSectionOffsets = std::move(Chunk.m_SectionOffsets);
+	Chunk.m_SectionOffsets.clear();
+	for (const auto & SectionRef: SectionRefs)
+	{
+		VERIFY(AddSectionRef(SectionRef.second));
+		Chunk.m_SectionOffsets.push_back(SectionRef.second);
+	}
+	for (const auto Offset: OldSectionOffsets)
+	{
+		RemoveSectionRef(Offset);
+	}
+	m_LiveSize = m_LiveSize - Chunk.m_Size + ChunkSize;
+	Chunk.m_Offset = ChunkOffset;
+	Chunk.m_Size = ChunkSize;
+
+	CompactIfNeeded();
+	return true;
+}
+
+
+
+
+
+bool cCompactRegionFile::Compact(void)
+{
+	if (!OpenFile(true))
+	{
+		// Nothing to compact
+		return !cFile::Exists(m_FileName);
+	}
+
+	// Build the new file in memory, from the live records only:
+	ContiguousByteBuffer Data(HEADER_SIZE, std::byte(0));
+	std::copy(std::begin(Magic), std::end(Magic), Data.begin());
+	const auto VersionBytes = HostToNetwork(Version);
+	std::copy(VersionBytes.begin(), VersionBytes.end(), Data.begin() + 4);
+	std::unordered_map<UInt32, UInt32> NewOffsets;
+	for (size_t i = 0; i < MAX_CHUNKS; i++)
+	{
+		const auto & Chunk = m_Chunks[i];
+		if (Chunk.m_Offset == 0)
+		{
+			continue;
+		}
+		for (const auto Offset: Chunk.m_SectionOffsets)
+		{
+			if (NewOffsets.find(Offset) != NewOffsets.end())
+			{
+				continue;
+			}
+			if (!ReadRecord(Offset, m_Sections.at(Offset).m_RecordSize))
+			{
+				LOGWARNING("Cannot compact file \"%s\", reading a section record failed", m_FileName);
+				return false;
+			}
+			NewOffsets[Offset] = static_cast<UInt32>(Data.size());
+			Data.append(m_Record);
+		}
+
+		if (!ReadRecord(Chunk.m_Offset, Chunk.m_Size))
+		{
+			LOGWARNING("Cannot compact file \"%s\", reading a chunk record failed", m_FileName);
+			return false;
+		}
+		for (size_t s = 0; s < Chunk.m_SectionOffsets.size(); s++)
+		{
+			const auto NewOffset = HostToNetwork(NewOffsets[Chunk.m_SectionOffsets[s]]);
+			std::copy(NewOffset.begin(), NewOffset.end(), m_Record.begin() + static_cast<std::ptrdiff_t>(2 + s * 5));
+		}
+		const auto Offset = HostToNetwork(static_cast<UInt32>(Data.size()));
+		const auto Size = HostToNetwork(Chunk.m_Size);
+		std::copy(Offset.begin(), Offset.end(), Data.begin() + static_cast<std::ptrdiff_t>(8 + i * 8));
+		std::copy(Size.begin(), Size.end(), Data.begin() + static_cast<std::ptrdiff_t>(12 + i * 8));
+		Data.append(m_Record);
+	}
+
+	// Write the new file, then replace the old one with it:
+	const auto TempFileName = m_FileName + ".tmp";
+	{
+		cFile Out;
+		if (!Out.Open(TempFileName, cFile::fmWrite) || (Out.Write(Data.data(), Data.size()) != static_cast<int>(Data.size())))
+		{
+			LOGWARNING("Cannot compact file \"%s\", writing file \"%s\" failed", m_FileName, TempFileName);
+			Out.Close();
+			cFile::DeleteFile(TempFileName);
+			return false;
+		}
+	}
+	Reset();
+	if (!cFile::Rename(TempFileName, m_FileName))
+	{
+		// Some platforms don't replace the existing files when renaming. OpenFile() finishes the rename if interrupted here.
+		if (!cFile::DeleteFile(m_FileName) || !cFile::Rename(TempFileName, m_FileName))
+		{
+			LOGWARNING("Cannot compact file \"%s\", replacing it with file \"%s\" failed", m_FileName, TempFileName);
+			return false;
+		}
+	}
+	return OpenFile(true);
+}
+
+
+
+
+
+size_t cCompactRegionFile::GetNumChunks(void)
+{
+	if (!OpenFile(true))
+	{
+		return 0;
+	}
+	return static_cast<size_t>(std::count_if(m_Chunks.begin(), m_Chunks.end(), [](const sChunk & a_Chunk)
+		{
+			return (a_Chunk.m_Offset != 0);
+		}
+	));
+}
+
+
+
+
+
+size_t cCompactRegionFile::GetNumSectionRefs(void) const
+{
+	size_t Res = 0;
+	for (const auto & Section: m_Sections)
+	{
+		Res += Section.second.m_NumRefs;
+	}
+	return Res;
+}
+
+
+
+
+
+bool cCompactRegionFile::OpenFile(const bool a_IsForReading)
+{
+	if (m_File.IsOpen())
+	{
+		// Already open
+		return true;
+	}
+
+	// A compaction interrupted after removing the old file leaves the complete new one:
+	const auto TempFileName = m_FileName + ".tmp";
+	if (!cFile::Exists(m_FileName) && cFile::Exists(TempFileName))
+	{
+		cFile::Rename(TempFileName, m_FileName);
+	}
+
+	if (a_IsForReading && !cFile::Exists(m_FileName))
+	{
+		// We want to read and the file doesn't exist. Fail.
+		return false;
+	}
+	if (!m_File.Open(m_FileName, cFile::fmReadWrite))
+	{
+		return false;
+	}
+
+	const auto FileSize = m_File.GetSize();
+	if (FileSize <= 0)
+	{
+		// A new file, write an empty index:
+		ContiguousByteBuffer Header(HEADER_SIZE, std::byte(0));
+		std::copy(std::begin(Magic), std::end(Magic), Header.begin());
+		const auto VersionBytes = HostToNetwork(Version);
+		std::copy(VersionBytes.begin(), VersionBytes.end(), Header.begin() + 4);
+		if (m_File.Write(Header.data(), Header.size()) != static_cast<int>(Header.size()))
+		{
+			LOGWARNING("Cannot write the header of file \"%s\", chunks in that file will be lost", m_FileName);
+			m_File.Close();
+			return false;
+		}
+		m_FileSize = HEADER_SIZE;
+		m_LiveSize = HEADER_SIZE;
+		return true;
+	}
+
+	const auto Header = m_File.Read(HEADER_SIZE);
+	if (
+		(FileSize >= std::numeric_limits<int>::max()) ||
+		(Header.size() != HEADER_SIZE) ||
+		!std::equal(std::begin(Magic), std::end(Magic), Header.begin()) ||
+		(NetworkBufToHost<UInt32>(Header.data() + 4) != Version)
+	)
+	{
+		// Don't touch the file, its chunks may still be recoverable by other means:
+		LOGWARNING("File \"%s\" is not a compact region file of a supported version, chunks in that file cannot be loaded nor saved", m_FileName);
+		m_File.Close();
+		return false;
+	}
+	m_FileSize = static_cast<UInt32>(FileSize);
+
+	for (size_t i = 0; i < MAX_CHUNKS; i++)
+	{
+		const auto Offset = NetworkBufToHost<UInt32>(Header.data() + 8 + i * 8);
+		const auto Size = NetworkBufToHost<UInt32>(Header.data() + 12 + i * 8);
+		if (Offset == 0)
+		{
+			continue;
+		}
+		if ((Offset < HEADER_SIZE) || (Size == 0) || (static_cast<UInt64>(Offset) + Size > m_FileSize))
+		{
+			LOGWARNING("File \"%s\" has an invalid index entry %zu, the chunk is lost", m_FileName, i);
+			continue;
+		}
+		m_Chunks[i].m_Offset = Offset;
+		m_Chunks[i].m_Size = Size;
+	}
+	LoadSections();
+	return true;
+}
+
+
+
+
+
+void cCompactRegionFile::LoadSections(void)
+{
+	for (size_t i = 0; i < MAX_CHUNKS; i++)
+	{
+		auto & Chunk = m_Chunks[i];
+		if (Chunk.m_Offset == 0)
+		{
+			continue;
+		}
+
+		// Read the section offsets first, reading the sections overwrites the record:
+		bool IsValid = ReadRecord(Chunk.m_Offset, Chunk.m_Size);
+		if (IsValid)
+		{
+			const auto NumSections = static_cast<size_t>(m_Record[0]);
+			IsValid = (NumSections <= cChunkDef::NumSections) && (m_Record.size() >= 1 + NumSections * 5 + DataHeaderSize);
+			for (size_t s = 0; IsValid && (s < NumSections); s++)
+			{
+				Chunk.m_SectionOffsets.push_back(NetworkBufToHost<UInt32>(m_Record.data() + 2 + s * 5));
+			}
+		}
+		size_t NumAdded = 0;
+		while (IsValid && (NumAdded < Chunk.m_SectionOffsets.size()))
+		{
+			IsValid = AddSectionRef(Chunk.m_SectionOffsets[NumAdded]);
+			if (IsValid)
+			{
+				NumAdded++;
+			}
+		}
+
+		if (!IsValid)
+		{
+			LOGWARNING("File \"%s\" has an invalid chunk record at offset %u, the chunk is lost", m_FileName, Chunk.m_Offset);
+			for (size_t s = 0; s < NumAdded; s++)
+			{
+				RemoveSectionRef(Chunk.m_SectionOffsets[s]);
+			}
+			Chunk = sChunk();
+			continue;
+		}
+		m_LiveSize += Chunk.m_Size;
+	}
+}
+
+
+
+
+
+void cCompactRegionFile::Reset(void)
+{
+	m_File.Close();
+	m_Chunks.fill(sChunk());
+	m_Sections.clear();
+	m_SectionsByHash.clear();
+	m_FileSize = 0;
+	m_LiveSize = HEADER_SIZE;
+}
+
+
+
+
+
+bool cCompactRegionFile::AddSectionRef(const UInt32 a_Offset)
+{
+	auto itr = m_Sections.find(a_Offset);
+	if (itr != m_Sections.end())
+	{
+		itr->second.m_NumRefs++;
+		return true;
+	}
+
+	if ((a_Offset < HEADER_SIZE) || !ReadRecord(a_Offset, SECTION_RECORD_HEADER_SIZE))
+	{
+		return false;
+	}
+	const auto SectionHash = NetworkBufToHost<UInt64>(m_Record.data());
+	const auto RecordSize = static_cast<UInt64>(SECTION_RECORD_HEADER_SIZE) + NetworkBufToHost<UInt32>(m_Record.data() + 9);
+	if (static_cast<UInt64>(a_Offset) + RecordSize > m_FileSize)
+	{
+		return false;
+	}
+	m_Sections.emplace(a_Offset, sSection{ SectionHash, static_cast<UInt32>(RecordSize), 1 });
+	m_SectionsByHash.emplace(SectionHash, a_Offset);
+	m_LiveSize += static_cast<UInt32>(RecordSize);
+	return true;
+}
+
+
+
+
+
+void cCompactRegionFile::RemoveSectionRef(const UInt32 a_Offset)
+{
+	auto itr = m_Sections.find(a_Offset);
+	ASSERT(itr != m_Sections.end());
+	if ((itr == m_Sections.end()) || (--itr->second.m_NumRefs > 0))
+	{
+		return;
+	}
+
+	m_LiveSize -= itr->second.m_RecordSize;
+	const auto Range = m_SectionsByHash.equal_range(itr->second.m_Hash);
+	for (auto HashItr = Range.first; HashItr != Range.second; ++HashItr)
+	{
+		if (HashItr->second == a_Offset)
+		{
+			m_SectionsByHash.erase(HashItr);
+			break;
+		}
+	}
+	m_Sections.erase(itr);
+}
+
+
+
+
+
+UInt32 cCompactRegionFile::FindSection(const UInt64 a_Hash, const ContiguousByteBufferView a_Encoded)
+{
+	const auto Range = m_SectionsByHash.equal_range(a_Hash);
+	for (auto itr = Range.first; itr != Range.second; ++itr)
+	{
+		// Compare the whole sections, the hash only narrows down the candidates:
+		try
+		{
+			ReadSection(itr->second, m_Extracted);
+		}
+		catch (const std::exception &)
+		{
+			continue;
+		}
+		if (ContiguousByteBufferView(m_Extracted) == a_Encoded)
+		{
+			return itr->second;
+		}
+	}
+	return 0;
+}
+
+
+
+
+
+bool cCompactRegionFile::ReadRecord(const UInt32 a_Offset, const UInt32 a_Size)
+{
+	if (static_cast<UInt64>(a_Offset) + a_Size > m_FileSize)
+	{
+		return false;
+	}
+	if (m_File.Seek(static_cast<int>(a_Offset)) < 0)
+	{
+		return false;
+	}
+	m_Record.resize(a_Size);
+	return (m_File.Read(m_Record.data(), a_Size) == static_cast<int>(a_Size));
+}
+
+
+
+
+
+void cCompactRegionFile::ReadSection(const UInt32 a_Offset, ContiguousByteBuffer & a_Encoded)
+{
+	const auto itr = m_Sections.find(a_Offset);
+	if (itr == m_Sections.end())
+	{
+		throw std::runtime_error(fmt::format(FMT_STRING("Unknown section record at offset {}"), a_Offset));
+	}
+	if (!ReadRecord(a_Offset, itr->second.m_RecordSize))
+	{
+		throw std::runtime_error(fmt::format(FMT_STRING("Cannot read the section record at offset {}"), a_Offset));
+	}
+	ExtractData(ContiguousByteBufferView(m_Record).substr(8), a_Encoded);
+}
+
+
+
+
+
+bool cCompactRegionFile::WriteIndexEntry(const size_t a_Index, const UInt32 a_Offset, const UInt32 a_Size)
+{
+	ContiguousByteBuffer Entry;
+	Append(Entry, a_Offset);
+	Append(Entry, a_Size);
+	return (
+		(m_File.Seek(static_cast<int>(8 + a_Index * 8)) >= 0) &&
+		(m_File.Write(Entry.data(), Entry.size()) == static_cast<int>(Entry.size()))
+	);
+}
+
+
+
+
+
+void cCompactRegionFile::AppendData(ContiguousByteBuffer & a_Out, const ContiguousByteBufferView a_Data)
+{
+	const auto Compressed = m_Compressor.CompressDeflate(a_Data);
+	const bool IsCompressed = (Compressed.Size < a_Data.size());
+	const auto Stored = IsCompressed ? Compressed.GetView() : a_Data;
+	a_Out.push_back(std::byte(IsCompressed ? COMPRESSION_DEFLATE : COMPRESSION_NONE));
+	Append(a_Out, static_cast<UInt32>(Stored.size()));
+	Append(a_Out, static_cast<UInt32>(a_Data.size()));
+	a_Out.append(Stored);
+}
+
+
+
+
+
+void cCompactRegionFile::ExtractData(const ContiguousByteBufferView a_Data, ContiguousByteBuffer & a_Out)
+{
+	if (a_Data.size() < DataHeaderSize)
+	{
+		throw std::runtime_error("Data header truncated");
+	}
+	const auto Compression = static_cast<Byte>(a_Data[0]);
+	const auto StoredSize = NetworkBufToHost<UInt32>(a_Data.data() + 1);
+	const auto OriginalSize = NetworkBufToHost<UInt32>(a_Data.data() + 5);
+	if ((StoredSize > a_Data.size() - DataHeaderSize) || (OriginalSize > MaxDataSize))
+	{
+		throw std::runtime_error("Data size out of bounds");
+	}
+	const auto Stored = a_Data.substr(DataHeaderSize, StoredSize);
+
+	switch (Compression)
+	{
+		case COMPRESSION_NONE:
+		{
+			if (StoredSize != OriginalSize)
+			{
+				throw std::runtime_error("Data size mismatch");
+			}
+			a_Out.assign(Stored);
+			return;
+		}
+		case COMPRESSION_DEFLATE:
+		{
+			m_Extractor.ExtractDeflate(Stored, OriginalSize, a_Out);
+			a_Out.resize(OriginalSize);
+			return;
+		}
+	}
+	throw std::runtime_error(fmt::format(FMT_STRING("Unknown data compression: {}"), Compression));
+}
+
+
+
+
+
+void cCompactRegionFile::CompactIfNeeded(void)
+{
+	if ((m_FileSize < MinCompactionSize) || (m_FileSize - m_LiveSize <= m_LiveSize))
+	{
+		return;
+	}
+	Compact();
+}
+
+
+
+
+
+UInt64 cCompactRegionFile::Hash(const ContiguousByteBufferView a_Data)
+{
+	UInt64 Res = 14695981039346656037ULL;
+	for (const auto Value: a_Data)
+	{
+		Res = (Res ^ static_cast<UInt64>(Value)) * 1099511628211ULL;
+	}
+	return Res;
+}
+
+
+
+
+
+size_t cCompactRegionFile::GetIndex(const cChunkCoords & a_Chunk)
+{
+	const int LocalX = a_Chunk.m_ChunkX - FAST_FLOOR_DIV(a_Chunk.m_ChunkX, 32) * 32;
+	const int LocalZ = a_Chunk.m_ChunkZ - FAST_FLOOR_DIV(a_Chunk.m_ChunkZ, 32) * 32;
+	return static_cast<size_t>(LocalX + 32 * LocalZ);
+}
@@ -0,0 +1,181 @@
+
+// CompactRegionFile.h
+
+// Declares the cCompactRegionFile class representing a single region file of the compact world storage
+
+/*
+A region file stores the 32 * 32 chunks of a region. It starts with a fixed-size index and continues with the records,
+each of them only ever appended and never rewritten:
+	the header:
+		"CMPR", UInt32 Version
+		{UInt32 Offset, UInt32 Size} Index[1024]  -- the chunk records, by LocalX + 32 * LocalZ; Offset 0 for no chunk
+	a section record:
+		UInt64 Hash                               -- FNV-1a of the encoded section
+		UInt8 Compression                         -- 0 stored as-is, 1 raw deflate
+		UInt32 StoredSize, UInt32 EncodedSize
+		StoredSize bytes of the encoded section, see cCompactChunkSerializer
+	a chunk record:
+		UInt8 NumSections
+		{UInt8 Y, UInt32 Offset} Sections[NumSections]
+		UInt8 Compression, UInt32 StoredSize, UInt32 ExtrasSize
+		StoredSize bytes of the extras NBT
+All the numbers are big-endian.
+
+The identical sections, whether in the same chunk or in different chunks of the region, share a single section record.
+Saving a chunk appends its new section records and its chunk record in a single write, then updates the index entry,
+so that a crash leaves either the old or the new chunk in the file, never a mix. The records that aren't referenced
+anymore are dropped by rewriting the file once they outweigh the live ones.
+*/
+
+
+
+
+
+#pragma once
+
+#include "CompactChunkSerializer.h"
+#include "../OSSupport/File.h"
+#include "../StringCompression.h"
+
+
+
+
+
+class cCompactRegionFile
+{
+public:
+
+	cCompactRegionFile(const AString & a_FileName, int a_RegionX, int a_RegionZ, Compression::Compressor & a_Compressor, Compression::Extractor & a_Extractor);
+
+	/** Reads the chunk. Returns false if the file doesn't contain the chunk.
+	Throws a std::runtime_error if the chunk data is corrupt. */
+	bool GetChunk(const cChunkCoords & a_Chunk, sCompactChunk & a_Data);
+
+	/** Stores the chunk, replacing any previous data of the chunk. Returns true if successful. */
+	bool SetChunk(const cChunkCoords & a_Chunk, const sCompactChunk & a_Data);
+
+	/** Rewrites the file with only the live records. Returns true if successful. */
+	bool Compact(void);
+
+	int             GetRegionX () const { return m_RegionX; }
+	int             GetRegionZ () const { return m_RegionZ; }
+	const AString & GetFileName() const { return m_FileName; }
+
+	/** Returns the number of the chunks in the file. Opens the file, if it exists. */
+	size_t GetNumChunks(void);
+
+	/** Returns the number of the distinct sections referenced by the chunks, and the total number of the references. */
+	size_t GetNumSections(void) const { return m_Sections.size(); }
+	size_t GetNumSectionRefs(void) const;
+
+	/** Returns the size of the file, including the records not referenced anymore. */
+	UInt32 GetFileSize(void) const { return m_FileSize; }
+
+protected:
+
+	enum
+	{
+		/** The chunks in a region file, same as the count of the index entries. */
+		MAX_CHUNKS = 32 * 32,
+
+		HEADER_SIZE = 8 + MAX_CHUNKS * 8,
+
+		SECTION_RECORD_HEADER_SIZE = 1 + 4 + 4 + 8,
+	};
+
+
+	/** A section record, referenced by one or more chunks. */
+	struct sSection
+	{
+		UInt64 m_Hash;
+
+		/** The size of the whole record, including its header. */
+		UInt32 m_RecordSize;
+
+		/** The number of the chunk sections using the record. */
+		size_t m_NumRefs;
+	};
+
+
+	/** The index entry of a chunk, with the sections that its record references. */
+	struct sChunk
+	{
+		UInt32 m_Offset = 0;
+		UInt32 m_Size = 0;
+		std::vector<UInt32> m_SectionOffsets;
+	};
+
+
+	int m_RegionX;
+	int m_RegionZ;
+	AString m_FileName;
+	cFile m_File;
+
+	Compression::Compressor & m_Compressor;
+	Compression::Extractor & m_Extractor;
+
+	/** The chunks stored in the file, indexed by LocalX + 32 * LocalZ. */
+	std::array<sChunk, MAX_CHUNKS> m_Chunks;
+
+	/** The live section records, by their offset. */
+	std::unordered_map<UInt32, sSection> m_Sections;
+
+	/** The offsets of the live section records, by the hash of their encoded section. */
+	std::unordered_multimap<UInt64, UInt32> m_SectionsByHash;
+
+	UInt32 m_FileSize;
+
+	/** The size of the header and the records referenced from it; the rest of the file is garbage. */
+	UInt32 m_LiveSize;
+
+	/** Buffers kept across the calls to avoid reallocating. */
+	ContiguousByteBuffer m_Record, m_Extracted;
+
+
+	/** Opens the file either for reading (fails if it doesn't exist) or for writing (creates it if it doesn't exist)
+	and loads the index. Returns true if successful. */
+	bool OpenFile(bool a_IsForReading);
+
+	/** Reads the chunk records' sections and the section records' headers to rebuild the section maps.
+	Drops the chunks whose records cannot be read. */
+	void LoadSections(void);
+
+	/** Clears all the in-memory state, as for a file not opened yet. */
+	void Reset(void);
+
+	/** Adds a reference to the section record at the specified offset, reading its header if it wasn't referenced before.
+	Returns false if the record cannot be read. */
+	bool AddSectionRef(UInt32 a_Offset);
+
+	/** Removes a reference to the section record; the last one turns the record into garbage. */
+	void RemoveSectionRef(UInt32 a_Offset);
+
+	/** Returns the offset of a live section record with the same encoded section, or 0 if there's none. */
+	UInt32 FindSection(UInt64 a_Hash, ContiguousByteBufferView a_Encoded);
+
+	/** Reads the whole record of the specified size at the specified offset into m_Record. Returns true if successful. */
+	bool ReadRecord(UInt32 a_Offset, UInt32 a_Size);
+
+	/** Reads the section record at the specified offset and extracts the encoded section into a_Encoded.
+	Throws a std::runtime_error if the record is corrupt. */
+	void ReadSection(UInt32 a_Offset, ContiguousByteBuffer & a_Encoded);
+
+	/** Writes the index entry of the specified chunk into the file. Returns true if successful. */
+	bool WriteIndexEntry(size_t a_Index, UInt32 a_Offset, UInt32 a_Size);
+
+	/** Appends the data to a_Out, deflate-compressed if that makes it smaller, preceded by the compression and sizes. */
+	void AppendData(ContiguousByteBuffer & a_Out, ContiguousByteBufferView a_Data);
+
+	/** Extracts the data written by AppendData() at the start of a_Data into a_Out.
+	Throws a std::runtime_error if the data is corrupt. */
+	void ExtractData(ContiguousByteBufferView a_Data, ContiguousByteBuffer & a_Out);
+
+	/** Rewrites the file if the garbage outweighs the live records. */
+	void CompactIfNeeded(void);
+
+	/** Returns the FNV-1a hash of the data. */
+	static UInt64 Hash(ContiguousByteBufferView a_Data);
+
+	/** Returns the index of the chunk within its region. */
+	static size_t GetIndex(const cChunkCoords & a_Chunk);
+};
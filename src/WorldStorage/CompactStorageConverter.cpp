@@ -0,0 +1,303 @@
+
+// CompactStorageConverter.cpp
+
+// Implements the cCompactStorageConverter class that converts the worlds between the Anvil and the compact storage
+
+#include "Globals.h"
+#include "CompactStorageConverter.h"
+#include "CompactChunkSerializer.h"
+#include "CompactRegionFile.h"
+#include "../Endianness.h"
+#include "../OSSupport/File.h"
+
+
+
+
+
+namespace
+{
+	/** The MCA files are made of 4 KiB sectors, the first two are the header. */
+	constexpr size_t MCASectorSize = 4 KiB;
+	constexpr size_t MCAHeaderSize = 2 * MCASectorSize;
+
+	/** The MCA chunk compression method that Cuberite reads and writes. */
+	constexpr Byte MCACompressionZLib = 2;
+
+
+
+
+
+	/** Replaces the file with the temporary one, on the platforms whose rename doesn't replace, too. */
+	bool ReplaceFile(const AString & a_TempFileName, const AString & a_FileName)
+	{
+		if (cFile::Rename(a_TempFileName, a_FileName))
+		{
+			return true;
+		}
+		cFile::DeleteFile(a_FileName);
+		return cFile::Rename(a_TempFileName, a_FileName);
+	}
+
+
+
+
+
+	/** Parses the region coords out of the "r.X.Z.<Extension>" file name. Returns false if the name doesn't match. */
+	bool ParseRegionFileName(const AString & a_FileName, const AString & a_Extension, int & a_RegionX, int & a_RegionZ)
+	{
+		const auto Split = StringSplit(a_FileName, ".");
+		return (
+			(Split.size() == 4) &&
+			(Split[0] == "r") &&
+			(Split[3] == a_Extension) &&
+			StringToInteger(Split[1], a_RegionX) &&
+			StringToInteger(Split[2], a_RegionZ)
+		);
+	}
+}  // namespace (anonymous)
+
+
+
+
+
+cCompactStorageConverter::cCompactStorageConverter(const int a_CompressionFactor):
+	m_Compressor(a_CompressionFactor)
+{
+}
+
+
+
+
+
+size_t cCompactStorageConverter::AnvilToCompact(const AString & a_MCAFileName, const AString & a_CompactFileName, const int a_RegionX, const int a_RegionZ)
+{
+	cRegionChunks Chunks;
+	if (!ReadMCAFile(a_MCAFileName, Chunks))
+	{
+		LOGWARNING("Cannot read file \"%s\", its chunks are not converted", a_MCAFileName);
+		return 0;
+	}
+
+	cCompactRegionFile Region(a_CompactFileName, a_RegionX, a_RegionZ, m_Compressor, m_Extractor);
+	size_t NumConverted = 0;
+	sCompactChunk Compact;
+	for (size_t i = 0; i < REGION_CHUNKS; i++)
+	{
+		if (Chunks[i].empty())
+		{
+			continue;
+		}
+		const cChunkCoords Coords(a_RegionX * 32 + static_cast<int>(i % 32), a_RegionZ * 32 + static_cast<int>(i / 32));
+		if (!cCompactChunkSerializer::AnvilToCompact(Chunks[i], Compact))
+		{
+			LOGWARNING("Chunk [%d, %d] in file \"%s\" is not a valid chunk, skipping", Coords.m_ChunkX, Coords.m_ChunkZ, a_MCAFileName);
+			continue;
+		}
+		if (Region.SetChunk(Coords, Compact))
+		{
+			NumConverted++;
+		}
+	}
+	return NumConverted;
+}
+
+
+
+
+
+size_t cCompactStorageConverter::CompactToAnvil(const AString & a_CompactFileName, const AString & a_MCAFileName, const int a_RegionX, const int a_RegionZ)
+{
+	// Keep the chunks of the MCA file that the compact file doesn't have:
+	cRegionChunks Chunks;
+	if (cFile::Exists(a_MCAFileName) && !ReadMCAFile(a_MCAFileName, Chunks))
+	{
+		LOGWARNING("Cannot read file \"%s\", the chunks of file \"%s\" are not converted", a_MCAFileName, a_CompactFileName);
+		return 0;
+	}
+	Chunks.resize(REGION_CHUNKS);
+
+	cCompactRegionFile Region(a_CompactFileName, a_RegionX, a_RegionZ, m_Compressor, m_Extractor);
+	size_t NumConverted = 0;
+	sCompactChunk Compact;
+	ContiguousByteBuffer Anvil;
+	for (size_t i = 0; i < REGION_CHUNKS; i++)
+	{
+		const cChunkCoords Coords(a_RegionX * 32 + static_cast<int>(i % 32), a_RegionZ * 32 + static_cast<int>(i / 32));
+		try
+		{
+			if (!Region.GetChunk(Coords, Compact))
+			{
+				continue;
+			}
+			if (!cCompactChunkSerializer::CompactToAnvil(Compact, Anvil))
+			{
+				throw std::runtime_error("Corrupt chunk data");
+			}
+		}
+		catch (const std::exception & Oops)
+		{
+			LOGWARNING("Cannot read chunk [%d, %d] from file \"%s\": %s; skipping", Coords.m_ChunkX, Coords.m_ChunkZ, a_CompactFileName, Oops.what());
+			continue;
+		}
+		Chunks[i] = std::move(Anvil);
+		NumConverted++;
+	}
+
+	if ((NumConverted > 0) && !WriteMCAFile(a_MCAFileName, Chunks))
+	{
+		LOGWARNING("Cannot write file \"%s\", the chunks of file \"%s\" are not converted", a_MCAFileName, a_CompactFileName);
+		return 0;
+	}
+	return NumConverted;
+}
+
+
+
+
+
+size_t cCompactStorageConverter::ConvertWorld(const AString & a_WorldFolder, const bool a_ToCompact)
+{
+	const auto AnvilFolder = fmt::format(FMT_STRING("{}{}region"), a_WorldFolder, cFile::PathSeparator());
+	const auto CompactFolder = GetCompactFolder(a_WorldFolder);
+	cFile::CreateFolder(a_ToCompact ? CompactFolder : AnvilFolder);
+
+	size_t NumConverted = 0;
+	for (const auto & FileName: cFile::GetFolderContents(a_ToCompact ? AnvilFolder : CompactFolder))
+	{
+		int RegionX, RegionZ;
+		if (!ParseRegionFileName(FileName, a_ToCompact ? "mca" : "cmr", RegionX, RegionZ))
+		{
+			continue;
+		}
+		const auto MCAFileName = fmt::format(FMT_STRING("{}{}r.{}.{}.mca"), AnvilFolder, cFile::PathSeparator(), RegionX, RegionZ);
+		const auto CompactFileName = GetCompactFileName(CompactFolder, RegionX, RegionZ);
+		const auto NumChunks = a_ToCompact ?
+			AnvilToCompact(MCAFileName, CompactFileName, RegionX, RegionZ) :
+			CompactToAnvil(CompactFileName, MCAFileName, RegionX, RegionZ);
+		LOG("Converted %zu chunks of region [%d, %d]", NumChunks, RegionX, RegionZ);
+		NumConverted += NumChunks;
+	}
+	return NumConverted;
+}
+
+
+
+
+
+bool cCompactStorageConverter::ReadMCAFile(const AString & a_FileName, cRegionChunks & a_Chunks)
+{
+	cFile File;
+	if (!File.Open(a_FileName, cFile::fmRead))
+	{
+		return false;
+	}
+	const auto FileSize = File.GetSize();
+	if (FileSize < static_cast<long>(MCAHeaderSize))
+	{
+		return false;
+	}
+	const auto Data = File.Read(static_cast<size_t>(FileSize));
+	if (Data.size() != static_cast<size_t>(FileSize))
+	{
+		return false;
+	}
+
+	a_Chunks.clear();
+	a_Chunks.resize(REGION_CHUNKS);
+	for (size_t i = 0; i < REGION_CHUNKS; i++)
+	{
+		const auto Location = NetworkBufToHost<UInt32>(Data.data() + i * 4);
+		const size_t Offset = (Location >> 8) * MCASectorSize;
+		if (Offset < MCAHeaderSize)
+		{
+			continue;
+		}
+		if (Offset + 5 > Data.size())
+		{
+			LOGWARNING("Chunk %zu of file \"%s\" is out of the file, skipping", i, a_FileName);
+			continue;
+		}
+		const size_t Size = NetworkBufToHost<UInt32>(Data.data() + Offset);
+		const auto Compression = static_cast<Byte>(Data[Offset + 4]);
+		if ((Size < 1) || (Offset + 4 + Size > Data.size()) || (Compression != MCACompressionZLib))
+		{
+			LOGWARNING("Chunk %zu of file \"%s\" is invalid or uses an unknown compression, skipping", i, a_FileName);
+			continue;
+		}
+		try
+		{
+			a_Chunks[i] = m_Extractor.ExtractZLib(ContiguousByteBufferView(Data).substr(Offset + 5, Size - 1)).GetView();
+		}
+		catch (const std::exception & Oops)
+		{
+			LOGWARNING("Chunk %zu of file \"%s\" cannot be extracted: %s; skipping", i, a_FileName, Oops.what());
+		}
+	}
+	return true;
+}
+
+
+
+
+
+bool cCompactStorageConverter::WriteMCAFile(const AString & a_FileName, const cRegionChunks & a_Chunks)
+{
+	ASSERT(a_Chunks.size() == REGION_CHUNKS);
+
+	ContiguousByteBuffer Data(MCAHeaderSize, std::byte(0));
+	const auto TimeStamp = HostToNetwork(static_cast<UInt32>(time(nullptr)));
+	for (size_t i = 0; i < REGION_CHUNKS; i++)
+	{
+		if (a_Chunks[i].empty())
+		{
+			continue;
+		}
+		const auto Compressed = m_Compressor.CompressZLib(a_Chunks[i]);
+		const auto NumSectors = (Compressed.Size + 5 + MCASectorSize - 1) / MCASectorSize;
+		if (NumSectors > 255)
+		{
+			LOGWARNING("Chunk %zu doesn't fit into file \"%s\", the data is too large (%zu KiB, maximum is 1024 KiB)", i, a_FileName, NumSectors * 4);
+			continue;
+		}
+
+		const auto Location = HostToNetwork(static_cast<UInt32>(((Data.size() / MCASectorSize) << 8) | NumSectors));
+		std::copy(Location.begin(), Location.end(), Data.begin() + static_cast<std::ptrdiff_t>(i * 4));
+		std::copy(TimeStamp.begin(), TimeStamp.end(), Data.begin() + static_cast<std::ptrdiff_t>(MCASectorSize + i * 4));
+
+		const auto Size = HostToNetwork(static_cast<UInt32>(Compressed.Size + 1));
+		Data.append(Size.begin(), Size.end());
+		Data.push_back(std::byte(MCACompressionZLib));
+		Data.append(Compressed.GetView());
+		Data.resize(Data.size() + NumSectors * MCASectorSize - (Compressed.Size + 5));  // Pad to the sector boundary
+	}
+
+	const auto TempFileName = a_FileName + ".tmp";
+	{
+		cFile File;
+		if (!File.Open(TempFileName, cFile::fmWrite) || (File.Write(Data.data(), Data.size()) != static_cast<int>(Data.size())))
+		{
+			File.Close();
+			cFile::DeleteFile(TempFileName);
+			return false;
+		}
+	}
+	return ReplaceFile(TempFileName, a_FileName);
+}
+
+
+
+
+
+AString cCompactStorageConverter::GetCompactFolder(const AString & a_WorldFolder)
+{
+	return fmt::format(FMT_STRING("{}{}compact"), a_WorldFolder, cFile::PathSeparator());
+}
+
+
+
+
+
+AString cCompactStorageConverter::GetCompactFileName(const AString & a_Folder, const int a_RegionX, const int a_RegionZ)
+{
+	return fmt::format(FMT_STRING("{}{}r.{}.{}.cmr"), a_Folder, cFile::PathSeparator(), a_RegionX, a_RegionZ);
+}
@@ -0,0 +1,63 @@
+
+// CompactStorageConverter.h
+
+// Declares the cCompactStorageConverter class that converts the worlds between the Anvil and the compact storage
+
+
+
+
+
+#pragma once
+
+#include "../StringCompression.h"
+
+
+
+
+
+/** Converts the region files between the Anvil and the compact storage, in either direction.
+The chunk NBT survives the round trip unchanged, apart from the order of the "Sections" tag within the Level.
+The converted chunks replace those of the destination file, the destination's other chunks are kept. */
+class cCompactStorageConverter
+{
+public:
+
+	/** The uncompressed NBT of the chunks in a region, indexed by LocalX + 32 * LocalZ; empty for the chunks not present. */
+	using cRegionChunks = std::vector<ContiguousByteBuffer>;
+
+	enum
+	{
+		/** The chunks in a region, same as the count of the MCA header items. */
+		REGION_CHUNKS = 32 * 32,
+	};
+
+
+	cCompactStorageConverter(int a_CompressionFactor = 6);
+
+	/** Converts the chunks of the Anvil region file into the compact region file. Returns the number of the chunks converted. */
+	size_t AnvilToCompact(const AString & a_MCAFileName, const AString & a_CompactFileName, int a_RegionX, int a_RegionZ);
+
+	/** Converts the chunks of the compact region file into the Anvil region file. Returns the number of the chunks converted. */
+	size_t CompactToAnvil(const AString & a_CompactFileName, const AString & a_MCAFileName, int a_RegionX, int a_RegionZ);
+
+	/** Converts all the region files of the world, from its "region" folder into its "compact" folder, or back.
+	Returns the number of the chunks converted. */
+	size_t ConvertWorld(const AString & a_WorldFolder, bool a_ToCompact);
+
+	/** Reads all the chunks of the MCA file into a_Chunks. Returns false if the file cannot be read. */
+	bool ReadMCAFile(const AString & a_FileName, cRegionChunks & a_Chunks);
+
+	/** Writes the chunks into the MCA file, replacing the file. Returns true if successful. */
+	bool WriteMCAFile(const AString & a_FileName, const cRegionChunks & a_Chunks);
+
+	/** Returns the name of the folder within the world folder that keeps the compact region files. */
+	static AString GetCompactFolder(const AString & a_WorldFolder);
+
+	/** Returns the name of the compact region file within the folder. */
+	static AString GetCompactFileName(const AString & a_Folder, int a_RegionX, int a_RegionZ);
+
+protected:
+
+	Compression::Compressor m_Compressor;
+	Compression::Extractor m_Extractor;
+};
@@ -672,6 +672,60 @@ void cFastNBTWriter::AddIntArray(const AString & a_Name, const Int32 * a_Value,
 
 
 
+void cFastNBTWriter::CopyTag(const cParsedNBT & a_NBT, const int a_Tag)
+{
+	const auto Name = a_NBT.GetName(a_Tag);
+	switch (a_NBT.GetType(a_Tag))
+	{
+		case TAG_Byte:      AddByte     (Name, a_NBT.GetByte(a_Tag));       return;
+		case TAG_Short:     AddShort    (Name, a_NBT.GetShort(a_Tag));      return;
+		case TAG_Int:       AddInt      (Name, a_NBT.GetInt(a_Tag));        return;
+		case TAG_Long:      AddLong     (Name, a_NBT.GetLong(a_Tag));       return;
+		case TAG_Float:     AddFloat    (Name, a_NBT.GetFloat(a_Tag));      return;
+		case TAG_Double:    AddDouble   (Name, a_NBT.GetDouble(a_Tag));     return;
+		case TAG_String:    AddString   (Name, a_NBT.GetStringView(a_Tag)); return;
+		case TAG_ByteArray: AddByteArray(Name, reinterpret_cast<const char *>(a_NBT.GetData(a_Tag)), a_NBT.GetDataLength(a_Tag)); return;
+		case TAG_IntArray:
+		{
+			// The parsed data is in the network byte order already, copy it as-is:
+			TagCommon(Name, TAG_IntArray);
+			const auto Length = HostToNetwork(static_cast<UInt32>(a_NBT.GetDataLength(a_Tag) / 4));
+			m_Result.append(Length.begin(), Length.end());
+			m_Result.append(a_NBT.GetData(a_Tag), a_NBT.GetDataLength(a_Tag));
+			return;
+		}
+		case TAG_List:
+		{
+			BeginList(Name, a_NBT.GetChildrenType(a_Tag));
+			for (int Child = a_NBT.GetFirstChild(a_Tag); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+			{
+				CopyTag(a_NBT, Child);
+			}
+			EndList();
+			return;
+		}
+		case TAG_Compound:
+		{
+			BeginCompound(Name);
+			for (int Child = a_NBT.GetFirstChild(a_Tag); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+			{
+				CopyTag(a_NBT, Child);
+			}
+			EndCompound();
+			return;
+		}
+		case TAG_End:
+		{
+			return;
+		}
+	}
+	UNREACHABLE("Unsupported nbt tag type");
+}
+
+
+
+
+
 void cFastNBTWriter::Finish(void)
 {
 	ASSERT(m_CurrentStack == 0);
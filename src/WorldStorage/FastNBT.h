@@ -345,6 +345,10 @@ public:
 		AddByteArray(a_Name, a_Value.data(), a_Value.size());
 	}
 
+	/** Copies the tag, with its name and all its children, from the parsed NBT.
+	The empty lists are written with the TAG_End children type, cParsedNBT doesn't keep the type of those. */
+	void CopyTag(const cParsedNBT & a_NBT, int a_Tag);
+
 	ContiguousByteBufferView GetResult(void) const { return m_Result; }
 
 	void Finish(void);
@@ -1189,8 +1189,13 @@ public:
 ////////////////////////////////////////////////////////////////////////////////
 // NBTChunkSerializer:
 
-void NBTChunkSerializer::Serialize(const cWorld & aWorld, cChunkCoords aCoords, cFastNBTWriter & aWriter)
+void NBTChunkSerializer::Serialize(
+	const cWorld & aWorld, cChunkCoords aCoords, cFastNBTWriter & aWriter,
+	ChunkBlockData * aBlockData, ChunkLightData * aLightData
+)
 {
+	ASSERT((aBlockData == nullptr) == (aLightData == nullptr));
+
 	SerializerCollector serializer(aWriter);
 	aWriter.BeginCompound("Level");
 	aWriter.AddInt("xPos", aCoords.m_ChunkX);
@@ -1205,52 +1210,60 @@ void NBTChunkSerializer::Serialize(const cWorld & aWorld, cChunkCoords aCoords,
 	// Save heightmap (Vanilla require this):
 	aWriter.AddIntArray("HeightMap", reinterpret_cast<const int *>(serializer.Heights), ARRAYCOUNT(serializer.Heights));
 
-	// Save blockdata:
-	aWriter.BeginList("Sections", TAG_Compound);
-	ChunkDef_ForEachSection(serializer.m_BlockData, serializer.m_LightData,
+	// Save blockdata, or hand it over to the caller:
+	if (aBlockData != nullptr)
 	{
-		aWriter.BeginCompound("");
-
-		if (Blocks != nullptr)
-		{
-			aWriter.AddByteArray("Blocks", reinterpret_cast<const char *>(Blocks->data()), Blocks->size());
-		}
-		else
+		aBlockData->Assign(serializer.m_BlockData);
+		aLightData->Assign(serializer.m_LightData);
+	}
+	else
+	{
+		aWriter.BeginList("Sections", TAG_Compound);
+		ChunkDef_ForEachSection(serializer.m_BlockData, serializer.m_LightData,
 		{
-			aWriter.AddByteArray("Blocks", ChunkBlockData::SectionBlockCount, ChunkBlockData::DefaultValue);
-		}
+			aWriter.BeginCompound("");
 
-		if (Metas != nullptr)
-		{
-			aWriter.AddByteArray("Data", reinterpret_cast<const char *>(Metas->data()), Metas->size());
-		}
-		else
-		{
-			aWriter.AddByteArray("Data", ChunkBlockData::SectionMetaCount, ChunkBlockData::DefaultMetaValue);
-		}
+			if (Blocks != nullptr)
+			{
+				aWriter.AddByteArray("Blocks", reinterpret_cast<const char *>(Blocks->data()), Blocks->size());
+			}
+			else
+			{
+				aWriter.AddByteArray("Blocks", ChunkBlockData::SectionBlockCount, ChunkBlockData::DefaultValue);
+			}
 
-		if (BlockLights != nullptr)
-		{
-			aWriter.AddByteArray("BlockLight", reinterpret_cast<const char *>(BlockLights->data()), BlockLights->size());
-		}
-		else
-		{
-			aWriter.AddByteArray("BlockLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultBlockLightValue);
-		}
+			if (Metas != nullptr)
+			{
+				aWriter.AddByteArray("Data", reinterpret_cast<const char *>(Metas->data()), Metas->size());
+			}
+			else
+			{
+				aWriter.AddByteArray("Data", ChunkBlockData::SectionMetaCount, ChunkBlockData::DefaultMetaValue);
+			}
 
-		if (SkyLights != nullptr)
-		{
-			aWriter.AddByteArray("SkyLight", reinterpret_cast<const char *>(SkyLights->data()), SkyLights->size());
-		}
-		else
-		{
-			aWriter.AddByteArray("SkyLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue);
-		}
+			if (BlockLights != nullptr)
+			{
+				aWriter.AddByteArray("BlockLight", reinterpret_cast<const char *>(BlockLights->data()), BlockLights->size());
+			}
+			else
+			{
+				aWriter.AddByteArray("BlockLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultBlockLightValue);
+			}
 
-		aWriter.AddByte("Y", static_cast<unsigned char>(Y));
-		aWriter.EndCompound();
-	});
-	aWriter.EndList();  // "Sections"
+			if (SkyLights != nullptr)
+			{
+				aWriter.AddByteArray("SkyLight", reinterpret_cast<const char *>(SkyLights->data()), SkyLights->size());
+			}
+			else
+			{
+				aWriter.AddByteArray("SkyLight", ChunkLightData::SectionLightCount, ChunkLightData::DefaultSkyLightValue);
+			}
+
+			aWriter.AddByte("Y", static_cast<unsigned char>(Y));
+			aWriter.EndCompound();
+		});
+		aWriter.EndList();  // "Sections"
+	}
 
 	// Store the information that the lighting is valid.
 	// For compatibility reason, the default is "invalid" (missing) - this means older data is re-lighted upon loading.
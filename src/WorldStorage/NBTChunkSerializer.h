@@ -9,6 +9,8 @@
 // fwd:
 class cFastNBTWriter;
 class cWorld;
+class ChunkBlockData;
+class ChunkLightData;
 
 
 
@@ -21,6 +23,11 @@ class NBTChunkSerializer
 {
 public:
 
-	/** Serializes the chunk into the specified writer. The chunk must be present. */
-	static void Serialize(const cWorld & aWorld, cChunkCoords aCoords, cFastNBTWriter & aWriter);
+	/** Serializes the chunk into the specified writer. The chunk must be present.
+	If aBlockData and aLightData are given, the chunk's blocks and light are copied into them instead of being written
+	as the "Sections" tag, for the storages that keep them in their own format. */
+	static void Serialize(
+		const cWorld & aWorld, cChunkCoords aCoords, cFastNBTWriter & aWriter,
+		ChunkBlockData * aBlockData = nullptr, ChunkLightData * aLightData = nullptr
+	);
 };
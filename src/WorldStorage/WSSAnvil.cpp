@@ -192,8 +192,8 @@ void cWSSAnvil::ChunkLoadFailed(const cChunkCoords a_ChunkCoords, const AString
 	const int RegionX = FAST_FLOOR_DIV(a_ChunkCoords.m_ChunkX, 32);
 	const int RegionZ = FAST_FLOOR_DIV(a_ChunkCoords.m_ChunkZ, 32);
 	auto Info = fmt::format(
-		FMT_STRING("Loading chunk {} for world {} from file r.{}.{}.mca failed: {} Offloading old chunk data to file {} and regenerating chunk."),
-		a_ChunkCoords, m_World->GetName(), RegionX, RegionZ, a_Reason, OffloadFileName
+		FMT_STRING("Loading chunk {} for world {} from file {} failed: {} Offloading old chunk data to file {} and regenerating chunk."),
+		a_ChunkCoords, m_World->GetName(), GetRegionFileName(RegionX, RegionZ), a_Reason, OffloadFileName
 	);
 	LOGWARNING("%s", Info);
 
@@ -221,6 +221,15 @@ void cWSSAnvil::ChunkLoadFailed(const cChunkCoords a_ChunkCoords, const AString
 
 
 
+AString cWSSAnvil::GetRegionFileName(const int a_RegionX, const int a_RegionZ) const
+{
+	return fmt::format(FMT_STRING("r.{}.{}.mca"), a_RegionX, a_RegionZ);
+}
+
+
+
+
+
 bool cWSSAnvil::GetChunkData(const cChunkCoords & a_Chunk, ContiguousByteBuffer & a_Data)
 {
 	cCSLock Lock(m_CS);
@@ -345,8 +354,8 @@ Compression::Result cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk)
 bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT & a_NBT, const ContiguousByteBufferView a_RawChunkData)
 {
 	struct SetChunkData Data(a_Chunk);
+	Data.SetMemoryAccount(m_World->GetChunkMap()->GetMemoryAccount());
 
-	// Load the blockdata, blocklight and skylight:
 	int Level = a_NBT.FindChildByName(0, "Level");
 	if (Level < 0)
 	{
@@ -354,17 +363,31 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 		return false;
 	}
 
-	int Sections = a_NBT.FindChildByName(Level, "Sections");
+	// Load the blockdata, blocklight and skylight, then the rest:
+	if (!LoadSectionsFromNBT(Data, a_NBT, Level, a_RawChunkData))
+	{
+		return false;
+	}
+	return LoadLevelFromNBT(std::move(Data), a_NBT, Level, a_RawChunkData);
+}
+
+
+
+
+
+bool cWSSAnvil::LoadSectionsFromNBT(struct SetChunkData & a_Data, const cParsedNBT & a_NBT, const int a_Level, const ContiguousByteBufferView a_RawChunkData)
+{
+	int Sections = a_NBT.FindChildByName(a_Level, "Sections");
 	if ((Sections < 0) || (a_NBT.GetType(Sections) != TAG_List))
 	{
-		ChunkLoadFailed(a_Chunk, "Missing NBT tag: Sections", a_RawChunkData);
+		ChunkLoadFailed(a_Data.Chunk, "Missing NBT tag: Sections", a_RawChunkData);
 		return false;
 	}
 
 	eTagType SectionsType = a_NBT.GetChildrenType(Sections);
 	if ((SectionsType != TAG_Compound) && (SectionsType != TAG_End))
 	{
-		ChunkLoadFailed(a_Chunk, "NBT tag has wrong type: Sections", a_RawChunkData);
+		ChunkLoadFailed(a_Data.Chunk, "NBT tag has wrong type: Sections", a_RawChunkData);
 		return false;
 	}
 	for (int Child = a_NBT.GetFirstChild(Sections); Child >= 0; Child = a_NBT.GetNextSibling(Child))
@@ -372,14 +395,14 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 		const int SectionYTag = a_NBT.FindChildByName(Child, "Y");
 		if ((SectionYTag < 0) || (a_NBT.GetType(SectionYTag) != TAG_Byte))
 		{
-			ChunkLoadFailed(a_Chunk, "NBT tag missing or has wrong: Y", a_RawChunkData);
+			ChunkLoadFailed(a_Data.Chunk, "NBT tag missing or has wrong: Y", a_RawChunkData);
 			return false;
 		}
 
 		const int Y = a_NBT.GetByte(SectionYTag);
 		if ((Y < 0) || (Y > static_cast<int>(cChunkDef::NumSections - 1)))
 		{
-			ChunkLoadFailed(a_Chunk, "NBT tag exceeds chunk bounds: Y", a_RawChunkData);
+			ChunkLoadFailed(a_Data.Chunk, "NBT tag exceeds chunk bounds: Y", a_RawChunkData);
 			return false;
 		}
 
@@ -390,34 +413,43 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 			SkyLightData = GetSectionData(a_NBT, Child, "SkyLight", ChunkLightData::SectionLightCount);
 		if ((BlockData != nullptr) && (MetaData != nullptr) && (SkyLightData != nullptr) && (BlockLightData != nullptr))
 		{
-			Data.BlockData.SetSection(*reinterpret_cast<const ChunkBlockData::SectionType *>(BlockData), *reinterpret_cast<const ChunkBlockData::SectionMetaType *>(MetaData), static_cast<size_t>(Y));
-			Data.LightData.SetSection(*reinterpret_cast<const ChunkLightData::SectionType *>(BlockLightData), *reinterpret_cast<const ChunkLightData::SectionType *>(SkyLightData), static_cast<size_t>(Y));
+			a_Data.BlockData.SetSection(*reinterpret_cast<const ChunkBlockData::SectionType *>(BlockData), *reinterpret_cast<const ChunkBlockData::SectionMetaType *>(MetaData), static_cast<size_t>(Y));
+			a_Data.LightData.SetSection(*reinterpret_cast<const ChunkLightData::SectionType *>(BlockLightData), *reinterpret_cast<const ChunkLightData::SectionType *>(SkyLightData), static_cast<size_t>(Y));
 		}
 		else
 		{
-			ChunkLoadFailed(a_Chunk, "Missing chunk block/light data", a_RawChunkData);
+			ChunkLoadFailed(a_Data.Chunk, "Missing chunk block/light data", a_RawChunkData);
 			return false;
 		}
 	}  // for itr - LevelSections[]
 
+	return true;
+}
+
+
+
+
+
+bool cWSSAnvil::LoadLevelFromNBT(struct SetChunkData && a_Data, const cParsedNBT & a_NBT, const int a_Level, const ContiguousByteBufferView a_RawChunkData)
+{
 	// Load the biomes from NBT, if present and valid:
-	if (!LoadBiomeMapFromNBT(Data.BiomeMap, a_NBT, a_NBT.FindChildByName(Level, "Biomes")))
+	if (!LoadBiomeMapFromNBT(a_Data.BiomeMap, a_NBT, a_NBT.FindChildByName(a_Level, "Biomes")))
 	{
-		ChunkLoadFailed(a_Chunk, "Missing chunk biome data", a_RawChunkData);
+		ChunkLoadFailed(a_Data.Chunk, "Missing chunk biome data", a_RawChunkData);
 		return false;
 	}
 
 	// Load the Height map, if it fails, recalculate it:
-	if (!LoadHeightMapFromNBT(Data.HeightMap, a_NBT, a_NBT.FindChildByName(Level, "HeightMap")))
+	if (!LoadHeightMapFromNBT(a_Data.HeightMap, a_NBT, a_NBT.FindChildByName(a_Level, "HeightMap")))
 	{
-		Data.UpdateHeightMap();
+		a_Data.UpdateHeightMap();
 	}
 
 	// Load the entities from NBT:
-	LoadEntitiesFromNBT     (Data.Entities,      a_NBT, a_NBT.FindChildByName(Level, "Entities"));
-	LoadBlockEntitiesFromNBT(Data.BlockEntities, a_NBT, a_NBT.FindChildByName(Level, "TileEntities"), Data.BlockData);
+	LoadEntitiesFromNBT     (a_Data.Entities,      a_NBT, a_NBT.FindChildByName(a_Level, "Entities"));
+	LoadBlockEntitiesFromNBT(a_Data.BlockEntities, a_NBT, a_NBT.FindChildByName(a_Level, "TileEntities"), a_Data.BlockData);
 
-	Data.IsLightValid = (a_NBT.FindChildByName(Level, "MCSIsLightValid") > 0);
+	a_Data.IsLightValid = (a_NBT.FindChildByName(a_Level, "MCSIsLightValid") > 0);
 
 	/*
 	// Uncomment this block for really cool stuff :)
@@ -455,7 +487,7 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 	}  // for y
 	//*/
 
-	m_World->QueueSetChunkData(std::move(Data));
+	m_World->QueueSetChunkData(std::move(a_Data));
 	return true;
 }
 
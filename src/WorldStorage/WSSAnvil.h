@@ -17,6 +17,7 @@ class cProjectileEntity;
 class cHangingEntity;
 class cUUID;
 class ChunkBlockData;
+struct SetChunkData;
 
 
 
@@ -116,6 +117,17 @@ protected:
 	a_RawChunkData is the raw (compressed) chunk data, used for offloading when chunk loading fails. */
 	bool LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT & a_NBT, ContiguousByteBufferView a_RawChunkData);
 
+	/** Loads the blockdata, blocklight and skylight from the Level\\Sections tag into a_Data.
+	Reports the failure through ChunkLoadFailed(), offloading a_RawChunkData. */
+	bool LoadSectionsFromNBT(struct SetChunkData & a_Data, const cParsedNBT & a_NBT, int a_Level, ContiguousByteBufferView a_RawChunkData);
+
+	/** Loads the rest of the chunk from the Level tag into a_Data, and queues the chunk into the world.
+	Reports the failure through ChunkLoadFailed(), offloading a_RawChunkData. */
+	bool LoadLevelFromNBT(struct SetChunkData && a_Data, const cParsedNBT & a_NBT, int a_Level, ContiguousByteBufferView a_RawChunkData);
+
+	/** Returns the name of the file that stores the region, as reported when a chunk fails to load. */
+	virtual AString GetRegionFileName(int a_RegionX, int a_RegionZ) const;
+
 	/** Loads the chunk's biome map into a_BiomeMap if biomes present and valid; returns false otherwise. */
 	bool LoadBiomeMapFromNBT(cChunkDef::BiomeMap & a_BiomeMap, const cParsedNBT & a_NBT, int a_TagIdx);
 
@@ -0,0 +1,209 @@
+
+// WSSCompact.cpp
+
+// Implements the cWSSCompact class implementing the compact world storage schema
+
+#include "Globals.h"
+#include "WSSCompact.h"
+#include "CompactChunkSerializer.h"
+#include "CompactRegionFile.h"
+#include "CompactStorageConverter.h"
+#include "NBTChunkSerializer.h"
+#include "../ChunkMap.h"
+#include "../SetChunkData.h"
+#include "../World.h"
+
+
+
+
+
+/** Maximum number of region files that are cached in memory.
+Each file keeps its index and section maps in the memory, and means an OS FS handle. */
+#define MAX_REGION_FILES 32
+
+
+
+
+
+cWSSCompact::cWSSCompact(cWorld * a_World, int a_CompressionFactor):
+	Super(a_World, a_CompressionFactor),
+	m_Folder(cCompactStorageConverter::GetCompactFolder(a_World->GetDataPath())),
+	m_HasFolder(cFile::IsFolder(m_Folder))
+{
+}
+
+
+
+
+
+cWSSCompact::~cWSSCompact()
+{
+	cCSLock Lock(m_CSRegions);
+	m_Regions.clear();
+}
+
+
+
+
+
+std::shared_ptr<cCompactRegionFile> cWSSCompact::LoadRegionFile(const cChunkCoords & a_Chunk)
+{
+	// ASSUME m_CSRegions is locked
+	ASSERT(m_CSRegions.IsLocked());
+
+	const int RegionX = FAST_FLOOR_DIV(a_Chunk.m_ChunkX, 32);
+	const int RegionZ = FAST_FLOOR_DIV(a_Chunk.m_ChunkZ, 32);
+
+	// Is it already cached?
+	for (auto itr = m_Regions.begin(); itr != m_Regions.end(); ++itr)
+	{
+		if (((*itr)->GetRegionX() == RegionX) && ((*itr)->GetRegionZ() == RegionZ))
+		{
+			// Move the file to front and return it:
+			auto f = *itr;
+			if (itr != m_Regions.begin())
+			{
+				m_Regions.erase(itr);
+				m_Regions.push_front(f);
+			}
+			return f;
+		}
+	}
+
+	// Load it anew:
+	auto f = std::make_shared<cCompactRegionFile>(
+		cCompactStorageConverter::GetCompactFileName(m_Folder, RegionX, RegionZ), RegionX, RegionZ, m_Compressor, m_Extractor
+	);
+	m_Regions.push_front(f);
+
+	// If there are too many region files cached, delete the last one used:
+	if (m_Regions.size() > MAX_REGION_FILES)
+	{
+		m_Regions.pop_back();
+	}
+	return f;
+}
+
+
+
+
+
+AString cWSSCompact::GetRegionFileName(const int a_RegionX, const int a_RegionZ) const
+{
+	return fmt::format(FMT_STRING("compact{}r.{}.{}.cmr"), cFile::PathSeparator(), a_RegionX, a_RegionZ);
+}
+
+
+
+
+
+bool cWSSCompact::LoadChunk(const cChunkCoords & a_Chunk)
+{
+	sCompactChunk Chunk;
+	try
+	{
+		cCSLock Lock(m_CSRegions);
+		if (!m_HasFolder || !LoadRegionFile(a_Chunk)->GetChunk(a_Chunk, Chunk))
+		{
+			// Not in this storage
+			return false;
+		}
+	}
+	catch (const std::exception & Oops)
+	{
+		ChunkLoadFailed(a_Chunk, Oops.what(), {});
+		return false;
+	}
+
+	struct SetChunkData Data(a_Chunk);
+	Data.SetMemoryAccount(m_World->GetChunkMap()->GetMemoryAccount());
+
+	// Load the blockdata, blocklight and skylight:
+	ChunkBlockData::SectionType Blocks;
+	ChunkBlockData::SectionMetaType Metas;
+	ChunkLightData::SectionType BlockLight, SkyLight;
+	for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+	{
+		if (Chunk.m_Sections[Y].empty())
+		{
+			continue;
+		}
+		if (!cCompactChunkSerializer::DecodeSection(Chunk.m_Sections[Y], Blocks, Metas, BlockLight, SkyLight))
+		{
+			ChunkLoadFailed(a_Chunk, fmt::format(FMT_STRING("Corrupt section {}."), Y), Chunk.m_Extras);
+			return false;
+		}
+		Data.BlockData.SetSection(Blocks, Metas, Y);
+		Data.LightData.SetSection(BlockLight, SkyLight, Y);
+	}
+
+	// Load the rest from the NBT, same as Anvil:
+	const cParsedNBT NBT(Chunk.m_Extras);
+	if (!NBT.IsValid())
+	{
+		ChunkLoadFailed(a_Chunk, fmt::format("NBT parsing failed. {} at position {}.", NBT.GetErrorCode().message(), NBT.GetErrorPos()), Chunk.m_Extras);
+		return false;
+	}
+	const int Level = NBT.FindChildByName(0, "Level");
+	if (Level < 0)
+	{
+		ChunkLoadFailed(a_Chunk, "Missing NBT tag: Level", Chunk.m_Extras);
+		return false;
+	}
+
+	// The chunks converted from Anvil whose sections didn't fit the binary form keep them in the NBT:
+	if ((NBT.FindChildByName(Level, "Sections") >= 0) && !LoadSectionsFromNBT(Data, NBT, Level, Chunk.m_Extras))
+	{
+		return false;
+	}
+	return LoadLevelFromNBT(std::move(Data), NBT, Level, Chunk.m_Extras);
+}
+
+
+
+
+
+bool cWSSCompact::SaveChunk(const cChunkCoords & a_Chunk)
+{
+	try
+	{
+		cFastNBTWriter Writer;
+		ChunkBlockData BlockData;
+		ChunkLightData LightData;
+		NBTChunkSerializer::Serialize(*m_World, a_Chunk, Writer, &BlockData, &LightData);
+		Writer.Finish();
+
+		sCompactChunk Chunk;
+		Chunk.m_Extras = Writer.GetResult();
+		ChunkDef_ForEachSection(BlockData, LightData,
+		{
+			cCompactChunkSerializer::EncodeSection(
+				Chunk.m_Sections[Y],
+				(Blocks == nullptr) ? nullptr : Blocks->data(),
+				(Metas == nullptr) ? nullptr : Metas->data(),
+				(BlockLights == nullptr) ? nullptr : BlockLights->data(),
+				(SkyLights == nullptr) ? nullptr : SkyLights->data()
+			);
+		});
+
+		cCSLock Lock(m_CSRegions);
+		if (!m_HasFolder)
+		{
+			cFile::CreateFolder(m_Folder);
+			m_HasFolder = true;
+		}
+		if (!LoadRegionFile(a_Chunk)->SetChunk(a_Chunk, Chunk))
+		{
+			LOGWARNING("Cannot store chunk [%d, %d] data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+			return false;
+		}
+	}
+	catch (const std::exception & Oops)
+	{
+		LOGWARNING("Cannot serialize chunk [%d, %d] into data: %s", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, Oops.what());
+		return false;
+	}
+
+	// Everything successful
+	return true;
+}
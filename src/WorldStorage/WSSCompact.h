@@ -0,0 +1,65 @@
+
+// WSSCompact.h
+
+// Declares the cWSSCompact class implementing the compact world storage schema
+
+
+
+
+
+#pragma once
+
+#include "WSSAnvil.h"
+
+
+
+
+
+// fwd:
+class cCompactRegionFile;
+
+
+
+
+
+/** Implements the compact world storage schema: the blocks and light are palette-encoded per section, deflate-compressed
+and shared between the identical sections of a region, see cCompactRegionFile. The rest of the chunk is kept as the
+same NBT as the Anvil schema writes, so the entities and block entities load through the Anvil code.
+The region files are in the world's "compact" folder; cCompactStorageConverter converts the worlds from and to Anvil. */
+class cWSSCompact:
+	public cWSSAnvil
+{
+	using Super = cWSSAnvil;
+
+public:
+
+	cWSSCompact(cWorld * a_World, int a_CompressionFactor);
+	virtual ~cWSSCompact() override;
+
+protected:
+
+	/** The world's folder of the compact region files. */
+	const AString m_Folder;
+
+	/** Protects m_Regions and m_HasFolder against multithreaded access. */
+	cCriticalSection m_CSRegions;
+
+	/** True once m_Folder exists. The folder is only created by saving a chunk; until then, no chunk is looked up. */
+	bool m_HasFolder;
+
+	/** A MRU cache of the region files.
+	Protected against multithreaded access by m_CSRegions. */
+	std::list<std::shared_ptr<cCompactRegionFile>> m_Regions;
+
+
+	/** Gets the region file either from the cache or from the disk, manages the m_Regions cache; assumes m_CSRegions is locked. */
+	std::shared_ptr<cCompactRegionFile> LoadRegionFile(const cChunkCoords & a_Chunk);
+
+	// cWSSAnvil overrides:
+	virtual AString GetRegionFileName(int a_RegionX, int a_RegionZ) const override;
+
+	// cWSSchema overrides:
+	virtual bool LoadChunk(const cChunkCoords & a_Chunk) override;
+	virtual bool SaveChunk(const cChunkCoords & a_Chunk) override;
+	virtual const AString GetName() const override { return "compact"; }
+};
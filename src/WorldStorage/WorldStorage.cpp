@@ -8,10 +8,13 @@
 #include "Globals.h"
 #include "WorldStorage.h"
 #include "WSSAnvil.h"
+#include "WSSCompact.h"
+#include "CompactStorageConverter.h"
 #include "../World.h"
 #include "../Generating/ChunkGenerator.h"
 #include "../Entities/Entity.h"
 #include "../BlockEntities/BlockEntity.h"
+#include "../Profiler.h"
 
 
 
@@ -166,8 +169,42 @@ void cWorldStorage::QueueSaveChunk(int a_ChunkX, int a_ChunkZ)
 
 void cWorldStorage::InitSchemas(int a_StorageCompressionFactor)
 {
+	// A world switched back from the compact storage has its newer chunks in the compact folder, the Anvil files are stale.
+	// Convert the chunks back and move the folder aside, so that the stale Anvil copies are never loaded:
+	const auto CompactFolder = cCompactStorageConverter::GetCompactFolder(m_World->GetDataPath());
+	if ((NoCaseCompare(m_StorageSchemaName, "compact") != 0) && cFile::IsFolder(CompactFolder))
+	{
+		LOG("World \"%s\" no longer uses the compact storage, converting its chunks back to Anvil...", m_World->GetName());
+		const auto NumConverted = cCompactStorageConverter(a_StorageCompressionFactor).ConvertWorld(m_World->GetDataPath(), false);
+		auto ConvertedFolder = CompactFolder + ".converted";
+		for (int i = 2; cFile::Exists(ConvertedFolder); i++)
+		{
+			ConvertedFolder = fmt::format(FMT_STRING("{}.converted{}"), CompactFolder, i);
+		}
+		if (cFile::Rename(CompactFolder, ConvertedFolder))
+		{
+			LOG("Converted %zu chunks of world \"%s\" back to Anvil, the compact files are kept in \"%s\"",
+				NumConverted, m_World->GetName(), ConvertedFolder
+			);
+		}
+		else
+		{
+			// The conversion would run again on the next start and overwrite the newer Anvil chunks, keep the compact storage instead:
+			LOGERROR("Cannot rename folder \"%s\" to \"%s\", world \"%s\" keeps using the compact storage",
+				CompactFolder, ConvertedFolder, m_World->GetName()
+			);
+			m_StorageSchemaName = "compact";
+		}
+	}
+
 	// The first schema added is considered the default
 	m_Schemas.push_back(new cWSSAnvil    (m_World, a_StorageCompressionFactor));
+
+	// Every chunk not found by the save schema is looked up in the others; only look in the compact storage if it's used:
+	if (NoCaseCompare(m_StorageSchemaName, "compact") == 0)
+	{
+		m_Schemas.push_back(new cWSSCompact(m_World, a_StorageCompressionFactor));
+	}
 	m_Schemas.push_back(new cWSSForgetful(m_World));
 	// Add new schemas here
 
@@ -202,6 +239,8 @@ void cWorldStorage::InitSchemas(int a_StorageCompressionFactor)
 
 void cWorldStorage::Execute(void)
 {
+	cProfiler::SetCurrentThreadName("World Storage");
+
 	while (!m_ShouldTerminate)
 	{
 		m_Event.Wait();
@@ -257,6 +296,7 @@ bool cWorldStorage::SaveOneChunk(void)
 	// Save the chunk, if it's valid:
 	if (m_World->IsChunkValid(ToSave.m_ChunkX, ToSave.m_ChunkZ))
 	{
+		cProfileScope Profile("cWorldStorage::SaveChunk");
 		m_World->MarkChunkSaving(ToSave.m_ChunkX, ToSave.m_ChunkZ);
 		if (m_SaveSchema->SaveChunk(cChunkCoords(ToSave.m_ChunkX, ToSave.m_ChunkZ)))
 		{
@@ -274,6 +314,7 @@ bool cWorldStorage::SaveOneChunk(void)
 bool cWorldStorage::LoadChunk(int a_ChunkX, int a_ChunkZ)
 {
 	ASSERT(m_World->IsChunkQueued(a_ChunkX, a_ChunkZ));
+	cProfileScope Profile("cWorldStorage::LoadChunk");
 
 	cChunkCoords Coords(a_ChunkX, a_ChunkZ);
 
@@ -3,6 +3,7 @@
 
 #include "main.h"
 #include "BuildInfo.h"
+#include "IniFile.h"
 #include "Logger.h"
 #include "MemorySettingsRepository.h"
 #include "Root.h"
@@ -112,6 +113,22 @@ static void ParseArguments(int argc, char ** argv, cMemorySettingsRepository & a
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// GetNumNetworkEventLoops - Read the network settings needed before cRoot starts
+
+/** Returns the number of LibEvent loops set in the [Network] section of the settings file, 0 for the default.
+The network is started before cRoot reads the rest of the settings, so the value is read from the file here. */
+static size_t GetNumNetworkEventLoops(cSettingsRepositoryInterface & a_Overrides)
+{
+	cIniFile IniFile;
+	IniFile.ReadFile(a_Overrides.GetValue("Server", "ConfigFile", "settings.ini"));
+	return static_cast<size_t>(std::max(IniFile.GetValueI("Network", "EventLoops", 0), 0));
+}
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // UniversalMain - Main startup logic for both standard running and as a service
 
@@ -170,10 +187,10 @@ static int UniversalMain(int argc, char * argv[], const bool a_RunningAsService)
 		{
 			const struct NetworkRAII
 			{
-				NetworkRAII()
+				NetworkRAII(cSettingsRepositoryInterface & a_Settings)
 				{
 					// Initialize LibEvent:
-					cNetworkSingleton::Get().Initialise();
+					cNetworkSingleton::Get().Initialise(GetNumNetworkEventLoops(a_Settings));
 				}
 
 				~NetworkRAII()
@@ -181,7 +198,7 @@ static int UniversalMain(int argc, char * argv[], const bool a_RunningAsService)
 					// Shutdown all of LibEvent:
 					cNetworkSingleton::Get().Terminate();
 				}
-			} LibEvent;
+			} LibEvent(Settings);
 
 			cRoot Root;
 			if (!Root.Run(Settings))
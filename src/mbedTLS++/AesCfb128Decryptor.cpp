@@ -11,6 +11,7 @@
 
 
 cAesCfb128Decryptor::cAesCfb128Decryptor(void) :
+	m_IsAesNi(false),
 	m_IsValid(false)
 {
 #if PLATFORM_CRYPTOGRAPHY && defined(_WIN32)
@@ -45,6 +46,15 @@ void cAesCfb128Decryptor::Init(const Byte a_Key[16], const Byte a_IV[16])
 {
 	ASSERT(!IsValid());  // Cannot Init twice
 
+	if (cAesNiCfb8::IsSupported())
+	{
+		// The AES-NI implementation decrypts several bytes in parallel, prefer it over anything else:
+		m_AesNi.Init(a_Key, a_IV);
+		m_IsAesNi = true;
+		m_IsValid = true;
+		return;
+	}
+
 #if PLATFORM_CRYPTOGRAPHY && defined(_WIN32)
 	struct Key
 	{
@@ -77,6 +87,12 @@ void cAesCfb128Decryptor::ProcessData(std::byte * const a_EncryptedIn, const siz
 {
 	ASSERT(IsValid());  // Must Init() first
 
+	if (m_IsAesNi)
+	{
+		m_AesNi.Decrypt(a_EncryptedIn, a_Length);
+		return;
+	}
+
 #if PLATFORM_CRYPTOGRAPHY && defined(_WIN32)
 	ASSERT(a_Length <= std::numeric_limits<DWORD>::max());
 
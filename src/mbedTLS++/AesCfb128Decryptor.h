@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "AesNiCfb8.h"
+
 #if PLATFORM_CRYPTOGRAPHY && defined(_WIN32)
 #include <wincrypt.h>
 #else
@@ -48,6 +50,12 @@ protected:
 	/** The InitialVector, used by the CFB mode decryption */
 	Byte m_IV[16];
 
+	/** The AES-NI implementation, used instead of m_Aes when the CPU supports it. */
+	cAesNiCfb8 m_AesNi;
+
+	/** Indicates whether m_AesNi is used for the decryption. */
+	bool m_IsAesNi;
+
 	/** Indicates whether the object has been initialized with the Key / IV */
 	bool m_IsValid;
 } ;
@@ -11,6 +11,7 @@
 
 
 cAesCfb128Encryptor::cAesCfb128Encryptor(void):
+	m_IsAesNi(false),
 	m_IsValid(false)
 {
 	mbedtls_aes_init(&m_Aes);
@@ -34,8 +35,16 @@ void cAesCfb128Encryptor::Init(const Byte a_Key[16], const Byte a_IV[16])
 {
 	ASSERT(!IsValid());  // Cannot Init twice
 
-	memcpy(m_IV, a_IV, 16);
-	mbedtls_aes_setkey_enc(&m_Aes, a_Key, 128);
+	if (cAesNiCfb8::IsSupported())
+	{
+		m_AesNi.Init(a_Key, a_IV);
+		m_IsAesNi = true;
+	}
+	else
+	{
+		memcpy(m_IV, a_IV, 16);
+		mbedtls_aes_setkey_enc(&m_Aes, a_Key, 128);
+	}
 	m_IsValid = true;
 }
 
@@ -46,5 +55,11 @@ void cAesCfb128Encryptor::Init(const Byte a_Key[16], const Byte a_IV[16])
 void cAesCfb128Encryptor::ProcessData(std::byte * const a_PlainIn, const size_t a_Length)
 {
 	ASSERT(IsValid());  // Must Init() first
+
+	if (m_IsAesNi)
+	{
+		m_AesNi.Encrypt(a_PlainIn, a_Length);
+		return;
+	}
 	mbedtls_aes_crypt_cfb8(&m_Aes, MBEDTLS_AES_ENCRYPT, a_Length, m_IV, reinterpret_cast<const unsigned char *>(a_PlainIn), reinterpret_cast<unsigned char *>(a_PlainIn));
 }
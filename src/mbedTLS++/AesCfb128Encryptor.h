@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "AesNiCfb8.h"
 #include "mbedtls/aes.h"
 
 
@@ -39,6 +40,12 @@ protected:
 	/** The InitialVector, used by the CFB mode encryption */
 	Byte m_IV[16];
 
+	/** The AES-NI implementation, used instead of m_Aes when the CPU supports it. */
+	cAesNiCfb8 m_AesNi;
+
+	/** Indicates whether m_AesNi is used for the encryption. */
+	bool m_IsAesNi;
+
 	/** Indicates whether the object has been initialized with the Key / IV */
 	bool m_IsValid;
 } ;
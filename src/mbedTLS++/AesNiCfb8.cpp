@@ -0,0 +1,287 @@
+
+// AesNiCfb8.cpp
+
+// Implements the cAesNiCfb8 class implementing the AES-128 CFB8 cipher using the AES-NI CPU instructions
+
+#include "Globals.h"
+#include "AesNiCfb8.h"
+
+#include "mbedtls/platform_util.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define AESNI_CFB8_AVAILABLE
+	#include <wmmintrin.h>
+	#include <tmmintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+// GCC and Clang only emit the instructions in functions that explicitly ask for them,
+// so that the rest of the server still runs on CPUs without AES-NI:
+#if defined(__GNUC__) || defined(__clang__)
+	#define AESNI_TARGET __attribute__((target("ssse3,aes")))
+#else
+	#define AESNI_TARGET
+#endif
+
+
+
+
+
+#ifdef AESNI_CFB8_AVAILABLE
+
+namespace
+{
+	/** Returns the next round key, given the previous one and the result of its _mm_aeskeygenassist_si128(). */
+	AESNI_TARGET inline __m128i ExpandKeyStep(__m128i a_Key, __m128i a_KeyGenAssist)
+	{
+		a_KeyGenAssist = _mm_shuffle_epi32(a_KeyGenAssist, _MM_SHUFFLE(3, 3, 3, 3));
+		a_Key = _mm_xor_si128(a_Key, _mm_slli_si128(a_Key, 4));
+		a_Key = _mm_xor_si128(a_Key, _mm_slli_si128(a_Key, 4));
+		a_Key = _mm_xor_si128(a_Key, _mm_slli_si128(a_Key, 4));
+		return _mm_xor_si128(a_Key, a_KeyGenAssist);
+	}
+
+
+
+
+
+	AESNI_TARGET void ExpandKey(const Byte a_Key[16], Byte a_RoundKeys[11][16])
+	{
+		// The round constant is an immediate operand of the instruction, hence the unrolled steps:
+		__m128i Keys[11];
+		Keys[0]  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_Key));
+		Keys[1]  = ExpandKeyStep(Keys[0], _mm_aeskeygenassist_si128(Keys[0], 0x01));
+		Keys[2]  = ExpandKeyStep(Keys[1], _mm_aeskeygenassist_si128(Keys[1], 0x02));
+		Keys[3]  = ExpandKeyStep(Keys[2], _mm_aeskeygenassist_si128(Keys[2], 0x04));
+		Keys[4]  = ExpandKeyStep(Keys[3], _mm_aeskeygenassist_si128(Keys[3], 0x08));
+		Keys[5]  = ExpandKeyStep(Keys[4], _mm_aeskeygenassist_si128(Keys[4], 0x10));
+		Keys[6]  = ExpandKeyStep(Keys[5], _mm_aeskeygenassist_si128(Keys[5], 0x20));
+		Keys[7]  = ExpandKeyStep(Keys[6], _mm_aeskeygenassist_si128(Keys[6], 0x40));
+		Keys[8]  = ExpandKeyStep(Keys[7], _mm_aeskeygenassist_si128(Keys[7], 0x80));
+		Keys[9]  = ExpandKeyStep(Keys[8], _mm_aeskeygenassist_si128(Keys[8], 0x1b));
+		Keys[10] = ExpandKeyStep(Keys[9], _mm_aeskeygenassist_si128(Keys[9], 0x36));
+		for (size_t i = 0; i < 11; i++)
+		{
+			_mm_store_si128(reinterpret_cast<__m128i *>(a_RoundKeys[i]), Keys[i]);
+		}
+		mbedtls_platform_zeroize(Keys, sizeof(Keys));
+	}
+
+
+
+
+
+	/** Encrypts a single block and returns the first byte of the result, which is all that CFB8 uses. */
+	AESNI_TARGET inline Byte EncryptBlockFirstByte(const __m128i (& a_Keys)[11], __m128i a_Block)
+	{
+		a_Block = _mm_xor_si128(a_Block, a_Keys[0]);
+		for (size_t r = 1; r < 10; r++)
+		{
+			a_Block = _mm_aesenc_si128(a_Block, a_Keys[r]);
+		}
+		a_Block = _mm_aesenclast_si128(a_Block, a_Keys[10]);
+		return static_cast<Byte>(_mm_cvtsi128_si32(a_Block));
+	}
+
+
+
+
+
+	AESNI_TARGET inline void LoadKeys(const Byte a_RoundKeys[11][16], __m128i (& a_Keys)[11])
+	{
+		for (size_t r = 0; r < 11; r++)
+		{
+			a_Keys[r] = _mm_load_si128(reinterpret_cast<const __m128i *>(a_RoundKeys[r]));
+		}
+	}
+
+
+
+
+
+	AESNI_TARGET void EncryptCfb8(const Byte a_RoundKeys[11][16], Byte a_IV[16], Byte * a_Data, size_t a_Length)
+	{
+		__m128i Keys[11];
+		LoadKeys(a_RoundKeys, Keys);
+
+		auto IV = _mm_load_si128(reinterpret_cast<const __m128i *>(a_IV));
+		for (size_t i = 0; i < a_Length; i++)
+		{
+			const Byte Cipher = a_Data[i] ^ EncryptBlockFirstByte(Keys, IV);
+			a_Data[i] = Cipher;
+
+			// Shift the register by a byte and append the ciphertext byte at its end:
+			IV = _mm_or_si128(_mm_srli_si128(IV, 1), _mm_slli_si128(_mm_cvtsi32_si128(Cipher), 15));
+		}
+		_mm_store_si128(reinterpret_cast<__m128i *>(a_IV), IV);
+	}
+
+
+
+
+
+	/** Decrypts the eight bytes at a_Data, whose input blocks start at a_Offset in the 32-byte stream (a_Prev, a_Next).
+	The eight blocks are independent, their rounds are interleaved so that they overlap in the CPU pipeline. */
+	template <int Offset>
+	AESNI_TARGET inline void DecryptEight(const __m128i (& a_Keys)[11], __m128i a_Prev, __m128i a_Next, Byte * a_Data)
+	{
+		// The shift amount of _mm_alignr_epi8 is an immediate operand, hence the template:
+		__m128i Blocks[8] =
+		{
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 0),
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 1),
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 2),
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 3),
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 4),
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 5),
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 6),
+			_mm_alignr_epi8(a_Next, a_Prev, Offset + 7),
+		};
+		for (auto & Block : Blocks)
+		{
+			Block = _mm_xor_si128(Block, a_Keys[0]);
+		}
+		for (size_t r = 1; r < 10; r++)
+		{
+			for (auto & Block : Blocks)
+			{
+				Block = _mm_aesenc_si128(Block, a_Keys[r]);
+			}
+		}
+		for (size_t b = 0; b < 8; b++)
+		{
+			a_Data[b] ^= static_cast<Byte>(_mm_cvtsi128_si32(_mm_aesenclast_si128(Blocks[b], a_Keys[10])));
+		}
+	}
+
+
+
+
+
+	AESNI_TARGET void DecryptCfb8(const Byte a_RoundKeys[11][16], Byte a_IV[16], Byte * a_Data, size_t a_Length)
+	{
+		__m128i Keys[11];
+		LoadKeys(a_RoundKeys, Keys);
+
+		// The input block of the i-th byte is the 16 bytes preceding it in the (IV + ciphertext) stream.
+		// The data is decrypted in-place, so the last 16 ciphertext bytes are kept in a register (Prev)
+		// and the next 16 are loaded before their plaintext overwrites them (Next):
+		auto Prev = _mm_load_si128(reinterpret_cast<const __m128i *>(a_IV));
+		size_t i = 0;
+		for (; i + 16 <= a_Length; i += 16)
+		{
+			const auto Next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a_Data + i));
+			DecryptEight<0>(Keys, Prev, Next, a_Data + i);
+			DecryptEight<8>(Keys, Prev, Next, a_Data + i + 8);
+			Prev = Next;
+		}
+
+		// The last few bytes, one at a time:
+		for (; i < a_Length; i++)
+		{
+			const Byte Cipher = a_Data[i];
+			a_Data[i] = Cipher ^ EncryptBlockFirstByte(Keys, Prev);
+			Prev = _mm_or_si128(_mm_srli_si128(Prev, 1), _mm_slli_si128(_mm_cvtsi32_si128(Cipher), 15));
+		}
+		_mm_store_si128(reinterpret_cast<__m128i *>(a_IV), Prev);
+	}
+}
+
+#endif  // AESNI_CFB8_AVAILABLE
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cAesNiCfb8:
+
+cAesNiCfb8::cAesNiCfb8(void)
+{
+	std::memset(m_RoundKeys, 0, sizeof(m_RoundKeys));
+	std::memset(m_IV, 0, sizeof(m_IV));
+}
+
+
+
+
+
+cAesNiCfb8::~cAesNiCfb8()
+{
+	// Clear the leftover in-memory data, so that they can't be accessed by a backdoor:
+	mbedtls_platform_zeroize(m_RoundKeys, sizeof(m_RoundKeys));
+	mbedtls_platform_zeroize(m_IV, sizeof(m_IV));
+}
+
+
+
+
+
+bool cAesNiCfb8::IsSupported(void)
+{
+#ifdef AESNI_CFB8_AVAILABLE
+	static const bool IsCpuSupported = []
+	{
+		// CPUID leaf 1, ECX bit 25 is AES-NI, ECX bit 9 is SSSE3:
+		#if defined(_MSC_VER)
+			int Regs[4];
+			__cpuid(Regs, 1);
+			const auto Ecx = static_cast<unsigned>(Regs[2]);
+		#else
+			unsigned Eax, Ebx, Ecx, Edx;
+			if (__get_cpuid(1, &Eax, &Ebx, &Ecx, &Edx) == 0)
+			{
+				return false;
+			}
+		#endif
+		return (((Ecx >> 25) & 1) != 0) && (((Ecx >> 9) & 1) != 0);
+	}();
+	return IsCpuSupported;
+#else
+	return false;
+#endif
+}
+
+
+
+
+
+void cAesNiCfb8::Init(const Byte a_Key[16], const Byte a_IV[16])
+{
+	ASSERT(IsSupported());
+
+#ifdef AESNI_CFB8_AVAILABLE
+	ExpandKey(a_Key, m_RoundKeys);
+	std::memcpy(m_IV, a_IV, 16);
+#endif
+}
+
+
+
+
+
+void cAesNiCfb8::Encrypt(std::byte * a_Data, size_t a_Length)
+{
+	ASSERT(IsSupported());
+
+#ifdef AESNI_CFB8_AVAILABLE
+	EncryptCfb8(m_RoundKeys, m_IV, reinterpret_cast<Byte *>(a_Data), a_Length);
+#endif
+}
+
+
+
+
+
+void cAesNiCfb8::Decrypt(std::byte * a_Data, size_t a_Length)
+{
+	ASSERT(IsSupported());
+
+#ifdef AESNI_CFB8_AVAILABLE
+	DecryptCfb8(m_RoundKeys, m_IV, reinterpret_cast<Byte *>(a_Data), a_Length);
+#endif
+}
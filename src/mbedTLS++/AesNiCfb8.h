@@ -0,0 +1,55 @@
+
+// AesNiCfb8.h
+
+// Declares the cAesNiCfb8 class implementing the AES-128 CFB8 cipher using the AES-NI CPU instructions
+
+/*
+The protocol encryption is AES-128 in the CFB8 mode: every single byte of traffic needs a full AES block encryption
+of the last 16 ciphertext bytes. mbedtls_aes_crypt_cfb8() pays for a function call and the generic block code
+for each of those bytes. This class keeps the expanded key ready for the AES-NI instructions, and:
+	- encrypts with the AES rounds inlined; this is still a block per byte, one after another, because the input of
+	each block depends on the previous ciphertext byte;
+	- decrypts eight bytes at a time, because the inputs of the decryption blocks are all the already known ciphertext,
+	so the rounds of eight independent blocks are interleaved and overlap in the CPU pipeline.
+The instructions are only available on x86 CPUs that support them; the users check IsSupported() at runtime
+and fall back to mbedTLS otherwise.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cAesNiCfb8
+{
+public:
+
+	cAesNiCfb8(void);
+	~cAesNiCfb8();
+
+	/** Returns true if the CPU we're running on supports the instructions needed by this class.
+	The other functions may only be called if this returns true. */
+	static bool IsSupported(void);
+
+	/** Initializes the cipher with the specified Key / IV. */
+	void Init(const Byte a_Key[16], const Byte a_IV[16]);
+
+	/** Encrypts a_Length bytes of the plain data in-place. */
+	void Encrypt(std::byte * a_Data, size_t a_Length);
+
+	/** Decrypts a_Length bytes of the encrypted data in-place. */
+	void Decrypt(std::byte * a_Data, size_t a_Length);
+
+private:
+
+	/** The expanded AES-128 encryption key, one 16-byte round key for each of the 11 rounds. */
+	alignas(16) Byte m_RoundKeys[11][16];
+
+	/** The shift register of the CFB8 mode: the last 16 bytes of the ciphertext. */
+	alignas(16) Byte m_IV[16];
+};
@@ -0,0 +1,180 @@
+
+// AesCfb8Test.cpp
+
+// Tests the AES-NI implementation of the AES-128 CFB8 cipher against the known answers and the mbedTLS implementation,
+// and measures the throughput of both
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "mbedTLS++/AesCfb128Decryptor.h"
+#include "mbedTLS++/AesCfb128Encryptor.h"
+#include "mbedTLS++/AesNiCfb8.h"
+
+#include <random>
+
+
+
+
+
+/** The CFB8-AES128 example vectors from NIST SP 800-38A, F.3.7. */
+static const Byte NIST_KEY[16] =
+{
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+static const Byte NIST_IV[16] =
+{
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+static const Byte NIST_PLAIN[18] =
+{
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d
+};
+
+static const Byte NIST_CIPHER[18] =
+{
+	0x3b, 0x79, 0x42, 0x4c, 0x9c, 0x0d, 0xd4, 0x36, 0xba, 0xce, 0x9e, 0x0e, 0xd4, 0x58, 0x6a, 0x4f, 0x32, 0xb9
+};
+
+
+
+
+
+/** Runs the mbedTLS implementation over the data in-place, regardless of the CPU. */
+static void MbedTlsCfb8(int a_Mode, const Byte a_Key[16], const Byte a_IV[16], ContiguousByteBuffer & a_Data)
+{
+	mbedtls_aes_context Aes;
+	mbedtls_aes_init(&Aes);
+	mbedtls_aes_setkey_enc(&Aes, a_Key, 128);
+	Byte IV[16];
+	std::copy_n(a_IV, 16, IV);
+	auto Data = reinterpret_cast<unsigned char *>(a_Data.data());
+	mbedtls_aes_crypt_cfb8(&Aes, a_Mode, a_Data.size(), IV, Data, Data);
+	mbedtls_aes_free(&Aes);
+}
+
+
+
+
+
+/** Tests the encryptor and decryptor, whichever implementation they choose, against the NIST vectors. */
+static void TestKnownAnswer(void)
+{
+	LOG("AES-NI is %s", cAesNiCfb8::IsSupported() ? "supported, testing it" : "not supported, testing mbedTLS");
+
+	ContiguousByteBuffer Data(reinterpret_cast<const std::byte *>(NIST_PLAIN), sizeof(NIST_PLAIN));
+	cAesCfb128Encryptor Encryptor;
+	Encryptor.Init(NIST_KEY, NIST_IV);
+	Encryptor.ProcessData(Data.data(), 5);
+	Encryptor.ProcessData(Data.data() + 5, Data.size() - 5);
+	TEST_EQUAL(memcmp(Data.data(), NIST_CIPHER, sizeof(NIST_CIPHER)), 0);
+
+	cAesCfb128Decryptor Decryptor;
+	Decryptor.Init(NIST_KEY, NIST_IV);
+	Decryptor.ProcessData(Data.data(), 3);
+	Decryptor.ProcessData(Data.data() + 3, Data.size() - 3);
+	TEST_EQUAL(memcmp(Data.data(), NIST_PLAIN, sizeof(NIST_PLAIN)), 0);
+}
+
+
+
+
+
+/** Compares the AES-NI implementation to mbedTLS on random keys and data, fed in random chunks. */
+static void TestAgainstMbedTls(void)
+{
+	if (!cAesNiCfb8::IsSupported())
+	{
+		LOG("Skipped, AES-NI is not supported by this CPU");
+		return;
+	}
+
+	std::minstd_rand Random(0x5eed);
+	auto RandomByte = [&Random]()
+	{
+		return static_cast<Byte>(Random() & 0xff);
+	};
+	for (int i = 0; i < 200; i++)
+	{
+		Byte Key[16], IV[16];
+		std::generate(std::begin(Key), std::end(Key), RandomByte);
+		std::generate(std::begin(IV), std::end(IV), RandomByte);
+		ContiguousByteBuffer Plain(static_cast<size_t>(Random() % 5000), std::byte(0));
+		std::generate(Plain.begin(), Plain.end(), [&RandomByte]() { return static_cast<std::byte>(RandomByte()); });
+
+		// Encryption, in chunks of various sizes, including the empty ones:
+		auto Expected = Plain;
+		MbedTlsCfb8(MBEDTLS_AES_ENCRYPT, Key, IV, Expected);
+		auto Data = Plain;
+		cAesNiCfb8 Encryptor;
+		Encryptor.Init(Key, IV);
+		for (size_t Pos = 0; Pos < Data.size();)
+		{
+			auto Length = std::min<size_t>(Random() % 40, Data.size() - Pos);
+			Encryptor.Encrypt(Data.data() + Pos, Length);
+			Pos += Length;
+		}
+		TEST_TRUE((Data == Expected));
+
+		// Decryption, in chunks that are both smaller and larger than the parallel batch:
+		cAesNiCfb8 Decryptor;
+		Decryptor.Init(Key, IV);
+		for (size_t Pos = 0; Pos < Data.size();)
+		{
+			auto Length = std::min<size_t>(Random() % 40, Data.size() - Pos);
+			Decryptor.Decrypt(Data.data() + Pos, Length);
+			Pos += Length;
+		}
+		TEST_TRUE((Data == Plain));
+	}
+}
+
+
+
+
+
+/** Logs the throughput of both implementations in both directions. */
+static void Benchmark(void)
+{
+	const size_t Size = 4 * 1024 * 1024;
+	ContiguousByteBuffer Data(Size, std::byte(0));
+	auto Measure = [&Data](const char * a_Name, auto a_Process)
+	{
+		auto Start = std::chrono::steady_clock::now();
+		a_Process(Data);
+		auto Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		LOG("%s: %.1f MiB/s", a_Name, static_cast<double>(Data.size()) / (1024 * 1024) / std::max(Seconds, 1e-9));
+	};
+
+	Measure("mbedTLS encryption", [](ContiguousByteBuffer & a_Data) { MbedTlsCfb8(MBEDTLS_AES_ENCRYPT, NIST_KEY, NIST_IV, a_Data); });
+	Measure("mbedTLS decryption", [](ContiguousByteBuffer & a_Data) { MbedTlsCfb8(MBEDTLS_AES_DECRYPT, NIST_KEY, NIST_IV, a_Data); });
+	if (!cAesNiCfb8::IsSupported())
+	{
+		return;
+	}
+	Measure("AES-NI encryption", [](ContiguousByteBuffer & a_Data)
+		{
+			cAesNiCfb8 Cipher;
+			Cipher.Init(NIST_KEY, NIST_IV);
+			Cipher.Encrypt(a_Data.data(), a_Data.size());
+		}
+	);
+	Measure("AES-NI decryption", [](ContiguousByteBuffer & a_Data)
+		{
+			cAesNiCfb8 Cipher;
+			Cipher.Init(NIST_KEY, NIST_IV);
+			Cipher.Decrypt(a_Data.data(), a_Data.size());
+		}
+	);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("AesCfb8",
+	TestKnownAnswer();
+	TestAgainstMbedTls();
+	Benchmark();
+)
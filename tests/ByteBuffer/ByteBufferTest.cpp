@@ -70,6 +70,37 @@ static void TestWrap(void)
 
 
 
+static void TestView(void)
+{
+	const ContiguousByteBuffer Data(reinterpret_cast<const std::byte *>("\x05\xac\x02\x03" "abc"), 7);
+	cByteBuffer buf(Data);
+	TEST_EQUAL(buf.GetReadableSpace(), Data.size());
+	TEST_EQUAL(buf.GetFreeSpace(), 0);
+	TEST_FALSE(buf.Write("d", 1));
+	UInt32 v1;
+	TEST_TRUE(buf.ReadVarInt(v1));
+	TEST_EQUAL(v1, 5);
+	UInt32 v2;
+	TEST_TRUE(buf.ReadVarInt(v2));
+	TEST_EQUAL(v2, 300);
+	AString s;
+	TEST_TRUE(buf.ReadVarUTF8String(s));
+	TEST_EQUAL(s, "abc");
+	TEST_EQUAL(buf.GetReadableSpace(), 0);
+	UInt8 v3;
+	TEST_FALSE(buf.ReadBEUInt8(v3));
+
+	// The data is read directly, not copied:
+	buf.ResetRead();
+	ContiguousByteBuffer All;
+	buf.ReadAll(All);
+	TEST_TRUE((All == Data));
+}
+
+
+
+
+
 static void TestXYZPositionRoundtrip(void)
 {
 	cByteBuffer buf(50);
@@ -104,6 +135,7 @@ IMPLEMENT_TEST_MAIN("ByteBuffer",
 	TestRead();
 	TestWrite();
 	TestWrap();
+	TestView();
 	TestXYZPositionRoundtrip();
 	TestXZYPositionRoundtrip();
 )
@@ -169,6 +169,45 @@ static void Test()
 		CopyAll(buffer, &ChunkLightData::GetSkyLightSection, ChunkLightData::DefaultSkyLightValue, DstNibbleBuffer);
 		TEST_EQUAL(memcmp(SrcNibbleBuffer, DstNibbleBuffer, (16 * 16 * 256 / 2) - 1), 0);
 	}
+
+	{
+		// The copies share the sections until either side writes into them:
+		ChunkBlockData buffer;
+		buffer.SetBlock({ 3, 1, 4 }, 0xDE);
+		buffer.SetBlock({ 3, 17, 4 }, 0xAD);
+
+		ChunkBlockData copy;
+		copy.Assign(buffer);
+		TEST_EQUAL(copy.GetSection(0), buffer.GetSection(0));
+		TEST_EQUAL(copy.GetSection(1), buffer.GetSection(1));
+
+		// Writing the same value keeps the section shared:
+		copy.SetBlock({ 3, 1, 4 }, 0xDE);
+		TEST_EQUAL(copy.GetSection(0), buffer.GetSection(0));
+
+		copy.SetBlock({ 3, 1, 4 }, 0xBE);
+		TEST_NOTEQUAL(copy.GetSection(0), buffer.GetSection(0));
+		TEST_EQUAL(copy.GetSection(1), buffer.GetSection(1));
+		TEST_EQUAL(copy.GetBlock({ 3, 1, 4 }), 0xBE);
+		TEST_EQUAL(buffer.GetBlock({ 3, 1, 4 }), 0xDE);
+
+		buffer.GetOrCreateSection(1)[0] = 0xEF;
+		TEST_NOTEQUAL(copy.GetSection(1), buffer.GetSection(1));
+		TEST_EQUAL(copy.GetBlock({ 3, 17, 4 }), 0xAD);
+		TEST_EQUAL(buffer.GetBlock({ 0, 16, 0 }), 0xEF);
+		TEST_EQUAL(copy.GetBlock({ 0, 16, 0 }), ChunkBlockData::DefaultValue);
+
+		// Overwriting a whole shared section leaves the other copy intact:
+		ChunkLightData lights;
+		lights.SetAll({}, {});
+		ChunkLightData lightsCopy;
+		lightsCopy.Assign(lights);
+		NIBBLETYPE SrcNibbleBuffer[ChunkLightData::SectionLightCount];
+		memset(SrcNibbleBuffer, 0x77, sizeof(SrcNibbleBuffer));
+		lights.SetSection(SrcNibbleBuffer, SrcNibbleBuffer, 0);
+		TEST_EQUAL(lights.GetSkyLight({ 0, 0, 0 }), 7);
+		TEST_EQUAL(lightsCopy.GetSkyLight({ 0, 0, 0 }), 0);
+	}
 }
 
 
@@ -0,0 +1,287 @@
+
+// PalettedSection.cpp
+
+// Tests the PalettedBlockSection class and compares it to the flat layout of ChunkBlockData
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "PalettedBlockSection.h"
+#include "FastRandom.h"
+
+
+
+
+
+/** Checks the widening from a uniform section up to the direct states, and the narrowing by Compact(). */
+static void TestWidening()
+{
+	PalettedBlockSection Section(PalettedBlockSection::MakeState(1, 0));
+	TEST_EQUAL(Section.GetBitsPerEntry(), 0U);
+	TEST_EQUAL(Section.GetBlock(1234), 1);
+	TEST_TRUE(Section.GetData().empty());
+
+	// Writing the existing state keeps the section uniform:
+	Section.SetBlock(1234, 1, 0);
+	TEST_EQUAL(Section.GetBitsPerEntry(), 0U);
+
+	// Each new state that doesn't fit doubles the width, the rest stays as it was:
+	const std::pair<size_t, unsigned> Steps[] = { { 2, 1 }, { 4, 2 }, { 16, 4 }, { 256, 8 }, { 257, 16 } };
+	size_t NumStates = 1;
+	for (const auto & [PaletteSize, Bits]: Steps)
+	{
+		for (; NumStates < PaletteSize; NumStates++)
+		{
+			Section.Set(NumStates * 7, static_cast<PalettedBlockSection::State>(NumStates + 16));
+		}
+		TEST_EQUAL(Section.GetBitsPerEntry(), Bits);
+	}
+	TEST_TRUE(Section.IsDirect());
+	TEST_TRUE(Section.GetPalette().empty());
+	for (size_t i = 1; i < NumStates; i++)
+	{
+		TEST_EQUAL(Section.Get(i * 7), i + 16);
+		TEST_EQUAL(Section.Get(i * 7 + 1), PalettedBlockSection::MakeState(1, 0));
+	}
+
+	// Overwrite all but two states, the section narrows back to a single bit:
+	for (size_t i = 2; i < NumStates; i++)
+	{
+		Section.Set(i * 7, PalettedBlockSection::MakeState(1, 0));
+	}
+	Section.Compact();
+	TEST_EQUAL(Section.GetBitsPerEntry(), 1U);
+	TEST_EQUAL(Section.GetPalette().size(), 2U);
+	TEST_EQUAL(Section.Get(7), 17);
+	TEST_EQUAL(Section.Get(14), PalettedBlockSection::MakeState(1, 0));
+
+	Section.Set(7, PalettedBlockSection::MakeState(1, 0));
+	Section.Compact();
+	TEST_EQUAL(Section.GetBitsPerEntry(), 0U);
+	TEST_EQUAL(Section.GetMemoryUsage(), sizeof(PalettedBlockSection) + sizeof(PalettedBlockSection::State));
+}
+
+
+
+
+
+/** Checks that the conversion from and to the flat arrays keeps all the blocks and metas. */
+static void TestRoundTrip()
+{
+	cFastRandom Random;
+	for (int NumStates: { 1, 3, 30, 1000 })
+	{
+		ChunkBlockData::BlockArray Blocks;
+		ChunkBlockData::MetaArray Metas{};
+		for (size_t i = 0; i < Blocks.size(); i++)
+		{
+			const auto State = Random.RandInt(NumStates - 1);
+			Blocks[i] = static_cast<BLOCKTYPE>(State % 256);
+			cChunkDef::PackNibble(Metas.data(), i, static_cast<NIBBLETYPE>(State / 256));
+		}
+
+		PalettedBlockSection Section;
+		Section.SetAll(Blocks.data(), Metas.data());
+		for (size_t i = 0; i < Blocks.size(); i++)
+		{
+			TEST_EQUAL(Section.GetBlock(i), Blocks[i]);
+			TEST_EQUAL(Section.GetMeta(i), cChunkDef::ExpandNibble(Metas.data(), i));
+		}
+
+		ChunkBlockData::BlockArray BlocksOut;
+		ChunkBlockData::MetaArray MetasOut;
+		Section.CopyTo(BlocksOut.data(), MetasOut.data());
+		TEST_TRUE((Blocks == BlocksOut));
+		TEST_TRUE((Metas == MetasOut));
+	}
+
+	// A section not allocated in ChunkBlockData is all air:
+	PalettedBlockSection Section(PalettedBlockSection::MakeState(1, 0));
+	Section.SetAll(nullptr, nullptr);
+	TEST_EQUAL(Section.GetBitsPerEntry(), 0U);
+	TEST_EQUAL(Section.Get(0), PalettedBlockSection::MakeState(ChunkBlockData::DefaultValue, ChunkBlockData::DefaultMetaValue));
+}
+
+
+
+
+
+/** Checks that a section loads back from its width, palette and data, and that the inconsistent ones are refused. */
+static void TestLoad()
+{
+	cFastRandom Random;
+	for (int NumStates: { 1, 2, 3, 17, 256, 1000 })
+	{
+		PalettedBlockSection Section;
+		for (size_t i = 0; i < PalettedBlockSection::EntryCount; i++)
+		{
+			Section.Set(i, static_cast<PalettedBlockSection::State>(Random.RandInt(NumStates - 1)));
+		}
+		Section.Compact();
+
+		PalettedBlockSection Loaded;
+		TEST_TRUE(Loaded.Load(Section.GetBitsPerEntry(), Section.GetPalette(), Section.GetData()));
+		for (size_t i = 0; i < PalettedBlockSection::EntryCount; i++)
+		{
+			TEST_EQUAL(Loaded.Get(i), Section.Get(i));
+		}
+
+		// A width other than the smallest, or data of a different size:
+		TEST_FALSE(Loaded.Load(Section.GetBitsPerEntry() + 1, Section.GetPalette(), Section.GetData()));
+		auto Data = Section.GetData();
+		Data.push_back(0);
+		TEST_FALSE(Loaded.Load(Section.GetBitsPerEntry(), Section.GetPalette(), Data));
+	}
+
+	// An index past the palette, or a state past the valid ones:
+	PalettedBlockSection Loaded;
+	const std::vector<PalettedBlockSection::State> Palette = { 1, 2, 3 };
+	std::vector<UInt64> Data(PalettedBlockSection::EntryCount * 2 / 64, 0);
+	TEST_TRUE(Loaded.Load(2, Palette, Data));
+	Data[17] = UInt64(3) << 10;
+	TEST_FALSE(Loaded.Load(2, Palette, Data));
+	TEST_FALSE(Loaded.Load(2, { 1, 2, 0x1000 }, std::vector<UInt64>(Data.size(), 0)));
+	Data = std::vector<UInt64>(PalettedBlockSection::EntryCount * 16 / 64, 0x0fff);
+	TEST_TRUE(Loaded.Load(16, {}, Data));
+	Data[5] = 0x1000;
+	TEST_FALSE(Loaded.Load(16, {}, Data));
+
+	// A refused section stays as it was:
+	TEST_EQUAL(Loaded.GetBitsPerEntry(), 16U);
+	TEST_EQUAL(Loaded.Get(0), 0x0fff);
+}
+
+
+
+
+
+/** Logs the memory used and the access speed of both layouts, for a few kinds of sections. */
+static void Benchmark()
+{
+	struct sKind
+	{
+		const char * m_Name;
+		int m_NumStates;
+		int m_NumDifferentBlocks;  // Blocks per 4096 that aren't the base state
+	};
+	const sKind Kinds[] =
+	{
+		{ "uniform", 1, 0 },
+		{ "stone with ores", 8, 200 },
+		{ "surface", 40, 1500 },
+		{ "noise", 4000, 4096 },
+	};
+
+	cFastRandom Random;
+	for (const auto & Kind: Kinds)
+	{
+		ChunkBlockData Flat;
+		PalettedBlockSection Paletted[cChunkDef::NumSections];
+		for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+		{
+			auto & Blocks = Flat.GetOrCreateSection(Y);
+			auto & Metas = Flat.GetOrCreateMetaSection(Y);
+			for (size_t i = 0; i < Blocks.size(); i++)
+			{
+				const auto State = (Random.RandInt(4095) < Kind.m_NumDifferentBlocks) ? Random.RandInt(Kind.m_NumStates - 1) : 0;
+				Blocks[i] = static_cast<BLOCKTYPE>(1 + State % 255);
+				cChunkDef::PackNibble(Metas.data(), i, static_cast<NIBBLETYPE>(State / 255));
+			}
+			Paletted[Y].SetAll(Blocks.data(), Metas.data());
+		}
+
+		size_t PalettedMemory = 0;
+		for (const auto & Section: Paletted)
+		{
+			PalettedMemory += Section.GetMemoryUsage();
+		}
+		const size_t FlatMemory = sizeof(ChunkBlockData) + cChunkDef::NumSections * (sizeof(ChunkBlockData::BlockArray) + sizeof(ChunkBlockData::MetaArray));
+
+		// Read all the blocks a few times, then overwrite a third of them with a block already present.
+		// Both layouts are accessed by the index within a section, as the bulk operations do:
+		const int NumPasses = 50;
+		auto Measure = [](auto a_Process)
+		{
+			auto Start = std::chrono::steady_clock::now();
+			a_Process();
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		};
+		unsigned FlatSum = 0;
+		unsigned PalettedSum = 0;
+		const auto FlatGet = Measure([&]()
+			{
+				for (int Pass = 0; Pass < NumPasses; Pass++)
+				{
+					for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+					{
+						const auto & Blocks = *Flat.GetSection(Y);
+						const auto & Metas = *Flat.GetMetaSection(Y);
+						for (size_t i = 0; i < PalettedBlockSection::EntryCount; i++)
+						{
+							FlatSum += Blocks[i] + cChunkDef::ExpandNibble(Metas.data(), i);
+						}
+					}
+				}
+			}
+		);
+		const auto PalettedGet = Measure([&]()
+			{
+				for (int Pass = 0; Pass < NumPasses; Pass++)
+				{
+					for (const auto & Section: Paletted)
+					{
+						for (size_t i = 0; i < PalettedBlockSection::EntryCount; i++)
+						{
+							PalettedSum += Section.GetBlock(i) + Section.GetMeta(i);
+						}
+					}
+				}
+			}
+		);
+		TEST_EQUAL(FlatSum, PalettedSum);
+
+		const auto FlatSet = Measure([&]()
+			{
+				for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+				{
+					auto & Blocks = Flat.GetOrCreateSection(Y);
+					auto & Metas = Flat.GetOrCreateMetaSection(Y);
+					for (size_t i = 0; i < PalettedBlockSection::EntryCount; i += 3)
+					{
+						Blocks[i] = 1;
+						cChunkDef::PackNibble(Metas.data(), i, 0);
+					}
+				}
+			}
+		);
+		const auto PalettedSet = Measure([&]()
+			{
+				for (auto & Section: Paletted)
+				{
+					for (size_t i = 0; i < PalettedBlockSection::EntryCount; i += 3)
+					{
+						Section.SetBlock(i, 1, 0);
+					}
+				}
+			}
+		);
+
+		const auto NumReads = static_cast<double>(NumPasses) * cChunkDef::NumBlocks;
+		const auto NumWrites = static_cast<double>(cChunkDef::NumSections * ((PalettedBlockSection::EntryCount + 2) / 3));
+		LOG("%s: flat %zu KiB, %.2f ns per read, %.2f ns per write; paletted %zu KiB, %.2f ns per read, %.2f ns per write",
+			Kind.m_Name,
+			FlatMemory / 1024, FlatGet * 1e9 / NumReads, FlatSet * 1e9 / NumWrites,
+			PalettedMemory / 1024, PalettedGet * 1e9 / NumReads, PalettedSet * 1e9 / NumWrites
+		);
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ChunkData PalettedSection",
+	TestWidening();
+	TestRoundTrip();
+	TestLoad();
+	Benchmark();
+)
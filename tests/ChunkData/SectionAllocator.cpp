@@ -0,0 +1,140 @@
+
+// SectionAllocator.cpp
+
+// Tests the memory accounting and the slab pools of the chunk sections
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "ChunkData.h"
+#include <thread>
+
+
+
+
+
+/** Checks that the account is charged for each section exactly once, however many snapshots share it. */
+static void TestAccounting()
+{
+	auto Account = std::make_shared<cMemoryAccount>();
+	{
+		ChunkBlockData Data;
+		Data.SetMemoryAccount(Account);
+		TEST_EQUAL(Account->GetBytes(), 0U);
+
+		Data.SetBlock({ 0, 0, 0 }, 1);
+		const auto OneSection = Account->GetBytes();
+		TEST_TRUE((OneSection >= sizeof(ChunkBlockData::BlockArray)));
+
+		Data.SetMeta({ 0, 0, 0 }, 2);
+		const auto TwoSections = Account->GetBytes();
+		TEST_TRUE((TwoSections > OneSection));
+
+		// A snapshot shares the sections, nothing is allocated:
+		ChunkBlockData Snapshot;
+		Snapshot.Assign(Data);
+		TEST_EQUAL(Account->GetBytes(), TwoSections);
+
+		// Writing to the shared section copies it, charged to the writer's account:
+		Data.SetBlock({ 1, 0, 0 }, 1);
+		TEST_EQUAL(Account->GetBytes(), TwoSections + OneSection);
+
+		// The snapshot is the last one holding the original section; freeing it refunds the account it was charged to:
+		Snapshot = ChunkBlockData();
+		TEST_EQUAL(Account->GetBytes(), TwoSections);
+	}
+	TEST_EQUAL(Account->GetBytes(), 0U);
+
+	// The account outlives the world it was created for, as long as any section refers to it:
+	ChunkBlockData Orphan;
+	{
+		auto TempAccount = std::make_shared<cMemoryAccount>();
+		Orphan.SetMemoryAccount(TempAccount);
+		Orphan.SetBlock({ 0, 16, 0 }, 1);
+	}
+	Orphan = ChunkBlockData();
+}
+
+
+
+
+
+/** Checks that the slabs of the freed sections are given back to the system. */
+static void TestTrim()
+{
+	const auto UsedBefore = cSlabPool::GetTotalUsedBytes();
+	{
+		auto Account = std::make_shared<cMemoryAccount>();
+		std::vector<ChunkBlockData> Chunks(200);
+		for (auto & Chunk: Chunks)
+		{
+			Chunk.SetMemoryAccount(Account);
+			for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+			{
+				Chunk.GetOrCreateSection(Y);
+			}
+		}
+		TEST_EQUAL(cSlabPool::GetTotalUsedBytes(), UsedBefore + Account->GetBytes());
+		TEST_TRUE((cSlabPool::GetTotalReservedBytes() >= cSlabPool::GetTotalUsedBytes()));
+	}
+	TEST_EQUAL(cSlabPool::GetTotalUsedBytes(), UsedBefore);
+
+	// Only the blocks kept in this thread's cache may still hold a slab, the rest go back to the system:
+	const auto ReservedBefore = cSlabPool::GetTotalReservedBytes();
+	const auto Released = cSlabPool::TrimAll();
+	TEST_TRUE((Released > 0));
+	TEST_EQUAL(cSlabPool::GetTotalReservedBytes(), ReservedBefore - Released);
+	TEST_EQUAL(cSlabPool::TrimAll(), 0U);
+}
+
+
+
+
+
+/** Allocates and frees the sections from several threads at once, some of them freed by a different thread. */
+static void TestThreads()
+{
+	const auto UsedBefore = cSlabPool::GetTotalUsedBytes();
+	auto Account = std::make_shared<cMemoryAccount>();
+	std::vector<ChunkBlockData> Handover(4);
+	{
+		std::vector<std::thread> Threads;
+		for (size_t i = 0; i < Handover.size(); i++)
+		{
+			Threads.emplace_back([&Account, &Out = Handover[i]]()
+				{
+					for (int Round = 0; Round < 100; Round++)
+					{
+						ChunkBlockData Data;
+						Data.SetMemoryAccount(Account);
+						for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+						{
+							Data.GetOrCreateSection(Y);
+							Data.GetOrCreateMetaSection(Y);
+						}
+						Out.Assign(Data);
+					}
+				}
+			);
+		}
+		for (auto & Thread: Threads)
+		{
+			Thread.join();
+		}
+	}
+	TEST_TRUE((Account->GetBytes() > 0));
+
+	// Free the sections allocated by the threads that are gone:
+	Handover.clear();
+	TEST_EQUAL(Account->GetBytes(), 0U);
+	TEST_EQUAL(cSlabPool::GetTotalUsedBytes(), UsedBefore);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ChunkData SectionAllocator",
+	TestAccounting();
+	TestTrim();
+	TestThreads();
+)
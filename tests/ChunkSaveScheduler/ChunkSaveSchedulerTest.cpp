@@ -0,0 +1,220 @@
+
+// ChunkSaveSchedulerTest.cpp
+
+// Tests the order and the amount of the chunks picked for saving by cChunkSaveScheduler
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "WorldStorage/ChunkSaveScheduler.h"
+#include "FastRandom.h"
+
+
+
+
+
+using sDirtyChunk = cChunkSaveScheduler::sDirtyChunk;
+
+static cTickTimeLong Seconds(const int a_Seconds)
+{
+	return std::chrono::duration_cast<cTickTimeLong>(std::chrono::seconds(a_Seconds));
+}
+
+
+
+
+
+/** Checks the order: the chunks due within the period first, then the unused ones, then the rest, each oldest first. */
+static void TestPriority()
+{
+	cChunkSaveScheduler Scheduler;
+	Scheduler.Configure(Seconds(300), 1, 1000);
+
+	std::vector<sDirtyChunk> Chunks;
+	TEST_EQUAL(Scheduler.Schedule(Chunks, Seconds(1000), Seconds(1)), 0U);
+	TEST_EQUAL(Scheduler.GetNumOverdue(), 0U);
+	TEST_EQUAL(Scheduler.GetOldestDirtyAge(), cTickTimeLong(0));
+
+	Chunks =
+	{
+		{ { 0, 0 }, Seconds(900), false },
+		{ { 1, 0 }, Seconds(600), false },  // Overdue
+		{ { 2, 0 }, Seconds(990), true },
+		{ { 3, 0 }, Seconds(700), false },  // Due within the period
+		{ { 4, 0 }, Seconds(950), true },
+		{ { 5, 0 }, Seconds(800), false },
+	};
+	const auto NumToSave = Scheduler.Schedule(Chunks, Seconds(1000), Seconds(1));
+	const int Order[] = { 1, 3, 4, 2, 5, 0 };
+	for (size_t i = 0; i < Chunks.size(); i++)
+	{
+		TEST_EQUAL(Chunks[i].m_Coords.m_ChunkX, Order[i]);
+	}
+
+	// The two due chunks, more than the configured rate:
+	TEST_EQUAL(NumToSave, 2U);
+	TEST_EQUAL(Scheduler.GetNumOverdue(), 1U);
+	TEST_EQUAL(Scheduler.GetOldestDirtyAge(), Seconds(400));
+}
+
+
+
+
+
+/** Checks that the chunks are spread over the interval, at most at the configured rate, and that the rates below a chunk
+per period still save chunks. */
+static void TestRate()
+{
+	cChunkSaveScheduler Scheduler;
+	Scheduler.Configure(Seconds(300), 100, 1000);
+
+	// 6000 chunks changed at once, to be saved within 300 seconds, need 20 chunks a second:
+	std::vector<sDirtyChunk> Chunks;
+	for (int i = 0; i < 6000; i++)
+	{
+		Chunks.push_back({ { i, 0 }, Seconds(0), false });
+	}
+	TEST_EQUAL(Scheduler.Schedule(Chunks, Seconds(0), Seconds(1)), 20U);
+
+	// A third of the time later, the remaining two thirds:
+	Chunks.erase(Chunks.begin() + 4000, Chunks.end());
+	TEST_EQUAL(Scheduler.Schedule(Chunks, Seconds(100), Seconds(1)), 20U);
+
+	// Limited by the configured rate until the rest is due:
+	Scheduler.Configure(Seconds(300), 10, 1000);
+	TEST_EQUAL(Scheduler.Schedule(Chunks, Seconds(100), Seconds(1)), 10U);
+	TEST_EQUAL(Scheduler.Schedule(Chunks, Seconds(299), Seconds(1)), 4000U);
+
+	// 100 chunks need a chunk every three seconds:
+	Chunks.erase(Chunks.begin() + 100, Chunks.end());
+	size_t NumSaved = 0;
+	for (int Second = 0; Second < 300; Second++)
+	{
+		const auto NumToSave = Scheduler.Schedule(Chunks, Seconds(Second), Seconds(1));
+		TEST_LESS_THAN_OR_EQUAL(NumToSave, 1U);
+		Chunks.erase(Chunks.begin(), Chunks.begin() + static_cast<std::ptrdiff_t>(NumToSave));
+		NumSaved += NumToSave;
+	}
+	TEST_EQUAL(NumSaved, 100U);
+	TEST_TRUE(Chunks.empty());
+}
+
+
+
+
+
+/** Checks that the unused chunks over the cap are saved regardless of the rate. */
+static void TestUnusedCap()
+{
+	cChunkSaveScheduler Scheduler;
+	Scheduler.Configure(Seconds(300), 1, 10);
+
+	std::vector<sDirtyChunk> Chunks;
+	for (int i = 0; i < 40; i++)
+	{
+		// Every other chunk is in use:
+		Chunks.push_back({ { i, 0 }, Seconds(100 - i), (i % 2) == 0 });
+	}
+	const auto NumToSave = Scheduler.Schedule(Chunks, Seconds(100), Seconds(1));
+	TEST_EQUAL(NumToSave, 10U);
+	for (size_t i = 0; i < Chunks.size(); i++)
+	{
+		TEST_EQUAL(Chunks[i].m_IsUnused, (i < 20));
+	}
+
+	// The unused chunks due count towards the ones to be saved:
+	Chunks[0].m_DirtySince = Seconds(-300);
+	Chunks[25].m_DirtySince = Seconds(-300);
+	TEST_EQUAL(Scheduler.Schedule(Chunks, Seconds(100), Seconds(1)), 11U);
+	TEST_EQUAL(Scheduler.GetNumOverdue(), 2U);
+}
+
+
+
+
+
+/** Simulates an hour of a world whose players change random chunks, saves what the scheduler picks each second
+and checks that no change waits longer than the interval. Compares the number of chunks saved, and the largest batch
+of them, with saving everything every interval. A few chunks are changed every second, such as by a redstone clock;
+they mustn't be saved any more often than by saving everything every interval. */
+static void TestSimulation()
+{
+	const int Interval = 300;
+	const int Duration = 3600;
+	const int NumBusyChunks = 10;
+	cChunkSaveScheduler Scheduler;
+	Scheduler.Configure(Seconds(Interval), 20, 1000);
+
+	cFastRandom Random;
+	std::map<int, cTickTimeLong> DirtySince;
+	std::map<int, size_t> NumBusySaved;
+	size_t MaxBatch = 0, NumSaved = 0;
+	size_t MaxSaveAllBatch = 0, NumSaveAllSaved = 0;
+	std::set<int> DirtySinceSaveAll;
+	for (int Second = 0; Second < Duration; Second++)
+	{
+		// A burst of changes, such as an explosion or newly generated chunks, once in a while:
+		const int NumChanges = ((Second % 600) == 0) ? 2000 : 8;
+		for (int i = 0; i < NumChanges; i++)
+		{
+			const int Chunk = Random.RandInt(0, 4000);
+			DirtySince.emplace(Chunk, Seconds(Second));
+			DirtySinceSaveAll.insert(Chunk);
+		}
+		for (int Chunk = -NumBusyChunks; Chunk < 0; Chunk++)
+		{
+			DirtySince.emplace(Chunk, Seconds(Second));
+			DirtySinceSaveAll.insert(Chunk);
+		}
+
+		std::vector<sDirtyChunk> Chunks;
+		for (const auto & [Chunk, Since]: DirtySince)
+		{
+			// The busy chunks are in use, they are being ticked:
+			Chunks.push_back({ { Chunk, 0 }, Since, (Chunk >= 0) && ((Chunk % 3) == 0) });
+		}
+		const auto NumToSave = Scheduler.Schedule(Chunks, Seconds(Second), Seconds(1));
+		TEST_EQUAL(Scheduler.GetNumOverdue(), 0U);
+		for (size_t i = 0; i < NumToSave; i++)
+		{
+			TEST_LESS_THAN_OR_EQUAL(Seconds(Second) - Chunks[i].m_DirtySince, Seconds(Interval));
+			DirtySince.erase(Chunks[i].m_Coords.m_ChunkX);
+			if (Chunks[i].m_Coords.m_ChunkX < 0)
+			{
+				NumBusySaved[Chunks[i].m_Coords.m_ChunkX] += 1;
+			}
+		}
+		MaxBatch = std::max(MaxBatch, NumToSave);
+		NumSaved += NumToSave;
+
+		if ((Second % Interval) == 0)
+		{
+			MaxSaveAllBatch = std::max(MaxSaveAllBatch, DirtySinceSaveAll.size());
+			NumSaveAllSaved += DirtySinceSaveAll.size();
+			DirtySinceSaveAll.clear();
+		}
+	}
+	NumSaveAllSaved += DirtySinceSaveAll.size();
+
+	// The bursts are spread out, yet no chunk is saved more often:
+	TEST_LESS_THAN_OR_EQUAL(MaxBatch * 10, MaxSaveAllBatch);
+	TEST_LESS_THAN_OR_EQUAL(NumSaved, NumSaveAllSaved);
+	TEST_EQUAL(NumBusySaved.size(), static_cast<size_t>(NumBusyChunks));
+	for (const auto & Busy: NumBusySaved)
+	{
+		TEST_LESS_THAN_OR_EQUAL(Busy.second, static_cast<size_t>(Duration / Interval + 1));
+	}
+	LOG("Saved %zu chunks in an hour, at most %zu in a second; saving all every %d seconds saves %zu, up to %zu at once",
+		NumSaved, MaxBatch, Interval, NumSaveAllSaved, MaxSaveAllBatch
+	);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("ChunkSaveScheduler",
+	TestPriority();
+	TestRate();
+	TestUnusedCap();
+	TestSimulation();
+)
@@ -0,0 +1,707 @@
+
+// CompactStorageTest.cpp
+
+// Tests the compact world storage: the section encoding, the lossless conversion from and to Anvil, the region file
+// and its section sharing; and compares its load and save throughput with the Anvil storage on a sample region set
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockType.h"
+#include "FastRandom.h"
+#include "OSSupport/File.h"
+#include "WorldStorage/CompactChunkSerializer.h"
+#include "WorldStorage/CompactRegionFile.h"
+#include "WorldStorage/CompactStorageConverter.h"
+#include "WorldStorage/FastNBT.h"
+
+
+
+
+
+namespace
+{
+	constexpr size_t SectionBlockCount = 16 * 16 * 16;
+	constexpr size_t SectionNibbleCount = SectionBlockCount / 2;
+
+	/** The folder for the files written by the test, relative to the current folder. */
+	const AString TestFolder = "CompactStorageTest.tmp";
+
+	/** The sample region set: the regions 0 and 1 on the X axis, each with all its 32 * 32 chunks. */
+	constexpr int NumSampleRegions = 2;
+
+
+
+
+
+	/** A section's blocks and light, as the chunk data keeps them. */
+	struct sSection
+	{
+		BLOCKTYPE m_Blocks[SectionBlockCount];
+		NIBBLETYPE m_Metas[SectionNibbleCount];
+		NIBBLETYPE m_BlockLight[SectionNibbleCount];
+		NIBBLETYPE m_SkyLight[SectionNibbleCount];
+
+		bool operator != (const sSection & a_Other) const
+		{
+			return (std::memcmp(this, &a_Other, sizeof(sSection)) != 0);
+		}
+	};
+
+	/** A chunk of the sample region set, the sections nullptr where the chunk doesn't store them. */
+	struct sSampleChunk
+	{
+		int m_ChunkX, m_ChunkZ;
+		std::array<std::unique_ptr<sSection>, cChunkDef::NumSections> m_Sections;
+		Byte m_Biomes[256];
+		int m_HeightMap[256];
+		bool m_HasChest;
+		bool m_IsFlat;
+	};
+
+
+
+
+
+	void SetNibble(NIBBLETYPE * a_Nibbles, const size_t a_Index, const NIBBLETYPE a_Value)
+	{
+		const auto Shift = (a_Index & 1) * 4;
+		a_Nibbles[a_Index / 2] = static_cast<NIBBLETYPE>((a_Nibbles[a_Index / 2] & ~(0x0f << Shift)) | ((a_Value & 0x0f) << Shift));
+	}
+
+
+
+
+
+	/** Generates a chunk resembling the generated terrain: bedrock, stone with ores and variants, dirt and grass
+	or sand under water, air above, with the skylight and some blocklight. Every eighth chunk is a superflat one instead. */
+	std::unique_ptr<sSampleChunk> GenerateChunk(const int a_ChunkX, const int a_ChunkZ, cFastRandom & a_Random)
+	{
+		auto Chunk = std::make_unique<sSampleChunk>();
+		Chunk->m_ChunkX = a_ChunkX;
+		Chunk->m_ChunkZ = a_ChunkZ;
+		Chunk->m_IsFlat = ((a_ChunkX + a_ChunkZ * 3) % 8) == 0;
+		Chunk->m_HasChest = a_Random.RandBool(0.2);
+		const int BaseHeight = Chunk->m_IsFlat ? 4 : 55 + a_Random.RandInt(0, 20);
+		int MaxHeight = 0;
+		for (size_t i = 0; i < 256; i++)
+		{
+			Chunk->m_HeightMap[i] = Chunk->m_IsFlat ? BaseHeight : BaseHeight + a_Random.RandInt(0, 3) + static_cast<int>(i % 16) / 4;
+			Chunk->m_Biomes[i] = static_cast<Byte>(Chunk->m_IsFlat ? 1 : ((Chunk->m_HeightMap[i] < 62) ? 0 : 4));
+			MaxHeight = std::max(MaxHeight, Chunk->m_HeightMap[i]);
+		}
+
+		for (int SectionY = 0; SectionY <= MaxHeight / 16 + 1; SectionY++)
+		{
+			auto Section = std::make_unique<sSection>();
+			std::memset(Section->m_BlockLight, 0, sizeof(Section->m_BlockLight));
+			for (size_t Index = 0; Index < SectionBlockCount; Index++)
+			{
+				// The ChunkDef block order within a section: x, then z, then y
+				const size_t Column = Index % 256;
+				const int y = SectionY * 16 + static_cast<int>(Index / 256);
+				const int Height = Chunk->m_HeightMap[Column];
+				BLOCKTYPE Block = E_BLOCK_AIR;
+				NIBBLETYPE Meta = 0;
+				if (y == 0)
+				{
+					Block = E_BLOCK_BEDROCK;
+				}
+				else if (Chunk->m_IsFlat)
+				{
+					Block = (y < Height) ? E_BLOCK_DIRT : ((y == Height) ? E_BLOCK_GRASS : E_BLOCK_AIR);
+				}
+				else if (y < Height - 4)
+				{
+					Block = E_BLOCK_STONE;
+					const int Ore = a_Random.RandInt(0, 199);
+					if (Ore < 2)
+					{
+						Block = E_BLOCK_COAL_ORE;
+					}
+					else if (Ore < 3)
+					{
+						Block = E_BLOCK_IRON_ORE;
+					}
+					else if (Ore < 10)
+					{
+						Meta = static_cast<NIBBLETYPE>(a_Random.RandInt(1, 6));
+					}
+				}
+				else if (y < Height)
+				{
+					Block = (Height < 62) ? E_BLOCK_SAND : E_BLOCK_DIRT;
+				}
+				else if (y == Height)
+				{
+					Block = (Height < 62) ? E_BLOCK_SAND : E_BLOCK_GRASS;
+				}
+				else if (y <= 62)
+				{
+					Block = E_BLOCK_STATIONARY_WATER;
+				}
+				Section->m_Blocks[Index] = Block;
+				SetNibble(Section->m_Metas, Index, Meta);
+				SetNibble(Section->m_SkyLight, Index, (y > Height) ? static_cast<NIBBLETYPE>(std::max(15 - std::max(62 - y, 0) * 3, 0)) : 0);
+				if ((Block == E_BLOCK_AIR) && (y == Height + 1) && a_Random.RandBool(0.01))
+				{
+					SetNibble(Section->m_BlockLight, Index, 14);
+				}
+			}
+			Chunk->m_Sections[static_cast<size_t>(SectionY)] = std::move(Section);
+		}
+		return Chunk;
+	}
+
+
+
+
+
+	/** Writes the chunk's Anvil NBT, in the NBTChunkSerializer's layout. Skips the "Sections" if a_WithSections is false. */
+	void WriteChunkNBT(cFastNBTWriter & a_Writer, const sSampleChunk & a_Chunk, const bool a_WithSections)
+	{
+		a_Writer.BeginCompound("Level");
+		a_Writer.AddInt("xPos", a_Chunk.m_ChunkX);
+		a_Writer.AddInt("zPos", a_Chunk.m_ChunkZ);
+		a_Writer.BeginList("Entities", TAG_Compound);
+		a_Writer.EndList();
+		a_Writer.BeginList("TileEntities", TAG_Compound);
+		if (a_Chunk.m_HasChest)
+		{
+			a_Writer.BeginCompound("");
+			a_Writer.AddString("id", "Chest");
+			a_Writer.AddInt("x", a_Chunk.m_ChunkX * 16 + 3);
+			a_Writer.AddInt("y", a_Chunk.m_HeightMap[3] + 1);
+			a_Writer.AddInt("z", a_Chunk.m_ChunkZ * 16);
+			a_Writer.BeginList("Items", TAG_Compound);
+			a_Writer.BeginCompound("");
+			a_Writer.AddShort("id", E_ITEM_DIAMOND);
+			a_Writer.AddShort("Damage", 0);
+			a_Writer.AddByte("Count", 3);
+			a_Writer.AddByte("Slot", 5);
+			a_Writer.EndCompound();
+			a_Writer.EndList();
+			a_Writer.EndCompound();
+		}
+		a_Writer.EndList();
+		a_Writer.AddByteArray("Biomes", reinterpret_cast<const char *>(a_Chunk.m_Biomes), ARRAYCOUNT(a_Chunk.m_Biomes));
+		a_Writer.AddIntArray("HeightMap", a_Chunk.m_HeightMap, ARRAYCOUNT(a_Chunk.m_HeightMap));
+		if (a_WithSections)
+		{
+			a_Writer.BeginList("Sections", TAG_Compound);
+			for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+			{
+				const auto & Section = a_Chunk.m_Sections[Y];
+				if (Section == nullptr)
+				{
+					continue;
+				}
+				a_Writer.BeginCompound("");
+				a_Writer.AddByteArray("Blocks", reinterpret_cast<const char *>(Section->m_Blocks), sizeof(Section->m_Blocks));
+				a_Writer.AddByteArray("Data", reinterpret_cast<const char *>(Section->m_Metas), sizeof(Section->m_Metas));
+				a_Writer.AddByteArray("BlockLight", reinterpret_cast<const char *>(Section->m_BlockLight), sizeof(Section->m_BlockLight));
+				a_Writer.AddByteArray("SkyLight", reinterpret_cast<const char *>(Section->m_SkyLight), sizeof(Section->m_SkyLight));
+				a_Writer.AddByte("Y", static_cast<unsigned char>(Y));
+				a_Writer.EndCompound();
+			}
+			a_Writer.EndList();
+		}
+		a_Writer.AddByte("MCSIsLightValid", 1);
+		a_Writer.AddLong("LastUpdate", 123456);
+		a_Writer.AddByte("TerrainPopulated", 1);
+		a_Writer.EndCompound();
+	}
+
+
+
+
+
+	ContiguousByteBuffer GetChunkNBT(const sSampleChunk & a_Chunk)
+	{
+		cFastNBTWriter Writer;
+		WriteChunkNBT(Writer, a_Chunk, true);
+		Writer.Finish();
+		return ContiguousByteBuffer(Writer.GetResult());
+	}
+
+
+
+
+
+	/** Returns true if the tags hold the same data. The compounds may have their children in any order;
+	the empty lists may have any children type. */
+	bool AreTagsEqual(const cParsedNBT & a_NBT1, const int a_Tag1, const cParsedNBT & a_NBT2, const int a_Tag2)
+	{
+		if ((a_NBT1.GetType(a_Tag1) != a_NBT2.GetType(a_Tag2)) || (a_NBT1.GetName(a_Tag1) != a_NBT2.GetName(a_Tag2)))
+		{
+			return false;
+		}
+		switch (a_NBT1.GetType(a_Tag1))
+		{
+			case TAG_Compound:
+			{
+				int NumChildren1 = 0, NumChildren2 = 0;
+				for (int Child = a_NBT1.GetFirstChild(a_Tag1); Child >= 0; Child = a_NBT1.GetNextSibling(Child))
+				{
+					const auto Other = a_NBT2.FindChildByName(a_Tag2, a_NBT1.GetName(Child));
+					if ((Other < 0) || !AreTagsEqual(a_NBT1, Child, a_NBT2, Other))
+					{
+						return false;
+					}
+					NumChildren1++;
+				}
+				for (int Child = a_NBT2.GetFirstChild(a_Tag2); Child >= 0; Child = a_NBT2.GetNextSibling(Child))
+				{
+					NumChildren2++;
+				}
+				return (NumChildren1 == NumChildren2);
+			}
+			case TAG_List:
+			{
+				int Child1 = a_NBT1.GetFirstChild(a_Tag1);
+				int Child2 = a_NBT2.GetFirstChild(a_Tag2);
+				for (; (Child1 >= 0) && (Child2 >= 0); Child1 = a_NBT1.GetNextSibling(Child1), Child2 = a_NBT2.GetNextSibling(Child2))
+				{
+					if (!AreTagsEqual(a_NBT1, Child1, a_NBT2, Child2))
+					{
+						return false;
+					}
+				}
+				return ((Child1 < 0) && (Child2 < 0));
+			}
+			default:
+			{
+				return (
+					(a_NBT1.GetDataLength(a_Tag1) == a_NBT2.GetDataLength(a_Tag2)) &&
+					(std::memcmp(a_NBT1.GetData(a_Tag1), a_NBT2.GetData(a_Tag2), a_NBT1.GetDataLength(a_Tag1)) == 0)
+				);
+			}
+		}
+	}
+
+
+
+
+
+	bool AreChunksEqual(const ContiguousByteBufferView a_NBT1, const ContiguousByteBufferView a_NBT2)
+	{
+		const cParsedNBT NBT1(a_NBT1);
+		const cParsedNBT NBT2(a_NBT2);
+		return NBT1.IsValid() && NBT2.IsValid() && AreTagsEqual(NBT1, NBT1.GetRoot(), NBT2, NBT2.GetRoot());
+	}
+
+
+
+
+
+	/** The sample region set, generated once for all the tests. */
+	std::vector<std::unique_ptr<sSampleChunk>> g_SampleChunks;
+
+	void GenerateSampleRegions()
+	{
+		cFastRandom Random;
+		for (int RegionX = 0; RegionX < NumSampleRegions; RegionX++)
+		{
+			for (int z = 0; z < 32; z++)
+			{
+				for (int x = 0; x < 32; x++)
+				{
+					g_SampleChunks.push_back(GenerateChunk(RegionX * 32 + x, z, Random));
+				}
+			}
+		}
+	}
+}  // namespace (anonymous)
+
+
+
+
+
+/** Checks that the sections of all kinds of palettes decode to what was encoded, and that broken data is refused. */
+static void TestSectionEncoding()
+{
+	cFastRandom Random;
+	auto Section = std::make_unique<sSection>();
+	auto Decoded = std::make_unique<sSection>();
+	for (const int NumStates: { 1, 2, 3, 16, 17, 300, 4096 })
+	{
+		for (size_t i = 0; i < SectionBlockCount; i++)
+		{
+			const int State = (NumStates == 4096) ? static_cast<int>(i) : Random.RandInt(0, NumStates - 1) * 37;
+			Section->m_Blocks[i] = static_cast<BLOCKTYPE>(State >> 4);
+			SetNibble(Section->m_Metas, i, static_cast<NIBBLETYPE>(State & 0x0f));
+		}
+		for (size_t i = 0; i < SectionNibbleCount; i++)
+		{
+			Section->m_BlockLight[i] = static_cast<NIBBLETYPE>(Random.RandInt(0, 255));
+			Section->m_SkyLight[i] = (NumStates % 2 == 0) ? 0xff : static_cast<NIBBLETYPE>(Random.RandInt(0, 255));
+		}
+
+		ContiguousByteBuffer Encoded;
+		cCompactChunkSerializer::EncodeSection(Encoded, Section->m_Blocks, Section->m_Metas, Section->m_BlockLight, Section->m_SkyLight);
+		TEST_TRUE(cCompactChunkSerializer::DecodeSection(Encoded, Decoded->m_Blocks, Decoded->m_Metas, Decoded->m_BlockLight, Decoded->m_SkyLight));
+		TEST_EQUAL(*Section, *Decoded);
+
+		// The same section encodes the same:
+		ContiguousByteBuffer Encoded2;
+		cCompactChunkSerializer::EncodeSection(Encoded2, Section->m_Blocks, Section->m_Metas, Section->m_BlockLight, Section->m_SkyLight);
+		TEST_EQUAL(Encoded, Encoded2);
+
+		// Truncated or extended data is refused:
+		TEST_FALSE(cCompactChunkSerializer::DecodeSection(ContiguousByteBufferView(Encoded).substr(0, Encoded.size() - 1), Decoded->m_Blocks, Decoded->m_Metas, Decoded->m_BlockLight, Decoded->m_SkyLight));
+		Encoded.push_back(std::byte(0));
+		TEST_FALSE(cCompactChunkSerializer::DecodeSection(Encoded, Decoded->m_Blocks, Decoded->m_Metas, Decoded->m_BlockLight, Decoded->m_SkyLight));
+	}
+
+	// The missing arrays are the defaults, a single-entry palette with uniform light takes just a few bytes:
+	ContiguousByteBuffer Encoded;
+	cCompactChunkSerializer::EncodeSection(Encoded, nullptr, nullptr, nullptr, nullptr);
+	TEST_EQUAL(Encoded.size(), 2U + 2U + 1U + 2U + 2U);
+	TEST_TRUE(cCompactChunkSerializer::DecodeSection(Encoded, Decoded->m_Blocks, Decoded->m_Metas, Decoded->m_BlockLight, Decoded->m_SkyLight));
+	TEST_EQUAL(Decoded->m_Blocks[1234], E_BLOCK_AIR);
+	TEST_EQUAL(Decoded->m_Metas[17], 0);
+	TEST_EQUAL(Decoded->m_BlockLight[17], 0);
+	TEST_EQUAL(Decoded->m_SkyLight[17], 0xff);
+}
+
+
+
+
+
+/** Checks that the chunks convert to the compact form and back to the same NBT, including the unusual ones. */
+static void TestChunkConversion()
+{
+	ContiguousByteBuffer Anvil;
+	sCompactChunk Compact;
+	for (size_t i = 0; i < g_SampleChunks.size(); i += 7)
+	{
+		const auto Original = GetChunkNBT(*g_SampleChunks[i]);
+		TEST_TRUE(cCompactChunkSerializer::AnvilToCompact(Original, Compact));
+		TEST_TRUE(cCompactChunkSerializer::CompactToAnvil(Compact, Anvil));
+		TEST_TRUE(AreChunksEqual(Original, Anvil));
+		TEST_FALSE(Compact.m_Sections[0].empty());
+		TEST_TRUE(Compact.m_Sections[15].empty());
+	}
+
+	// A section with an extra tag keeps all the sections in the NBT:
+	{
+		cFastNBTWriter Writer;
+		Writer.BeginCompound("Level");
+		Writer.AddByteArray("Biomes", 256, 1);
+		Writer.BeginList("Sections", TAG_Compound);
+		Writer.BeginCompound("");
+		Writer.AddByteArray("Blocks", SectionBlockCount, E_BLOCK_STONE);
+		Writer.AddByteArray("Add", SectionNibbleCount, 0);
+		Writer.AddByteArray("Data", SectionNibbleCount, 0);
+		Writer.AddByteArray("BlockLight", SectionNibbleCount, 0);
+		Writer.AddByteArray("SkyLight", SectionNibbleCount, 0);
+		Writer.AddByte("Y", 3);
+		Writer.EndCompound();
+		Writer.EndList();
+		Writer.EndCompound();
+		Writer.AddInt("DataVersion", 1343);
+		Writer.Finish();
+		const ContiguousByteBuffer Original(Writer.GetResult());
+		TEST_TRUE(cCompactChunkSerializer::AnvilToCompact(Original, Compact));
+		TEST_TRUE(Compact.m_Sections[3].empty());
+		TEST_TRUE(cCompactChunkSerializer::CompactToAnvil(Compact, Anvil));
+		TEST_TRUE(AreChunksEqual(Original, Anvil));
+	}
+
+	// No sections at all:
+	{
+		cFastNBTWriter Writer;
+		Writer.BeginCompound("Level");
+		Writer.BeginList("Sections", TAG_Compound);
+		Writer.EndList();
+		Writer.EndCompound();
+		Writer.Finish();
+		const ContiguousByteBuffer Original(Writer.GetResult());
+		TEST_TRUE(cCompactChunkSerializer::AnvilToCompact(Original, Compact));
+		TEST_TRUE(cCompactChunkSerializer::CompactToAnvil(Compact, Anvil));
+		TEST_TRUE(AreChunksEqual(Original, Anvil));
+	}
+
+	// Not a chunk:
+	{
+		cFastNBTWriter Writer;
+		Writer.AddInt("xPos", 1);
+		Writer.Finish();
+		TEST_FALSE(cCompactChunkSerializer::AnvilToCompact(Writer.GetResult(), Compact));
+	}
+}
+
+
+
+
+
+/** Checks the region file: storing, reopening, the sections shared between the chunks, compaction. */
+static void TestRegionFile()
+{
+	Compression::Compressor Compressor;
+	Compression::Extractor Extractor;
+	const auto FileName = TestFolder + "/r.0.0.cmr";
+	cFile::DeleteFile(FileName);
+
+	std::vector<sCompactChunk> Chunks(64);
+	{
+		cCompactRegionFile Region(FileName, 0, 0, Compressor, Extractor);
+		sCompactChunk Chunk;
+		TEST_FALSE(Region.GetChunk({ 0, 0 }, Chunk));
+		for (size_t i = 0; i < Chunks.size(); i++)
+		{
+			TEST_TRUE(cCompactChunkSerializer::AnvilToCompact(GetChunkNBT(*g_SampleChunks[i]), Chunks[i]));
+			TEST_TRUE(Region.SetChunk({ static_cast<int>(i % 32), static_cast<int>(i / 32) }, Chunks[i]));
+		}
+	}
+
+	// All the chunks read back the same from a reopened file, the flat ones share their sections:
+	size_t NumFlat = 0;
+	{
+		cCompactRegionFile Region(FileName, 0, 0, Compressor, Extractor);
+		TEST_EQUAL(Region.GetNumChunks(), Chunks.size());
+		sCompactChunk Chunk;
+		for (size_t i = 0; i < Chunks.size(); i++)
+		{
+			TEST_TRUE(Region.GetChunk({ static_cast<int>(i % 32), static_cast<int>(i / 32) }, Chunk));
+			TEST_EQUAL(Chunk.m_Sections, Chunks[i].m_Sections);
+			TEST_EQUAL(Chunk.m_Extras, Chunks[i].m_Extras);
+			NumFlat += g_SampleChunks[i]->m_IsFlat ? 1 : 0;
+		}
+		TEST_GREATER_THAN_OR_EQUAL(NumFlat, 2U);
+		TEST_LESS_THAN_OR_EQUAL(Region.GetNumSections() + NumFlat - 1, Region.GetNumSectionRefs());
+	}
+
+	// Overwriting the chunks over and over grows the file until it gets compacted; the chunks stay the same:
+	{
+		cCompactRegionFile Region(FileName, 0, 0, Compressor, Extractor);
+		const auto InitialSize = Region.GetFileSize();
+		UInt32 MaxSize = 0;
+		for (int Round = 0; Round < 20; Round++)
+		{
+			for (size_t i = 0; i < Chunks.size(); i++)
+			{
+				// Change one block, so that the chunks don't just share their sections with their older versions:
+				Chunks[i].m_Sections[1].clear();
+				auto Section = std::make_unique<sSection>();
+				std::memcpy(Section->m_Blocks, g_SampleChunks[i]->m_Sections[1]->m_Blocks, sizeof(Section->m_Blocks));
+				Section->m_Blocks[static_cast<size_t>(Round)] = E_BLOCK_GOLD_BLOCK;
+				const auto & Original = g_SampleChunks[i]->m_Sections[1];
+				cCompactChunkSerializer::EncodeSection(Chunks[i].m_Sections[1], Section->m_Blocks, Original->m_Metas, Original->m_BlockLight, Original->m_SkyLight);
+				TEST_TRUE(Region.SetChunk({ static_cast<int>(i % 32), static_cast<int>(i / 32) }, Chunks[i]));
+			}
+			MaxSize = std::max(MaxSize, Region.GetFileSize());
+		}
+		TEST_LESS_THAN_OR_EQUAL(InitialSize * 2, MaxSize);
+		TEST_TRUE(Region.Compact());
+
+		// The compacted file is no larger than a file with just the current chunks:
+		const auto FreshFileName = TestFolder + "/r.0.1.cmr";
+		cCompactRegionFile Fresh(FreshFileName, 0, 1, Compressor, Extractor);
+		for (size_t i = 0; i < Chunks.size(); i++)
+		{
+			TEST_TRUE(Fresh.SetChunk({ static_cast<int>(i % 32), 32 + static_cast<int>(i / 32) }, Chunks[i]));
+		}
+		TEST_LESS_THAN_OR_EQUAL(Region.GetFileSize(), Fresh.GetFileSize());
+		LOG("Region file of %zu chunks: %u bytes after compaction, up to %u bytes before", Chunks.size(), Region.GetFileSize(), MaxSize);
+	}
+	{
+		cCompactRegionFile Region(FileName, 0, 0, Compressor, Extractor);
+		sCompactChunk Chunk;
+		for (size_t i = 0; i < Chunks.size(); i++)
+		{
+			TEST_TRUE(Region.GetChunk({ static_cast<int>(i % 32), static_cast<int>(i / 32) }, Chunk));
+			TEST_EQUAL(Chunk.m_Sections, Chunks[i].m_Sections);
+			TEST_EQUAL(Chunk.m_Extras, Chunks[i].m_Extras);
+		}
+	}
+
+	// A file that isn't a compact region file is left alone:
+	{
+		const auto BadFileName = TestFolder + "/r.1.0.cmr";
+		cFile File(BadFileName, cFile::fmWrite);
+		File.Write("Not a region file, just some text that is long enough", 54);
+		File.Close();
+		cCompactRegionFile Region(BadFileName, 1, 0, Compressor, Extractor);
+		TEST_FALSE(Region.SetChunk({ 32, 0 }, Chunks[0]));
+		TEST_EQUAL(cFile::GetSize(BadFileName), 54);
+	}
+}
+
+
+
+
+
+/** Checks that a world converts to the compact storage and back without changing any chunk. */
+static void TestWorldConversion()
+{
+	const auto WorldFolder = TestFolder + "/world";
+	const auto RegionFolder = WorldFolder + "/region";
+	cFile::CreateFolderRecursive(RegionFolder);
+
+	cCompactStorageConverter Converter;
+	cCompactStorageConverter::cRegionChunks Original(cCompactStorageConverter::REGION_CHUNKS);
+	for (size_t i = 0; i < cCompactStorageConverter::REGION_CHUNKS; i += 3)
+	{
+		Original[i] = GetChunkNBT(*g_SampleChunks[i]);
+	}
+	TEST_TRUE(Converter.WriteMCAFile(RegionFolder + "/r.0.0.mca", Original));
+
+	const auto NumConverted = (cCompactStorageConverter::REGION_CHUNKS + 2) / 3;
+	TEST_EQUAL(Converter.ConvertWorld(WorldFolder, true), NumConverted);
+	TEST_TRUE(cFile::DeleteFile(RegionFolder + "/r.0.0.mca"));
+	TEST_EQUAL(Converter.ConvertWorld(WorldFolder, false), NumConverted);
+
+	cCompactStorageConverter::cRegionChunks Converted;
+	TEST_TRUE(Converter.ReadMCAFile(RegionFolder + "/r.0.0.mca", Converted));
+	for (size_t i = 0; i < cCompactStorageConverter::REGION_CHUNKS; i++)
+	{
+		TEST_EQUAL(Original[i].empty(), Converted[i].empty());
+		if (!Original[i].empty())
+		{
+			TEST_TRUE(AreChunksEqual(Original[i], Converted[i]));
+		}
+	}
+}
+
+
+
+
+
+/** Saves and loads the sample region set with the same codec path as cWSSAnvil (the chunk NBT, zlib, the MCA file)
+and with the compact storage; logs the throughput and the sizes. */
+static void BenchmarkStorages()
+{
+	using Clock = std::chrono::steady_clock;
+	auto Seconds = [](const Clock::duration a_Duration)
+	{
+		return std::chrono::duration<double>(a_Duration).count();
+	};
+	const auto NumChunks = g_SampleChunks.size();
+	cCompactStorageConverter Converter;  // For the MCA file access
+	Compression::Compressor Compressor;
+	Compression::Extractor Extractor;
+
+	// Anvil save: serialize each chunk into the NBT, compress and write the region files:
+	auto Start = Clock::now();
+	long AnvilSize = 0;
+	for (int RegionX = 0; RegionX < NumSampleRegions; RegionX++)
+	{
+		cCompactStorageConverter::cRegionChunks Chunks(cCompactStorageConverter::REGION_CHUNKS);
+		for (size_t i = 0; i < cCompactStorageConverter::REGION_CHUNKS; i++)
+		{
+			Chunks[i] = GetChunkNBT(*g_SampleChunks[static_cast<size_t>(RegionX) * 1024 + i]);
+		}
+		const auto FileName = fmt::format(FMT_STRING("{}/r.{}.0.mca"), TestFolder, RegionX);
+		TEST_TRUE(Converter.WriteMCAFile(FileName, Chunks));
+		AnvilSize += cFile::GetSize(FileName);
+	}
+	const auto AnvilSave = Seconds(Clock::now() - Start);
+
+	// Compact save: encode the sections, serialize the rest into the NBT and store each chunk:
+	Start = Clock::now();
+	long CompactSize = 0;
+	for (int RegionX = 0; RegionX < NumSampleRegions; RegionX++)
+	{
+		const auto FileName = fmt::format(FMT_STRING("{}/r.{}.0.cmr"), TestFolder, RegionX);
+		cFile::DeleteFile(FileName);
+		cCompactRegionFile Region(FileName, RegionX, 0, Compressor, Extractor);
+		sCompactChunk Compact;
+		for (size_t i = 0; i < cCompactStorageConverter::REGION_CHUNKS; i++)
+		{
+			const auto & Chunk = *g_SampleChunks[static_cast<size_t>(RegionX) * 1024 + i];
+			for (size_t Y = 0; Y < cChunkDef::NumSections; Y++)
+			{
+				Compact.m_Sections[Y].clear();
+				const auto & Section = Chunk.m_Sections[Y];
+				if (Section != nullptr)
+				{
+					cCompactChunkSerializer::EncodeSection(Compact.m_Sections[Y], Section->m_Blocks, Section->m_Metas, Section->m_BlockLight, Section->m_SkyLight);
+				}
+			}
+			cFastNBTWriter Writer;
+			WriteChunkNBT(Writer, Chunk, false);
+			Writer.Finish();
+			Compact.m_Extras = Writer.GetResult();
+			TEST_TRUE(Region.SetChunk({ Chunk.m_ChunkX, Chunk.m_ChunkZ }, Compact));
+		}
+		CompactSize += Region.GetFileSize();
+	}
+	const auto CompactSave = Seconds(Clock::now() - Start);
+
+	// Anvil load: read the region files, extract and parse each chunk's NBT and copy its sections:
+	auto Loaded = std::make_unique<sSection>();
+	Start = Clock::now();
+	size_t NumAnvilSections = 0;
+	for (int RegionX = 0; RegionX < NumSampleRegions; RegionX++)
+	{
+		cCompactStorageConverter::cRegionChunks Chunks;
+		TEST_TRUE(Converter.ReadMCAFile(fmt::format(FMT_STRING("{}/r.{}.0.mca"), TestFolder, RegionX), Chunks));
+		for (const auto & Data: Chunks)
+		{
+			const cParsedNBT NBT(Data);
+			TEST_TRUE(NBT.IsValid());
+			const int Sections = NBT.FindTagByPath(NBT.GetRoot(), "Level\\Sections");
+			for (int Section = NBT.GetFirstChild(Sections); Section >= 0; Section = NBT.GetNextSibling(Section))
+			{
+				std::memcpy(Loaded->m_Blocks, NBT.GetData(NBT.FindChildByName(Section, "Blocks")), SectionBlockCount);
+				std::memcpy(Loaded->m_Metas, NBT.GetData(NBT.FindChildByName(Section, "Data")), SectionNibbleCount);
+				std::memcpy(Loaded->m_BlockLight, NBT.GetData(NBT.FindChildByName(Section, "BlockLight")), SectionNibbleCount);
+				std::memcpy(Loaded->m_SkyLight, NBT.GetData(NBT.FindChildByName(Section, "SkyLight")), SectionNibbleCount);
+				NumAnvilSections++;
+			}
+		}
+	}
+	const auto AnvilLoad = Seconds(Clock::now() - Start);
+
+	// Compact load: read each chunk, decode its sections and parse the rest of the NBT:
+	Start = Clock::now();
+	size_t NumCompactSections = 0;
+	for (int RegionX = 0; RegionX < NumSampleRegions; RegionX++)
+	{
+		cCompactRegionFile Region(fmt::format(FMT_STRING("{}/r.{}.0.cmr"), TestFolder, RegionX), RegionX, 0, Compressor, Extractor);
+		sCompactChunk Compact;
+		for (size_t i = 0; i < cCompactStorageConverter::REGION_CHUNKS; i++)
+		{
+			const auto & Chunk = *g_SampleChunks[static_cast<size_t>(RegionX) * 1024 + i];
+			TEST_TRUE(Region.GetChunk({ Chunk.m_ChunkX, Chunk.m_ChunkZ }, Compact));
+			for (const auto & Section: Compact.m_Sections)
+			{
+				if (!Section.empty())
+				{
+					TEST_TRUE(cCompactChunkSerializer::DecodeSection(Section, Loaded->m_Blocks, Loaded->m_Metas, Loaded->m_BlockLight, Loaded->m_SkyLight));
+					NumCompactSections++;
+				}
+			}
+			const cParsedNBT NBT(Compact.m_Extras);
+			TEST_TRUE(NBT.IsValid());
+		}
+	}
+	const auto CompactLoad = Seconds(Clock::now() - Start);
+	TEST_EQUAL(NumAnvilSections, NumCompactSections);
+
+	// The compact storage is expected to be smaller; the times depend too much on the machine to check them:
+	TEST_LESS_THAN_OR_EQUAL(CompactSize, AnvilSize);
+	LOG("Sample region set: %zu chunks, %zu sections", NumChunks, NumAnvilSections);
+	LOG("  Anvil:   %ld bytes, save %.0f chunks/s, load %.0f chunks/s", AnvilSize, NumChunks / AnvilSave, NumChunks / AnvilLoad);
+	LOG("  Compact: %ld bytes, save %.0f chunks/s, load %.0f chunks/s", CompactSize, NumChunks / CompactSave, NumChunks / CompactLoad);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("CompactStorage",
+	if (cFile::IsFolder(TestFolder))
+	{
+		cFile::DeleteFolderContents(TestFolder);
+	}
+	cFile::CreateFolder(TestFolder);
+	GenerateSampleRegions();
+	TestSectionEncoding();
+	TestChunkConversion();
+	TestRegionFile();
+	TestWorldConversion();
+	BenchmarkStorages();
+	cFile::DeleteFolderContents(TestFolder);
+	cFile::DeleteFolder(TestFolder);
+)
@@ -0,0 +1,269 @@
+
+// CraftingRecipesTest.cpp
+
+// Replays every recipe in crafting.txt and checks that the indexed and cached recipe search finds the same recipes as trying all of them in turn
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "CraftingRecipes.h"
+#include "FastRandom.h"
+
+
+
+
+
+/** Exposes the search, and provides the search as it was before the indices: every recipe tried in turn. */
+class cCraftingRecipesTest:
+	public cCraftingRecipes
+{
+public:
+
+	using cCraftingRecipes::FindRecipe;
+	using cCraftingRecipes::m_Recipes;
+
+	cRecipe * FindRecipeLinear(const cItem * a_CraftingGrid, int a_GridWidth, int a_GridHeight)
+	{
+		// Crop the grid the same way FindRecipe() does:
+		int GridLeft = MAX_GRID_WIDTH, GridTop = MAX_GRID_HEIGHT;
+		int GridRight = 0, GridBottom = 0;
+		for (int y = 0; y < a_GridHeight; y++) for (int x = 0; x < a_GridWidth; x++)
+		{
+			if (!a_CraftingGrid[x + y * a_GridWidth].IsEmpty())
+			{
+				GridRight  = std::max(x, GridRight);
+				GridBottom = std::max(y, GridBottom);
+				GridLeft   = std::min(x, GridLeft);
+				GridTop    = std::min(y, GridTop);
+			}
+		}
+		int GridWidth = GridRight - GridLeft + 1;
+		int GridHeight = GridBottom - GridTop + 1;
+		const cItem * Grid = a_CraftingGrid + GridLeft + (a_GridWidth * GridTop);
+
+		for (const auto Recipe : m_Recipes)
+		{
+			for (int x = 0; x <= GridWidth - Recipe->m_Width; x++) for (int y = 0; y <= GridHeight - Recipe->m_Height; y++)
+			{
+				cRecipe * Res = MatchRecipe(Grid, GridWidth, GridHeight, a_GridWidth, Recipe, x, y);
+				if (Res != nullptr)
+				{
+					// Move the coords back to the whole grid, as FindRecipe() does:
+					for (auto & Slot : Res->m_Ingredients)
+					{
+						Slot.x += GridLeft;
+						Slot.y += GridTop;
+					}
+					return Res;
+				}
+			}
+		}
+		return nullptr;
+	}
+};
+
+
+
+
+
+/** Returns true if both searches found nothing, or the same result from the same ingredients. */
+static bool AreSameMatch(const cCraftingRecipes::cRecipe * a_Indexed, const cCraftingRecipes::cRecipe * a_Linear)
+{
+	if ((a_Indexed == nullptr) || (a_Linear == nullptr))
+	{
+		return (a_Indexed == a_Linear);
+	}
+	if (
+		!a_Indexed->m_Result.IsEqual(a_Linear->m_Result) ||
+		(a_Indexed->m_Result.m_ItemCount != a_Linear->m_Result.m_ItemCount) ||
+		(a_Indexed->m_Ingredients.size() != a_Linear->m_Ingredients.size())
+	)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a_Indexed->m_Ingredients.size(); i++)
+	{
+		const auto & Indexed = a_Indexed->m_Ingredients[i];
+		const auto & Linear = a_Linear->m_Ingredients[i];
+		if ((Indexed.x != Linear.x) || (Indexed.y != Linear.y) || !Indexed.m_Item.IsEqual(Linear.m_Item))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+/** Searches the grid with both searches, and with a cache twice, once filling it and once reusing it.
+Returns true if a recipe was found. */
+static bool CheckGrid(cCraftingRecipesTest & a_Recipes, const cItem * a_Grid, int a_GridSize)
+{
+	std::unique_ptr<cCraftingRecipes::cRecipe> Linear(a_Recipes.FindRecipeLinear(a_Grid, a_GridSize, a_GridSize));
+	std::unique_ptr<cCraftingRecipes::cRecipe> Indexed(a_Recipes.FindRecipe(a_Grid, a_GridSize, a_GridSize));
+	TEST_TRUE(AreSameMatch(Indexed.get(), Linear.get()));
+
+	cCraftingRecipes::cRecipeCache Cache;
+	for (int i = 0; i < 2; i++)
+	{
+		std::unique_ptr<cCraftingRecipes::cRecipe> Cached(a_Recipes.FindRecipe(a_Grid, a_GridSize, a_GridSize, &Cache));
+		TEST_TRUE(AreSameMatch(Cached.get(), Linear.get()));
+	}
+	return (Linear != nullptr);
+}
+
+
+
+
+
+/** Lays each recipe out in the 3x3 and 2x2 grids, at every offset it fits in, and checks that both searches agree.
+The "anywhere" ingredients take the free slots, the first ones their constraints allow. */
+static void TestAllRecipes(cCraftingRecipesTest & a_Recipes)
+{
+	size_t NumFound = 0, NumLaidOut = 0;
+	for (const auto Recipe : a_Recipes.m_Recipes)
+	{
+		for (int GridSize = 2; GridSize <= 3; GridSize++)
+		{
+			for (int OfsY = 0; OfsY <= GridSize - Recipe->m_Height; OfsY++) for (int OfsX = 0; OfsX <= GridSize - Recipe->m_Width; OfsX++)
+			{
+				cItem Grid[9];
+				bool IsLaidOut = true;
+				for (const auto & Slot : Recipe->m_Ingredients)
+				{
+					// Ingredients without a damage value take any, use something else than zero:
+					const short Damage = (Slot.m_Item.m_ItemDamage >= 0) ? Slot.m_Item.m_ItemDamage : 1;
+					const cItem Item(Slot.m_Item.m_ItemType, 1, Damage);
+					if ((Slot.x >= 0) && (Slot.y >= 0))
+					{
+						Grid[(Slot.x + OfsX) + (Slot.y + OfsY) * GridSize] = Item;
+						continue;
+					}
+					bool IsPlaced = false;
+					for (int Idx = 0; (Idx < GridSize * GridSize) && !IsPlaced; Idx++)
+					{
+						const int x = Idx % GridSize, y = Idx / GridSize;
+						if (((Slot.x >= 0) && (x != Slot.x)) || ((Slot.y >= 0) && (y != Slot.y)) || !Grid[Idx].IsEmpty())
+						{
+							continue;
+						}
+						Grid[Idx] = Item;
+						IsPlaced = true;
+					}
+					IsLaidOut = IsLaidOut && IsPlaced;
+				}
+				if (!IsLaidOut)
+				{
+					// Too many ingredients for the grid
+					continue;
+				}
+				NumLaidOut++;
+				if (CheckGrid(a_Recipes, Grid, GridSize))
+				{
+					NumFound++;
+				}
+
+				// An extra item in a free slot makes most of the recipes not match:
+				for (int Idx = 0; Idx < GridSize * GridSize; Idx++)
+				{
+					if (Grid[Idx].IsEmpty())
+					{
+						Grid[Idx] = Recipe->m_Ingredients.front().m_Item;
+						Grid[Idx].m_ItemCount = 1;
+						CheckGrid(a_Recipes, Grid, GridSize);
+						break;
+					}
+				}
+			}
+		}
+	}
+	LOG("Laid out %zu recipes, %zu of them found", NumLaidOut, NumFound);
+
+	// Each recipe fits in the 3x3 grid, and is found, possibly as another recipe of the same ingredients listed before it:
+	TEST_GREATER_THAN_OR_EQUAL(NumLaidOut, a_Recipes.m_Recipes.size());
+	TEST_EQUAL(NumFound, NumLaidOut);
+}
+
+
+
+
+
+/** Checks random grids of the ingredients used by the recipes, including stacks of no items that still have a type. */
+static void TestRandomGrids(cCraftingRecipesTest & a_Recipes)
+{
+	std::vector<cItem> Items;
+	for (const auto Recipe : a_Recipes.m_Recipes)
+	{
+		for (const auto & Slot : Recipe->m_Ingredients)
+		{
+			Items.emplace_back(Slot.m_Item.m_ItemType, 1, std::max<short>(Slot.m_Item.m_ItemDamage, 0));
+		}
+	}
+
+	cFastRandom Random;
+	for (int i = 0; i < 20000; i++)
+	{
+		cItem Grid[9];
+		const int GridSize = Random.RandInt(2, 3);
+		const int NumItems = Random.RandInt(1, GridSize * GridSize);
+		for (int n = 0; n < NumItems; n++)
+		{
+			auto & Slot = Grid[Random.RandInt(0, GridSize * GridSize - 1)];
+			Slot = Items[Random.RandInt<size_t>(0, Items.size() - 1)];
+			Slot.m_ItemCount = static_cast<char>(Random.RandInt(0, 2));
+		}
+		CheckGrid(a_Recipes, Grid, GridSize);
+	}
+}
+
+
+
+
+
+/** Compares the time spent searching the laid out recipes by both searches. */
+static void Benchmark(cCraftingRecipesTest & a_Recipes)
+{
+	std::vector<cItem> Grids;
+	for (const auto Recipe : a_Recipes.m_Recipes)
+	{
+		if (std::any_of(Recipe->m_Ingredients.begin(), Recipe->m_Ingredients.end(), [](const cCraftingRecipes::cRecipeSlot & a_Slot) { return (a_Slot.x < 0) || (a_Slot.y < 0); }))
+		{
+			continue;
+		}
+		Grids.resize(Grids.size() + 9);
+		auto Grid = Grids.end() - 9;
+		for (const auto & Slot : Recipe->m_Ingredients)
+		{
+			Grid[Slot.x + Slot.y * 3] = cItem(Slot.m_Item.m_ItemType, 1, std::max<short>(Slot.m_Item.m_ItemDamage, 0));
+		}
+	}
+
+	auto Measure = [&Grids](auto a_Find)
+	{
+		auto Start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < Grids.size(); i += 9)
+		{
+			std::unique_ptr<cCraftingRecipes::cRecipe> Recipe(a_Find(&Grids[i]));
+			TEST_NOTEQUAL(Recipe, nullptr);
+		}
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	};
+	const auto LinearTime = Measure([&a_Recipes](const cItem * a_Grid) { return a_Recipes.FindRecipeLinear(a_Grid, 3, 3); });
+	const auto IndexedTime = Measure([&a_Recipes](const cItem * a_Grid) { return a_Recipes.FindRecipe(a_Grid, 3, 3); });
+	LOG("Searching %zu shaped recipes: all recipes in turn %.2f ms, indexed %.2f ms",
+		Grids.size() / 9, LinearTime * 1000, IndexedTime * 1000
+	);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("CraftingRecipes",
+	cCraftingRecipesTest Recipes;
+	TEST_GREATER_THAN_OR_EQUAL(Recipes.m_Recipes.size(), 100U);
+	TestAllRecipes(Recipes);
+	TestRandomGrids(Recipes);
+	Benchmark(Recipes);
+)
@@ -0,0 +1,165 @@
+
+// EntityTrackerTest.cpp
+
+// Tests the cEntityTracker's tracking ranges and update intervals
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Entities/EntityTracker.h"
+
+
+
+
+
+namespace
+{
+
+/** Checks that a viewer moving away from an entity along each axis leaves its range exactly at the range's distance,
+and enters it again on the way back. */
+void TestRangeEntryAndExit(void)
+{
+	const Vector3d EntityPos(100.5, 64, -20.5);
+	const auto Params = cEntityTracker::GetParams(cEntity::etPickup, mtInvalidType, false);
+	const auto Range = static_cast<double>(Params.m_Range);
+
+	TEST_TRUE(cEntityTracker::IsInRange(EntityPos, EntityPos, Params));
+	for (const auto & Axis : { Vector3d(1, 0, 0), Vector3d(0, 1, 0), Vector3d(0, 0, 1) })
+	{
+		for (const double Sign : { -1.0, 1.0 })
+		{
+			const auto Direction = Axis * Sign;
+
+			// Walk out of the range and back in, counting the transitions:
+			int NumExits = 0, NumEntries = 0;
+			bool WasInRange = true;
+			for (int Step = 0; Step <= 2 * (Params.m_Range + 10); Step++)
+			{
+				const auto Distance = (Step <= Params.m_Range + 10) ? Step : (2 * (Params.m_Range + 10) - Step);
+				const bool IsInRange = cEntityTracker::IsInRange(EntityPos + Direction * Distance, EntityPos, Params);
+				TEST_EQUAL(IsInRange, (Distance <= Params.m_Range));
+				NumExits += (WasInRange && !IsInRange) ? 1 : 0;
+				NumEntries += (!WasInRange && IsInRange) ? 1 : 0;
+				WasInRange = IsInRange;
+			}
+			TEST_EQUAL(NumExits, 1);
+			TEST_EQUAL(NumEntries, 1);
+		}
+
+		// The range is inclusive:
+		TEST_TRUE(cEntityTracker::IsInRange(EntityPos + Axis * Range, EntityPos, Params));
+		TEST_FALSE(cEntityTracker::IsInRange(EntityPos + Axis * (Range + 0.01), EntityPos, Params));
+	}
+
+	// A viewer far above or below is out of range, even right above the entity:
+	TEST_FALSE(cEntityTracker::IsInRange(EntityPos + Vector3d(0, Range + 1, 0), EntityPos, Params));
+	TEST_FALSE(cEntityTracker::IsInRange(EntityPos - Vector3d(0, Range + 1, 0), EntityPos, Params));
+
+	// Players are seen from much further away than pickups:
+	const auto PlayerParams = cEntityTracker::GetParams(cEntity::etPlayer, mtInvalidType, false);
+	TEST_TRUE(cEntityTracker::IsInRange(EntityPos + Vector3d(Range + 1, 0, 0), EntityPos, PlayerParams));
+}
+
+
+
+
+
+/** Checks the update interval of each entity class, and that the updates come exactly that often. */
+void TestUpdateIntervals(void)
+{
+	const std::pair<cEntityTracker::sParams, int> Expected[] =
+	{
+		{ cEntityTracker::GetParams(cEntity::etPlayer,       mtInvalidType, false), 2 },
+		{ cEntityTracker::GetParams(cEntity::etMonster,      mtZombie,      false), 3 },
+		{ cEntityTracker::GetParams(cEntity::etMonster,      mtEnderDragon, false), 3 },
+		{ cEntityTracker::GetParams(cEntity::etMinecart,     mtInvalidType, false), 3 },
+		{ cEntityTracker::GetParams(cEntity::etFloater,      mtInvalidType, false), 5 },
+		{ cEntityTracker::GetParams(cEntity::etTNT,          mtInvalidType, false), 10 },
+		{ cEntityTracker::GetParams(cEntity::etProjectile,   mtInvalidType, false), 10 },
+		{ cEntityTracker::GetParams(cEntity::etProjectile,   mtInvalidType, true),  20 },
+		{ cEntityTracker::GetParams(cEntity::etPickup,       mtInvalidType, false), 20 },
+		{ cEntityTracker::GetParams(cEntity::etExpOrb,       mtInvalidType, false), 20 },
+		{ cEntityTracker::GetParams(cEntity::etFallingBlock, mtInvalidType, false), 20 },
+	};
+	for (const auto & [Params, Interval] : Expected)
+	{
+		TEST_EQUAL(Params.m_UpdateInterval, Interval);
+
+		// Each entity gets an update exactly every Interval ticks, whatever its ID:
+		for (UInt32 EntityID = 0; EntityID < 50; EntityID++)
+		{
+			int LastUpdate = -1;
+			for (int Tick = 0; Tick < 200; Tick++)
+			{
+				if (!cEntityTracker::ShouldUpdate(cTickTimeLong(Tick), EntityID, Params))
+				{
+					continue;
+				}
+				if (LastUpdate >= 0)
+				{
+					TEST_EQUAL(Tick - LastUpdate, Interval);
+				}
+				else
+				{
+					TEST_LESS_THAN_OR_EQUAL(Tick, Interval - 1);
+				}
+				LastUpdate = Tick;
+			}
+		}
+	}
+
+	// The entities that don't move on their own never get an update:
+	for (const auto EntityType : { cEntity::etItemFrame, cEntity::etPainting, cEntity::etLeashKnot, cEntity::etEnderCrystal })
+	{
+		const auto Params = cEntityTracker::GetParams(EntityType, mtInvalidType, false);
+		TEST_EQUAL(Params.m_UpdateInterval, 0);
+		for (int Tick = 0; Tick < 100; Tick++)
+		{
+			TEST_FALSE(cEntityTracker::ShouldUpdate(cTickTimeLong(Tick), 7, Params));
+		}
+	}
+}
+
+
+
+
+
+/** Checks that the entities with the same interval are spread over the ticks,
+and that exactly one update in each resync period carries the absolute position. */
+void TestSpreadAndResync(void)
+{
+	const auto Params = cEntityTracker::GetParams(cEntity::etPickup, mtInvalidType, false);
+	std::vector<int> NumUpdatesPerTick(static_cast<size_t>(Params.m_UpdateInterval));
+	for (UInt32 EntityID = 0; EntityID < 200; EntityID++)
+	{
+		int NumResyncs = 0;
+		for (int Tick = 0; Tick < cEntityTracker::RESYNC_INTERVAL; Tick++)
+		{
+			if (!cEntityTracker::ShouldUpdate(cTickTimeLong(Tick), EntityID, Params))
+			{
+				continue;
+			}
+			if (Tick < Params.m_UpdateInterval)
+			{
+				NumUpdatesPerTick[static_cast<size_t>(Tick)] += 1;
+			}
+			NumResyncs += cEntityTracker::ShouldResync(cTickTimeLong(Tick), EntityID, Params) ? 1 : 0;
+		}
+		TEST_EQUAL(NumResyncs, 1);
+	}
+	for (const auto NumUpdates : NumUpdatesPerTick)
+	{
+		TEST_EQUAL(NumUpdates, 200 / Params.m_UpdateInterval);
+	}
+}
+
+}  // namespace (anonymous)
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("EntityTracker",
+	TestRangeEntryAndExit();
+	TestUpdateIntervals();
+	TestSpreadAndResync();
+)
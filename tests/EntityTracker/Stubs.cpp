@@ -0,0 +1,50 @@
+
+// Stubs.cpp
+
+// Implements stubs of various Cuberite methods that are needed for linking but not for runtime
+// This is required so that we don't bring in the entire Cuberite via dependencies
+
+#include "Globals.h"
+#include "ClientHandle.h"
+#include "World.h"
+
+
+
+
+
+static cCriticalSection g_WorldCS;
+
+
+
+
+
+cWorld::cLock::cLock(const cWorld & a_World) :
+	Super(&g_WorldCS)
+{
+}
+
+
+
+
+
+cTickTimeLong cWorld::GetWorldTickAge() const
+{
+	return cTickTimeLong(0);
+}
+
+
+
+
+
+bool cClientHandle::StartTrackingEntity(const UInt32 a_EntityID)
+{
+	return false;
+}
+
+
+
+
+
+void cClientHandle::StopTrackingEntity(const UInt32 a_EntityID)
+{
+}
@@ -0,0 +1,219 @@
+
+// FluidQueueTest.cpp
+
+// Tests the queue of blocks to simulate used by cDelayedFluidSimulator and compares it to the former linear-scan queue
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Simulator/DelayedFluidSimulator.h"
+
+
+
+
+
+using cSlot = cDelayedFluidSimulatorChunkData::cSlot;
+
+
+
+
+
+/** The queue as it was before the bitmaps, searching the blocks of the same Z coord for a duplicate on each add. */
+class cLinearSlot
+{
+public:
+
+	bool Add(int a_RelX, int a_RelY, int a_RelZ)
+	{
+		auto & Blocks = m_Blocks[a_RelZ];
+		const auto Index = cChunkDef::MakeIndex(a_RelX, a_RelY, a_RelZ);
+		for (const auto & Block : Blocks)
+		{
+			if (Block.Data == Index)
+			{
+				return false;
+			}
+		}
+		Blocks.emplace_back(a_RelX, a_RelY, a_RelZ, Index);
+		return true;
+	}
+
+	size_t TakeAll(void)
+	{
+		size_t Res = 0;
+		for (auto & Blocks: m_Blocks)
+		{
+			Res += Blocks.size();
+			Blocks.clear();
+		}
+		return Res;
+	}
+
+	std::vector<cCoordWithData<size_t>> m_Blocks[16];
+};
+
+
+
+
+
+static size_t TakeAll(cSlot & a_Slot)
+{
+	std::vector<cCoordWithData<size_t>> Blocks[cChunkDef::Width];
+	a_Slot.TakeAll(Blocks);
+	size_t Res = 0;
+	for (const auto & BlocksZ: Blocks)
+	{
+		Res += BlocksZ.size();
+	}
+	return Res;
+}
+
+
+
+
+
+static size_t TakeAll(cLinearSlot & a_Slot)
+{
+	return a_Slot.TakeAll();
+}
+
+
+
+
+
+/** Checks the duplicate detection and that taking the blocks empties the slot. */
+static void TestSlot()
+{
+	cSlot Slot;
+	TEST_FALSE(Slot.HasBlock(1, 2, 3));
+	TEST_TRUE(Slot.Add(1, 2, 3));
+	TEST_TRUE(Slot.HasBlock(1, 2, 3));
+	TEST_FALSE(Slot.Add(1, 2, 3));
+
+	// The same position within another section is a different block:
+	TEST_FALSE(Slot.HasBlock(1, 2 + cChunkDef::SectionHeight, 3));
+	TEST_TRUE(Slot.Add(1, 2 + cChunkDef::SectionHeight, 3));
+	TEST_TRUE(Slot.Add(15, 255, 15));
+	TEST_EQUAL(Slot.m_Blocks[3].size(), 2U);
+	TEST_EQUAL(Slot.m_Blocks[15].size(), 1U);
+
+	std::vector<cCoordWithData<size_t>> Blocks[cChunkDef::Width];
+	Slot.TakeAll(Blocks);
+	TEST_EQUAL(Blocks[3].size(), 2U);
+	TEST_EQUAL(Blocks[3][1].y, 2 + cChunkDef::SectionHeight);
+	TEST_EQUAL(Blocks[15][0].Data, cChunkDef::MakeIndex(15, 255, 15));
+	TEST_FALSE(Slot.HasBlock(1, 2, 3));
+	TEST_TRUE(Slot.m_Blocks[3].empty());
+
+	// The taken blocks can be queued again:
+	TEST_TRUE(Slot.Add(1, 2, 3));
+}
+
+
+
+
+
+/** Replays the wake-ups of a 64 x 64 lake being drained and refilled, as a diagonal front of changed blocks moving
+across it, a step per tick. Each changed block wakes itself and its neighbors, into the slots of their chunks.
+Returns the number of blocks that were queued for simulating. */
+template <class SlotType>
+static size_t ReplayLake(int a_Depth)
+{
+	const int LakeSize = 64;
+	const int NumChunks = LakeSize / cChunkDef::Width;
+	const int TickDelay = 5;
+	const int Surface = 62;
+	std::vector<SlotType> Slots(static_cast<size_t>(NumChunks * NumChunks * TickDelay));
+
+	size_t NumQueued = 0;
+	int Tick = 0;
+	for (int Pass = 0; Pass < 2; Pass++)
+	{
+		// The drain empties the lake from one corner, the refill floods it from the opposite one:
+		for (int Step = 0; Step <= 2 * (LakeSize - 1); Step++, Tick++)
+		{
+			const int AddSlot = Tick % TickDelay;
+			const int Diagonal = (Pass == 0) ? Step : 2 * (LakeSize - 1) - Step;
+			for (int X = std::max(0, Diagonal - LakeSize + 1); X <= std::min(Diagonal, LakeSize - 1); X++)
+			{
+				const int Z = Diagonal - X;
+				for (int Y = Surface - a_Depth + 1; Y <= Surface; Y++)
+				{
+					for (const auto & Offset: { Vector3i(0, 0, 0), Vector3i(1, 0, 0), Vector3i(-1, 0, 0), Vector3i(0, 1, 0), Vector3i(0, -1, 0), Vector3i(0, 0, 1), Vector3i(0, 0, -1) })
+					{
+						const auto Pos = Vector3i(X, Y, Z) + Offset;
+						if ((Pos.x < 0) || (Pos.x >= LakeSize) || (Pos.z < 0) || (Pos.z >= LakeSize))
+						{
+							continue;
+						}
+						const auto Chunk = (Pos.x / cChunkDef::Width) + (Pos.z / cChunkDef::Width) * NumChunks;
+						Slots[static_cast<size_t>(Chunk * TickDelay + AddSlot)].Add(Pos.x % cChunkDef::Width, Pos.y, Pos.z % cChunkDef::Width);
+					}
+				}
+			}
+
+			// Simulate the slot after the one just added to, in all the chunks:
+			const int SimSlot = (Tick + 1) % TickDelay;
+			for (int Chunk = 0; Chunk < NumChunks * NumChunks; Chunk++)
+			{
+				NumQueued += TakeAll(Slots[static_cast<size_t>(Chunk * TickDelay + SimSlot)]);
+			}
+		}
+	}
+	for (auto & Slot: Slots)
+	{
+		NumQueued += TakeAll(Slot);
+	}
+	return NumQueued;
+}
+
+
+
+
+
+/** Compares the time spent queueing the lake's wake-ups by both queues, for a shallow lake and an ocean. */
+static void Benchmark()
+{
+	for (int Depth: { 8, 60 })
+	{
+		const int NumRepeats = 2;
+		auto Measure = [](auto a_Process)
+		{
+			auto Start = std::chrono::steady_clock::now();
+			a_Process();
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		};
+		size_t LinearQueued = 0;
+		size_t BitmapQueued = 0;
+		const auto LinearTime = Measure([&]()
+			{
+				for (int i = 0; i < NumRepeats; i++)
+				{
+					LinearQueued = ReplayLake<cLinearSlot>(Depth);
+				}
+			}
+		);
+		const auto BitmapTime = Measure([&]()
+			{
+				for (int i = 0; i < NumRepeats; i++)
+				{
+					BitmapQueued = ReplayLake<cSlot>(Depth);
+				}
+			}
+		);
+
+		// Both queues must keep exactly the same blocks:
+		TEST_EQUAL(LinearQueued, BitmapQueued);
+		LOG("Lake 64 x 64 x %d: %zu blocks queued; linear scan %.2f ms, bitmaps %.2f ms per drain and refill",
+			Depth, BitmapQueued, LinearTime * 1000 / NumRepeats, BitmapTime * 1000 / NumRepeats
+		);
+	}
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("FluidQueue",
+	TestSlot();
+	Benchmark();
+)
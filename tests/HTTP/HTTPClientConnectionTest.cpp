@@ -0,0 +1,302 @@
+
+// HTTPClientConnectionTest.cpp
+
+// Tests the cHTTPClientConnection class against a local mock of the session server
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "HTTP/HTTPClientConnection.h"
+#include "OSSupport/NetworkSingleton.h"
+
+
+
+
+
+namespace
+{
+
+/** The URL of the mock session server. It listens on any free port, the URL is set once it is known. */
+AString g_MockServerUrl;
+
+/** The number of connections accepted by the mock server so far. */
+std::atomic<int> g_NumAccepted{ 0 };
+
+/** All the links accepted by the mock server, so that the test can drop them as if idle-timed out. */
+cCriticalSection g_CSLinks;
+std::vector<cTCPLinkPtr> g_Links;
+
+
+
+
+
+/** Link callbacks of the mock session server.
+Replies to "/session/minecraft/hasJoined?username=<name>&serverId=<id>" similarly to the real server. Special names:
+	- "Unknown" receives an empty 204 reply, same as a client that didn't join;
+	- "Slow" receives no reply at all;
+	- "Close" receives a reply with "Connection: close" and the connection is closed afterwards. */
+class cMockSessionLink:
+	public cTCPLink::cCallbacks
+{
+	cTCPLinkPtr m_Link;
+	AString m_Incoming;
+
+
+	virtual void OnLinkCreated(cTCPLinkPtr a_Link) override
+	{
+		m_Link = a_Link;
+		cCSLock Lock(g_CSLinks);
+		g_Links.push_back(std::move(a_Link));
+	}
+
+
+	virtual void OnReceivedData(const char * a_Data, size_t a_Length) override
+	{
+		m_Incoming.append(a_Data, a_Length);
+		for (;;)
+		{
+			auto End = m_Incoming.find("\r\n\r\n");
+			if (End == AString::npos)
+			{
+				return;
+			}
+			auto Request = m_Incoming.substr(0, End);
+			m_Incoming.erase(0, End + 4);
+			Reply(Request);
+		}
+	}
+
+
+	void Reply(const AString & a_Request)
+	{
+		auto NameStart = a_Request.find("username=");
+		auto NameEnd = a_Request.find('&', NameStart);
+		if ((NameStart == AString::npos) || (NameEnd == AString::npos))
+		{
+			m_Link->Send("HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+			return;
+		}
+		auto Name = a_Request.substr(NameStart + 9, NameEnd - NameStart - 9);
+		if (Name == "Slow")
+		{
+			return;
+		}
+		if (Name == "Unknown")
+		{
+			m_Link->Send("HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
+			return;
+		}
+		auto Body = fmt::format(FMT_STRING("{{\"id\":\"0123456789abcdef0123456789abcdef\",\"name\":\"{}\",\"properties\":[]}}"), Name);
+		auto Connection = (Name == "Close") ? "close" : "keep-alive";
+		m_Link->Send(fmt::format(
+			FMT_STRING("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: {}\r\nConnection: {}\r\n\r\n{}"),
+			Body.size(), Connection, Body
+		));
+		if (Name == "Close")
+		{
+			m_Link->Shutdown();
+		}
+	}
+
+
+	virtual void OnRemoteClosed(void) override
+	{
+		m_Link.reset();
+	}
+
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		m_Link.reset();
+	}
+};
+
+
+
+
+
+class cMockSessionServer:
+	public cNetwork::cListenCallbacks
+{
+	virtual cTCPLink::cCallbacksPtr OnIncomingConnection(const AString & a_RemoteIPAddress, UInt16 a_RemotePort) override
+	{
+		return std::make_shared<cMockSessionLink>();
+	}
+
+
+	virtual void OnAccepted(cTCPLink & a_Link) override
+	{
+		++g_NumAccepted;
+	}
+
+
+	virtual void OnError(int a_ErrorCode, const AString & a_ErrorMsg) override
+	{
+		LOGWARNING("Mock session server: listening error %d (%s)", a_ErrorCode, a_ErrorMsg.c_str());
+	}
+};
+
+
+
+
+
+AString JoinPath(const AString & a_UserName)
+{
+	return fmt::format(FMT_STRING("/session/minecraft/hasJoined?username={}&serverId=abc"), a_UserName);
+}
+
+
+
+
+
+/** Sends multiple requests over a single connection object, checks that they all go over a single TCP connection. */
+void TestKeepAlive(void)
+{
+	const auto NumAcceptedBefore = g_NumAccepted.load();
+	cHTTPClientConnection Connection(g_MockServerUrl);
+	TEST_TRUE(Connection.IsValid());
+	for (int i = 0; i < 20; i++)
+	{
+		auto Name = fmt::format(FMT_STRING("Player{}"), i);
+		auto Response = Connection.Get(JoinPath(Name), std::chrono::seconds(5));
+		TEST_TRUE(Response.m_IsSuccessful);
+		TEST_EQUAL(Response.m_StatusCode, 200);
+		TEST_NOTEQUAL(Response.m_Body.find(Name), AString::npos);
+	}
+	TEST_EQUAL(Connection.GetNumConnectionsOpened(), 1U);
+	TEST_EQUAL(g_NumAccepted.load() - NumAcceptedBefore, 1);
+
+	// A 204 reply is a complete response without a body:
+	auto Response = Connection.Get(JoinPath("Unknown"), std::chrono::seconds(5));
+	TEST_TRUE(Response.m_IsSuccessful);
+	TEST_EQUAL(Response.m_StatusCode, 204);
+	TEST_TRUE(Response.m_Body.empty());
+	TEST_EQUAL(Connection.GetNumConnectionsOpened(), 1U);
+}
+
+
+
+
+
+/** Checks that the connection is reopened when the server closes it, either announced or while idle. */
+void TestReconnect(void)
+{
+	cHTTPClientConnection Connection(g_MockServerUrl);
+	TEST_TRUE(Connection.Get(JoinPath("Close"), std::chrono::seconds(5)).m_IsSuccessful);
+	TEST_TRUE(Connection.Get(JoinPath("Player"), std::chrono::seconds(5)).m_IsSuccessful);
+	TEST_EQUAL(Connection.GetNumConnectionsOpened(), 2U);
+
+	// Drop all the connections on the server side, as if they timed out; the request must still succeed:
+	{
+		cCSLock Lock(g_CSLinks);
+		for (auto & Link : g_Links)
+		{
+			Link->Shutdown();
+		}
+		g_Links.clear();
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	auto Response = Connection.Get(JoinPath("Player"), std::chrono::seconds(5));
+	TEST_TRUE(Response.m_IsSuccessful);
+	TEST_EQUAL(Response.m_StatusCode, 200);
+	TEST_EQUAL(Connection.GetNumConnectionsOpened(), 3U);
+}
+
+
+
+
+
+/** Checks that an unanswered request times out, and that the next request uses a fresh connection. */
+void TestTimeout(void)
+{
+	cHTTPClientConnection Connection(g_MockServerUrl);
+	const auto Start = std::chrono::steady_clock::now();
+	auto Response = Connection.Get(JoinPath("Slow"), std::chrono::milliseconds(300));
+	const auto Elapsed = std::chrono::steady_clock::now() - Start;
+	TEST_FALSE(Response.m_IsSuccessful);
+	TEST_GREATER_THAN_OR_EQUAL(Elapsed, std::chrono::milliseconds(300));
+	TEST_LESS_THAN_OR_EQUAL(Elapsed, std::chrono::seconds(3));
+
+	// The late reply to the timed out request mustn't be mistaken for the reply to the next one:
+	Response = Connection.Get(JoinPath("Player"), std::chrono::seconds(5));
+	TEST_TRUE(Response.m_IsSuccessful);
+	TEST_EQUAL(Connection.GetNumConnectionsOpened(), 2U);
+}
+
+
+
+
+
+/** Checks that nothing listening on the port is reported as a failure, rather than a hang. */
+void TestNoServer(void)
+{
+	// Find a free port by listening on it and closing it right away:
+	auto Server = cNetwork::Listen(0, std::make_shared<cMockSessionServer>());
+	TEST_TRUE(Server->IsListening());
+	const auto Port = Server->GetPort();
+	Server->Close();
+
+	cHTTPClientConnection Connection(fmt::format(FMT_STRING("http://localhost:{}"), Port));
+	auto Response = Connection.Get(JoinPath("Player"), std::chrono::seconds(5));
+	TEST_FALSE(Response.m_IsSuccessful);
+}
+
+
+
+
+
+/** Runs several connections in parallel, as the authenticator workers do. */
+void TestConcurrent(void)
+{
+	const auto NumAcceptedBefore = g_NumAccepted.load();
+	std::atomic<int> NumSucceeded{ 0 };
+	std::vector<std::thread> Threads;
+	for (int t = 0; t < 4; t++)
+	{
+		Threads.emplace_back([t, &NumSucceeded]()
+		{
+			cHTTPClientConnection Connection(g_MockServerUrl);
+			for (int i = 0; i < 25; i++)
+			{
+				auto Name = fmt::format(FMT_STRING("Player{}x{}"), t, i);
+				auto Response = Connection.Get(JoinPath(Name), std::chrono::seconds(5));
+				if (Response.m_IsSuccessful && (Response.m_Body.find(Name) != AString::npos))
+				{
+					++NumSucceeded;
+				}
+			}
+		});
+	}
+	for (auto & Thread : Threads)
+	{
+		Thread.join();
+	}
+	TEST_EQUAL(NumSucceeded.load(), 100);
+	TEST_EQUAL(g_NumAccepted.load() - NumAcceptedBefore, 4);
+}
+
+}  // namespace (anonymous)
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("HTTPClientConnection",
+	cNetworkSingleton::Get().Initialise();
+	auto Server = cNetwork::Listen(0, std::make_shared<cMockSessionServer>());
+	TEST_TRUE(Server->IsListening());
+	TEST_NOTEQUAL(Server->GetPort(), 0);
+	g_MockServerUrl = fmt::format(FMT_STRING("http://localhost:{}"), Server->GetPort());
+
+	TestKeepAlive();
+	TestReconnect();
+	TestTimeout();
+	TestNoServer();
+	TestConcurrent();
+
+	Server->Close();
+	{
+		cCSLock Lock(g_CSLinks);
+		g_Links.clear();
+	}
+	cNetworkSingleton::Get().Terminate();
+)
@@ -0,0 +1,174 @@
+
+// MetricsTest.cpp
+
+// Tests the cMetrics registry and its OpenMetrics text output
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Metrics.h"
+
+
+
+
+
+namespace
+{
+
+/** Returns true if the output contains the specified line. */
+bool HasLine(const AString & a_Output, const AString & a_Line)
+{
+	return (("\n" + a_Output).find("\n" + a_Line + "\n") != AString::npos);
+}
+
+
+
+
+
+/** Checks the output of each metric type, including the histogram's cumulative buckets. */
+void TestSerialize(void)
+{
+	auto & Counter = cMetrics::GetCounter("test_events", "Number of test events");
+	Counter.Inc();
+	Counter.Inc(2);
+	TEST_EQUAL(&Counter, &cMetrics::GetCounter("test_events", "Number of test events"));
+
+	cMetrics::GetGauge("test_queue_length", "Length of a queue", cMetrics::FormatLabels({{"world", "a"}})).Set(5);
+	cMetrics::GetGauge("test_queue_length", "Length of a queue", cMetrics::FormatLabels({{"world", "b"}})).Set(0.5);
+
+	auto & Histogram = cMetrics::GetHistogram("test_duration_seconds", "Duration of a test", { 0.125, 1 });
+	// The values are exact in binary, so that their sum is exact as well:
+	Histogram.Observe(0.0625);
+	Histogram.Observe(0.125);  // The bounds are inclusive
+	Histogram.Observe(0.5);
+	Histogram.Observe(7);
+
+	auto Output = cMetrics::Serialize();
+	TEST_TRUE(HasLine(Output, "# TYPE test_events counter"));
+	TEST_TRUE(HasLine(Output, "# HELP test_events Number of test events"));
+	TEST_TRUE(HasLine(Output, "test_events_total 3"));
+	TEST_TRUE(HasLine(Output, "# TYPE test_queue_length gauge"));
+	TEST_TRUE(HasLine(Output, "test_queue_length{world=\"a\"} 5"));
+	TEST_TRUE(HasLine(Output, "test_queue_length{world=\"b\"} 0.5"));
+	TEST_TRUE(HasLine(Output, "# TYPE test_duration_seconds histogram"));
+	TEST_TRUE(HasLine(Output, "test_duration_seconds_bucket{le=\"0.125\"} 2"));
+	TEST_TRUE(HasLine(Output, "test_duration_seconds_bucket{le=\"1\"} 3"));
+	TEST_TRUE(HasLine(Output, "test_duration_seconds_bucket{le=\"+Inf\"} 4"));
+	TEST_TRUE(HasLine(Output, "test_duration_seconds_count 4"));
+	TEST_TRUE(HasLine(Output, "test_duration_seconds_sum 7.6875"));
+
+	// The output must end with the EOF marker:
+	TEST_GREATER_THAN_OR_EQUAL(Output.size(), 6U);
+	TEST_EQUAL(Output.substr(Output.size() - 6), "# EOF\n");
+}
+
+
+
+
+
+/** Checks that the collectors are called on each scrape, and that the label values are escaped. */
+void TestCollectors(void)
+{
+	int NumCalls = 0;
+	cMetrics::SetCollector("test_players", "Players", [&NumCalls](std::vector<cMetrics::sSample> & a_Samples)
+		{
+			NumCalls += 1;
+			a_Samples.push_back({ cMetrics::FormatLabels({{"name", "a\"b\\c"}}), static_cast<double>(NumCalls) });
+		}
+	);
+	cMetrics::Serialize();
+	auto Output = cMetrics::Serialize();
+	TEST_EQUAL(NumCalls, 2);
+	TEST_TRUE(HasLine(Output, "# TYPE test_players gauge"));
+	TEST_TRUE(HasLine(Output, "test_players{name=\"a\\\"b\\\\c\"} 2"));
+
+	cMetrics::RemoveCollector("test_players");
+	Output = cMetrics::Serialize();
+	TEST_EQUAL(NumCalls, 2);
+	TEST_EQUAL(Output.find("test_players"), AString::npos);
+}
+
+
+
+
+
+/** Removes a collector while a scrape is calling it, checks that the removal waits for the call to finish. */
+void TestRemoveDuringScrape(void)
+{
+	std::atomic<bool> HasStarted(false);
+	std::atomic<bool> IsRunning(false);
+	cMetrics::SetCollector("test_slow", "Slow collector", [&HasStarted, &IsRunning](std::vector<cMetrics::sSample> & a_Samples)
+		{
+			IsRunning = true;
+			HasStarted = true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			a_Samples.push_back({ AString(), 1 });
+			IsRunning = false;
+		}
+	);
+	std::thread Scraper([]()
+		{
+			cMetrics::Serialize();
+		}
+	);
+	while (!HasStarted)
+	{
+		std::this_thread::yield();
+	}
+	cMetrics::RemoveCollector("test_slow");
+	TEST_FALSE(IsRunning);
+	Scraper.join();
+	TEST_EQUAL(cMetrics::Serialize().find("test_slow"), AString::npos);
+}
+
+
+
+
+
+/** Updates the metrics from multiple threads, checks that no update is lost. */
+void TestConcurrentUpdates(void)
+{
+	static const int NUM_THREADS = 4;
+	static const int NUM_UPDATES = 100000;
+	auto & Counter = cMetrics::GetCounter("test_concurrent", "Concurrent updates");
+	auto & Histogram = cMetrics::GetHistogram("test_concurrent_seconds", "Concurrent observations", { 1 });
+	std::vector<std::thread> Threads;
+	for (int t = 0; t < NUM_THREADS; t++)
+	{
+		Threads.emplace_back([&Counter, &Histogram]()
+			{
+				for (int i = 0; i < NUM_UPDATES; i++)
+				{
+					Counter.Inc();
+					Histogram.Observe(0.5);
+				}
+			}
+		);
+	}
+
+	// Scrape while the updates are running:
+	for (int i = 0; i < 10; i++)
+	{
+		cMetrics::Serialize();
+	}
+	for (auto & Thread: Threads)
+	{
+		Thread.join();
+	}
+
+	TEST_EQUAL(Counter.Get(), static_cast<UInt64>(NUM_THREADS * NUM_UPDATES));
+	TEST_EQUAL(Histogram.GetCount(), static_cast<UInt64>(NUM_THREADS * NUM_UPDATES));
+	TEST_EQUAL(Histogram.GetSum(), NUM_THREADS * NUM_UPDATES * 0.5);
+}
+
+}  // namespace (anonymous)
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("Metrics",
+	TestSerialize();
+	TestCollectors();
+	TestRemoveDuringScrape();
+	TestConcurrentUpdates();
+)
@@ -0,0 +1,368 @@
+
+// RankManagerTest.cpp
+
+// Tests the in-memory cache of cRankManager against the SQL queries that it replaced
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "RankManager.h"
+#include "Protocol/MojangAPI.h"
+#include "UUID.h"
+#include "SQLiteCpp/Statement.h"
+
+
+
+
+
+namespace
+{
+
+/** The file in which cRankManager stores its DB, in the current folder. */
+static const char DB_FILE_NAME[] = "Ranks.sqlite";
+
+/** The pools of names that the random changes draw from. Small, so that the changes often collide. */
+static const AStringVector RANK_NAMES = { "Default", "VIP", "Operator", "Admin", "Rank1", "Rank2" };
+static const AStringVector GROUP_NAMES = { "Default", "Kick", "Teleport", "Everything", "Group1", "Group2" };
+static const AStringVector PERMISSIONS = { "core.help", "core.build", "core.kick", "core.teleport", "*", "perm.a", "perm.b" };
+static const AStringVector PLAYER_NAMES = { "alice", "Alice", "bob", "Carol", "dave", "Eve", "xavier" };
+
+/** The original queries used in more than one place. */
+static const char RANK_PERMISSIONS_SQL[] =
+	"SELECT PermissionItem.Permission FROM PermissionItem "
+		"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermissionItem.PermGroupID "
+		"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
+	"WHERE Rank.Name = ?";
+static const char RANK_RESTRICTIONS_SQL[] =
+	"SELECT RestrictionItem.Permission FROM RestrictionItem "
+		"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = RestrictionItem.PermGroupID "
+		"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
+	"WHERE Rank.Name = ?";
+static const char PLAYER_RANK_SQL[] =
+	"SELECT Rank.Name FROM Rank LEFT JOIN PlayerRank ON Rank.RankID = PlayerRank.RankID WHERE PlayerRank.PlayerUUID = ?";
+
+
+
+
+
+/** Exposes the DB of cRankManager, to run the original SQL queries on it. */
+class cRankManagerTest:
+	public cRankManager
+{
+public:
+
+	/** Returns the first column of all the rows returned by the query with the specified params. */
+	template <typename... Args>
+	AStringVector Query(const char * a_Sql, const Args &... a_Params)
+	{
+		cCSLock Lock(m_CS);
+		SQLite::Statement stmt(m_DB, a_Sql);
+		int Index = 1;
+		(stmt.bind(Index++, a_Params), ...);
+		AStringVector res;
+		while (stmt.executeStep())
+		{
+			res.push_back(stmt.getColumn(0).getText());
+		}
+		return res;
+	}
+
+
+	/** Returns the first row's first column returned by the query, or an empty string if there's none. */
+	template <typename... Args>
+	AString QueryFirst(const char * a_Sql, const Args &... a_Params)
+	{
+		auto res = Query(a_Sql, a_Params...);
+		return res.empty() ? AString() : res[0];
+	}
+};
+
+
+
+
+
+std::vector<cUUID> MakePlayerUUIDs(void)
+{
+	std::vector<cUUID> res;
+	for (const auto & Name: PLAYER_NAMES)
+	{
+		res.push_back(cUUID::GenerateVersion3(Name));
+	}
+	return res;
+}
+
+static const std::vector<cUUID> PLAYER_UUIDS = MakePlayerUUIDs();
+
+
+
+
+
+AStringVector Sorted(AStringVector a_Values)
+{
+	std::sort(a_Values.begin(), a_Values.end());
+	return a_Values;
+}
+
+
+
+
+
+/** Checks that all the queries served by the cache return the same as the original SQL queries. */
+void CompareWithDB(cRankManagerTest & a_RankManager)
+{
+	auto & RM = a_RankManager;
+
+	// The lists kept in the DB order:
+	TEST_EQUAL(RM.GetAllRanks(), RM.Query("SELECT Name FROM Rank"));
+	TEST_EQUAL(RM.GetAllGroups(), RM.Query("SELECT Name FROM PermGroup"));
+	TEST_EQUAL(RM.GetAllPermissions(), RM.Query("SELECT DISTINCT(Permission) FROM PermissionItem"));
+	TEST_EQUAL(RM.GetAllRestrictions(), RM.Query("SELECT DISTINCT(Permission) FROM RestrictionItem"));
+
+	// The players, ordered by their name:
+	AStringVector PlayerNames;
+	for (const auto & UUID: RM.GetAllPlayerUUIDs())
+	{
+		PlayerNames.push_back(StrToLower(RM.GetPlayerName(UUID)));
+	}
+	TEST_EQUAL(PlayerNames, RM.Query("SELECT LOWER(PlayerName) FROM PlayerRank ORDER BY PlayerName COLLATE NOCASE"));
+
+	for (const auto & Rank: RANK_NAMES)
+	{
+		TEST_EQUAL(RM.RankExists(Rank), !RM.Query("SELECT * FROM Rank WHERE Name = ?", Rank).empty());
+		TEST_EQUAL(Sorted(RM.GetRankGroups(Rank)), Sorted(RM.Query(
+			"SELECT PermGroup.Name FROM PermGroup "
+				"LEFT JOIN RankPermGroup ON RankPermGroup.PermGroupID = PermGroup.PermGroupID "
+				"LEFT JOIN Rank ON Rank.RankID = RankPermGroup.RankID "
+			"WHERE Rank.Name = ?", Rank
+		)));
+		TEST_EQUAL(Sorted(RM.GetRankPermissions(Rank)), Sorted(RM.Query(RANK_PERMISSIONS_SQL, Rank)));
+		TEST_EQUAL(Sorted(RM.GetRankRestrictions(Rank)), Sorted(RM.Query(RANK_RESTRICTIONS_SQL, Rank)));
+
+		AString Prefix, Suffix, Color;
+		const auto DBVisuals = RM.QueryFirst("SELECT MsgPrefix || '|' || MsgSuffix || '|' || MsgNameColorCode FROM Rank WHERE Name = ?", Rank);
+		TEST_EQUAL(RM.GetRankVisuals(Rank, Prefix, Suffix, Color), !DBVisuals.empty());
+		if (!DBVisuals.empty())
+		{
+			TEST_EQUAL(Prefix + "|" + Suffix + "|" + Color, DBVisuals);
+		}
+
+		for (const auto & Group: GROUP_NAMES)
+		{
+			TEST_EQUAL(RM.IsGroupInRank(Group, Rank), !RM.Query(
+				"SELECT * FROM Rank "
+					"LEFT JOIN RankPermGroup ON Rank.RankID = RankPermGroup.RankID "
+					"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RankPermGroup.PermGroupID "
+				"WHERE Rank.Name = ? AND PermGroup.Name = ?", Rank, Group
+			).empty());
+		}
+	}
+
+	for (const auto & Group: GROUP_NAMES)
+	{
+		TEST_EQUAL(RM.GroupExists(Group), !RM.Query("SELECT * FROM PermGroup WHERE Name = ?", Group).empty());
+		TEST_EQUAL(Sorted(RM.GetGroupPermissions(Group)), Sorted(RM.Query(
+			"SELECT PermissionItem.Permission FROM PermissionItem "
+				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = PermissionItem.PermGroupID "
+			"WHERE PermGroup.Name = ?", Group
+		)));
+		TEST_EQUAL(Sorted(RM.GetGroupRestrictions(Group)), Sorted(RM.Query(
+			"SELECT RestrictionItem.Permission FROM RestrictionItem "
+				"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RestrictionItem.PermGroupID "
+			"WHERE PermGroup.Name = ?", Group
+		)));
+		for (const auto & Permission: PERMISSIONS)
+		{
+			TEST_EQUAL(RM.IsPermissionInGroup(Permission, Group), !RM.Query(
+				"SELECT * FROM PermissionItem "
+					"LEFT JOIN PermGroup ON PermGroup.PermGroupID = PermissionItem.PermGroupID "
+				"WHERE PermissionItem.Permission = ? AND PermGroup.Name = ?", Permission, Group
+			).empty());
+			TEST_EQUAL(RM.IsRestrictionInGroup(Permission, Group), !RM.Query(
+				"SELECT * FROM RestrictionItem "
+					"LEFT JOIN PermGroup ON PermGroup.PermGroupID = RestrictionItem.PermGroupID "
+				"WHERE RestrictionItem.Permission = ? AND PermGroup.Name = ?", Permission, Group
+			).empty());
+		}
+	}
+
+	for (const auto & UUID: PLAYER_UUIDS)
+	{
+		const auto StrUUID = UUID.ToShortString();
+		TEST_EQUAL(RM.IsPlayerRankSet(UUID), !RM.Query("SELECT * FROM PlayerRank WHERE PlayerUUID = ?", StrUUID).empty());
+		TEST_EQUAL(RM.GetPlayerName(UUID), RM.QueryFirst("SELECT PlayerName FROM PlayerRank WHERE PlayerUUID = ?", StrUUID));
+		TEST_EQUAL(RM.GetPlayerRankName(UUID), RM.QueryFirst(PLAYER_RANK_SQL, StrUUID));
+
+		// Players without a (valid) rank get the default rank's permissions:
+		auto Rank = RM.QueryFirst(PLAYER_RANK_SQL, StrUUID);
+		if (Rank.empty())
+		{
+			Rank = RM.GetDefaultRank();
+		}
+		TEST_EQUAL(Sorted(RM.GetPlayerPermissions(UUID)), Sorted(RM.Query(RANK_PERMISSIONS_SQL, Rank)));
+		TEST_EQUAL(Sorted(RM.GetPlayerRestrictions(UUID)), Sorted(RM.Query(RANK_RESTRICTIONS_SQL, Rank)));
+		TEST_EQUAL(Sorted(RM.GetPlayerGroups(UUID)), Sorted(RM.Query(
+			"SELECT PermGroup.Name FROM PermGroup "
+				"LEFT JOIN RankPermGroup ON PermGroup.PermGroupID = RankPermGroup.PermGroupID "
+				"LEFT JOIN PlayerRank ON PlayerRank.RankID = RankPermGroup.RankID "
+			"WHERE PlayerRank.PlayerUUID = ?", StrUUID
+		)));
+	}
+}
+
+
+
+
+
+/** Does a single random change to the ranks, groups, permissions or players. */
+void RandomChange(cRankManager & a_RankManager, std::mt19937 & a_Random)
+{
+	auto Pick = [&a_Random](const auto & a_Pool) -> const auto &
+	{
+		return a_Pool[std::uniform_int_distribution<size_t>(0, a_Pool.size() - 1)(a_Random)];
+	};
+	auto & RM = a_RankManager;
+	switch (std::uniform_int_distribution<int>(0, 21)(a_Random))
+	{
+		case 0:  RM.AddRank(Pick(RANK_NAMES), "<", ">", "@a"); break;
+		case 1:  RM.AddGroup(Pick(GROUP_NAMES)); break;
+		case 2:  RM.AddGroups({ Pick(GROUP_NAMES), Pick(GROUP_NAMES) }); break;
+		case 3:  RM.AddGroupToRank(Pick(GROUP_NAMES), Pick(RANK_NAMES)); break;
+		case 4:  RM.AddPermissionToGroup(Pick(PERMISSIONS), Pick(GROUP_NAMES)); break;
+		case 5:  RM.AddRestrictionToGroup(Pick(PERMISSIONS), Pick(GROUP_NAMES)); break;
+		case 6:  RM.AddPermissionsToGroup({ Pick(PERMISSIONS), Pick(PERMISSIONS) }, Pick(GROUP_NAMES)); break;
+		case 7:  RM.AddRestrictionsToGroup({ Pick(PERMISSIONS), Pick(PERMISSIONS) }, Pick(GROUP_NAMES)); break;
+		case 8:  RM.RemoveRank(Pick(RANK_NAMES), Pick(RANK_NAMES)); break;
+		case 9:  RM.RemoveGroup(Pick(GROUP_NAMES)); break;
+		case 10: RM.RemoveGroupFromRank(Pick(GROUP_NAMES), Pick(RANK_NAMES)); break;
+		case 11: RM.RemovePermissionFromGroup(Pick(PERMISSIONS), Pick(GROUP_NAMES)); break;
+		case 12: RM.RemoveRestrictionFromGroup(Pick(PERMISSIONS), Pick(GROUP_NAMES)); break;
+		case 13: RM.RenameRank(Pick(RANK_NAMES), Pick(RANK_NAMES)); break;
+		case 14: RM.RenameGroup(Pick(GROUP_NAMES), Pick(GROUP_NAMES)); break;
+		case 15: RM.SetRankVisuals(Pick(RANK_NAMES), Pick(PERMISSIONS), Pick(PLAYER_NAMES), "@b"); break;
+		case 16: RM.SetPlayerRank(Pick(PLAYER_UUIDS), Pick(PLAYER_NAMES), Pick(RANK_NAMES)); break;
+		case 17: RM.RemovePlayerRank(Pick(PLAYER_UUIDS)); break;
+		case 18: RM.NotifyNameUUID(Pick(PLAYER_NAMES), Pick(PLAYER_UUIDS)); break;
+		case 19: RM.UpdatePlayerName(Pick(PLAYER_UUIDS), Pick(PLAYER_NAMES)); break;
+		case 20: RM.SetDefaultRank(Pick(RANK_NAMES)); break;
+		case 21:
+		{
+			// Clearing all players is rare, so that there are players to work with most of the time:
+			if (std::uniform_int_distribution<int>(0, 10)(a_Random) == 0)
+			{
+				RM.ClearPlayerRanks();
+			}
+			break;
+		}
+	}
+}
+
+
+
+
+
+/** Checks the cache against the DB after each of many random changes, some of them done as mass changes. */
+void TestRandomChanges(cRankManagerTest & a_RankManager)
+{
+	std::mt19937 Random(0x5eed);
+	for (int i = 0; i < 1000; i++)
+	{
+		if ((i % 50) == 0)
+		{
+			cRankManager::cMassChangeLock Lock(a_RankManager);
+			for (int j = 0; j < 20; j++)
+			{
+				RandomChange(a_RankManager, Random);
+			}
+		}
+		else
+		{
+			RandomChange(a_RankManager, Random);
+		}
+		CompareWithDB(a_RankManager);
+	}
+}
+
+
+
+
+
+/** Checks that the queries work while other threads change the data, and the cache is consistent afterwards. */
+void TestConcurrentAccess(cRankManagerTest & a_RankManager)
+{
+	std::atomic<bool> ShouldStop{ false };
+	std::vector<std::thread> Readers;
+	for (int t = 0; t < 4; t++)
+	{
+		Readers.emplace_back([&a_RankManager, &ShouldStop]()
+		{
+			while (!ShouldStop)
+			{
+				for (const auto & UUID: PLAYER_UUIDS)
+				{
+					a_RankManager.GetPlayerPermissions(UUID);
+					AString Prefix, Suffix, Color;
+					a_RankManager.GetPlayerMsgVisuals(UUID, Prefix, Suffix, Color);
+				}
+				a_RankManager.GetAllPlayerUUIDs();
+			}
+		});
+	}
+
+	std::mt19937 Random(0xc0ffee);
+	for (int i = 0; i < 2000; i++)
+	{
+		RandomChange(a_RankManager, Random);
+	}
+	ShouldStop = true;
+	for (auto & Reader: Readers)
+	{
+		Reader.join();
+	}
+	CompareWithDB(a_RankManager);
+}
+
+/** Checks that the changes not yet committed in the background are committed when the rank manager is destroyed. */
+void TestCommitOnDestroy(cMojangAPI & a_MojangAPI)
+{
+	AStringVector Ranks;
+	AStringVector Groups;
+	AStringVector Permissions;
+	{
+		cRankManagerTest RankManager;
+		RankManager.Initialize(a_MojangAPI);
+		RankManager.AddRank(RANK_NAMES[0], "", "", "");
+		RankManager.AddGroup("NewGroup");
+		RankManager.AddPermissionToGroup("perm.new", "NewGroup");
+		RankManager.SetPlayerRank(PLAYER_UUIDS[0], PLAYER_NAMES[0], RANK_NAMES[0]);
+		Ranks = RankManager.GetAllRanks();
+		Groups = RankManager.GetAllGroups();
+		Permissions = RankManager.GetAllPermissions();
+	}
+
+	cRankManagerTest RankManager;
+	RankManager.Initialize(a_MojangAPI);
+	TEST_EQUAL(RankManager.GetAllRanks(), Ranks);
+	TEST_EQUAL(RankManager.GetAllGroups(), Groups);
+	TEST_EQUAL(RankManager.GetAllPermissions(), Permissions);
+	TEST_EQUAL(RankManager.GetPlayerRankName(PLAYER_UUIDS[0]), RANK_NAMES[0]);
+	CompareWithDB(RankManager);
+}
+
+}  // namespace (anonymous)
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("RankManager",
+	std::remove(DB_FILE_NAME);
+	cMojangAPI MojangAPI;
+	{
+		cRankManagerTest RankManager;
+		RankManager.Initialize(MojangAPI);
+		CompareWithDB(RankManager);
+		TestRandomChanges(RankManager);
+		TestConcurrentAccess(RankManager);
+	}
+	TestCommitOnDestroy(MojangAPI);
+	std::remove(DB_FILE_NAME);
+)
@@ -0,0 +1,223 @@
+
+// RedstoneStorageTest.cpp
+
+// Tests the per-section storage and the active block queue of the redstone simulator's chunk data
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "Simulator/IncrementalRedstoneSimulator/RedstoneSectionStorage.h"
+#include <stack>
+
+
+
+
+
+/** Checks setting, finding and erasing values, in different sections. */
+static void TestStore()
+{
+	cRedstoneSectionStore<unsigned char> Store;
+	TEST_EQUAL(Store.Find({ 1, 2, 3 }), nullptr);
+
+	Store.Set({ 1, 2, 3 }, 7);
+	TEST_NOTEQUAL(Store.Find({ 1, 2, 3 }), nullptr);
+	TEST_EQUAL(*Store.Find({ 1, 2, 3 }), 7);
+
+	// The same position within another section is a different block:
+	TEST_EQUAL(Store.Find({ 1, 2 + cChunkDef::SectionHeight, 3 }), nullptr);
+	Store.Set({ 15, 255, 15 }, 0);
+	TEST_EQUAL(*Store.Find({ 15, 255, 15 }), 0);
+
+	// A value may be changed in place:
+	*Store.Find({ 1, 2, 3 }) = 9;
+	TEST_EQUAL(*Store.Find({ 1, 2, 3 }), 9);
+
+	Store.Erase({ 1, 2, 3 });
+	TEST_EQUAL(Store.Find({ 1, 2, 3 }), nullptr);
+	Store.Erase({ 1, 2, 3 });
+	Store.Erase({ 4, 100, 4 });
+	TEST_EQUAL(*Store.Find({ 15, 255, 15 }), 0);
+
+	// The section freed with its last value is allocated again:
+	Store.Set({ 0, 0, 0 }, 1);
+	TEST_EQUAL(*Store.Find({ 0, 0, 0 }), 1);
+	TEST_EQUAL(Store.Find({ 1, 2, 3 }), nullptr);
+}
+
+
+
+
+
+/** Checks the last in first out order of the queue and its duplicate detection. */
+static void TestQueue()
+{
+	cRedstoneActiveQueue Queue;
+	TEST_TRUE(Queue.IsEmpty());
+
+	Queue.Push({ 1, 2, 3 });
+	Queue.Push({ 4, 5, 6 });
+	Queue.Push({ 1, 2, 3 });
+	TEST_EQUAL(Queue.GetSize(), 2U);
+
+	// Positions outside the chunk are kept as they are:
+	Queue.Push({ -1, 5, 16 });
+	Queue.Push({ -1, 5, 16 });
+	TEST_EQUAL(Queue.GetSize(), 4U);
+
+	TEST_EQUAL(Queue.Pop(), Vector3i(-1, 5, 16));
+	TEST_EQUAL(Queue.Pop(), Vector3i(-1, 5, 16));
+
+	// A queued position woken up again stays where it is, a taken one can be queued again:
+	Queue.Push({ 4, 5, 6 });
+	TEST_EQUAL(Queue.Pop(), Vector3i(4, 5, 6));
+	Queue.Push({ 4, 5, 6 });
+	TEST_EQUAL(Queue.Pop(), Vector3i(4, 5, 6));
+	TEST_EQUAL(Queue.Pop(), Vector3i(1, 2, 3));
+	TEST_TRUE(Queue.IsEmpty());
+
+	// The same order as the stack the chunk data used to keep, when there are no duplicates:
+	std::stack<Vector3i, std::vector<Vector3i>> Stack;
+	for (int Round = 0; Round < 100; Round++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			const Vector3i Position((Round * 3 + i) % cChunkDef::Width, (Round * 3 + i) / cChunkDef::Width, 0);
+			Queue.Push(Position);
+			Stack.push(Position);
+		}
+		TEST_EQUAL(Queue.Pop(), Stack.top());
+		Stack.pop();
+	}
+	while (!Stack.empty())
+	{
+		TEST_EQUAL(Queue.Pop(), Stack.top());
+		Stack.pop();
+	}
+	TEST_TRUE(Queue.IsEmpty());
+}
+
+
+
+
+
+/** Replays a hopper clock's wake-ups: a row of components, each woken up every tick and waking up its neighbours,
+each woken position reading the power of its neighbours. Runs on a hash map and a stack as the chunk data used to,
+then on the section storage and the deduplicated queue. Returns the number of positions processed. */
+template <class PowerType, class QueueType, class GetPower, class SetPower, class Push, class Pop, class IsEmpty>
+static size_t ReplayHopperClock(GetPower a_GetPower, SetPower a_SetPower, Push a_Push, Pop a_Pop, IsEmpty a_IsEmpty)
+{
+	const int NumTicks = 5000;
+	const Vector3i Adjacents[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	PowerType Power;
+	QueueType Queue;
+	size_t NumProcessed = 0;
+	for (int Tick = 0; Tick < NumTicks; Tick++)
+	{
+		for (int i = 0; i < 24; i++)
+		{
+			a_Push(Queue, Vector3i(1 + i % 14, 64, 3 + 2 * (i / 14)));
+		}
+		while (!a_IsEmpty(Queue))
+		{
+			const auto Position = a_Pop(Queue);
+			if (!cChunkDef::IsValidRelPos(Position))
+			{
+				continue;
+			}
+			NumProcessed++;
+			unsigned char Level = 0;
+			for (const auto & Offset: Adjacents)
+			{
+				// The simulator asks the neighbouring chunk for the positions outside this one:
+				if (cChunkDef::IsValidRelPos(Position + Offset))
+				{
+					Level = std::max(Level, a_GetPower(Power, Position + Offset));
+				}
+			}
+			if ((Position.y == 64) && ((Position.z % 2) == 1) && (Position.x >= 1) && (Position.x <= 14))
+			{
+				// A component, its power alternates, waking up the neighbours when it changes:
+				const auto NewLevel = static_cast<unsigned char>(Tick % 2);
+				if (a_GetPower(Power, Position) != NewLevel)
+				{
+					a_SetPower(Power, Position, NewLevel);
+					for (const auto & Offset: Adjacents)
+					{
+						a_Push(Queue, Position + Offset);
+					}
+				}
+			}
+			else
+			{
+				a_SetPower(Power, Position, Level);
+			}
+		}
+	}
+	return NumProcessed;
+}
+
+
+
+
+
+static void Benchmark()
+{
+	auto Measure = [](auto a_Process)
+	{
+		auto Start = std::chrono::steady_clock::now();
+		a_Process();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	};
+
+	using cHashPower = std::unordered_map<Vector3i, unsigned char, VectorHasher<int>>;
+	using cStack = std::stack<Vector3i, std::vector<Vector3i>>;
+	size_t HashProcessed = 0;
+	const auto HashTime = Measure([&]()
+		{
+			HashProcessed = ReplayHopperClock<cHashPower, cStack>(
+				[](const cHashPower & a_Power, const Vector3i a_Position)
+				{
+					const auto Itr = a_Power.find(a_Position);
+					return (Itr == a_Power.end()) ? static_cast<unsigned char>(0) : Itr->second;
+				},
+				[](cHashPower & a_Power, const Vector3i a_Position, const unsigned char a_Level) { a_Power[a_Position] = a_Level; },
+				[](cStack & a_Queue, const Vector3i a_Position) { a_Queue.push(a_Position); },
+				[](cStack & a_Queue) { const auto Position = a_Queue.top(); a_Queue.pop(); return Position; },
+				[](const cStack & a_Queue) { return a_Queue.empty(); }
+			);
+		}
+	);
+
+	using cSectionPower = cRedstoneSectionStore<unsigned char>;
+	size_t SectionProcessed = 0;
+	const auto SectionTime = Measure([&]()
+		{
+			SectionProcessed = ReplayHopperClock<cSectionPower, cRedstoneActiveQueue>(
+				[](const cSectionPower & a_Power, const Vector3i a_Position)
+				{
+					const auto Level = a_Power.Find(a_Position);
+					return (Level == nullptr) ? static_cast<unsigned char>(0) : *Level;
+				},
+				[](cSectionPower & a_Power, const Vector3i a_Position, const unsigned char a_Level) { a_Power.Set(a_Position, a_Level); },
+				[](cRedstoneActiveQueue & a_Queue, const Vector3i a_Position) { a_Queue.Push(a_Position); },
+				[](cRedstoneActiveQueue & a_Queue) { return a_Queue.Pop(); },
+				[](const cRedstoneActiveQueue & a_Queue) { return a_Queue.IsEmpty(); }
+			);
+		}
+	);
+
+	// The duplicate wake-ups are processed only once:
+	TEST_TRUE((SectionProcessed < HashProcessed));
+	LOG("Hopper clock: hash map and stack %.2f ms, %zu positions processed; section storage and deduplicated queue %.2f ms, %zu positions processed",
+		HashTime * 1000, HashProcessed, SectionTime * 1000, SectionProcessed
+	);
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("RedstoneStorage",
+	TestStore();
+	TestQueue();
+	Benchmark();
+)
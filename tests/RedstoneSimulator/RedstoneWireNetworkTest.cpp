@@ -0,0 +1,359 @@
+
+// RedstoneWireNetworkTest.cpp
+
+// Tests that the wires evaluated in compiled networks get the same power levels as when evaluated block by block
+
+#include "Globals.h"
+#include "../TestHelpers.h"
+#include "BlockType.h"
+#include "Chunk.h"
+#include "Simulator/SimulatorManager.h"
+#include "Simulator/IncrementalRedstoneSimulator/IncrementalRedstoneSimulator.h"
+#include "Simulator/IncrementalRedstoneSimulator/RedstoneSimulatorChunkData.h"
+#include "Simulator/IncrementalRedstoneSimulator/RedstoneWireNetwork.h"
+
+
+
+
+
+/** The simulator manager of the chunks in existence, the stubbed cChunk::WakeUpSimulators() wakes it up. */
+extern cSimulatorManager * g_SimulatorManager;
+
+
+
+
+
+/** Two chunks next to each other along the X axis, simulated by the incremental redstone simulator.
+The chunks have no world, the simulator reaches the other blocks through the chunks only.
+The blocks set before LoadChunks() are woken up chunk by chunk, as when the chunks are loaded. */
+class cRedstoneTestWorld
+{
+public:
+
+	explicit cRedstoneTestWorld(const bool a_CompileCircuits):
+		m_Simulator(std::make_unique<cIncrementalRedstoneSimulator>(a_CompileCircuits))
+	{
+		ASSERT(g_SimulatorManager == nullptr);
+		g_SimulatorManager = &m_SimulatorManager;
+		m_SimulatorManager.RegisterSimulator(m_Simulator.get(), 1);
+		for (int ChunkX = 0; ChunkX < 2; ChunkX++)
+		{
+			m_Chunks.push_back(std::make_unique<cChunk>(ChunkX, 0, nullptr, nullptr));
+		}
+	}
+
+
+	~cRedstoneTestWorld()
+	{
+		g_SimulatorManager = nullptr;
+	}
+
+
+	/** Sets the block at the absolute position and wakes the simulator up for it, if its chunk is loaded. */
+	void SetBlock(const Vector3i a_Position, const BLOCKTYPE a_BlockType, const NIBBLETYPE a_BlockMeta)
+	{
+		auto & Chunk = GetChunk(a_Position);
+		const auto Relative = cChunkDef::AbsoluteToRelative(a_Position);
+		Chunk.SetBlock(Relative, a_BlockType, a_BlockMeta);
+		if (a_BlockType == E_BLOCK_REDSTONE_WIRE)
+		{
+			m_Wires.push_back(a_Position);
+		}
+		else
+		{
+			m_Others.push_back(a_Position);
+		}
+
+		if (Chunk.IsValid())
+		{
+			m_SimulatorManager.WakeUp(Chunk, Relative);
+		}
+	}
+
+
+	/** Marks the chunks as loaded one after the other, waking the simulator up for their blocks. */
+	void LoadChunks(void)
+	{
+		for (auto & Chunk: m_Chunks)
+		{
+			Chunk->SetPresence(cChunk::cpPresent);
+			for (const auto & Positions: { m_Wires, m_Others })
+			{
+				for (const auto & Position: Positions)
+				{
+					if (&GetChunk(Position) == Chunk.get())
+					{
+						m_SimulatorManager.WakeUp(*Chunk, cChunkDef::AbsoluteToRelative(Position));
+					}
+				}
+			}
+		}
+	}
+
+
+	/** Simulates enough ticks for the wires to settle and the networks dissolved meanwhile to be compiled again.
+	Returns the power of all the wires set so far. */
+	std::vector<NIBBLETYPE> Settle(void)
+	{
+		for (int Tick = 0; Tick < 50; Tick++)
+		{
+			m_SimulatorManager.Simulate(50);
+			for (auto & Chunk: m_Chunks)
+			{
+				m_SimulatorManager.SimulateChunk(std::chrono::milliseconds(50), Chunk->GetPosX(), Chunk->GetPosZ(), Chunk.get());
+			}
+		}
+
+		m_MaxNumNetworks = std::max(m_MaxNumNetworks, GetNumNetworks());
+
+		std::vector<NIBBLETYPE> Powers;
+		for (const auto & Wire: m_Wires)
+		{
+			Powers.push_back(GetPower(Wire));
+		}
+		return Powers;
+	}
+
+
+	/** Returns the power level of the wire at the absolute position. */
+	NIBBLETYPE GetPower(const Vector3i a_Position)
+	{
+		auto & Chunk = GetChunk(a_Position);
+		const auto Relative = cChunkDef::AbsoluteToRelative(a_Position);
+		TEST_EQUAL(Chunk.GetBlock(Relative), E_BLOCK_REDSTONE_WIRE);
+		return Chunk.GetMeta(Relative);
+	}
+
+
+	/** Returns the greatest number of compiled networks there were after any of the Settle() calls. */
+	size_t GetMaxNumNetworks(void) const { return m_MaxNumNetworks; }
+
+private:
+
+	std::unique_ptr<cIncrementalRedstoneSimulator> m_Simulator;
+	cSimulatorManager m_SimulatorManager;
+	std::vector<std::unique_ptr<cChunk>> m_Chunks;
+
+	/** The absolute positions of the blocks set, wires and others. */
+	std::vector<Vector3i> m_Wires;
+	std::vector<Vector3i> m_Others;
+
+	size_t m_MaxNumNetworks = 0;
+
+
+	/** Returns the number of compiled networks in both chunks. */
+	size_t GetNumNetworks(void) const
+	{
+		size_t Res = 0;
+		for (const auto & Chunk: m_Chunks)
+		{
+			Res += static_cast<cIncrementalRedstoneSimulatorChunkData *>(Chunk->GetRedstoneSimulatorData())->WireNetworks.size();
+		}
+		return Res;
+	}
+
+
+	cChunk & GetChunk(const Vector3i a_Position)
+	{
+		const auto ChunkX = cChunkDef::BlockToChunk(a_Position).m_ChunkX;
+		ASSERT((ChunkX >= 0) && (static_cast<size_t>(ChunkX) < m_Chunks.size()));
+		return *m_Chunks[static_cast<size_t>(ChunkX)];
+	}
+};
+
+
+
+
+
+/** Runs the layout once with the wires simulated block by block and once with the networks compiled.
+a_Layout sets the blocks, calls Settle() after each change and checks some of the powers, it returns the results of
+all the Settle() calls, which must match between the two runs. */
+static void TestLayout(const char * a_Name, const std::function<std::vector<std::vector<NIBBLETYPE>>(cRedstoneTestWorld &)> & a_Layout)
+{
+	LOG("Testing layout %s", a_Name);
+
+	std::vector<std::vector<NIBBLETYPE>> BlockByBlock;
+	{
+		cRedstoneTestWorld World(false);
+		BlockByBlock = a_Layout(World);
+		TEST_EQUAL(World.GetMaxNumNetworks(), 0);
+	}
+
+	std::vector<std::vector<NIBBLETYPE>> Compiled;
+	{
+		cRedstoneTestWorld World(true);
+		Compiled = a_Layout(World);
+		TEST_GREATER_THAN_OR_EQUAL(World.GetMaxNumNetworks(), 1);
+	}
+
+	TEST_EQUAL(BlockByBlock.size(), Compiled.size());
+	for (size_t i = 0; i < BlockByBlock.size(); i++)
+	{
+		TEST_TRUE((BlockByBlock[i] == Compiled[i]));
+	}
+}
+
+
+
+
+
+/** Places a wire at each of the positions between the two, inclusive, in a straight line. */
+static void SetWireLine(cRedstoneTestWorld & a_World, const Vector3i a_From, const Vector3i a_To)
+{
+	const auto Step = Vector3i(Clamp(a_To.x - a_From.x, -1, 1), 0, Clamp(a_To.z - a_From.z, -1, 1));
+	for (auto Position = a_From; Position != a_To + Step; Position += Step)
+	{
+		a_World.SetBlock(Position, E_BLOCK_REDSTONE_WIRE, 0);
+	}
+}
+
+
+
+
+
+/** A line of wire with two branches, powered by a redstone block at its end which is then removed and put back. */
+static void TestBranches()
+{
+	TestLayout("branches", [](cRedstoneTestWorld & a_World)
+	{
+		std::vector<std::vector<NIBBLETYPE>> Results;
+		a_World.SetBlock({ 1, 1, 8 }, E_BLOCK_BLOCK_OF_REDSTONE, 0);
+		SetWireLine(a_World, { 2, 1, 8 }, { 13, 1, 8 });
+		SetWireLine(a_World, { 5, 1, 9 }, { 5, 1, 12 });
+		SetWireLine(a_World, { 10, 1, 7 }, { 10, 1, 4 });
+		a_World.LoadChunks();
+
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 2, 1, 8 }), 15);
+		TEST_EQUAL(a_World.GetPower({ 13, 1, 8 }), 4);
+		TEST_EQUAL(a_World.GetPower({ 5, 1, 12 }), 8);
+		TEST_EQUAL(a_World.GetPower({ 10, 1, 4 }), 3);
+
+		a_World.SetBlock({ 1, 1, 8 }, E_BLOCK_AIR, 0);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 2, 1, 8 }), 0);
+		TEST_EQUAL(a_World.GetPower({ 5, 1, 12 }), 0);
+
+		a_World.SetBlock({ 1, 1, 8 }, E_BLOCK_BLOCK_OF_REDSTONE, 0);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 10, 1, 4 }), 3);
+		return Results;
+	});
+}
+
+
+
+
+
+/** A ring of wire, fed through a repeater by a lever that is switched on and off again.
+The lever is farther than one block from the wires, so switching it doesn't dissolve the network. */
+static void TestLoop()
+{
+	TestLayout("loop", [](cRedstoneTestWorld & a_World)
+	{
+		std::vector<std::vector<NIBBLETYPE>> Results;
+		a_World.SetBlock({ 3, 1, 2 }, E_BLOCK_LEVER, 5);
+		a_World.SetBlock({ 3, 1, 3 }, E_BLOCK_REDSTONE_REPEATER_OFF, E_META_REDSTONE_REPEATER_FACING_ZP);
+		SetWireLine(a_World, { 2, 1, 4 }, { 8, 1, 4 });
+		SetWireLine(a_World, { 8, 1, 5 }, { 8, 1, 10 });
+		SetWireLine(a_World, { 7, 1, 10 }, { 2, 1, 10 });
+		SetWireLine(a_World, { 2, 1, 9 }, { 2, 1, 5 });
+		a_World.LoadChunks();
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 3, 1, 4 }), 0);
+
+		a_World.SetBlock({ 3, 1, 2 }, E_BLOCK_LEVER, 5 | 0x08);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 3, 1, 4 }), 15);
+		TEST_EQUAL(a_World.GetPower({ 2, 1, 4 }), 14);
+		TEST_EQUAL(a_World.GetPower({ 8, 1, 10 }), 4);
+		TEST_EQUAL(a_World.GetPower({ 7, 1, 10 }), 3);
+
+		// Powers must not linger in the loop once the lever is off:
+		a_World.SetBlock({ 3, 1, 2 }, E_BLOCK_LEVER, 5);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 3, 1, 4 }), 0);
+		TEST_EQUAL(a_World.GetPower({ 8, 1, 10 }), 0);
+		return Results;
+	});
+}
+
+
+
+
+
+/** A line of wire with a redstone block at its end and a lever and repeater in its middle, which are removed. */
+static void TestSourceRemoved()
+{
+	TestLayout("source removed", [](cRedstoneTestWorld & a_World)
+	{
+		std::vector<std::vector<NIBBLETYPE>> Results;
+		a_World.SetBlock({ 0, 1, 8 }, E_BLOCK_BLOCK_OF_REDSTONE, 0);
+		SetWireLine(a_World, { 1, 1, 8 }, { 14, 1, 8 });
+		a_World.SetBlock({ 8, 1, 9 }, E_BLOCK_REDSTONE_REPEATER_OFF, E_META_REDSTONE_REPEATER_FACING_ZM);
+		a_World.SetBlock({ 8, 1, 10 }, E_BLOCK_LEVER, 5 | 0x08);
+		a_World.LoadChunks();
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 1, 1, 8 }), 15);
+		TEST_EQUAL(a_World.GetPower({ 4, 1, 8 }), 12);
+		TEST_EQUAL(a_World.GetPower({ 8, 1, 8 }), 15);
+		TEST_EQUAL(a_World.GetPower({ 14, 1, 8 }), 9);
+
+		a_World.SetBlock({ 8, 1, 10 }, E_BLOCK_AIR, 0);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 8, 1, 8 }), 8);
+		TEST_EQUAL(a_World.GetPower({ 14, 1, 8 }), 2);
+
+		a_World.SetBlock({ 8, 1, 9 }, E_BLOCK_AIR, 0);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 14, 1, 8 }), 2);
+		return Results;
+	});
+}
+
+
+
+
+
+/** A line of wire crossing into the other chunk, fed by a lever and repeater, later also by a redstone block at its far end. */
+static void TestChunkBorder()
+{
+	TestLayout("chunk border", [](cRedstoneTestWorld & a_World)
+	{
+		std::vector<std::vector<NIBBLETYPE>> Results;
+		a_World.SetBlock({ 7, 1, 8 }, E_BLOCK_LEVER, 5);
+		a_World.SetBlock({ 8, 1, 8 }, E_BLOCK_REDSTONE_REPEATER_OFF, E_META_REDSTONE_REPEATER_FACING_XP);
+		SetWireLine(a_World, { 9, 1, 8 }, { 20, 1, 8 });
+		a_World.LoadChunks();
+		Results.push_back(a_World.Settle());
+
+		a_World.SetBlock({ 7, 1, 8 }, E_BLOCK_LEVER, 5 | 0x08);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 9, 1, 8 }), 15);
+		TEST_EQUAL(a_World.GetPower({ 15, 1, 8 }), 9);
+		TEST_EQUAL(a_World.GetPower({ 16, 1, 8 }), 8);
+		TEST_EQUAL(a_World.GetPower({ 20, 1, 8 }), 4);
+
+		a_World.SetBlock({ 21, 1, 8 }, E_BLOCK_BLOCK_OF_REDSTONE, 0);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 15, 1, 8 }), 10);
+		TEST_EQUAL(a_World.GetPower({ 20, 1, 8 }), 15);
+
+		a_World.SetBlock({ 7, 1, 8 }, E_BLOCK_LEVER, 5);
+		Results.push_back(a_World.Settle());
+		TEST_EQUAL(a_World.GetPower({ 9, 1, 8 }), 4);
+		TEST_EQUAL(a_World.GetPower({ 16, 1, 8 }), 11);
+		return Results;
+	});
+}
+
+
+
+
+
+IMPLEMENT_TEST_MAIN("RedstoneWireNetwork",
+	TestBranches();
+	TestLoop();
+	TestSourceRemoved();
+	TestChunkBorder();
+)
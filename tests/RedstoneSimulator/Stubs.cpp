@@ -0,0 +1,520 @@
+
+// Stubs.cpp
+
+// Implements stubs of various Cuberite methods that are needed for linking but not for runtime
+// The chunk functions used by the redstone simulator are implemented over a simple map of the test's chunks and their
+// simulator manager
+
+#include "Globals.h"
+#include "Chunk.h"
+#include "Item.h"
+#include "ItemGrid.h"
+#include "Profiler.h"
+#include "World.h"
+#include "Simulator/SimulatorManager.h"
+#include "BlockEntities/BlockEntityWithItems.h"
+#include "BlockEntities/CommandBlockEntity.h"
+#include "BlockEntities/DropSpenserEntity.h"
+#include "BlockEntities/HopperEntity.h"
+#include "BlockEntities/NoteEntity.h"
+#include "Blocks/BlockPiston.h"
+#include "Blocks/ChunkInterface.h"
+#include "Entities/Player.h"
+#include "Simulator/IncrementalRedstoneSimulator/RedstoneSimulatorChunkData.h"
+#include "Simulator/IncrementalRedstoneSimulator/RedstoneWireNetwork.h"
+
+
+
+
+
+/** The chunks in existence, by their coords, so that new chunks can find their neighbours as in cChunkMap. */
+static std::map<std::pair<int, int>, cChunk *> g_Chunks;
+
+/** The simulator manager of the chunks in existence, set by the test. */
+cSimulatorManager * g_SimulatorManager = nullptr;
+
+
+
+
+
+cChunk::cChunk(int a_ChunkX, int a_ChunkZ, cChunkMap * a_ChunkMap, cWorld * a_World):
+	m_Presence(cpInvalid),
+	m_IsLightValid(false),
+	m_IsDirty(false),
+	m_IsSaving(false),
+	m_DirtySince(0),
+	m_StayCount(0),
+	m_LastUsed(0),
+	m_PosX(a_ChunkX),
+	m_PosZ(a_ChunkZ),
+	m_World(a_World),
+	m_ChunkMap(a_ChunkMap),
+	m_WaterSimulatorData(nullptr),
+	m_LavaSimulatorData(nullptr),
+	m_RedstoneSimulatorData(new cIncrementalRedstoneSimulatorChunkData),
+	m_AlwaysTicked(0)
+{
+	const auto FindChunk = [](const int a_X, const int a_Z) -> cChunk *
+	{
+		const auto Itr = g_Chunks.find({ a_X, a_Z });
+		return (Itr == g_Chunks.end()) ? nullptr : Itr->second;
+	};
+	m_NeighborXM = FindChunk(a_ChunkX - 1, a_ChunkZ);
+	m_NeighborXP = FindChunk(a_ChunkX + 1, a_ChunkZ);
+	m_NeighborZM = FindChunk(a_ChunkX, a_ChunkZ - 1);
+	m_NeighborZP = FindChunk(a_ChunkX, a_ChunkZ + 1);
+
+	if (m_NeighborXM != nullptr)
+	{
+		m_NeighborXM->m_NeighborXP = this;
+	}
+	if (m_NeighborXP != nullptr)
+	{
+		m_NeighborXP->m_NeighborXM = this;
+	}
+	if (m_NeighborZM != nullptr)
+	{
+		m_NeighborZM->m_NeighborZP = this;
+	}
+	if (m_NeighborZP != nullptr)
+	{
+		m_NeighborZP->m_NeighborZM = this;
+	}
+	g_Chunks[{ a_ChunkX, a_ChunkZ }] = this;
+}
+
+
+
+
+
+cChunk::~cChunk()
+{
+	g_Chunks.erase({ m_PosX, m_PosZ });
+	if (m_NeighborXM != nullptr)
+	{
+		m_NeighborXM->m_NeighborXP = nullptr;
+	}
+	if (m_NeighborXP != nullptr)
+	{
+		m_NeighborXP->m_NeighborXM = nullptr;
+	}
+	if (m_NeighborZM != nullptr)
+	{
+		m_NeighborZM->m_NeighborZP = nullptr;
+	}
+	if (m_NeighborZP != nullptr)
+	{
+		m_NeighborZP->m_NeighborZM = nullptr;
+	}
+	delete m_RedstoneSimulatorData;
+}
+
+
+
+
+
+void cChunk::SetPresence(cChunk::ePresence a_Presence)
+{
+	m_Presence = a_Presence;
+}
+
+
+
+
+
+void cChunk::SetBlock(Vector3i a_RelBlockPos, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
+{
+	FastSetBlock(a_RelBlockPos, a_BlockType, a_BlockMeta);
+}
+
+
+
+
+
+void cChunk::WakeUpSimulators(Vector3i a_RelPos)
+{
+	g_SimulatorManager->WakeUp(*this, a_RelPos);
+}
+
+
+
+
+
+void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, BLOCKTYPE a_BlockMeta)
+{
+	ASSERT(cChunkDef::IsValidRelPos({ a_RelX, a_RelY, a_RelZ }));
+
+	m_BlockData.SetBlock({ a_RelX, a_RelY, a_RelZ }, a_BlockType);
+	m_BlockData.SetMeta({ a_RelX, a_RelY, a_RelZ }, a_BlockMeta);
+}
+
+
+
+
+
+void cChunk::GetBlockTypeMeta(Vector3i a_RelPos, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
+{
+	a_BlockType = GetBlock(a_RelPos);
+	a_BlockMeta = GetMeta(a_RelPos);
+}
+
+
+
+
+
+bool cChunk::UnboundedRelGetBlock(Vector3i a_RelPos, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const
+{
+	if (!cChunkDef::IsValidHeight(a_RelPos))
+	{
+		return false;
+	}
+	auto Chunk = GetRelNeighborChunkAdjustCoords(a_RelPos);
+	if ((Chunk == nullptr) || !Chunk->IsValid())
+	{
+		return false;
+	}
+	Chunk->GetBlockTypeMeta(a_RelPos, a_BlockType, a_BlockMeta);
+	return true;
+}
+
+
+
+
+
+bool cChunk::UnboundedRelGetBlockType(Vector3i a_RelPos, BLOCKTYPE & a_BlockType) const
+{
+	NIBBLETYPE BlockMeta;
+	return UnboundedRelGetBlock(a_RelPos, a_BlockType, BlockMeta);
+}
+
+
+
+
+
+cChunk * cChunk::GetRelNeighborChunkAdjustCoords(Vector3i & a_RelPos) const
+{
+	cChunk * ToReturn = const_cast<cChunk *>(this);
+	int RelX = a_RelPos.x;
+	int RelZ = a_RelPos.z;
+	while ((RelX >= cChunkDef::Width) && (ToReturn != nullptr))
+	{
+		RelX -= cChunkDef::Width;
+		ToReturn = ToReturn->m_NeighborXP;
+	}
+	while ((RelX < 0) && (ToReturn != nullptr))
+	{
+		RelX += cChunkDef::Width;
+		ToReturn = ToReturn->m_NeighborXM;
+	}
+	while ((RelZ >= cChunkDef::Width) && (ToReturn != nullptr))
+	{
+		RelZ -= cChunkDef::Width;
+		ToReturn = ToReturn->m_NeighborZP;
+	}
+	while ((RelZ < 0) && (ToReturn != nullptr))
+	{
+		RelZ += cChunkDef::Width;
+		ToReturn = ToReturn->m_NeighborZM;
+	}
+	a_RelPos.x = RelX;
+	a_RelPos.z = RelZ;
+	return ToReturn;
+}
+
+
+
+
+
+NIBBLETYPE cChunk::GetTimeAlteredLight(NIBBLETYPE a_Skylight) const
+{
+	return a_Skylight;
+}
+
+
+
+
+
+void cChunk::SetDirty(void)
+{
+}
+
+
+
+
+
+bool cChunk::DoWithBlockEntityAt(Vector3i a_Position, cBlockEntityCallback a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cChunk::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback a_Callback) const
+{
+	return true;
+}
+
+
+
+
+
+BLOCKTYPE cChunkInterface::GetBlock(Vector3i a_Pos)
+{
+	return E_BLOCK_AIR;
+}
+
+
+
+
+
+NIBBLETYPE cChunkInterface::GetBlockMeta(Vector3i a_Pos)
+{
+	return 0;
+}
+
+
+
+
+
+void cChunkInterface::SetBlockMeta(Vector3i a_Pos, NIBBLETYPE a_MetaData)
+{
+}
+
+
+
+
+
+bool cChunkInterface::ForEachChunkInRect(int a_MinChunkX, int a_MaxChunkX, int a_MinChunkZ, int a_MaxChunkZ, cChunkDataCallback & a_Callback)
+{
+	return false;
+}
+
+
+
+
+
+bool cChunkInterface::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes)
+{
+	return false;
+}
+
+
+
+
+
+void cWorld::BroadcastSoundEffect(const AString & a_SoundName, Vector3d a_Position, float a_Volume, float a_Pitch, const cClientHandle * a_Exclude)
+{
+}
+
+
+
+
+
+void cWorld::BroadcastSoundParticleEffect(const EffectID a_EffectID, Vector3i a_SrcPos, int a_Data, const cClientHandle * a_Exclude)
+{
+}
+
+
+
+
+
+cTickTime cWorld::GetTimeOfDay(void) const
+{
+	return cTickTime(0);
+}
+
+
+
+
+
+UInt32 cWorld::SpawnPrimedTNT(Vector3d a_Pos, int a_FuseTicks, double a_InitialVelocityCoeff, bool a_ShouldPlayFuseSound)
+{
+	return cEntity::INVALID_ID;
+}
+
+
+
+
+
+void cBlockPistonHandler::ExtendPiston(Vector3i a_BlockPos, cWorld & a_World)
+{
+}
+
+
+
+
+
+void cBlockPistonHandler::RetractPiston(Vector3i a_BlockPos, cWorld & a_World)
+{
+}
+
+
+
+
+
+cItems cBlockEntity::ConvertToPickups() const
+{
+	return {};
+}
+
+
+
+
+
+void cBlockEntity::CopyFrom(const cBlockEntity & a_Src)
+{
+}
+
+
+
+
+
+void cBlockEntity::Destroy()
+{
+}
+
+
+
+
+
+void cBlockEntity::OnAddToWorld(cWorld & a_World, cChunk & a_Chunk)
+{
+}
+
+
+
+
+
+void cBlockEntity::OnRemoveFromWorld()
+{
+}
+
+
+
+
+
+bool cBlockEntity::Tick(std::chrono::milliseconds a_Dt, cChunk & a_Chunk)
+{
+	return false;
+}
+
+
+
+
+
+cItems cBlockEntityWithItems::ConvertToPickups() const
+{
+	return {};
+}
+
+
+
+
+
+void cBlockEntityWithItems::CopyFrom(const cBlockEntity & a_Src)
+{
+}
+
+
+
+
+
+void cBlockEntityWithItems::OnSlotChanged(cItemGrid * a_Grid, int a_SlotNum)
+{
+}
+
+
+
+
+
+void cCommandBlockEntity::Activate(void)
+{
+}
+
+
+
+
+
+void cDropSpenserEntity::Activate(void)
+{
+}
+
+
+
+
+
+void cHopperEntity::SetLocked(bool a_Value)
+{
+}
+
+
+
+
+
+void cNoteEntity::MakeSound(void)
+{
+}
+
+
+
+
+
+cEnchantments::cEnchantments(void)
+{
+}
+
+
+
+
+
+cItem::cItem():
+	m_ItemType(E_ITEM_EMPTY),
+	m_ItemCount(0),
+	m_ItemDamage(0),
+	m_RepairCost(0)
+{
+}
+
+
+
+
+
+char cItem::GetMaxStackSize(void) const
+{
+	return 64;
+}
+
+
+
+
+
+const cItem & cItemGrid::GetSlot(int a_SlotNum) const
+{
+	static const cItem Empty;
+	return Empty;
+}
+
+
+
+
+
+bool cPlayer::IsGameModeSpectator(void) const
+{
+	return false;
+}
+
+
+
+
+
+std::atomic<bool> cProfiler::s_IsEnabled(false);
+
+
+
+
+
+void cProfiler::AddEvent(const char * a_Name, clock::time_point a_Start, clock::time_point a_End)
+{
+}